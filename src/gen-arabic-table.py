@@ -127,6 +127,13 @@ def print_joining_table(f):
 	print ("static unsigned int")
 	print ("joining_type (hb_codepoint_t u)")
 	print ("{")
+	# The first range covers the Arabic, Syriac, Thaana and N'Ko blocks,
+	# which is where nearly all text going through this shaper lives; check
+	# it before the switch.
+	start,end = ranges[0]
+	print ("  if (hb_in_range<hb_codepoint_t> (u, 0x%04Xu, 0x%04Xu)) return joining_table[u - 0x%04Xu + joining_offset_0x%04xu];" % (start, end, start, start))
+	print ()
+	ranges = ranges[1:]
 	print ("  switch (u >> %d)" % page_bits)
 	print ("  {")
 	pages = set([u>>page_bits for u in [s for s,e in ranges]+[e for s,e in ranges]])
@@ -53,7 +53,7 @@ print ('#include "hb-unicode.hh"')
 print ()
 
 for typ,s in ranges.items():
-	if typ != "Extended_Pictographic": continue
+	if typ not in ("Emoji_Presentation", "Extended_Pictographic"): continue
 	print()
 	print("static const struct hb_unicode_range_t _hb_unicode_emoji_%s_table[] =" % typ)
 	print("{")
@@ -100,6 +100,8 @@ print (" */")
 print ()
 print ('#include "hb-ot-shape-complex-indic.hh"')
 print ()
+print ('#if !defined(HB_NO_OT_SHAPE_COMPLEX_INDIC_TABLE)')
+print ()
 
 # Shorten values
 short = [{
@@ -251,6 +253,8 @@ for i in range (2):
 		print ("#undef %s_%s" %
 			(what_short[i], short[i][v]))
 print ()
+print ("#endif")
+print ()
 print ("/* == End of generated table == */")
 
 # Maintain at least 30% occupancy in the table */
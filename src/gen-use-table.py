@@ -418,6 +418,8 @@ print (" */")
 print ()
 print ('#include "hb-ot-shape-complex-use.hh"')
 print ()
+print ('#if !defined(HB_NO_OT_SHAPE_COMPLEX_USE)')
+print ()
 
 total = 0
 used = 0
@@ -530,6 +532,8 @@ for k,v in sorted(use_positions.items()):
 		tag = k + suf
 		print ("#undef %s" % tag)
 print ()
+print ("#endif")
+print ()
 print ("/* == End of generated table == */")
 
 # Maintain at least 50% occupancy in the table */
@@ -28,6 +28,8 @@
 #define HB_AAT_LAYOUT_COMMON_HH
 
 #include "hb-aat-layout.hh"
+#include "hb-cache.hh"
+#include "hb-map.hh"
 #include "hb-open-type.hh"
 
 
@@ -54,6 +56,14 @@ struct LookupFormat0
     return &arrayZ[glyph_id];
   }
 
+  template <typename set_t, typename filter_t>
+  void collect_glyphs (set_t &glyphs, unsigned int num_glyphs, const filter_t &filter) const
+  {
+    for (unsigned int i = 0; i < num_glyphs; i++)
+      if (filter (arrayZ[i]))
+	glyphs.add (i);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -112,6 +122,15 @@ struct LookupFormat2
     return v ? &v->value : nullptr;
   }
 
+  template <typename set_t, typename filter_t>
+  void collect_glyphs (set_t &glyphs, const filter_t &filter) const
+  {
+    unsigned int count = segments.get_length ();
+    for (unsigned int i = 0; i < count; i++)
+      if (filter (segments[i].value))
+	glyphs.add_range (segments[i].first, segments[i].last);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -143,6 +162,16 @@ struct LookupSegmentArray
     return first <= glyph_id && glyph_id <= last ? &(base+valuesZ)[glyph_id - first] : nullptr;
   }
 
+  template <typename set_t, typename filter_t>
+  void collect_glyphs (set_t &glyphs, const void *base, const filter_t &filter) const
+  {
+    if (first > last) return;
+    const UnsizedArrayOf<T> &values = base+valuesZ;
+    for (unsigned int i = 0; i <= (unsigned) (last - first); i++)
+      if (filter (values[i]))
+	glyphs.add (first + i);
+  }
+
   int cmp (hb_codepoint_t g) const
   { return g < first ? -1 : g <= last ? 0 : +1; }
 
@@ -183,6 +212,14 @@ struct LookupFormat4
     return v ? v->get_value (glyph_id, this) : nullptr;
   }
 
+  template <typename set_t, typename filter_t>
+  void collect_glyphs (set_t &glyphs, const filter_t &filter) const
+  {
+    unsigned int count = segments.get_length ();
+    for (unsigned int i = 0; i < count; i++)
+      segments[i].collect_glyphs (glyphs, this, filter);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -240,6 +277,15 @@ struct LookupFormat6
     return v ? &v->value : nullptr;
   }
 
+  template <typename set_t, typename filter_t>
+  void collect_glyphs (set_t &glyphs, const filter_t &filter) const
+  {
+    unsigned int count = entries.get_length ();
+    for (unsigned int i = 0; i < count; i++)
+      if (filter (entries[i].value))
+	glyphs.add (entries[i].glyph);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -271,6 +317,15 @@ struct LookupFormat8
 	   &valueArrayZ[glyph_id - firstGlyph] : nullptr;
   }
 
+  template <typename set_t, typename filter_t>
+  void collect_glyphs (set_t &glyphs, const filter_t &filter) const
+  {
+    unsigned int count = glyphCount;
+    for (unsigned int i = 0; i < count; i++)
+      if (filter (valueArrayZ[i]))
+	glyphs.add (firstGlyph + i);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -315,6 +370,15 @@ struct LookupFormat10
     return v;
   }
 
+  template <typename set_t, typename filter_t>
+  void collect_glyphs (set_t &glyphs, const filter_t &filter) const
+  {
+    unsigned int count = glyphCount;
+    for (unsigned int i = 0; i < count; i++)
+      if (filter (get_value_or_null (firstGlyph + i)))
+	glyphs.add (firstGlyph + i);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -370,6 +434,25 @@ struct Lookup
     return v ? *v : outOfRange;
   }
 
+  /* Adds the glyphs that have a value for which filter returns true. */
+  template <typename set_t, typename filter_t>
+  void collect_glyphs (set_t &glyphs, unsigned int num_glyphs, const filter_t &filter) const
+  {
+    switch (u.format) {
+    case 0: u.format0.collect_glyphs (glyphs, num_glyphs, filter); return;
+    case 2: u.format2.collect_glyphs (glyphs, filter); return;
+    case 4: u.format4.collect_glyphs (glyphs, filter); return;
+    case 6: u.format6.collect_glyphs (glyphs, filter); return;
+    case 8: u.format8.collect_glyphs (glyphs, filter); return;
+    case 10: u.format10.collect_glyphs (glyphs, filter); return;
+    default:return;
+    }
+  }
+
+  /* Whether get_value() has to search, rather than index. */
+  bool is_search () const
+  { return u.format == 2 || u.format == 4 || u.format == 6; }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -425,8 +508,6 @@ struct Null<AAT::Lookup<T>> {
 };
 namespace AAT {
 
-enum { DELETED_GLYPH = 0xFFFF };
-
 /*
  * (Extended) State Table
  */
@@ -504,6 +585,36 @@ struct StateTable
     return (this+classTable).get_class (glyph_id, num_glyphs, 1);
   }
 
+  /* Adds the glyphs get_class() does not map to CLASS_OUT_OF_BOUNDS. */
+  template <typename set_t>
+  void collect_glyphs (set_t &glyphs, unsigned int num_glyphs) const
+  {
+    (this+classTable).collect_glyphs (glyphs, num_glyphs,
+				      [] (unsigned int klass) { return klass != CLASS_OUT_OF_BOUNDS; });
+    glyphs.add (DELETED_GLYPH);
+  }
+
+  /* Whether a run of out-of-bounds glyphs, as well as the end of text,
+   * keeps the machine in its start state without any entry for which
+   * is_action returns true.  If so, the machine does nothing to buffers
+   * with none of the glyphs from collect_glyphs(). */
+  template <typename action_func_t>
+  bool is_idle_without_glyphs (const action_func_t &is_action) const
+  {
+    const unsigned int classes[] = {CLASS_END_OF_TEXT, CLASS_OUT_OF_BOUNDS};
+    for (unsigned int i = 0; i < ARRAY_LENGTH (classes); i++)
+    {
+      const Entry<Extra> &entry = get_entry (STATE_START_OF_TEXT, classes[i]);
+      if (new_state (entry.newState) != STATE_START_OF_TEXT || is_action (entry))
+	return false;
+    }
+    return true;
+  }
+
+  /* Whether get_class() is worth caching; see class_cache_t. */
+  bool has_slow_classes () const
+  { return (this+classTable).is_search (); }
+
   const Entry<Extra> *get_entries () const
   { return (this+entryTable).arrayZ; }
 
@@ -652,6 +763,15 @@ struct ClassTable
   {
     return get_class (glyph_id, outOfRange);
   }
+  template <typename set_t, typename filter_t>
+  void collect_glyphs (set_t &glyphs, unsigned int num_glyphs HB_UNUSED, const filter_t &filter) const
+  {
+    unsigned int count = classArray.len;
+    for (unsigned int i = 0; i < count; i++)
+      if (filter (classArray[i]))
+	glyphs.add (firstGlyph + i);
+  }
+  bool is_search () const { return false; }
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -726,19 +846,118 @@ struct ExtendedTypes
   }
 };
 
+/* Remembers glyph classes of the subtable being applied.  Entries are
+ * tagged with a per-subtable serial, so moving on to the next subtable
+ * does not need to clear the cache. */
+struct class_cache_t
+{
+  void init ()
+  {
+    cache.init ();
+    serial = 0;
+  }
+
+  /* Forgets the classes of the previous subtable. */
+  void next_subtable ()
+  {
+    if (unlikely (++serial == 1u << 8))
+    {
+      cache.clear ();
+      serial = 0;
+    }
+  }
+
+  bool get (hb_codepoint_t glyph, unsigned int *klass) const
+  { return !(glyph >> 16) && cache.get ((serial << 16) | glyph, klass); }
+
+  void set (hb_codepoint_t glyph, unsigned int klass)
+  {
+    if (glyph >> 16) return;
+    cache.set ((serial << 16) | glyph, klass);
+  }
+
+  private:
+  hb_cache_t<24, 16, 8> cache;
+  unsigned int serial;
+};
+
+/* Remembers kerning values of one pair-kerning subtable.  Shared by all
+ * fonts of a face, so only values that do not depend on variations may be
+ * stored.  Pairs of glyphs that do not fit in 12 bits each are not cached. */
+struct pair_cache_t
+{
+  void init () { cache.init (); }
+
+  bool get (hb_codepoint_t left, hb_codepoint_t right, int *kern) const
+  {
+    unsigned int key, v;
+    if (!get_key (left, right, &key) || !cache.get (key, &v))
+      return false;
+    *kern = (int) v - 0x8000;
+    return true;
+  }
+
+  void set (hb_codepoint_t left, hb_codepoint_t right, int kern)
+  {
+    unsigned int key;
+    if (!get_key (left, right, &key) || kern < -0x8000 || kern > 0x7FFF)
+      return;
+    cache.set (key, (unsigned int) (kern + 0x8000));
+  }
+
+  private:
+  static bool get_key (hb_codepoint_t left, hb_codepoint_t right, unsigned int *key)
+  {
+    if ((left | right) >> 12)
+      return false;
+    /* The cache slot is picked from the low bits of the key; mix in the
+     * left glyph so that pairs sharing a right glyph do not collide.  The
+     * left glyph is still intact in the high bits, so this is reversible. */
+    *key = ((left << 12) | right) ^ (left & 0xFFu);
+    return true;
+  }
+
+  hb_cache_t<24, 16, 8> cache;
+};
+
+/* Nonzero kerning values of a pair-list subtable, keyed on
+ * (left << 16) | right.  Built once per face; see OT::kern. */
+typedef hb_hashmap_t<unsigned int, int> pair_map_t;
+
 template <typename Types, typename EntryData>
 struct StateTableDriver
 {
   StateTableDriver (const StateTable<Types, EntryData> &machine_,
 		    hb_buffer_t *buffer_,
-		    hb_face_t *face_) :
+		    hb_face_t *face_,
+		    class_cache_t *class_cache_ = nullptr) :
 	      machine (machine_),
 	      buffer (buffer_),
-	      num_glyphs (face_->get_num_glyphs ()) {}
+	      num_glyphs (face_->get_num_glyphs ()),
+	      class_cache (class_cache_ && machine_.has_slow_classes () ? class_cache_ : nullptr)
+  {
+    if (class_cache)
+      class_cache->next_subtable ();
+  }
+
+  unsigned int get_class (hb_codepoint_t glyph_id)
+  {
+    unsigned int klass;
+    if (class_cache && class_cache->get (glyph_id, &klass))
+      return klass;
+    klass = machine.get_class (glyph_id, num_glyphs);
+    if (class_cache)
+      class_cache->set (glyph_id, klass);
+    return klass;
+  }
 
   template <typename context_t>
   void drive (context_t *c)
   {
+    if (unlikely (buffer->max_ops_budget) &&
+	(buffer->max_ops -= buffer->len) <= 0)
+      return;
+
     if (!c->in_place)
       buffer->clear_output ();
 
@@ -746,7 +965,7 @@ struct StateTableDriver
     for (buffer->idx = 0; buffer->successful;)
     {
       unsigned int klass = buffer->idx < buffer->len ?
-			   machine.get_class (buffer->info[buffer->idx].codepoint, num_glyphs) :
+			   get_class (buffer->info[buffer->idx].codepoint) :
 			   (unsigned) StateTable<Types, EntryData>::CLASS_END_OF_TEXT;
       DEBUG_MSG (APPLY, nullptr, "c%u at %u", klass, buffer->idx);
       const Entry<EntryData> &entry = machine.get_entry (state, klass);
@@ -797,6 +1016,7 @@ struct StateTableDriver
   const StateTable<Types, EntryData> &machine;
   hb_buffer_t *buffer;
   unsigned int num_glyphs;
+  class_cache_t *class_cache;
 };
 
 
@@ -817,8 +1037,13 @@ struct hb_aat_apply_context_t :
   hb_buffer_t *buffer;
   hb_sanitize_context_t sanitizer;
   const ankr *ankr_table;
+  class_cache_t class_cache;
+  pair_cache_t *pair_caches;
+  unsigned int num_pair_caches;
+  const pair_map_t *pair_maps;
+  unsigned int num_pair_maps;
 
-  /* Unused. For debug tracing only. */
+  /* Index of the subtable being applied, across chains. */
   unsigned int lookup_index;
   unsigned int debug_depth;
 
@@ -830,6 +1055,22 @@ struct hb_aat_apply_context_t :
   HB_INTERNAL ~hb_aat_apply_context_t ();
 
   HB_INTERNAL void set_ankr_table (const AAT::ankr *ankr_table_);
+  HB_INTERNAL void set_pair_caches (AAT::pair_cache_t *pair_caches_,
+				    unsigned int num_pair_caches_);
+
+  HB_INTERNAL void set_pair_maps (const AAT::pair_map_t *pair_maps_,
+				  unsigned int num_pair_maps_);
+
+  /* Pair cache for the subtable being applied, if any. */
+  pair_cache_t *get_pair_cache () const
+  { return lookup_index < num_pair_caches ? &pair_caches[lookup_index] : nullptr; }
+  /* Pair map for the subtable being applied, if one was built. */
+  const pair_map_t *get_pair_map () const
+  {
+    if (lookup_index >= num_pair_maps) return nullptr;
+    const pair_map_t *map = &pair_maps[lookup_index];
+    return map->is_empty () ? nullptr : map;
+  }
 
   void set_lookup_index (unsigned int i) { lookup_index = i; }
 };
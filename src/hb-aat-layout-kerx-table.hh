@@ -37,6 +37,10 @@
  */
 #define HB_AAT_TAG_kerx HB_TAG('k','e','r','x')
 
+#ifndef HB_KERX_MAX_PAIR_CACHES
+#define HB_KERX_MAX_PAIR_CACHES 32
+#endif
+
 
 namespace AAT {
 
@@ -67,6 +71,7 @@ struct hb_glyph_pair_t
 struct KernPair
 {
   int get_kerning () const { return value; }
+  hb_glyph_pair_t get_pair () const { return {left, right}; }
 
   int cmp (const hb_glyph_pair_t &o) const
   {
@@ -100,6 +105,27 @@ struct KerxSubTableFormat0
     return kerxTupleKern (v, header.tuple_count (), this, c);
   }
 
+  unsigned int get_pair_count () const { return pairs.len; }
+
+  /* Fills map with the nonzero kerning values of this subtable.  Values
+   * are looked up the same way get_kerning() does, so that duplicate or
+   * unsorted pairs resolve the same either way. */
+  bool collect_pairs (pair_map_t *map) const
+  {
+    if (header.tuple_count ())
+      return false;
+
+    unsigned int count = pairs.len;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      hb_glyph_pair_t pair = pairs[i].get_pair ();
+      int v = pairs.bsearch (pair).get_kerning ();
+      if (v)
+	map->set ((pair.left << 16) | pair.right, v);
+    }
+    return map->successful;
+  }
+
   bool apply (hb_aat_apply_context_t *c) const
   {
     TRACE_APPLY (this);
@@ -121,13 +147,31 @@ struct KerxSubTableFormat0
   {
     const KerxSubTableFormat0 &table;
     hb_aat_apply_context_t *c;
+    pair_cache_t *cache;
+    const pair_map_t *pair_map;
 
     accelerator_t (const KerxSubTableFormat0 &table_,
 		   hb_aat_apply_context_t *c_) :
-		     table (table_), c (c_) {}
+		     table (table_), c (c_),
+		     cache (table_.header.tuple_count () ? nullptr : c_->get_pair_cache ()),
+		     pair_map (table_.header.tuple_count () ? nullptr : c_->get_pair_map ()) {}
 
     int get_kerning (hb_codepoint_t left, hb_codepoint_t right) const
-    { return table.get_kerning (left, right, c); }
+    {
+      int v;
+      if (pair_map && !((left | right) >> 16))
+      {
+	unsigned int key = (left << 16) | right;
+	if (likely (key != HB_MAP_VALUE_INVALID)) /* Not representable in the map. */
+	  return pair_map->has (key, &v) ? v : 0;
+      }
+      if (cache && cache->get (left, right, &v))
+	return v;
+      v = table.get_kerning (left, right, c);
+      if (cache)
+	cache->set (left, right, v);
+      return v;
+    }
   };
 
 
@@ -355,7 +399,7 @@ struct KerxSubTableFormat1
 
     driver_context_t dc (this, c);
 
-    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->font->face);
+    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->font->face, &c->class_cache);
     driver.drive (&dc);
 
     return_trace (true);
@@ -420,13 +464,23 @@ struct KerxSubTableFormat2
   {
     const KerxSubTableFormat2 &table;
     hb_aat_apply_context_t *c;
+    pair_cache_t *cache;
 
     accelerator_t (const KerxSubTableFormat2 &table_,
 		   hb_aat_apply_context_t *c_) :
-		     table (table_), c (c_) {}
+		     table (table_), c (c_),
+		     cache (table_.header.tuple_count () ? nullptr : c_->get_pair_cache ()) {}
 
     int get_kerning (hb_codepoint_t left, hb_codepoint_t right) const
-    { return table.get_kerning (left, right, c); }
+    {
+      int v;
+      if (cache && cache->get (left, right, &v))
+	return v;
+      v = table.get_kerning (left, right, c);
+      if (cache)
+	cache->set (left, right, v);
+      return v;
+    }
   };
 
   bool sanitize (hb_sanitize_context_t *c) const
@@ -595,7 +649,7 @@ struct KerxSubTableFormat4
 
     driver_context_t dc (this, c);
 
-    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->font->face);
+    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->font->face, &c->class_cache);
     driver.drive (&dc);
 
     return_trace (true);
@@ -694,13 +748,23 @@ struct KerxSubTableFormat6
   {
     const KerxSubTableFormat6 &table;
     hb_aat_apply_context_t *c;
+    pair_cache_t *cache;
 
     accelerator_t (const KerxSubTableFormat6 &table_,
 		   hb_aat_apply_context_t *c_) :
-		     table (table_), c (c_) {}
+		     table (table_), c (c_),
+		     cache (table_.header.tuple_count () ? nullptr : c_->get_pair_cache ()) {}
 
     int get_kerning (hb_codepoint_t left, hb_codepoint_t right) const
-    { return table.get_kerning (left, right, c); }
+    {
+      int v;
+      if (cache && cache->get (left, right, &v))
+	return v;
+      v = table.get_kerning (left, right, c);
+      if (cache)
+	cache->set (left, right, v);
+      return v;
+    }
   };
 
   protected:
@@ -851,6 +915,32 @@ struct KerxTable
     return false;
   }
 
+  /* Builds pair maps for the first count subtables that are pair lists,
+   * hashing at most max_pairs pairs in total.  Other entries of maps are
+   * left empty. */
+  void collect_pair_maps (pair_map_t *maps, unsigned int count, unsigned int max_pairs) const
+  {
+    typedef typename T::SubTable SubTable;
+
+    const SubTable *st = &thiz()->firstSubTable;
+    count = hb_min (count, (unsigned) thiz()->tableCount);
+    for (unsigned int i = 0; i < count; i++)
+    {
+      if (st->get_type () == 0 && st->u.format0.get_pair_count () <= max_pairs)
+      {
+	unsigned int num_pairs = st->u.format0.get_pair_count ();
+	if (st->u.format0.collect_pairs (&maps[i]))
+	  max_pairs -= num_pairs;
+	else
+	{
+	  maps[i].fini ();
+	  maps[i].init ();
+	}
+      }
+      st = &StructAfter<SubTable> (*st);
+    }
+  }
+
   int get_h_kerning (hb_codepoint_t left, hb_codepoint_t right) const
   {
     typedef typename T::SubTable SubTable;
@@ -911,17 +1001,22 @@ struct KerxTable
 	}
       }
 
-      if (reverse)
-	c->buffer->reverse ();
-
       {
-	/* See comment in sanitize() for conditional here. */
-	hb_sanitize_with_object_t with (&c->sanitizer, i < count - 1 ? st : (const SubTable *) nullptr);
-	ret |= st->dispatch (c);
-      }
+	hb_buffer_trace_scope_t trace (c->buffer, c->font, HB_BUFFER_TRACE_EVENT_TYPE_SUBTABLE,
+				       thiz()->tableTag, c->lookup_index);
 
-      if (reverse)
-	c->buffer->reverse ();
+	if (reverse)
+	  c->buffer->reverse ();
+
+	{
+	  /* See comment in sanitize() for conditional here. */
+	  hb_sanitize_with_object_t with (&c->sanitizer, i < count - 1 ? st : (const SubTable *) nullptr);
+	  ret |= st->dispatch (c);
+	}
+
+	if (reverse)
+	  c->buffer->reverse ();
+      }
 
       (void) c->buffer->message (c->font, "end %c%c%c%c subtable %d", HB_UNTAG (thiz()->tableTag), c->lookup_index);
 
@@ -981,6 +1076,40 @@ struct kerx : KerxTable<kerx>
 
   bool has_data () const { return version; }
 
+  struct accelerator_t
+  {
+    void init (hb_face_t *face)
+    {
+      this->table = hb_sanitize_context_t().reference_table<kerx> (face);
+
+      /* One pair cache per subtable; subtables past the cap, and those
+       * that are not pair lookups, simply go uncached. */
+      this->num_pair_caches = hb_min ((unsigned) table->tableCount, (unsigned) HB_KERX_MAX_PAIR_CACHES);
+      this->pair_caches = (pair_cache_t *) calloc (this->num_pair_caches, sizeof (pair_cache_t));
+      if (unlikely (!this->pair_caches))
+	this->num_pair_caches = 0;
+
+      for (unsigned int i = 0; i < this->num_pair_caches; i++)
+	this->pair_caches[i].init ();
+    }
+
+    void fini ()
+    {
+      free (this->pair_caches);
+      this->table.destroy ();
+    }
+
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (this->table);
+      usage->heap += this->num_pair_caches * sizeof (pair_cache_t);
+    }
+
+    hb_blob_ptr_t<kerx> table;
+    unsigned int num_pair_caches;
+    pair_cache_t *pair_caches;
+  };
+
   protected:
   HBUINT16	version;	/* The version number of the extended kerning table
 				 * (currently 2, 3, or 4). */
@@ -995,6 +1124,8 @@ struct kerx : KerxTable<kerx>
 };
 
 
+struct kerx_accelerator_t : kerx::accelerator_t {};
+
 } /* namespace AAT */
 
 
@@ -167,12 +167,21 @@ struct RearrangementSubtable
 
     driver_context_t dc (this);
 
-    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face);
+    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face, &c->class_cache);
     driver.drive (&dc);
 
     return_trace (dc.ret);
   }
 
+  void collect_glyph_digest (hb_set_digest_t &digest, unsigned int num_glyphs) const
+  {
+    if (machine.is_idle_without_glyphs ([] (const Entry<EntryData> &entry)
+					{ return entry.flags & driver_context_t::Verb; }))
+      machine.collect_glyphs (digest, num_glyphs);
+    else
+      digest.add_range (0, HB_SET_VALUE_INVALID - 1);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -263,6 +272,8 @@ struct ContextualSubtable
       {
 	buffer->unsafe_to_break (mark, hb_min (buffer->idx + 1, buffer->len));
 	buffer->info[mark].codepoint = *replacement;
+	if (unlikely (*replacement == DELETED_GLYPH))
+	  buffer->scratch_flags |= HB_BUFFER_SCRATCH_FLAG_AAT_HAS_DELETED;
 	ret = true;
       }
 
@@ -287,6 +298,8 @@ struct ContextualSubtable
       if (replacement)
       {
 	buffer->info[idx].codepoint = *replacement;
+	if (unlikely (*replacement == DELETED_GLYPH))
+	  buffer->scratch_flags |= HB_BUFFER_SCRATCH_FLAG_AAT_HAS_DELETED;
 	ret = true;
       }
 
@@ -313,12 +326,21 @@ struct ContextualSubtable
 
     driver_context_t dc (this, c);
 
-    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face);
+    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face, &c->class_cache);
     driver.drive (&dc);
 
     return_trace (dc.ret);
   }
 
+  void collect_glyph_digest (hb_set_digest_t &digest, unsigned int num_glyphs) const
+  {
+    if (machine.is_idle_without_glyphs ([] (const Entry<EntryData> &entry)
+					{ return entry.data.markIndex != 0xFFFF || entry.data.currentIndex != 0xFFFF; }))
+      machine.collect_glyphs (digest, num_glyphs);
+    else
+      digest.add_range (0, HB_SET_VALUE_INVALID - 1);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -526,6 +548,8 @@ struct LigatureSubtable
 
 	    DEBUG_MSG (APPLY, nullptr, "Produced ligature %u", lig);
 	    buffer->replace_glyph (lig);
+	    if (unlikely (lig == DELETED_GLYPH))
+	      buffer->scratch_flags |= HB_BUFFER_SCRATCH_FLAG_AAT_HAS_DELETED;
 
 	    unsigned int lig_end = match_positions[(match_length - 1u) % ARRAY_LENGTH (match_positions)] + 1u;
 	    /* Now go and delete all subsequent components. */
@@ -534,6 +558,7 @@ struct LigatureSubtable
 	      DEBUG_MSG (APPLY, nullptr, "Skipping ligature component");
 	      buffer->move_to (match_positions[--match_length % ARRAY_LENGTH (match_positions)]);
 	      buffer->replace_glyph (DELETED_GLYPH);
+	      buffer->scratch_flags |= HB_BUFFER_SCRATCH_FLAG_AAT_HAS_DELETED;
 	    }
 
 	    buffer->move_to (lig_end);
@@ -565,12 +590,21 @@ struct LigatureSubtable
 
     driver_context_t dc (this, c);
 
-    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face);
+    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face, &c->class_cache);
     driver.drive (&dc);
 
     return_trace (dc.ret);
   }
 
+  void collect_glyph_digest (hb_set_digest_t &digest, unsigned int num_glyphs) const
+  {
+    if (machine.is_idle_without_glyphs ([] (const Entry<EntryData> &entry)
+					{ return LigatureEntryT::performAction (entry); }))
+      machine.collect_glyphs (digest, num_glyphs);
+    else
+      digest.add_range (0, HB_SET_VALUE_INVALID - 1);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -610,6 +644,8 @@ struct NoncontextualSubtable
       if (replacement)
       {
 	info[i].codepoint = *replacement;
+	if (unlikely (*replacement == DELETED_GLYPH))
+	  c->buffer->scratch_flags |= HB_BUFFER_SCRATCH_FLAG_AAT_HAS_DELETED;
 	ret = true;
       }
     }
@@ -617,6 +653,9 @@ struct NoncontextualSubtable
     return_trace (ret);
   }
 
+  void collect_glyph_digest (hb_set_digest_t &digest, unsigned int num_glyphs) const
+  { substitute.collect_glyphs (digest, num_glyphs, [] (unsigned int) { return true; }); }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -738,7 +777,11 @@ struct InsertionSubtable
 	  buffer->copy_glyph ();
 	/* TODO We ignore KashidaLike setting. */
 	for (unsigned int i = 0; i < count; i++)
+	{
 	  buffer->output_glyph (glyphs[i]);
+	  if (unlikely (glyphs[i] == DELETED_GLYPH))
+	    buffer->scratch_flags |= HB_BUFFER_SCRATCH_FLAG_AAT_HAS_DELETED;
+	}
 	if (buffer->idx < buffer->len && !before)
 	  buffer->skip_glyph ();
 
@@ -765,7 +808,11 @@ struct InsertionSubtable
 	  buffer->copy_glyph ();
 	/* TODO We ignore KashidaLike setting. */
 	for (unsigned int i = 0; i < count; i++)
+	{
 	  buffer->output_glyph (glyphs[i]);
+	  if (unlikely (glyphs[i] == DELETED_GLYPH))
+	    buffer->scratch_flags |= HB_BUFFER_SCRATCH_FLAG_AAT_HAS_DELETED;
+	}
 	if (buffer->idx < buffer->len && !before)
 	  buffer->skip_glyph ();
 
@@ -802,12 +849,22 @@ struct InsertionSubtable
 
     driver_context_t dc (this, c);
 
-    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face);
+    StateTableDriver<Types, EntryData> driver (machine, c->buffer, c->face, &c->class_cache);
     driver.drive (&dc);
 
     return_trace (dc.ret);
   }
 
+  void collect_glyph_digest (hb_set_digest_t &digest, unsigned int num_glyphs) const
+  {
+    if (machine.is_idle_without_glyphs ([] (const Entry<EntryData> &entry)
+					{ return (entry.flags & (driver_context_t::CurrentInsertCount | driver_context_t::MarkedInsertCount)) &&
+					       (entry.data.currentInsertIndex != 0xFFFF || entry.data.markedInsertIndex != 0xFFFF); }))
+      machine.collect_glyphs (digest, num_glyphs);
+    else
+      digest.add_range (0, HB_SET_VALUE_INVALID - 1);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -905,6 +962,20 @@ struct ChainSubtable
     return_trace (dispatch (c));
   }
 
+  /* Adds the glyphs without which applying this subtable would not
+   * change the buffer. */
+  void collect_glyph_digest (hb_set_digest_t &digest, unsigned int num_glyphs) const
+  {
+    switch (get_type ()) {
+    case Rearrangement:	u.rearrangement.collect_glyph_digest (digest, num_glyphs); return;
+    case Contextual:	u.contextual.collect_glyph_digest (digest, num_glyphs); return;
+    case Ligature:	u.ligature.collect_glyph_digest (digest, num_glyphs); return;
+    case Noncontextual:	u.noncontextual.collect_glyph_digest (digest, num_glyphs); return;
+    case Insertion:	u.insertion.collect_glyph_digest (digest, num_glyphs); return;
+    default:		return;
+    }
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -966,9 +1037,27 @@ struct Chain
     return flags;
   }
 
+  void compile_digests (unsigned int num_glyphs,
+			hb_vector_t<hb_set_digest_t> &digests) const
+  {
+    const ChainSubtable<Types> *subtable = &StructAfter<ChainSubtable<Types>> (featureZ.as_array (featureCount));
+    unsigned int count = subtableCount;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      hb_set_digest_t *digest = digests.push ();
+      digest->init ();
+      subtable->collect_glyph_digest (*digest, num_glyphs);
+      subtable = &StructAfter<ChainSubtable<Types>> (*subtable);
+    }
+  }
+
   void apply (hb_aat_apply_context_t *c,
 		     hb_mask_t flags) const
   {
+    const hb_vector_t<hb_set_digest_t> &digests = c->plan->aat_map.subtable_digests;
+    hb_set_digest_t buffer_digest;
+    bool buffer_digest_valid = false;
+
     const ChainSubtable<Types> *subtable = &StructAfter<ChainSubtable<Types>> (featureZ.as_array (featureCount));
     unsigned int count = subtableCount;
     for (unsigned int i = 0; i < count; i++)
@@ -978,6 +1067,19 @@ struct Chain
       if (!(subtable->subFeatureFlags & flags))
         goto skip;
 
+      /* Skip subtables that do not care about any glyph in the buffer. */
+      if (c->lookup_index < digests.length)
+      {
+	if (!buffer_digest_valid)
+	{
+	  buffer_digest.init ();
+	  buffer_digest.add_array (&c->buffer->info[0].codepoint, c->buffer->len, sizeof (c->buffer->info[0]));
+	  buffer_digest_valid = true;
+	}
+	if (!digests[c->lookup_index].may_have (buffer_digest))
+	  goto skip;
+      }
+
       if (!(subtable->get_coverage() & ChainSubtable<Types>::AllDirections) &&
 	  HB_DIRECTION_IS_VERTICAL (c->buffer->props.direction) !=
 	  bool (subtable->get_coverage() & ChainSubtable<Types>::Vertical))
@@ -1018,13 +1120,20 @@ struct Chain
       if (!c->buffer->message (c->font, "start chain subtable %d", c->lookup_index))
         goto skip;
 
-      if (reverse)
-        c->buffer->reverse ();
+      {
+	hb_buffer_trace_scope_t trace (c->buffer, c->font, HB_BUFFER_TRACE_EVENT_TYPE_SUBTABLE,
+				       Types::extended ? HB_AAT_TAG_morx : HB_AAT_TAG_mort,
+				       c->lookup_index);
+
+	if (reverse)
+	  c->buffer->reverse ();
 
-      subtable->apply (c);
+	subtable->apply (c);
+	buffer_digest_valid = false;
 
-      if (reverse)
-        c->buffer->reverse ();
+	if (reverse)
+	  c->buffer->reverse ();
+      }
 
       (void) c->buffer->message (c->font, "end chain subtable %d", c->lookup_index);
 
@@ -1092,9 +1201,11 @@ struct mortmorx
   {
     const Chain<Types> *chain = &firstChain;
     unsigned int count = chainCount;
+    unsigned int num_glyphs = mapper->face->get_num_glyphs ();
     for (unsigned int i = 0; i < count; i++)
     {
       map->chain_flags.push (chain->compile_flags (mapper));
+      chain->compile_digests (num_glyphs, map->subtable_digests);
       chain = &StructAfter<Chain<Types>> (*chain);
     }
   }
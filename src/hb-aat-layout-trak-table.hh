@@ -177,8 +177,7 @@ struct trak
     hb_buffer_t *buffer = c->buffer;
     if (HB_DIRECTION_IS_HORIZONTAL (buffer->props.direction))
     {
-      const TrackData &trackData = this+horizData;
-      int tracking = trackData.get_tracking (this, ptem);
+      int tracking = get_tracking (c->font, true);
       hb_position_t offset_to_add = c->font->em_scalef_x (tracking / 2);
       hb_position_t advance_to_add = c->font->em_scalef_x (tracking);
       foreach_grapheme (buffer, start, end)
@@ -190,8 +189,7 @@ struct trak
     }
     else
     {
-      const TrackData &trackData = this+vertData;
-      int tracking = trackData.get_tracking (this, ptem);
+      int tracking = get_tracking (c->font, false);
       hb_position_t offset_to_add = c->font->em_scalef_y (tracking / 2);
       hb_position_t advance_to_add = c->font->em_scalef_y (tracking);
       foreach_grapheme (buffer, start, end)
@@ -205,6 +203,22 @@ struct trak
     return_trace (true);
   }
 
+  /* Resolving the tracking walks the size table and interpolates; it only
+   * changes with the face and ptem, both of which bump the font's serial. */
+  int get_tracking (hb_font_t *font, bool horizontal) const
+  {
+    hb_font_t::trak_cache_t &cache = font->trak_cache[horizontal ? 0 : 1];
+    int key = (int) (font->serial + 1);
+    if (cache.serial.get () == key)
+      return cache.tracking.get_relaxed ();
+
+    const TrackData &trackData = horizontal ? this+horizData : this+vertData;
+    int tracking = trackData.get_tracking (this, font->ptem);
+    cache.tracking.set_relaxed (tracking);
+    cache.serial.set (key);
+    return tracking;
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
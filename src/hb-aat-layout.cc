@@ -157,6 +157,10 @@ AAT::hb_aat_apply_context_t::hb_aat_apply_context_t (const hb_ot_shape_plan_t *p
 						       buffer (buffer_),
 						       sanitizer (),
 						       ankr_table (&Null(AAT::ankr)),
+						       pair_caches (nullptr),
+						       num_pair_caches (0),
+						       pair_maps (nullptr),
+						       num_pair_maps (0),
 						       lookup_index (0),
 						       debug_depth (0)
 {
@@ -164,6 +168,7 @@ AAT::hb_aat_apply_context_t::hb_aat_apply_context_t (const hb_ot_shape_plan_t *p
   sanitizer.set_num_glyphs (face->get_num_glyphs ());
   sanitizer.start_processing ();
   sanitizer.set_max_ops (HB_SANITIZE_MAX_OPS_MAX);
+  class_cache.init ();
 }
 
 AAT::hb_aat_apply_context_t::~hb_aat_apply_context_t ()
@@ -173,11 +178,28 @@ void
 AAT::hb_aat_apply_context_t::set_ankr_table (const AAT::ankr *ankr_table_)
 { ankr_table = ankr_table_; }
 
+void
+AAT::hb_aat_apply_context_t::set_pair_caches (AAT::pair_cache_t *pair_caches_,
+					      unsigned int num_pair_caches_)
+{
+  pair_caches = pair_caches_;
+  num_pair_caches = num_pair_caches_;
+}
+
+void
+AAT::hb_aat_apply_context_t::set_pair_maps (const AAT::pair_map_t *pair_maps_,
+					    unsigned int num_pair_maps_)
+{
+  pair_maps = pair_maps_;
+  num_pair_maps = num_pair_maps_;
+}
+
 
 /*
  * mort/morx/kerx/trak
  */
 
+#if !defined(HB_NO_AAT)
 
 void
 hb_aat_layout_compile_map (const hb_aat_map_builder_t *mapper,
@@ -198,6 +220,8 @@ hb_aat_layout_compile_map (const hb_aat_map_builder_t *mapper,
   }
 }
 
+#endif
+
 
 /*
  * hb_aat_layout_has_substitution:
@@ -209,10 +233,14 @@ hb_aat_layout_compile_map (const hb_aat_map_builder_t *mapper,
 hb_bool_t
 hb_aat_layout_has_substitution (hb_face_t *face)
 {
+#if defined(HB_NO_AAT)
+  return false;
+#endif
   return face->table.morx->has_data () ||
 	 face->table.mort->has_data ();
 }
 
+#if !defined(HB_NO_AAT)
 void
 hb_aat_layout_substitute (const hb_ot_shape_plan_t *plan,
 			  hb_font_t *font,
@@ -237,28 +265,7 @@ hb_aat_layout_substitute (const hb_ot_shape_plan_t *plan,
   }
 }
 
-void
-hb_aat_layout_zero_width_deleted_glyphs (hb_buffer_t *buffer)
-{
-  unsigned int count = buffer->len;
-  hb_glyph_info_t *info = buffer->info;
-  hb_glyph_position_t *pos = buffer->pos;
-  for (unsigned int i = 0; i < count; i++)
-    if (unlikely (info[i].codepoint == AAT::DELETED_GLYPH))
-      pos[i].x_advance = pos[i].y_advance = pos[i].x_offset = pos[i].y_offset = 0;
-}
-
-static bool
-is_deleted_glyph (const hb_glyph_info_t *info)
-{
-  return info->codepoint == AAT::DELETED_GLYPH;
-}
-
-void
-hb_aat_layout_remove_deleted_glyphs (hb_buffer_t *buffer)
-{
-  hb_ot_layout_delete_glyphs_inplace (buffer, is_deleted_glyph);
-}
+#endif
 
 /*
  * hb_aat_layout_has_positioning:
@@ -270,21 +277,28 @@ hb_aat_layout_remove_deleted_glyphs (hb_buffer_t *buffer)
 hb_bool_t
 hb_aat_layout_has_positioning (hb_face_t *face)
 {
-  return face->table.kerx->has_data ();
+#if defined(HB_NO_AAT)
+  return false;
+#endif
+  return face->table.kerx->table->has_data ();
 }
 
+#if !defined(HB_NO_AAT)
 void
 hb_aat_layout_position (const hb_ot_shape_plan_t *plan,
 			hb_font_t *font,
 			hb_buffer_t *buffer)
 {
-  hb_blob_t *kerx_blob = font->face->table.kerx.get_blob ();
-  const AAT::kerx& kerx = *kerx_blob->as<AAT::kerx> ();
+  const AAT::kerx_accelerator_t &accel = *font->face->table.kerx;
+  hb_blob_t *kerx_blob = accel.table.get_blob ();
+  const AAT::kerx& kerx = *accel.table;
 
   AAT::hb_aat_apply_context_t c (plan, font, buffer, kerx_blob);
   c.set_ankr_table (font->face->table.ankr.get ());
+  c.set_pair_caches (accel.pair_caches, accel.num_pair_caches);
   kerx.apply (&c);
 }
+#endif
 
 
 /*
@@ -297,9 +311,13 @@ hb_aat_layout_position (const hb_ot_shape_plan_t *plan,
 hb_bool_t
 hb_aat_layout_has_tracking (hb_face_t *face)
 {
+#if defined(HB_NO_AAT)
+  return false;
+#endif
   return face->table.trak->has_data ();
 }
 
+#if !defined(HB_NO_AAT)
 void
 hb_aat_layout_track (const hb_ot_shape_plan_t *plan,
 		     hb_font_t *font,
@@ -310,6 +328,7 @@ hb_aat_layout_track (const hb_ot_shape_plan_t *plan,
   AAT::hb_aat_apply_context_t c (plan, font, buffer);
   trak.apply (&c);
 }
+#endif
 
 /**
  * hb_aat_layout_get_feature_types:
@@ -328,6 +347,11 @@ hb_aat_layout_get_feature_types (hb_face_t                    *face,
 				 unsigned int                 *feature_count, /* IN/OUT.  May be NULL. */
 				 hb_aat_layout_feature_type_t *features       /* OUT.     May be NULL. */)
 {
+#if defined(HB_NO_AAT)
+  if (feature_count)
+    *feature_count = 0;
+  return 0;
+#endif
   return face->table.feat->get_feature_types (start_offset, feature_count, features);
 }
 
@@ -344,6 +368,9 @@ hb_ot_name_id_t
 hb_aat_layout_feature_type_get_name_id (hb_face_t                    *face,
 					hb_aat_layout_feature_type_t  feature_type)
 {
+#if defined(HB_NO_AAT)
+  return HB_OT_NAME_ID_INVALID;
+#endif
   return face->table.feat->get_feature_name_id (feature_type);
 }
 
@@ -372,5 +399,12 @@ hb_aat_layout_feature_type_get_selector_infos (hb_face_t
 					       hb_aat_layout_feature_selector_info_t *selectors,      /* OUT.     May be NULL. */
 					       unsigned int                          *default_index   /* OUT.     May be NULL. */)
 {
+#if defined(HB_NO_AAT)
+  if (selector_count)
+    *selector_count = 0;
+  if (default_index)
+    *default_index = HB_AAT_LAYOUT_NO_SELECTOR_INDEX;
+  return 0;
+#endif
   return face->table.feat->get_selector_infos (feature_type, start_offset, selector_count, selectors, default_index);
 }
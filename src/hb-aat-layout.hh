@@ -32,6 +32,12 @@
 #include "hb-ot-shape.hh"
 #include "hb-aat-ltag-table.hh"
 
+namespace AAT {
+/* What morx turns the glyphs it deletes into; they are removed after
+ * substitution.  See hb_ot_substitute_post(). */
+enum { DELETED_GLYPH = 0xFFFF };
+}
+
 struct hb_aat_feature_mapping_t
 {
   hb_tag_t otFeatureTag;
@@ -61,12 +67,6 @@ hb_aat_layout_substitute (const hb_ot_shape_plan_t *plan,
 			  hb_font_t *font,
 			  hb_buffer_t *buffer);
 
-HB_INTERNAL void
-hb_aat_layout_zero_width_deleted_glyphs (hb_buffer_t *buffer);
-
-HB_INTERNAL void
-hb_aat_layout_remove_deleted_glyphs (hb_buffer_t *buffer);
-
 HB_INTERNAL void
 hb_aat_layout_position (const hb_ot_shape_plan_t *plan,
 			hb_font_t *font,
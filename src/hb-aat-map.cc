@@ -30,6 +30,7 @@
 
 #include "hb-aat-layout.hh"
 
+#if !defined(HB_NO_AAT)
 
 void hb_aat_map_builder_t::add_feature (hb_tag_t tag,
 					unsigned int value)
@@ -66,3 +67,6 @@ hb_aat_map_builder_t::compile (hb_aat_map_t  &m)
 
   hb_aat_layout_compile_map (this, &m);
 }
+
+
+#endif
@@ -29,6 +29,8 @@
 
 #include "hb.hh"
 
+#include "hb-set-digest.hh"
+
 
 struct hb_aat_map_t
 {
@@ -40,11 +42,18 @@ struct hb_aat_map_t
   {
     memset (this, 0, sizeof (*this));
     chain_flags.init ();
+    subtable_digests.init ();
+  }
+  void fini ()
+  {
+    chain_flags.fini ();
+    subtable_digests.fini ();
   }
-  void fini () { chain_flags.fini (); }
 
   public:
   hb_vector_t<hb_mask_t> chain_flags;
+  /* Glyphs each subtable, across all chains, depends on. */
+  hb_vector_t<hb_set_digest_t> subtable_digests;
 };
 
 struct hb_aat_map_builder_t
@@ -638,7 +638,7 @@ static inline void sort_r_simple(void *base, size_t nel, size_t w,
 
     /* Use median of first, middle and last items as pivot */
     char *x, *y, *xend, ch;
-    char *pl, *pm, *pr;
+    char *pl, *pr;
     char *last = b+w*(nel-1), *tmp;
     char *l[3];
     l[0] = b;
@@ -656,24 +656,25 @@ static inline void sort_r_simple(void *base, size_t nel, size_t w,
       ch = *x; *x = *y; *y = ch;
     }
 
+    /* Partition around the pivot; elements equal to it stop both scans,
+     * so runs of equal elements still split evenly. */
     pl = b;
-    pr = last;
-
-    while(pl < pr) {
-      pm = pl+((pr-pl+1)>>1);
-      for(; pl < pm; pl += w) {
-        if(sort_r_cmpswap(pl, pr, w, compar, arg)) {
-          pr -= w; /* pivot now at pl */
-          break;
-        }
-      }
-      pm = pl+((pr-pl)>>1);
-      for(; pm < pr; pr -= w) {
-        if(sort_r_cmpswap(pl, pr, w, compar, arg)) {
-          pl += w; /* pivot now at pr */
-          break;
-        }
+    pr = last - w;
+    for (;;)
+    {
+      while(pl < last && compar(pl, last, arg) < 0) pl += w;
+      while(pr > b && compar(pr, last, arg) > 0) pr -= w;
+      if(pl >= pr) break;
+      for(x = pl, y = pr, xend = x+w; x<xend; x++, y++) {
+        ch = *x; *x = *y; *y = ch;
       }
+      pl += w;
+      pr -= w;
+    }
+
+    /* Move the pivot to its final place. */
+    for(x = pl, y = last, xend = x+w; x<xend && x != y; x++, y++) {
+      ch = *x; *x = *y; *y = ch;
     }
 
     sort_r_simple(b, (pl-b)/w, w, compar, arg);
@@ -740,29 +741,144 @@ hb_codepoint_parse (const char *s, unsigned int len, int base, hb_codepoint_t *o
 }
 
 
+/* Explicit SIMD for the bit-set page operations below, if hb.hh found
+ * any.  Unlike HB_VECTOR_SIZE, these use unaligned loads and stores, so
+ * they are safe on memory from hb_vector_t. */
+
+#if defined(HB_SIMD_AVX2) || defined(HB_SIMD_SSE2) || defined(HB_SIMD_NEON)
+#define HB_SIMD 1
+
+struct hb_simd_t
+{
+#if defined(HB_SIMD_AVX2)
+  typedef __m256i vec_t;
+  static vec_t load (const void *p) { return _mm256_loadu_si256 ((const __m256i *) p); }
+  static void store (void *p, vec_t v) { _mm256_storeu_si256 ((__m256i *) p, v); }
+  static vec_t or_ (vec_t a, vec_t b) { return _mm256_or_si256 (a, b); }
+  static vec_t and_ (vec_t a, vec_t b) { return _mm256_and_si256 (a, b); }
+  static vec_t andnot (vec_t a, vec_t b) { return _mm256_andnot_si256 (b, a); }
+  static vec_t xor_ (vec_t a, vec_t b) { return _mm256_xor_si256 (a, b); }
+  static bool is_zero (vec_t v) { return _mm256_testz_si256 (v, v); }
+#elif defined(HB_SIMD_SSE2)
+  typedef __m128i vec_t;
+  static vec_t load (const void *p) { return _mm_loadu_si128 ((const __m128i *) p); }
+  static void store (void *p, vec_t v) { _mm_storeu_si128 ((__m128i *) p, v); }
+  static vec_t or_ (vec_t a, vec_t b) { return _mm_or_si128 (a, b); }
+  static vec_t and_ (vec_t a, vec_t b) { return _mm_and_si128 (a, b); }
+  static vec_t andnot (vec_t a, vec_t b) { return _mm_andnot_si128 (b, a); }
+  static vec_t xor_ (vec_t a, vec_t b) { return _mm_xor_si128 (a, b); }
+  static bool is_zero (vec_t v)
+  { return 0xFFFF == _mm_movemask_epi8 (_mm_cmpeq_epi8 (v, _mm_setzero_si128 ())); }
+#elif defined(HB_SIMD_NEON)
+  typedef uint64x2_t vec_t;
+  static vec_t load (const void *p) { return vreinterpretq_u64_u8 (vld1q_u8 ((const uint8_t *) p)); }
+  static void store (void *p, vec_t v) { vst1q_u8 ((uint8_t *) p, vreinterpretq_u8_u64 (v)); }
+  static vec_t or_ (vec_t a, vec_t b) { return vorrq_u64 (a, b); }
+  static vec_t and_ (vec_t a, vec_t b) { return vandq_u64 (a, b); }
+  static vec_t andnot (vec_t a, vec_t b) { return vbicq_u64 (a, b); }
+  static vec_t xor_ (vec_t a, vec_t b) { return veorq_u64 (a, b); }
+  static bool is_zero (vec_t v) { return !vmaxvq_u32 (vreinterpretq_u32_u64 (v)); }
+#endif
+  static constexpr unsigned size = sizeof (vec_t);
+
+  /* Population count of byte_size bytes at p; byte_size a multiple of size. */
+  static unsigned int popcount (const void *p, unsigned int byte_size)
+  {
+#if defined(HB_SIMD_NEON)
+    uint16x8_t sum = vdupq_n_u16 (0);
+    for (unsigned int i = 0; i < byte_size; i += size)
+      sum = vpadalq_u8 (sum, vcntq_u8 (vld1q_u8 ((const uint8_t *) p + i)));
+    return vaddvq_u16 (sum);
+#elif !defined(__POPCNT__)
+    /* Bit-slicing; without a popcount instruction the scalar fallback
+     * is a table lookup or libgcc call per word. */
+#if defined(HB_SIMD_AVX2)
+    const __m256i m1 = _mm256_set1_epi8 (0x55);
+    const __m256i m2 = _mm256_set1_epi8 (0x33);
+    const __m256i m4 = _mm256_set1_epi8 (0x0F);
+    __m256i sum = _mm256_setzero_si256 ();
+    for (unsigned int i = 0; i < byte_size; i += size)
+    {
+      __m256i v = load ((const char *) p + i);
+      v = _mm256_sub_epi8 (v, _mm256_and_si256 (_mm256_srli_epi64 (v, 1), m1));
+      v = _mm256_add_epi8 (_mm256_and_si256 (v, m2), _mm256_and_si256 (_mm256_srli_epi64 (v, 2), m2));
+      v = _mm256_and_si256 (_mm256_add_epi8 (v, _mm256_srli_epi64 (v, 4)), m4);
+      sum = _mm256_add_epi64 (sum, _mm256_sad_epu8 (v, _mm256_setzero_si256 ()));
+    }
+    __m128i s = _mm_add_epi64 (_mm256_castsi256_si128 (sum), _mm256_extracti128_si256 (sum, 1));
+#else
+    const __m128i m1 = _mm_set1_epi8 (0x55);
+    const __m128i m2 = _mm_set1_epi8 (0x33);
+    const __m128i m4 = _mm_set1_epi8 (0x0F);
+    __m128i s = _mm_setzero_si128 ();
+    for (unsigned int i = 0; i < byte_size; i += size)
+    {
+      __m128i v = load ((const char *) p + i);
+      v = _mm_sub_epi8 (v, _mm_and_si128 (_mm_srli_epi64 (v, 1), m1));
+      v = _mm_add_epi8 (_mm_and_si128 (v, m2), _mm_and_si128 (_mm_srli_epi64 (v, 2), m2));
+      v = _mm_and_si128 (_mm_add_epi8 (v, _mm_srli_epi64 (v, 4)), m4);
+      s = _mm_add_epi64 (s, _mm_sad_epu8 (v, _mm_setzero_si128 ()));
+    }
+#endif
+    return _mm_cvtsi128_si32 (s) + _mm_cvtsi128_si32 (_mm_unpackhi_epi64 (s, s));
+#else
+    unsigned int pop = 0;
+    for (unsigned int i = 0; i < byte_size; i += 8)
+    {
+      uint64_t v;
+      memcpy (&v, (const char *) p + i, 8);
+      pop += hb_popcount (v);
+    }
+    return pop;
+#endif
+  }
+};
+#endif
+
 struct HbOpOr
 {
   static constexpr bool passthru_left = true;
   static constexpr bool passthru_right = true;
   template <typename T> static void process (T &o, const T &a, const T &b) { o = a | b; }
+#ifdef HB_SIMD
+  static hb_simd_t::vec_t process (hb_simd_t::vec_t a, hb_simd_t::vec_t b) { return hb_simd_t::or_ (a, b); }
+#endif
 };
 struct HbOpAnd
 {
   static constexpr bool passthru_left = false;
   static constexpr bool passthru_right = false;
   template <typename T> static void process (T &o, const T &a, const T &b) { o = a & b; }
+#ifdef HB_SIMD
+  static hb_simd_t::vec_t process (hb_simd_t::vec_t a, hb_simd_t::vec_t b) { return hb_simd_t::and_ (a, b); }
+#endif
 };
 struct HbOpMinus
 {
   static constexpr bool passthru_left = true;
   static constexpr bool passthru_right = false;
   template <typename T> static void process (T &o, const T &a, const T &b) { o = a & ~b; }
+#ifdef HB_SIMD
+  static hb_simd_t::vec_t process (hb_simd_t::vec_t a, hb_simd_t::vec_t b) { return hb_simd_t::andnot (a, b); }
+#endif
+};
+struct HbOpReverseMinus
+{
+  static constexpr bool passthru_left = false;
+  static constexpr bool passthru_right = true;
+  template <typename T> static void process (T &o, const T &a, const T &b) { o = ~a & b; }
+#ifdef HB_SIMD
+  static hb_simd_t::vec_t process (hb_simd_t::vec_t a, hb_simd_t::vec_t b) { return hb_simd_t::andnot (b, a); }
+#endif
 };
 struct HbOpXor
 {
   static constexpr bool passthru_left = true;
   static constexpr bool passthru_right = true;
   template <typename T> static void process (T &o, const T &a, const T &b) { o = a ^ b; }
+#ifdef HB_SIMD
+  static hb_simd_t::vec_t process (hb_simd_t::vec_t a, hb_simd_t::vec_t b) { return hb_simd_t::xor_ (a, b); }
+#endif
 };
 
 
@@ -783,6 +899,16 @@ struct hb_vector_size_t
   hb_vector_size_t process (const hb_vector_size_t &o) const
   {
     hb_vector_size_t r;
+#ifdef HB_SIMD
+    if (0 == byte_size % hb_simd_t::size)
+    {
+      for (unsigned int i = 0; i < byte_size; i += hb_simd_t::size)
+	hb_simd_t::store ((char *) &r + i,
+			  Op::process (hb_simd_t::load ((const char *) this + i),
+				       hb_simd_t::load ((const char *) &o + i)));
+      return r;
+    }
+#endif
 #if HB_VECTOR_SIZE
     if (HB_VECTOR_SIZE && 0 == (byte_size * 8) % HB_VECTOR_SIZE)
       for (unsigned int i = 0; i < ARRAY_LENGTH (u.vec); i++)
@@ -799,6 +925,35 @@ struct hb_vector_size_t
   { return process<HbOpAnd> (o); }
   hb_vector_size_t operator ^ (const hb_vector_size_t &o) const
   { return process<HbOpXor> (o); }
+  bool is_zero () const
+  {
+#ifdef HB_SIMD
+    if (0 == byte_size % hb_simd_t::size)
+    {
+      hb_simd_t::vec_t acc = hb_simd_t::load (this);
+      for (unsigned int i = hb_simd_t::size; i < byte_size; i += hb_simd_t::size)
+	acc = hb_simd_t::or_ (acc, hb_simd_t::load ((const char *) this + i));
+      return hb_simd_t::is_zero (acc);
+    }
+#endif
+    for (unsigned int i = 0; i < ARRAY_LENGTH (u.v); i++)
+      if (u.v[i])
+	return false;
+    return true;
+  }
+
+  unsigned int get_population () const
+  {
+#ifdef HB_SIMD
+    if (0 == byte_size % hb_simd_t::size)
+      return hb_simd_t::popcount (this, byte_size);
+#endif
+    unsigned int pop = 0;
+    for (unsigned int i = 0; i < ARRAY_LENGTH (u.v); i++)
+      pop += hb_popcount (u.v[i]);
+    return pop;
+  }
+
   hb_vector_size_t operator ~ () const
   {
     hb_vector_size_t r;
@@ -274,6 +274,7 @@ struct hb_atomic_int_t
   int get () const { return hb_atomic_int_impl_get (&v); }
   int inc () { return hb_atomic_int_impl_add (&v,  1); }
   int dec () { return hb_atomic_int_impl_add (&v, -1); }
+  int add (int d) { return hb_atomic_int_impl_add (&v, d); }
 
   int v;
 };
@@ -389,13 +389,11 @@ hb_blob_get_data_writable (hb_blob_t *blob, unsigned int *length)
 }
 
 
-bool
-hb_blob_t::try_make_writable_inplace_unix ()
+#ifdef HAVE_SYS_MMAN_H
+static uintptr_t
+_hb_get_pagesize ()
 {
-#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MPROTECT)
-  uintptr_t pagesize = -1, mask, length;
-  const char *addr;
-
+  uintptr_t pagesize = -1;
 #if defined(HAVE_SYSCONF) && defined(_SC_PAGE_SIZE)
   pagesize = (uintptr_t) sysconf (_SC_PAGE_SIZE);
 #elif defined(HAVE_SYSCONF) && defined(_SC_PAGESIZE)
@@ -403,6 +401,16 @@ hb_blob_t::try_make_writable_inplace_unix ()
 #elif defined(HAVE_GETPAGESIZE)
   pagesize = (uintptr_t) getpagesize ();
 #endif
+  return pagesize;
+}
+#endif
+
+bool
+hb_blob_t::try_make_writable_inplace_unix ()
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MPROTECT)
+  uintptr_t pagesize = _hb_get_pagesize (), mask, length;
+  const char *addr;
 
   if ((uintptr_t) -1L == pagesize) {
     DEBUG_MSG_FUNC (BLOB, this, "failed to get pagesize: %s", strerror (errno));
@@ -432,6 +440,27 @@ hb_blob_t::try_make_writable_inplace_unix ()
 #endif
 }
 
+void
+hb_blob_t::advise (bool sequential) const
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(MADV_WILLNEED) && defined(MADV_SEQUENTIAL)
+  uintptr_t pagesize = _hb_get_pagesize ();
+  if (!this->length || (uintptr_t) -1L == pagesize)
+    return;
+
+  /* Only advisory; rounding out to whole pages is harmless even when the
+   * data isn't mapped from a file. */
+  uintptr_t mask = ~(pagesize-1);
+  const char *addr = (const char *) (((uintptr_t) this->data) & mask);
+  uintptr_t length = (const char *) (((uintptr_t) this->data + this->length + pagesize-1) & mask) - addr;
+  DEBUG_MSG_FUNC (BLOB, this,
+		  "calling madvise on [%p..%p] (%lu bytes)",
+		  addr, addr+length, (unsigned long) length);
+  if (-1 == madvise ((void *) addr, length, sequential ? MADV_SEQUENTIAL : MADV_WILLNEED))
+    DEBUG_MSG_FUNC (BLOB, this, "madvise failed: %s", strerror (errno));
+#endif
+}
+
 bool
 hb_blob_t::try_make_writable_inplace ()
 {
@@ -512,14 +541,67 @@ struct hb_mapped_file_t
 #ifdef _WIN32
   HANDLE mapping;
 #endif
+#ifdef HAVE_MMAP
+  /* Blobs of the same, unchanged, file share one mapping. */
+  dev_t dev;
+  ino_t ino;
+  time_t mtime;
+  unsigned int refcount; /* Protected by mapped_files_lock. */
+  hb_mapped_file_t *next;
+#endif
 };
 
+#if defined(HAVE_MMAP) && !defined(HB_NO_MMAP)
+static hb_mutex_t mapped_files_lock = HB_MUTEX_INIT;
+static hb_mapped_file_t *mapped_files;
+
+static hb_mapped_file_t *
+_hb_mapped_file_find (const struct stat &st)
+{
+  hb_lock_t lock (mapped_files_lock);
+  for (hb_mapped_file_t *file = mapped_files; file; file = file->next)
+    if (file->dev == st.st_dev && file->ino == st.st_ino &&
+	file->mtime == st.st_mtime && file->length == (unsigned long) st.st_size)
+    {
+      file->refcount++;
+      return file;
+    }
+  return nullptr;
+}
+
+static void
+_hb_mapped_file_add (hb_mapped_file_t *file)
+{
+  hb_lock_t lock (mapped_files_lock);
+  file->refcount = 1;
+  file->next = mapped_files;
+  mapped_files = file;
+}
+
+static bool
+_hb_mapped_file_release (hb_mapped_file_t *file)
+{
+  hb_lock_t lock (mapped_files_lock);
+  if (--file->refcount)
+    return false;
+  for (hb_mapped_file_t **p = &mapped_files; *p; p = &(*p)->next)
+    if (*p == file)
+    {
+      *p = file->next;
+      break;
+    }
+  return true;
+}
+#endif
+
 #if (defined(HAVE_MMAP) || defined(_WIN32)) && !defined(HB_NO_MMAP)
 static void
 _hb_mapped_file_destroy (void *file_)
 {
   hb_mapped_file_t *file = (hb_mapped_file_t *) file_;
 #ifdef HAVE_MMAP
+  if (!_hb_mapped_file_release (file))
+    return;
   munmap (file->contents, file->length);
 #elif defined(_WIN32)
   UnmapViewOfFile (file->contents);
@@ -555,6 +637,21 @@ hb_blob_create_from_file (const char *file_name)
   struct stat st;
   if (unlikely (fstat (fd, &st) == -1)) goto fail;
 
+  /* Reuse a mapping of the same file if we have one.  Since the mapping
+   * is shared, blobs are plain read-only: making one writable copies the
+   * data instead of changing the mapping under the other blobs. */
+  {
+    hb_mapped_file_t *shared = _hb_mapped_file_find (st);
+    if (shared)
+    {
+      close (fd);
+      free (file);
+      return hb_blob_create (shared->contents, shared->length,
+			     HB_MEMORY_MODE_READONLY, (void *) shared,
+			     (hb_destroy_func_t) _hb_mapped_file_destroy);
+    }
+  }
+
   file->length = (unsigned long) st.st_size;
   file->contents = (char *) mmap (nullptr, file->length, PROT_READ,
 				  MAP_PRIVATE | MAP_NORESERVE, fd, 0);
@@ -563,8 +660,13 @@ hb_blob_create_from_file (const char *file_name)
 
   close (fd);
 
+  file->dev = st.st_dev;
+  file->ino = st.st_ino;
+  file->mtime = st.st_mtime;
+  _hb_mapped_file_add (file);
+
   return hb_blob_create (file->contents, file->length,
-			 HB_MEMORY_MODE_READONLY_MAY_MAKE_WRITABLE, (void *) file,
+			 HB_MEMORY_MODE_READONLY, (void *) file,
 			 (hb_destroy_func_t) _hb_mapped_file_destroy);
 
 fail:
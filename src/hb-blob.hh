@@ -53,6 +53,8 @@ struct hb_blob_t
   HB_INTERNAL bool try_make_writable ();
   HB_INTERNAL bool try_make_writable_inplace ();
   HB_INTERNAL bool try_make_writable_inplace_unix ();
+  /* Tells the OS how the data will be read: soon, or front to back. */
+  HB_INTERNAL void advise (bool sequential) const;
 
   template <typename Type>
   const Type* as () const
@@ -98,4 +100,30 @@ struct hb_blob_ptr_t
 };
 
 
+/* Bytes a face or font holds on to, for hb_face_get_memory_usage():
+ * heap is memory allocated by HarfBuzz, mapped is font data that is only
+ * referenced, wherever it lives. */
+struct hb_memory_usage_t
+{
+  void add_blob (const hb_blob_t *blob)
+  {
+    if (!blob || hb_object_is_inert (blob)) return;
+    heap += sizeof (*blob);
+    /* Private copies, as made by try_make_writable(), are freed with free(). */
+    if (blob->destroy == (hb_destroy_func_t) free)
+      heap += blob->length;
+    else
+      mapped += blob->length;
+  }
+  template <typename P>
+  void add_blob (const hb_blob_ptr_t<P> &blob) { add_blob (blob.get_blob ()); }
+
+  template <typename Vector>
+  void add_vector (const Vector &v) { heap += v.get_heap_size (); }
+
+  unsigned int heap;
+  unsigned int mapped;
+};
+
+
 #endif /* HB_BLOB_HH */
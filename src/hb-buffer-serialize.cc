@@ -30,6 +30,7 @@
 static const char *serialize_formats[] = {
   "text",
   "json",
+  "binary",
   nullptr
 };
 
@@ -89,11 +90,98 @@ hb_buffer_serialize_format_to_string (hb_buffer_serialize_format_t format)
   {
     case HB_BUFFER_SERIALIZE_FORMAT_TEXT:	return serialize_formats[0];
     case HB_BUFFER_SERIALIZE_FORMAT_JSON:	return serialize_formats[1];
+    case HB_BUFFER_SERIALIZE_FORMAT_BINARY:	return serialize_formats[2];
     default:
     case HB_BUFFER_SERIALIZE_FORMAT_INVALID:	return nullptr;
   }
 }
 
+/* Decimal and hex formatting for the serializers below; snprintf()'s
+ * format parsing dominated serializing otherwise. */
+
+static char *
+_hb_serialize_uint (char *p, unsigned int v)
+{
+  char digits[10];
+  unsigned int n = 0;
+  do
+  {
+    digits[n++] = '0' + v % 10;
+    v /= 10;
+  } while (v);
+  while (n)
+    *p++ = digits[--n];
+  return p;
+}
+
+static char *
+_hb_serialize_int (char *p, int v)
+{
+  if (v < 0)
+  {
+    *p++ = '-';
+    return _hb_serialize_uint (p, 0u - (unsigned int) v);
+  }
+  return _hb_serialize_uint (p, v);
+}
+
+static char *
+_hb_serialize_hex (char *p, unsigned int v)
+{
+  char digits[8];
+  unsigned int n = 0;
+  do
+  {
+    digits[n++] = "0123456789ABCDEF"[v & 0xFu];
+    v >>= 4;
+  } while (v);
+  while (n)
+    *p++ = digits[--n];
+  return p;
+}
+
+/* Glyph names of recently serialized glyphs, for the duration of one
+ * call; runs repeat the same few glyphs a lot. */
+struct hb_serialize_names_t
+{
+  hb_serialize_names_t (hb_font_t *font_) : font (font_)
+  {
+    for (unsigned int i = 0; i < ARRAY_LENGTH (slots); i++)
+      slots[i].glyph = (hb_codepoint_t) -1;
+  }
+
+  /* Writes the name of glyph to p, which must have room for 128 bytes. */
+  char *put (char *p, hb_codepoint_t glyph)
+  {
+    slot_t &slot = slots[glyph % ARRAY_LENGTH (slots)];
+    if (slot.glyph != glyph)
+    {
+      hb_font_glyph_to_string (font, glyph, p, 128);
+      unsigned int len = strlen (p);
+      if (len < sizeof (slot.name))
+      {
+	slot.glyph = glyph;
+	slot.len = len;
+	memcpy (slot.name, p, len);
+      }
+      return p + len;
+    }
+    memcpy (p, slot.name, slot.len);
+    return p + slot.len;
+  }
+
+  private:
+  struct slot_t
+  {
+    hb_codepoint_t glyph;
+    unsigned int len;
+    char name[56];
+  };
+
+  hb_font_t *font;
+  slot_t slots[16];
+};
+
 static unsigned int
 _hb_buffer_serialize_glyphs_json (hb_buffer_t *buffer,
 				  unsigned int start,
@@ -108,6 +196,8 @@ _hb_buffer_serialize_glyphs_json (hb_buffer_t *buffer,
   hb_glyph_position_t *pos = (flags & HB_BUFFER_SERIALIZE_FLAG_NO_POSITIONS) ?
 			     nullptr : hb_buffer_get_glyph_positions (buffer, nullptr);
 
+  hb_serialize_names_t names (font);
+
   *buf_consumed = 0;
   hb_position_t x = 0, y = 0;
   for (unsigned int i = start; i < end; i++)
@@ -128,7 +218,7 @@ _hb_buffer_serialize_glyphs_json (hb_buffer_t *buffer,
     if (!(flags & HB_BUFFER_SERIALIZE_FLAG_NO_GLYPH_NAMES))
     {
       char g[128];
-      hb_font_glyph_to_string (font, info[i].codepoint, g, sizeof (g));
+      *names.put (g, info[i].codepoint) = '\0';
       *p++ = '"';
       for (char *q = g; *q; q++) {
         if (*q == '"')
@@ -138,35 +228,49 @@ _hb_buffer_serialize_glyphs_json (hb_buffer_t *buffer,
       *p++ = '"';
     }
     else
-      p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), "%u", info[i].codepoint));
+      p = _hb_serialize_uint (p, info[i].codepoint);
 
     if (!(flags & HB_BUFFER_SERIALIZE_FLAG_NO_CLUSTERS)) {
-      p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), ",\"cl\":%u", info[i].cluster));
+      APPEND (",\"cl\":");
+      p = _hb_serialize_uint (p, info[i].cluster);
     }
 
     if (!(flags & HB_BUFFER_SERIALIZE_FLAG_NO_POSITIONS))
     {
-      p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), ",\"dx\":%d,\"dy\":%d",
-			     x+pos[i].x_offset, y+pos[i].y_offset));
+      APPEND (",\"dx\":");
+      p = _hb_serialize_int (p, x+pos[i].x_offset);
+      APPEND (",\"dy\":");
+      p = _hb_serialize_int (p, y+pos[i].y_offset);
       if (!(flags & HB_BUFFER_SERIALIZE_FLAG_NO_ADVANCES))
-	p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), ",\"ax\":%d,\"ay\":%d",
-			       pos[i].x_advance, pos[i].y_advance));
+      {
+	APPEND (",\"ax\":");
+	p = _hb_serialize_int (p, pos[i].x_advance);
+	APPEND (",\"ay\":");
+	p = _hb_serialize_int (p, pos[i].y_advance);
+      }
     }
 
     if (flags & HB_BUFFER_SERIALIZE_FLAG_GLYPH_FLAGS)
     {
       if (info[i].mask & HB_GLYPH_FLAG_DEFINED)
-	p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), ",\"fl\":%u", info[i].mask & HB_GLYPH_FLAG_DEFINED));
+      {
+	APPEND (",\"fl\":");
+	p = _hb_serialize_uint (p, info[i].mask & HB_GLYPH_FLAG_DEFINED);
+      }
     }
 
     if (flags & HB_BUFFER_SERIALIZE_FLAG_GLYPH_EXTENTS)
     {
       hb_glyph_extents_t extents;
       hb_font_get_glyph_extents(font, info[i].codepoint, &extents);
-      p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), ",\"xb\":%d,\"yb\":%d",
-		extents.x_bearing, extents.y_bearing));
-      p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), ",\"w\":%d,\"h\":%d",
-		extents.width, extents.height));
+      APPEND (",\"xb\":");
+      p = _hb_serialize_int (p, extents.x_bearing);
+      APPEND (",\"yb\":");
+      p = _hb_serialize_int (p, extents.y_bearing);
+      APPEND (",\"w\":");
+      p = _hb_serialize_int (p, extents.width);
+      APPEND (",\"h\":");
+      p = _hb_serialize_int (p, extents.height);
     }
 
     *p++ = '}';
@@ -206,6 +310,8 @@ _hb_buffer_serialize_glyphs_text (hb_buffer_t *buffer,
   hb_glyph_position_t *pos = (flags & HB_BUFFER_SERIALIZE_FLAG_NO_POSITIONS) ?
 			     nullptr : hb_buffer_get_glyph_positions (buffer, nullptr);
 
+  hb_serialize_names_t names (font);
+
   *buf_consumed = 0;
   hb_position_t x = 0, y = 0;
   for (unsigned int i = start; i < end; i++)
@@ -219,42 +325,59 @@ _hb_buffer_serialize_glyphs_text (hb_buffer_t *buffer,
       *p++ = '|';
 
     if (!(flags & HB_BUFFER_SERIALIZE_FLAG_NO_GLYPH_NAMES))
-    {
-      hb_font_glyph_to_string (font, info[i].codepoint, p, 128);
-      p += strlen (p);
-    }
+      p = names.put (p, info[i].codepoint);
     else
-      p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), "%u", info[i].codepoint));
+      p = _hb_serialize_uint (p, info[i].codepoint);
 
     if (!(flags & HB_BUFFER_SERIALIZE_FLAG_NO_CLUSTERS)) {
-      p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), "=%u", info[i].cluster));
+      *p++ = '=';
+      p = _hb_serialize_uint (p, info[i].cluster);
     }
 
     if (!(flags & HB_BUFFER_SERIALIZE_FLAG_NO_POSITIONS))
     {
       if (x+pos[i].x_offset || y+pos[i].y_offset)
-	p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), "@%d,%d", x+pos[i].x_offset, y+pos[i].y_offset));
+      {
+	*p++ = '@';
+	p = _hb_serialize_int (p, x+pos[i].x_offset);
+	*p++ = ',';
+	p = _hb_serialize_int (p, y+pos[i].y_offset);
+      }
 
       if (!(flags & HB_BUFFER_SERIALIZE_FLAG_NO_ADVANCES))
       {
 	*p++ = '+';
-	p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), "%d", pos[i].x_advance));
+	p = _hb_serialize_int (p, pos[i].x_advance);
 	if (pos[i].y_advance)
-	  p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), ",%d", pos[i].y_advance));
+	{
+	  *p++ = ',';
+	  p = _hb_serialize_int (p, pos[i].y_advance);
+	}
       }
     }
 
     if (flags & HB_BUFFER_SERIALIZE_FLAG_GLYPH_FLAGS)
     {
       if (info[i].mask & HB_GLYPH_FLAG_DEFINED)
-	p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), "#%X", info[i].mask &HB_GLYPH_FLAG_DEFINED));
+      {
+	*p++ = '#';
+	p = _hb_serialize_hex (p, info[i].mask &HB_GLYPH_FLAG_DEFINED);
+      }
     }
 
     if (flags & HB_BUFFER_SERIALIZE_FLAG_GLYPH_EXTENTS)
     {
       hb_glyph_extents_t extents;
       hb_font_get_glyph_extents(font, info[i].codepoint, &extents);
-      p += hb_max (0, snprintf (p, ARRAY_LENGTH (b) - (p - b), "<%d,%d,%d,%d>", extents.x_bearing, extents.y_bearing, extents.width, extents.height));
+      *p++ = '<';
+      p = _hb_serialize_int (p, extents.x_bearing);
+      *p++ = ',';
+      p = _hb_serialize_int (p, extents.y_bearing);
+      *p++ = ',';
+      p = _hb_serialize_int (p, extents.width);
+      *p++ = ',';
+      p = _hb_serialize_int (p, extents.height);
+      *p++ = '>';
     }
 
     unsigned int l = p - b;
@@ -278,6 +401,149 @@ _hb_buffer_serialize_glyphs_text (hb_buffer_t *buffer,
   return end - start;
 }
 
+/* The binary format.  Each hb_buffer_serialize_glyphs() call writes a
+ * chunk: the byte 'B', a byte of the HB_BUFFER_SERIALIZE_BINARY_* bits
+ * below, and the number of glyphs in the chunk as a 32-bit little-endian
+ * integer.  The glyphs follow, each as a run of variable-length integers
+ * (seven bits per byte, low bits first, high bit set on all but the last
+ * byte); signed values are zigzag-encoded.  Glyph indices and clusters are
+ * stored as differences from the previous glyph's in the chunk. */
+
+enum {
+  HB_BUFFER_SERIALIZE_BINARY_CLUSTERS	= 0x01u,
+  HB_BUFFER_SERIALIZE_BINARY_POSITIONS	= 0x02u,
+  HB_BUFFER_SERIALIZE_BINARY_ADVANCES	= 0x04u,
+  HB_BUFFER_SERIALIZE_BINARY_FLAGS	= 0x08u,
+  HB_BUFFER_SERIALIZE_BINARY_EXTENTS	= 0x10u,
+};
+#define HB_BUFFER_SERIALIZE_BINARY_HEADER_SIZE 6
+
+static unsigned char *
+_hb_binary_put_uint (unsigned char *p, uint32_t v)
+{
+  while (v >= 0x80u)
+  {
+    *p++ = v | 0x80u;
+    v >>= 7;
+  }
+  *p++ = v;
+  return p;
+}
+
+static unsigned char *
+_hb_binary_put_int (unsigned char *p, int32_t v)
+{
+  return _hb_binary_put_uint (p, ((uint32_t) v << 1) ^ (v < 0 ? 0xFFFFFFFFu : 0u));
+}
+
+static unsigned int
+_hb_buffer_serialize_glyphs_binary (hb_buffer_t *buffer,
+				    unsigned int start,
+				    unsigned int end,
+				    char *buf,
+				    unsigned int buf_size,
+				    unsigned int *buf_consumed,
+				    hb_font_t *font,
+				    hb_buffer_serialize_flags_t flags)
+{
+  hb_glyph_info_t *info = hb_buffer_get_glyph_infos (buffer, nullptr);
+  hb_glyph_position_t *pos = (flags & HB_BUFFER_SERIALIZE_FLAG_NO_POSITIONS) ?
+			     nullptr : hb_buffer_get_glyph_positions (buffer, nullptr);
+
+  unsigned int fields = 0;
+  if (!(flags & HB_BUFFER_SERIALIZE_FLAG_NO_CLUSTERS))
+    fields |= HB_BUFFER_SERIALIZE_BINARY_CLUSTERS;
+  if (pos)
+  {
+    fields |= HB_BUFFER_SERIALIZE_BINARY_POSITIONS;
+    if (!(flags & HB_BUFFER_SERIALIZE_FLAG_NO_ADVANCES))
+      fields |= HB_BUFFER_SERIALIZE_BINARY_ADVANCES;
+  }
+  if (flags & HB_BUFFER_SERIALIZE_FLAG_GLYPH_FLAGS)
+    fields |= HB_BUFFER_SERIALIZE_BINARY_FLAGS;
+  if (flags & HB_BUFFER_SERIALIZE_FLAG_GLYPH_EXTENTS)
+    fields |= HB_BUFFER_SERIALIZE_BINARY_EXTENTS;
+
+  *buf_consumed = 0;
+  if (buf_size <= HB_BUFFER_SERIALIZE_BINARY_HEADER_SIZE)
+    return 0;
+  unsigned char *header = (unsigned char *) buf;
+  buf += HB_BUFFER_SERIALIZE_BINARY_HEADER_SIZE;
+  buf_size -= HB_BUFFER_SERIALIZE_BINARY_HEADER_SIZE;
+
+  hb_codepoint_t last_glyph = 0, last_cluster = 0;
+  hb_position_t x = 0, y = 0;
+  unsigned int i;
+  for (i = start; i < end; i++)
+  {
+    unsigned char b[64];
+    unsigned char *p = b;
+
+    /* Eleven fields of at most five bytes each fit b. */
+
+    p = _hb_binary_put_int (p, (int32_t) (info[i].codepoint - last_glyph));
+    if (fields & HB_BUFFER_SERIALIZE_BINARY_CLUSTERS)
+      p = _hb_binary_put_int (p, (int32_t) (info[i].cluster - last_cluster));
+    if (fields & HB_BUFFER_SERIALIZE_BINARY_POSITIONS)
+    {
+      p = _hb_binary_put_int (p, x + pos[i].x_offset);
+      p = _hb_binary_put_int (p, y + pos[i].y_offset);
+    }
+    if (fields & HB_BUFFER_SERIALIZE_BINARY_ADVANCES)
+    {
+      p = _hb_binary_put_int (p, pos[i].x_advance);
+      p = _hb_binary_put_int (p, pos[i].y_advance);
+    }
+    if (fields & HB_BUFFER_SERIALIZE_BINARY_FLAGS)
+      p = _hb_binary_put_uint (p, info[i].mask & HB_GLYPH_FLAG_DEFINED);
+    if (fields & HB_BUFFER_SERIALIZE_BINARY_EXTENTS)
+    {
+      hb_glyph_extents_t extents;
+      hb_font_get_glyph_extents(font, info[i].codepoint, &extents);
+      p = _hb_binary_put_int (p, extents.x_bearing);
+      p = _hb_binary_put_int (p, extents.y_bearing);
+      p = _hb_binary_put_int (p, extents.width);
+      p = _hb_binary_put_int (p, extents.height);
+    }
+
+    unsigned int l = p - b;
+    if (buf_size > l)
+    {
+      memcpy (buf, b, l);
+      buf += l;
+      buf_size -= l;
+      *buf_consumed += l;
+      *buf = '\0';
+    } else
+      break;
+
+    last_glyph = info[i].codepoint;
+    last_cluster = info[i].cluster;
+    if (pos && (flags & HB_BUFFER_SERIALIZE_FLAG_NO_ADVANCES))
+    {
+      x += pos[i].x_advance;
+      y += pos[i].y_advance;
+    }
+  }
+
+  unsigned int count = i - start;
+  if (!count)
+  {
+    *header = '\0';
+    return 0;
+  }
+
+  header[0] = 'B';
+  header[1] = fields;
+  header[2] = count;
+  header[3] = count >> 8;
+  header[4] = count >> 16;
+  header[5] = count >> 24;
+  *buf_consumed += HB_BUFFER_SERIALIZE_BINARY_HEADER_SIZE;
+
+  return count;
+}
+
 /**
  * hb_buffer_serialize_glyphs:
  * @buffer: an #hb_buffer_t buffer.
@@ -319,6 +585,14 @@ _hb_buffer_serialize_glyphs_text (hb_buffer_t *buffer,
  * ## json
  * TODO.
  *
+ * ## binary
+ * A compact format for passing shaping results between processes, with
+ * glyph indices and clusters delta-encoded into variable-length integers.
+ * Glyph indices are always written, never names.  Each call writes one
+ * self-contained chunk; chunks can be concatenated and handed to
+ * hb_buffer_deserialize_glyphs() together.  The output may contain nul
+ * bytes, so use @buf_consumed for its length.
+ *
  * Return value:
  * The number of serialized items.
  *
@@ -368,6 +642,11 @@ hb_buffer_serialize_glyphs (hb_buffer_t *buffer,
 					       buf, buf_size, buf_consumed,
 					       font, flags);
 
+    case HB_BUFFER_SERIALIZE_FORMAT_BINARY:
+      return _hb_buffer_serialize_glyphs_binary (buffer, start, end,
+						 buf, buf_size, buf_consumed,
+						 font, flags);
+
     default:
     case HB_BUFFER_SERIALIZE_FORMAT_INVALID:
       return 0;
@@ -376,6 +655,56 @@ hb_buffer_serialize_glyphs (hb_buffer_t *buffer,
 }
 
 
+/**
+ * hb_buffer_serialize_glyphs_write:
+ * @buffer: an #hb_buffer_t buffer.
+ * @start: the first item in @buffer to serialize.
+ * @end: the last item in @buffer to serialize.
+ * @font: (allow-none): the #hb_font_t used to shape this buffer, needed to
+ *        read glyph names and extents. If %NULL, and empty font will be used.
+ * @format: the #hb_buffer_serialize_format_t to use for formatting the output.
+ * @flags: the #hb_buffer_serialize_flags_t that control what glyph properties
+ *         to serialize.
+ * @func: (scope call): function to receive the serialized bytes.
+ * @user_data: data passed to @func.
+ *
+ * Serializes the items from @start to @end of @buffer like
+ * hb_buffer_serialize_glyphs() does, handing the output to @func in pieces
+ * as it goes, so that callers don't need to size an output buffer and
+ * call again for the rest.
+ *
+ * Return value: %true if all the items were serialized and @func
+ * succeeded every time.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_buffer_serialize_glyphs_write (hb_buffer_t *buffer,
+				  unsigned int start,
+				  unsigned int end,
+				  hb_font_t *font,
+				  hb_buffer_serialize_format_t format,
+				  hb_buffer_serialize_flags_t flags,
+				  hb_buffer_serialize_write_func_t func,
+				  void *user_data)
+{
+  /* Holds several items of any format; each hb_buffer_serialize_glyphs()
+   * call fills it as far as whole items go. */
+  char buf[4096];
+  while (start < end)
+  {
+    unsigned int consumed;
+    unsigned int n = hb_buffer_serialize_glyphs (buffer, start, end,
+						 buf, sizeof (buf), &consumed,
+						 font, format, flags);
+    if (unlikely (!n) || !func (buf, consumed, user_data))
+      return false;
+    start += n;
+  }
+  return true;
+}
+
+
 static hb_bool_t
 parse_uint (const char *pp, const char *end, uint32_t *pv)
 {
@@ -421,6 +750,108 @@ parse_int (const char *pp, const char *end, int32_t *pv)
 #include "hb-buffer-deserialize-json.hh"
 #include "hb-buffer-deserialize-text.hh"
 
+static bool
+_hb_binary_get_uint (const unsigned char **pp, const unsigned char *end, uint32_t *pv)
+{
+  const unsigned char *p = *pp;
+  uint32_t v = 0;
+  for (unsigned int shift = 0; shift < 35; shift += 7)
+  {
+    if (unlikely (p == end))
+      return false;
+    unsigned int c = *p++;
+    v |= (uint32_t) (c & 0x7Fu) << shift;
+    if (!(c & 0x80u))
+    {
+      *pp = p;
+      *pv = v;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool
+_hb_binary_get_int (const unsigned char **pp, const unsigned char *end, int32_t *pv)
+{
+  uint32_t v;
+  if (unlikely (!_hb_binary_get_uint (pp, end, &v)))
+    return false;
+  *pv = (int32_t) ((v >> 1) ^ (0u - (v & 1u)));
+  return true;
+}
+
+static hb_bool_t
+_hb_buffer_deserialize_glyphs_binary (hb_buffer_t *buffer,
+				      const char *buf,
+				      unsigned int buf_len,
+				      const char **end_ptr,
+				      hb_font_t *font HB_UNUSED)
+{
+  const unsigned char *p = (const unsigned char *) buf, *pe = p + buf_len;
+
+  /* Ensure we have positions. */
+  (void) hb_buffer_get_glyph_positions (buffer, nullptr);
+
+  while (p < pe)
+  {
+    if (unlikely (pe - p < HB_BUFFER_SERIALIZE_BINARY_HEADER_SIZE || p[0] != 'B'))
+      return false;
+    unsigned int fields = p[1];
+    unsigned int count = p[2] | (p[3] << 8) | (p[4] << 16) | ((unsigned int) p[5] << 24);
+    p += HB_BUFFER_SERIALIZE_BINARY_HEADER_SIZE;
+
+    /* Every glyph takes at least a byte. */
+    if (unlikely (count > (unsigned int) (pe - p) ||
+		  !buffer->ensure (buffer->len + count)))
+      return false;
+
+    hb_codepoint_t glyph = 0, cluster = 0;
+    for (unsigned int n = 0; n < count; n++)
+    {
+      hb_glyph_info_t info = {0};
+      hb_glyph_position_t pos = {0};
+      int32_t v;
+      uint32_t u;
+
+      if (!_hb_binary_get_int (&p, pe, &v)) return false;
+      info.codepoint = glyph += v;
+      if (fields & HB_BUFFER_SERIALIZE_BINARY_CLUSTERS)
+      {
+	if (!_hb_binary_get_int (&p, pe, &v)) return false;
+	cluster += v;
+      }
+      info.cluster = cluster;
+      if (fields & HB_BUFFER_SERIALIZE_BINARY_POSITIONS)
+      {
+	if (!_hb_binary_get_int (&p, pe, &pos.x_offset)) return false;
+	if (!_hb_binary_get_int (&p, pe, &pos.y_offset)) return false;
+      }
+      if (fields & HB_BUFFER_SERIALIZE_BINARY_ADVANCES)
+      {
+	if (!_hb_binary_get_int (&p, pe, &pos.x_advance)) return false;
+	if (!_hb_binary_get_int (&p, pe, &pos.y_advance)) return false;
+      }
+      if (fields & HB_BUFFER_SERIALIZE_BINARY_FLAGS)
+      {
+	if (!_hb_binary_get_uint (&p, pe, &u)) return false;
+	info.mask = u & HB_GLYPH_FLAG_DEFINED;
+      }
+      if (fields & HB_BUFFER_SERIALIZE_BINARY_EXTENTS)
+	for (unsigned int j = 0; j < 4; j++)
+	  if (!_hb_binary_get_int (&p, pe, &v)) return false;
+
+      buffer->add_info (info);
+      if (unlikely (!buffer->successful))
+	return false;
+      buffer->pos[buffer->len - 1] = pos;
+      *end_ptr = (const char *) p;
+    }
+  }
+
+  return true;
+}
+
 /**
  * hb_buffer_deserialize_glyphs:
  * @buffer: an #hb_buffer_t buffer.
@@ -478,6 +909,11 @@ hb_buffer_deserialize_glyphs (hb_buffer_t *buffer,
 						 buf, buf_len, end_ptr,
 						 font);
 
+    case HB_BUFFER_SERIALIZE_FORMAT_BINARY:
+      return _hb_buffer_deserialize_glyphs_binary (buffer,
+						   buf, buf_len, end_ptr,
+						   font);
+
     default:
     case HB_BUFFER_SERIALIZE_FORMAT_INVALID:
       return false;
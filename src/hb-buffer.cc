@@ -28,8 +28,15 @@
  */
 
 #include "hb-buffer.hh"
+#include "hb-font.hh"
 #include "hb-utf.hh"
 
+#ifdef HAVE_CLOCK_GETTIME
+#include <time.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
 
 /**
  * SECTION: hb-buffer
@@ -112,6 +119,8 @@ hb_segment_properties_hash (const hb_segment_properties_t *p)
 bool
 hb_buffer_t::enlarge (unsigned int size)
 {
+  HB_ALLOC_STATS_SCOPE (BUFFER);
+
   if (unlikely (!successful))
     return false;
   if (unlikely (size > max_len))
@@ -135,8 +144,28 @@ hb_buffer_t::enlarge (unsigned int size)
   if (unlikely (hb_unsigned_mul_overflows (new_allocated, sizeof (info[0]))))
     goto done;
 
-  new_pos = (hb_glyph_position_t *) realloc (pos, new_allocated * sizeof (pos[0]));
-  new_info = (hb_glyph_info_t *) realloc (info, new_allocated * sizeof (info[0]));
+  if (unlikely (arrays_in_storage))
+  {
+    /* Outgrew the caller's storage; move to the heap. */
+    new_pos = (hb_glyph_position_t *) malloc (new_allocated * sizeof (pos[0]));
+    new_info = (hb_glyph_info_t *) malloc (new_allocated * sizeof (info[0]));
+    if (unlikely (!new_pos || !new_info))
+    {
+      free (new_pos);
+      free (new_info);
+      new_pos = nullptr;
+      new_info = nullptr;
+      goto done;
+    }
+    memcpy (new_pos, pos, allocated * sizeof (pos[0]));
+    memcpy (new_info, info, allocated * sizeof (info[0]));
+    arrays_in_storage = false;
+  }
+  else
+  {
+    new_pos = (hb_glyph_position_t *) realloc (pos, new_allocated * sizeof (pos[0]));
+    new_info = (hb_glyph_info_t *) realloc (info, new_allocated * sizeof (info[0]));
+  }
 
 done:
   if (unlikely (!new_pos || !new_info))
@@ -179,6 +208,18 @@ hb_buffer_t::shift_forward (unsigned int count)
   assert (have_output);
   if (unlikely (!ensure (len + count))) return false;
 
+  /* The space in info before idx is the gap between the input and the
+   * output.  Open it wider than asked for, so that further rewinds don't
+   * each move the rest of the buffer again.  The extra room is proportional
+   * to what we move, which keeps rewinding amortized linear, and comes out
+   * of the spare capacity we already have. */
+  unsigned int extra = hb_min (len - idx, allocated - (len + count) - 1);
+  if (len + count < max_len)
+    extra = hb_min (extra, max_len - (len + count));
+  else
+    extra = 0;
+  count += extra;
+
   memmove (info + idx + count, info + idx, (len - idx) * sizeof (info[0]));
   if (idx + count > len)
   {
@@ -225,6 +266,7 @@ hb_buffer_t::reset ()
   flags = HB_BUFFER_FLAG_DEFAULT;
   replacement = HB_BUFFER_REPLACEMENT_CODEPOINT_DEFAULT;
   invisible = 0;
+  max_ops_budget = 0;
 
   clear ();
 }
@@ -240,6 +282,7 @@ hb_buffer_t::clear ()
   scratch_flags = HB_BUFFER_SCRATCH_FLAG_DEFAULT;
 
   content_type = HB_BUFFER_CONTENT_TYPE_INVALID;
+  max_ops_exhausted = false;
   successful = true;
   have_output = false;
   have_positions = false;
@@ -410,9 +453,9 @@ hb_buffer_t::move_to (unsigned int i)
      *
      * We used to shift with extra 32 items, instead of the 0 below.
      * But that would leave empty slots in the buffer in case of allocation
-     * failures.  Setting to zero for now to avoid other problems (see
-     * comments in shift_forward().  This can cause O(N^2) behavior more
-     * severely than adding 32 empty slots can... */
+     * failures.  shift_forward() now opens a gap out of spare capacity,
+     * which only ever fills it with stale copies of the input, so that
+     * repeated rewinds don't go O(N^2). */
     if (unlikely (idx < count && !shift_forward (count + 0))) return false;
 
     assert (idx >= count);
@@ -526,18 +569,27 @@ hb_buffer_t::merge_clusters_impl (unsigned int start,
   for (unsigned int i = start + 1; i < end; i++)
     cluster = hb_min (cluster, info[i].cluster);
 
-  /* Extend end */
-  while (end < len && info[end - 1].cluster == info[end].cluster)
-    end++;
+  /* Neighbors sharing an edge glyph's cluster only need rewriting if that
+   * cluster changes.  Repeatedly merging glyphs into one long cluster, as
+   * happens with long runs of marks, would otherwise rescan the whole
+   * cluster every time and go quadratic. */
 
-  /* Extend start */
-  while (idx < start && info[start - 1].cluster == info[start].cluster)
-    start--;
+  /* Extend end */
+  if (info[end - 1].cluster != cluster)
+    while (end < len && info[end - 1].cluster == info[end].cluster)
+      end++;
 
-  /* If we hit the start of buffer, continue in out-buffer. */
-  if (idx == start)
-    for (unsigned int i = out_len; i && out_info[i - 1].cluster == info[start].cluster; i--)
-      set_cluster (out_info[i - 1], cluster);
+  if (info[start].cluster != cluster)
+  {
+    /* Extend start */
+    while (idx < start && info[start - 1].cluster == info[start].cluster)
+      start--;
+
+    /* If we hit the start of buffer, continue in out-buffer. */
+    if (idx == start)
+      for (unsigned int i = out_len; i && out_info[i - 1].cluster == info[start].cluster; i--)
+	set_cluster (out_info[i - 1], cluster);
+  }
 
   for (unsigned int i = start; i < end; i++)
     set_cluster (info[i], cluster);
@@ -557,18 +609,25 @@ hb_buffer_t::merge_out_clusters (unsigned int start,
   for (unsigned int i = start + 1; i < end; i++)
     cluster = hb_min (cluster, out_info[i].cluster);
 
-  /* Extend start */
-  while (start && out_info[start - 1].cluster == out_info[start].cluster)
-    start--;
+  /* As in merge_clusters_impl(), only extend over neighbors whose
+   * cluster changes. */
 
-  /* Extend end */
-  while (end < out_len && out_info[end - 1].cluster == out_info[end].cluster)
-    end++;
+  /* Extend start */
+  if (out_info[start].cluster != cluster)
+    while (start && out_info[start - 1].cluster == out_info[start].cluster)
+      start--;
 
-  /* If we hit the end of out-buffer, continue in buffer. */
-  if (end == out_len)
-    for (unsigned int i = idx; i < len && info[i].cluster == out_info[end - 1].cluster; i++)
-      set_cluster (info[i], cluster);
+  if (out_info[end - 1].cluster != cluster)
+  {
+    /* Extend end */
+    while (end < out_len && out_info[end - 1].cluster == out_info[end].cluster)
+      end++;
+
+    /* If we hit the end of out-buffer, continue in buffer. */
+    if (end == out_len)
+      for (unsigned int i = idx; i < len && info[i].cluster == out_info[end - 1].cluster; i++)
+	set_cluster (info[i], cluster);
+  }
 
   for (unsigned int i = start; i < end; i++)
     set_cluster (out_info[i], cluster);
@@ -610,29 +669,31 @@ done:
 }
 
 void
-hb_buffer_t::unsafe_to_break_impl (unsigned int start, unsigned int end)
+hb_buffer_t::set_glyph_flags (hb_mask_t mask, unsigned int start, unsigned int end)
 {
+  end = hb_min (end, len);
   unsigned int cluster = (unsigned int) -1;
   cluster = _unsafe_to_break_find_min_cluster (info, start, end, cluster);
-  _unsafe_to_break_set_mask (info, start, end, cluster);
+  _unsafe_to_break_set_mask (info, start, end, cluster, mask);
 }
 void
-hb_buffer_t::unsafe_to_break_from_outbuffer (unsigned int start, unsigned int end)
+hb_buffer_t::set_glyph_flags_from_outbuffer (hb_mask_t mask, unsigned int start, unsigned int end)
 {
   if (!have_output)
   {
-    unsafe_to_break_impl (start, end);
+    set_glyph_flags (mask, start, end);
     return;
   }
 
+  end = hb_min (end, len);
   assert (start <= out_len);
   assert (idx <= end);
 
   unsigned int cluster = (unsigned int) -1;
   cluster = _unsafe_to_break_find_min_cluster (out_info, start, out_len, cluster);
   cluster = _unsafe_to_break_find_min_cluster (info, idx, end, cluster);
-  _unsafe_to_break_set_mask (out_info, start, out_len, cluster);
-  _unsafe_to_break_set_mask (info, idx, end, cluster);
+  _unsafe_to_break_set_mask (out_info, start, out_len, cluster, mask);
+  _unsafe_to_break_set_mask (info, idx, end, cluster, mask);
 }
 
 void
@@ -643,13 +704,20 @@ hb_buffer_t::guess_segment_properties ()
 
   /* If script is set to INVALID, guess from buffer contents */
   if (props.script == HB_SCRIPT_INVALID) {
-    for (unsigned int i = 0; i < len; i++) {
-      hb_script_t script = unicode->script (info[i].codepoint);
-      if (likely (script != HB_SCRIPT_COMMON &&
-		  script != HB_SCRIPT_INHERITED &&
-		  script != HB_SCRIPT_UNKNOWN)) {
-        props.script = script;
-        break;
+    /* Small batches; the first character usually decides. */
+    hb_script_t scripts[8];
+    for (unsigned int start = 0; start < len && props.script == HB_SCRIPT_INVALID; start += ARRAY_LENGTH (scripts)) {
+      unsigned int count = hb_min (len - start, ARRAY_LENGTH (scripts));
+      unicode->script_batch (count, &info[start].codepoint, sizeof (info[0]),
+			     scripts, sizeof (scripts[0]));
+      for (unsigned int i = 0; i < count; i++) {
+	hb_script_t script = scripts[i];
+	if (likely (script != HB_SCRIPT_COMMON &&
+		    script != HB_SCRIPT_INHERITED &&
+		    script != HB_SCRIPT_UNKNOWN)) {
+	  props.script = script;
+	  break;
+	}
       }
     }
   }
@@ -683,6 +751,8 @@ DEFINE_NULL_INSTANCE (hb_buffer_t) =
   HB_BUFFER_SCRATCH_FLAG_DEFAULT,
   HB_BUFFER_MAX_LEN_DEFAULT,
   HB_BUFFER_MAX_OPS_DEFAULT,
+  0, /* max_ops_budget */
+  false, /* max_ops_exhausted */
 
   HB_BUFFER_CONTENT_TYPE_INVALID,
   HB_SEGMENT_PROPERTIES_DEFAULT,
@@ -711,6 +781,8 @@ DEFINE_NULL_INSTANCE (hb_buffer_t) =
 hb_buffer_t *
 hb_buffer_create ()
 {
+  HB_ALLOC_STATS_SCOPE (BUFFER);
+
   hb_buffer_t *buffer;
 
   if (!(buffer = hb_object_create<hb_buffer_t> ()))
@@ -724,6 +796,58 @@ hb_buffer_create ()
   return buffer;
 }
 
+/**
+ * hb_buffer_create_with_storage:
+ * @storage: memory to place the buffer in.
+ * @storage_size: size of @storage in bytes.
+ *
+ * Creates a new #hb_buffer_t like hb_buffer_create() does, but places
+ * the buffer object and its initial glyph arrays in @storage instead of
+ * allocating them.  This lets a caller reuse one block of memory for
+ * many short-lived buffers.  If the contents outgrow @storage, the glyph
+ * arrays are moved to the heap.
+ *
+ * @storage must be aligned like memory returned by malloc(), and must
+ * stay valid until the buffer is destroyed.  hb_buffer_destroy() does not
+ * free it.  If @storage_size is too small to hold the buffer object, the
+ * empty buffer is returned.
+ *
+ * Return value: (transfer full):
+ * A new #hb_buffer_t with a reference count of 1.
+ *
+ * Since: REPLACEME
+ **/
+hb_buffer_t *
+hb_buffer_create_with_storage (void         *storage,
+			       unsigned int  storage_size)
+{
+  unsigned int object_size = hb_ceil_to_4 (sizeof (hb_buffer_t));
+  if (unlikely (!storage || storage_size < object_size))
+    return hb_buffer_get_empty ();
+
+  hb_buffer_t *buffer = (hb_buffer_t *) storage;
+  memset (buffer, 0, sizeof (*buffer));
+  hb_object_init (buffer);
+  buffer->object_in_storage = true;
+
+  buffer->max_len = HB_BUFFER_MAX_LEN_DEFAULT;
+  buffer->max_ops = HB_BUFFER_MAX_OPS_DEFAULT;
+
+  static_assert ((sizeof (buffer->info[0]) == sizeof (buffer->pos[0])), "");
+  unsigned int count = (storage_size - object_size) / (2 * sizeof (buffer->info[0]));
+  if (count)
+  {
+    buffer->info = (hb_glyph_info_t *) ((char *) storage + object_size);
+    buffer->pos = (hb_glyph_position_t *) (buffer->info + count);
+    buffer->allocated = count;
+    buffer->arrays_in_storage = true;
+  }
+
+  buffer->reset ();
+
+  return buffer;
+}
+
 /**
  * hb_buffer_get_empty:
  *
@@ -774,12 +898,19 @@ hb_buffer_destroy (hb_buffer_t *buffer)
 
   hb_unicode_funcs_destroy (buffer->unicode);
 
-  free (buffer->info);
-  free (buffer->pos);
+  if (!buffer->arrays_in_storage)
+  {
+    free (buffer->info);
+    free (buffer->pos);
+  }
+  buffer->arena.fini ();
   if (buffer->message_destroy)
     buffer->message_destroy (buffer->message_data);
+  if (buffer->trace_destroy)
+    buffer->trace_destroy (buffer->trace_data);
 
-  free (buffer);
+  if (!buffer->object_in_storage)
+    free (buffer);
 }
 
 /**
@@ -1220,6 +1351,54 @@ hb_buffer_get_invisible_glyph (hb_buffer_t    *buffer)
   return buffer->invisible;
 }
 
+/**
+ * hb_buffer_set_max_ops:
+ * @buffer: an #hb_buffer_t.
+ * @max_ops: the operation budget for shaping @buffer, or zero.
+ *
+ * Limits how much work the next shaping calls may spend on @buffer,
+ * for services that have to bound the time a hostile font can take.
+ * The budget is counted in abstract operations: each GSUB or GPOS
+ * lookup applied costs the length of the buffer, each AAT subtable as
+ * much again, and nested lookups and repeated state machine steps one
+ * each.  Shaping a buffer of a few hundred characters with a typical
+ * font takes in the order of ten thousand operations.
+ *
+ * When the budget runs out, the remaining lookups are skipped and
+ * hb_shape_full() returns %false; the buffer still holds positioned
+ * glyphs, but they are not the correct shaping of the text.  Setting
+ * @max_ops to zero, the default, leaves only the built-in limits that
+ * HarfBuzz always applies.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_buffer_set_max_ops (hb_buffer_t    *buffer,
+		       unsigned int    max_ops)
+{
+  if (unlikely (hb_object_is_immutable (buffer)))
+    return;
+
+  buffer->max_ops_budget = max_ops;
+}
+
+/**
+ * hb_buffer_get_max_ops:
+ * @buffer: an #hb_buffer_t.
+ *
+ * See hb_buffer_set_max_ops().
+ *
+ * Return value:
+ * The operation budget of @buffer, or zero if it has none.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_buffer_get_max_ops (hb_buffer_t    *buffer)
+{
+  return buffer->max_ops_budget;
+}
+
 
 /**
  * hb_buffer_reset:
@@ -1423,6 +1602,116 @@ hb_buffer_get_glyph_positions (hb_buffer_t  *buffer,
   return (hb_glyph_position_t *) buffer->pos;
 }
 
+/**
+ * hb_buffer_get_glyphs:
+ * @buffer: an #hb_buffer_t.
+ * @start_offset: index of the first glyph to retrieve.
+ * @count: (inout) (optional): input length of the output arrays;
+ *         output number of glyphs written to them.
+ * @glyphs: (out) (array length=count) (optional): glyph ids.
+ * @clusters: (out) (array length=count) (optional): glyph clusters.
+ * @x_advances: (out) (array length=count) (optional): horizontal advances.
+ * @y_advances: (out) (array length=count) (optional): vertical advances.
+ * @x_offsets: (out) (array length=count) (optional): horizontal offsets.
+ * @y_offsets: (out) (array length=count) (optional): vertical offsets.
+ *
+ * Copies the glyphs of @buffer, starting at @start_offset, into separate
+ * caller-owned arrays, one per field, in a single pass.  Any of the arrays
+ * may be %NULL, in which case that field is skipped.  Unlike
+ * hb_buffer_get_glyph_infos() and hb_buffer_get_glyph_positions(), the
+ * output stays valid after @buffer is modified or reused.
+ *
+ * If the buffer has no positions, the position fields are written as zero.
+ *
+ * Return value:
+ * The @buffer length.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_buffer_get_glyphs (hb_buffer_t    *buffer,
+		      unsigned int    start_offset,
+		      unsigned int   *count, /* IN/OUT */
+		      hb_codepoint_t *glyphs, /* OUT */
+		      uint32_t       *clusters, /* OUT */
+		      hb_position_t  *x_advances, /* OUT */
+		      hb_position_t  *y_advances, /* OUT */
+		      hb_position_t  *x_offsets, /* OUT */
+		      hb_position_t  *y_offsets /* OUT */)
+{
+  if (count)
+  {
+    if (!buffer->have_positions)
+      buffer->clear_positions ();
+
+    unsigned int len = buffer->len;
+    unsigned int n = start_offset < len ? hb_min (*count, len - start_offset) : 0;
+    *count = n;
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+      const hb_glyph_info_t &info = buffer->info[start_offset + i];
+      const hb_glyph_position_t &pos = buffer->pos[start_offset + i];
+      if (glyphs)     glyphs[i]     = info.codepoint;
+      if (clusters)   clusters[i]   = info.cluster;
+      if (x_advances) x_advances[i] = pos.x_advance;
+      if (y_advances) y_advances[i] = pos.y_advance;
+      if (x_offsets)  x_offsets[i]  = pos.x_offset;
+      if (y_offsets)  y_offsets[i]  = pos.y_offset;
+    }
+  }
+
+  return buffer->len;
+}
+
+/**
+ * hb_buffer_get_compact_glyphs:
+ * @buffer: an #hb_buffer_t.
+ * @start_offset: index of the first glyph to retrieve.
+ * @count: (inout) (optional): input length of @glyphs;
+ *         output number of glyphs written to it.
+ * @glyphs: (out) (array length=count) (optional): the compact glyphs.
+ *
+ * Packs the glyphs of @buffer, starting at @start_offset, into @glyphs as
+ * #hb_glyph_compact_t: glyph index, cluster and the advance along the
+ * buffer direction, in 12 bytes per glyph instead of the 40 bytes of an
+ * #hb_glyph_info_t and #hb_glyph_position_t pair.  Fetching the output of
+ * a large buffer in windows bounds the extra memory needed to compact it.
+ *
+ * Return value:
+ * The @buffer length.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_buffer_get_compact_glyphs (hb_buffer_t        *buffer,
+			      unsigned int        start_offset,
+			      unsigned int       *count, /* IN/OUT */
+			      hb_glyph_compact_t *glyphs /* OUT */)
+{
+  if (count)
+  {
+    if (!buffer->have_positions)
+      buffer->clear_positions ();
+
+    unsigned int len = buffer->len;
+    unsigned int n = start_offset < len ? hb_min (*count, len - start_offset) : 0;
+    *count = n;
+
+    bool vertical = HB_DIRECTION_IS_VERTICAL (buffer->props.direction);
+    for (unsigned int i = 0; i < n; i++)
+    {
+      const hb_glyph_info_t &info = buffer->info[start_offset + i];
+      const hb_glyph_position_t &pos = buffer->pos[start_offset + i];
+      glyphs[i].glyph = info.codepoint;
+      glyphs[i].cluster = info.cluster;
+      glyphs[i].advance = vertical ? pos.y_advance : pos.x_advance;
+    }
+  }
+
+  return buffer->len;
+}
+
 /**
  * hb_glyph_info_get_glyph_flags:
  * @info: a #hb_glyph_info_t.
@@ -1521,6 +1810,38 @@ hb_buffer_guess_segment_properties (hb_buffer_t *buffer)
   buffer->guess_segment_properties ();
 }
 
+/* Appends count characters that are each a single code unit, filling the
+ * info array directly instead of going through add() for each one.  The
+ * loop body is branch-free, so the compiler is free to vectorize it. */
+template <typename utf_t>
+static inline bool
+hb_buffer_add_units (hb_buffer_t  *buffer,
+		     const typename utf_t::codepoint_t *text,
+		     const typename utf_t::codepoint_t *next,
+		     unsigned int  count)
+{
+  if (unlikely (!buffer->ensure (buffer->len + count)))
+    return false;
+
+  const hb_codepoint_t replacement = buffer->replacement;
+  const typename utf_t::codepoint_t *end = next + count;
+  unsigned int cluster = next - text;
+  hb_glyph_info_t *info = buffer->info + buffer->len;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    hb_codepoint_t u;
+    if (sizeof (*next) == 1)
+      u = next[i]; /* ASCII. */
+    else
+      utf_t::next (next + i, end, &u, replacement);
+    memset (&info[i], 0, sizeof (info[i]));
+    info[i].codepoint = u;
+    info[i].cluster = cluster + i;
+  }
+  buffer->len += count;
+  return true;
+}
+
 template <typename utf_t>
 static inline void
 hb_buffer_add_utf (hb_buffer_t  *buffer,
@@ -1569,8 +1890,26 @@ hb_buffer_add_utf (hb_buffer_t  *buffer,
 
   const T *next = text + item_offset;
   const T *end = next + item_length;
+  /* UTF-32 is fixed-width. */
+  if (sizeof (T) == 4 && hb_buffer_add_units<utf_t> (buffer, text, next, end - next))
+    next = end;
   while (next < end)
   {
+    /* ASCII decodes to itself in both UTF-8 and Latin-1; copy runs of it in
+     * bulk and only decode the rest one character at a time. */
+    if (sizeof (T) == 1)
+    {
+      const T *ascii_end = (const T *) hb_utf8_t::ascii_end ((const uint8_t *) next,
+							     (const uint8_t *) end);
+      if (ascii_end > next &&
+	  hb_buffer_add_units<utf_t> (buffer, text, next, ascii_end - next))
+      {
+	next = ascii_end;
+	if (next == end)
+	  break;
+      }
+    }
+
     hb_codepoint_t u;
     const T *old_next = next;
     next = utf_t::next (next, end, &u, replacement);
@@ -1713,7 +2052,9 @@ hb_buffer_add_latin1 (hb_buffer_t   *buffer,
  * paragraph and specify the run start and length as @item_offset and
  * @item_length, respectively, to give HarfBuzz the full context to be able,
  * for example, to do cross-run Arabic shaping or properly handle combining
- * marks at stat of run.
+ * marks at stat of run.  Only a few characters of context either side of the
+ * run are copied, so this costs the same regardless of the paragraph size,
+ * as long as @text_length is given rather than -1.
  *
  * This function does not check the validity of @text, it is up to the caller
  * to ensure it contains a valid Unicode code points.
@@ -1872,6 +2213,42 @@ hb_buffer_normalize_glyphs (hb_buffer_t *buffer)
   normalize_glyphs_cluster (buffer, start, end, backward);
 }
 
+/**
+ * hb_buffer_scale_positions:
+ * @buffer: an #hb_buffer_t with glyph positions in font units.
+ * @font: the font to scale the positions to.
+ *
+ * Scales the glyph positions of @buffer from font units to the scale
+ * of @font.  This allows shaping once with a font at its default scale
+ * of the face's units per em, and no ppem, and then producing copies for
+ * many sizes with hb_buffer_append() and this function, instead of
+ * shaping again at each size.
+ *
+ * The result can be off by one from shaping at the target scale, which
+ * rounds every positioning value separately.  Device table adjustments for
+ * the target ppem are not applied; variation deltas are, as they were
+ * part of the shaped positions.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_buffer_scale_positions (hb_buffer_t *buffer,
+			   hb_font_t   *font)
+{
+  if (!buffer->have_positions || hb_object_is_immutable (buffer))
+    return;
+
+  unsigned int count = buffer->len;
+  hb_glyph_position_t *pos = buffer->pos;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    pos[i].x_advance = font->em_scale_position_x (pos[i].x_advance);
+    pos[i].y_advance = font->em_scale_position_y (pos[i].y_advance);
+    pos[i].x_offset  = font->em_scale_position_x (pos[i].x_offset);
+    pos[i].y_offset  = font->em_scale_position_y (pos[i].y_offset);
+  }
+}
+
 void
 hb_buffer_t::sort (unsigned int start, unsigned int end, int(*compar)(const hb_glyph_info_t *, const hb_glyph_info_t *))
 {
@@ -2030,3 +2407,65 @@ hb_buffer_t::message_impl (hb_font_t *font, const char *fmt, va_list ap)
   vsnprintf (buf, sizeof (buf),  fmt, ap);
   return (bool) this->message_func (this, font, buf, this->message_data);
 }
+
+/**
+ * hb_buffer_set_trace_func:
+ * @buffer: an #hb_buffer_t.
+ * @func: (closure user_data) (destroy destroy) (scope notified):
+ * @user_data:
+ * @destroy:
+ *
+ * Sets a function to receive an #hb_buffer_trace_event_t, with start and
+ * end timestamps, for each shape call, lookup and subtable applied to
+ * @buffer.  Events are reported when they end, so nested ones come
+ * before the event enclosing them.  Unlike hb_buffer_set_message_func(),
+ * @func cannot skip lookups.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_buffer_set_trace_func (hb_buffer_t *buffer,
+			  hb_buffer_trace_func_t func,
+			  void *user_data, hb_destroy_func_t destroy)
+{
+  if (unlikely (hb_object_is_immutable (buffer)))
+  {
+    if (destroy)
+      destroy (user_data);
+    return;
+  }
+
+  if (buffer->trace_destroy)
+    buffer->trace_destroy (buffer->trace_data);
+
+  if (func) {
+    buffer->trace_func = func;
+    buffer->trace_data = user_data;
+    buffer->trace_destroy = destroy;
+  } else {
+    buffer->trace_func = nullptr;
+    buffer->trace_data = nullptr;
+    buffer->trace_destroy = nullptr;
+  }
+}
+
+uint64_t
+_hb_trace_now ()
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  if (unlikely (clock_gettime (CLOCK_MONOTONIC, &ts)))
+    return 0;
+  return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+#elif defined(_WIN32)
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  if (unlikely (!frequency.QuadPart) && !QueryPerformanceFrequency (&frequency))
+    return 0;
+  QueryPerformanceCounter (&counter);
+  return (uint64_t) (counter.QuadPart / frequency.QuadPart) * 1000000000u +
+	 (uint64_t) (counter.QuadPart % frequency.QuadPart) * 1000000000u / frequency.QuadPart;
+#else
+  return 0;
+#endif
+}
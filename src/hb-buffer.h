@@ -89,14 +89,31 @@ typedef struct hb_glyph_info_t
  * 				   of each line after line-breaking, or limiting
  * 				   the reshaping to a small piece around the
  * 				   breaking point only.
+ * @HB_GLYPH_FLAG_UNSAFE_TO_CONCAT: Indicates that if input text is changed on
+ * 				   one side of the beginning of the cluster
+ * 				   this glyph is part of, then the shaping
+ * 				   results for the other side might change.
+ * 				   The absence of this flag alone does not
+ * 				   make concatenation safe: only two pieces
+ * 				   both clear of it where they meet can be
+ * 				   glued together without reshaping.  A line
+ * 				   breaker can use this to reshape only a
+ * 				   small piece around each break, even where
+ * 				   @HB_GLYPH_FLAG_UNSAFE_TO_BREAK is set or
+ * 				   hyphenation changes the text there.
+ * 				   @HB_GLYPH_FLAG_UNSAFE_TO_BREAK implies this
+ * 				   flag.  Only produced when the buffer has
+ * 				   @HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT
+ * 				   set.  Since: REPLACEME
  * @HB_GLYPH_FLAG_DEFINED: All the currently defined flags.
  *
  * Since: 1.5.0
  */
 typedef enum { /*< flags >*/
   HB_GLYPH_FLAG_UNSAFE_TO_BREAK		= 0x00000001,
+  HB_GLYPH_FLAG_UNSAFE_TO_CONCAT	= 0x00000002,
 
-  HB_GLYPH_FLAG_DEFINED			= 0x00000001 /* OR of all defined flags */
+  HB_GLYPH_FLAG_DEFINED			= 0x00000003 /* OR of all defined flags */
 } hb_glyph_flags_t;
 
 HB_EXTERN hb_glyph_flags_t
@@ -132,6 +149,26 @@ typedef struct hb_glyph_position_t {
   hb_var_int_t   var;
 } hb_glyph_position_t;
 
+/**
+ * hb_glyph_compact_t:
+ * @glyph: the glyph index.
+ * @cluster: the index of the character in the original text that corresponds
+ *           to this glyph, as in #hb_glyph_info_t.
+ * @advance: how much the line advances after drawing this glyph, along the
+ *           direction of the buffer.
+ *
+ * A dense, 12-byte form of a shaped glyph, for keeping large amounts of
+ * shaping output around when glyph offsets are not needed.  Filled by
+ * hb_buffer_get_compact_glyphs().
+ *
+ * Since: REPLACEME
+ */
+typedef struct hb_glyph_compact_t {
+  hb_codepoint_t glyph;
+  uint32_t       cluster;
+  hb_position_t  advance;
+} hb_glyph_compact_t;
+
 /**
  * hb_segment_properties_t:
  * @direction: the #hb_direction_t of the buffer, see hb_buffer_set_direction().
@@ -178,6 +215,10 @@ typedef struct hb_buffer_t hb_buffer_t;
 HB_EXTERN hb_buffer_t *
 hb_buffer_create (void);
 
+HB_EXTERN hb_buffer_t *
+hb_buffer_create_with_storage (void         *storage,
+			       unsigned int  storage_size);
+
 HB_EXTERN hb_buffer_t *
 hb_buffer_get_empty (void);
 
@@ -288,6 +329,11 @@ hb_buffer_guess_segment_properties (hb_buffer_t *buffer);
  *                      flag indicating that a dotted circle should
  *                      not be inserted in the rendering of incorrect
  *                      character sequences (such at <0905 093E>). Since: 2.4
+ * @HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT:
+ *                      flag indicating that the @HB_GLYPH_FLAG_UNSAFE_TO_CONCAT
+ *                      glyph flag should be produced by the shaper.  By
+ *                      default it will not be produced, since it incurs a
+ *                      cost.  Since: REPLACEME
  *
  * Since: 0.9.20
  */
@@ -297,7 +343,8 @@ typedef enum { /*< flags >*/
   HB_BUFFER_FLAG_EOT				= 0x00000002u, /* End-of-text */
   HB_BUFFER_FLAG_PRESERVE_DEFAULT_IGNORABLES	= 0x00000004u,
   HB_BUFFER_FLAG_REMOVE_DEFAULT_IGNORABLES	= 0x00000008u,
-  HB_BUFFER_FLAG_DO_NOT_INSERT_DOTTED_CIRCLE	= 0x00000010u
+  HB_BUFFER_FLAG_DO_NOT_INSERT_DOTTED_CIRCLE	= 0x00000010u,
+  HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT	= 0x00000020u
 } hb_buffer_flags_t;
 
 HB_EXTERN void
@@ -356,6 +403,13 @@ hb_buffer_set_invisible_glyph (hb_buffer_t    *buffer,
 HB_EXTERN hb_codepoint_t
 hb_buffer_get_invisible_glyph (hb_buffer_t    *buffer);
 
+HB_EXTERN void
+hb_buffer_set_max_ops (hb_buffer_t    *buffer,
+		       unsigned int    max_ops);
+
+HB_EXTERN unsigned int
+hb_buffer_get_max_ops (hb_buffer_t    *buffer);
+
 
 HB_EXTERN void
 hb_buffer_reset (hb_buffer_t *buffer);
@@ -447,10 +501,30 @@ HB_EXTERN hb_glyph_position_t *
 hb_buffer_get_glyph_positions (hb_buffer_t  *buffer,
                                unsigned int *length);
 
+HB_EXTERN unsigned int
+hb_buffer_get_glyphs (hb_buffer_t    *buffer,
+		      unsigned int    start_offset,
+		      unsigned int   *count, /* IN/OUT */
+		      hb_codepoint_t *glyphs, /* OUT */
+		      uint32_t       *clusters, /* OUT */
+		      hb_position_t  *x_advances, /* OUT */
+		      hb_position_t  *y_advances, /* OUT */
+		      hb_position_t  *x_offsets, /* OUT */
+		      hb_position_t  *y_offsets /* OUT */);
+
+HB_EXTERN unsigned int
+hb_buffer_get_compact_glyphs (hb_buffer_t        *buffer,
+			      unsigned int        start_offset,
+			      unsigned int       *count, /* IN/OUT */
+			      hb_glyph_compact_t *glyphs /* OUT */);
 
 HB_EXTERN void
 hb_buffer_normalize_glyphs (hb_buffer_t *buffer);
 
+HB_EXTERN void
+hb_buffer_scale_positions (hb_buffer_t *buffer,
+			   hb_font_t   *font);
+
 
 /*
  * Serialize
@@ -485,6 +559,8 @@ typedef enum { /*< flags >*/
  * hb_buffer_serialize_format_t:
  * @HB_BUFFER_SERIALIZE_FORMAT_TEXT: a human-readable, plain text format.
  * @HB_BUFFER_SERIALIZE_FORMAT_JSON: a machine-readable JSON format.
+ * @HB_BUFFER_SERIALIZE_FORMAT_BINARY: a compact binary format, for passing
+ *   shaping results between processes. Since: REPLACEME
  * @HB_BUFFER_SERIALIZE_FORMAT_INVALID: invalid format.
  *
  * The buffer serialization and de-serialization format used in
@@ -495,6 +571,7 @@ typedef enum { /*< flags >*/
 typedef enum {
   HB_BUFFER_SERIALIZE_FORMAT_TEXT	= HB_TAG('T','E','X','T'),
   HB_BUFFER_SERIALIZE_FORMAT_JSON	= HB_TAG('J','S','O','N'),
+  HB_BUFFER_SERIALIZE_FORMAT_BINARY	= HB_TAG('B','I','N','A'),
   HB_BUFFER_SERIALIZE_FORMAT_INVALID	= HB_TAG_NONE
 } hb_buffer_serialize_format_t;
 
@@ -518,6 +595,30 @@ hb_buffer_serialize_glyphs (hb_buffer_t *buffer,
 			    hb_buffer_serialize_format_t format,
 			    hb_buffer_serialize_flags_t flags);
 
+/**
+ * hb_buffer_serialize_write_func_t:
+ * @data: serialized bytes to write.
+ * @length: number of bytes.
+ * @user_data: user data passed to hb_buffer_serialize_glyphs_write().
+ *
+ * Return value: %true if all @length bytes were written.
+ *
+ * Since: REPLACEME
+ **/
+typedef hb_bool_t (*hb_buffer_serialize_write_func_t) (const char   *data,
+						       unsigned int  length,
+						       void         *user_data);
+
+HB_EXTERN hb_bool_t
+hb_buffer_serialize_glyphs_write (hb_buffer_t *buffer,
+				  unsigned int start,
+				  unsigned int end,
+				  hb_font_t *font,
+				  hb_buffer_serialize_format_t format,
+				  hb_buffer_serialize_flags_t flags,
+				  hb_buffer_serialize_write_func_t func,
+				  void *user_data);
+
 HB_EXTERN hb_bool_t
 hb_buffer_deserialize_glyphs (hb_buffer_t *buffer,
 			      const char *buf,
@@ -580,6 +681,65 @@ hb_buffer_set_message_func (hb_buffer_t *buffer,
 			    hb_buffer_message_func_t func,
 			    void *user_data, hb_destroy_func_t destroy);
 
+/**
+ * hb_buffer_trace_event_type_t:
+ * @HB_BUFFER_TRACE_EVENT_TYPE_SHAPE: one hb_shape_plan_execute() call.
+ * @HB_BUFFER_TRACE_EVENT_TYPE_LOOKUP: one GSUB or GPOS lookup applied to
+ * the buffer.
+ * @HB_BUFFER_TRACE_EVENT_TYPE_SUBTABLE: one morx, mort, kerx or kern
+ * subtable applied to the buffer.
+ *
+ * The kind of work an #hb_buffer_trace_event_t times.
+ *
+ * Since: REPLACEME
+ */
+typedef enum {
+  HB_BUFFER_TRACE_EVENT_TYPE_SHAPE		= 0,
+  HB_BUFFER_TRACE_EVENT_TYPE_LOOKUP		= 1,
+  HB_BUFFER_TRACE_EVENT_TYPE_SUBTABLE		= 2
+} hb_buffer_trace_event_type_t;
+
+/**
+ * hb_buffer_trace_event_t:
+ * @type: what was timed.
+ * @table: the table the lookup or subtable belongs to, or 0 for
+ * %HB_BUFFER_TRACE_EVENT_TYPE_SHAPE.
+ * @index: the lookup or subtable index within @table.
+ * @start: first glyph the event ran over.
+ * @end: one past the last glyph the event ran over, at its end.
+ * @start_time: monotonic time the event started at, in nanoseconds.
+ * @end_time: monotonic time the event ended at, in nanoseconds.
+ *
+ * One timed step of shaping, as passed to #hb_buffer_trace_func_t.  The
+ * clock has an arbitrary origin; only differences between timestamps are
+ * meaningful.  They are zero on platforms without a monotonic clock.
+ *
+ * Since: REPLACEME
+ */
+typedef struct hb_buffer_trace_event_t {
+  hb_buffer_trace_event_type_t type;
+  hb_tag_t      table;
+  unsigned int  index;
+  unsigned int  start;
+  unsigned int  end;
+  uint64_t      start_time;
+  uint64_t      end_time;
+
+  /*< private >*/
+  hb_var_int_t  reserved1;
+  hb_var_int_t  reserved2;
+} hb_buffer_trace_event_t;
+
+typedef void	(*hb_buffer_trace_func_t)	(hb_buffer_t                   *buffer,
+						 hb_font_t                     *font,
+						 const hb_buffer_trace_event_t *event,
+						 void                          *user_data);
+
+HB_EXTERN void
+hb_buffer_set_trace_func (hb_buffer_t *buffer,
+			  hb_buffer_trace_func_t func,
+			  void *user_data, hb_destroy_func_t destroy);
+
 
 HB_END_DECLS
 
@@ -31,6 +31,7 @@
 #define HB_BUFFER_HH
 
 #include "hb.hh"
+#include "hb-pool.hh"
 #include "hb-unicode.hh"
 
 
@@ -56,6 +57,7 @@
 
 static_assert ((sizeof (hb_glyph_info_t) == 20), "");
 static_assert ((sizeof (hb_glyph_info_t) == sizeof (hb_glyph_position_t)), "");
+static_assert ((sizeof (hb_glyph_compact_t) == 12), "");
 
 HB_MARK_AS_FLAG_T (hb_buffer_flags_t);
 HB_MARK_AS_FLAG_T (hb_buffer_serialize_flags_t);
@@ -67,8 +69,11 @@ enum hb_buffer_scratch_flags_t {
   HB_BUFFER_SCRATCH_FLAG_HAS_DEFAULT_IGNORABLES		= 0x00000002u,
   HB_BUFFER_SCRATCH_FLAG_HAS_SPACE_FALLBACK		= 0x00000004u,
   HB_BUFFER_SCRATCH_FLAG_HAS_GPOS_ATTACHMENT		= 0x00000008u,
-  HB_BUFFER_SCRATCH_FLAG_HAS_UNSAFE_TO_BREAK		= 0x00000010u,
+  HB_BUFFER_SCRATCH_FLAG_HAS_GLYPH_FLAGS		= 0x00000010u,
   HB_BUFFER_SCRATCH_FLAG_HAS_CGJ			= 0x00000020u,
+  HB_BUFFER_SCRATCH_FLAG_HAS_MARKS			= 0x00000040u,
+  HB_BUFFER_SCRATCH_FLAG_HAS_DEFAULT_POSITIONS		= 0x00000080u,
+  HB_BUFFER_SCRATCH_FLAG_AAT_HAS_DELETED		= 0x00000100u,
 
   /* Reserved for complex shapers' internal use. */
   HB_BUFFER_SCRATCH_FLAG_COMPLEX0			= 0x01000000u,
@@ -96,6 +101,8 @@ struct hb_buffer_t
   hb_buffer_scratch_flags_t scratch_flags; /* Have space-fallback, etc. */
   unsigned int max_len; /* Maximum allowed len. */
   int max_ops; /* Maximum allowed operations. */
+  unsigned int max_ops_budget; /* Caller-set limit on max_ops; 0 for none. */
+  bool max_ops_exhausted; /* Last shaping ran out of max_ops_budget. */
 
   /* Buffer contents */
   hb_buffer_content_type_t content_type;
@@ -104,6 +111,8 @@ struct hb_buffer_t
   bool successful; /* Allocations successful */
   bool have_output; /* Whether we have an output buffer going on */
   bool have_positions; /* Whether we have positions */
+  bool object_in_storage; /* Object lives in caller-provided storage */
+  bool arrays_in_storage; /* info and pos live in caller-provided storage */
 
   unsigned int idx; /* Cursor into ->info and ->pos arrays */
   unsigned int len; /* Length of ->info and ->pos arrays */
@@ -116,6 +125,9 @@ struct hb_buffer_t
 
   unsigned int serial;
 
+  /* Scratch memory for internal use during one shaping call. */
+  hb_arena_t arena;
+
   /* Text before / after the main buffer contents.
    * Always in Unicode, and ordered outward.
    * Index 0 is for "pre-context", 1 for "post-context". */
@@ -127,6 +139,9 @@ struct hb_buffer_t
   hb_buffer_message_func_t message_func;
   void *message_data;
   hb_destroy_func_t message_destroy;
+  hb_buffer_trace_func_t trace_func;
+  void *trace_data;
+  hb_destroy_func_t trace_destroy;
 
   /* Internal debugging. */
   /* The bits here reflect current allocations of the bytes in glyph_info_t's var1 and var2. */
@@ -139,6 +154,10 @@ struct hb_buffer_t
 
   bool in_error () const { return !successful; }
 
+  /* The glyphs, as arrays to build iterator pipelines over. */
+  hb_array_t<hb_glyph_info_t> info_array () const { return hb_array (info, len); }
+  hb_array_t<hb_glyph_position_t> pos_array () const { return hb_array (pos, len); }
+
   void allocate_var (unsigned int start, unsigned int count)
   {
 #ifndef HB_NDEBUG
@@ -315,6 +334,14 @@ struct hb_buffer_t
   /* Merge clusters for deleting current glyph, and skip it. */
   HB_INTERNAL void delete_glyph ();
 
+  /* Unsafe-to-break implies unsafe-to-concat; the latter is only produced
+   * on request. */
+  hb_mask_t unsafe_to_break_mask () const
+  {
+    return HB_GLYPH_FLAG_UNSAFE_TO_BREAK |
+	   ((flags & HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT) ? HB_GLYPH_FLAG_UNSAFE_TO_CONCAT : 0);
+  }
+
   void unsafe_to_break (unsigned int start,
 			       unsigned int end)
   {
@@ -322,8 +349,26 @@ struct hb_buffer_t
       return;
     unsafe_to_break_impl (start, end);
   }
-  HB_INTERNAL void unsafe_to_break_impl (unsigned int start, unsigned int end);
-  HB_INTERNAL void unsafe_to_break_from_outbuffer (unsigned int start, unsigned int end);
+  void unsafe_to_break_impl (unsigned int start, unsigned int end)
+  { set_glyph_flags (unsafe_to_break_mask (), start, end); }
+  void unsafe_to_break_from_outbuffer (unsigned int start, unsigned int end)
+  { set_glyph_flags_from_outbuffer (unsafe_to_break_mask (), start, end); }
+
+  void unsafe_to_concat (unsigned int start, unsigned int end)
+  {
+    if (likely (!(flags & HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT)) || end - start < 2)
+      return;
+    set_glyph_flags (HB_GLYPH_FLAG_UNSAFE_TO_CONCAT, start, end);
+  }
+  void unsafe_to_concat_from_outbuffer (unsigned int start, unsigned int end)
+  {
+    if (likely (!(flags & HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT)))
+      return;
+    set_glyph_flags_from_outbuffer (HB_GLYPH_FLAG_UNSAFE_TO_CONCAT, start, end);
+  }
+
+  HB_INTERNAL void set_glyph_flags (hb_mask_t mask, unsigned int start, unsigned int end);
+  HB_INTERNAL void set_glyph_flags_from_outbuffer (hb_mask_t mask, unsigned int start, unsigned int end);
 
 
   /* Internal methods */
@@ -360,16 +405,15 @@ struct hb_buffer_t
   }
   HB_INTERNAL bool message_impl (hb_font_t *font, const char *fmt, va_list ap) HB_PRINTF_FUNC(3, 0);
 
+  bool tracing () const { return unlikely (trace_func); }
+  void trace (hb_font_t *font, const hb_buffer_trace_event_t *event)
+  { trace_func (this, font, event, trace_data); }
+
   static void
   set_cluster (hb_glyph_info_t &inf, unsigned int cluster, unsigned int mask = 0)
   {
     if (inf.cluster != cluster)
-    {
-      if (mask & HB_GLYPH_FLAG_UNSAFE_TO_BREAK)
-	inf.mask |= HB_GLYPH_FLAG_UNSAFE_TO_BREAK;
-      else
-	inf.mask &= ~HB_GLYPH_FLAG_UNSAFE_TO_BREAK;
-    }
+      inf.mask = (inf.mask & ~HB_GLYPH_FLAG_DEFINED) | (mask & HB_GLYPH_FLAG_DEFINED);
     inf.cluster = cluster;
   }
 
@@ -385,13 +429,14 @@ struct hb_buffer_t
   void
   _unsafe_to_break_set_mask (hb_glyph_info_t *infos,
 			     unsigned int start, unsigned int end,
-			     unsigned int cluster)
+			     unsigned int cluster,
+			     hb_mask_t mask)
   {
     for (unsigned int i = start; i < end; i++)
       if (cluster != infos[i].cluster)
       {
-	scratch_flags |= HB_BUFFER_SCRATCH_FLAG_HAS_UNSAFE_TO_BREAK;
-	infos[i].mask |= HB_GLYPH_FLAG_UNSAFE_TO_BREAK;
+	scratch_flags |= HB_BUFFER_SCRATCH_FLAG_HAS_GLYPH_FLAGS;
+	infos[i].mask |= mask;
       }
   }
 
@@ -406,6 +451,41 @@ struct hb_buffer_t
 DECLARE_NULL_INSTANCE (hb_buffer_t);
 
 
+/* Nanoseconds on a monotonic clock, or 0 if there is none. */
+HB_INTERNAL uint64_t _hb_trace_now ();
+
+/* Times the enclosing scope and reports it to the buffer's trace func.
+ * Costs a pointer test when no trace func is set. */
+struct hb_buffer_trace_scope_t
+{
+  hb_buffer_trace_scope_t (hb_buffer_t *buffer_, hb_font_t *font_,
+			   hb_buffer_trace_event_type_t type,
+			   hb_tag_t table, unsigned int index)
+  {
+    buffer = buffer_->tracing () ? buffer_ : nullptr;
+    if (likely (!buffer)) return;
+    font = font_;
+    memset (&event, 0, sizeof (event));
+    event.type = type;
+    event.table = table;
+    event.index = index;
+    event.start_time = _hb_trace_now ();
+  }
+  ~hb_buffer_trace_scope_t ()
+  {
+    if (likely (!buffer)) return;
+    event.end = buffer->len;
+    event.end_time = _hb_trace_now ();
+    buffer->trace (font, &event);
+  }
+
+  private:
+  hb_buffer_t *buffer;
+  hb_font_t *font;
+  hb_buffer_trace_event_t event;
+};
+
+
 /* Loop over clusters. Duplicated in foreach_syllable(). */
 #define foreach_cluster(buffer, start, end) \
   for (unsigned int \
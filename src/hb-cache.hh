@@ -77,4 +77,82 @@ typedef hb_cache_t<21, 16, 8> hb_cmap_cache_t;
 typedef hb_cache_t<16, 24, 8> hb_advance_cache_t;
 
 
+/* Same as hb_cache_t, but with the number of entries chosen at runtime.
+ * The size is rounded down to a power of two and clamped to what the
+ * key and value widths allow.  A size of zero disables the cache. */
+
+template <unsigned int key_bits, unsigned int value_bits>
+struct hb_dynamic_cache_t
+{
+  static_assert (sizeof (hb_atomic_int_t) == sizeof (unsigned int), "");
+
+  bool init (unsigned int size)
+  {
+    cache_bits = 0;
+    values = nullptr;
+    if (!size)
+      return true;
+
+    /* Enough cache bits to fit the rest of the key with the value. */
+    unsigned int min_cache_bits = key_bits + value_bits > 32 ? key_bits + value_bits - 32 : 0;
+    cache_bits = hb_bit_storage (size) - 1;
+    cache_bits = hb_min (hb_max (cache_bits, min_cache_bits), key_bits);
+    values = (hb_atomic_int_t *) malloc (sizeof (hb_atomic_int_t) << cache_bits);
+    if (unlikely (!values))
+    {
+      cache_bits = 0;
+      return false;
+    }
+    clear ();
+    return true;
+  }
+  void fini ()
+  {
+    free (values);
+    values = nullptr;
+    cache_bits = 0;
+  }
+
+  void clear ()
+  {
+    if (!values) return;
+    for (unsigned i = 0; i < (1u<<cache_bits); i++)
+      values[i].set_relaxed (-1);
+  }
+
+  unsigned int get_size () const { return values ? 1u<<cache_bits : 0; }
+
+  bool get (unsigned int key, unsigned int *value) const
+  {
+    if (unlikely (!values || (key >> key_bits))) return false;
+    unsigned int k = key & ((1u<<cache_bits)-1);
+    unsigned int v = values[k].get_relaxed ();
+    if ((key_bits + value_bits - cache_bits == 8 * sizeof (hb_atomic_int_t) && v == (unsigned int) -1) ||
+	(v >> value_bits) != (key >> cache_bits))
+      return false;
+    *value = v & ((1u<<value_bits)-1);
+    return true;
+  }
+
+  bool set (unsigned int key, unsigned int value)
+  {
+    if (unlikely (!values)) return false;
+    if (unlikely ((key >> key_bits) || (value >> value_bits)))
+      return false; /* Overflows */
+    unsigned int k = key & ((1u<<cache_bits)-1);
+    unsigned int v = ((key>>cache_bits)<<value_bits) | value;
+    values[k].set_relaxed (v);
+    return true;
+  }
+
+  private:
+  unsigned int cache_bits;
+  hb_atomic_int_t *values;
+};
+
+typedef hb_dynamic_cache_t<21, 16> hb_cmap_dynamic_cache_t;
+typedef hb_dynamic_cache_t<16, 24> hb_advance_dynamic_cache_t;
+typedef hb_dynamic_cache_t<16, 16> hb_origin_dynamic_cache_t;
+
+
 #endif /* HB_CACHE_HH */
@@ -387,7 +387,11 @@ struct byte_str_ref_t
 
 typedef hb_vector_t<byte_str_t> byte_str_array_t;
 
-/* stack */
+/* stack
+ *
+ * The elements live in the stack itself, so setting one up for every
+ * charstring costs nothing; they are only read once pushed, and pushing
+ * sets them. */
 template <typename ELEM, int LIMIT>
 struct stack_t
 {
@@ -395,26 +399,23 @@ struct stack_t
   {
     error = false;
     count = 0;
-    elements.init ();
-    elements.resize (kSizeLimit);
-    for (unsigned int i = 0; i < elements.length; i++)
-      elements[i].init ();
   }
 
-  void fini ()
-  {
-    elements.fini_deep ();
-  }
+  void fini () {}
 
   ELEM& operator [] (unsigned int i)
   {
-    if (unlikely (i >= count)) set_error ();
+    if (unlikely (i >= count))
+    {
+      set_error ();
+      return Crap(ELEM);
+    }
     return elements[i];
   }
 
   void push (const ELEM &v)
   {
-    if (likely (count < elements.length))
+    if (likely (count < kSizeLimit))
       elements[count++] = v;
     else
       set_error ();
@@ -422,7 +423,7 @@ struct stack_t
 
   ELEM &push ()
   {
-    if (likely (count < elements.length))
+    if (likely (count < kSizeLimit))
       return elements[count++];
     else
     {
@@ -463,7 +464,7 @@ struct stack_t
 
   void unpop ()
   {
-    if (likely (count < elements.length))
+    if (likely (count < kSizeLimit))
       count++;
     else
       set_error ();
@@ -471,7 +472,7 @@ struct stack_t
 
   void clear () { count = 0; }
 
-  bool in_error () const { return (error || elements.in_error ()); }
+  bool in_error () const { return error; }
   void set_error ()      { error = true; }
 
   unsigned int get_count () const { return count; }
@@ -482,7 +483,7 @@ struct stack_t
   protected:
   bool error;
   unsigned int count;
-  hb_vector_t<ELEM> elements;
+  ELEM elements[LIMIT];
 };
 
 /* argument stack */
@@ -539,7 +540,7 @@ struct arg_stack_t : stack_t<ARG, 513>
 
   hb_array_t<const ARG> get_subarray (unsigned int start) const
   {
-    return S::elements.sub_array (start);
+    return hb_array (S::elements).sub_array (start);
   }
 
   private:
@@ -581,6 +582,8 @@ struct parsed_values_t
   }
   void fini () { values.fini_deep (); }
 
+  void add_memory_usage (hb_memory_usage_t *usage) const { usage->add_vector (values); }
+
   void add_op (op_code_t op, const byte_str_ref_t& str_ref = byte_str_ref_t ())
   {
     VAL *val = values.push ();
@@ -38,58 +38,75 @@ struct blend_arg_t : number_t
   void init ()
   {
     number_t::init ();
-    deltas.init ();
+    reset_blends ();
   }
 
-  void fini ()
-  {
-    number_t::fini ();
-    deltas.fini_deep ();
-  }
+  void fini () {}
 
   void set_int (int v) { reset_blends (); number_t::set_int (v); }
   void set_fixed (int32_t v) { reset_blends (); number_t::set_fixed (v); }
   void set_real (double v) { reset_blends (); number_t::set_real (v); }
 
   void set_blends (unsigned int numValues_, unsigned int valueIndex_,
-			  unsigned int numBlends, hb_array_t<const blend_arg_t> blends_)
+			  unsigned int deltasStart_, unsigned int numDeltas_)
   {
     numValues = numValues_;
     valueIndex = valueIndex_;
-    deltas.resize (numBlends);
-    for (unsigned int i = 0; i < numBlends; i++)
-      deltas[i] = blends_[i];
+    deltasStart = deltasStart_;
+    numDeltas = numDeltas_;
   }
 
-  bool blending () const { return deltas.length > 0; }
+  bool blending () const { return numDeltas > 0; }
   void reset_blends ()
   {
     numValues = valueIndex = 0;
-    deltas.resize (0);
+    deltasStart = numDeltas = 0;
   }
 
   unsigned int numValues;
   unsigned int valueIndex;
-  hb_vector_t<number_t> deltas;
+  /* The deltas are numDeltas numbers at deltasStart in the delta pool of
+   * the interpreter environment; see cff2_cs_interp_env_t::get_deltas(). */
+  unsigned int deltasStart;
+  unsigned int numDeltas;
 };
 
+/* Inline capacity of the blend scalars; enough for the regions of most
+ * variable fonts, so blending a glyph doesn't allocate for them. */
+#ifndef HB_CFF2_INLINE_SCALARS
+#define HB_CFF2_INLINE_SCALARS 32
+#endif
+
+/* Inline capacity of the pool holding the deltas of blended arguments,
+ * enough for the blends of a typical glyph. */
+#ifndef HB_CFF2_INLINE_DELTAS
+#define HB_CFF2_INLINE_DELTAS 64
+#endif
+
 typedef interp_env_t<blend_arg_t> BlendInterpEnv;
 typedef biased_subrs_t<CFF2Subrs>   cff2_biased_subrs_t;
 
 struct cff2_cs_interp_env_t : cs_interp_env_t<blend_arg_t, CFF2Subrs>
 {
+  /* If region_scalars_ is not null, it holds the scalars of all regions
+   * of acc's variation store at coords_, as from
+   * VariationStore::get_font_scalars(), and blends use it instead of
+   * evaluating the regions again. */
   template <typename ACC>
   void init (const byte_str_t &str, ACC &acc, unsigned int fd,
-		    const int *coords_=nullptr, unsigned int num_coords_=0)
+		    const int *coords_=nullptr, unsigned int num_coords_=0,
+		    const float *region_scalars_=nullptr)
   {
     SUPER::init (str, *acc.globalSubrs, *acc.privateDicts[fd].localSubrs);
 
     coords = coords_;
     num_coords = num_coords_;
+    region_scalars = region_scalars_;
     varStore = acc.varStore;
     seen_blend = false;
     seen_vsindex_ = false;
-    scalars.init ();
+    scalars.reset ();
+    deltas.reset ();
     do_blend = (coords != nullptr) && num_coords && (varStore != &Null(CFF2VariationStore));
     set_ivs (acc.privateDicts[fd].ivs);
   }
@@ -97,6 +114,7 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<blend_arg_t, CFF2Subrs>
   void fini ()
   {
     scalars.fini ();
+    deltas.fini ();
     SUPER::fini ();
   }
 
@@ -136,7 +154,8 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<blend_arg_t, CFF2Subrs>
 	scalars.resize (region_count);
 	varStore->varStore.get_scalars (get_ivs (),
 					(int *)coords, num_coords,
-					&scalars[0], region_count);
+					&scalars[0], region_count,
+					region_scalars);
       }
       seen_blend = true;
     }
@@ -156,6 +175,23 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<blend_arg_t, CFF2Subrs>
     seen_vsindex_ = true;
   }
 
+  /* Copies blend deltas into the pool, returning where they start. */
+  unsigned int add_deltas (hb_array_t<const blend_arg_t> blends)
+  {
+    unsigned int start = deltas.length;
+    if (unlikely (!deltas.resize (start + blends.length)))
+    {
+      set_error ();
+      return 0;
+    }
+    for (unsigned int i = 0; i < blends.length; i++)
+      deltas[start + i] = blends[i];
+    return start;
+  }
+
+  hb_array_t<const number_t> get_deltas (const blend_arg_t &arg) const
+  { return deltas.sub_array (arg.deltasStart, arg.numDeltas); }
+
   unsigned int get_region_count () const { return region_count; }
   void	 set_region_count (unsigned int region_count_) { region_count = region_count_; }
   unsigned int get_ivs () const { return ivs; }
@@ -167,15 +203,15 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<blend_arg_t, CFF2Subrs>
   {
     if (do_blend && arg.blending ())
     {
-      if (likely (scalars.length == arg.deltas.length))
+      if (likely (scalars.length == arg.numDeltas))
       {
+	hb_array_t<const number_t> arg_deltas = get_deltas (arg);
 	double v = arg.to_real ();
-	for (unsigned int i = 0; i < scalars.length; i++)
+	for (unsigned int i = 0; i < arg_deltas.length; i++)
 	{
-	  v += (double)scalars[i] * arg.deltas[i].to_real ();
+	  v += (double)scalars[i] * arg_deltas[i].to_real ();
 	}
 	arg.set_real (v);
-	arg.deltas.resize (0);
       }
     }
   }
@@ -183,10 +219,12 @@ struct cff2_cs_interp_env_t : cs_interp_env_t<blend_arg_t, CFF2Subrs>
   protected:
   const int     *coords;
   unsigned int  num_coords;
+  const float   *region_scalars;
   const	 CFF2VariationStore *varStore;
   unsigned int  region_count;
   unsigned int  ivs;
-  hb_vector_t<float>  scalars;
+  hb_vector_t<float, HB_CFF2_INLINE_SCALARS>  scalars;
+  hb_vector_t<number_t, HB_CFF2_INLINE_DELTAS>  deltas;
   bool	  do_blend;
   bool	  seen_vsindex_;
   bool	  seen_blend;
@@ -245,8 +283,8 @@ struct cff2_cs_opset_t : cs_opset_t<blend_arg_t, OPSET, cff2_cs_interp_env_t, PA
     }
     for (unsigned int i = 0; i < n; i++)
     {
-      const hb_array_t<const blend_arg_t>	blends = env.argStack.get_subarray (start + n + (i * k));
-      env.argStack[start + i].set_blends (n, i, k, blends);
+      const hb_array_t<const blend_arg_t>	blends = env.argStack.get_subarray (start + n + (i * k)).sub_array (0, k);
+      env.argStack[start + i].set_blends (n, i, env.add_deltas (blends), k);
     }
 
     /* pop off blend values leaving default values now adorned with blend values */
@@ -225,11 +225,10 @@ lang_equal (hb_language_t  v1,
   return *p1 == canon_map[*p2];
 }
 
-#if 0
 static unsigned int
 lang_hash (const void *key)
 {
-  const unsigned char *p = key;
+  const unsigned char *p = (const unsigned char *) key;
   unsigned int h = 0;
   while (canon_map[*p])
     {
@@ -239,56 +238,72 @@ lang_hash (const void *key)
 
   return h;
 }
-#endif
 
 
 struct hb_language_item_t {
 
   struct hb_language_item_t *next;
   hb_language_t lang;
+  unsigned int hash;
+  /* Memoized by hb-ot-tag.cc; see _hb_language_get_ot_tags(). */
+  hb_atomic_ptr_t<hb_language_ot_tags_t> ot_tags;
 
-  bool operator == (const char *s) const
-  { return lang_equal (lang, s); }
-
-  hb_language_item_t & operator = (const char *s) {
-    /* If a custom allocated is used calling strdup() pairs
-    badly with a call to the custom free() in fini() below.
-    Therefore don't call strdup(), implement its behavior.
-    */
-    size_t len = strlen(s) + 1;
-    lang = (hb_language_t) malloc(len);
-    if (likely (lang))
-    {
-      memcpy((unsigned char *) lang, s, len);
-      for (unsigned char *p = (unsigned char *) lang; *p; p++)
-	*p = canon_map[*p];
-    }
-
-    return *this;
+  /* The canonicalized string is stored right after the item itself, such
+   * that the item can be found back from the hb_language_t. */
+  static hb_language_item_t *create (const char *s)
+  {
+    /* Don't call strdup(); a custom allocator would pair badly with it. */
+    size_t len = strlen (s) + 1;
+    hb_language_item_t *item = (hb_language_item_t *) calloc (1, sizeof (hb_language_item_t) + len);
+    if (unlikely (!item))
+      return nullptr;
+
+    unsigned char *p = (unsigned char *) (item + 1);
+    memcpy (p, s, len);
+    for (; *p; p++)
+      *p = canon_map[*p];
+    item->lang = (hb_language_t) (item + 1);
+
+    return item;
   }
 
-  void fini () { free ((void *) lang); }
+  static hb_language_item_t *from_language (hb_language_t language)
+  { return ((hb_language_item_t *) language) - 1; }
+
+  bool matches (const char *s, unsigned int h) const
+  { return hash == h && lang_equal (lang, s); }
+
+  void fini () { free ((void *) ot_tags.get_relaxed ()); }
 };
 
 
-/* Thread-safe lock-free language list */
+/* Thread-safe lock-free language table: a fixed array of buckets, each
+ * a list that only ever grows at its head.  Items are never moved, so
+ * an hb_language_t stays valid and unique for the process lifetime. */
 
-static hb_atomic_ptr_t <hb_language_item_t> langs;
+#define HB_LANGUAGE_BUCKETS 256 /* Power of two. */
+
+static hb_atomic_ptr_t <hb_language_item_t> langs[HB_LANGUAGE_BUCKETS];
 
 #if HB_USE_ATEXIT
+static hb_atomic_int_t num_langs;
+
 static void
 free_langs ()
 {
-retry:
-  hb_language_item_t *first_lang = langs;
-  if (unlikely (!langs.cmpexch (first_lang, nullptr)))
-    goto retry;
-
-  while (first_lang) {
-    hb_language_item_t *next = first_lang->next;
-    first_lang->fini ();
-    free (first_lang);
-    first_lang = next;
+  for (unsigned int i = 0; i < HB_LANGUAGE_BUCKETS; i++)
+  {
+  retry:
+    hb_language_item_t *first_lang = langs[i];
+    if (unlikely (!langs[i].cmpexch (first_lang, nullptr)))
+      goto retry;
+
+    while (first_lang) {
+      hb_language_item_t *next = first_lang->next;
+      first_lang->fini ();
+      free (first_lang);
+      first_lang = next;
+    }
   }
 }
 #endif
@@ -296,34 +311,40 @@ retry:
 static hb_language_item_t *
 lang_find_or_insert (const char *key)
 {
+  unsigned int hash = lang_hash (key);
+  hb_atomic_ptr_t <hb_language_item_t> &bucket = langs[hash & (HB_LANGUAGE_BUCKETS - 1)];
+  hb_language_item_t *lang = nullptr;
+
 retry:
-  hb_language_item_t *first_lang = langs;
+  hb_language_item_t *first_lang = bucket;
 
-  for (hb_language_item_t *lang = first_lang; lang; lang = lang->next)
-    if (*lang == key)
-      return lang;
+  for (hb_language_item_t *item = first_lang; item; item = item->next)
+    if (item->matches (key, hash))
+    {
+      if (unlikely (lang))
+      {
+	/* Lost a race against an insertion of the same key. */
+	lang->fini ();
+	free (lang);
+      }
+      return item;
+    }
 
   /* Not found; allocate one. */
-  hb_language_item_t *lang = (hb_language_item_t *) calloc (1, sizeof (hb_language_item_t));
-  if (unlikely (!lang))
-    return nullptr;
-  lang->next = first_lang;
-  *lang = key;
-  if (unlikely (!lang->lang))
+  if (!lang)
   {
-    free (lang);
-    return nullptr;
+    lang = hb_language_item_t::create (key);
+    if (unlikely (!lang))
+      return nullptr;
+    lang->hash = hash;
   }
+  lang->next = first_lang;
 
-  if (unlikely (!langs.cmpexch (first_lang, lang)))
-  {
-    lang->fini ();
-    free (lang);
+  if (unlikely (!bucket.cmpexch (first_lang, lang)))
     goto retry;
-  }
 
 #if HB_USE_ATEXIT
-  if (!first_lang)
+  if (!num_langs.inc ())
     atexit (free_langs); /* First person registers atexit() callback. */
 #endif
 
@@ -417,6 +438,32 @@ hb_language_get_default ()
   return language;
 }
 
+const hb_language_ot_tags_t *
+_hb_language_get_ot_tags (hb_language_t language)
+{
+  return hb_language_item_t::from_language (language)->ot_tags.get ();
+}
+
+const hb_language_ot_tags_t *
+_hb_language_set_ot_tags (hb_language_t language,
+			  const hb_language_ot_tags_t *tags)
+{
+  hb_language_item_t *item = hb_language_item_t::from_language (language);
+
+  hb_language_ot_tags_t *copy = (hb_language_ot_tags_t *) malloc (sizeof (*copy));
+  if (unlikely (!copy))
+    return tags;
+  *copy = *tags;
+
+  if (unlikely (!item->ot_tags.cmpexch (nullptr, copy)))
+  {
+    /* Another thread got there first; it computed the same thing. */
+    free (copy);
+    return item->ot_tags.get ();
+  }
+  return copy;
+}
+
 
 /* hb_script_t */
 
@@ -601,24 +648,121 @@ hb_user_data_array_t::set (hb_user_data_key_t *key,
   if (!key)
     return false;
 
-  if (replace) {
-    if (!data && !destroy) {
-      items.remove (key, lock);
-      return true;
+  bool clear = replace && !data && !destroy;
+  void *old_data = nullptr;
+  hb_destroy_func_t old_destroy = nullptr;
+
+  lock.lock ();
+
+  table_t *t = table.get_relaxed ();
+  unsigned int length = t ? t->length.get_relaxed () : 0;
+  hb_user_data_item_t *item = nullptr;
+  for (unsigned int i = 0; i < length; i++)
+    if (t->items[i].key == key)
+    {
+      item = &t->items[i];
+      break;
+    }
+
+  if (item && item->is_set)
+  {
+    if (!replace)
+    {
+      lock.unlock ();
+      return false;
     }
+    old_data = item->data.get_relaxed ();
+    old_destroy = item->destroy;
+  }
+  else if (clear)
+  {
+    lock.unlock ();
+    return true;
   }
-  hb_user_data_item_t item = {key, data, destroy};
-  bool ret = !!items.replace_or_insert (item, lock, (bool) replace);
 
-  return ret;
+  if (!item)
+  {
+    if (!t || length == t->allocated)
+    {
+      unsigned int allocated = t ? 2 * t->allocated : 4;
+      table_t *new_t = (table_t *) calloc (table_t::get_size (allocated), 1);
+      if (unlikely (!new_t))
+      {
+	lock.unlock ();
+	return false;
+      }
+      new_t->prev = t;
+      new_t->allocated = allocated;
+      for (unsigned int i = 0; i < length; i++)
+      {
+	hb_user_data_item_t &src = t->items[i];
+	hb_user_data_item_t &dst = new_t->items[i];
+	dst.key = src.key;
+	dst.data.set_relaxed (src.data.get_relaxed ());
+	dst.destroy = src.destroy;
+	dst.is_set = src.is_set;
+      }
+      new_t->length.set_relaxed (length);
+      table.cmpexch (t, new_t);
+      t = new_t;
+    }
+    item = &t->items[length];
+    item->key = key;
+  }
+
+  item->data.cmpexch (item->data.get_relaxed (), data);
+  item->destroy = destroy;
+  item->is_set = !clear;
+  if (item == &t->items[length])
+    t->length.set (length + 1);
+
+  lock.unlock ();
+
+  if (old_destroy)
+    old_destroy (old_data);
+
+  return true;
 }
 
 void *
 hb_user_data_array_t::get (hb_user_data_key_t *key)
 {
-  hb_user_data_item_t item = {nullptr, nullptr, nullptr};
+  const table_t *t = table.get ();
+  if (!t)
+    return nullptr;
 
-  return items.find (key, &item, lock) ? item.data : nullptr;
+  unsigned int length = t->length.get ();
+  for (unsigned int i = 0; i < length; i++)
+    if (t->items[i].key == key)
+      return t->items[i].data.get ();
+
+  return nullptr;
+}
+
+void
+hb_user_data_array_t::fini ()
+{
+  table_t *t = table.get_relaxed ();
+  if (!t)
+    return;
+
+  /* Destroy in the reverse order items were first set. */
+  for (unsigned int i = t->length.get_relaxed (); i; i--)
+  {
+    hb_user_data_item_t &item = t->items[i - 1];
+    if (item.is_set && item.destroy)
+      item.destroy (item.data.get_relaxed ());
+  }
+
+  while (t)
+  {
+    table_t *prev = t->prev;
+    free (t);
+    t = prev;
+  }
+  table.init ();
+
+  lock.fini ();
 }
 
 
@@ -1217,6 +1361,99 @@ uint8_t
 }
 
 
+/* hb_alloc_stats */
+
+#ifdef HB_ALLOC_STATS
+static hb_atomic_int_t _hb_alloc_stats[HB_ALLOC_SUBSYSTEM_SANITIZE + 1];
+thread_local hb_alloc_subsystem_t _hb_alloc_stats_subsystem;
+#endif
+
+/**
+ * hb_alloc_stats_get:
+ * @subsystem: the subsystem to query.
+ * @count: (out): number of allocations made by @subsystem.
+ *
+ * Fetches the number of allocations made on behalf of @subsystem
+ * since the library was loaded or hb_alloc_stats_reset() was last
+ * called, across all threads.  Each call to malloc(), calloc() or
+ * realloc() counts as one allocation.
+ *
+ * Counting is only available when HarfBuzz is built with
+ * `HB_ALLOC_STATS` defined; otherwise @count is set to zero.
+ *
+ * Return value: %true if allocations are being counted, %false otherwise.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_alloc_stats_get (hb_alloc_subsystem_t subsystem,
+		    unsigned int        *count)
+{
+#ifdef HB_ALLOC_STATS
+  *count = (unsigned) subsystem <= HB_ALLOC_SUBSYSTEM_SANITIZE ?
+	   _hb_alloc_stats[subsystem].get_relaxed () : 0;
+  return true;
+#else
+  *count = 0;
+  return false;
+#endif
+}
+
+/**
+ * hb_alloc_stats_reset:
+ *
+ * Resets all allocation counters reported by hb_alloc_stats_get()
+ * to zero.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_alloc_stats_reset ()
+{
+#ifdef HB_ALLOC_STATS
+  for (unsigned int i = 0; i <= HB_ALLOC_SUBSYSTEM_SANITIZE; i++)
+    _hb_alloc_stats[i].set_relaxed (0);
+#endif
+}
+
+#ifdef HB_ALLOC_STATS
+/* Forward to whatever allocator hb.hh would have used without counting. */
+#undef malloc
+#undef calloc
+#undef realloc
+#if defined(hb_malloc_impl) \
+ && defined(hb_calloc_impl) \
+ && defined(hb_realloc_impl) \
+ && defined(hb_free_impl)
+#define malloc hb_malloc_impl
+#define calloc hb_calloc_impl
+#define realloc hb_realloc_impl
+#endif
+
+extern "C" void *
+_hb_alloc_stats_malloc (size_t size)
+{
+  _hb_alloc_stats[_hb_alloc_stats_subsystem].inc ();
+  return malloc (size);
+}
+
+extern "C" void *
+_hb_alloc_stats_calloc (size_t nmemb, size_t size)
+{
+  _hb_alloc_stats[_hb_alloc_stats_subsystem].inc ();
+  return calloc (nmemb, size);
+}
+
+extern "C" void *
+_hb_alloc_stats_realloc (void *ptr, size_t size)
+{
+  if (size)
+    _hb_alloc_stats[_hb_alloc_stats_subsystem].inc ();
+  return realloc (ptr, size);
+}
+#endif
+
+
 /* If there is no visibility control, then hb-static.cc will NOT
  * define anything.  Instead, we get it to define one set in here
  * only, so only libharfbuzz.so defines them, not other libs. */
@@ -408,6 +408,36 @@ typedef struct hb_user_data_key_t {
 typedef void (*hb_destroy_func_t) (void *user_data);
 
 
+/* Executors, for running independent jobs concurrently. */
+
+/**
+ * hb_job_func_t:
+ * @index: index of the job to run.
+ * @job_data: data to pass back unchanged.
+ *
+ * Since: REPLACEME
+ **/
+typedef void (*hb_job_func_t) (unsigned int index, void *job_data);
+
+/**
+ * hb_executor_func_t:
+ * @count: number of jobs.
+ * @job_func: function to run each job.
+ * @job_data: data to pass to @job_func.
+ * @user_data: user data passed along with the executor.
+ *
+ * Must call @job_func once for each index from 0 to @count - 1, in any
+ * order and possibly concurrently, and only return once all calls have
+ * returned.
+ *
+ * Since: REPLACEME
+ **/
+typedef void (*hb_executor_func_t) (unsigned int   count,
+				    hb_job_func_t  job_func,
+				    void          *job_data,
+				    void          *user_data);
+
+
 /* Font features and variations. */
 
 /**
@@ -483,6 +513,39 @@ HB_EXTERN uint8_t
 hb_color_get_blue (hb_color_t color);
 #define hb_color_get_blue(color)	(((color) >> 24) & 0xFF)
 
+/**
+ * hb_alloc_subsystem_t:
+ * @HB_ALLOC_SUBSYSTEM_OTHER: Allocations not attributed to any of the others.
+ * @HB_ALLOC_SUBSYSTEM_BUFFER: Buffer creation and growth.
+ * @HB_ALLOC_SUBSYSTEM_SHAPE_PLAN: Shape plans and the shape-plan cache.
+ * @HB_ALLOC_SUBSYSTEM_MAP: Feature maps compiled for shape plans.
+ * @HB_ALLOC_SUBSYSTEM_ACCELERATOR: Layout table and lookup accelerators.
+ * @HB_ALLOC_SUBSYSTEM_SANITIZE: Loading and sanitizing font tables.
+ *
+ * The parts of the library that hb_alloc_stats_get() counts allocations for.
+ *
+ * Since: REPLACEME
+ */
+typedef enum
+{
+  HB_ALLOC_SUBSYSTEM_OTHER,
+  HB_ALLOC_SUBSYSTEM_BUFFER,
+  HB_ALLOC_SUBSYSTEM_SHAPE_PLAN,
+  HB_ALLOC_SUBSYSTEM_MAP,
+  HB_ALLOC_SUBSYSTEM_ACCELERATOR,
+  HB_ALLOC_SUBSYSTEM_SANITIZE,
+
+  /*< private >*/
+  _HB_ALLOC_SUBSYSTEM_MAX_VALUE = HB_TAG_MAX_SIGNED /*< skip >*/
+} hb_alloc_subsystem_t;
+
+HB_EXTERN hb_bool_t
+hb_alloc_stats_get (hb_alloc_subsystem_t subsystem,
+		    unsigned int        *count);
+
+HB_EXTERN void
+hb_alloc_stats_reset (void);
+
 HB_END_DECLS
 
 #endif /* HB_COMMON_H */
@@ -0,0 +1,91 @@
+/*
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef HB_CONFIG_HH
+#define HB_CONFIG_HH
+
+/*
+ * Compile-time configuration.
+ *
+ * Those embedding HarfBuzz can leave out whole features by defining
+ * these, for example in CPPFLAGS.  The code and the shaping hooks of a
+ * feature left out are not compiled; its public API stays, but behaves
+ * as if no font had the tables it reads.
+ *
+ *   HB_NO_AAT			AAT shaping (morx, kerx, trak) and the hb-aat API.
+ *   HB_NO_COLOR		The hb-ot-color API and bitmap glyph extents.
+ *   HB_NO_MATH			The hb-ot-math API.
+ *   HB_NO_OT_KERN		Kerning with the legacy 'kern' table.
+ *   HB_NO_OT_SHAPE_FALLBACK	Fallback mark positioning, kerning and
+ *				spaces, and the per-script fallbacks.
+ *   HB_NO_OT_SHAPE_COMPLEX_ARABIC, _HANGUL, _HEBREW, _INDIC, _KHMER,
+ *   _MYANMAR, _THAI, _USE	Complex shapers; their scripts are shaped
+ *				with the default shaper instead.
+ *   HB_NO_SUBSET_LAYOUT	Subsetting of GSUB, GPOS and GDEF.
+ *
+ * Some features need others; those are left out along with what they
+ * need, below.
+ */
+
+
+#if defined(HB_NO_AAT) && !defined(HB_NO_NAME_TABLE_AAT)
+#define HB_NO_NAME_TABLE_AAT
+#endif
+
+#if defined(HB_NO_COLOR) && !defined(HB_NO_OT_FONT_BITMAP)
+#define HB_NO_OT_FONT_BITMAP
+#endif
+
+/* The USE shaper joins Arabic-like scripts with the Arabic shaper's code. */
+#if defined(HB_NO_OT_SHAPE_COMPLEX_ARABIC) && !defined(HB_NO_OT_SHAPE_COMPLEX_USE)
+#define HB_NO_OT_SHAPE_COMPLEX_USE
+#endif
+
+#if (defined(HB_NO_OT_SHAPE_FALLBACK) || defined(HB_NO_OT_SHAPE_COMPLEX_ARABIC)) && \
+    !defined(HB_NO_OT_SHAPE_COMPLEX_ARABIC_FALLBACK)
+#define HB_NO_OT_SHAPE_COMPLEX_ARABIC_FALLBACK
+#endif
+#if (defined(HB_NO_OT_SHAPE_FALLBACK) || defined(HB_NO_OT_SHAPE_COMPLEX_HEBREW)) && \
+    !defined(HB_NO_OT_SHAPE_COMPLEX_HEBREW_FALLBACK)
+#define HB_NO_OT_SHAPE_COMPLEX_HEBREW_FALLBACK
+#endif
+#if (defined(HB_NO_OT_SHAPE_FALLBACK) || defined(HB_NO_OT_SHAPE_COMPLEX_THAI)) && \
+    !defined(HB_NO_OT_SHAPE_COMPLEX_THAI_FALLBACK)
+#define HB_NO_OT_SHAPE_COMPLEX_THAI_FALLBACK
+#endif
+
+/* Khmer and Myanmar use the Indic character categories. */
+#if defined(HB_NO_OT_SHAPE_COMPLEX_INDIC) && \
+    defined(HB_NO_OT_SHAPE_COMPLEX_KHMER) && \
+    defined(HB_NO_OT_SHAPE_COMPLEX_MYANMAR) && \
+    !defined(HB_NO_OT_SHAPE_COMPLEX_INDIC_TABLE)
+#define HB_NO_OT_SHAPE_COMPLEX_INDIC_TABLE
+#endif
+
+#if defined(HB_NO_OT_SHAPE_COMPLEX_INDIC) && \
+    defined(HB_NO_OT_SHAPE_COMPLEX_USE) && \
+    !defined(HB_NO_OT_SHAPE_COMPLEX_VOWEL_CONSTRAINTS)
+#define HB_NO_OT_SHAPE_COMPLEX_VOWEL_CONSTRAINTS
+#endif
+
+
+#endif /* HB_CONFIG_HH */
@@ -273,6 +273,23 @@ create_ct_font (CGFontRef cg_font, CGFloat font_size)
   return ct_font;
 }
 
+/* Number of CTFonts, of the most recently used sizes, each face keeps for
+ * its fonts to share; creating a CTFont is expensive, and zooming goes
+ * back and forth between a few sizes. */
+#ifndef HB_CORETEXT_CT_FONT_CACHE_SIZE
+#define HB_CORETEXT_CT_FONT_CACHE_SIZE 8
+#endif
+
+struct hb_coretext_face_data_t
+{
+  CGFontRef cg_font;
+
+  hb_mutex_t lock;
+  /* Most recently used first. */
+  unsigned int num_ct_fonts;
+  CTFontRef ct_fonts[HB_CORETEXT_CT_FONT_CACHE_SIZE];
+};
+
 hb_coretext_face_data_t *
 _hb_coretext_shaper_face_data_create (hb_face_t *face)
 {
@@ -284,13 +301,75 @@ _hb_coretext_shaper_face_data_create (hb_face_t *face)
     return nullptr;
   }
 
-  return (hb_coretext_face_data_t *) cg_font;
+  hb_coretext_face_data_t *data = (hb_coretext_face_data_t *) calloc (1, sizeof (hb_coretext_face_data_t));
+  if (unlikely (!data))
+  {
+    CFRelease (cg_font);
+    return nullptr;
+  }
+
+  data->cg_font = cg_font;
+  data->lock.init ();
+  data->num_ct_fonts = 0;
+
+  return data;
 }
 
 void
 _hb_coretext_shaper_face_data_destroy (hb_coretext_face_data_t *data)
 {
-  CFRelease ((CGFontRef) data);
+  for (unsigned int i = 0; i < data->num_ct_fonts; i++)
+    CFRelease (data->ct_fonts[i]);
+  data->lock.fini ();
+  CFRelease (data->cg_font);
+  free (data);
+}
+
+/* Returns a reference to the face's CTFont of font_size, creating it if
+ * the face doesn't have it yet. */
+static CTFontRef
+reference_ct_font (hb_coretext_face_data_t *data, CGFloat font_size)
+{
+  {
+    hb_lock_t l (data->lock);
+    for (unsigned int i = 0; i < data->num_ct_fonts; i++)
+    {
+      CTFontRef ct_font = data->ct_fonts[i];
+      if (CTFontGetSize (ct_font) != font_size)
+	continue;
+      /* Move to front. */
+      memmove (&data->ct_fonts[1], &data->ct_fonts[0], i * sizeof (data->ct_fonts[0]));
+      data->ct_fonts[0] = ct_font;
+      return (CTFontRef) CFRetain (ct_font);
+    }
+  }
+
+  /* Create outside the lock; it is the slow part. */
+  CTFontRef ct_font = create_ct_font (data->cg_font, font_size);
+  if (unlikely (!ct_font))
+    return nullptr;
+
+  CTFontRef evicted = nullptr;
+  {
+    hb_lock_t l (data->lock);
+    /* Another thread may have added the size meanwhile; keep theirs. */
+    for (unsigned int i = 0; i < data->num_ct_fonts; i++)
+      if (CTFontGetSize (data->ct_fonts[i]) == font_size)
+      {
+	CFRelease (ct_font);
+	return (CTFontRef) CFRetain (data->ct_fonts[i]);
+      }
+
+    if (data->num_ct_fonts == HB_CORETEXT_CT_FONT_CACHE_SIZE)
+      evicted = data->ct_fonts[--data->num_ct_fonts];
+    memmove (&data->ct_fonts[1], &data->ct_fonts[0], data->num_ct_fonts * sizeof (data->ct_fonts[0]));
+    data->ct_fonts[0] = (CTFontRef) CFRetain (ct_font);
+    data->num_ct_fonts++;
+  }
+  if (evicted)
+    CFRelease (evicted);
+
+  return ct_font;
 }
 
 hb_face_t *
@@ -305,7 +384,8 @@ hb_coretext_face_create (CGFontRef cg_font)
 CGFontRef
 hb_coretext_face_get_cg_font (hb_face_t *face)
 {
-  return (CGFontRef) (const void *) face->data.coretext;
+  const hb_coretext_face_data_t *data = face->data.coretext;
+  return data ? data->cg_font : nullptr;
 }
 
 
@@ -315,9 +395,9 @@ _hb_coretext_shaper_font_data_create (hb_font_t *font)
   hb_face_t *face = font->face;
   const hb_coretext_face_data_t *face_data = face->data.coretext;
   if (unlikely (!face_data)) return nullptr;
-  CGFontRef cg_font = (CGFontRef) (const void *) face->data.coretext;
 
-  CTFontRef ct_font = create_ct_font (cg_font, coretext_font_size_from_ptem (font->ptem));
+  CTFontRef ct_font = reference_ct_font (const_cast<hb_coretext_face_data_t *> (face_data),
+					 coretext_font_size_from_ptem (font->ptem));
 
   if (unlikely (!ct_font))
   {
@@ -452,7 +532,7 @@ _hb_coretext_shape (hb_shape_plan_t    *shape_plan,
                     unsigned int        num_features)
 {
   hb_face_t *face = font->face;
-  CGFontRef cg_font = (CGFontRef) (const void *) face->data.coretext;
+  CGFontRef cg_font = face->data.coretext->cg_font;
   CTFontRef ct_font = (CTFontRef) hb_coretext_font_data_sync (font);
 
   CGFloat ct_font_size = CTFontGetSize (ct_font);
@@ -129,6 +129,99 @@ public:
 };
 
 
+/*
+ * Process-wide DirectWrite objects
+ *
+ * The factory and the text analyzer are shared by all faces and shape
+ * calls instead of being created for each.
+ */
+
+#if HB_USE_ATEXIT
+static void free_static_dwrite_factory ();
+static void free_static_dwrite_text_analyzer ();
+#endif
+
+static struct hb_dwrite_factory_lazy_loader_t : hb_lazy_loader_t<IDWriteFactory,
+								 hb_dwrite_factory_lazy_loader_t>
+{
+  static IDWriteFactory *create ()
+  {
+    IDWriteFactory *factory = nullptr;
+    if (FAILED (DWriteCreateFactory (DWRITE_FACTORY_TYPE_SHARED, __uuidof (IDWriteFactory),
+				     (IUnknown**) &factory)))
+      return nullptr;
+
+#if HB_USE_ATEXIT
+    atexit (free_static_dwrite_factory);
+#endif
+
+    return factory;
+  }
+  static void destroy (IDWriteFactory *factory)
+  {
+    factory->Release ();
+  }
+  static IDWriteFactory *get_null ()
+  {
+    return nullptr;
+  }
+  static constexpr bool create_once () { return true; }
+} static_dwrite_factory;
+
+static IDWriteFactory *
+get_dwrite_factory ()
+{
+  return static_dwrite_factory.get_unconst ();
+}
+
+static struct hb_dwrite_text_analyzer_lazy_loader_t : hb_lazy_loader_t<IDWriteTextAnalyzer,
+									hb_dwrite_text_analyzer_lazy_loader_t>
+{
+  static IDWriteTextAnalyzer *create ()
+  {
+    IDWriteFactory *factory = get_dwrite_factory ();
+    IDWriteTextAnalyzer *analyzer = nullptr;
+    if (unlikely (!factory) || FAILED (factory->CreateTextAnalyzer (&analyzer)))
+      return nullptr;
+
+#if HB_USE_ATEXIT
+    atexit (free_static_dwrite_text_analyzer);
+#endif
+
+    return analyzer;
+  }
+  static void destroy (IDWriteTextAnalyzer *analyzer)
+  {
+    analyzer->Release ();
+  }
+  static IDWriteTextAnalyzer *get_null ()
+  {
+    return nullptr;
+  }
+  static constexpr bool create_once () { return true; }
+} static_dwrite_text_analyzer;
+
+#if HB_USE_ATEXIT
+static
+void free_static_dwrite_factory ()
+{
+  static_dwrite_factory.free_instance ();
+}
+
+static
+void free_static_dwrite_text_analyzer ()
+{
+  static_dwrite_text_analyzer.free_instance ();
+}
+#endif
+
+static IDWriteTextAnalyzer *
+get_dwrite_text_analyzer ()
+{
+  return static_dwrite_text_analyzer.get_unconst ();
+}
+
+
 /*
 * shaper face data
 */
@@ -150,10 +243,13 @@ _hb_directwrite_shaper_face_data_create (hb_face_t *face)
   if (unlikely (!data))
     return nullptr;
 
-  // TODO: factory and fontFileLoader should be cached separately
-  IDWriteFactory* dwriteFactory;
-  DWriteCreateFactory (DWRITE_FACTORY_TYPE_SHARED, __uuidof (IDWriteFactory),
-		       (IUnknown**) &dwriteFactory);
+  IDWriteFactory* dwriteFactory = get_dwrite_factory ();
+  if (unlikely (!dwriteFactory))
+  {
+    delete data;
+    return nullptr;
+  }
+  dwriteFactory->AddRef ();
 
   HRESULT hr;
   hb_blob_t *blob = hb_face_reference_blob (face);
@@ -520,12 +616,54 @@ _hb_directwrite_shape_full (hb_shape_plan_t    *shape_plan,
 {
   hb_face_t *face = font->face;
   const hb_directwrite_face_data_t *face_data = face->data.directwrite;
-  IDWriteFactory *dwriteFactory = face_data->dwriteFactory;
   IDWriteFontFace *fontFace = face_data->fontFace;
 
-  IDWriteTextAnalyzer* analyzer;
-  dwriteFactory->CreateTextAnalyzer (&analyzer);
+  IDWriteTextAnalyzer* analyzer = get_dwrite_text_analyzer ();
+  if (unlikely (!analyzer))
+    return false;
+
+  // TODO: Handle TEST_DISABLE_OPTIONAL_LIGATURES
+
+  DWRITE_READING_DIRECTION readingDirection;
+  readingDirection = buffer->props.direction ?
+		     DWRITE_READING_DIRECTION_RIGHT_TO_LEFT :
+		     DWRITE_READING_DIRECTION_LEFT_TO_RIGHT;
+
+  bool isRightToLeft = HB_DIRECTION_IS_BACKWARD (buffer->props.direction);
+
+  const wchar_t localeName[20] = {0};
+  if (buffer->props.language != nullptr)
+    mbstowcs ((wchar_t*) localeName,
+	      hb_language_to_string (buffer->props.language), 20);
+
+  // TODO: it does work but doesn't care about ranges
+  DWRITE_TYPOGRAPHIC_FEATURES typographic_features;
+  typographic_features.featureCount = num_features;
+  if (num_features)
+  {
+    typographic_features.features = new DWRITE_FONT_FEATURE[num_features];
+    for (unsigned int i = 0; i < num_features; ++i)
+    {
+      typographic_features.features[i].nameTag = (DWRITE_FONT_FEATURE_TAG)
+						 hb_uint32_swap (features[i].tag);
+      typographic_features.features[i].parameter = features[i].value;
+    }
+  }
+  const DWRITE_TYPOGRAPHIC_FEATURES* dwFeatures;
+  dwFeatures = (const DWRITE_TYPOGRAPHIC_FEATURES*) &typographic_features;
+  //
+
+  HRESULT hr;
+
+#define FAIL(...) \
+  HB_STMT_START { \
+    DEBUG_MSG (DIRECTWRITE, nullptr, __VA_ARGS__); \
+    return false; \
+  } HB_STMT_END;
 
+  /* All per-shape arrays live in the buffer's scratch space; if the
+   * glyphs don't fit, the buffer is grown and everything redone. */
+retry:
   unsigned int scratch_size;
   hb_buffer_t::scratch_buffer_t *scratch = buffer->get_scratch_buffer (&scratch_size);
 #define ALLOCATE_ARRAY(Type, name, len) \
@@ -569,69 +707,43 @@ _hb_directwrite_shape_full (hb_shape_plan_t    *shape_plan,
       log_clusters[chars_len++] = cluster; /* Surrogates. */
   }
 
-  // TODO: Handle TEST_DISABLE_OPTIONAL_LIGATURES
-
-  DWRITE_READING_DIRECTION readingDirection;
-  readingDirection = buffer->props.direction ?
-		     DWRITE_READING_DIRECTION_RIGHT_TO_LEFT :
-		     DWRITE_READING_DIRECTION_LEFT_TO_RIGHT;
-
   /*
   * There's an internal 16-bit limit on some things inside the analyzer,
   * but we never attempt to shape a word longer than 64K characters
   * in a single gfxShapedWord, so we cannot exceed that limit.
   */
   uint32_t textLength = buffer->len;
+  const uint32_t featureRangeLengths[] = { textLength };
 
   TextAnalysis analysis (textString, textLength, nullptr, readingDirection);
   TextAnalysis::Run *runHead;
-  HRESULT hr;
   hr = analysis.GenerateResults (analyzer, &runHead);
 
-#define FAIL(...) \
-  HB_STMT_START { \
-    DEBUG_MSG (DIRECTWRITE, nullptr, __VA_ARGS__); \
-    return false; \
-  } HB_STMT_END;
-
   if (FAILED (hr))
     FAIL ("Analyzer failed to generate results.");
 
-  uint32_t maxGlyphCount = 3 * textLength / 2 + 16;
-  uint32_t glyphCount;
-  bool isRightToLeft = HB_DIRECTION_IS_BACKWARD (buffer->props.direction);
+  ALLOCATE_ARRAY (uint16_t, clusterMap, textLength);
+  ALLOCATE_ARRAY (DWRITE_SHAPING_TEXT_PROPERTIES, textProperties, textLength);
 
-  const wchar_t localeName[20] = {0};
-  if (buffer->props.language != nullptr)
-    mbstowcs ((wchar_t*) localeName,
-	      hb_language_to_string (buffer->props.language), 20);
+  /* The -4 in the following is to compensate for possible
+   * alignment needed after the two 16-bit arrays. */
+  unsigned int glyphs_size = (scratch_size * sizeof (*scratch) - 4)
+			     / (sizeof (uint16_t) +
+				sizeof (DWRITE_SHAPING_GLYPH_PROPERTIES) +
+				sizeof (float) +
+				sizeof (DWRITE_GLYPH_OFFSET) +
+				sizeof (uint32_t));
 
-  // TODO: it does work but doesn't care about ranges
-  DWRITE_TYPOGRAPHIC_FEATURES typographic_features;
-  typographic_features.featureCount = num_features;
-  if (num_features)
-  {
-    typographic_features.features = new DWRITE_FONT_FEATURE[num_features];
-    for (unsigned int i = 0; i < num_features; ++i)
-    {
-      typographic_features.features[i].nameTag = (DWRITE_FONT_FEATURE_TAG)
-						 hb_uint32_swap (features[i].tag);
-      typographic_features.features[i].parameter = features[i].value;
-    }
-  }
-  const DWRITE_TYPOGRAPHIC_FEATURES* dwFeatures;
-  dwFeatures = (const DWRITE_TYPOGRAPHIC_FEATURES*) &typographic_features;
-  const uint32_t featureRangeLengths[] = { textLength };
-  //
+  ALLOCATE_ARRAY (uint16_t, glyphIndices, glyphs_size);
+  ALLOCATE_ARRAY (DWRITE_SHAPING_GLYPH_PROPERTIES, glyphProperties, glyphs_size);
+  ALLOCATE_ARRAY (float, glyphAdvances, glyphs_size);
+  ALLOCATE_ARRAY (DWRITE_GLYPH_OFFSET, glyphOffsets, glyphs_size);
+  ALLOCATE_ARRAY (uint32_t, vis_clusters, glyphs_size);
 
-  uint16_t* clusterMap;
-  clusterMap = new uint16_t[textLength];
-  DWRITE_SHAPING_TEXT_PROPERTIES* textProperties;
-  textProperties = new DWRITE_SHAPING_TEXT_PROPERTIES[textLength];
-retry_getglyphs:
-  uint16_t* glyphIndices = new uint16_t[maxGlyphCount];
-  DWRITE_SHAPING_GLYPH_PROPERTIES* glyphProperties;
-  glyphProperties = new DWRITE_SHAPING_GLYPH_PROPERTIES[maxGlyphCount];
+#undef ALLOCATE_ARRAY
+
+  uint32_t maxGlyphCount = glyphs_size;
+  uint32_t glyphCount;
 
   hr = analyzer->GetGlyphs (textString, textLength, fontFace, false,
 			    isRightToLeft, &runHead->mScript, localeName,
@@ -639,33 +751,18 @@ retry_getglyphs:
 			    maxGlyphCount, clusterMap, textProperties,
 			    glyphIndices, glyphProperties, &glyphCount);
 
-  if (unlikely (hr == HRESULT_FROM_WIN32 (ERROR_INSUFFICIENT_BUFFER)))
+  /* The output has to fit the buffer without it moving, as the glyph
+   * arrays are in its scratch space. */
+  if (unlikely (hr == HRESULT_FROM_WIN32 (ERROR_INSUFFICIENT_BUFFER) ||
+		(SUCCEEDED (hr) && glyphCount >= buffer->allocated)))
   {
-    delete [] glyphIndices;
-    delete [] glyphProperties;
-
-    maxGlyphCount *= 2;
-
-    goto retry_getglyphs;
+    if (unlikely (!buffer->ensure (buffer->allocated * 2)))
+      FAIL ("Buffer resize failed");
+    goto retry;
   }
   if (FAILED (hr))
     FAIL ("Analyzer failed to get glyphs.");
 
-  float* glyphAdvances = new float[maxGlyphCount];
-  DWRITE_GLYPH_OFFSET* glyphOffsets = new DWRITE_GLYPH_OFFSET[maxGlyphCount];
-
-  /* The -2 in the following is to compensate for possible
-   * alignment needed after the WORD array.  sizeof (WORD) == 2. */
-  unsigned int glyphs_size = (scratch_size * sizeof (int) - 2)
-			     / (sizeof (WORD) +
-				sizeof (DWRITE_SHAPING_GLYPH_PROPERTIES) +
-				sizeof (int) +
-				sizeof (DWRITE_GLYPH_OFFSET) +
-				sizeof (uint32_t));
-  ALLOCATE_ARRAY (uint32_t, vis_clusters, glyphs_size);
-
-#undef ALLOCATE_ARRAY
-
   int fontEmSize = font->face->get_upem ();
   if (fontEmSize < 0) fontEmSize = -fontEmSize;
 
@@ -683,8 +780,15 @@ retry_getglyphs:
   if (FAILED (hr))
     FAIL ("Analyzer failed to get glyph placements.");
 
-  IDWriteTextAnalyzer1* analyzer1;
-  analyzer->QueryInterface (&analyzer1);
+  /* Justification replaces the scratch arrays with these. */
+  uint16_t *ownedClusterMap = nullptr;
+  uint16_t *ownedGlyphIndices = nullptr;
+  float *ownedGlyphAdvances = nullptr;
+  DWRITE_GLYPH_OFFSET *ownedGlyphOffsets = nullptr;
+
+  IDWriteTextAnalyzer1* analyzer1 = nullptr;
+  if (lineWidth)
+    analyzer->QueryInterface (&analyzer1);
 
   if (analyzer1 && lineWidth)
   {
@@ -742,31 +846,28 @@ retry_getglyphs:
       if (FAILED (hr))
 	FAIL ("Analyzer failed to get justified glyphs.");
 
-      delete [] clusterMap;
-      delete [] glyphIndices;
-      delete [] glyphAdvances;
-      delete [] glyphOffsets;
-
       glyphCount = actualGlyphsCount;
-      clusterMap = modifiedClusterMap;
-      glyphIndices = modifiedGlyphIndices;
-      glyphAdvances = modifiedGlyphAdvances;
-      glyphOffsets = modifiedGlyphOffsets;
+      clusterMap = ownedClusterMap = modifiedClusterMap;
+      glyphIndices = ownedGlyphIndices = modifiedGlyphIndices;
+      glyphAdvances = ownedGlyphAdvances = modifiedGlyphAdvances;
+      glyphOffsets = ownedGlyphOffsets = modifiedGlyphOffsets;
 
       delete [] justifiedGlyphAdvances;
       delete [] justifiedGlyphOffsets;
     }
     else
     {
-      delete [] glyphAdvances;
-      delete [] glyphOffsets;
-
-      glyphAdvances = justifiedGlyphAdvances;
-      glyphOffsets = justifiedGlyphOffsets;
+      glyphAdvances = ownedGlyphAdvances = justifiedGlyphAdvances;
+      glyphOffsets = ownedGlyphOffsets = justifiedGlyphOffsets;
     }
 
     delete [] justificationOpportunities;
   }
+  if (analyzer1)
+    analyzer1->Release ();
+
+  if (unlikely (glyphCount > glyphs_size || glyphCount >= buffer->allocated))
+    FAIL ("Justified glyphs don't fit the buffer.");
 
   /* Ok, we've got everything we need, now compose output buffer,
    * very, *very*, carefully! */
@@ -821,12 +922,10 @@ retry_getglyphs:
 
   if (isRightToLeft) hb_buffer_reverse (buffer);
 
-  delete [] clusterMap;
-  delete [] glyphIndices;
-  delete [] textProperties;
-  delete [] glyphProperties;
-  delete [] glyphAdvances;
-  delete [] glyphOffsets;
+  delete [] ownedClusterMap;
+  delete [] ownedGlyphIndices;
+  delete [] ownedGlyphAdvances;
+  delete [] ownedGlyphOffsets;
 
   if (num_features)
     delete [] typographic_features.features;
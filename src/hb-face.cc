@@ -89,6 +89,7 @@ DEFINE_NULL_INSTANCE (hb_face_t) =
   0,    /* index */
   HB_ATOMIC_INT_INIT (1000), /* upem */
   HB_ATOMIC_INT_INIT (0),    /* num_glyphs */
+  false, /* trusted */
 
   /* Zero for the rest is fine. */
 };
@@ -125,6 +126,11 @@ hb_face_create_for_tables (hb_reference_table_func_t  reference_table_func,
 
   face->num_glyphs.set_relaxed (-1);
 
+  face->shape_plans.init ();
+  face->lookup_bitmap_budget.set_relaxed (HB_OT_LAYOUT_LOOKUP_BITMAP_BUDGET);
+  face->apply_cache_budget.set_relaxed (HB_OT_LAYOUT_APPLY_CACHE_BUDGET);
+  face->coverage_index_budget.set_relaxed (HB_OT_LAYOUT_COVERAGE_INDEX_BUDGET);
+  face->collect_glyphs_budget.set_relaxed (HB_OT_LAYOUT_COLLECT_GLYPHS_BUDGET);
   face->data.init0 (face);
   face->table.init0 (face);
 
@@ -135,6 +141,14 @@ hb_face_create_for_tables (hb_reference_table_func_t  reference_table_func,
 typedef struct hb_face_for_data_closure_t {
   hb_blob_t *blob;
   unsigned int  index;
+
+  /* Resolved once, so that each table reference is just a lookup. */
+  const OT::OpenTypeFontFace *ot_face;
+  unsigned int base_offset;
+
+  /* Sub-blob of each table, made on first reference and shared after. */
+  unsigned int num_tables;
+  hb_atomic_ptr_t<hb_blob_t> *table_blobs;
 } hb_face_for_data_closure_t;
 
 static hb_face_for_data_closure_t *
@@ -149,6 +163,14 @@ _hb_face_for_data_closure_create (hb_blob_t *blob, unsigned int index)
   closure->blob = blob;
   closure->index = index;
 
+  const OT::OpenTypeFontFile &ot_file = *blob->as<OT::OpenTypeFontFile> ();
+  closure->ot_face = &ot_file.get_face (index, &closure->base_offset);
+  closure->num_tables = closure->ot_face->get_table_count ();
+  closure->table_blobs = (hb_atomic_ptr_t<hb_blob_t> *) calloc (closure->num_tables,
+								sizeof (closure->table_blobs[0]));
+  if (unlikely (!closure->table_blobs))
+    closure->num_tables = 0;
+
   return closure;
 }
 
@@ -157,6 +179,9 @@ _hb_face_for_data_closure_destroy (void *data)
 {
   hb_face_for_data_closure_t *closure = (hb_face_for_data_closure_t *) data;
 
+  for (unsigned int i = 0; i < closure->num_tables; i++)
+    hb_blob_destroy (closure->table_blobs[i].get ());
+  free (closure->table_blobs);
   hb_blob_destroy (closure->blob);
   free (closure);
 }
@@ -169,13 +194,33 @@ _hb_face_for_data_reference_table (hb_face_t *face HB_UNUSED, hb_tag_t tag, void
   if (tag == HB_TAG_NONE)
     return hb_blob_reference (data->blob);
 
-  const OT::OpenTypeFontFile &ot_file = *data->blob->as<OT::OpenTypeFontFile> ();
-  unsigned int base_offset;
-  const OT::OpenTypeFontFace &ot_face = ot_file.get_face (data->index, &base_offset);
+  unsigned int table_index;
+  if (!data->ot_face->find_table_index (tag, &table_index))
+    return hb_blob_get_empty ();
 
-  const OT::OpenTypeTable &table = ot_face.get_table_by_tag (tag);
+  if (table_index < data->num_tables)
+  {
+    hb_blob_t *blob = data->table_blobs[table_index].get ();
+    if (likely (blob))
+      return hb_blob_reference (blob);
+  }
+
+  const OT::OpenTypeTable &table = data->ot_face->get_table (table_index);
+  hb_blob_t *blob = hb_blob_create_sub_blob (data->blob, data->base_offset + table.offset, table.length);
 
-  hb_blob_t *blob = hb_blob_create_sub_blob (data->blob, base_offset + table.offset, table.length);
+  /* Sanitizing edits a copy of immutable blobs, so this one is safe to
+   * hand out again. */
+  if (table_index < data->num_tables && blob != hb_blob_get_empty ())
+  {
+    hb_blob_make_immutable (blob);
+    if (data->table_blobs[table_index].cmpexch (nullptr, blob))
+      hb_blob_reference (blob);
+    else
+    {
+      hb_blob_destroy (blob);
+      blob = hb_blob_reference (data->table_blobs[table_index].get ());
+    }
+  }
 
   return blob;
 }
@@ -259,13 +304,8 @@ hb_face_destroy (hb_face_t *face)
 {
   if (!hb_object_destroy (face)) return;
 
-  for (hb_face_t::plan_node_t *node = face->shape_plans; node; )
-  {
-    hb_face_t::plan_node_t *next = node->next;
-    hb_shape_plan_destroy (node->shape_plan);
-    free (node);
-    node = next;
-  }
+  face->shape_plans.fini ();
+  _hb_indic_position_cache_destroy (face->indic_position_cache.get ());
 
   face->data.fini ();
   face->table.fini ();
@@ -491,6 +531,147 @@ hb_face_get_glyph_count (const hb_face_t *face)
   return face->get_num_glyphs ();
 }
 
+/**
+ * hb_face_set_trusted:
+ * @face: a face.
+ * @trusted: whether the face's tables are known to be valid.
+ *
+ * Marks the tables of @face as already validated, for example when the
+ * font files were checked once at ingest and are immutable afterwards.
+ * Tables of a trusted face are only checked for being long enough for
+ * their fixed-size header; the full sanitizer walk is skipped.
+ *
+ * Never set this for fonts from an untrusted source.  Must be set before
+ * any table is loaded; has no effect on an immutable face.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_face_set_trusted (hb_face_t *face,
+		     hb_bool_t  trusted)
+{
+  if (hb_object_is_immutable (face))
+    return;
+
+  face->trusted = trusted;
+}
+
+/**
+ * hb_face_is_trusted:
+ * @face: a face.
+ *
+ * Return value: whether @face was marked with hb_face_set_trusted().
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_face_is_trusted (const hb_face_t *face)
+{
+  return face->trusted;
+}
+
+/**
+ * hb_face_advise_access:
+ * @face: a face.
+ * @tables: (array length=table_count) (nullable): tags of the tables
+ * about to be accessed, or %NULL for the whole font.
+ * @table_count: number of tags in @tables.
+ * @access: how they will be accessed.
+ *
+ * Passes an access hint for the byte ranges of the given tables on to the
+ * operating system, for example so that a font mapped with
+ * hb_blob_create_from_file() is read in ahead of shaping it on a cold page
+ * cache, instead of one page fault at a time.  This is only a hint; it has
+ * no effect where the system doesn't support it.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_face_advise_access (hb_face_t        *face,
+		       const hb_tag_t   *tables,
+		       unsigned int      table_count,
+		       hb_face_access_t  access)
+{
+  bool sequential = access == HB_FACE_ACCESS_SEQUENTIAL;
+
+  if (!tables)
+  {
+    hb_blob_t *blob = face->reference_table (HB_TAG_NONE);
+    blob->advise (sequential);
+    hb_blob_destroy (blob);
+    return;
+  }
+
+  for (unsigned int i = 0; i < table_count; i++)
+  {
+    hb_blob_t *blob = face->reference_table (tables[i]);
+    blob->advise (sequential);
+    hb_blob_destroy (blob);
+  }
+}
+
+/**
+ * hb_face_warm_up:
+ * @face: a face.
+ * @tables: (array length=table_count) (nullable): tags of the tables to
+ * load, or %NULL for those the first hb_shape() on @face would load.
+ * @table_count: number of tags in @tables.
+ * @executor: (nullable): executor to load tables on, or %NULL.
+ * @user_data: data to pass to @executor.
+ *
+ * Sanitizes and, where HarfBuzz keeps one, builds the accelerator of each
+ * table ahead of time, so that the first request using @face doesn't pay
+ * for it.  Each table is a separate job run through @executor, for
+ * example on a thread pool; pass %NULL to load them one after the other
+ * on the calling thread.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_face_warm_up (hb_face_t          *face,
+		 const hb_tag_t     *tables,
+		 unsigned int        table_count,
+		 hb_executor_func_t  executor,
+		 void               *user_data)
+{
+  if (unlikely (hb_object_is_inert (face)))
+    return;
+
+  face->table.warm_up (tables, table_count, executor, user_data);
+}
+
+/**
+ * hb_face_trim:
+ * @face: a face.
+ *
+ * Releases memory @face holds that it can rebuild: cached shape plans,
+ * most table accelerators, and the caches of those that fonts and shape
+ * plans created from @face still point to.  @face stays usable; what was
+ * released is rebuilt as it is needed again.  Useful for long-lived faces
+ * of an application under memory pressure.
+ *
+ * Unlike most face functions, this is not thread-safe: no other thread
+ * may be using @face, or fonts and shape plans created from it, during
+ * the call.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_face_trim (hb_face_t *face)
+{
+  if (unlikely (hb_object_is_inert (face)))
+    return;
+
+  face->shape_plans.clear ();
+  face->table.trim ();
+
+  /* What the layout caches were charged for is free again. */
+  face->lookup_bitmap_budget.set_relaxed (HB_OT_LAYOUT_LOOKUP_BITMAP_BUDGET);
+  face->apply_cache_budget.set_relaxed (HB_OT_LAYOUT_APPLY_CACHE_BUDGET);
+  face->coverage_index_budget.set_relaxed (HB_OT_LAYOUT_COVERAGE_INDEX_BUDGET);
+  face->collect_glyphs_budget.set_relaxed (HB_OT_LAYOUT_COLLECT_GLYPHS_BUDGET);
+}
+
 /**
  * hb_face_get_table_tags:
  * @face: a face.
@@ -525,6 +706,80 @@ hb_face_get_table_tags (const hb_face_t *face,
   return ot_face.get_table_tags (start_offset, table_count, table_tags);
 }
 
+/**
+ * hb_face_get_memory_usage:
+ * @face: a face.
+ * @subsystem: which part of @face to report on.
+ * @mapped_bytes: (out) (optional): font data referenced by @subsystem.
+ *
+ * Reports how much memory a part of @face is holding.  Heap bytes are what
+ * HarfBuzz allocated itself; mapped bytes are font data it only refers to,
+ * whether that lives in a file mapping or in memory owned by the caller.
+ * Tables HarfBuzz had to make a private copy of count as heap.
+ *
+ * Only what has been loaded so far is counted.  Tables are sub-ranges of
+ * the font blob, so mapped bytes of different subsystems can overlap.
+ * Data private to shapers other than the OpenType one is not counted.
+ *
+ * Return value: bytes of heap memory held by @subsystem.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_face_get_memory_usage (hb_face_t                  *face,
+			  hb_face_memory_subsystem_t  subsystem,
+			  unsigned int               *mapped_bytes /* OUT */)
+{
+  hb_memory_usage_t usage = {0, 0};
+
+  if (unlikely (hb_object_is_inert (face)))
+  {
+    if (mapped_bytes) *mapped_bytes = 0;
+    return 0;
+  }
+
+  switch (subsystem)
+  {
+    case HB_FACE_MEMORY_OBJECT:
+      usage.heap += sizeof (*face);
+      if (face->destroy == (hb_destroy_func_t) _hb_face_for_data_closure_destroy)
+      {
+	const hb_face_for_data_closure_t *closure = (const hb_face_for_data_closure_t *) face->user_data;
+	usage.heap += sizeof (*closure);
+	usage.heap += closure->num_tables * sizeof (closure->table_blobs[0]);
+	for (unsigned int i = 0; i < closure->num_tables; i++)
+	  if (closure->table_blobs[i].get_relaxed ())
+	    usage.heap += sizeof (hb_blob_t);
+	usage.add_blob (closure->blob);
+      }
+      break;
+
+    case HB_FACE_MEMORY_TABLES:
+    {
+      hb_memory_usage_t accelerators = {0, 0};
+      face->table.add_memory_usage (&usage, &accelerators);
+      break;
+    }
+
+    case HB_FACE_MEMORY_ACCELERATORS:
+    {
+      hb_memory_usage_t tables = {0, 0};
+      face->table.add_memory_usage (&tables, &usage);
+      break;
+    }
+
+    case HB_FACE_MEMORY_SHAPE_PLANS:
+      face->shape_plans.add_memory_usage (&usage);
+      break;
+
+    default:
+      break;
+  }
+
+  if (mapped_bytes) *mapped_bytes = usage.mapped;
+  return usage.heap;
+}
+
 
 /*
  * Character set.
@@ -545,6 +800,31 @@ hb_face_collect_unicodes (hb_face_t *face,
   face->table.cmap->collect_unicodes (out);
 }
 
+/**
+ * hb_face_covers_unicodes:
+ * @face: font face.
+ * @count: number of code points to check.
+ * @first_unicode: (array length=count): the first code point.
+ * @unicode_stride: byte distance between consecutive code points.
+ *
+ * Checks which of a run of code points @face maps to a glyph, for font
+ * fallback.  The face's coverage is built on first use and shared by all
+ * later calls, so checking a character is a bit lookup.
+ *
+ * Return value: the number of code points at the start of the run that
+ * @face covers; @count if it covers all of them.
+ *
+ * Since: REPLACEME
+ */
+unsigned int
+hb_face_covers_unicodes (hb_face_t            *face,
+			 unsigned int          count,
+			 const hb_codepoint_t *first_unicode,
+			 unsigned int          unicode_stride)
+{
+  return face->table.cmap->get_covered_prefix (count, first_unicode, unicode_stride);
+}
+
 /**
  * hb_face_collect_variation_selectors:
  * @face: font face.
@@ -599,6 +879,12 @@ struct hb_face_builder_data_t
     hb_blob_t *blob;
   };
 
+  hb_tag_t get_sfnt_tag ()
+  {
+    bool is_cff = tables.lsearch (HB_TAG ('C','F','F',' ')) || tables.lsearch (HB_TAG ('C','F','F','2'));
+    return is_cff ? OT::OpenTypeFontFile::CFFTag : OT::OpenTypeFontFile::TrueTypeTag;
+  }
+
   hb_vector_t<table_entry_t> tables;
 };
 
@@ -645,10 +931,7 @@ _hb_face_builder_data_reference_blob (hb_face_builder_data_t *data)
   c.propagate_error (data->tables);
   OT::OpenTypeFontFile *f = c.start_serialize<OT::OpenTypeFontFile> ();
 
-  bool is_cff = data->tables.lsearch (HB_TAG ('C','F','F',' ')) || data->tables.lsearch (HB_TAG ('C','F','F','2'));
-  hb_tag_t sfnt_tag = is_cff ? OT::OpenTypeFontFile::CFFTag : OT::OpenTypeFontFile::TrueTypeTag;
-
-  bool ret = f->serialize_single (&c, sfnt_tag, data->tables.as_array ());
+  bool ret = f->serialize_single (&c, data->get_sfnt_tag (), data->tables.as_array ());
 
   c.end_serialize ();
 
@@ -721,3 +1004,186 @@ hb_face_builder_add_table (hb_face_t *face, hb_tag_t tag, hb_blob_t *blob)
 
   return true;
 }
+
+/* Collects, in output order, blobs that concatenate to the compiled
+ * font: the table directory, then each table followed by its padding.
+ * Tables are referenced, not copied, except head, whose checksum
+ * adjustment is patched into a copy. */
+static bool
+_hb_face_builder_data_collect_blobs (hb_face_builder_data_t *data,
+				     hb_vector_t<hb_blob_t *> &blobs)
+{
+  unsigned int table_count = data->tables.length;
+  unsigned int dir_length = table_count * 16 + 12;
+
+  /* Reserve up front so that pushing below cannot fail and leak a blob. */
+  if (unlikely (!blobs.alloc (1 + 2 * table_count)))
+    return false;
+
+  char *buf = (char *) malloc (dir_length);
+  if (unlikely (!buf))
+    return false;
+
+  hb_serialize_context_t c (buf, dir_length);
+  c.propagate_error (data->tables);
+  OT::OpenTypeFontFile *f = c.start_serialize<OT::OpenTypeFontFile> ();
+  uint32_t checksum_adjustment = 0;
+  bool has_adjustment = false;
+  hb_array_t<hb_face_builder_data_t::table_entry_t> items = data->tables.as_array ();
+  for (unsigned int i = 0; i < table_count; i++)
+    if (items[i].tag == HB_TAG ('h','e','a','d') &&
+	hb_ceil_to_4 (hb_blob_get_length (items[i].blob)) >= OT::head::static_size)
+      has_adjustment = true;
+  bool ret = f->serialize_single_directory (&c, data->get_sfnt_tag (), items, &checksum_adjustment);
+  c.end_serialize ();
+
+  if (unlikely (!ret))
+  {
+    free (buf);
+    return false;
+  }
+  blobs.push (hb_blob_create (buf, dir_length, HB_MEMORY_MODE_WRITABLE, buf, free));
+
+  static const char padding[3] = {0};
+  for (unsigned int i = 0; i < table_count; i++)
+  {
+    unsigned int length;
+    const char *table = hb_blob_get_data (items[i].blob, &length);
+
+    if (has_adjustment && items[i].tag == HB_TAG ('h','e','a','d'))
+    {
+      /* Patch checkSumAdjustment into a copy; head is small. */
+      char *head = (char *) malloc (length);
+      if (unlikely (!head))
+	return false;
+      memcpy (head, table, length);
+      * (OT::HBUINT32 *) (head + 8) = checksum_adjustment;
+      blobs.push (hb_blob_create (head, length, HB_MEMORY_MODE_WRITABLE, head, free));
+    }
+    else
+      blobs.push (hb_blob_reference (items[i].blob));
+
+    if (length & 3)
+      blobs.push (hb_blob_create (padding, 4 - (length & 3), HB_MEMORY_MODE_READONLY, nullptr, nullptr));
+  }
+
+  return true;
+}
+
+static void
+_hb_face_builder_blobs_destroy (hb_vector_t<hb_blob_t *> &blobs)
+{
+  for (unsigned int i = 0; i < blobs.length; i++)
+    hb_blob_destroy (blobs[i]);
+  blobs.fini ();
+}
+
+/**
+ * hb_face_builder_write:
+ * @face: a face created with hb_face_builder_create().
+ * @func: (closure user_data) (scope call): function to write bytes with.
+ * @user_data: data to pass to @func.
+ *
+ * Compiles the tables of @face to a binary font file, like
+ * hb_face_reference_blob() does, but writes it out through @func piece
+ * by piece instead of building it in memory first.  For a face returned
+ * by hb_subset() this avoids holding a second copy of the whole subset
+ * font.  The bytes written are identical to the blob's.
+ *
+ * Return value: %true if the whole font was written; %false if @face is
+ * not a face builder or @func failed.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_face_builder_write (hb_face_t            *face,
+		       hb_face_write_func_t  func,
+		       void                 *user_data)
+{
+  if (unlikely (face->destroy != (hb_destroy_func_t) _hb_face_builder_data_destroy))
+    return false;
+
+  hb_face_builder_data_t *data = (hb_face_builder_data_t *) face->user_data;
+  hb_vector_t<hb_blob_t *> blobs;
+  bool ret = _hb_face_builder_data_collect_blobs (data, blobs);
+
+  for (unsigned int i = 0; ret && i < blobs.length; i++)
+  {
+    unsigned int length;
+    const char *bytes = hb_blob_get_data (blobs[i], &length);
+    if (length)
+      ret = func (bytes, length, user_data);
+  }
+
+  _hb_face_builder_blobs_destroy (blobs);
+  return ret;
+}
+
+/**
+ * hb_face_builder_get_blobs:
+ * @face: a face created with hb_face_builder_create().
+ * @start_offset: index of the first blob to return.
+ * @blob_count: (inout) (optional): input length of @blobs array, output
+ * number of blobs written.
+ * @blobs: (out) (array length=blob_count) (transfer full): array to
+ * write blobs into.
+ *
+ * Retrieves the compiled font of @face as a scatter list: blobs that,
+ * concatenated in order, give the bytes of hb_face_reference_blob().
+ * Tables added to the builder are returned by reference rather than
+ * copied, so tables a subset keeps unchanged still point into the
+ * source font's data; a writer can hand the list to writev() or similar
+ * without assembling the font first.  The caller must destroy each blob
+ * written.
+ *
+ * Return value: total number of blobs, or 0 if @face is not a face
+ * builder or compiling it failed.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_face_builder_get_blobs (hb_face_t    *face,
+			   unsigned int  start_offset,
+			   unsigned int *blob_count, /* IN/OUT */
+			   hb_blob_t   **blobs /* OUT */)
+{
+  hb_vector_t<hb_blob_t *> all;
+  if (unlikely (face->destroy != (hb_destroy_func_t) _hb_face_builder_data_destroy ||
+		!_hb_face_builder_data_collect_blobs ((hb_face_builder_data_t *) face->user_data, all)))
+  {
+    _hb_face_builder_blobs_destroy (all);
+    if (blob_count)
+      *blob_count = 0;
+    return 0;
+  }
+
+  if (blob_count)
+  {
+    hb_array_t<hb_blob_t *> arr = all.as_array ().sub_array (start_offset, blob_count);
+    for (unsigned int i = 0; i < arr.length; i++)
+      blobs[i] = hb_blob_reference (arr[i]);
+  }
+
+  unsigned int total = all.length;
+  _hb_face_builder_blobs_destroy (all);
+  return total;
+}
+
+bool
+hb_face_builder_append_tables (hb_face_t *dest, hb_face_t *src)
+{
+  if (unlikely (dest->destroy != (hb_destroy_func_t) _hb_face_builder_data_destroy ||
+		src->destroy != (hb_destroy_func_t) _hb_face_builder_data_destroy))
+    return false;
+
+  hb_face_builder_data_t *dest_data = (hb_face_builder_data_t *) dest->user_data;
+  hb_face_builder_data_t *src_data = (hb_face_builder_data_t *) src->user_data;
+  if (unlikely (!dest_data->tables.alloc (dest_data->tables.length + src_data->tables.length)))
+    return false;
+
+  for (unsigned int i = 0; i < src_data->tables.length; i++)
+    *dest_data->tables.push () = src_data->tables[i];
+  src_data->tables.resize (0);
+
+  return true;
+}
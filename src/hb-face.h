@@ -115,12 +115,77 @@ hb_face_set_glyph_count (hb_face_t    *face,
 HB_EXTERN unsigned int
 hb_face_get_glyph_count (const hb_face_t *face);
 
+HB_EXTERN void
+hb_face_set_trusted (hb_face_t *face,
+		     hb_bool_t  trusted);
+
+HB_EXTERN hb_bool_t
+hb_face_is_trusted (const hb_face_t *face);
+
+/**
+ * hb_face_access_t:
+ * @HB_FACE_ACCESS_WILL_NEED: the tables will be read soon, in no
+ * particular order, as when shaping.
+ * @HB_FACE_ACCESS_SEQUENTIAL: the tables will be read once, front to
+ * back, as when subsetting the whole font.
+ *
+ * How the data of a face is about to be accessed.
+ *
+ * Since: REPLACEME
+ **/
+typedef enum {
+  HB_FACE_ACCESS_WILL_NEED,
+  HB_FACE_ACCESS_SEQUENTIAL
+} hb_face_access_t;
+
+HB_EXTERN void
+hb_face_advise_access (hb_face_t        *face,
+		       const hb_tag_t   *tables,
+		       unsigned int      table_count,
+		       hb_face_access_t  access);
+
+HB_EXTERN void
+hb_face_warm_up (hb_face_t          *face,
+		 const hb_tag_t     *tables,
+		 unsigned int        table_count,
+		 hb_executor_func_t  executor,
+		 void               *user_data);
+
+HB_EXTERN void
+hb_face_trim (hb_face_t *face);
+
 HB_EXTERN unsigned int
 hb_face_get_table_tags (const hb_face_t *face,
 			unsigned int  start_offset,
 			unsigned int *table_count, /* IN/OUT */
 			hb_tag_t     *table_tags /* OUT */);
 
+/**
+ * hb_face_memory_subsystem_t:
+ * @HB_FACE_MEMORY_OBJECT: the face itself and, for faces made with
+ * hb_face_create(), its copy of the font table directory and the font
+ * blob.
+ * @HB_FACE_MEMORY_TABLES: the tables loaded so far.
+ * @HB_FACE_MEMORY_ACCELERATORS: the lookup structures built on top of
+ * the loaded tables.
+ * @HB_FACE_MEMORY_SHAPE_PLANS: the shape plans cached on the face.
+ *
+ * Parts of a face whose memory use hb_face_get_memory_usage() reports.
+ *
+ * Since: REPLACEME
+ **/
+typedef enum {
+  HB_FACE_MEMORY_OBJECT,
+  HB_FACE_MEMORY_TABLES,
+  HB_FACE_MEMORY_ACCELERATORS,
+  HB_FACE_MEMORY_SHAPE_PLANS
+} hb_face_memory_subsystem_t;
+
+HB_EXTERN unsigned int
+hb_face_get_memory_usage (hb_face_t                  *face,
+			  hb_face_memory_subsystem_t  subsystem,
+			  unsigned int               *mapped_bytes /* OUT */);
+
 
 /*
  * Character set.
@@ -130,6 +195,12 @@ HB_EXTERN void
 hb_face_collect_unicodes (hb_face_t *face,
 			  hb_set_t  *out);
 
+HB_EXTERN unsigned int
+hb_face_covers_unicodes (hb_face_t            *face,
+			 unsigned int          count,
+			 const hb_codepoint_t *first_unicode,
+			 unsigned int          unicode_stride);
+
 HB_EXTERN void
 hb_face_collect_variation_selectors (hb_face_t *face,
 				     hb_set_t  *out);
@@ -152,6 +223,30 @@ hb_face_builder_add_table (hb_face_t *face,
 			   hb_tag_t   tag,
 			   hb_blob_t *blob);
 
+/**
+ * hb_face_write_func_t:
+ * @data: bytes to write.
+ * @length: number of bytes.
+ * @user_data: user data passed to hb_face_builder_write().
+ *
+ * Return value: %true if all @length bytes were written.
+ *
+ * Since: REPLACEME
+ **/
+typedef hb_bool_t (*hb_face_write_func_t) (const char   *data,
+					   unsigned int  length,
+					   void         *user_data);
+
+HB_EXTERN hb_bool_t
+hb_face_builder_write (hb_face_t            *face,
+		       hb_face_write_func_t  func,
+		       void                 *user_data);
+
+HB_EXTERN unsigned int
+hb_face_builder_get_blobs (hb_face_t    *face,
+			   unsigned int  start_offset,
+			   unsigned int *blob_count, /* IN/OUT */
+			   hb_blob_t   **blobs /* OUT */);
 
 HB_END_DECLS
 
@@ -40,10 +40,41 @@
  * hb_face_t
  */
 
+#ifndef HB_OT_LAYOUT_LOOKUP_BITMAP_BUDGET
+/* Bytes per face that lookup accelerators may spend on exact coverage bitmaps. */
+#define HB_OT_LAYOUT_LOOKUP_BITMAP_BUDGET (256 * 1024)
+#endif
+
+#ifndef HB_OT_LAYOUT_APPLY_CACHE_BUDGET
+/* Bytes per face that subtables may spend on their apply caches, like
+ * ligature set indices and glyph class caches. */
+#define HB_OT_LAYOUT_APPLY_CACHE_BUDGET (512 * 1024)
+#endif
+
+#ifndef HB_OT_LAYOUT_COVERAGE_INDEX_BUDGET
+/* Bytes per face that subtables may spend on native copies of their
+ * large coverages; see hb_coverage_index_t. */
+#define HB_OT_LAYOUT_COVERAGE_INDEX_BUDGET (256 * 1024)
+#endif
+
+#ifndef HB_OT_LAYOUT_COVERAGE_INDEX_MIN_GLYPHS
+/* Coverages with fewer glyphs are searched in place. */
+#define HB_OT_LAYOUT_COVERAGE_INDEX_MIN_GLYPHS 128
+#endif
+
+#ifndef HB_OT_LAYOUT_COLLECT_GLYPHS_BUDGET
+/* Bytes per face that may be spent remembering the glyphs
+ * hb_ot_layout_lookup_collect_glyphs() found for each lookup. */
+#define HB_OT_LAYOUT_COLLECT_GLYPHS_BUDGET (1024 * 1024)
+#endif
+
 #define HB_SHAPER_IMPLEMENT(shaper) HB_SHAPER_DATA_INSTANTIATE_SHAPERS(shaper, face);
 #include "hb-shaper-list.hh"
 #undef HB_SHAPER_IMPLEMENT
 
+struct indic_position_cache_t;
+HB_INTERNAL void _hb_indic_position_cache_destroy (indic_position_cache_t *cache);
+
 struct hb_face_t
 {
   hb_object_header_t header;
@@ -55,17 +86,20 @@ struct hb_face_t
   unsigned int index;			/* Face index in a collection, zero-based. */
   mutable hb_atomic_int_t upem;		/* Units-per-EM. */
   mutable hb_atomic_int_t num_glyphs;	/* Number of glyphs. */
+  bool trusted;				/* Tables were validated elsewhere; don't sanitize. */
 
   hb_shaper_object_dataset_t<hb_face_t> data;/* Various shaper data. */
   hb_ot_face_t table;			/* All the face's tables. */
 
   /* Cache */
-  struct plan_node_t
-  {
-    hb_shape_plan_t *shape_plan;
-    plan_node_t *next;
-  };
-  hb_atomic_ptr_t<plan_node_t> shape_plans;
+  hb_shape_plan_cache_t shape_plans;
+  mutable hb_atomic_int_t lookup_bitmap_budget; /* Bytes left for lookup glyph bitmaps. */
+  mutable hb_atomic_int_t apply_cache_budget; /* Bytes left for subtable apply caches. */
+  mutable hb_atomic_int_t coverage_index_budget; /* Bytes left for subtable coverage indices. */
+  mutable hb_atomic_int_t collect_glyphs_budget; /* Bytes left for collected lookup glyphs. */
+  mutable hb_atomic_int_t layout_checksum; /* Of GSUB and GPOS; 0 if not computed yet. */
+  mutable hb_atomic_int_t default_shaper; /* See hb_shape_plan_key_t::init(); 0 if not chosen yet. */
+  mutable hb_atomic_ptr_t<indic_position_cache_t> indic_position_cache; /* Created on first use. */
 
   hb_blob_t *reference_table (hb_tag_t tag) const
   {
@@ -99,11 +133,25 @@ struct hb_face_t
     return ret;
   }
 
+  /* Identifies the GSUB and GPOS tables serialized shape plans depend on. */
+  unsigned int get_layout_checksum () const
+  {
+    unsigned int ret = layout_checksum.get_relaxed ();
+    if (unlikely (!ret))
+      return load_layout_checksum ();
+    return ret;
+  }
+
   private:
   HB_INTERNAL unsigned int load_upem () const;
   HB_INTERNAL unsigned int load_num_glyphs () const;
+  HB_INTERNAL unsigned int load_layout_checksum () const;
 };
 DECLARE_NULL_INSTANCE (hb_face_t);
 
+/* Moves the tables of face-builder @src to the end of face-builder @dest. */
+HB_INTERNAL bool
+hb_face_builder_append_tables (hb_face_t *dest, hb_face_t *src);
+
 
 #endif /* HB_FACE_HH */
@@ -0,0 +1,711 @@
+/*
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb-font-cache.hh"
+#include "hb-face.hh"
+#include "hb-font.hh"
+
+
+/**
+ * SECTION:hb-font-cache
+ * @title: hb-font-cache
+ * @short_description: Sharing faces and fonts across threads
+ * @include: hb.h
+ *
+ * A font cache hands out faces loaded from font files, and fonts made of
+ * faces, reusing the ones it handed out before.  It is safe to use from
+ * several threads at once; it is split into separately locked shards,
+ * so that lookups rarely wait for each other.
+ *
+ * The cache keeps the memory its faces and fonts hold, as reported by
+ * hb_face_get_memory_usage() and hb_font_get_memory_usage(), under a
+ * limit by dropping the least recently used ones.  Faces and fonts are
+ * warmed up before they go into the cache, so that the first shaping
+ * with them is not slower than the rest, and their size is known.
+ **/
+
+
+static_assert (0 == (HB_FONT_CACHE_SHARDS & (HB_FONT_CACHE_SHARDS - 1)), "");
+
+
+/* hb_font_cache_t::node_t */
+
+bool
+hb_font_cache_t::node_t::key_equal (const node_t *key) const
+{
+  if (hash != key->hash || !file_name != !key->file_name)
+    return false;
+
+  if (file_name)
+    return index == key->index && 0 == strcmp (file_name, key->file_name);
+
+  return face == key->face &&
+	 x_scale == key->x_scale &&
+	 y_scale == key->y_scale &&
+	 num_variations == key->num_variations &&
+	 0 == hb_memcmp (variations, key->variations,
+			 num_variations * sizeof (variations[0]));
+}
+
+void
+hb_font_cache_t::node_t::measure ()
+{
+  if (font)
+  {
+    bytes = hb_font_get_memory_usage (font);
+    return;
+  }
+
+  /* The font data counts once; tables are parts of it. */
+  unsigned int mapped;
+  bytes = hb_face_get_memory_usage (face, HB_FACE_MEMORY_OBJECT, &mapped) + mapped;
+  bytes += hb_face_get_memory_usage (face, HB_FACE_MEMORY_TABLES, nullptr);
+  bytes += hb_face_get_memory_usage (face, HB_FACE_MEMORY_ACCELERATORS, nullptr);
+  bytes += hb_face_get_memory_usage (face, HB_FACE_MEMORY_SHAPE_PLANS, nullptr);
+}
+
+
+/* hb_font_cache_t::shard_t */
+
+hb_font_cache_t::node_t *
+hb_font_cache_t::shard_t::find (const node_t *key) const
+{
+  for (node_t *node = head; node; node = node->next)
+    if (node->key_equal (key))
+      return node;
+  return nullptr;
+}
+
+void
+hb_font_cache_t::shard_t::promote (node_t *node)
+{
+  if (node == head) return;
+  unlink (node);
+  link (node);
+}
+
+void
+hb_font_cache_t::shard_t::link (node_t *node)
+{
+  node->prev = nullptr;
+  node->next = head;
+  if (head)
+    head->prev = node;
+  else
+    tail = node;
+  head = node;
+  count++;
+}
+
+void
+hb_font_cache_t::shard_t::unlink (node_t *node)
+{
+  if (node->prev)
+    node->prev->next = node->next;
+  else
+    head = node->next;
+  if (node->next)
+    node->next->prev = node->prev;
+  else
+    tail = node->prev;
+  count--;
+}
+
+
+/* hb_font_cache_t */
+
+void
+hb_font_cache_t::init (unsigned int max_bytes_)
+{
+  max_bytes.set_relaxed ((int) max_bytes_);
+  bytes.set_relaxed (0);
+  for (unsigned int i = 0; i < HB_FONT_CACHE_SHARDS; i++)
+  {
+    shards[i].lock.init ();
+    shards[i].head = shards[i].tail = nullptr;
+    shards[i].count = 0;
+    shards[i].hits = shards[i].misses = shards[i].evictions = 0;
+  }
+}
+
+void
+hb_font_cache_t::fini ()
+{
+  clear ();
+  for (unsigned int i = 0; i < HB_FONT_CACHE_SHARDS; i++)
+    shards[i].lock.fini ();
+}
+
+void
+hb_font_cache_t::destroy_node (node_t *node)
+{
+  if (node->font)
+    hb_font_destroy (node->font);
+  else
+    hb_face_destroy (node->face);
+  free (node->file_name);
+  free (node->variations);
+  free (node);
+}
+
+void *
+hb_font_cache_t::reference (node_t *node)
+{
+  if (node->font)
+    return hb_font_reference (node->font);
+  return hb_face_reference (node->face);
+}
+
+void *
+hb_font_cache_t::lookup (const node_t *key)
+{
+  shard_t &shard = get_shard (key->hash);
+  void *ret;
+  {
+    hb_lock_t l (shard.lock);
+
+    node_t *node = shard.find (key);
+    if (!node)
+    {
+      shard.misses++;
+      return nullptr;
+    }
+
+    shard.hits++;
+    shard.promote (node);
+    ret = reference (node);
+  }
+
+  /* Faces load more data while in use; catch up with that. */
+  remeasure (key, ret);
+  return ret;
+}
+
+void
+hb_font_cache_t::remeasure (const node_t *key, const void *object)
+{
+  /* Measure outside the lock; the reference held on object keeps it alive. */
+  node_t measured = {};
+  if (key->file_name)
+    measured.face = (hb_face_t *) object;
+  else
+    measured.font = (hb_font_t *) object;
+  measured.measure ();
+
+  shard_t &shard = get_shard (key->hash);
+  {
+    hb_lock_t l (shard.lock);
+
+    /* Objects are unique while referenced, so a node holding object is
+     * still the one that was found. */
+    node_t *node = shard.find (key);
+    if (!node || (node->font ? (void *) node->font : (void *) node->face) != object)
+      return;
+    bytes.add ((int) (measured.bytes - node->bytes));
+    node->bytes = measured.bytes;
+  }
+
+  evict (&shard - shards, nullptr);
+}
+
+void *
+hb_font_cache_t::insert (node_t *node)
+{
+  shard_t &shard = get_shard (node->hash);
+  node_t *found;
+  void *ret;
+  {
+    hb_lock_t l (shard.lock);
+
+    found = shard.find (node);
+    if (!found)
+    {
+      bytes.add ((int) node->bytes);
+      shard.link (node);
+    }
+    else
+      shard.promote (found);
+
+    ret = reference (found ? found : node);
+  }
+
+  if (found)
+    destroy_node (node);
+  else
+    evict (&shard - shards, node);
+  return ret;
+}
+
+void
+hb_font_cache_t::evict (unsigned int start, const node_t *keep)
+{
+  node_t *evicted = nullptr;
+  for (unsigned int i = 0; i < HB_FONT_CACHE_SHARDS && over_budget (); i++)
+  {
+    shard_t &shard = shards[(start + i) & (HB_FONT_CACHE_SHARDS - 1)];
+    hb_lock_t l (shard.lock);
+
+    node_t *node = shard.tail;
+    while (node && over_budget ())
+    {
+      node_t *prev = node->prev;
+      if (node != keep)
+      {
+	shard.unlink (node);
+	shard.evictions++;
+	bytes.add (-(int) node->bytes);
+	node->next = evicted;
+	evicted = node;
+      }
+      node = prev;
+    }
+  }
+
+  /* Destroy outside the locks; faces can take a while. */
+  while (evicted)
+  {
+    node_t *next = evicted->next;
+    destroy_node (evicted);
+    evicted = next;
+  }
+}
+
+hb_face_t *
+hb_font_cache_t::get_face (const char *file_name, unsigned int index)
+{
+  node_t key = {};
+  key.file_name = const_cast<char *> (file_name);
+  key.index = index;
+  key.hash = hb_bytes_t (file_name, strlen (file_name)).hash () * 31 + hb_hash (index);
+
+  hb_face_t *face = (hb_face_t *) lookup (&key);
+  if (face)
+    return face;
+
+  hb_blob_t *blob = hb_blob_create_from_file (file_name);
+  if (unlikely (!hb_blob_get_length (blob)))
+  {
+    hb_blob_destroy (blob);
+    return hb_face_get_empty ();
+  }
+  face = hb_face_create (blob, index);
+  hb_blob_destroy (blob);
+  hb_face_make_immutable (face);
+  hb_face_warm_up (face, nullptr, 0, nullptr, nullptr);
+
+  unsigned int len = strlen (file_name) + 1;
+  node_t *node = (node_t *) calloc (1, sizeof (node_t));
+  if (unlikely (!node || !(node->file_name = (char *) malloc (len))))
+  {
+    free (node);
+    return face;
+  }
+  memcpy (node->file_name, file_name, len);
+  node->hash = key.hash;
+  node->index = index;
+  node->face = face;
+  node->measure ();
+
+  return (hb_face_t *) insert (node);
+}
+
+hb_font_t *
+hb_font_cache_t::get_font (hb_face_t *face,
+			   int x_scale, int y_scale,
+			   const hb_variation_t *variations,
+			   unsigned int num_variations)
+{
+  if (!variations)
+    num_variations = 0;
+
+  node_t key = {};
+  key.face = face;
+  key.x_scale = x_scale;
+  key.y_scale = y_scale;
+  key.variations = const_cast<hb_variation_t *> (variations);
+  key.num_variations = num_variations;
+  uint32_t hash = hb_hash ((uintptr_t) face);
+  hash = hash * 31 + hb_hash ((unsigned int) x_scale);
+  hash = hash * 31 + hb_hash ((unsigned int) y_scale);
+  for (unsigned int i = 0; i < num_variations; i++)
+  {
+    uint32_t value;
+    memcpy (&value, &variations[i].value, sizeof (value));
+    hash = hash * 31 + hb_hash (variations[i].tag);
+    hash = hash * 31 + hb_hash (value);
+  }
+  key.hash = hash;
+
+  hb_font_t *font = (hb_font_t *) lookup (&key);
+  if (font)
+    return font;
+
+  font = hb_font_create (face);
+  hb_font_set_scale (font, x_scale, y_scale);
+  if (num_variations)
+    hb_font_set_variations (font, variations, num_variations);
+  hb_font_make_immutable (font);
+  hb_face_warm_up (face, nullptr, 0, nullptr, nullptr);
+
+  node_t *node = (node_t *) calloc (1, sizeof (node_t));
+  if (unlikely (!node))
+    return font;
+  if (num_variations &&
+      unlikely (!(node->variations = (hb_variation_t *) malloc (num_variations * sizeof (variations[0])))))
+  {
+    free (node);
+    return font;
+  }
+  if (num_variations)
+    memcpy (node->variations, variations, num_variations * sizeof (variations[0]));
+  node->hash = hash;
+  node->font = font;
+  node->face = face;
+  node->x_scale = x_scale;
+  node->y_scale = y_scale;
+  node->num_variations = num_variations;
+  node->measure ();
+
+  return (hb_font_t *) insert (node);
+}
+
+void
+hb_font_cache_t::clear ()
+{
+  for (unsigned int i = 0; i < HB_FONT_CACHE_SHARDS; i++)
+  {
+    shard_t &shard = shards[i];
+    node_t *node;
+    {
+      hb_lock_t l (shard.lock);
+      node = shard.head;
+      for (node_t *n = node; n; n = n->next)
+	bytes.add (-(int) n->bytes);
+      shard.head = shard.tail = nullptr;
+      shard.count = 0;
+    }
+
+    while (node)
+    {
+      node_t *next = node->next;
+      destroy_node (node);
+      node = next;
+    }
+  }
+}
+
+void
+hb_font_cache_t::set_max_bytes (unsigned int max_bytes_)
+{
+  max_bytes.set ((int) max_bytes_);
+  evict (0, nullptr);
+}
+
+void
+hb_font_cache_t::get_stats (unsigned int *count_,
+			    unsigned int *bytes_,
+			    unsigned int *hits_,
+			    unsigned int *misses_,
+			    unsigned int *evictions_)
+{
+  unsigned int count = 0, hits = 0, misses = 0, evictions = 0;
+  for (unsigned int i = 0; i < HB_FONT_CACHE_SHARDS; i++)
+  {
+    hb_lock_t l (shards[i].lock);
+    count += shards[i].count;
+    hits += shards[i].hits;
+    misses += shards[i].misses;
+    evictions += shards[i].evictions;
+  }
+
+  if (count_) *count_ = count;
+  if (bytes_) *bytes_ = (unsigned int) bytes.get ();
+  if (hits_) *hits_ = hits;
+  if (misses_) *misses_ = misses;
+  if (evictions_) *evictions_ = evictions;
+}
+
+
+/* Public API */
+
+/**
+ * hb_font_cache_create: (Xconstructor)
+ * @max_bytes: memory the cached faces and fonts may hold.
+ *
+ * Creates a font cache.  @max_bytes is a soft limit: the face or font
+ * just added always stays, even if it alone is larger.
+ *
+ * Return value: (transfer full): the new font cache.
+ *
+ * Since: REPLACEME
+ **/
+hb_font_cache_t *
+hb_font_cache_create (unsigned int max_bytes)
+{
+  hb_font_cache_t *cache;
+
+  if (!(cache = hb_object_create<hb_font_cache_t> ()))
+    return hb_font_cache_get_empty ();
+
+  cache->init (max_bytes);
+
+  return cache;
+}
+
+/**
+ * hb_font_cache_get_empty:
+ *
+ * Fetches the empty font cache, which caches nothing and hands out empty
+ * faces and fonts.
+ *
+ * Return value: (transfer full): the empty font cache.
+ *
+ * Since: REPLACEME
+ **/
+hb_font_cache_t *
+hb_font_cache_get_empty ()
+{
+  return const_cast<hb_font_cache_t *> (&Null(hb_font_cache_t));
+}
+
+/**
+ * hb_font_cache_reference: (skip)
+ * @cache: a font cache.
+ *
+ * Return value: (transfer full): @cache.
+ *
+ * Since: REPLACEME
+ **/
+hb_font_cache_t *
+hb_font_cache_reference (hb_font_cache_t *cache)
+{
+  return hb_object_reference (cache);
+}
+
+/**
+ * hb_font_cache_destroy: (skip)
+ * @cache: a font cache.
+ *
+ * Releases a reference to @cache.  The faces and fonts it handed out stay
+ * valid for as long as their holders keep them.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_font_cache_destroy (hb_font_cache_t *cache)
+{
+  if (!hb_object_destroy (cache)) return;
+
+  cache->fini ();
+
+  free (cache);
+}
+
+/**
+ * hb_font_cache_set_user_data: (skip)
+ * @cache: a font cache.
+ * @key: user-data key.
+ * @data: data to attach.
+ * @destroy: callback to release @data.
+ * @replace: whether to replace existing data for @key.
+ *
+ * Return value: whether the data was attached.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_font_cache_set_user_data (hb_font_cache_t    *cache,
+			     hb_user_data_key_t *key,
+			     void *              data,
+			     hb_destroy_func_t   destroy,
+			     hb_bool_t           replace)
+{
+  return hb_object_set_user_data (cache, key, data, destroy, replace);
+}
+
+/**
+ * hb_font_cache_get_user_data: (skip)
+ * @cache: a font cache.
+ * @key: user-data key.
+ *
+ * Return value: (transfer none): the data attached to @cache for @key.
+ *
+ * Since: REPLACEME
+ **/
+void *
+hb_font_cache_get_user_data (hb_font_cache_t    *cache,
+			     hb_user_data_key_t *key)
+{
+  return hb_object_get_user_data (cache, key);
+}
+
+
+/**
+ * hb_font_cache_get_face:
+ * @cache: a font cache.
+ * @file_name: font file to load the face from.
+ * @index: index of the face in the file.
+ *
+ * Fetches the face at @index of @file_name, loading it if @cache doesn't
+ * have it yet.  Faces are told apart by @file_name as given, so the same
+ * file reached by two paths is loaded twice.  The face is immutable.
+ *
+ * Return value: (transfer full): the face, or the empty face if the file
+ * could not be read.
+ *
+ * Since: REPLACEME
+ **/
+hb_face_t *
+hb_font_cache_get_face (hb_font_cache_t *cache,
+			const char      *file_name,
+			unsigned int     index)
+{
+  if (unlikely (hb_object_is_inert (cache) || !file_name))
+    return hb_face_get_empty ();
+
+  return cache->get_face (file_name, index);
+}
+
+/**
+ * hb_font_cache_get_font:
+ * @cache: a font cache.
+ * @face: face of the font.
+ * @x_scale: horizontal scale of the font.
+ * @y_scale: vertical scale of the font.
+ * @variations: (array length=num_variations) (nullable): variation
+ * settings of the font.
+ * @num_variations: number of @variations.
+ *
+ * Fetches a font of @face with the given scale and variations, making it
+ * if @cache doesn't have it yet.  Variations must come in the same order
+ * to find the same font.  The font is immutable; to change it, make a
+ * sub-font with hb_font_create_sub_font().
+ *
+ * Return value: (transfer full): the font.
+ *
+ * Since: REPLACEME
+ **/
+hb_font_t *
+hb_font_cache_get_font (hb_font_cache_t      *cache,
+			hb_face_t            *face,
+			int                   x_scale,
+			int                   y_scale,
+			const hb_variation_t *variations,
+			unsigned int          num_variations)
+{
+  if (unlikely (hb_object_is_inert (cache)))
+    return hb_font_get_empty ();
+
+  if (unlikely (!face))
+    face = hb_face_get_empty ();
+
+  return cache->get_font (face, x_scale, y_scale, variations, num_variations);
+}
+
+/**
+ * hb_font_cache_clear:
+ * @cache: a font cache.
+ *
+ * Drops all faces and fonts from @cache; those handed out stay valid.
+ * The limit and statistics stay.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_font_cache_clear (hb_font_cache_t *cache)
+{
+  if (unlikely (hb_object_is_inert (cache)))
+    return;
+
+  cache->clear ();
+}
+
+/**
+ * hb_font_cache_set_max_bytes:
+ * @cache: a font cache.
+ * @max_bytes: memory the cached faces and fonts may hold.
+ *
+ * Changes the limit of @cache, dropping faces and fonts to meet it.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_font_cache_set_max_bytes (hb_font_cache_t *cache,
+			     unsigned int     max_bytes)
+{
+  if (unlikely (hb_object_is_inert (cache)))
+    return;
+
+  cache->set_max_bytes (max_bytes);
+}
+
+/**
+ * hb_font_cache_get_max_bytes:
+ * @cache: a font cache.
+ *
+ * Return value: memory the faces and fonts in @cache may hold.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_font_cache_get_max_bytes (hb_font_cache_t *cache)
+{
+  return (unsigned int) cache->max_bytes.get ();
+}
+
+/**
+ * hb_font_cache_get_stats:
+ * @cache: a font cache.
+ * @count: (out) (optional): number of faces and fonts currently cached.
+ * @bytes: (out) (optional): memory they hold, as last measured.
+ * @hits: (out) (optional): number of requests fulfilled from the cache.
+ * @misses: (out) (optional): number of requests that had to load a face
+ * or make a font.
+ * @evictions: (out) (optional): number of faces and fonts dropped to
+ * honor the limit.
+ *
+ * Fetches statistics of @cache, useful for sizing it.  The memory of a
+ * face or font is measured when it is added, and again whenever it is
+ * fetched from the cache, as faces load more data while in use.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_font_cache_get_stats (hb_font_cache_t *cache,
+			 unsigned int    *count,    /* OUT */
+			 unsigned int    *bytes,    /* OUT */
+			 unsigned int    *hits,     /* OUT */
+			 unsigned int    *misses,   /* OUT */
+			 unsigned int    *evictions /* OUT */)
+{
+  if (unlikely (hb_object_is_inert (cache)))
+  {
+    if (count) *count = 0;
+    if (bytes) *bytes = 0;
+    if (hits) *hits = 0;
+    if (misses) *misses = 0;
+    if (evictions) *evictions = 0;
+    return;
+  }
+
+  cache->get_stats (count, bytes, hits, misses, evictions);
+}
@@ -0,0 +1,106 @@
+/*
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef HB_H_IN
+#error "Include <hb.h> instead."
+#endif
+
+#ifndef HB_FONT_CACHE_H
+#define HB_FONT_CACHE_H
+
+#include "hb-common.h"
+#include "hb-face.h"
+#include "hb-font.h"
+
+HB_BEGIN_DECLS
+
+
+/**
+ * hb_font_cache_t:
+ *
+ * A cache of faces loaded from files, and of fonts made of faces, for
+ * sharing them across threads.
+ *
+ * Since: REPLACEME
+ **/
+typedef struct hb_font_cache_t hb_font_cache_t;
+
+
+HB_EXTERN hb_font_cache_t *
+hb_font_cache_create (unsigned int max_bytes);
+
+HB_EXTERN hb_font_cache_t *
+hb_font_cache_get_empty (void);
+
+HB_EXTERN hb_font_cache_t *
+hb_font_cache_reference (hb_font_cache_t *cache);
+
+HB_EXTERN void
+hb_font_cache_destroy (hb_font_cache_t *cache);
+
+HB_EXTERN hb_bool_t
+hb_font_cache_set_user_data (hb_font_cache_t    *cache,
+			     hb_user_data_key_t *key,
+			     void *              data,
+			     hb_destroy_func_t   destroy,
+			     hb_bool_t           replace);
+
+HB_EXTERN void *
+hb_font_cache_get_user_data (hb_font_cache_t    *cache,
+			     hb_user_data_key_t *key);
+
+
+HB_EXTERN hb_face_t *
+hb_font_cache_get_face (hb_font_cache_t *cache,
+			const char      *file_name,
+			unsigned int     index);
+
+HB_EXTERN hb_font_t *
+hb_font_cache_get_font (hb_font_cache_t      *cache,
+			hb_face_t            *face,
+			int                   x_scale,
+			int                   y_scale,
+			const hb_variation_t *variations,
+			unsigned int          num_variations);
+
+HB_EXTERN void
+hb_font_cache_clear (hb_font_cache_t *cache);
+
+HB_EXTERN void
+hb_font_cache_set_max_bytes (hb_font_cache_t *cache,
+			     unsigned int     max_bytes);
+
+HB_EXTERN unsigned int
+hb_font_cache_get_max_bytes (hb_font_cache_t *cache);
+
+HB_EXTERN void
+hb_font_cache_get_stats (hb_font_cache_t *cache,
+			 unsigned int    *count,    /* OUT */
+			 unsigned int    *bytes,    /* OUT */
+			 unsigned int    *hits,     /* OUT */
+			 unsigned int    *misses,   /* OUT */
+			 unsigned int    *evictions /* OUT */);
+
+
+HB_END_DECLS
+
+#endif /* HB_FONT_CACHE_H */
@@ -0,0 +1,125 @@
+/*
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef HB_FONT_CACHE_HH
+#define HB_FONT_CACHE_HH
+
+#include "hb.hh"
+
+
+#ifndef HB_FONT_CACHE_SHARDS
+/* Separately locked parts of a font cache; a power of two. */
+#define HB_FONT_CACHE_SHARDS 8
+#endif
+
+struct hb_font_cache_t
+{
+  /* A face loaded from file_name, or a font made of face; font nodes
+   * have no file_name, and their font holds the reference to face. */
+  struct node_t
+  {
+    uint32_t hash;
+    unsigned int bytes;	/* As last measured. */
+    node_t *prev;	/* Towards most-recently-used. */
+    node_t *next;	/* Towards least-recently-used. */
+
+    hb_face_t *face;
+    hb_font_t *font;
+
+    /* Key, besides face. */
+    char *file_name;
+    unsigned int index;
+    int x_scale;
+    int y_scale;
+    hb_variation_t *variations;
+    unsigned int num_variations;
+
+    bool key_equal (const node_t *key) const;
+    void measure ();
+  };
+
+  struct shard_t
+  {
+    hb_mutex_t lock;
+    node_t *head;
+    node_t *tail;
+    unsigned int count;
+
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions;
+
+    node_t *find (const node_t *key) const;
+    void promote (node_t *node);
+    void link (node_t *node);
+    void unlink (node_t *node);
+  };
+
+  hb_object_header_t header;
+
+  hb_atomic_int_t max_bytes;
+  hb_atomic_int_t bytes;	/* Measured bytes of all nodes. */
+  shard_t shards[HB_FONT_CACHE_SHARDS];
+
+  HB_INTERNAL void init (unsigned int max_bytes);
+  HB_INTERNAL void fini ();
+
+  /* Return new references. */
+  HB_INTERNAL hb_face_t *get_face (const char *file_name, unsigned int index);
+  HB_INTERNAL hb_font_t *get_font (hb_face_t *face,
+				   int x_scale, int y_scale,
+				   const hb_variation_t *variations,
+				   unsigned int num_variations);
+
+  HB_INTERNAL void clear ();
+  HB_INTERNAL void set_max_bytes (unsigned int max_bytes);
+
+  HB_INTERNAL void get_stats (unsigned int *count,
+			      unsigned int *bytes,
+			      unsigned int *hits,
+			      unsigned int *misses,
+			      unsigned int *evictions);
+
+  private:
+  shard_t &get_shard (uint32_t hash)
+  { return shards[(hash ^ (hash >> 16)) & (HB_FONT_CACHE_SHARDS - 1)]; }
+
+  /* Return a new reference to the face or font of the node matching key,
+   * or nullptr. */
+  void *lookup (const node_t *key);
+  /* Measures the node matching key again, if it still holds object. */
+  void remeasure (const node_t *key, const void *object);
+  /* Takes over node, which must be measured, unless another thread
+   * inserted a node with the same key meanwhile; then returns that one's
+   * object instead. */
+  void *insert (node_t *node);
+  /* Drops least recently used nodes, starting with shard start but never
+   * keep, until the cache fits its limit again. */
+  void evict (unsigned int start, const node_t *keep);
+  bool over_budget () const
+  { return (unsigned int) bytes.get () > (unsigned int) max_bytes.get (); }
+  static void *reference (node_t *node);
+  static void destroy_node (node_t *node);
+};
+
+
+#endif /* HB_FONT_CACHE_HH */
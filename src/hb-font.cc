@@ -330,12 +330,56 @@ hb_font_get_glyph_v_origin_default (hb_font_t *font,
 				    hb_position_t *y,
 				    void *user_data HB_UNUSED)
 {
+  if (font->has_glyph_v_origins_func_set ())
+  {
+    return font->get_glyph_v_origins (1, &glyph, 0, x, 0, y, 0);
+  }
   hb_bool_t ret = font->parent->get_glyph_v_origin (glyph, x, y);
   if (ret)
     font->parent_scale_position (x, y);
   return ret;
 }
 
+#define hb_font_get_glyph_v_origins_nil hb_font_get_glyph_v_origins_default
+static hb_bool_t
+hb_font_get_glyph_v_origins_default (hb_font_t *font,
+				     void *font_data HB_UNUSED,
+				     unsigned int count,
+				     const hb_codepoint_t *first_glyph,
+				     unsigned int glyph_stride,
+				     hb_position_t *first_x,
+				     unsigned int x_stride,
+				     hb_position_t *first_y,
+				     unsigned int y_stride,
+				     void *user_data HB_UNUSED)
+{
+  hb_bool_t ret = true;
+  if (font->has_glyph_v_origin_func_set ())
+  {
+    for (unsigned int i = 0; i < count; i++)
+    {
+      if (!font->get_glyph_v_origin (*first_glyph, first_x, first_y))
+	ret = false;
+      first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+      first_x = &StructAtOffsetUnaligned<hb_position_t> (first_x, x_stride);
+      first_y = &StructAtOffsetUnaligned<hb_position_t> (first_y, y_stride);
+    }
+    return ret;
+  }
+
+  ret = font->parent->get_glyph_v_origins (count,
+					   first_glyph, glyph_stride,
+					   first_x, x_stride,
+					   first_y, y_stride);
+  for (unsigned int i = 0; i < count; i++)
+  {
+    font->parent_scale_position (first_x, first_y);
+    first_x = &StructAtOffsetUnaligned<hb_position_t> (first_x, x_stride);
+    first_y = &StructAtOffsetUnaligned<hb_position_t> (first_y, y_stride);
+  }
+  return ret;
+}
+
 static hb_position_t
 hb_font_get_glyph_h_kerning_nil (hb_font_t *font HB_UNUSED,
 				 void *font_data HB_UNUSED,
@@ -391,6 +435,10 @@ hb_font_get_glyph_extents_default (hb_font_t *font,
 				   hb_glyph_extents_t *extents,
 				   void *user_data HB_UNUSED)
 {
+  if (font->has_glyph_extents_array_func_set ())
+  {
+    return font->get_glyph_extents_array (1, &glyph, 0, extents, 0);
+  }
   hb_bool_t ret = font->parent->get_glyph_extents (glyph, extents);
   if (ret) {
     font->parent_scale_position (&extents->x_bearing, &extents->y_bearing);
@@ -399,6 +447,42 @@ hb_font_get_glyph_extents_default (hb_font_t *font,
   return ret;
 }
 
+#define hb_font_get_glyph_extents_array_nil hb_font_get_glyph_extents_array_default
+static unsigned int
+hb_font_get_glyph_extents_array_default (hb_font_t *font,
+					 void *font_data HB_UNUSED,
+					 unsigned int count,
+					 const hb_codepoint_t *first_glyph,
+					 unsigned int glyph_stride,
+					 hb_glyph_extents_t *first_extents,
+					 unsigned int extents_stride,
+					 void *user_data HB_UNUSED)
+{
+  unsigned int ret = 0;
+  if (font->has_glyph_extents_func_set ())
+  {
+    for (unsigned int i = 0; i < count; i++)
+    {
+      if (font->get_glyph_extents (*first_glyph, first_extents))
+	ret++;
+      first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+      first_extents = &StructAtOffsetUnaligned<hb_glyph_extents_t> (first_extents, extents_stride);
+    }
+    return ret;
+  }
+
+  ret = font->parent->get_glyph_extents_array (count,
+					       first_glyph, glyph_stride,
+					       first_extents, extents_stride);
+  for (unsigned int i = 0; i < count; i++)
+  {
+    font->parent_scale_position (&first_extents->x_bearing, &first_extents->y_bearing);
+    font->parent_scale_distance (&first_extents->width, &first_extents->height);
+    first_extents = &StructAtOffsetUnaligned<hb_glyph_extents_t> (first_extents, extents_stride);
+  }
+  return ret;
+}
+
 static hb_bool_t
 hb_font_get_glyph_contour_point_nil (hb_font_t *font HB_UNUSED,
 				     void *font_data HB_UNUSED,
@@ -708,6 +792,81 @@ hb_font_t::has_func (unsigned int i)
 	 (parent && parent != &_hb_Null_hb_font_t && parent->has_func (i));
 }
 
+const float *
+hb_var_scalars_cache_t::add (entry_t *entry)
+{
+  for (unsigned int i = 0; i < HB_FONT_VAR_SCALARS_SLOTS; i++)
+  {
+    if (slots[i].cmpexch (nullptr, entry))
+      return entry->scalars;
+    const entry_t *other = slots[i].get ();
+    if (other->store == entry->store)
+    {
+      free (entry);
+      return other->scalars;
+    }
+  }
+  free (entry);
+  return nullptr;
+}
+
+void
+hb_var_scalars_cache_t::reset ()
+{
+  for (unsigned int i = 0; i < HB_FONT_VAR_SCALARS_SLOTS; i++)
+  {
+    free (slots[i].get ());
+    slots[i].set_relaxed (nullptr);
+  }
+}
+
+unsigned int
+hb_var_scalars_cache_t::get_memory_usage () const
+{
+  unsigned int heap = 0;
+  for (unsigned int i = 0; i < HB_FONT_VAR_SCALARS_SLOTS; i++)
+    if (slots[i].get_relaxed ())
+      heap += sizeof (entry_t); /* Scalars themselves not counted. */
+  return heap;
+}
+
+void
+hb_font_t::reset_var_scalars ()
+{
+  hb_var_coords_destroy (var_coords.get ());
+  var_coords.set_relaxed (nullptr);
+  var_scalars.reset ();
+}
+
+static hb_var_coords_t *
+_hb_var_coords_create (hb_face_t *face, unsigned int coords_length);
+
+hb_var_coords_t *
+hb_font_t::get_shared_var_coords ()
+{
+  if (!num_coords)
+    return nullptr;
+
+retry:
+  hb_var_coords_t *shared = var_coords.get ();
+  if (likely (shared))
+    return shared;
+
+  shared = _hb_var_coords_create (face, num_coords);
+  if (unlikely (!shared->num_coords))
+    return nullptr;
+  memcpy (shared->coords, coords, num_coords * sizeof (coords[0]));
+
+  /* Scalars already in var_scalars stay valid until the next reset, for
+   * whoever still uses them. */
+  if (unlikely (!var_coords.cmpexch (nullptr, shared)))
+  {
+    hb_var_coords_destroy (shared);
+    goto retry;
+  }
+  return shared;
+}
+
 /* Public getters */
 
 /**
@@ -925,6 +1084,40 @@ hb_font_get_glyph_v_origin (hb_font_t *font,
   return font->get_glyph_v_origin (glyph, x, y);
 }
 
+/**
+ * hb_font_get_glyph_v_origins:
+ * @font: a font.
+ * @count: number of glyphs.
+ * @first_glyph: glyph indices; @glyph_stride bytes apart.
+ * @glyph_stride: bytes from one glyph index to the next.
+ * @first_x: (out): x origins; @x_stride bytes apart.
+ * @x_stride: bytes from one x origin to the next.
+ * @first_y: (out): y origins; @y_stride bytes apart.
+ * @y_stride: bytes from one y origin to the next.
+ *
+ * Fetches the vertical origins of @count glyphs in one call, as if by
+ * calling hb_font_get_glyph_v_origin() on each.
+ *
+ * Return value: true if the origins of all glyphs were found.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_font_get_glyph_v_origins (hb_font_t *font,
+			     unsigned int count,
+			     const hb_codepoint_t *first_glyph,
+			     unsigned int glyph_stride,
+			     hb_position_t *first_x,
+			     unsigned int x_stride,
+			     hb_position_t *first_y,
+			     unsigned int y_stride)
+{
+  return font->get_glyph_v_origins (count,
+				    first_glyph, glyph_stride,
+				    first_x, x_stride,
+				    first_y, y_stride);
+}
+
 /**
  * hb_font_get_glyph_h_kerning:
  * @font: a font.
@@ -985,6 +1178,35 @@ hb_font_get_glyph_extents (hb_font_t *font,
   return font->get_glyph_extents (glyph, extents);
 }
 
+/**
+ * hb_font_get_glyph_extents_array:
+ * @font: a font.
+ * @count: number of glyphs.
+ * @first_glyph: glyph indices; @glyph_stride bytes apart.
+ * @glyph_stride: bytes from one glyph index to the next.
+ * @first_extents: (out): extents; @extents_stride bytes apart.
+ * @extents_stride: bytes from one extents record to the next.
+ *
+ * Fetches the extents of @count glyphs in one call.  Extents of glyphs
+ * that have none are zeroed.
+ *
+ * Return value: the number of glyphs extents were found for.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_font_get_glyph_extents_array (hb_font_t *font,
+				 unsigned int count,
+				 const hb_codepoint_t *first_glyph,
+				 unsigned int glyph_stride,
+				 hb_glyph_extents_t *first_extents,
+				 unsigned int extents_stride)
+{
+  return font->get_glyph_extents_array (count,
+					first_glyph, glyph_stride,
+					first_extents, extents_stride);
+}
+
 /**
  * hb_font_get_glyph_contour_point:
  * @font: a font.
@@ -1298,6 +1520,8 @@ DEFINE_NULL_INSTANCE (hb_font_t) =
 
   1000, /* x_scale */
   1000, /* y_scale */
+  {}, /* x_mult */
+  {}, /* y_mult */
 
   0, /* x_ppem */
   0, /* y_ppem */
@@ -1305,6 +1529,7 @@ DEFINE_NULL_INSTANCE (hb_font_t) =
 
   0, /* num_coords */
   nullptr, /* coords */
+  0, /* serial */
 
   const_cast<hb_font_funcs_t *> (&_hb_Null_hb_font_funcs_t),
 
@@ -1328,6 +1553,7 @@ _hb_font_create (hb_face_t *face)
   font->klass = hb_font_funcs_get_empty ();
   font->data.init0 (font);
   font->x_scale = font->y_scale = hb_face_get_upem (face);
+  font->mults_changed ();
 
   return font;
 }
@@ -1359,9 +1585,13 @@ hb_font_create (hb_face_t *face)
  * hb_font_create_sub_font:
  * @parent: parent font.
  *
- * 
+ * Creates a font that gets its glyph data from @parent, scaled to its
+ * own scale.  The new font starts at the
+ * variation coordinates of @parent, and shares the data derived from
+ * them, like region scalars, with @parent and its other sub-fonts until
+ * its coordinates are changed.
  *
- * Return value: (transfer full): 
+ * Return value: (transfer full): the new font.
  *
  * Since: 0.9.2
  **/
@@ -1380,6 +1610,7 @@ hb_font_create_sub_font (hb_font_t *parent)
 
   font->x_scale = parent->x_scale;
   font->y_scale = parent->y_scale;
+  font->mults_changed ();
   font->x_ppem = parent->x_ppem;
   font->y_ppem = parent->y_ppem;
   font->ptem = parent->ptem;
@@ -1394,7 +1625,11 @@ hb_font_create_sub_font (hb_font_t *parent)
     if (unlikely (!font->coords))
       font->num_coords = 0;
     else
+    {
       memcpy (font->coords, parent->coords, size);
+      /* Siblings at the parent's coords share what's derived from them. */
+      font->var_coords.set_relaxed (hb_var_coords_reference (parent->get_shared_var_coords ()));
+    }
   }
 
   return font;
@@ -1454,6 +1689,13 @@ hb_font_destroy (hb_font_t *font)
   hb_font_funcs_destroy (font->klass);
 
   free (font->coords);
+  font->reset_var_scalars ();
+
+  _hb_shape_cache_destroy (font->shape_cache.get ());
+  _hb_ot_anchor_cache_destroy (font->anchor_cache.get ());
+  _hb_ot_device_cache_destroy (font->device_cache.get ());
+  _hb_ot_color_png_cache_destroy (font->png_cache.get ());
+  _hb_ot_normalize_cache_destroy (font->normalize_cache.get ());
 
   free (font);
 }
@@ -1560,6 +1802,7 @@ hb_font_set_parent (hb_font_t *font,
   font->parent = hb_font_reference (parent);
 
   hb_font_destroy (old);
+  font->serial++;
 }
 
 /**
@@ -1602,6 +1845,9 @@ hb_font_set_face (hb_font_t *font,
   font->face = hb_face_reference (face);
 
   hb_face_destroy (old);
+  font->mults_changed ();
+  font->reset_var_scalars ();
+  font->serial++;
 }
 
 /**
@@ -1656,6 +1902,8 @@ hb_font_set_funcs (hb_font_t         *font,
   font->klass = klass;
   font->user_data = font_data;
   font->destroy = destroy;
+  font->ot_font = nullptr;
+  font->serial++;
 }
 
 /**
@@ -1686,6 +1934,8 @@ hb_font_set_funcs_data (hb_font_t         *font,
 
   font->user_data = font_data;
   font->destroy = destroy;
+  font->ot_font = nullptr;
+  font->serial++;
 }
 
 
@@ -1709,6 +1959,8 @@ hb_font_set_scale (hb_font_t *font,
 
   font->x_scale = x_scale;
   font->y_scale = y_scale;
+  font->mults_changed ();
+  font->serial++;
 }
 
 /**
@@ -1750,6 +2002,7 @@ hb_font_set_ppem (hb_font_t *font,
 
   font->x_ppem = x_ppem;
   font->y_ppem = y_ppem;
+  font->serial++;
 }
 
 /**
@@ -1789,6 +2042,7 @@ hb_font_set_ptem (hb_font_t *font, float ptem)
     return;
 
   font->ptem = ptem;
+  font->serial++;
 }
 
 /**
@@ -1820,6 +2074,8 @@ _hb_font_adopt_var_coords_normalized (hb_font_t *font,
 
   font->coords = coords;
   font->num_coords = coords_length;
+  font->reset_var_scalars ();
+  font->serial++;
 }
 
 /**
@@ -1897,6 +2153,50 @@ hb_font_set_var_coords_normalized (hb_font_t *font,
   _hb_font_adopt_var_coords_normalized (font, copy, coords_length);
 }
 
+/**
+ * hb_font_set_var_coords:
+ * @font: a font.
+ * @coords: variation coordinates made for the face of @font.
+ *
+ * Sets the variation coordinates of @font to @coords, without
+ * normalizing them again.  Fonts set to the same @coords also share the
+ * variation data derived from them, so switching a font between a few
+ * coordinate sets doesn't recompute it either.  Setting the coords
+ * @font already has is free, and keeps @font's caches.
+ *
+ * If @coords was made for another face, this is the same as calling
+ * hb_font_set_var_coords_normalized() with its normalized coords.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_font_set_var_coords (hb_font_t       *font,
+			hb_var_coords_t *coords)
+{
+  if (hb_object_is_immutable (font))
+    return;
+
+  if (coords == font->var_coords.get ())
+    return;
+
+  if (coords->face != font->face)
+  {
+    hb_font_set_var_coords_normalized (font, coords->coords, coords->num_coords);
+    return;
+  }
+
+  unsigned int coords_length = coords->num_coords;
+  int *copy = coords_length ? (int *) calloc (coords_length, sizeof (coords->coords[0])) : nullptr;
+  if (unlikely (coords_length && !copy))
+    return;
+
+  if (coords_length)
+    memcpy (copy, coords->coords, coords_length * sizeof (coords->coords[0]));
+
+  _hb_font_adopt_var_coords_normalized (font, copy, coords_length);
+  font->var_coords.set_relaxed (hb_var_coords_reference (coords));
+}
+
 /**
  * hb_font_get_var_coords_normalized:
  *
@@ -1916,6 +2216,183 @@ hb_font_get_var_coords_normalized (hb_font_t *font,
 }
 
 
+/*
+ * hb_var_coords_t
+ */
+
+static hb_var_coords_t *
+_hb_var_coords_create (hb_face_t *face, unsigned int coords_length)
+{
+  hb_var_coords_t *coords;
+
+  if (unlikely (!face))
+    face = hb_face_get_empty ();
+  if (!(coords = hb_object_create<hb_var_coords_t> ()))
+    return hb_var_coords_get_empty ();
+
+  coords->coords = coords_length ? (int *) calloc (coords_length, sizeof (int)) : nullptr;
+  if (unlikely (coords_length && !coords->coords))
+  {
+    hb_object_fini (coords);
+    free (coords);
+    return hb_var_coords_get_empty ();
+  }
+  coords->num_coords = coords_length;
+  coords->face = hb_face_reference (face);
+
+  return coords;
+}
+
+/**
+ * hb_var_coords_create:
+ * @face: a face.
+ * @variations: (array length=variations_length): variation settings.
+ * @variations_length: number of @variations.
+ *
+ * Normalizes @variations for @face once, for use with
+ * hb_font_set_var_coords().  Axes not in @variations get their default
+ * value.
+ *
+ * Return value: (transfer full): the new coords object.
+ *
+ * Since: REPLACEME
+ **/
+hb_var_coords_t *
+hb_var_coords_create (hb_face_t            *face,
+		      const hb_variation_t *variations,
+		      unsigned int          variations_length)
+{
+  hb_var_coords_t *coords = _hb_var_coords_create (face, hb_ot_var_get_axis_count (face));
+  if (coords->num_coords)
+    hb_ot_var_normalize_variations (face,
+				    variations, variations_length,
+				    coords->coords, coords->num_coords);
+  return coords;
+}
+
+/**
+ * hb_var_coords_create_design:
+ * @face: a face.
+ * @coords: (array length=coords_length): design-space coordinates, in axis order.
+ * @coords_length: number of @coords.
+ *
+ * Normalizes design-space @coords for @face once, for use with
+ * hb_font_set_var_coords().
+ *
+ * Return value: (transfer full): the new coords object.
+ *
+ * Since: REPLACEME
+ **/
+hb_var_coords_t *
+hb_var_coords_create_design (hb_face_t    *face,
+			     const float  *coords,
+			     unsigned int  coords_length)
+{
+  hb_var_coords_t *var_coords = _hb_var_coords_create (face, coords_length);
+  if (var_coords->num_coords)
+    hb_ot_var_normalize_coords (face, coords_length, coords, var_coords->coords);
+  return var_coords;
+}
+
+/**
+ * hb_var_coords_get_empty:
+ *
+ * Return value: (transfer full): the empty coords object, which has no
+ * coordinates.
+ *
+ * Since: REPLACEME
+ **/
+hb_var_coords_t *
+hb_var_coords_get_empty ()
+{
+  return const_cast<hb_var_coords_t *> (&Null (hb_var_coords_t));
+}
+
+/**
+ * hb_var_coords_reference: (skip)
+ * @coords: a coords object.
+ *
+ * Return value: (transfer full): @coords.
+ *
+ * Since: REPLACEME
+ **/
+hb_var_coords_t *
+hb_var_coords_reference (hb_var_coords_t *coords)
+{
+  return hb_object_reference (coords);
+}
+
+/**
+ * hb_var_coords_destroy: (skip)
+ * @coords: a coords object.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_var_coords_destroy (hb_var_coords_t *coords)
+{
+  if (!hb_object_destroy (coords)) return;
+
+  coords->var_scalars.reset ();
+  free (coords->coords);
+  hb_face_destroy (coords->face);
+
+  free (coords);
+}
+
+/**
+ * hb_var_coords_get_normalized:
+ * @coords: a coords object.
+ * @length: (out) (optional): number of coordinates.
+ *
+ * Return value: (array length=length): the normalized coordinates,
+ * valid as long as @coords is alive.
+ *
+ * Since: REPLACEME
+ **/
+const int *
+hb_var_coords_get_normalized (hb_var_coords_t *coords,
+			      unsigned int    *length)
+{
+  if (length)
+    *length = coords->num_coords;
+
+  return coords->coords;
+}
+
+/**
+ * hb_font_get_memory_usage:
+ * @font: a font.
+ *
+ * Reports how much heap memory @font is holding itself: its variation
+ * coordinates and derived data, its shape, anchor and device caches, and the
+ * caches of the OpenType font functions if it uses them.  Memory of the face, and of
+ * user data and other font functions, is not counted; see
+ * hb_face_get_memory_usage().
+ *
+ * Return value: bytes of heap memory held by @font.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_font_get_memory_usage (hb_font_t *font)
+{
+  if (unlikely (hb_object_is_inert (font)))
+    return 0;
+
+  unsigned int heap = sizeof (*font);
+  heap += font->num_coords * sizeof (font->coords[0]);
+  heap += font->var_scalars.get_memory_usage ();
+  heap += _hb_ot_font_get_memory_usage (font);
+  heap += _hb_shape_cache_get_memory_usage (font->shape_cache.get ());
+  heap += _hb_ot_anchor_cache_get_memory_usage (font->anchor_cache.get ());
+  heap += _hb_ot_device_cache_get_memory_usage (font->device_cache.get ());
+  heap += _hb_ot_color_png_cache_get_memory_usage (font->png_cache.get ());
+  heap += _hb_ot_normalize_cache_get_memory_usage (font->normalize_cache.get ());
+  return heap;
+}
+
+
 /*
  * Deprecated get_glyph_func():
  */
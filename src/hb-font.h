@@ -157,11 +157,29 @@ typedef hb_bool_t (*hb_font_get_glyph_origin_func_t) (hb_font_t *font, void *fon
 typedef hb_font_get_glyph_origin_func_t hb_font_get_glyph_h_origin_func_t;
 typedef hb_font_get_glyph_origin_func_t hb_font_get_glyph_v_origin_func_t;
 
+typedef hb_bool_t (*hb_font_get_glyph_origins_func_t) (hb_font_t *font, void *font_data,
+						       unsigned int count,
+						       const hb_codepoint_t *first_glyph,
+						       unsigned int glyph_stride,
+						       hb_position_t *first_x,
+						       unsigned int x_stride,
+						       hb_position_t *first_y,
+						       unsigned int y_stride,
+						       void *user_data);
+typedef hb_font_get_glyph_origins_func_t hb_font_get_glyph_v_origins_func_t;
+
 
 typedef hb_bool_t (*hb_font_get_glyph_extents_func_t) (hb_font_t *font, void *font_data,
 						       hb_codepoint_t glyph,
 						       hb_glyph_extents_t *extents,
 						       void *user_data);
+typedef unsigned int (*hb_font_get_glyph_extents_array_func_t) (hb_font_t *font, void *font_data,
+								unsigned int count,
+								const hb_codepoint_t *first_glyph,
+								unsigned int glyph_stride,
+								hb_glyph_extents_t *first_extents,
+								unsigned int extents_stride,
+								void *user_data);
 typedef hb_bool_t (*hb_font_get_glyph_contour_point_func_t) (hb_font_t *font, void *font_data,
 							     hb_codepoint_t glyph, unsigned int point_index,
 							     hb_position_t *x, hb_position_t *y,
@@ -356,6 +374,24 @@ hb_font_funcs_set_glyph_v_origin_func (hb_font_funcs_t *ffuncs,
 				       hb_font_get_glyph_v_origin_func_t func,
 				       void *user_data, hb_destroy_func_t destroy);
 
+/**
+ * hb_font_funcs_set_glyph_v_origins_func:
+ * @ffuncs: font functions.
+ * @func: (closure user_data) (destroy destroy) (scope notified):
+ * @user_data:
+ * @destroy:
+ *
+ * Sets the callback that fetches the vertical origins of many glyphs at
+ * once.  It should return true only if it found the origins of all of
+ * them.
+ *
+ * Since: REPLACEME
+ **/
+HB_EXTERN void
+hb_font_funcs_set_glyph_v_origins_func (hb_font_funcs_t *ffuncs,
+					hb_font_get_glyph_v_origins_func_t func,
+					void *user_data, hb_destroy_func_t destroy);
+
 /**
  * hb_font_funcs_set_glyph_extents_func:
  * @ffuncs: font functions.
@@ -372,6 +408,24 @@ hb_font_funcs_set_glyph_extents_func (hb_font_funcs_t *ffuncs,
 				      hb_font_get_glyph_extents_func_t func,
 				      void *user_data, hb_destroy_func_t destroy);
 
+/**
+ * hb_font_funcs_set_glyph_extents_array_func:
+ * @ffuncs: font functions.
+ * @func: (closure user_data) (destroy destroy) (scope notified):
+ * @user_data:
+ * @destroy:
+ *
+ * Sets the callback that fetches the extents of many glyphs at once.  It
+ * should return the number of glyphs it found extents for, leaving the
+ * extents of the others zeroed.
+ *
+ * Since: REPLACEME
+ **/
+HB_EXTERN void
+hb_font_funcs_set_glyph_extents_array_func (hb_font_funcs_t *ffuncs,
+					    hb_font_get_glyph_extents_array_func_t func,
+					    void *user_data, hb_destroy_func_t destroy);
+
 /**
  * hb_font_funcs_set_glyph_contour_point_func:
  * @ffuncs: font functions.
@@ -468,11 +522,27 @@ HB_EXTERN hb_bool_t
 hb_font_get_glyph_v_origin (hb_font_t *font,
 			    hb_codepoint_t glyph,
 			    hb_position_t *x, hb_position_t *y);
+HB_EXTERN hb_bool_t
+hb_font_get_glyph_v_origins (hb_font_t *font,
+			     unsigned int count,
+			     const hb_codepoint_t *first_glyph,
+			     unsigned int glyph_stride,
+			     hb_position_t *first_x,
+			     unsigned int x_stride,
+			     hb_position_t *first_y,
+			     unsigned int y_stride);
 
 HB_EXTERN hb_bool_t
 hb_font_get_glyph_extents (hb_font_t *font,
 			   hb_codepoint_t glyph,
 			   hb_glyph_extents_t *extents);
+HB_EXTERN unsigned int
+hb_font_get_glyph_extents_array (hb_font_t *font,
+				 unsigned int count,
+				 const hb_codepoint_t *first_glyph,
+				 unsigned int glyph_stride,
+				 hb_glyph_extents_t *first_extents,
+				 unsigned int extents_stride);
 
 HB_EXTERN hb_bool_t
 hb_font_get_glyph_contour_point (hb_font_t *font,
@@ -674,6 +744,46 @@ HB_EXTERN const int *
 hb_font_get_var_coords_normalized (hb_font_t *font,
 				   unsigned int *length);
 
+/**
+ * hb_var_coords_t:
+ *
+ * Variation coordinates normalized once for a face, to be set on fonts
+ * with hb_font_set_var_coords().
+ *
+ * Since: REPLACEME
+ **/
+typedef struct hb_var_coords_t hb_var_coords_t;
+
+HB_EXTERN hb_var_coords_t *
+hb_var_coords_create (hb_face_t            *face,
+		      const hb_variation_t *variations,
+		      unsigned int          variations_length);
+
+HB_EXTERN hb_var_coords_t *
+hb_var_coords_create_design (hb_face_t    *face,
+			     const float  *coords,
+			     unsigned int  coords_length);
+
+HB_EXTERN hb_var_coords_t *
+hb_var_coords_get_empty (void);
+
+HB_EXTERN hb_var_coords_t *
+hb_var_coords_reference (hb_var_coords_t *coords);
+
+HB_EXTERN void
+hb_var_coords_destroy (hb_var_coords_t *coords);
+
+HB_EXTERN const int *
+hb_var_coords_get_normalized (hb_var_coords_t *coords,
+			      unsigned int    *length);
+
+HB_EXTERN void
+hb_font_set_var_coords (hb_font_t       *font,
+			hb_var_coords_t *coords);
+
+HB_EXTERN unsigned int
+hb_font_get_memory_usage (hb_font_t *font);
+
 HB_END_DECLS
 
 #endif /* HB_FONT_H */
@@ -51,9 +51,11 @@
   HB_FONT_FUNC_IMPLEMENT (glyph_v_advances) \
   HB_FONT_FUNC_IMPLEMENT (glyph_h_origin) \
   HB_FONT_FUNC_IMPLEMENT (glyph_v_origin) \
+  HB_FONT_FUNC_IMPLEMENT (glyph_v_origins) \
   HB_FONT_FUNC_IMPLEMENT (glyph_h_kerning) \
   HB_FONT_FUNC_IMPLEMENT (glyph_v_kerning) \
   HB_FONT_FUNC_IMPLEMENT (glyph_extents) \
+  HB_FONT_FUNC_IMPLEMENT (glyph_extents_array) \
   HB_FONT_FUNC_IMPLEMENT (glyph_contour_point) \
   HB_FONT_FUNC_IMPLEMENT (glyph_name) \
   HB_FONT_FUNC_IMPLEMENT (glyph_from_name) \
@@ -96,10 +98,131 @@ DECLARE_NULL_INSTANCE (hb_font_funcs_t);
  * hb_font_t
  */
 
+#ifndef HB_FONT_VAR_SCALARS_SLOTS
+#define HB_FONT_VAR_SCALARS_SLOTS 8
+#endif
+
+/* Region scalars of a face's variation stores at some coords, keyed by
+ * store.  Filled by OT::VariationStore::get_font_scalars(). */
+struct hb_var_scalars_cache_t
+{
+  struct entry_t
+  {
+    const void *store;
+    float *scalars;
+  };
+
+  const float *get (const void *store) const
+  {
+    for (unsigned int i = 0; i < HB_FONT_VAR_SCALARS_SLOTS; i++)
+    {
+      const entry_t *entry = slots[i].get ();
+      if (!entry)
+	break;
+      if (entry->store == store)
+	return entry->scalars;
+    }
+    return nullptr;
+  }
+  bool full () const
+  { return slots[HB_FONT_VAR_SCALARS_SLOTS - 1].get () != nullptr; }
+  /* Takes ownership of entry, which must be a single malloc() block.
+   * Returns the scalars kept for entry->store, which may be another
+   * thread's, or nullptr if all slots are taken. */
+  HB_INTERNAL const float *add (entry_t *entry);
+  HB_INTERNAL void reset ();
+  HB_INTERNAL unsigned int get_memory_usage () const;
+
+  hb_atomic_ptr_t<entry_t> slots[HB_FONT_VAR_SCALARS_SLOTS];
+};
+
+/* Scales font units to a font scale like hb_font_t::em_scale() does,
+ * with the same rounding, but without dividing: with scale = q * upem + r,
+ * v * scale / upem is v * q plus the rounded quotient of v * r by upem,
+ * which a multiply by a rounded-up reciprocal computes exactly for
+ * numerators below 2^30. */
+struct hb_em_mult_t
+{
+  void init (int scale, unsigned int upem)
+  {
+    valid = false;
+    if (unlikely (!upem || upem > 16384))
+      return;
+    uint64_t abs_scale = scale < 0 ? - (int64_t) scale : scale;
+    negative = scale < 0;
+    q = abs_scale / upem;
+    r = abs_scale % upem;
+    half = upem / 2;
+    shift = 30 + hb_bit_storage (upem - 1);
+    m = ((1ull << shift) + upem - 1) / upem;
+    valid = true;
+  }
+
+  hb_position_t scale (int16_t v) const
+  {
+    uint64_t abs_v = v < 0 ? - (int) v : v;
+    int64_t scaled = abs_v * q + ((abs_v * r + half) * m >> shift);
+    return (hb_position_t) ((v < 0) != negative ? -scaled : scaled);
+  }
+
+  uint64_t q;
+  uint64_t m;
+  uint32_t r;
+  uint32_t half;
+  uint32_t shift;
+  bool negative;
+  bool valid;
+};
+
+/* Normalized coords for a face, with the region scalars derived from
+ * them, shared by every font they are set on. */
+struct hb_var_coords_t
+{
+  hb_object_header_t header;
+
+  hb_face_t *face;
+  unsigned int num_coords;
+  int *coords;
+
+  hb_var_scalars_cache_t var_scalars;
+};
+
+
 #define HB_SHAPER_IMPLEMENT(shaper) HB_SHAPER_DATA_INSTANTIATE_SHAPERS(shaper, font);
 #include "hb-shaper-list.hh"
 #undef HB_SHAPER_IMPLEMENT
 
+struct hb_shape_cache_t;
+struct hb_ot_anchor_cache_t;
+struct hb_ot_device_cache_t;
+struct hb_ot_color_png_cache_t;
+struct hb_ot_normalize_cache_t;
+struct hb_ot_font_t;
+
+/* In hb-ot-font.cc.  The OpenType font functions, called directly rather
+ * than through the font funcs; see hb_font_t::ot_font. */
+HB_INTERNAL hb_bool_t
+_hb_ot_font_get_nominal_glyph (const hb_ot_font_t *ot_font,
+			       hb_codepoint_t unicode,
+			       hb_codepoint_t *glyph);
+
+HB_INTERNAL unsigned int
+_hb_ot_font_get_nominal_glyphs (const hb_ot_font_t *ot_font,
+				unsigned int count,
+				const hb_codepoint_t *first_unicode,
+				unsigned int unicode_stride,
+				hb_codepoint_t *first_glyph,
+				unsigned int glyph_stride);
+
+HB_INTERNAL void
+_hb_ot_font_get_glyph_h_advances (hb_font_t *font,
+				  const hb_ot_font_t *ot_font,
+				  unsigned int count,
+				  const hb_codepoint_t *first_glyph,
+				  unsigned int glyph_stride,
+				  hb_position_t *first_advance,
+				  unsigned int advance_stride);
+
 struct hb_font_t
 {
   hb_object_header_t header;
@@ -109,6 +232,9 @@ struct hb_font_t
 
   int x_scale;
   int y_scale;
+  /* Precomputed for em_scale_x() and the like; see mults_changed (). */
+  hb_em_mult_t x_mult;
+  hb_em_mult_t y_mult;
 
   unsigned int x_ppem;
   unsigned int y_ppem;
@@ -119,24 +245,107 @@ struct hb_font_t
   unsigned int num_coords;
   int *coords;
 
+  /* Changes whenever scale, ppem, ptem, face, parent, font funcs or
+   * variations do, so that caches can tell when they went stale. */
+  unsigned int serial;
+
   hb_font_funcs_t   *klass;
   void              *user_data;
   hb_destroy_func_t  destroy;
 
+  /* user_data, if klass is the OpenType font functions as attached by
+   * hb_ot_font_set_funcs(); nullptr otherwise.  The hottest queries call
+   * those directly when set. */
+  const hb_ot_font_t *ot_font;
+
   hb_shaper_object_dataset_t<hb_font_t> data; /* Various shaper data. */
 
+  /* Shaped output of hb_shape_full(); created by the first
+   * hb_shape_cache_set_capacity() call. */
+  hb_atomic_ptr_t<hb_shape_cache_t> shape_cache;
+
+  /* Resolved GPOS anchors; created by the first anchor that needs
+   * device deltas.  See hb_ot_layout_get_anchor_cache(). */
+  hb_atomic_ptr_t<hb_ot_anchor_cache_t> anchor_cache;
+
+  /* Evaluated GPOS value-record Device tables; created by the first
+   * one applied.  See hb_ot_layout_get_device_cache(). */
+  hb_atomic_ptr_t<hb_ot_device_cache_t> device_cache;
+
+  /* Chosen sbix/CBDT strikes and recent PNG glyph blobs; created by the
+   * first hb_ot_color_glyph_reference_png() call. */
+  hb_atomic_ptr_t<hb_ot_color_png_cache_t> png_cache;
+
+  /* Recent decompositions and recompositions of the normalizer; created
+   * by the first one tried.  See hb-ot-shape-normalize.cc. */
+  hb_atomic_ptr_t<hb_ot_normalize_cache_t> normalize_cache;
+
+  /* 'trak' tracking resolved at ptem for horizontal and vertical text,
+   * keyed by serial + 1 so that zero is never valid.  See AAT::trak. */
+  struct trak_cache_t
+  {
+    hb_atomic_int_t serial;
+    hb_atomic_int_t tracking;
+  } trak_cache[2];
+
+  /* The coords object coords were last set from, if any; see
+   * hb_font_set_var_coords().  Also made on demand by
+   * get_shared_var_coords(). */
+  hb_atomic_ptr_t<hb_var_coords_t> var_coords;
+
+  /* Region scalars of the face's variation stores at coords; dropped
+   * whenever coords or face change.  Fonts whose coords came from a
+   * coords object use and fill that object's instead. */
+  hb_var_scalars_cache_t var_scalars;
+
+  typedef hb_var_scalars_cache_t::entry_t var_scalars_t;
+  hb_var_scalars_cache_t &get_var_scalars_cache ()
+  {
+    hb_var_coords_t *shared = var_coords.get ();
+    return shared ? shared->var_scalars : var_scalars;
+  }
+  const float *get_var_scalars (const void *store)
+  { return get_var_scalars_cache ().get (store); }
+  bool var_scalars_full ()
+  { return get_var_scalars_cache ().full (); }
+  /* Takes ownership of entry, which must be a single malloc() block.
+   * Returns the scalars kept for entry->store, which may be another
+   * thread's, or nullptr if all slots are taken. */
+  const float *add_var_scalars (var_scalars_t *entry)
+  { return get_var_scalars_cache ().add (entry); }
+  HB_INTERNAL void reset_var_scalars ();
+  /* A coords object holding coords, for sub-fonts to share; nullptr
+   * if there are no coords. */
+  HB_INTERNAL hb_var_coords_t *get_shared_var_coords ();
+
+
+  /* To be called whenever scale or face change. */
+  void mults_changed ()
+  {
+    unsigned int upem = face->get_upem ();
+    x_mult.init (x_scale, upem);
+    y_mult.init (y_scale, upem);
+  }
 
   /* Convert from font-space to user-space */
   int dir_scale (hb_direction_t direction)
   { return HB_DIRECTION_IS_VERTICAL(direction) ? y_scale : x_scale; }
-  hb_position_t em_scale_x (int16_t v) { return em_scale (v, x_scale); }
-  hb_position_t em_scale_y (int16_t v) { return em_scale (v, y_scale); }
+  hb_position_t em_scale_x (int16_t v)
+  { return likely (x_mult.valid) ? x_mult.scale (v) : em_scale (v, x_scale); }
+  hb_position_t em_scale_y (int16_t v)
+  { return likely (y_mult.valid) ? y_mult.scale (v) : em_scale (v, y_scale); }
   hb_position_t em_scalef_x (float v) { return em_scalef (v, this->x_scale); }
   hb_position_t em_scalef_y (float v) { return em_scalef (v, this->y_scale); }
   float em_fscale_x (int16_t v) { return em_fscale (v, x_scale); }
   float em_fscale_y (int16_t v) { return em_fscale (v, y_scale); }
   hb_position_t em_scale_dir (int16_t v, hb_direction_t direction)
-  { return em_scale (v, dir_scale (direction)); }
+  { return HB_DIRECTION_IS_VERTICAL (direction) ? em_scale_y (v) : em_scale_x (v); }
+  /* Same, for values that may not fit 16 bits, like positions shaped in
+   * font units. */
+  hb_position_t em_scale_position_x (hb_position_t v)
+  { return v == (int16_t) v ? em_scale_x (v) : em_scale_position (v, x_scale); }
+  hb_position_t em_scale_position_y (hb_position_t v)
+  { return v == (int16_t) v ? em_scale_y (v) : em_scale_position (v, y_scale); }
 
   /* Convert from parent-font user-space to our user-space */
   hb_position_t parent_scale_x_distance (hb_position_t v)
@@ -217,6 +426,8 @@ struct hb_font_t
 				      hb_codepoint_t *glyph)
   {
     *glyph = 0;
+    if (ot_font)
+      return _hb_ot_font_get_nominal_glyph (ot_font, unicode, glyph);
     return klass->get.f.nominal_glyph (this, user_data,
 				       unicode, glyph,
 				       klass->user_data.nominal_glyph);
@@ -227,6 +438,10 @@ struct hb_font_t
 				   hb_codepoint_t *first_glyph,
 				   unsigned int glyph_stride)
   {
+    if (ot_font)
+      return _hb_ot_font_get_nominal_glyphs (ot_font, count,
+					     first_unicode, unicode_stride,
+					     first_glyph, glyph_stride);
     return klass->get.f.nominal_glyphs (this, user_data,
 					count,
 					first_unicode, unicode_stride,
@@ -245,6 +460,12 @@ struct hb_font_t
 
   hb_position_t get_glyph_h_advance (hb_codepoint_t glyph)
   {
+    if (ot_font)
+    {
+      hb_position_t advance;
+      _hb_ot_font_get_glyph_h_advances (this, ot_font, 1, &glyph, 0, &advance, 0);
+      return advance;
+    }
     return klass->get.f.glyph_h_advance (this, user_data,
 					 glyph,
 					 klass->user_data.glyph_h_advance);
@@ -263,6 +484,10 @@ struct hb_font_t
 			     hb_position_t *first_advance,
 			     unsigned int advance_stride)
   {
+    if (ot_font)
+      return _hb_ot_font_get_glyph_h_advances (this, ot_font, count,
+					       first_glyph, glyph_stride,
+					       first_advance, advance_stride);
     return klass->get.f.glyph_h_advances (this, user_data,
 					  count,
 					  first_glyph, glyph_stride,
@@ -301,6 +526,29 @@ struct hb_font_t
 					klass->user_data.glyph_v_origin);
   }
 
+  hb_bool_t get_glyph_v_origins (unsigned int count,
+				 const hb_codepoint_t *first_glyph,
+				 unsigned int glyph_stride,
+				 hb_position_t *first_x,
+				 unsigned int x_stride,
+				 hb_position_t *first_y,
+				 unsigned int y_stride)
+  {
+    hb_position_t *x = first_x, *y = first_y;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      *x = *y = 0;
+      x = &StructAtOffsetUnaligned<hb_position_t> (x, x_stride);
+      y = &StructAtOffsetUnaligned<hb_position_t> (y, y_stride);
+    }
+    return klass->get.f.glyph_v_origins (this, user_data,
+					 count,
+					 first_glyph, glyph_stride,
+					 first_x, x_stride,
+					 first_y, y_stride,
+					 klass->user_data.glyph_v_origins);
+  }
+
   hb_position_t get_glyph_h_kerning (hb_codepoint_t left_glyph,
 				     hb_codepoint_t right_glyph)
   {
@@ -327,6 +575,25 @@ struct hb_font_t
 				       klass->user_data.glyph_extents);
   }
 
+  unsigned int get_glyph_extents_array (unsigned int count,
+					const hb_codepoint_t *first_glyph,
+					unsigned int glyph_stride,
+					hb_glyph_extents_t *first_extents,
+					unsigned int extents_stride)
+  {
+    hb_glyph_extents_t *extents = first_extents;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      memset (extents, 0, sizeof (*extents));
+      extents = &StructAtOffsetUnaligned<hb_glyph_extents_t> (extents, extents_stride);
+    }
+    return klass->get.f.glyph_extents_array (this, user_data,
+					     count,
+					     first_glyph, glyph_stride,
+					     first_extents, extents_stride,
+					     klass->user_data.glyph_extents_array);
+  }
+
   hb_bool_t get_glyph_contour_point (hb_codepoint_t glyph, unsigned int point_index,
 					    hb_position_t *x, hb_position_t *y)
   {
@@ -446,6 +713,29 @@ struct hb_font_t
     }
   }
 
+  void get_glyph_v_origins_with_fallback (unsigned int count,
+					  const hb_codepoint_t *first_glyph,
+					  unsigned int glyph_stride,
+					  hb_position_t *first_x,
+					  unsigned int x_stride,
+					  hb_position_t *first_y,
+					  unsigned int y_stride)
+  {
+    if (get_glyph_v_origins (count,
+			     first_glyph, glyph_stride,
+			     first_x, x_stride,
+			     first_y, y_stride))
+      return;
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+      get_glyph_v_origin_with_fallback (*first_glyph, first_x, first_y);
+      first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+      first_x = &StructAtOffsetUnaligned<hb_position_t> (first_x, x_stride);
+      first_y = &StructAtOffsetUnaligned<hb_position_t> (first_y, y_stride);
+    }
+  }
+
   void get_glyph_origin_for_direction (hb_codepoint_t glyph,
 				       hb_direction_t direction,
 				       hb_position_t *x, hb_position_t *y)
@@ -600,6 +890,8 @@ struct hb_font_t
   }
 
   hb_position_t em_scale (int16_t v, int scale)
+  { return em_scale_position (v, scale); }
+  hb_position_t em_scale_position (hb_position_t v, int scale)
   {
     int upem = face->get_upem ();
     int64_t scaled = v * (int64_t) scale;
@@ -613,5 +905,49 @@ struct hb_font_t
 };
 DECLARE_NULL_INSTANCE (hb_font_t);
 
+/* Heap bytes of the OpenType font functions' data attached to @font, if
+ * any. */
+HB_INTERNAL unsigned int
+_hb_ot_font_get_memory_usage (const hb_font_t *font);
+
+/* Whether @font maps characters to glyphs with its face's cmap, through
+ * the OpenType font functions. */
+HB_INTERNAL bool
+_hb_ot_font_has_face_cmap (const hb_font_t *font);
+
+/* In hb-shape.cc. */
+HB_INTERNAL void
+_hb_shape_cache_destroy (hb_shape_cache_t *cache);
+
+HB_INTERNAL unsigned int
+_hb_shape_cache_get_memory_usage (hb_shape_cache_t *cache);
+
+/* In hb-ot-layout.cc. */
+HB_INTERNAL void
+_hb_ot_anchor_cache_destroy (hb_ot_anchor_cache_t *cache);
+
+HB_INTERNAL unsigned int
+_hb_ot_anchor_cache_get_memory_usage (hb_ot_anchor_cache_t *cache);
+
+HB_INTERNAL void
+_hb_ot_device_cache_destroy (hb_ot_device_cache_t *cache);
+
+HB_INTERNAL unsigned int
+_hb_ot_device_cache_get_memory_usage (hb_ot_device_cache_t *cache);
+
+/* In hb-ot-color.cc. */
+HB_INTERNAL void
+_hb_ot_color_png_cache_destroy (hb_ot_color_png_cache_t *cache);
+
+HB_INTERNAL unsigned int
+_hb_ot_color_png_cache_get_memory_usage (hb_ot_color_png_cache_t *cache);
+
+/* In hb-ot-shape-normalize.cc. */
+HB_INTERNAL void
+_hb_ot_normalize_cache_destroy (hb_ot_normalize_cache_t *cache);
+
+HB_INTERNAL unsigned int
+_hb_ot_normalize_cache_get_memory_usage (hb_ot_normalize_cache_t *cache);
+
 
 #endif /* HB_FONT_HH */
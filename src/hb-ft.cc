@@ -79,6 +79,48 @@ struct hb_ft_font_t
 
   mutable hb_atomic_int_t cached_x_scale;
   mutable hb_advance_cache_t advance_cache;
+
+  /* Clones of ft_face, set up the same, that callbacks check out instead
+   * of taking lock.  A slot is null while its face is checked out. */
+  unsigned int num_pooled_faces;
+  hb_atomic_ptr_t<FT_Face> *pooled_faces;
+  /* As set on ft_face by hb_ft_font_set_funcs(). */
+  FT_F26Dot6 char_width, char_height;
+  FT_Matrix transform;
+};
+
+/* Gives a callback exclusive use of an FT_Face: a free pooled clone if
+ * there is one, or else ft_face itself, under the lock. */
+struct hb_ft_face_lock_t
+{
+  hb_ft_face_lock_t (const hb_ft_font_t *ft_font_) : ft_font (ft_font_), pooled (nullptr)
+  {
+    for (unsigned int i = 0; i < ft_font->num_pooled_faces; i++)
+    {
+      FT_Face face = ft_font->pooled_faces[i].get ();
+      if (face && ft_font->pooled_faces[i].cmpexch (face, nullptr))
+      {
+	pooled = face;
+	slot = i;
+	return;
+      }
+    }
+    ft_font->lock.lock ();
+  }
+  ~hb_ft_face_lock_t ()
+  {
+    if (pooled)
+      ft_font->pooled_faces[slot].cmpexch (nullptr, pooled);
+    else
+      ft_font->lock.unlock ();
+  }
+
+  FT_Face get () const { return pooled ? pooled : ft_font->ft_face; }
+
+  private:
+  const hb_ft_font_t *ft_font;
+  FT_Face pooled;
+  unsigned int slot;
 };
 
 static hb_ft_font_t *
@@ -99,9 +141,21 @@ _hb_ft_font_create (FT_Face ft_face, bool symbol, bool unref)
   ft_font->cached_x_scale.set_relaxed (0);
   ft_font->advance_cache.init ();
 
+  ft_font->transform.xx = ft_font->transform.yy = 1 << 16;
+
   return ft_font;
 }
 
+static void
+_hb_ft_font_fini_face_pool (hb_ft_font_t *ft_font)
+{
+  for (unsigned int i = 0; i < ft_font->num_pooled_faces; i++)
+    FT_Done_Face (ft_font->pooled_faces[i].get ());
+  free (ft_font->pooled_faces);
+  ft_font->pooled_faces = nullptr;
+  ft_font->num_pooled_faces = 0;
+}
+
 static void
 _hb_ft_face_destroy (void *data)
 {
@@ -115,6 +169,8 @@ _hb_ft_font_destroy (void *data)
 
   ft_font->advance_cache.fini ();
 
+  _hb_ft_font_fini_face_pool (ft_font);
+
   if (ft_font->unref)
     _hb_ft_face_destroy (ft_font->ft_face);
 
@@ -144,6 +200,8 @@ hb_ft_font_set_load_flags (hb_font_t *font, int load_flags)
   hb_ft_font_t *ft_font = (hb_ft_font_t *) font->user_data;
 
   ft_font->load_flags = load_flags;
+  /* Hinting changes advances. */
+  ft_font->advance_cache.clear ();
 }
 
 /**
@@ -187,8 +245,9 @@ hb_ft_get_nominal_glyph (hb_font_t *font HB_UNUSED,
 			 void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
-  unsigned int g = FT_Get_Char_Index (ft_font->ft_face, unicode);
+  hb_ft_face_lock_t lock (ft_font);
+  FT_Face ft_face = lock.get ();
+  unsigned int g = FT_Get_Char_Index (ft_face, unicode);
 
   if (unlikely (!g))
   {
@@ -199,7 +258,7 @@ hb_ft_get_nominal_glyph (hb_font_t *font HB_UNUSED,
        * Windows seems to do, and that's hinted about at:
        * https://docs.microsoft.com/en-us/typography/opentype/spec/recom
        * under "Non-Standard (Symbol) Fonts". */
-      g = FT_Get_Char_Index (ft_font->ft_face, 0xF000u + unicode);
+      g = FT_Get_Char_Index (ft_face, 0xF000u + unicode);
       if (!g)
 	return false;
     }
@@ -222,10 +281,11 @@ hb_ft_get_nominal_glyphs (hb_font_t *font HB_UNUSED,
 			  void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
+  hb_ft_face_lock_t lock (ft_font);
+  FT_Face ft_face = lock.get ();
   unsigned int done;
   for (done = 0;
-       done < count && (*first_glyph = FT_Get_Char_Index (ft_font->ft_face, *first_unicode));
+       done < count && (*first_glyph = FT_Get_Char_Index (ft_face, *first_unicode));
        done++)
   {
     first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
@@ -246,8 +306,8 @@ hb_ft_get_variation_glyph (hb_font_t *font HB_UNUSED,
 			   void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
-  unsigned int g = FT_Face_GetCharVariantIndex (ft_font->ft_face, unicode, variation_selector);
+  hb_ft_face_lock_t lock (ft_font);
+  unsigned int g = FT_Face_GetCharVariantIndex (lock.get (), unicode, variation_selector);
 
   if (unlikely (!g))
     return false;
@@ -266,8 +326,6 @@ hb_ft_get_glyph_h_advances (hb_font_t* font, void* font_data,
 			    void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
   int load_flags = ft_font->load_flags;
   int mult = font->x_scale < 0 ? -1 : +1;
 
@@ -277,7 +335,25 @@ hb_ft_get_glyph_h_advances (hb_font_t* font, void* font_data,
     ft_font->cached_x_scale.set (font->x_scale);
   }
 
-  for (unsigned int i = 0; i < count; i++)
+  /* Serve cached advances without waiting for a face. */
+  unsigned int i = 0;
+  for (; i < count; i++)
+  {
+    unsigned int cv;
+    if (!ft_font->advance_cache.get (*first_glyph, &cv))
+      break;
+
+    *first_advance = ((FT_Fixed) cv * mult + (1<<9)) >> 10;
+    first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+    first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
+  }
+  if (i == count)
+    return;
+
+  hb_ft_face_lock_t lock (ft_font);
+  FT_Face ft_face = lock.get ();
+
+  for (; i < count; i++)
   {
     FT_Fixed v = 0;
     hb_codepoint_t glyph = *first_glyph;
@@ -304,10 +380,10 @@ hb_ft_get_glyph_v_advance (hb_font_t *font,
 			   void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
+  hb_ft_face_lock_t lock (ft_font);
   FT_Fixed v;
 
-  if (unlikely (FT_Get_Advance (ft_font->ft_face, glyph, ft_font->load_flags | FT_LOAD_VERTICAL_LAYOUT, &v)))
+  if (unlikely (FT_Get_Advance (lock.get (), glyph, ft_font->load_flags | FT_LOAD_VERTICAL_LAYOUT, &v)))
     return 0;
 
   if (font->y_scale < 0)
@@ -327,8 +403,8 @@ hb_ft_get_glyph_v_origin (hb_font_t *font,
 			  void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
+  hb_ft_face_lock_t lock (ft_font);
+  FT_Face ft_face = lock.get ();
 
   if (unlikely (FT_Load_Glyph (ft_face, glyph, ft_font->load_flags)))
     return false;
@@ -346,17 +422,13 @@ hb_ft_get_glyph_v_origin (hb_font_t *font,
   return true;
 }
 
-static hb_bool_t
-hb_ft_get_glyph_extents (hb_font_t *font,
-			 void *font_data,
-			 hb_codepoint_t glyph,
-			 hb_glyph_extents_t *extents,
-			 void *user_data HB_UNUSED)
+static bool
+_hb_ft_get_glyph_extents (hb_font_t *font,
+			  const hb_ft_font_t *ft_font,
+			  FT_Face ft_face,
+			  hb_codepoint_t glyph,
+			  hb_glyph_extents_t *extents)
 {
-  const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
-
   if (unlikely (FT_Load_Glyph (ft_face, glyph, ft_font->load_flags)))
     return false;
 
@@ -377,6 +449,43 @@ hb_ft_get_glyph_extents (hb_font_t *font,
   return true;
 }
 
+static hb_bool_t
+hb_ft_get_glyph_extents (hb_font_t *font,
+			 void *font_data,
+			 hb_codepoint_t glyph,
+			 hb_glyph_extents_t *extents,
+			 void *user_data HB_UNUSED)
+{
+  const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
+  hb_ft_face_lock_t lock (ft_font);
+  return _hb_ft_get_glyph_extents (font, ft_font, lock.get (), glyph, extents);
+}
+
+static unsigned int
+hb_ft_get_glyph_extents_array (hb_font_t *font,
+			       void *font_data,
+			       unsigned int count,
+			       const hb_codepoint_t *first_glyph,
+			       unsigned int glyph_stride,
+			       hb_glyph_extents_t *first_extents,
+			       unsigned int extents_stride,
+			       void *user_data HB_UNUSED)
+{
+  const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
+  hb_ft_face_lock_t lock (ft_font);
+  FT_Face ft_face = lock.get ();
+
+  unsigned int ret = 0;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    if (_hb_ft_get_glyph_extents (font, ft_font, ft_face, *first_glyph, first_extents))
+      ret++;
+    first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+    first_extents = &StructAtOffsetUnaligned<hb_glyph_extents_t> (first_extents, extents_stride);
+  }
+  return ret;
+}
+
 static hb_bool_t
 hb_ft_get_glyph_contour_point (hb_font_t *font HB_UNUSED,
 			       void *font_data,
@@ -387,8 +496,8 @@ hb_ft_get_glyph_contour_point (hb_font_t *font HB_UNUSED,
 			       void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
+  hb_ft_face_lock_t lock (ft_font);
+  FT_Face ft_face = lock.get ();
 
   if (unlikely (FT_Load_Glyph (ft_face, glyph, ft_font->load_flags)))
       return false;
@@ -413,8 +522,8 @@ hb_ft_get_glyph_name (hb_font_t *font HB_UNUSED,
 		      void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
+  hb_ft_face_lock_t lock (ft_font);
+  FT_Face ft_face = lock.get ();
 
   hb_bool_t ret = !FT_Get_Glyph_Name (ft_face, glyph, name, size);
   if (ret && (size && !*name))
@@ -431,8 +540,8 @@ hb_ft_get_glyph_from_name (hb_font_t *font HB_UNUSED,
 			   void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
+  hb_ft_face_lock_t lock (ft_font);
+  FT_Face ft_face = lock.get ();
 
   if (len < 0)
     *glyph = FT_Get_Name_Index (ft_face, (FT_String *) name);
@@ -464,8 +573,8 @@ hb_ft_get_font_h_extents (hb_font_t *font HB_UNUSED,
 			  void *user_data HB_UNUSED)
 {
   const hb_ft_font_t *ft_font = (const hb_ft_font_t *) font_data;
-  hb_lock_t lock (ft_font->lock);
-  FT_Face ft_face = ft_font->ft_face;
+  hb_ft_face_lock_t lock (ft_font);
+  FT_Face ft_face = lock.get ();
   metrics->ascender = FT_MulFix(ft_face->ascender, ft_face->size->metrics.y_scale);
   metrics->descender = FT_MulFix(ft_face->descender, ft_face->size->metrics.y_scale);
   metrics->line_gap = FT_MulFix( ft_face->height, ft_face->size->metrics.y_scale ) - (metrics->ascender - metrics->descender);
@@ -498,6 +607,7 @@ static struct hb_ft_font_funcs_lazy_loader_t : hb_font_funcs_lazy_loader_t<hb_ft
     //hb_font_funcs_set_glyph_h_origin_func (funcs, hb_ft_get_glyph_h_origin, nullptr, nullptr);
     hb_font_funcs_set_glyph_v_origin_func (funcs, hb_ft_get_glyph_v_origin, nullptr, nullptr);
     hb_font_funcs_set_glyph_extents_func (funcs, hb_ft_get_glyph_extents, nullptr, nullptr);
+    hb_font_funcs_set_glyph_extents_array_func (funcs, hb_ft_get_glyph_extents_array, nullptr, nullptr);
     hb_font_funcs_set_glyph_contour_point_func (funcs, hb_ft_get_glyph_contour_point, nullptr, nullptr);
     hb_font_funcs_set_glyph_name_func (funcs, hb_ft_get_glyph_name, nullptr, nullptr);
     hb_font_funcs_set_glyph_from_name_func (funcs, hb_ft_get_glyph_from_name, nullptr, nullptr);
@@ -675,6 +785,9 @@ hb_ft_font_create (FT_Face           ft_face,
   return font;
 }
 
+static bool
+_hb_ft_font_init_face_pool (hb_ft_font_t *ft_font, unsigned int pool_size);
+
 void
 hb_ft_font_changed (hb_font_t *font)
 {
@@ -684,6 +797,14 @@ hb_ft_font_changed (hb_font_t *font)
   hb_ft_font_t *ft_font = (hb_ft_font_t *) font->user_data;
   FT_Face ft_face = ft_font->ft_face;
 
+  /* Size or variations may have changed without the scale changing. */
+  ft_font->advance_cache.clear ();
+
+  /* Clones must follow ft_face; on failure we are left without a pool. */
+  unsigned int pool_size = ft_font->num_pooled_faces;
+  if (pool_size)
+    _hb_ft_font_init_face_pool (ft_font, pool_size);
+
   hb_font_set_scale (font,
 		     (int) (((uint64_t) ft_face->size->metrics.x_scale * (uint64_t) ft_face->units_per_EM + (1u<<15)) >> 16),
 		     (int) (((uint64_t) ft_face->size->metrics.y_scale * (uint64_t) ft_face->units_per_EM + (1u<<15)) >> 16));
@@ -825,10 +946,12 @@ hb_ft_font_set_funcs (hb_font_t *font)
 		    font->x_ppem * 72 * 64 / font->x_scale,
 		    font->y_ppem * 72 * 64 / font->y_scale);
 #endif
+  FT_Matrix matrix = { 1 << 16, 0,
+			0, 1 << 16};
   if (font->x_scale < 0 || font->y_scale < 0)
   {
-    FT_Matrix matrix = { font->x_scale < 0 ? -1 : +1, 0,
-			  0, font->y_scale < 0 ? -1 : +1};
+    matrix.xx = font->x_scale < 0 ? -1 : +1;
+    matrix.yy = font->y_scale < 0 ? -1 : +1;
     FT_Set_Transform (ft_face, &matrix, nullptr);
   }
 
@@ -853,4 +976,154 @@ hb_ft_font_set_funcs (hb_font_t *font)
 
   _hb_ft_font_set_funcs (font, ft_face, true);
   hb_ft_font_set_load_flags (font, FT_LOAD_DEFAULT | FT_LOAD_NO_HINTING);
+  if (font->destroy == (hb_destroy_func_t) _hb_ft_font_destroy)
+  {
+    hb_ft_font_t *ft_font = (hb_ft_font_t *) font->user_data;
+    ft_font->char_width = abs (font->x_scale);
+    ft_font->char_height = abs (font->y_scale);
+    ft_font->transform = matrix;
+  }
+}
+
+/* Only faces hb_ft_font_set_funcs() opened from the font's blob can be
+ * cloned: their memory and settings are known. */
+static bool
+_hb_ft_font_can_pool_faces (const hb_ft_font_t *ft_font)
+{
+  FT_Face ft_face = ft_font->ft_face;
+  return ft_font->unref &&
+	 !ft_face->stream->read &&
+	 ft_face->generic.finalizer == (FT_Generic_Finalizer) _release_blob;
+}
+
+/* Opens another FT_Face on ft_font's memory, with the same charmap,
+ * size, transform, and variations. */
+static FT_Face
+_hb_ft_font_clone_face (const hb_ft_font_t *ft_font)
+{
+  FT_Face ft_face = ft_font->ft_face;
+  FT_Face clone = nullptr;
+  if (unlikely (FT_New_Memory_Face (get_ft_library (),
+				    ft_face->stream->base,
+				    ft_face->stream->size,
+				    ft_face->face_index,
+				    &clone)))
+    return nullptr;
+
+  if (ft_face->charmap)
+  {
+    FT_Int index = FT_Get_Charmap_Index (ft_face->charmap);
+    if (index >= 0 && index < clone->num_charmaps)
+      FT_Set_Charmap (clone, clone->charmaps[index]);
+  }
+
+  /* Make the same size request, which is what drivers round alike; if
+   * the client resized ft_face since, ask for its scales instead. */
+  FT_Set_Char_Size (clone, ft_font->char_width, ft_font->char_height, 0, 0);
+  if (FT_IS_SCALABLE (ft_face) &&
+      (clone->size->metrics.x_scale != ft_face->size->metrics.x_scale ||
+       clone->size->metrics.y_scale != ft_face->size->metrics.y_scale))
+  {
+    FT_Size_RequestRec request = {FT_SIZE_REQUEST_TYPE_SCALES,
+				  ft_face->size->metrics.x_scale,
+				  ft_face->size->metrics.y_scale,
+				  0, 0};
+    FT_Request_Size (clone, &request);
+  }
+
+  FT_Matrix matrix = ft_font->transform;
+  FT_Set_Transform (clone, &matrix, nullptr);
+
+#if defined(HAVE_FT_GET_VAR_BLEND_COORDINATES) && defined(HAVE_FT_SET_VAR_BLEND_COORDINATES)
+  FT_MM_Var *mm_var = nullptr;
+  if (FT_HAS_MULTIPLE_MASTERS (ft_face) && !FT_Get_MM_Var (ft_face, &mm_var))
+  {
+    FT_Fixed *ft_coords = (FT_Fixed *) calloc (mm_var->num_axis, sizeof (FT_Fixed));
+    if (ft_coords &&
+	!FT_Get_Var_Blend_Coordinates (ft_face, mm_var->num_axis, ft_coords))
+    {
+      /* Like hb_ft_font_set_funcs(), leave default instances alone. */
+      bool nonzero = false;
+      for (unsigned int i = 0; i < mm_var->num_axis; i++)
+	nonzero = nonzero || ft_coords[i];
+      if (nonzero)
+	FT_Set_Var_Blend_Coordinates (clone, mm_var->num_axis, ft_coords);
+    }
+    free (ft_coords);
+#ifdef HAVE_FT_DONE_MM_VAR
+    FT_Done_MM_Var (ft_face->glyph->library, mm_var);
+#else
+    free (mm_var);
+#endif
+  }
+#endif
+
+  return clone;
+}
+
+static bool
+_hb_ft_font_init_face_pool (hb_ft_font_t *ft_font, unsigned int pool_size)
+{
+  _hb_ft_font_fini_face_pool (ft_font);
+  if (!pool_size)
+    return true;
+
+  hb_atomic_ptr_t<FT_Face> *faces = (hb_atomic_ptr_t<FT_Face> *) calloc (pool_size, sizeof (faces[0]));
+  if (unlikely (!faces))
+    return false;
+
+  for (unsigned int i = 0; i < pool_size; i++)
+  {
+    FT_Face clone = _hb_ft_font_clone_face (ft_font);
+    if (unlikely (!clone))
+    {
+      for (unsigned int j = 0; j < i; j++)
+	FT_Done_Face (faces[j].get_relaxed ());
+      free (faces);
+      return false;
+    }
+    faces[i].init (clone);
+  }
+
+  ft_font->pooled_faces = faces;
+  ft_font->num_pooled_faces = pool_size;
+  return true;
+}
+
+/**
+ * hb_ft_font_set_face_pool_size:
+ * @font: a font using hb_ft_font_set_funcs().
+ * @pool_size: number of FT_Face clones to keep, or zero for none.
+ *
+ * An FT_Face can only be used by one thread at a time, so by default the
+ * FreeType font functions serialize on a lock, and threads shaping with
+ * the same @font wait for each other.  This function gives @font a pool
+ * of @pool_size extra FT_Face objects over the same font data, with the
+ * same size and variations.  Each font function call checks out a free
+ * one, and only falls back to the lock when all of them are in use; a
+ * pool as large as the number of threads sharing @font avoids contention
+ * altogether.
+ *
+ * Only fonts set up with hb_ft_font_set_funcs() can use a pool.  The pool
+ * is rebuilt by hb_ft_font_changed().  This function is not thread-safe:
+ * call it before @font is shared between threads.
+ *
+ * Return value: %true if the pool was set up.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_ft_font_set_face_pool_size (hb_font_t *font, unsigned int pool_size)
+{
+  if (hb_object_is_immutable (font))
+    return false;
+
+  if (font->destroy != (hb_destroy_func_t) _hb_ft_font_destroy)
+    return false;
+
+  hb_ft_font_t *ft_font = (hb_ft_font_t *) font->user_data;
+  if (!_hb_ft_font_can_pool_faces (ft_font))
+    return false;
+
+  return _hb_ft_font_init_face_pool (ft_font, pool_size);
 }
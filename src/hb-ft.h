@@ -126,6 +126,9 @@ hb_ft_font_changed (hb_font_t *font);
 HB_EXTERN void
 hb_ft_font_set_funcs (hb_font_t *font);
 
+HB_EXTERN hb_bool_t
+hb_ft_font_set_face_pool_size (hb_font_t *font, unsigned int pool_size);
+
 
 HB_END_DECLS
 
@@ -85,6 +85,15 @@ HB_EXTERN GType
 hb_gobject_font_funcs_get_type (void);
 #define HB_GOBJECT_TYPE_FONT_FUNCS (hb_gobject_font_funcs_get_type ())
 
+/**
+ * hb_gobject_font_cache_get_type:
+ *
+ * Since: REPLACEME
+ **/
+HB_EXTERN GType
+hb_gobject_font_cache_get_type (void);
+#define HB_GOBJECT_TYPE_FONT_CACHE (hb_gobject_font_cache_get_type ())
+
 HB_EXTERN GType
 hb_gobject_set_get_type (void);
 #define HB_GOBJECT_TYPE_SET (hb_gobject_set_get_type ())
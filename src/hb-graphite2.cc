@@ -128,6 +128,15 @@ static void hb_graphite2_release_table(const void *data, const void *table_buffe
 
 static gr_face_ops hb_graphite2_face_ops = { sizeof(gr_face_ops), hb_graphite2_get_table, hb_graphite2_release_table };
 
+/* gr_face_preloadAll reads the attributes of every glyph when the face
+ * is created, which is slow and memory-heavy for large Graphite fonts.
+ * By default only the cmap is cached up front and glyphs are loaded, and
+ * kept, as shaping first needs them.  Define to gr_face_preloadAll to get
+ * the old behavior back. */
+#ifndef HB_GRAPHITE2_FACE_OPTIONS
+#define HB_GRAPHITE2_FACE_OPTIONS gr_face_cacheCmap
+#endif
+
 hb_graphite2_face_data_t *
 _hb_graphite2_shaper_face_data_create (hb_face_t *face)
 {
@@ -146,7 +155,7 @@ _hb_graphite2_shaper_face_data_create (hb_face_t *face)
     return nullptr;
 
   data->face = face;
-  data->grface = gr_make_face_with_ops (data, &hb_graphite2_face_ops, gr_face_preloadAll);
+  data->grface = gr_make_face_with_ops (data, &hb_graphite2_face_ops, HB_GRAPHITE2_FACE_OPTIONS);
 
   if (unlikely (!data->grface)) {
     free (data);
@@ -193,6 +193,11 @@ struct hb_lazy_loader_t : hb_data_wrapper_t<Data, WheresData>
   {
   retry:
     Stored *p = instance.get ();
+    if (unlikely (p == get_busy ()))
+    {
+      HB_SCHED_YIELD ();
+      goto retry;
+    }
     if (unlikely (p && !cmpexch (p, nullptr)))
       goto retry;
     do_destroy (p);
@@ -200,7 +205,7 @@ struct hb_lazy_loader_t : hb_data_wrapper_t<Data, WheresData>
 
   static void do_destroy (Stored *p)
   {
-    if (p && p != const_cast<Stored *> (Funcs::get_null ()))
+    if (p && p != get_busy () && p != const_cast<Stored *> (Funcs::get_null ()))
       Funcs::destroy (p);
   }
 
@@ -214,11 +219,32 @@ struct hb_lazy_loader_t : hb_data_wrapper_t<Data, WheresData>
   {
   retry:
     Stored *p = this->instance.get ();
+    if (Funcs::create_once () && unlikely (p == get_busy ()))
+    {
+      /* Another thread is creating it. */
+      HB_SCHED_YIELD ();
+      goto retry;
+    }
     if (unlikely (!p))
     {
       if (unlikely (this->is_inert ()))
 	return const_cast<Stored *> (Funcs::get_null ());
 
+      if (Funcs::create_once ())
+      {
+	/* Claim the slot before creating, so that threads arriving
+	 * meanwhile wait for this one instead of creating their own. */
+	if (!cmpexch (nullptr, get_busy ()))
+	  goto retry;
+
+	p = this->template call_create<Stored, Funcs> ();
+	if (unlikely (!p))
+	  p = const_cast<Stored *> (Funcs::get_null ());
+
+	cmpexch (get_busy (), p);
+	return p;
+      }
+
       p = this->template call_create<Stored, Funcs> ();
       if (unlikely (!p))
 	p = const_cast<Stored *> (Funcs::get_null ());
@@ -233,7 +259,15 @@ struct hb_lazy_loader_t : hb_data_wrapper_t<Data, WheresData>
   }
   Stored * get_stored_relaxed () const
   {
-    return this->instance.get_relaxed ();
+    Stored *p = this->instance.get_relaxed ();
+    return unlikely (p == get_busy ()) ? nullptr : p;
+  }
+  /* Safe to look into while another thread may be creating it; never
+   * creates the instance itself. */
+  Stored * get_stored_if_created () const
+  {
+    Stored *p = this->instance.get ();
+    return unlikely (p == get_busy ()) ? nullptr : p;
   }
 
   bool cmpexch (Stored *current, Stored *value) const
@@ -246,9 +280,17 @@ struct hb_lazy_loader_t : hb_data_wrapper_t<Data, WheresData>
   const Returned * get_relaxed () const { return Funcs::convert (get_stored_relaxed ()); }
   Returned * get_unconst () const { return const_cast<Returned *> (Funcs::convert (get_stored ())); }
 
+  /* Stands in for the instance while one thread is creating it. */
+  static Stored *get_busy () { return (Stored *) (uintptr_t) 1; }
+
   /* To be possibly overloaded by subclasses. */
   static Returned* convert (Stored *p) { return p; }
 
+  /* Whether to create the instance on one thread only while others wait,
+   * instead of letting each create its own and keeping the first.  Worth
+   * it when creation is expensive; creating must not need this loader. */
+  static constexpr bool create_once () { return false; }
+
   /* By default null/init/fini the object. */
   static const Stored* get_null () { return &Null(Stored); }
   static Stored *create (Data *data)
@@ -281,7 +323,28 @@ struct hb_lazy_loader_t : hb_data_wrapper_t<Data, WheresData>
 template <typename T, unsigned int WheresFace>
 struct hb_face_lazy_loader_t : hb_lazy_loader_t<T,
 						hb_face_lazy_loader_t<T, WheresFace>,
-						hb_face_t, WheresFace> {};
+						hb_face_t, WheresFace>
+{
+  static constexpr bool create_once () { return true; }
+
+  static T *create (hb_face_t *face)
+  {
+    HB_ALLOC_STATS_SCOPE (ACCELERATOR);
+    T *p = (T *) calloc (1, sizeof (T));
+    if (likely (p))
+      p->init (face);
+    return p;
+  }
+
+  /* Only counts what is already loaded. */
+  void add_memory_usage (hb_memory_usage_t *usage) const
+  {
+    const T *p = this->get_stored_if_created ();
+    if (!p || p == &Null (T)) return;
+    usage->heap += sizeof (T);
+    p->add_memory_usage (usage);
+  }
+};
 
 template <typename T, unsigned int WheresFace>
 struct hb_table_lazy_loader_t : hb_lazy_loader_t<T,
@@ -289,6 +352,8 @@ struct hb_table_lazy_loader_t : hb_lazy_loader_t<T,
 						 hb_face_t, WheresFace,
 						 hb_blob_t>
 {
+  static constexpr bool create_once () { return true; }
+
   static hb_blob_t *create (hb_face_t *face)
   { return hb_sanitize_context_t ().reference_table<T> (face); }
   static void destroy (hb_blob_t *p) { hb_blob_destroy (p); }
@@ -300,6 +365,9 @@ struct hb_table_lazy_loader_t : hb_lazy_loader_t<T,
   { return blob->as<T> (); }
 
   hb_blob_t* get_blob () const { return this->get_stored (); }
+
+  void add_memory_usage (hb_memory_usage_t *usage) const
+  { usage->add_blob (this->get_stored_if_created ()); }
 };
 
 template <typename Subclass>
@@ -28,6 +28,7 @@
 #define HB_MAP_HH
 
 #include "hb.hh"
+#include "hb-vector.hh"
 
 
 /*
@@ -46,10 +47,8 @@ struct hb_hashmap_t
   static_assert (hb_is_integer (K) || hb_is_pointer (K), "");
   static_assert (hb_is_integer (V) || hb_is_pointer (V), "");
 
-  /* TODO If key type is a pointer, keep hash in item_t and use to:
-   * 1. avoid rehashing when resizing table, and
-   * 2. compare hash before comparing keys, for speed.
-   */
+  /* TODO If key type is a pointer, keep hash in item_t and use to
+   * avoid rehashing when resizing table. */
   struct item_t
   {
     K key;
@@ -59,27 +58,34 @@ struct hb_hashmap_t
 
     bool operator == (K o) { return hb_deref (key) == hb_deref (o); }
     bool operator == (const item_t &o) { return *this == o.key; }
-    bool is_unused () const    { return key == kINVALID; }
-    bool is_tombstone () const { return key != kINVALID && value == vINVALID; }
     bool is_real () const { return key != kINVALID && value != vINVALID; }
     hb_pair_t<K, V> get_pair() const { return hb_pair_t<K, V> (key, value); }
   };
 
+  /* Next to the items, each slot has a tag byte: seven bits of the hash
+   * of its key, or one of the values below for free slots.  Slots are
+   * probed a group at a time, comparing all of the group's tags at once
+   * (using SSE2 where available), so items are only looked at on a tag
+   * match.  Deleted slots don't end a probe; empty ones do. */
+  static constexpr uint8_t TAG_EMPTY = 0x80;
+  static constexpr uint8_t TAG_DELETED = 0xFE;
+  static constexpr unsigned int GROUP_SIZE = 16;
+
   hb_object_header_t header;
   bool successful; /* Allocations successful */
-  unsigned int population; /* Not including tombstones. */
-  unsigned int occupancy; /* Including tombstones. */
+  unsigned int population; /* Not including deleted slots. */
+  unsigned int occupancy; /* Including deleted slots. */
   unsigned int mask;
-  unsigned int prime;
   item_t *items;
+  uint8_t *tags;
 
   void init_shallow ()
   {
     successful = true;
     population = occupancy = 0;
     mask = 0;
-    prime = 0;
     items = nullptr;
+    tags = nullptr;
   }
   void init ()
   {
@@ -90,6 +96,7 @@ struct hb_hashmap_t
   {
     free (items);
     items = nullptr;
+    tags = nullptr;
     population = occupancy = 0;
   }
   void fini ()
@@ -112,9 +119,11 @@ struct hb_hashmap_t
   {
     if (unlikely (!successful)) return false;
 
+    /* At least 16 slots; one group. */
     unsigned int power = hb_bit_storage (population * 2 + 8);
     unsigned int new_size = 1u << power;
-    item_t *new_items = (item_t *) malloc ((size_t) new_size * sizeof (item_t));
+    /* Tags go right after the items, in the same allocation. */
+    item_t *new_items = (item_t *) malloc ((size_t) new_size * (sizeof (item_t) + 1));
     if (unlikely (!new_items))
     {
       successful = false;
@@ -130,14 +139,15 @@ struct hb_hashmap_t
     /* Switch to new, empty, array. */
     population = occupancy = 0;
     mask = new_size - 1;
-    prime = prime_for (power);
     items = new_items;
+    tags = (uint8_t *) (new_items + new_size);
+    memset (tags, TAG_EMPTY, new_size);
 
     /* Insert back old items. */
     if (old_items)
       for (unsigned int i = 0; i < old_size; i++)
 	if (old_items[i].is_real ())
-	  set (old_items[i].key, old_items[i].value);
+	  insert (old_items[i].key, old_items[i].value, hash_for (old_items[i].key));
 
     free (old_items);
 
@@ -148,32 +158,44 @@ struct hb_hashmap_t
   {
     if (unlikely (!successful)) return;
     if (unlikely (key == kINVALID)) return;
-    if ((occupancy + occupancy / 2) >= mask && !resize ()) return;
-    unsigned int i = bucket_for (key);
-
-    if (value == vINVALID && items[i].key != key)
-      return; /* Trying to delete non-existent key. */
+    uint32_t hash = hash_for (key);
 
-    if (!items[i].is_unused ())
+    unsigned int free_slot = (unsigned int) -1;
+    if (items)
     {
-      occupancy--;
-      if (items[i].is_tombstone ())
-	population--;
+      unsigned int i = find (key, hash, &free_slot);
+      if (i != (unsigned int) -1)
+      {
+	if (value == vINVALID)
+	  erase (i);
+	else
+	  items[i].value = value;
+	return;
+      }
     }
 
-    items[i].key = key;
-    items[i].value = value;
-
-    occupancy++;
-    if (!items[i].is_tombstone ())
-      population++;
+    if (value == vINVALID)
+      return; /* Trying to delete non-existent key. */
 
+    if (free_slot == (unsigned int) -1 || tags[free_slot] == TAG_EMPTY)
+    {
+      if (occupancy >= max_occupancy ())
+      {
+	if (!resize ()) return;
+	free_slot = find_free (hash);
+      }
+      occupancy++;
+    }
+    population++;
+    tags[free_slot] = tag_for (hash);
+    items[free_slot].key = key;
+    items[free_slot].value = value;
   }
   V get (K key) const
   {
     if (unlikely (!items)) return vINVALID;
-    unsigned int i = bucket_for (key);
-    return items[i].is_real () && items[i] == key ? items[i].value : vINVALID;
+    unsigned int i = find (key, hash_for (key));
+    return i == (unsigned int) -1 ? vINVALID : items[i].value;
   }
 
   void del (K key) { set (key, vINVALID); }
@@ -196,9 +218,12 @@ struct hb_hashmap_t
     if (unlikely (hb_object_is_immutable (this)))
       return;
     if (items)
+    {
       + hb_iter (items, mask + 1)
       | hb_apply (&item_t::clear)
       ;
+      memset (tags, TAG_EMPTY, mask + 1);
+    }
 
     population = occupancy = 0;
   }
@@ -207,6 +232,10 @@ struct hb_hashmap_t
 
   unsigned int get_population () const { return population; }
 
+  /* Bytes held by the slot array and its tags. */
+  unsigned int get_heap_size () const
+  { return mask ? (mask + 1) * (sizeof (item_t) + 1) : 0; }
+
   /*
    * Iterator
    */
@@ -233,71 +262,111 @@ struct hb_hashmap_t
 
   protected:
 
-  unsigned int bucket_for (K key) const
+  /* Up to 7/8 of the slots, deleted ones included, are used. */
+  unsigned int max_occupancy () const
+  { return mask ? (mask + 1) - (mask + 1) / 8 : 0; }
+
+  /* Groups come from the low bits of the hash and tags from the top ones;
+   * hb_hash() of integers is multiplicative, so fold the top bits down. */
+  static uint32_t hash_for (K key)
+  {
+    uint32_t h = hb_hash (key);
+    return h ^ (h >> 15);
+  }
+  static uint8_t tag_for (uint32_t hash) { return hash >> 25; }
+
+  /* Bit i is set if the tag of slot i of group is tag. */
+  static unsigned int group_match (const uint8_t *group, uint8_t tag)
+  {
+#if defined(HB_SIMD_AVX2) || defined(HB_SIMD_SSE2)
+    __m128i v = _mm_loadu_si128 ((const __m128i *) group);
+    return _mm_movemask_epi8 (_mm_cmpeq_epi8 (v, _mm_set1_epi8 ((char) tag)));
+#else
+    unsigned int bits = 0;
+    for (unsigned int i = 0; i < GROUP_SIZE; i++)
+      bits |= (unsigned int) (group[i] == tag) << i;
+    return bits;
+#endif
+  }
+  /* Bit i is set if slot i of group is empty or deleted; these are the
+   * only tags with the high bit set. */
+  static unsigned int group_match_free (const uint8_t *group)
+  {
+#if defined(HB_SIMD_AVX2) || defined(HB_SIMD_SSE2)
+    return _mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i *) group));
+#else
+    unsigned int bits = 0;
+    for (unsigned int i = 0; i < GROUP_SIZE; i++)
+      bits |= (unsigned int) (group[i] >> 7) << i;
+    return bits;
+#endif
+  }
+
+  /* Probing goes over groups in triangular steps, which visits all of
+   * them since their number is a power of two.  If free_slot is given,
+   * it is set to the first empty or deleted slot on the way. */
+  unsigned int find (K key, uint32_t hash, unsigned int *free_slot = nullptr) const
   {
-    unsigned int i = hb_hash (key) % prime;
-    unsigned int step = 0;
-    unsigned int tombstone = (unsigned) -1;
-    while (!items[i].is_unused ())
+    unsigned int group_mask = mask / GROUP_SIZE;
+    uint8_t tag = tag_for (hash);
+    unsigned int g = hash & group_mask;
+    for (unsigned int step = 0; step <= group_mask; g = (g + ++step) & group_mask)
     {
-      if (items[i] == key)
-	return i;
-      if (tombstone == (unsigned) -1 && items[i].is_tombstone ())
-	tombstone = i;
-      i = (i + ++step) & mask;
+      const uint8_t *group = tags + g * GROUP_SIZE;
+      for (unsigned int bits = group_match (group, tag); bits; bits &= bits - 1)
+      {
+	unsigned int i = g * GROUP_SIZE + hb_ctz (bits);
+	if (items[i] == key)
+	  return i;
+      }
+      if (free_slot && *free_slot == (unsigned int) -1)
+      {
+	unsigned int bits = group_match_free (group);
+	if (bits)
+	  *free_slot = g * GROUP_SIZE + hb_ctz (bits);
+      }
+      if (group_match (group, TAG_EMPTY))
+	break;
     }
-    return tombstone == (unsigned) -1 ? i : tombstone;
+    return (unsigned int) -1;
   }
 
-  static unsigned int prime_for (unsigned int shift)
+  /* There must be one, which max_occupancy() makes sure of. */
+  unsigned int find_free (uint32_t hash) const
   {
-    /* Following comment and table copied from glib. */
-    /* Each table size has an associated prime modulo (the first prime
-     * lower than the table size) used to find the initial bucket. Probing
-     * then works modulo 2^n. The prime modulo is necessary to get a
-     * good distribution with poor hash functions.
-     */
-    /* Not declaring static to make all kinds of compilers happy... */
-    /*static*/ const unsigned int prime_mod [32] =
+    unsigned int group_mask = mask / GROUP_SIZE;
+    unsigned int g = hash & group_mask;
+    unsigned int bits;
+    for (unsigned int step = 0; !(bits = group_match_free (tags + g * GROUP_SIZE)); )
+      g = (g + ++step) & group_mask;
+    return g * GROUP_SIZE + hb_ctz (bits);
+  }
+
+  /* key must not be in the map, and there must be room. */
+  void insert (K key, V value, uint32_t hash)
+  {
+    unsigned int i = find_free (hash);
+    if (tags[i] == TAG_EMPTY)
+      occupancy++;
+    population++;
+    tags[i] = tag_for (hash);
+    items[i].key = key;
+    items[i].value = value;
+  }
+
+  void erase (unsigned int i)
+  {
+    /* No probe ever went past a group that has an empty slot, so the
+     * slot can go back to empty then. */
+    if (group_match (tags + (i & ~(GROUP_SIZE - 1)), TAG_EMPTY))
     {
-      1,          /* For 1 << 0 */
-      2,
-      3,
-      7,
-      13,
-      31,
-      61,
-      127,
-      251,
-      509,
-      1021,
-      2039,
-      4093,
-      8191,
-      16381,
-      32749,
-      65521,      /* For 1 << 16 */
-      131071,
-      262139,
-      524287,
-      1048573,
-      2097143,
-      4194301,
-      8388593,
-      16777213,
-      33554393,
-      67108859,
-      134217689,
-      268435399,
-      536870909,
-      1073741789,
-      2147483647  /* For 1 << 31 */
-    };
-
-    if (unlikely (shift >= ARRAY_LENGTH (prime_mod)))
-      return prime_mod[ARRAY_LENGTH (prime_mod) - 1];
-
-    return prime_mod[shift];
+      tags[i] = TAG_EMPTY;
+      occupancy--;
+    }
+    else
+      tags[i] = TAG_DELETED;
+    population--;
+    items[i].clear ();
   }
 };
 
@@ -311,4 +380,102 @@ struct hb_map_t : hb_hashmap_t<hb_codepoint_t,
 			       HB_MAP_VALUE_INVALID> {};
 
 
+/*
+ * hb_glyph_map_t
+ */
+
+/* Glyph id to glyph id map, in a plain array indexed by the key.  Glyph
+ * ids fit 16 bits and the keys are bounded by num_glyphs, so this takes
+ * less room than hb_map_t for anything but very sparse maps, and lookups
+ * don't hash.  Has the same interface as hb_map_t, less iteration. */
+struct hb_glyph_map_t
+{
+  HB_DELETE_COPY_ASSIGN (hb_glyph_map_t);
+  hb_glyph_map_t ()  { init (); }
+  ~hb_glyph_map_t () { fini (); }
+
+  void init ()
+  {
+    population = 0;
+    array.init ();
+  }
+  void fini ()
+  {
+    population = 0;
+    array.fini ();
+  }
+
+  bool in_error () const { return array.in_error (); }
+
+  /* Makes room for keys below num_keys. */
+  bool alloc (unsigned int num_keys) { return array.alloc (num_keys); }
+
+  void set (hb_codepoint_t key, hb_codepoint_t value)
+  {
+    if (unlikely (key >= INVALID)) return;
+    if (value == HB_MAP_VALUE_INVALID)
+    {
+      del (key);
+      return;
+    }
+    if (unlikely (value >= INVALID)) return;
+
+    if (key >= array.length)
+    {
+      unsigned int old_length = array.length;
+      if (unlikely (!array.resize (key + 1))) return;
+      memset (array.arrayZ () + old_length, 0xFF, (key + 1 - old_length) * array.item_size);
+    }
+    uint16_t &v = array.arrayZ ()[key];
+    if (v == INVALID)
+      population++;
+    v = value;
+  }
+  hb_codepoint_t get (hb_codepoint_t key) const
+  {
+    if (unlikely (key >= array.length)) return HB_MAP_VALUE_INVALID;
+    uint16_t v = array.arrayZ ()[key];
+    return likely (v != INVALID) ? v : HB_MAP_VALUE_INVALID;
+  }
+
+  void del (hb_codepoint_t key)
+  {
+    if (unlikely (key >= array.length)) return;
+    uint16_t &v = array.arrayZ ()[key];
+    if (v != INVALID)
+      population--;
+    v = INVALID;
+  }
+
+  /* Has interface. */
+  static constexpr hb_codepoint_t SENTINEL = HB_MAP_VALUE_INVALID;
+  typedef hb_codepoint_t value_t;
+  value_t operator [] (hb_codepoint_t k) const { return get (k); }
+  bool has (hb_codepoint_t k, hb_codepoint_t *vp = nullptr) const
+  {
+    hb_codepoint_t v = (*this)[k];
+    if (vp) *vp = v;
+    return v != SENTINEL;
+  }
+  /* Projection. */
+  hb_codepoint_t operator () (hb_codepoint_t k) const { return get (k); }
+
+  void clear ()
+  {
+    population = 0;
+    array.resize (0);
+  }
+
+  bool is_empty () const { return population == 0; }
+
+  unsigned int get_population () const { return population; }
+
+  protected:
+  static constexpr uint16_t INVALID = 0xFFFFu;
+
+  unsigned int population;
+  hb_vector_t<uint16_t> array;
+};
+
+
 #endif /* HB_MAP_HH */
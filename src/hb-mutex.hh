@@ -123,6 +123,20 @@ typedef int hb_mutex_impl_t;
 #endif
 
 
+#ifndef HB_SCHED_YIELD
+#if !defined(HB_NO_MT) && defined(_WIN32)
+# include <windows.h>
+# define HB_SCHED_YIELD() SwitchToThread ()
+#elif !defined(HB_NO_MT) && (defined(HAVE_PTHREAD) || defined(__APPLE__) || \
+			     (defined(HAVE_SCHED_H) && defined(HAVE_SCHED_YIELD)))
+# include <sched.h>
+# define HB_SCHED_YIELD() sched_yield ()
+#else
+# define HB_SCHED_YIELD() HB_STMT_START {} HB_STMT_END
+#endif
+#endif
+
+
 #define HB_MUTEX_INIT		{HB_MUTEX_IMPL_INIT}
 
 struct hb_mutex_t
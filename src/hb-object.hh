@@ -38,104 +38,6 @@
 #include "hb-vector.hh"
 
 
-/*
- * Lockable set
- */
-
-template <typename item_t, typename lock_t>
-struct hb_lockable_set_t
-{
-  hb_vector_t<item_t> items;
-
-  void init () { items.init (); }
-
-  template <typename T>
-  item_t *replace_or_insert (T v, lock_t &l, bool replace)
-  {
-    l.lock ();
-    item_t *item = items.find (v);
-    if (item) {
-      if (replace) {
-	item_t old = *item;
-	*item = v;
-	l.unlock ();
-	old.fini ();
-      }
-      else {
-        item = nullptr;
-	l.unlock ();
-      }
-    } else {
-      item = items.push (v);
-      l.unlock ();
-    }
-    return item;
-  }
-
-  template <typename T>
-  void remove (T v, lock_t &l)
-  {
-    l.lock ();
-    item_t *item = items.find (v);
-    if (item)
-    {
-      item_t old = *item;
-      *item = items[items.length - 1];
-      items.pop ();
-      l.unlock ();
-      old.fini ();
-    } else {
-      l.unlock ();
-    }
-  }
-
-  template <typename T>
-  bool find (T v, item_t *i, lock_t &l)
-  {
-    l.lock ();
-    item_t *item = items.find (v);
-    if (item)
-      *i = *item;
-    l.unlock ();
-    return !!item;
-  }
-
-  template <typename T>
-  item_t *find_or_insert (T v, lock_t &l)
-  {
-    l.lock ();
-    item_t *item = items.find (v);
-    if (!item) {
-      item = items.push (v);
-    }
-    l.unlock ();
-    return item;
-  }
-
-  void fini (lock_t &l)
-  {
-    if (!items.length)
-    {
-      /* No need to lock. */
-      items.fini ();
-      return;
-    }
-    l.lock ();
-    while (items.length)
-    {
-      item_t old = items[items.length - 1];
-      items.pop ();
-      l.unlock ();
-      old.fini ();
-      l.lock ();
-    }
-    items.fini ();
-    l.unlock ();
-  }
-
-};
-
-
 /*
  * Reference-count.
  */
@@ -161,23 +63,36 @@ struct hb_reference_count_t
 
 /* user_data */
 
+/* Items are only ever appended, and never move: clearing one keeps its
+ * key in place for when it is set again.  So get() reads without the
+ * lock, from the last published table; set() takes the lock, and when the
+ * table is full publishes a copy twice as large.  Replaced tables are
+ * kept until fini(), as readers may still be looking at them. */
 struct hb_user_data_array_t
 {
   struct hb_user_data_item_t {
     hb_user_data_key_t *key;
-    void *data;
+    hb_atomic_ptr_t<void> data;
+    /* Only accessed with the lock held. */
     hb_destroy_func_t destroy;
+    bool is_set;
+  };
 
-    bool operator == (hb_user_data_key_t *other_key) const { return key == other_key; }
-    bool operator == (hb_user_data_item_t &other) const { return key == other.key; }
+  struct table_t
+  {
+    static unsigned int get_size (unsigned int allocated)
+    { return offsetof (table_t, items) + allocated * sizeof (hb_user_data_item_t); }
 
-    void fini () { if (destroy) destroy (data); }
+    table_t *prev; /* The table this one replaced. */
+    unsigned int allocated;
+    hb_atomic_int_t length;
+    hb_user_data_item_t items[VAR];
   };
 
   hb_mutex_t lock;
-  hb_lockable_set_t<hb_user_data_item_t, hb_mutex_t> items;
+  hb_atomic_ptr_t<table_t> table;
 
-  void init () { lock.init (); items.init (); }
+  void init () { lock.init (); table.init (); }
 
   HB_INTERNAL bool set (hb_user_data_key_t *key,
 			void *              data,
@@ -186,7 +101,7 @@ struct hb_user_data_array_t
 
   HB_INTERNAL void *get (hb_user_data_key_t *key);
 
-  void fini () { items.fini (lock); lock.fini (); }
+  HB_INTERNAL void fini ();
 };
 
 
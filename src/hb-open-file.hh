@@ -186,6 +186,58 @@ typedef struct OffsetTable
     return_trace (true);
   }
 
+  /* Like serialize(), but only writes the header and table records, for
+   * the tables to be written after them by the caller, in items order and
+   * each padded to four bytes.  Returns the checkSumAdjustment to write
+   * into head, if there is one, in *checksum_adjustment. */
+  template <typename item_t>
+  bool serialize_directory (hb_serialize_context_t *c,
+			    hb_tag_t sfnt_tag,
+			    hb_array_t<item_t> items,
+			    uint32_t *checksum_adjustment)
+  {
+    TRACE_SERIALIZE (this);
+    if (unlikely (!c->extend_min (*this))) return_trace (false);
+    sfnt_version = sfnt_tag;
+    if (unlikely (!tables.serialize (c, items.length))) return_trace (false);
+
+    unsigned int offset = c->head - (const char *) this;
+    bool has_head = false;
+    for (unsigned int i = 0; i < tables.len; i++)
+    {
+      TableRecord &rec = tables.arrayZ[i];
+      unsigned int length;
+      const char *data = hb_blob_get_data (items[i].blob, &length);
+      rec.tag = items[i].tag;
+      rec.length = length;
+      rec.offset = offset;
+      rec.checkSum.set_for_unpadded_data (data, length);
+
+      if (items[i].tag == HB_OT_TAG_head &&
+	  hb_ceil_to_4 (length) >= head::static_size)
+      {
+	/* Summed with checkSumAdjustment zeroed, as serialize() does. */
+	has_head = true;
+	rec.checkSum = rec.checkSum - ((const head *) data)->checkSumAdjustment;
+      }
+
+      offset += hb_ceil_to_4 (length);
+    }
+
+    tables.qsort ();
+
+    if (has_head)
+    {
+      CheckSum checksum;
+      checksum.set_for_data (this, c->head - (const char *) this);
+      for (unsigned int i = 0; i < tables.len; i++)
+	checksum = checksum + tables.arrayZ[i].checkSum;
+      *checksum_adjustment = 0xB1B0AFBAu - checksum;
+    }
+
+    return_trace (true);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -492,6 +544,18 @@ struct OpenTypeFontFile
     return_trace (u.fontFace.serialize (c, sfnt_tag, items));
   }
 
+  template <typename item_t>
+  bool serialize_single_directory (hb_serialize_context_t *c,
+				   hb_tag_t sfnt_tag,
+				   hb_array_t<item_t> items,
+				   uint32_t *checksum_adjustment)
+  {
+    TRACE_SERIALIZE (this);
+    assert (sfnt_tag != TTCTag);
+    if (unlikely (!c->extend_min (*this))) return_trace (false);
+    return_trace (u.fontFace.serialize_directory (c, sfnt_tag, items, checksum_adjustment));
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -215,6 +215,16 @@ struct CheckSum : HBUINT32
   void set_for_data (const void *data, unsigned int length)
   { *this = CalcTableChecksum ((const HBUINT32 *) data, length); }
 
+  /* For data without the padding; it is summed as if zero-padded. */
+  void set_for_unpadded_data (const void *data, unsigned int length)
+  {
+    const char *p = (const char *) data;
+    uint32_t sum = CalcTableChecksum ((const HBUINT32 *) p, length & ~3u);
+    for (unsigned int i = length & ~3u; i < length; i++)
+      sum += (uint32_t) (uint8_t) p[i] << (24 - 8 * (i & 3));
+    *this = sum;
+  }
+
   public:
   DEFINE_SIZE_STATIC (4);
 };
@@ -625,14 +625,41 @@ struct FDSelect3_4 {
     return_trace (true);
   }
 
-  hb_codepoint_t get_fd (hb_codepoint_t glyph) const
+  /* Index of the last range starting at or before glyph; sanitize ()
+   * ensures ranges are sorted and the first one starts at glyph 0. */
+  unsigned int find_range (hb_codepoint_t glyph) const
   {
-    unsigned int i;
-    for (i = 1; i < nRanges (); i++)
-      if (glyph < ranges[i].first)
-	break;
+    unsigned int lo = 0, hi = nRanges ();
+    while (hi - lo > 1)
+    {
+      unsigned int mid = (lo + hi) / 2;
+      if (glyph < ranges[mid].first)
+	hi = mid;
+      else
+	lo = mid;
+    }
+    return lo;
+  }
 
-    return (hb_codepoint_t)ranges[i - 1].fd;
+  hb_codepoint_t get_fd (hb_codepoint_t glyph) const
+  { return (hb_codepoint_t)ranges[find_range (glyph)].fd; }
+
+  /* Like get_fd (), but starts from, and leaves in range, the range of
+   * the previous lookup.  Glyphs looked up in increasing order only step
+   * through the ranges. */
+  hb_codepoint_t get_fd (hb_codepoint_t glyph, unsigned int &range) const
+  {
+    unsigned int count = nRanges ();
+    if (unlikely (range >= count || glyph < ranges[range].first))
+      range = find_range (glyph);
+    else if (range + 1 < count && glyph >= ranges[range + 1].first)
+    {
+      /* Step into the next range; search if glyph is past that too. */
+      range++;
+      if (range + 1 < count && glyph >= ranges[range + 1].first)
+	range = find_range (glyph);
+    }
+    return (hb_codepoint_t)ranges[range].fd;
   }
 
   GID_TYPE &nRanges () { return ranges.len; }
@@ -693,6 +720,16 @@ struct FDSelect {
       return u.format3.get_fd (glyph);
   }
 
+  hb_codepoint_t get_fd (hb_codepoint_t glyph, unsigned int &range) const
+  {
+    if (this == &Null(FDSelect))
+      return 0;
+    if (format == 0)
+      return u.format0.get_fd (glyph);
+    else
+      return u.format3.get_fd (glyph, range);
+  }
+
   HBUINT8       format;
   union {
     FDSelect0   format0;
@@ -702,6 +739,76 @@ struct FDSelect {
   DEFINE_SIZE_MIN (1);
 };
 
+/* Fonts with at most this many glyphs, and at most 256 font dicts, get a
+ * byte per glyph mapping it to its font dict, built on the first lookup. */
+#ifndef HB_CFF_FDSELECT_CACHE_MAX_GLYPHS
+#define HB_CFF_FDSELECT_CACHE_MAX_GLYPHS 65536
+#endif
+
+/* Resolves glyphs to font dicts through an FDSelect of format 3 or 4,
+ * whose range tables would otherwise be searched for every glyph. */
+template <typename FDSELECT>
+struct fdselect_cache_t
+{
+  void init ()
+  {
+    fdSelect = &Null (FDSELECT);
+    num_glyphs = 0;
+    cacheable = false;
+    fds.init ();
+  }
+
+  void init (const FDSELECT *fdSelect_, unsigned int num_glyphs_, unsigned int fdCount)
+  {
+    init ();
+    fdSelect = fdSelect_;
+    num_glyphs = num_glyphs_;
+    cacheable = fdSelect != &Null (FDSELECT) && fdSelect->format != 0 &&
+		fdCount <= 0x100 && num_glyphs <= HB_CFF_FDSELECT_CACHE_MAX_GLYPHS;
+  }
+
+  void fini ()
+  {
+    free (fds.get ());
+    fds.init ();
+  }
+
+  void add_memory_usage (hb_memory_usage_t *usage) const
+  { if (fds.get ()) usage->heap += num_glyphs; }
+
+  hb_codepoint_t get_fd (hb_codepoint_t glyph) const
+  {
+    if (!cacheable || unlikely (glyph >= num_glyphs))
+      return fdSelect->get_fd (glyph);
+
+  retry:
+    uint8_t *v = fds.get ();
+    if (unlikely (!v))
+    {
+      v = (uint8_t *) malloc (num_glyphs);
+      if (unlikely (!v))
+	return fdSelect->get_fd (glyph);
+
+      unsigned int range = 0;
+      for (unsigned int i = 0; i < num_glyphs; i++)
+	v[i] = fdSelect->get_fd (i, range);
+
+      if (unlikely (!fds.cmpexch (nullptr, v)))
+      {
+	free (v);
+	goto retry;
+      }
+    }
+    return v[glyph];
+  }
+
+  protected:
+  const FDSELECT *fdSelect;
+  unsigned int num_glyphs;
+  bool cacheable;
+  hb_atomic_ptr_t<uint8_t *> fds;
+};
+
 template <typename COUNT>
 struct Subrs : CFFIndex<COUNT>
 {
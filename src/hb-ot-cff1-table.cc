@@ -27,6 +27,14 @@
 #include "hb-ot-cff1-table.hh"
 #include "hb-cff1-interp-cs.hh"
 
+#define HB_STRING_ARRAY_NAME cff1_std_strings
+#define HB_STRING_ARRAY_LIST "hb-ot-cff1-std-str.hh"
+#include "hb-string-array.hh"
+#undef HB_STRING_ARRAY_LIST
+#undef HB_STRING_ARRAY_NAME
+
+#define NUM_CFF1_STD_STRINGS 391
+
 using namespace CFF;
 
 /* SID to code */
@@ -291,7 +299,7 @@ bool _get_bounds (const OT::cff1::accelerator_t *cff, hb_codepoint_t glyph, boun
   bounds.init ();
   if (unlikely (!cff->is_valid () || (glyph >= cff->num_glyphs))) return false;
 
-  unsigned int fd = cff->fdSelect->get_fd (glyph);
+  unsigned int fd = cff->get_fd (glyph);
   cff1_cs_interpreter_t<cff1_cs_opset_extents_t, extents_param_t> interp;
   const byte_str_t str = (*cff->charStrings)[glyph];
   interp.env.init (str, *cff, fd);
@@ -303,7 +311,54 @@ bool _get_bounds (const OT::cff1::accelerator_t *cff, hb_codepoint_t glyph, boun
   return true;
 }
 
+/* Marks glyphs whose extents were not precomputed. */
+#define CFF1_EXTENTS_NOT_PRECOMPUTED INT16_MIN
+
+void OT::cff1::accelerator_t::precompute_extents ()
+{
+  precomputed_extents = (int16_t *) malloc (4 * sizeof (int16_t) * num_glyphs);
+  if (unlikely (!precomputed_extents))
+    return;
+
+  for (unsigned int glyph = 0; glyph < num_glyphs; glyph++)
+  {
+    int16_t *v = &precomputed_extents[4 * glyph];
+    hb_glyph_extents_t extents;
+    if (compute_extents (glyph, &extents) &&
+	extents.x_bearing != CFF1_EXTENTS_NOT_PRECOMPUTED &&
+	extents.x_bearing == (int16_t) extents.x_bearing &&
+	extents.y_bearing == (int16_t) extents.y_bearing &&
+	extents.width     == (int16_t) extents.width &&
+	extents.height    == (int16_t) extents.height)
+    {
+      v[0] = extents.x_bearing;
+      v[1] = extents.y_bearing;
+      v[2] = extents.width;
+      v[3] = extents.height;
+    }
+    else
+      v[0] = CFF1_EXTENTS_NOT_PRECOMPUTED;
+  }
+}
+
 bool OT::cff1::accelerator_t::get_extents (hb_codepoint_t glyph, hb_glyph_extents_t *extents) const
+{
+  if (precomputed_extents && glyph < num_glyphs)
+  {
+    const int16_t *v = &precomputed_extents[4 * glyph];
+    if (v[0] != CFF1_EXTENTS_NOT_PRECOMPUTED)
+    {
+      extents->x_bearing = v[0];
+      extents->y_bearing = v[1];
+      extents->width     = v[2];
+      extents->height    = v[3];
+      return true;
+    }
+  }
+  return compute_extents (glyph, extents);
+}
+
+bool OT::cff1::accelerator_t::compute_extents (hb_codepoint_t glyph, hb_glyph_extents_t *extents) const
 {
   bounds_t  bounds;
 
@@ -367,7 +422,7 @@ bool OT::cff1::accelerator_t::get_seac_components (hb_codepoint_t glyph, hb_code
 {
   if (unlikely (!is_valid () || (glyph >= num_glyphs))) return false;
 
-  unsigned int fd = fdSelect->get_fd (glyph);
+  unsigned int fd = get_fd (glyph);
   cff1_cs_interpreter_t<cff1_cs_opset_seac_t, get_seac_param_t> interp;
   const byte_str_t str = (*charStrings)[glyph];
   interp.env.init (str, *this, fd);
@@ -383,3 +438,84 @@ bool OT::cff1::accelerator_t::get_seac_components (hb_codepoint_t glyph, hb_code
   }
   return false;
 }
+
+hb_bytes_t OT::cff1::accelerator_t::glyph_name (hb_codepoint_t glyph) const
+{
+  if (unlikely (!is_valid () || is_CID () || glyph >= num_glyphs))
+    return hb_bytes_t ();
+
+  hb_codepoint_t sid = glyph_to_sid (glyph);
+  if (sid < NUM_CFF1_STD_STRINGS)
+    return cff1_std_strings (sid);
+
+  const byte_str_t str = (*stringIndex)[sid - NUM_CFF1_STD_STRINGS];
+  return hb_bytes_t ((const char *) str.arrayZ, str.length);
+}
+
+bool OT::cff1::accelerator_t::get_glyph_name (hb_codepoint_t glyph,
+					      char *buf, unsigned int buf_len) const
+{
+  hb_bytes_t s = glyph_name (glyph);
+  if (!s.length) return false;
+  if (!buf_len) return true;
+  unsigned int len = hb_min (buf_len - 1, s.length);
+  strncpy (buf, s.arrayZ, len);
+  buf[len] = '\0';
+  return true;
+}
+
+int OT::cff1::accelerator_t::cmp_gids (const void *pa, const void *pb, void *arg)
+{
+  const accelerator_t *thiz = (const accelerator_t *) arg;
+  uint16_t a = * (const uint16_t *) pa;
+  uint16_t b = * (const uint16_t *) pb;
+  return thiz->glyph_name (b).cmp (thiz->glyph_name (a));
+}
+
+int OT::cff1::accelerator_t::cmp_key (const void *pk, const void *po, void *arg)
+{
+  const accelerator_t *thiz = (const accelerator_t *) arg;
+  const hb_bytes_t *key = (const hb_bytes_t *) pk;
+  uint16_t o = * (const uint16_t *) po;
+  return thiz->glyph_name (o).cmp (*key);
+}
+
+bool OT::cff1::accelerator_t::get_glyph_from_name (const char *name, int len,
+						   hb_codepoint_t *glyph) const
+{
+  if (unlikely (!is_valid () || is_CID () || !num_glyphs)) return false;
+
+  if (len < 0) len = strlen (name);
+  if (unlikely (!len)) return false;
+
+retry:
+  uint16_t *gids = gids_sorted_by_name.get ();
+
+  if (unlikely (!gids))
+  {
+    gids = (uint16_t *) malloc (num_glyphs * sizeof (gids[0]));
+    if (unlikely (!gids))
+      return false;
+
+    for (unsigned int i = 0; i < num_glyphs; i++)
+      gids[i] = i;
+    hb_sort_r (gids, num_glyphs, sizeof (gids[0]), cmp_gids, (void *) this);
+
+    if (unlikely (!gids_sorted_by_name.cmpexch (nullptr, gids)))
+    {
+      free (gids);
+      goto retry;
+    }
+  }
+
+  hb_bytes_t st (name, len);
+  const uint16_t *gid = (const uint16_t *) hb_bsearch_r (hb_addressof (st), gids, num_glyphs,
+							 sizeof (gids[0]), cmp_key, (void *) this);
+  if (gid)
+  {
+    *glyph = *gid;
+    return true;
+  }
+
+  return false;
+}
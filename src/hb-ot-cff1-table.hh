@@ -41,6 +41,13 @@ namespace CFF {
 
 #define CFF_UNDEF_SID   CFF_UNDEF_CODE
 
+/* Fonts with at most this many glyphs get all their glyph extents computed
+ * when the accelerator is created, at 8 bytes per glyph.  Zero, the
+ * default, always interprets charstrings on demand. */
+#ifndef HB_CFF1_PRECOMPUTE_EXTENTS_MAX_GLYPHS
+#define HB_CFF1_PRECOMPUTE_EXTENTS_MAX_GLYPHS 0
+#endif
+
 enum EncodingID { StandardEncoding = 0, ExpertEncoding = 1 };
 enum CharsetID { ISOAdobeCharset = 0, ExpertCharset = 1, ExpertSubsetCharset = 2 };
 
@@ -999,6 +1006,7 @@ struct cff1
       topDict.init ();
       fontDicts.init ();
       privateDicts.init ();
+      fdSelectCache.init ();
 
       this->blob = sc.reference_table<cff1> (face);
 
@@ -1069,6 +1077,7 @@ struct cff1
       num_glyphs = charStrings->count;
       if (num_glyphs != sc.get_num_glyphs ())
       { fini (); return; }
+      fdSelectCache.init (fdSelect, num_glyphs, fdCount);
 
       privateDicts.resize (fdCount);
       for (unsigned int i = 0; i < fdCount; i++)
@@ -1127,11 +1136,28 @@ struct cff1
       topDict.fini ();
       fontDicts.fini_deep ();
       privateDicts.fini_deep ();
+      fdSelectCache.fini ();
       hb_blob_destroy (blob);
       blob = nullptr;
     }
 
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (blob);
+      topDict.add_memory_usage (usage);
+      usage->add_vector (fontDicts);
+      for (unsigned int i = 0; i < fontDicts.length; i++)
+	fontDicts[i].add_memory_usage (usage);
+      usage->add_vector (privateDicts);
+      for (unsigned int i = 0; i < privateDicts.length; i++)
+	privateDicts[i].add_memory_usage (usage);
+      fdSelectCache.add_memory_usage (usage);
+    }
+
     bool is_valid () const { return blob != nullptr; }
+
+    hb_codepoint_t get_fd (hb_codepoint_t glyph) const
+    { return fdSelectCache.get_fd (glyph); }
     bool is_CID () const { return topDict.is_CID (); }
 
     bool is_predef_charset () const { return topDict.CharsetOffset <= ExpertSubsetCharset; }
@@ -1149,6 +1175,31 @@ struct cff1
       return 0;
     }
 
+    hb_codepoint_t glyph_to_sid (hb_codepoint_t glyph) const
+    {
+      if (charset != &Null(Charset))
+	return charset->get_sid (glyph);
+      else
+      {
+	hb_codepoint_t sid = 0;
+	switch (topDict.CharsetOffset)
+	{
+	  case  ISOAdobeCharset:
+	    if (glyph <= 228 /*zcaron*/) sid = glyph;
+	    break;
+	  case  ExpertCharset:
+	    sid = lookup_expert_charset_for_sid (glyph);
+	    break;
+	  case  ExpertSubsetCharset:
+	      sid = lookup_expert_subset_charset_for_sid (glyph);
+	    break;
+	  default:
+	    break;
+	}
+	return sid;
+      }
+    }
+
     protected:
     hb_blob_t	       *blob;
     hb_sanitize_context_t   sc;
@@ -1163,6 +1214,7 @@ struct cff1
     const CFF1FDArray       *fdArray;
     const CFF1FDSelect      *fdSelect;
     unsigned int	    fdCount;
+    fdselect_cache_t<CFF1FDSelect> fdSelectCache;
 
     cff1_top_dict_values_t       topDict;
     hb_vector_t<cff1_font_dict_values_t>   fontDicts;
@@ -1173,8 +1225,55 @@ struct cff1
 
   struct accelerator_t : accelerator_templ_t<cff1_private_dict_opset_t, cff1_private_dict_values_t>
   {
+    void init (hb_face_t *face)
+    {
+      SUPER::init (face);
+      precomputed_extents = nullptr;
+      gids_sorted_by_name.set_relaxed (nullptr);
+      if (is_valid () && num_glyphs <= HB_CFF1_PRECOMPUTE_EXTENTS_MAX_GLYPHS)
+	precompute_extents ();
+    }
+
+    void fini ()
+    {
+      free (precomputed_extents);
+      precomputed_extents = nullptr;
+      free (gids_sorted_by_name.get ());
+      gids_sorted_by_name.set_relaxed (nullptr);
+      SUPER::fini ();
+    }
+
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      SUPER::add_memory_usage (usage);
+      if (precomputed_extents)
+	usage->heap += 4 * sizeof (int16_t) * num_glyphs;
+      if (gids_sorted_by_name.get ())
+	usage->heap += num_glyphs * sizeof (uint16_t);
+    }
+
     HB_INTERNAL bool get_extents (hb_codepoint_t glyph, hb_glyph_extents_t *extents) const;
     HB_INTERNAL bool get_seac_components (hb_codepoint_t glyph, hb_codepoint_t *base, hb_codepoint_t *accent) const;
+
+    /* Glyph names from the charset, for fonts whose post table has none.
+     * CID-keyed fonts have no glyph names. */
+    HB_INTERNAL bool get_glyph_name (hb_codepoint_t glyph, char *buf, unsigned int buf_len) const;
+    HB_INTERNAL bool get_glyph_from_name (const char *name, int len, hb_codepoint_t *glyph) const;
+
+    private:
+    HB_INTERNAL bool compute_extents (hb_codepoint_t glyph, hb_glyph_extents_t *extents) const;
+    HB_INTERNAL void precompute_extents ();
+    HB_INTERNAL hb_bytes_t glyph_name (hb_codepoint_t glyph) const;
+    HB_INTERNAL static int cmp_gids (const void *pa, const void *pb, void *arg);
+    HB_INTERNAL static int cmp_key (const void *pk, const void *po, void *arg);
+
+    /* x_bearing, y_bearing, width, height per glyph; see
+     * HB_CFF1_PRECOMPUTE_EXTENTS_MAX_GLYPHS. */
+    int16_t *precomputed_extents;
+    /* Built on first get_glyph_from_name(). */
+    hb_atomic_ptr_t<uint16_t *> gids_sorted_by_name;
+
+    typedef accelerator_templ_t<cff1_private_dict_opset_t, cff1_private_dict_values_t> SUPER;
   };
 
   struct accelerator_subset_t : accelerator_templ_t<cff1_private_dict_opset_subset, cff1_private_dict_values_subset_t>
@@ -1226,31 +1325,6 @@ struct cff1
       }
     }
 
-    hb_codepoint_t glyph_to_sid (hb_codepoint_t glyph) const
-    {
-      if (charset != &Null(Charset))
-	return charset->get_sid (glyph);
-      else
-      {
-	hb_codepoint_t sid = 0;
-	switch (topDict.CharsetOffset)
-	{
-	  case  ISOAdobeCharset:
-	    if (glyph <= 228 /*zcaron*/) sid = glyph;
-	    break;
-	  case  ExpertCharset:
-	    sid = lookup_expert_charset_for_sid (glyph);
-	    break;
-	  case  ExpertSubsetCharset:
-	      sid = lookup_expert_subset_charset_for_sid (glyph);
-	    break;
-	  default:
-	    break;
-	}
-	return sid;
-      }
-    }
-
     const Encoding	  *encoding;
 
     private:
@@ -103,10 +103,13 @@ bool OT::cff2::accelerator_t::get_extents (hb_font_t *font,
 
   unsigned int num_coords;
   const int *coords = hb_font_get_var_coords_normalized (font, &num_coords);
-  unsigned int fd = fdSelect->get_fd (glyph);
+  unsigned int fd = get_fd (glyph);
   cff2_cs_interpreter_t<cff2_cs_opset_extents_t, extents_param_t> interp;
   const byte_str_t str = (*charStrings)[glyph];
-  interp.env.init (str, *this, fd, coords, num_coords);
+  /* Region scalars at the font's coords are kept on the font, so only
+   * the first glyph blended at an instance evaluates them. */
+  const float *region_scalars = num_coords ? varStore->varStore.get_font_scalars (font) : nullptr;
+  interp.env.init (str, *this, fd, coords, num_coords, region_scalars);
   extents_param_t  param;
   param.init ();
   if (unlikely (!interp.interpret (param))) return false;
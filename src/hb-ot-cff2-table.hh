@@ -100,6 +100,18 @@ struct CFF2FDSelect
       return u.format4.get_fd (glyph);
   }
 
+  hb_codepoint_t get_fd (hb_codepoint_t glyph, unsigned int &range) const
+  {
+    if (this == &Null(CFF2FDSelect))
+      return 0;
+    if (format == 0)
+      return u.format0.get_fd (glyph);
+    else if (format == 3)
+      return u.format3.get_fd (glyph, range);
+    else
+      return u.format4.get_fd (glyph, range);
+  }
+
   HBUINT8       format;
   union {
     FDSelect0   format0;
@@ -425,6 +437,7 @@ struct cff2
       topDict.init ();
       fontDicts.init ();
       privateDicts.init ();
+      fdSelectCache.init ();
 
       this->blob = sc.reference_table<cff2> (face);
 
@@ -464,6 +477,7 @@ struct cff2
       { fini (); return; }
 
       fdCount = fdArray->count;
+      fdSelectCache.init (fdSelect, num_glyphs, fdCount);
       privateDicts.resize (fdCount);
 
       /* parse font dicts and gather private dicts */
@@ -499,12 +513,29 @@ struct cff2
       topDict.fini ();
       fontDicts.fini_deep ();
       privateDicts.fini_deep ();
+      fdSelectCache.fini ();
       hb_blob_destroy (blob);
       blob = nullptr;
     }
 
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (blob);
+      topDict.add_memory_usage (usage);
+      usage->add_vector (fontDicts);
+      for (unsigned int i = 0; i < fontDicts.length; i++)
+	fontDicts[i].add_memory_usage (usage);
+      usage->add_vector (privateDicts);
+      for (unsigned int i = 0; i < privateDicts.length; i++)
+	privateDicts[i].add_memory_usage (usage);
+      fdSelectCache.add_memory_usage (usage);
+    }
+
     bool is_valid () const { return blob != nullptr; }
 
+    hb_codepoint_t get_fd (hb_codepoint_t glyph) const
+    { return fdSelectCache.get_fd (glyph); }
+
     protected:
     hb_blob_t			*blob;
     hb_sanitize_context_t	sc;
@@ -517,6 +548,7 @@ struct cff2
     const CFF2FDArray		*fdArray;
     const CFF2FDSelect		*fdSelect;
     unsigned int		fdCount;
+    fdselect_cache_t<CFF2FDSelect>	fdSelectCache;
 
     hb_vector_t<cff2_font_dict_values_t>     fontDicts;
     hb_vector_t<PRIVDICTVAL>  privateDicts;
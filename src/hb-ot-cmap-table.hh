@@ -39,6 +39,15 @@
 namespace OT {
 
 
+/* A retained codepoint and the glyph it maps to in the subset; cmap
+ * subsetting builds all its subtables from a sorted array of these. */
+struct cmap_subset_mapping_t
+{
+  hb_codepoint_t unicode;
+  hb_codepoint_t new_gid;
+};
+
+
 struct CmapSubtableFormat0
 {
   bool get_glyph (hb_codepoint_t codepoint, hb_codepoint_t *glyph) const
@@ -79,10 +88,11 @@ struct CmapSubtableFormat4
     HBUINT16 start_code;
     HBUINT16 end_code;
     bool use_delta;
+    unsigned int first_mapping; /* Index of start_code in the mappings. */
   };
 
   bool serialize (hb_serialize_context_t *c,
-		  const hb_subset_plan_t *plan,
+		  const hb_vector_t<cmap_subset_mapping_t> &mappings,
 		  const hb_sorted_vector_t<segment_plan> &segments)
   {
     TRACE_SERIALIZE (this);
@@ -114,10 +124,9 @@ struct CmapSubtableFormat4
       start_count[i] = segments[i].start_code;
       if (segments[i].use_delta)
       {
-	hb_codepoint_t cp = segments[i].start_code;
-	hb_codepoint_t start_gid = 0;
-	if (unlikely (!plan->new_gid_for_codepoint (cp, &start_gid) && cp != 0xFFFF))
-	  return_trace (false);
+	/* The closing 0xFFFF segment may not have a mapping; it maps to 0. */
+	hb_codepoint_t start_gid = segments[i].first_mapping < mappings.length
+				 ? mappings[segments[i].first_mapping].new_gid : 0;
 	id_delta[i] = start_gid - segments[i].start_code;
       } else {
 	id_delta[i] = 0;
@@ -139,14 +148,10 @@ struct CmapSubtableFormat4
 	// =
 	// 2 * (glyph_id_array - id_range_offset - i)
 	id_range_offset[i] = 2 * (glyph_id_array - id_range_offset - i);
+	/* Codepoints in a segment are consecutive, and so are their mappings. */
+	const cmap_subset_mapping_t *mapping = &mappings[segments[i].first_mapping];
 	for (unsigned int j = 0; j < num_codepoints; j++)
-	{
-	  hb_codepoint_t cp = segments[i].start_code + j;
-	  hb_codepoint_t new_gid = 0;
-	  if (unlikely (!plan->new_gid_for_codepoint (cp, &new_gid)))
-	    return_trace (false);
-	  glyph_id_array[j] = new_gid;
-	}
+	  glyph_id_array[j] = mapping[j].new_gid;
       }
     }
 
@@ -175,20 +180,16 @@ struct CmapSubtableFormat4
 	+ segment_size;
   }
 
-  static bool create_sub_table_plan (const hb_subset_plan_t *plan,
+  static bool create_sub_table_plan (const hb_vector_t<cmap_subset_mapping_t> &mappings,
 				     hb_sorted_vector_t<segment_plan> *segments)
   {
     segment_plan *segment = nullptr;
     hb_codepoint_t last_gid = 0;
 
-    hb_codepoint_t cp = HB_SET_VALUE_INVALID;
-    while (plan->unicodes->next (&cp)) {
-      hb_codepoint_t new_gid = 0;
-      if (unlikely (!plan->new_gid_for_codepoint (cp, &new_gid)))
-      {
-	DEBUG_MSG(SUBSET, nullptr, "Unable to find new gid for %04x", cp);
-	return false;
-      }
+    for (unsigned int i = 0; i < mappings.length; i++)
+    {
+      hb_codepoint_t cp = mappings[i].unicode;
+      hb_codepoint_t new_gid = mappings[i].new_gid;
 
       /* Stop adding to cmap if we are now outside of unicode BMP. */
       if (cp > 0xFFFF) break;
@@ -200,6 +201,7 @@ struct CmapSubtableFormat4
 	segment->start_code = cp;
 	segment->end_code = cp;
 	segment->use_delta = true;
+	segment->first_mapping = i;
       } else {
 	segment->end_code = cp;
 	if (last_gid + 1u != new_gid)
@@ -218,9 +220,10 @@ struct CmapSubtableFormat4
       segment->start_code = 0xFFFF;
       segment->end_code = 0xFFFF;
       segment->use_delta = true;
+      segment->first_mapping = mappings.length;
     }
 
-    return true;
+    return !segments->in_error ();
   }
 
   struct accelerator_t
@@ -241,13 +244,12 @@ struct CmapSubtableFormat4
     }
     void fini () {}
 
-    bool get_glyph (hb_codepoint_t codepoint, hb_codepoint_t *glyph) const
+    bool find_segment (hb_codepoint_t codepoint, unsigned int *segment) const
     {
       /* Custom two-array bsearch. */
       int min = 0, max = (int) this->segCount - 1;
       const HBUINT16 *startCount = this->startCount;
       const HBUINT16 *endCount = this->endCount;
-      unsigned int i;
       while (min <= max)
       {
 	int mid = ((unsigned int) min + (unsigned int) max) / 2;
@@ -257,13 +259,18 @@ struct CmapSubtableFormat4
 	  min = mid + 1;
 	else
 	{
-	  i = mid;
-	  goto found;
+	  *segment = mid;
+	  return true;
 	}
       }
       return false;
+    }
 
-    found:
+    bool in_segment (hb_codepoint_t codepoint, unsigned int i) const
+    { return i < this->segCount && this->startCount[i] <= codepoint && codepoint <= this->endCount[i]; }
+
+    bool get_glyph_from_segment (hb_codepoint_t codepoint, unsigned int i, hb_codepoint_t *glyph) const
+    {
       hb_codepoint_t gid;
       unsigned int rangeOffset = this->idRangeOffset[i];
       if (rangeOffset == 0)
@@ -285,10 +292,54 @@ struct CmapSubtableFormat4
       *glyph = gid;
       return true;
     }
+
+    bool get_glyph (hb_codepoint_t codepoint, hb_codepoint_t *glyph) const
+    {
+      unsigned int i;
+      return find_segment (codepoint, &i) &&
+	     get_glyph_from_segment (codepoint, i, glyph);
+    }
+
+    /* Like get_glyph(), but starts from, and updates, the segment the previous
+     * character was found in.  Runs of text mostly stay in one segment or move
+     * on to the next one, so this skips the bsearch most of the time. */
+    bool get_glyph_hinted (hb_codepoint_t codepoint, hb_codepoint_t *glyph, unsigned int *hint) const
+    {
+      unsigned int i = *hint;
+      if (!in_segment (codepoint, i))
+      {
+	if (in_segment (codepoint, i + 1))
+	  i++;
+	else if (!find_segment (codepoint, &i))
+	  return false;
+	*hint = i;
+      }
+      return get_glyph_from_segment (codepoint, i, glyph);
+    }
+
     HB_INTERNAL static bool get_glyph_func (const void *obj, hb_codepoint_t codepoint, hb_codepoint_t *glyph)
     {
       return ((const accelerator_t *) obj)->get_glyph (codepoint, glyph);
     }
+    HB_INTERNAL static unsigned int get_glyphs_func (const void *obj,
+						     unsigned int count,
+						     const hb_codepoint_t *first_unicode,
+						     unsigned int unicode_stride,
+						     hb_codepoint_t *first_glyph,
+						     unsigned int glyph_stride)
+    {
+      const accelerator_t *accel = (const accelerator_t *) obj;
+      unsigned int hint = 0;
+      unsigned int done;
+      for (done = 0;
+	   done < count && accel->get_glyph_hinted (*first_unicode, first_glyph, &hint);
+	   done++)
+      {
+	first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+	first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+      }
+      return done;
+    }
     void collect_unicodes (hb_set_t *out) const
     {
       unsigned int count = this->segCount;
@@ -474,6 +525,44 @@ struct CmapSubtableLongSegmented
     return true;
   }
 
+  /* See CmapSubtableFormat4::accelerator_t::get_glyph_hinted(). */
+  bool get_glyph_hinted (hb_codepoint_t codepoint, hb_codepoint_t *glyph, unsigned int *hint) const
+  {
+    unsigned int i = *hint;
+    unsigned int count = groups.len;
+    if (!(i < count && !groups.arrayZ[i].cmp (codepoint)))
+    {
+      if (i + 1 < count && !groups.arrayZ[i + 1].cmp (codepoint))
+	i++;
+      else if (!groups.bfind (codepoint, &i))
+	return false;
+      *hint = i;
+    }
+    hb_codepoint_t gid = T::group_get_glyph (groups.arrayZ[i], codepoint);
+    if (!gid)
+      return false;
+    *glyph = gid;
+    return true;
+  }
+
+  unsigned int get_glyphs (unsigned int count,
+			   const hb_codepoint_t *first_unicode,
+			   unsigned int unicode_stride,
+			   hb_codepoint_t *first_glyph,
+			   unsigned int glyph_stride) const
+  {
+    unsigned int hint = 0;
+    unsigned int done;
+    for (done = 0;
+	 done < count && get_glyph_hinted (*first_unicode, first_glyph, &hint);
+	 done++)
+    {
+      first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+      first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+    }
+    return done;
+  }
+
   void collect_unicodes (hb_set_t *out) const
   {
     for (unsigned int i = 0; i < this->groups.len; i++) {
@@ -535,19 +624,15 @@ struct CmapSubtableFormat12 : CmapSubtableLongSegmented<CmapSubtableFormat12>
     return 16 + 12 * groups.length;
   }
 
-  static bool create_sub_table_plan (const hb_subset_plan_t *plan,
+  static bool create_sub_table_plan (const hb_vector_t<cmap_subset_mapping_t> &mappings,
 				     hb_sorted_vector_t<CmapSubtableLongGroup> *groups)
   {
     CmapSubtableLongGroup *group = nullptr;
 
-    hb_codepoint_t cp = HB_SET_VALUE_INVALID;
-    while (plan->unicodes->next (&cp)) {
-      hb_codepoint_t new_gid = 0;
-      if (unlikely (!plan->new_gid_for_codepoint (cp, &new_gid)))
-      {
-	DEBUG_MSG(SUBSET, nullptr, "Unable to find new gid for %04x", cp);
-	return false;
-      }
+    for (unsigned int i = 0; i < mappings.length; i++)
+    {
+      hb_codepoint_t cp = mappings[i].unicode;
+      hb_codepoint_t new_gid = mappings[i].new_gid;
 
       if (!group || !_is_gid_consecutive (group, cp, new_gid))
       {
@@ -565,7 +650,7 @@ struct CmapSubtableFormat12 : CmapSubtableLongSegmented<CmapSubtableFormat12>
       DEBUG_MSG(SUBSET, nullptr, "  %d: U+%04X-U+%04X, gid %d-%d", i, (uint32_t) group.startCharCode, (uint32_t) group.endCharCode, (uint32_t) group.glyphID, (uint32_t) group.glyphID + ((uint32_t) group.endCharCode - (uint32_t) group.startCharCode));
     }
 
-    return true;
+    return !groups->in_error ();
   }
 
  private:
@@ -853,17 +938,50 @@ struct cmap
 	  +  CmapSubtableFormat12::get_sub_table_size (this->format12_groups);
     }
 
+    hb_vector_t<cmap_subset_mapping_t> mappings;
     hb_sorted_vector_t<CmapSubtableFormat4::segment_plan> format4_segments;
     hb_sorted_vector_t<CmapSubtableLongGroup> format12_groups;
   };
 
+  /* Looks up each retained codepoint's new gid once, pulling codepoints
+   * out of the set a batch at a time. */
+  static bool _collect_mappings (const hb_subset_plan_t *plan,
+				 hb_vector_t<cmap_subset_mapping_t> *mappings)
+  {
+    if (unlikely (!mappings->alloc (plan->unicodes->get_population ())))
+      return false;
+
+    hb_codepoint_t batch[256];
+    hb_codepoint_t cp = HB_SET_VALUE_INVALID;
+    unsigned int count;
+    while ((count = plan->unicodes->next_many (cp, batch, ARRAY_LENGTH (batch))))
+    {
+      for (unsigned int i = 0; i < count; i++)
+      {
+	cmap_subset_mapping_t *mapping = mappings->push ();
+	mapping->unicode = batch[i];
+	if (unlikely (!plan->new_gid_for_codepoint (batch[i], &mapping->new_gid)))
+	{
+	  DEBUG_MSG(SUBSET, nullptr, "Unable to find new gid for %04x", batch[i]);
+	  return false;
+	}
+      }
+      cp = batch[count - 1];
+    }
+
+    return !mappings->in_error ();
+  }
+
   bool _create_plan (const hb_subset_plan_t *plan,
 		     subset_plan *cmap_plan) const
   {
-    if (unlikely (!CmapSubtableFormat4::create_sub_table_plan (plan, &cmap_plan->format4_segments)))
+    if (unlikely (!_collect_mappings (plan, &cmap_plan->mappings)))
       return false;
 
-    return CmapSubtableFormat12::create_sub_table_plan (plan, &cmap_plan->format12_groups);
+    if (unlikely (!CmapSubtableFormat4::create_sub_table_plan (cmap_plan->mappings, &cmap_plan->format4_segments)))
+      return false;
+
+    return CmapSubtableFormat12::create_sub_table_plan (cmap_plan->mappings, &cmap_plan->format12_groups);
   }
 
   bool _subset (const hb_subset_plan_t *plan,
@@ -908,7 +1026,7 @@ struct cmap
       subtable.u.format = 4;
 
       CmapSubtableFormat4 &format4 = subtable.u.format4;
-      if (unlikely (!format4.serialize (&c, plan, cmap_subset_plan.format4_segments)))
+      if (unlikely (!format4.serialize (&c, cmap_subset_plan.mappings, cmap_subset_plan.format4_segments)))
 	return false;
     }
 
@@ -1007,6 +1125,7 @@ struct cmap
       }
 
       this->get_glyph_data = subtable;
+      this->get_glyphs_funcZ = nullptr;
       if (unlikely (symbol))
       {
 	this->get_glyph_funcZ = get_glyph_from_symbol<CmapSubtable>;
@@ -1018,19 +1137,195 @@ struct cmap
 	  break;
 	case 12:
 	  this->get_glyph_funcZ = get_glyph_from<CmapSubtableFormat12>;
+	  this->get_glyphs_funcZ = get_glyphs_from<CmapSubtableFormat12>;
 	  break;
 	case  4:
 	  {
 	    this->format4_accel.init (&subtable->u.format4);
 	    this->get_glyph_data = &this->format4_accel;
 	    this->get_glyph_funcZ = this->format4_accel.get_glyph_func;
+	    this->get_glyphs_funcZ = this->format4_accel.get_glyphs_func;
 	  }
 	  break;
 	}
       }
+      this->symbol = symbol;
+      this->mappings.init ();
+      this->coverage.init ();
+    }
+
+    void fini ()
+    {
+      hb_vector_t<mapping_t> *m = this->mappings.get ();
+      if (m)
+      {
+	m->fini ();
+	free (m);
+      }
+      hb_set_t *c = this->coverage.get ();
+      if (c)
+      {
+	c->fini_shallow ();
+	free (c);
+      }
+      this->table.destroy ();
+    }
+
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (this->table);
+      const hb_vector_t<mapping_t> *m = this->mappings.get ();
+      if (m)
+	usage->add_vector (*m);
+      const hb_set_t *c = this->coverage.get ();
+      if (c)
+      {
+	usage->add_vector (c->page_map);
+	usage->add_vector (c->pages);
+      }
+    }
+
+    struct mapping_t
+    {
+      hb_codepoint_t unicode;
+      hb_codepoint_t glyph;
+    };
+
+    /* Every (unicode, glyph) pair of the nominal subtable, sorted by
+     * unicode.  Built on first use.  Returns nullptr for symbol
+     * subtables, whose U+0000..00FF lookups the pairs don't cover, and
+     * on allocation failure. */
+    const hb_vector_t<mapping_t> *get_mappings () const
+    {
+      if (unlikely (symbol || !this->get_glyph_funcZ)) return nullptr;
+
+    retry:
+      hb_vector_t<mapping_t> *m = this->mappings.get ();
+      if (likely (m)) return m;
+
+      m = (hb_vector_t<mapping_t> *) calloc (1, sizeof (hb_vector_t<mapping_t>));
+      if (unlikely (!m)) return nullptr;
+      m->init ();
+
+      hb_set_t unicodes;
+      collect_unicodes (&unicodes);
+      m->alloc (unicodes.get_population ());
+
+      hb_codepoint_t batch[256], glyphs[256];
+      hb_codepoint_t u = HB_SET_VALUE_INVALID;
+      unsigned int count;
+      while ((count = unicodes.next_many (u, batch, ARRAY_LENGTH (batch))))
+      {
+	for (unsigned int i = 0; i < count;)
+	{
+	  unsigned int done = get_nominal_glyphs (count - i,
+						  batch + i, sizeof (batch[0]),
+						  glyphs + i, sizeof (glyphs[0]));
+	  for (unsigned int j = i; j < i + done; j++)
+	  {
+	    mapping_t *mapping = m->push ();
+	    mapping->unicode = batch[j];
+	    mapping->glyph = glyphs[j];
+	  }
+	  i += done + 1; /* Skip the unicode that didn't map. */
+	}
+	u = batch[count - 1];
+      }
+
+      if (unlikely (unicodes.in_error () || m->in_error ()))
+      {
+	m->fini ();
+	free (m);
+	return nullptr;
+      }
+
+      if (unlikely (!this->mappings.cmpexch (nullptr, m)))
+      {
+	m->fini ();
+	free (m);
+	goto retry;
+      }
+      return m;
+    }
+
+    /* Every unicode with a nominal glyph, symbol-font duplicates
+     * included.  Built on first use.  Returns nullptr on allocation
+     * failure. */
+    const hb_set_t *get_coverage () const
+    {
+    retry:
+      hb_set_t *c = this->coverage.get ();
+      if (likely (c)) return c;
+
+      c = (hb_set_t *) calloc (1, sizeof (hb_set_t));
+      if (unlikely (!c)) return nullptr;
+      c->init_shallow ();
+
+      hb_set_t unicodes;
+      collect_unicodes (&unicodes);
+      if (symbol)
+	unicodes.add_range (0, 0x00FFu);
+
+      hb_codepoint_t batch[256], glyphs[256];
+      hb_codepoint_t u = HB_SET_VALUE_INVALID;
+      unsigned int count;
+      while ((count = unicodes.next_many (u, batch, ARRAY_LENGTH (batch))))
+      {
+	for (unsigned int i = 0; i < count;)
+	{
+	  unsigned int done = get_nominal_glyphs (count - i,
+						  batch + i, sizeof (batch[0]),
+						  glyphs + i, sizeof (glyphs[0]));
+	  c->add_sorted_array (batch + i, done);
+	  i += done + 1; /* Skip the unicode that didn't map. */
+	}
+	u = batch[count - 1];
+      }
+
+      if (unlikely (unicodes.in_error () || c->in_error ()))
+      {
+	c->fini_shallow ();
+	free (c);
+	return nullptr;
+      }
+
+      if (unlikely (!this->coverage.cmpexch (nullptr, c)))
+      {
+	c->fini_shallow ();
+	free (c);
+	goto retry;
+      }
+      return c;
     }
 
-    void fini () { this->table.destroy (); }
+    /* Returns how many of the count unicodes, from the first one on,
+     * have a nominal glyph. */
+    unsigned int get_covered_prefix (unsigned int count,
+				     const hb_codepoint_t *first_unicode,
+				     unsigned int unicode_stride) const
+    {
+      const hb_set_t *c = get_coverage ();
+      if (unlikely (!c))
+      {
+	hb_codepoint_t glyphs[64];
+	unsigned int done = 0;
+	while (done < count)
+	{
+	  unsigned int n = hb_min (count - done, ARRAY_LENGTH (glyphs));
+	  unsigned int mapped = get_nominal_glyphs (n, first_unicode, unicode_stride,
+						    glyphs, sizeof (glyphs[0]));
+	  done += mapped;
+	  if (mapped < n) break;
+	  first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, n * unicode_stride);
+	}
+	return done;
+      }
+
+      unsigned int done;
+      for (done = 0; done < count && c->has (*first_unicode); done++)
+	first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+      return done;
+    }
 
     bool get_nominal_glyph (hb_codepoint_t  unicode,
 				   hb_codepoint_t *glyph) const
@@ -1046,9 +1341,16 @@ struct cmap
     {
       if (unlikely (!this->get_glyph_funcZ)) return 0;
 
-      hb_cmap_get_glyph_func_t get_glyph_funcZ = this->get_glyph_funcZ;
       const void *get_glyph_data = this->get_glyph_data;
 
+      /* Format 4 and 12 remember the segment between characters. */
+      if (this->get_glyphs_funcZ)
+	return this->get_glyphs_funcZ (get_glyph_data, count,
+				       first_unicode, unicode_stride,
+				       first_glyph, glyph_stride);
+
+      hb_cmap_get_glyph_func_t get_glyph_funcZ = this->get_glyph_funcZ;
+
       unsigned int done;
       for (done = 0;
 	   done < count && get_glyph_funcZ (get_glyph_data, *first_unicode, first_glyph);
@@ -1094,6 +1396,12 @@ struct cmap
     typedef bool (*hb_cmap_get_glyph_func_t) (const void *obj,
 					      hb_codepoint_t codepoint,
 					      hb_codepoint_t *glyph);
+    typedef unsigned int (*hb_cmap_get_glyphs_func_t) (const void *obj,
+						       unsigned int count,
+						       const hb_codepoint_t *first_unicode,
+						       unsigned int unicode_stride,
+						       hb_codepoint_t *first_glyph,
+						       unsigned int glyph_stride);
 
     template <typename Type>
     HB_INTERNAL static bool get_glyph_from (const void *obj,
@@ -1104,6 +1412,20 @@ struct cmap
       return typed_obj->get_glyph (codepoint, glyph);
     }
 
+    template <typename Type>
+    HB_INTERNAL static unsigned int get_glyphs_from (const void *obj,
+						     unsigned int count,
+						     const hb_codepoint_t *first_unicode,
+						     unsigned int unicode_stride,
+						     hb_codepoint_t *first_glyph,
+						     unsigned int glyph_stride)
+    {
+      const Type *typed_obj = (const Type *) obj;
+      return typed_obj->get_glyphs (count,
+				    first_unicode, unicode_stride,
+				    first_glyph, glyph_stride);
+    }
+
     template <typename Type>
     HB_INTERNAL static bool get_glyph_from_symbol (const void *obj,
 						   hb_codepoint_t codepoint,
@@ -1131,10 +1453,15 @@ struct cmap
     hb_nonnull_ptr_t<const CmapSubtableFormat14> subtable_uvs;
 
     hb_cmap_get_glyph_func_t get_glyph_funcZ;
+    hb_cmap_get_glyphs_func_t get_glyphs_funcZ;
     const void *get_glyph_data;
 
     CmapSubtableFormat4::accelerator_t format4_accel;
 
+    bool symbol;
+    mutable hb_atomic_ptr_t<hb_vector_t<mapping_t>> mappings;
+    mutable hb_atomic_ptr_t<hb_set_t> coverage;
+
     hb_blob_ptr_t<cmap> table;
   };
 
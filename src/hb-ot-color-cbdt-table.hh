@@ -396,6 +396,12 @@ struct CBDT
       this->cbdt.destroy ();
     }
 
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (this->cblc);
+      usage->add_blob (this->cbdt);
+    }
+
     bool get_extents (hb_font_t *font, hb_codepoint_t glyph,
 		      hb_glyph_extents_t *extents) const
     {
@@ -454,9 +460,16 @@ struct CBDT
 
     hb_blob_t* reference_png (hb_font_t      *font,
 				     hb_codepoint_t  glyph) const
+    { return reference_png (choose_strike (font), glyph); }
+
+    const BitmapSizeTable &choose_strike (hb_font_t *font) const
+    { return this->cblc->choose_strike (font); }
+
+    /* For callers that cache the strike chosen for a font. */
+    hb_blob_t* reference_png (const BitmapSizeTable &strike,
+			      hb_codepoint_t         glyph) const
     {
       const void *base;
-      const BitmapSizeTable &strike = this->cblc->choose_strike (font);
       const IndexSubtableRecord *subtable_record = strike.find_table (glyph, cblc, &base);
       if (!subtable_record || !strike.ppemX || !strike.ppemY)
 	return hb_blob_get_empty ();
@@ -33,6 +33,13 @@
  */
 #define HB_OT_TAG_COLR HB_TAG('C','O','L','R')
 
+/* Fonts with at most this many glyphs get a dense glyph-to-record index,
+ * built on first lookup, at 2 bytes per glyph.  Larger fonts binary-search
+ * the base glyph records. */
+#ifndef HB_OT_COLR_DENSE_INDEX_MAX_GLYPHS
+#define HB_OT_COLR_DENSE_INDEX_MAX_GLYPHS 8192
+#endif
+
 
 namespace OT {
 
@@ -91,16 +98,30 @@ struct COLR
 
   bool has_data () const { return numBaseGlyphs; }
 
+  const BaseGlyphRecord &get_base_glyph_record (hb_codepoint_t glyph) const
+  { return (this+baseGlyphsZ).bsearch (numBaseGlyphs, glyph); }
+
+  hb_array_t<const BaseGlyphRecord> get_base_glyph_records () const
+  { return hb_array ((this+baseGlyphsZ).arrayZ, numBaseGlyphs); }
+
+  hb_array_t<const LayerRecord> get_layer_records (const BaseGlyphRecord &record) const
+  {
+    hb_array_t<const LayerRecord> all_layers ((this+layersZ).arrayZ, numLayers);
+    return all_layers.sub_array (record.firstLayerIdx, record.numLayers);
+  }
+
   unsigned int get_glyph_layers (hb_codepoint_t       glyph,
 				 unsigned int         start_offset,
 				 unsigned int        *count, /* IN/OUT.  May be NULL. */
 				 hb_ot_color_layer_t *layers /* OUT.     May be NULL. */) const
-  {
-    const BaseGlyphRecord &record = (this+baseGlyphsZ).bsearch (numBaseGlyphs, glyph);
+  { return get_glyph_layers (get_base_glyph_record (glyph), start_offset, count, layers); }
 
-    hb_array_t<const LayerRecord> all_layers ((this+layersZ).arrayZ, numLayers);
-    hb_array_t<const LayerRecord> glyph_layers = all_layers.sub_array (record.firstLayerIdx,
-								       record.numLayers);
+  unsigned int get_glyph_layers (const BaseGlyphRecord &record,
+				 unsigned int         start_offset,
+				 unsigned int        *count, /* IN/OUT.  May be NULL. */
+				 hb_ot_color_layer_t *layers /* OUT.     May be NULL. */) const
+  {
+    hb_array_t<const LayerRecord> glyph_layers = get_layer_records (record);
     if (count)
     {
       hb_array_t<const LayerRecord> segment_layers = glyph_layers.sub_array (start_offset, *count);
@@ -114,6 +135,110 @@ struct COLR
     return glyph_layers.length;
   }
 
+  struct accelerator_t
+  {
+    void init (hb_face_t *face)
+    {
+      table = hb_sanitize_context_t().reference_table<COLR> (face);
+      num_glyphs = face->get_num_glyphs ();
+      dense_index.set_relaxed (nullptr);
+    }
+    void fini ()
+    {
+      free (dense_index.get ());
+      dense_index.set_relaxed (nullptr);
+      table.destroy ();
+    }
+
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (table);
+      if (dense_index.get ())
+	usage->heap += num_glyphs * sizeof (uint16_t);
+    }
+
+    bool has_data () const { return table->has_data (); }
+
+    const BaseGlyphRecord &get_base_glyph_record (hb_codepoint_t glyph) const
+    {
+      const uint16_t *index = glyph < num_glyphs ? get_dense_index () : nullptr;
+      if (!index)
+	return table->get_base_glyph_record (glyph);
+      unsigned int i = index[glyph];
+      return i ? table->get_base_glyph_records ()[i - 1] : Null (BaseGlyphRecord);
+    }
+
+    unsigned int get_glyph_layers (hb_codepoint_t       glyph,
+				   unsigned int         start_offset,
+				   unsigned int        *count, /* IN/OUT.  May be NULL. */
+				   hb_ot_color_layer_t *layers /* OUT.     May be NULL. */) const
+    { return table->get_glyph_layers (get_base_glyph_record (glyph), start_offset, count, layers); }
+
+    unsigned int get_glyphs_layers (unsigned int          glyph_count,
+				    const hb_codepoint_t *glyphs,
+				    unsigned int         *layer_starts, /* OUT.     May be NULL. */
+				    unsigned int         *layer_count, /* IN/OUT.  May be NULL. */
+				    hb_ot_color_layer_t  *layers /* OUT.     May be NULL. */) const
+    {
+      unsigned int capacity = layer_count ? *layer_count : 0;
+      unsigned int total = 0;
+      unsigned int written = 0;
+      for (unsigned int i = 0; i < glyph_count; i++)
+      {
+	if (layer_starts) layer_starts[i] = total;
+	hb_array_t<const LayerRecord> glyph_layers = table->get_layer_records (get_base_glyph_record (glyphs[i]));
+	/* Only write layers of glyphs that fit entirely. */
+	if (written == total && glyph_layers.length <= capacity - written)
+	{
+	  for (unsigned int j = 0; j < glyph_layers.length; j++)
+	  {
+	    layers[written + j].glyph = glyph_layers.arrayZ[j].glyphId;
+	    layers[written + j].color_index = glyph_layers.arrayZ[j].colorIdx;
+	  }
+	  written += glyph_layers.length;
+	}
+	total += glyph_layers.length;
+      }
+      if (layer_starts) layer_starts[glyph_count] = total;
+      if (layer_count) *layer_count = written;
+      return total;
+    }
+
+    private:
+    const uint16_t *get_dense_index () const
+    {
+      if (num_glyphs > HB_OT_COLR_DENSE_INDEX_MAX_GLYPHS ||
+	  !table->has_data ())
+	return nullptr;
+
+    retry:
+      uint16_t *index = dense_index.get ();
+      if (unlikely (!index))
+      {
+	index = (uint16_t *) calloc (num_glyphs, sizeof (index[0]));
+	if (unlikely (!index))
+	  return nullptr;
+
+	hb_array_t<const BaseGlyphRecord> records = table->get_base_glyph_records ();
+	for (unsigned int i = 0; i < records.length; i++)
+	  if (records[i].glyphId < num_glyphs && !index[records[i].glyphId])
+	    index[records[i].glyphId] = i + 1;
+
+	if (unlikely (!dense_index.cmpexch (nullptr, index)))
+	{
+	  free (index);
+	  goto retry;
+	}
+      }
+      return index;
+    }
+
+    hb_blob_ptr_t<COLR> table;
+    unsigned int num_glyphs;
+    /* Base glyph record index plus one, or zero, for each glyph. */
+    mutable hb_atomic_ptr_t<uint16_t> dense_index;
+  };
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -134,6 +259,8 @@ struct COLR
   DEFINE_SIZE_STATIC (14);
 };
 
+struct COLR_accelerator_t : COLR::accelerator_t {};
+
 } /* namespace OT */
 
 
@@ -145,6 +145,9 @@ struct sbix
     }
     void fini () { table.destroy (); }
 
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    { usage->add_blob (table); }
+
     bool has_data () const { return table->has_data (); }
 
     bool get_extents (hb_font_t          *font,
@@ -161,13 +164,22 @@ struct sbix
 			      int            *y_offset,
 			      unsigned int   *available_ppem) const
     {
-      return choose_strike (font).get_glyph_blob (glyph_id, table.get_blob (),
-						  HB_TAG ('p','n','g',' '),
-						  x_offset, y_offset,
-						  num_glyphs, available_ppem);
+      return reference_png (choose_strike (font), glyph_id,
+			    x_offset, y_offset, available_ppem);
     }
 
-    private:
+    /* For callers that cache the strike chosen for a font. */
+    hb_blob_t *reference_png (const SBIXStrike &strike,
+			      hb_codepoint_t    glyph_id,
+			      int              *x_offset,
+			      int              *y_offset,
+			      unsigned int     *available_ppem) const
+    {
+      return strike.get_glyph_blob (glyph_id, table.get_blob (),
+				    HB_TAG ('p','n','g',' '),
+				    x_offset, y_offset,
+				    num_glyphs, available_ppem);
+    }
 
     const SBIXStrike &choose_strike (hb_font_t *font) const
     {
@@ -50,6 +50,9 @@ struct SVGDocumentIndexEntry
 				    svgDocLength);
   }
 
+  hb_codepoint_t get_start_glyph () const { return startGlyphID; }
+  hb_codepoint_t get_end_glyph () const { return endGlyphID; }
+
   bool sanitize (hb_sanitize_context_t *c, const void *base) const
   {
     TRACE_SANITIZE (this);
@@ -80,21 +83,124 @@ struct SVG
   struct accelerator_t
   {
     void init (hb_face_t *face)
-    { table = hb_sanitize_context_t().reference_table<SVG> (face); }
-    void fini () { table.destroy (); }
+    {
+      table = hb_sanitize_context_t().reference_table<SVG> (face);
+      num_documents = table->get_document_count ();
+      last_document.set_relaxed (0);
+      blobs.set_relaxed (nullptr);
+    }
+    void fini ()
+    {
+      hb_atomic_ptr_t<hb_blob_t> *cached = blobs.get ();
+      if (cached)
+      {
+	for (unsigned int i = 0; i < num_documents; i++)
+	  hb_blob_destroy (cached[i].get ());
+	free (cached);
+      }
+      blobs.set_relaxed (nullptr);
+      table.destroy ();
+    }
+
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (table);
+      hb_atomic_ptr_t<hb_blob_t> *cached = blobs.get ();
+      if (cached)
+      {
+	usage->heap += num_documents * sizeof (cached[0]);
+	for (unsigned int i = 0; i < num_documents; i++)
+	  if (cached[i].get ())
+	    usage->heap += sizeof (hb_blob_t);
+      }
+    }
+
+    /* Index of the document index entry covering glyph_id, or -1.
+     * Consecutive lookups tend to hit the same entry, so that one is
+     * checked before searching. */
+    int get_document_index (hb_codepoint_t glyph_id) const
+    {
+      unsigned int last = last_document.get_relaxed ();
+      if (last < num_documents && !table->get_document (last).cmp (glyph_id))
+	return last;
+
+      unsigned int i;
+      if (!table->find_document (glyph_id, &i))
+	return -1;
+      last_document.set_relaxed (i);
+      return i;
+    }
+
+    const SVGDocumentIndexEntry &get_document (unsigned int index) const
+    { return table->get_document (index); }
+
+    hb_blob_t *reference_document_blob (unsigned int index) const
+    {
+      if (unlikely (index >= num_documents))
+	return hb_blob_get_empty ();
+
+      hb_atomic_ptr_t<hb_blob_t> *cached = get_blobs ();
+      if (unlikely (!cached))
+	return table->get_document (index).reference_blob (table.get_blob (),
+							   table->svgDocEntries);
+
+    retry:
+      hb_blob_t *blob = cached[index].get ();
+      if (unlikely (!blob))
+      {
+	blob = table->get_document (index).reference_blob (table.get_blob (),
+							   table->svgDocEntries);
+	if (unlikely (!cached[index].cmpexch (nullptr, blob)))
+	{
+	  hb_blob_destroy (blob);
+	  goto retry;
+	}
+      }
+      return hb_blob_reference (blob);
+    }
 
     hb_blob_t *reference_blob_for_glyph (hb_codepoint_t glyph_id) const
     {
-      return table->get_glyph_entry (glyph_id).reference_blob (table.get_blob (),
-							       table->svgDocEntries);
+      int index = get_document_index (glyph_id);
+      return index < 0 ? hb_blob_get_empty () : reference_document_blob (index);
     }
 
     bool has_data () const { return table->has_data (); }
 
     private:
+    hb_atomic_ptr_t<hb_blob_t> *get_blobs () const
+    {
+    retry:
+      hb_atomic_ptr_t<hb_blob_t> *cached = blobs.get ();
+      if (unlikely (!cached))
+      {
+	cached = (hb_atomic_ptr_t<hb_blob_t> *) calloc (num_documents, sizeof (cached[0]));
+	if (unlikely (!cached))
+	  return nullptr;
+	if (unlikely (!blobs.cmpexch (nullptr, cached)))
+	{
+	  free (cached);
+	  goto retry;
+	}
+      }
+      return cached;
+    }
+
     hb_blob_ptr_t<SVG> table;
+    unsigned int num_documents;
+    mutable hb_atomic_int_t last_document;
+    /* Document blobs, created on first use. */
+    mutable hb_atomic_ptr_t<hb_atomic_ptr_t<hb_blob_t>> blobs;
   };
 
+  unsigned int get_document_count () const { return (this+svgDocEntries).len; }
+
+  const SVGDocumentIndexEntry &get_document (unsigned int index) const
+  { return (this+svgDocEntries)[index]; }
+
+  bool find_document (hb_codepoint_t glyph_id, unsigned int *index) const
+  { return (this+svgDocEntries).bfind (glyph_id, index); }
+
   const SVGDocumentIndexEntry &get_glyph_entry (hb_codepoint_t glyph_id) const
   { return (this+svgDocEntries).bsearch (glyph_id); }
 
@@ -40,6 +40,119 @@
 #include "hb-ot-layout.hh"
 
 
+#ifndef HB_OT_COLOR_PNG_CACHE_SIZE
+#define HB_OT_COLOR_PNG_CACHE_SIZE 64
+#endif
+
+/* The strikes hb_ot_color_glyph_reference_png() chose for a font, and the
+ * blobs it returned for recent glyphs; emptied whenever the font serial
+ * changes.  Holds a reference to each blob. */
+struct hb_ot_color_png_cache_t
+{
+  struct entry_t
+  {
+    hb_codepoint_t glyph;
+    hb_blob_t *blob;
+  };
+
+  /* On a miss, still hands out the strikes chosen so far. */
+  bool get (unsigned int font_serial, hb_codepoint_t glyph, hb_blob_t **blob,
+	    const OT::SBIXStrike **sbix_strike_,
+	    const OT::BitmapSizeTable **cbdt_strike_)
+  {
+    hb_lock_t l (lock);
+    if (serial != font_serial)
+      return false;
+    *sbix_strike_ = sbix_strike;
+    *cbdt_strike_ = cbdt_strike;
+    const entry_t &e = entries[glyph % HB_OT_COLOR_PNG_CACHE_SIZE];
+    if (!e.blob || e.glyph != glyph)
+      return false;
+    *blob = hb_blob_reference (e.blob);
+    return true;
+  }
+
+  void set (unsigned int font_serial, hb_codepoint_t glyph, hb_blob_t *blob,
+	    const OT::SBIXStrike *sbix_strike_,
+	    const OT::BitmapSizeTable *cbdt_strike_)
+  {
+    hb_blob_t *old;
+    {
+      hb_lock_t l (lock);
+      if (serial != font_serial)
+      {
+	clear ();
+	serial = font_serial;
+      }
+      sbix_strike = sbix_strike_;
+      cbdt_strike = cbdt_strike_;
+      entry_t &e = entries[glyph % HB_OT_COLOR_PNG_CACHE_SIZE];
+      old = e.blob;
+      e.glyph = glyph;
+      e.blob = hb_blob_reference (blob);
+    }
+    hb_blob_destroy (old);
+  }
+
+  void clear ()
+  {
+    sbix_strike = nullptr;
+    cbdt_strike = nullptr;
+    for (unsigned int i = 0; i < HB_OT_COLOR_PNG_CACHE_SIZE; i++)
+    {
+      hb_blob_destroy (entries[i].blob);
+      entries[i].blob = nullptr;
+    }
+  }
+
+  hb_mutex_t lock;
+  unsigned int serial;
+  const OT::SBIXStrike *sbix_strike;
+  const OT::BitmapSizeTable *cbdt_strike;
+  entry_t entries[HB_OT_COLOR_PNG_CACHE_SIZE];
+};
+
+/* Creates the PNG cache of font on first use; nullptr if that fails. */
+static hb_ot_color_png_cache_t *
+_hb_ot_color_get_png_cache (hb_font_t *font)
+{
+retry:
+  hb_ot_color_png_cache_t *cache = font->png_cache.get ();
+  if (unlikely (!cache))
+  {
+    if (unlikely (hb_object_is_inert (font)))
+      return nullptr;
+
+    cache = (hb_ot_color_png_cache_t *) calloc (1, sizeof (hb_ot_color_png_cache_t));
+    if (unlikely (!cache))
+      return nullptr;
+    cache->lock.init ();
+
+    if (unlikely (!font->png_cache.cmpexch (nullptr, cache)))
+    {
+      _hb_ot_color_png_cache_destroy (cache);
+      goto retry;
+    }
+  }
+  return cache;
+}
+
+void
+_hb_ot_color_png_cache_destroy (hb_ot_color_png_cache_t *cache)
+{
+  if (!cache) return;
+  cache->clear ();
+  cache->lock.fini ();
+  free (cache);
+}
+
+unsigned int
+_hb_ot_color_png_cache_get_memory_usage (hb_ot_color_png_cache_t *cache)
+{
+  return cache ? sizeof (*cache) : 0;
+}
+
+
 /**
  * SECTION:hb-ot-color
  * @title: hb-ot-color
@@ -66,6 +179,9 @@
 hb_bool_t
 hb_ot_color_has_palettes (hb_face_t *face)
 {
+#if defined(HB_NO_COLOR)
+  return false;
+#endif
   return face->table.CPAL->has_data ();
 }
 
@@ -81,6 +197,9 @@ hb_ot_color_has_palettes (hb_face_t *face)
 unsigned int
 hb_ot_color_palette_get_count (hb_face_t *face)
 {
+#if defined(HB_NO_COLOR)
+  return 0;
+#endif
   return face->table.CPAL->get_palette_count ();
 }
 
@@ -101,6 +220,9 @@ hb_ot_name_id_t
 hb_ot_color_palette_get_name_id (hb_face_t *face,
 				 unsigned int palette_index)
 {
+#if defined(HB_NO_COLOR)
+  return HB_OT_NAME_ID_INVALID;
+#endif
   return face->table.CPAL->get_palette_name_id (palette_index);
 }
 
@@ -117,6 +239,9 @@ hb_ot_name_id_t
 hb_ot_color_palette_color_get_name_id (hb_face_t *face,
 				       unsigned int color_index)
 {
+#if defined(HB_NO_COLOR)
+  return HB_OT_NAME_ID_INVALID;
+#endif
   return face->table.CPAL->get_color_name_id (color_index);
 }
 
@@ -133,6 +258,9 @@ hb_ot_color_palette_flags_t
 hb_ot_color_palette_get_flags (hb_face_t *face,
 			       unsigned int palette_index)
 {
+#if defined(HB_NO_COLOR)
+  return HB_OT_COLOR_PALETTE_FLAG_DEFAULT;
+#endif
   return face->table.CPAL->get_palette_flags (palette_index);
 }
 
@@ -167,6 +295,11 @@ hb_ot_color_palette_get_colors (hb_face_t     *face,
 				unsigned int  *colors_count  /* IN/OUT.  May be NULL. */,
 				hb_color_t    *colors        /* OUT.     May be NULL. */)
 {
+#if defined(HB_NO_COLOR)
+  if (colors_count)
+    *colors_count = 0;
+  return 0;
+#endif
   return face->table.CPAL->get_palette_colors (palette_index, start_offset, colors_count, colors);
 }
 
@@ -186,6 +319,9 @@ hb_ot_color_palette_get_colors (hb_face_t     *face,
 hb_bool_t
 hb_ot_color_has_layers (hb_face_t *face)
 {
+#if defined(HB_NO_COLOR)
+  return false;
+#endif
   return face->table.COLR->has_data ();
 }
 
@@ -209,9 +345,56 @@ hb_ot_color_glyph_get_layers (hb_face_t           *face,
 			      unsigned int        *count, /* IN/OUT.  May be NULL. */
 			      hb_ot_color_layer_t *layers /* OUT.     May be NULL. */)
 {
+#if defined(HB_NO_COLOR)
+  if (count)
+    *count = 0;
+  return 0;
+#endif
   return face->table.COLR->get_glyph_layers (glyph, start_offset, count, layers);
 }
 
+/**
+ * hb_ot_color_glyphs_get_layers:
+ * @face:         a font face.
+ * @glyph_count:  number of glyphs in @glyphs.
+ * @glyphs: (array length=glyph_count): glyph ids to look up.
+ * @layer_starts: (array) (out) (optional): gets @glyph_count + 1 offsets;
+ * 		  the layers of @glyphs[i] are at @layer_starts[i] up to
+ * 		  @layer_starts[i + 1] in the full result.
+ * @layer_count:  (inout) (optional): gets number of layers available to be
+ * 		  written on buffer and returns number of written layers.
+ * @layers: (array length=layer_count) (out) (optional): layers buffer to buffer.
+ *
+ * Fetches the layers of many glyphs in one call.  Layers are written
+ * glyph by glyph until the next glyph's layers don't fit in @layers;
+ * if the return value is larger than the returned @layer_count, call
+ * again with a buffer of at least that size.  Glyphs that are not
+ * layered color glyphs contribute no layers.
+ *
+ * Returns: Total number of layers of all the glyphs.
+ *
+ * Since: REPLACEME
+ */
+unsigned int
+hb_ot_color_glyphs_get_layers (hb_face_t            *face,
+			       unsigned int          glyph_count,
+			       const hb_codepoint_t *glyphs,
+			       unsigned int         *layer_starts, /* OUT.     May be NULL. */
+			       unsigned int         *layer_count, /* IN/OUT.  May be NULL. */
+			       hb_ot_color_layer_t  *layers /* OUT.     May be NULL. */)
+{
+#if defined(HB_NO_COLOR)
+  if (layer_starts)
+    for (unsigned int i = 0; i <= glyph_count; i++)
+      layer_starts[i] = 0;
+  if (layer_count)
+    *layer_count = 0;
+  return 0;
+#endif
+  return face->table.COLR->get_glyphs_layers (glyph_count, glyphs,
+					      layer_starts, layer_count, layers);
+}
+
 
 /*
  * SVG
@@ -230,6 +413,9 @@ hb_ot_color_glyph_get_layers (hb_face_t           *face,
 hb_bool_t
 hb_ot_color_has_svg (hb_face_t *face)
 {
+#if defined(HB_NO_COLOR)
+  return false;
+#endif
   return face->table.SVG->has_data ();
 }
 
@@ -247,9 +433,75 @@ hb_ot_color_has_svg (hb_face_t *face)
 hb_blob_t *
 hb_ot_color_glyph_reference_svg (hb_face_t *face, hb_codepoint_t glyph)
 {
+#if defined(HB_NO_COLOR)
+  return hb_blob_get_empty ();
+#endif
   return face->table.SVG->reference_blob_for_glyph (glyph);
 }
 
+/**
+ * hb_ot_color_glyph_get_svg_document:
+ * @face:           a font face.
+ * @glyph:          a svg glyph index.
+ * @document_index: (out) (optional): index of the SVG document of @glyph.
+ * @start_glyph:    (out) (optional): first glyph drawn by the document.
+ * @end_glyph:      (out) (optional): last glyph drawn by the document.
+ *
+ * Finds the SVG document that draws @glyph, along with the range of
+ * glyphs that share it, so that clients can parse each document once
+ * and reuse it for all of its glyphs.  Use
+ * hb_ot_color_svg_reference_document() to get its data.
+ *
+ * Returns: true if @glyph has an SVG document, false otherwise.
+ *
+ * Since: REPLACEME
+ */
+hb_bool_t
+hb_ot_color_glyph_get_svg_document (hb_face_t      *face,
+				    hb_codepoint_t  glyph,
+				    unsigned int   *document_index, /* OUT.  May be NULL. */
+				    hb_codepoint_t *start_glyph, /* OUT.  May be NULL. */
+				    hb_codepoint_t *end_glyph /* OUT.  May be NULL. */)
+{
+#if defined(HB_NO_COLOR)
+  return false;
+#endif
+  const OT::SVG_accelerator_t &svg = *face->table.SVG;
+  int index = svg.get_document_index (glyph);
+  if (index < 0)
+    return false;
+
+  const OT::SVGDocumentIndexEntry &entry = svg.get_document (index);
+  if (document_index) *document_index = index;
+  if (start_glyph) *start_glyph = entry.get_start_glyph ();
+  if (end_glyph) *end_glyph = entry.get_end_glyph ();
+  return true;
+}
+
+/**
+ * hb_ot_color_svg_reference_document:
+ * @face:           a font face.
+ * @document_index: an index returned by hb_ot_color_glyph_get_svg_document().
+ *
+ * Get an SVG document by index.  The blob may be either plain text or
+ * gzip-encoded.  Blobs are created once per face and shared by later
+ * calls, here and in hb_ot_color_glyph_reference_svg().
+ *
+ * Returns: (transfer full): the document, or the empty blob if
+ * @document_index is out of range.
+ *
+ * Since: REPLACEME
+ */
+hb_blob_t *
+hb_ot_color_svg_reference_document (hb_face_t    *face,
+				    unsigned int  document_index)
+{
+#if defined(HB_NO_COLOR)
+  return hb_blob_get_empty ();
+#endif
+  return face->table.SVG->reference_document_blob (document_index);
+}
+
 
 /*
  * PNG: CBDT or sbix
@@ -268,6 +520,9 @@ hb_ot_color_glyph_reference_svg (hb_face_t *face, hb_codepoint_t glyph)
 hb_bool_t
 hb_ot_color_has_png (hb_face_t *face)
 {
+#if defined(HB_NO_COLOR)
+  return false;
+#endif
   return face->table.CBDT->has_data () || face->table.sbix->has_data ();
 }
 
@@ -287,13 +542,35 @@ hb_ot_color_has_png (hb_face_t *face)
 hb_blob_t *
 hb_ot_color_glyph_reference_png (hb_font_t *font, hb_codepoint_t  glyph)
 {
-  hb_blob_t *blob = hb_blob_get_empty ();
+#if defined(HB_NO_COLOR)
+  return hb_blob_get_empty ();
+#endif
+  hb_ot_color_png_cache_t *cache = _hb_ot_color_get_png_cache (font);
+  const OT::SBIXStrike *sbix_strike = nullptr;
+  const OT::BitmapSizeTable *cbdt_strike = nullptr;
+  hb_blob_t *blob;
+
+  if (cache && cache->get (font->serial, glyph, &blob, &sbix_strike, &cbdt_strike))
+    return blob;
+
+  blob = hb_blob_get_empty ();
 
   if (font->face->table.sbix->has_data ())
-    blob = font->face->table.sbix->reference_png (font, glyph, nullptr, nullptr, nullptr);
+  {
+    if (!sbix_strike)
+      sbix_strike = &font->face->table.sbix->choose_strike (font);
+    blob = font->face->table.sbix->reference_png (*sbix_strike, glyph, nullptr, nullptr, nullptr);
+  }
 
   if (!blob->length && font->face->table.CBDT->has_data ())
-    blob = font->face->table.CBDT->reference_png (font, glyph);
+  {
+    if (!cbdt_strike)
+      cbdt_strike = &font->face->table.CBDT->choose_strike (font);
+    blob = font->face->table.CBDT->reference_png (*cbdt_strike, glyph);
+  }
+
+  if (cache)
+    cache->set (font->serial, glyph, blob, sbix_strike, cbdt_strike);
 
   return blob;
 }
@@ -113,6 +113,14 @@ hb_ot_color_glyph_get_layers (hb_face_t           *face,
 			      unsigned int        *count, /* IN/OUT.  May be NULL. */
 			      hb_ot_color_layer_t *layers /* OUT.     May be NULL. */);
 
+HB_EXTERN unsigned int
+hb_ot_color_glyphs_get_layers (hb_face_t            *face,
+			       unsigned int          glyph_count,
+			       const hb_codepoint_t *glyphs,
+			       unsigned int         *layer_starts, /* OUT.     May be NULL. */
+			       unsigned int         *layer_count, /* IN/OUT.  May be NULL. */
+			       hb_ot_color_layer_t  *layers /* OUT.     May be NULL. */);
+
 /*
  * SVG
  */
@@ -123,6 +131,17 @@ hb_ot_color_has_svg (hb_face_t *face);
 HB_EXTERN hb_blob_t *
 hb_ot_color_glyph_reference_svg (hb_face_t *face, hb_codepoint_t glyph);
 
+HB_EXTERN hb_bool_t
+hb_ot_color_glyph_get_svg_document (hb_face_t      *face,
+				    hb_codepoint_t  glyph,
+				    unsigned int   *document_index, /* OUT.  May be NULL. */
+				    hb_codepoint_t *start_glyph, /* OUT.  May be NULL. */
+				    hb_codepoint_t *end_glyph /* OUT.  May be NULL. */);
+
+HB_EXTERN hb_blob_t *
+hb_ot_color_svg_reference_document (hb_face_t    *face,
+				    unsigned int  document_index);
+
 /*
  * PNG: CBDT or sbix
  */
@@ -26,20 +26,40 @@
 
 #include "hb-ot-face.hh"
 
+#include "hb-aat-layout-ankr-table.hh"
+#include "hb-aat-layout-feat-table.hh"
+#include "hb-aat-layout-kerx-table.hh"
+#include "hb-aat-layout-lcar-table.hh"
+#include "hb-aat-layout-morx-table.hh"
+#include "hb-aat-layout-trak-table.hh"
+#include "hb-aat-ltag-table.hh"
 #include "hb-ot-cmap-table.hh"
 #include "hb-ot-glyf-table.hh"
 #include "hb-ot-cff1-table.hh"
 #include "hb-ot-cff2-table.hh"
+#include "hb-ot-head-table.hh"
 #include "hb-ot-hmtx-table.hh"
 #include "hb-ot-kern-table.hh"
+#include "hb-ot-math-table.hh"
 #include "hb-ot-name-table.hh"
+#include "hb-ot-os2-table.hh"
 #include "hb-ot-post-table.hh"
+#include "hb-ot-stat-table.hh"
+#include "hb-ot-vorg-table.hh"
+#include "hb-ot-var-avar-table.hh"
+#include "hb-ot-var-fvar-table.hh"
+#include "hb-ot-var-gvar-table.hh"
+#include "hb-ot-var-mvar-table.hh"
 #include "hb-ot-color-cbdt-table.hh"
+#include "hb-ot-color-colr-table.hh"
+#include "hb-ot-color-cpal-table.hh"
 #include "hb-ot-color-sbix-table.hh"
 #include "hb-ot-color-svg-table.hh"
+#include "hb-ot-layout-base-table.hh"
 #include "hb-ot-layout-gdef-table.hh"
 #include "hb-ot-layout-gsub-table.hh"
 #include "hb-ot-layout-gpos-table.hh"
+#include "hb-ot-layout-jstf-table.hh"
 
 
 void hb_ot_face_t::init0 (hb_face_t *face)
@@ -59,3 +79,105 @@ void hb_ot_face_t::fini ()
 #undef HB_OT_ACCELERATOR
 #undef HB_OT_TABLE
 }
+
+void hb_ot_face_t::add_memory_usage (hb_memory_usage_t *tables,
+				     hb_memory_usage_t *accelerators) const
+{
+#define HB_OT_TABLE(Namespace, Type) Type.add_memory_usage (tables);
+#define HB_OT_ACCELERATOR(Namespace, Type) Type.add_memory_usage (accelerators);
+  HB_OT_TABLES
+#undef HB_OT_ACCELERATOR
+#undef HB_OT_TABLE
+}
+
+/* Accelerators that objects created from the face point to: hb_ot_font_t
+ * keeps the cmap and hmtx ones, and shape plans the GSUB and GPOS lookup
+ * accelerators. */
+static bool
+is_pinned (hb_ot_face_t::order_t order)
+{
+  return order == hb_ot_face_t::HB_OT_TABLE_ORDER (OT, cmap) ||
+	 order == hb_ot_face_t::HB_OT_TABLE_ORDER (OT, hmtx) ||
+	 order == hb_ot_face_t::HB_OT_TABLE_ORDER (OT, GSUB) ||
+	 order == hb_ot_face_t::HB_OT_TABLE_ORDER (OT, GPOS);
+}
+
+template <typename Loader>
+static void
+trim_instance (Loader &loader)
+{
+  auto *p = loader.get_stored_relaxed ();
+  if (p && p != Loader::get_null ())
+    p->trim ();
+}
+
+void hb_ot_face_t::trim ()
+{
+  /* Plain tables stay; they are mostly sub-blobs of the face blob. */
+#define HB_OT_TABLE(Namespace, Type)
+#define HB_OT_ACCELERATOR(Namespace, Type) \
+  if (!is_pinned (HB_OT_TABLE_ORDER (Namespace, Type))) Type.free_instance ();
+  HB_OT_TABLES
+#undef HB_OT_ACCELERATOR
+#undef HB_OT_TABLE
+
+  trim_instance (GSUB);
+  trim_instance (GPOS);
+}
+
+void hb_ot_face_t::warm_up_table (hb_tag_t tag)
+{
+#define HB_OT_TABLE(Namespace, Type) \
+  if (tag == Namespace::Type::tableTag) { Type.get_stored (); return; }
+#define HB_OT_ACCELERATOR(Namespace, Type) HB_OT_TABLE (Namespace, Type)
+  HB_OT_TABLES
+#undef HB_OT_ACCELERATOR
+#undef HB_OT_TABLE
+}
+
+/* What the first hb_shape() on a face loads. */
+static const hb_tag_t shaping_tables[] =
+{
+  HB_OT_TAG_cmap,
+  HB_OT_TAG_hmtx,
+  HB_OT_TAG_GDEF,
+  HB_OT_TAG_GSUB,
+  HB_OT_TAG_GPOS,
+  HB_OT_TAG_kern,
+  HB_AAT_TAG_morx,
+  HB_AAT_TAG_kerx,
+};
+
+struct hb_ot_face_warm_up_t
+{
+  hb_ot_face_t *table;
+  const hb_tag_t *tags;
+
+  static void run (unsigned int index, void *job_data)
+  {
+    hb_ot_face_warm_up_t *c = (hb_ot_face_warm_up_t *) job_data;
+    c->table->warm_up_table (c->tags[index]);
+  }
+};
+
+void hb_ot_face_t::warm_up (const hb_tag_t *tags, unsigned int count,
+			    hb_executor_func_t executor, void *user_data)
+{
+  if (!tags)
+  {
+    tags = shaping_tables;
+    count = ARRAY_LENGTH (shaping_tables);
+  }
+
+  /* Nearly every table needs these while loading; get them out of the
+   * way before going concurrent. */
+  hb_face_get_upem (face);
+  hb_face_get_glyph_count (face);
+
+  hb_ot_face_warm_up_t c = {this, tags};
+  if (executor)
+    executor (count, hb_ot_face_warm_up_t::run, &c, user_data);
+  else
+    for (unsigned int i = 0; i < count; i++)
+      hb_ot_face_warm_up_t::run (i, &c);
+}
@@ -45,7 +45,7 @@
     HB_OT_ACCELERATOR(OT, hmtx) \
     HB_OT_ACCELERATOR(OT, vmtx) \
     HB_OT_ACCELERATOR(OT, post) \
-    HB_OT_TABLE(OT, kern) \
+    HB_OT_ACCELERATOR(OT, kern) \
     HB_OT_ACCELERATOR(OT, glyf) \
     HB_OT_ACCELERATOR(OT, cff1) \
     HB_OT_ACCELERATOR(OT, cff2) \
@@ -62,7 +62,7 @@
     /* AAT shaping. */ \
     HB_OT_TABLE(AAT, mort) \
     HB_OT_TABLE(AAT, morx) \
-    HB_OT_TABLE(AAT, kerx) \
+    HB_OT_ACCELERATOR(AAT, kerx) \
     HB_OT_TABLE(AAT, ankr) \
     HB_OT_TABLE(AAT, trak) \
     HB_OT_TABLE(AAT, lcar) \
@@ -71,11 +71,12 @@
     /* OpenType variations. */ \
     HB_OT_TABLE(OT, fvar) \
     HB_OT_TABLE(OT, avar) \
+    HB_OT_ACCELERATOR(OT, gvar) \
     HB_OT_TABLE(OT, MVAR) \
     /* OpenType math. */ \
-    HB_OT_TABLE(OT, MATH) \
+    HB_OT_ACCELERATOR(OT, MATH) \
     /* OpenType color fonts. */ \
-    HB_OT_TABLE(OT, COLR) \
+    HB_OT_ACCELERATOR(OT, COLR) \
     HB_OT_TABLE(OT, CPAL) \
     HB_OT_ACCELERATOR(OT, CBDT) \
     HB_OT_ACCELERATOR(OT, sbix) \
@@ -94,6 +95,21 @@ struct hb_ot_face_t
   HB_INTERNAL void init0 (hb_face_t *face);
   HB_INTERNAL void fini ();
 
+  /* Loads the listed tables, or those shaping needs if tags is nullptr,
+   * as independent jobs on executor; on this thread if that is nullptr. */
+  HB_INTERNAL void warm_up (const hb_tag_t *tags, unsigned int count,
+			    hb_executor_func_t executor, void *user_data);
+  HB_INTERNAL void warm_up_table (hb_tag_t tag);
+
+  /* Frees the accelerators nothing points to and the caches of those
+   * something does, to be rebuilt on next use.  Nothing else may be
+   * using the face meanwhile. */
+  HB_INTERNAL void trim ();
+
+  /* Adds up the loaded tables' blobs and the accelerators' own memory. */
+  HB_INTERNAL void add_memory_usage (hb_memory_usage_t *tables,
+				     hb_memory_usage_t *accelerators) const;
+
 #define HB_OT_TABLE_ORDER(Namespace, Type) \
     HB_PASTE (ORDER_, HB_PASTE (Namespace, HB_PASTE (_, Type)))
   enum order_t
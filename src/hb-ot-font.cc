@@ -31,6 +31,7 @@
 #include "hb-font.hh"
 #include "hb-machinery.hh"
 #include "hb-ot-face.hh"
+#include "hb-cache.hh"
 
 #include "hb-ot-cmap-table.hh"
 #include "hb-ot-glyf-table.hh"
@@ -42,6 +43,7 @@
 #include "hb-ot-post-table.hh"
 #include "hb-ot-stat-table.hh" // Just so we compile it; unused otherwise.
 #include "hb-ot-vorg-table.hh"
+#include "hb-ot-var-mvar-table.hh"
 #include "hb-ot-color-cbdt-table.hh"
 #include "hb-ot-color-sbix-table.hh"
 
@@ -58,6 +60,262 @@
  **/
 
 
+#ifndef HB_OT_FONT_CMAP_CACHE_SIZE
+#define HB_OT_FONT_CMAP_CACHE_SIZE 256
+#endif
+#ifndef HB_OT_FONT_ADVANCE_CACHE_SIZE
+#define HB_OT_FONT_ADVANCE_CACHE_SIZE 256
+#endif
+#ifndef HB_OT_FONT_EXTENTS_CACHE_SIZE
+#define HB_OT_FONT_EXTENTS_CACHE_SIZE 128
+#endif
+#ifndef HB_OT_FONT_V_ORIGIN_CACHE_SIZE
+#define HB_OT_FONT_V_ORIGIN_CACHE_SIZE 256
+#endif
+
+/* Lock-free cache of unscaled glyph extents.  Each of the four fields is
+ * stored in its own word, tagged with the glyph, so a reader racing with a
+ * writer either sees a consistent entry or a miss.  Only glyphs below 65535
+ * with extents that fit 16 bits are cached.  A size of zero disables the
+ * cache. */
+struct hb_ot_extents_cache_t
+{
+  bool init (unsigned int size)
+  {
+    mask = 0;
+    words = nullptr;
+    if (!size)
+      return true;
+
+    size = 1u << (hb_bit_storage (size) - 1);
+    words = (hb_atomic_int_t *) malloc (4 * sizeof (hb_atomic_int_t) * size);
+    if (unlikely (!words))
+      return false;
+    mask = size - 1;
+    clear ();
+    return true;
+  }
+  void fini ()
+  {
+    free (words);
+    words = nullptr;
+    mask = 0;
+  }
+
+  void clear ()
+  {
+    if (!words) return;
+    for (unsigned int i = 0; i < 4 * (mask + 1); i++)
+      words[i].set_relaxed (-1);
+  }
+
+  bool get (hb_codepoint_t glyph, hb_glyph_extents_t *extents) const
+  {
+    if (!words || glyph >= 0xFFFFu)
+      return false;
+    const hb_atomic_int_t *entry = &words[4 * (glyph & mask)];
+    int v[4];
+    for (unsigned int i = 0; i < 4; i++)
+    {
+      unsigned int w = entry[i].get_relaxed ();
+      if ((w >> 16) != glyph)
+	return false;
+      v[i] = (int16_t) (w & 0xFFFFu);
+    }
+    extents->x_bearing = v[0];
+    extents->y_bearing = v[1];
+    extents->width     = v[2];
+    extents->height    = v[3];
+    return true;
+  }
+
+  void set (hb_codepoint_t glyph, const hb_glyph_extents_t &extents)
+  {
+    if (!words || glyph >= 0xFFFFu)
+      return;
+    int v[4] = {extents.x_bearing, extents.y_bearing, extents.width, extents.height};
+    for (unsigned int i = 0; i < 4; i++)
+      if (v[i] != (int16_t) v[i])
+	return;
+    hb_atomic_int_t *entry = &words[4 * (glyph & mask)];
+    for (unsigned int i = 0; i < 4; i++)
+      entry[i].set_relaxed ((glyph << 16) | (v[i] & 0xFFFFu));
+  }
+
+  unsigned int get_size () const { return words ? mask + 1 : 0; }
+
+  private:
+  unsigned int mask;
+  hb_atomic_int_t *words;
+};
+
+/* Font-wide ascender, descender and line gap of one direction, scaled and
+ * with MVAR deltas applied, for the font state of serial.  Values are
+ * stored before the serial; concurrent writers for the same state store
+ * the same values. */
+struct hb_ot_font_metrics_cache_t
+{
+  void init (unsigned int font_serial) { serial.set_relaxed (font_serial - 1); }
+
+  bool get (const hb_font_t *font, hb_font_extents_t *metrics) const
+  {
+    if ((unsigned int) serial.get () != font->serial)
+      return false;
+    metrics->ascender = values[0].get_relaxed ();
+    metrics->descender = values[1].get_relaxed ();
+    metrics->line_gap = values[2].get_relaxed ();
+    return true;
+  }
+
+  void set (const hb_font_t *font, const hb_font_extents_t &metrics)
+  {
+    values[0].set_relaxed (metrics.ascender);
+    values[1].set_relaxed (metrics.descender);
+    values[2].set_relaxed (metrics.line_gap);
+    serial.set (font->serial);
+  }
+
+  private:
+  hb_atomic_int_t serial;
+  hb_atomic_int_t values[3];
+};
+
+/* HVAR/VVAR region scalars at the coords of one font serial. */
+struct hb_ot_var_cache_t
+{
+  unsigned int serial;
+  float *scalars;
+};
+
+struct hb_ot_font_t
+{
+  const hb_ot_face_t *ot_face;
+
+  /* Accelerators every shaping run needs, resolved at creation so that the
+   * per-glyph callbacks don't go through the lazy loaders. */
+  const OT::cmap_accelerator_t *cmap;
+  const OT::hmtx_accelerator_t *hmtx;
+
+  /* Caches; lock-free, hence mutable. */
+  mutable hb_cmap_dynamic_cache_t cmap_cache;
+  mutable hb_advance_dynamic_cache_t advance_cache; /* Unscaled, default instance only. */
+  mutable hb_origin_dynamic_cache_t v_origin_cache; /* Unscaled y, default instance only. */
+  mutable hb_ot_extents_cache_t extents_cache; /* Unscaled; valid for extents_serial. */
+  mutable hb_atomic_int_t extents_serial;
+  mutable hb_ot_font_metrics_cache_t h_metrics_cache;
+  mutable hb_ot_font_metrics_cache_t v_metrics_cache;
+  /* Only for fonts with no room left for the store's scalars; taken by
+   * one caller at a time, see _hb_ot_font_acquire_var_cache(). */
+  mutable hb_atomic_ptr_t<hb_ot_var_cache_t> h_var_cache;
+  mutable hb_atomic_ptr_t<hb_ot_var_cache_t> v_var_cache;
+};
+
+static void
+_hb_ot_var_cache_destroy (hb_ot_var_cache_t *cache)
+{
+  if (!cache) return;
+  OT::VariationStore::destroy_cache (cache->scalars);
+  free (cache);
+}
+
+/* Returns a cache valid for font's current coords, or nullptr.  It must be
+ * handed back with _hb_ot_font_release_var_cache(). */
+template <typename Accel>
+static hb_ot_var_cache_t *
+_hb_ot_font_acquire_var_cache (hb_atomic_ptr_t<hb_ot_var_cache_t> &slot,
+			       const Accel &mtx,
+			       hb_font_t *font)
+{
+  if (!mtx.wants_var_cache (font))
+    return nullptr;
+
+  hb_ot_var_cache_t *cache = slot.get ();
+  if (!cache || !slot.cmpexch (cache, nullptr))
+  {
+    /* First use, or another thread holds it. */
+    cache = (hb_ot_var_cache_t *) calloc (1, sizeof (hb_ot_var_cache_t));
+    if (unlikely (!cache))
+      return nullptr;
+    cache->scalars = mtx.create_var_cache ();
+    if (!cache->scalars)
+    {
+      free (cache);
+      return nullptr;
+    }
+    cache->serial = font->serial;
+    return cache;
+  }
+  if (cache->serial != font->serial)
+  {
+    mtx.reset_var_cache (cache->scalars);
+    cache->serial = font->serial;
+  }
+  return cache;
+}
+
+static void
+_hb_ot_font_release_var_cache (hb_atomic_ptr_t<hb_ot_var_cache_t> &slot,
+			       hb_ot_var_cache_t *cache)
+{
+  if (cache && !slot.cmpexch (nullptr, cache))
+    _hb_ot_var_cache_destroy (cache);
+}
+
+static hb_ot_font_t *
+_hb_ot_font_create (hb_font_t *font)
+{
+  hb_ot_font_t *ot_font = (hb_ot_font_t *) calloc (1, sizeof (hb_ot_font_t));
+  if (unlikely (!ot_font))
+    return nullptr;
+
+  ot_font->ot_face = &font->face->table;
+  ot_font->cmap = ot_font->ot_face->cmap.get ();
+  ot_font->hmtx = ot_font->ot_face->hmtx.get ();
+  ot_font->cmap_cache.init (HB_OT_FONT_CMAP_CACHE_SIZE);
+  ot_font->advance_cache.init (HB_OT_FONT_ADVANCE_CACHE_SIZE);
+  ot_font->v_origin_cache.init (HB_OT_FONT_V_ORIGIN_CACHE_SIZE);
+  ot_font->extents_cache.init (HB_OT_FONT_EXTENTS_CACHE_SIZE);
+  ot_font->extents_serial.set_relaxed (font->serial);
+  ot_font->h_metrics_cache.init (font->serial);
+  ot_font->v_metrics_cache.init (font->serial);
+
+  return ot_font;
+}
+
+static void
+_hb_ot_font_destroy (void *font_data)
+{
+  hb_ot_font_t *ot_font = (hb_ot_font_t *) font_data;
+
+  ot_font->cmap_cache.fini ();
+  ot_font->advance_cache.fini ();
+  ot_font->v_origin_cache.fini ();
+  ot_font->extents_cache.fini ();
+  _hb_ot_var_cache_destroy (ot_font->h_var_cache.get ());
+  _hb_ot_var_cache_destroy (ot_font->v_var_cache.get ());
+
+  free (ot_font);
+}
+
+
+hb_bool_t
+_hb_ot_font_get_nominal_glyph (const hb_ot_font_t *ot_font,
+			       hb_codepoint_t unicode,
+			       hb_codepoint_t *glyph)
+{
+  unsigned int v;
+  if (ot_font->cmap_cache.get (unicode, &v))
+  {
+    *glyph = v;
+    return true;
+  }
+
+  if (!ot_font->cmap->get_nominal_glyph (unicode, glyph))
+    return false;
+  ot_font->cmap_cache.set (unicode, *glyph);
+  return true;
+}
+
 static hb_bool_t
 hb_ot_get_nominal_glyph (hb_font_t *font HB_UNUSED,
 			 void *font_data,
@@ -65,8 +323,60 @@ hb_ot_get_nominal_glyph (hb_font_t *font HB_UNUSED,
 			 hb_codepoint_t *glyph,
 			 void *user_data HB_UNUSED)
 {
-  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
-  return ot_face->cmap->get_nominal_glyph (unicode, glyph);
+  return _hb_ot_font_get_nominal_glyph ((const hb_ot_font_t *) font_data, unicode, glyph);
+}
+
+unsigned int
+_hb_ot_font_get_nominal_glyphs (const hb_ot_font_t *ot_font,
+				unsigned int count,
+				const hb_codepoint_t *first_unicode,
+				unsigned int unicode_stride,
+				hb_codepoint_t *first_glyph,
+				unsigned int glyph_stride)
+{
+  if (!ot_font->cmap_cache.get_size ())
+    return ot_font->cmap->get_nominal_glyphs (count,
+					      first_unicode, unicode_stride,
+					      first_glyph, glyph_stride);
+
+  const OT::cmap_accelerator_t &cmap = *ot_font->cmap;
+  unsigned int done = 0;
+  while (done < count)
+  {
+    unsigned int v;
+    if (ot_font->cmap_cache.get (*first_unicode, &v))
+    {
+      *first_glyph = v;
+      first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+      first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+      done++;
+      continue;
+    }
+
+    /* Resolve the whole run of misses in one go, so that the cmap
+     * subtable can keep its current segment hot. */
+    unsigned int run = 1;
+    const hb_codepoint_t *next_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+    while (done + run < count && !ot_font->cmap_cache.get (*next_unicode, &v))
+    {
+      next_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (next_unicode, unicode_stride);
+      run++;
+    }
+
+    unsigned int mapped = cmap.get_nominal_glyphs (run,
+						   first_unicode, unicode_stride,
+						   first_glyph, glyph_stride);
+    for (unsigned int i = 0; i < mapped; i++)
+    {
+      ot_font->cmap_cache.set (*first_unicode, *first_glyph);
+      first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+      first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+    }
+    done += mapped;
+    if (mapped < run)
+      break;
+  }
+  return done;
 }
 
 static unsigned int
@@ -79,10 +389,9 @@ hb_ot_get_nominal_glyphs (hb_font_t *font HB_UNUSED,
 			  unsigned int glyph_stride,
 			  void *user_data HB_UNUSED)
 {
-  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
-  return ot_face->cmap->get_nominal_glyphs (count,
-					    first_unicode, unicode_stride,
-					    first_glyph, glyph_stride);
+  return _hb_ot_font_get_nominal_glyphs ((const hb_ot_font_t *) font_data, count,
+					 first_unicode, unicode_stride,
+					 first_glyph, glyph_stride);
 }
 
 static hb_bool_t
@@ -93,8 +402,48 @@ hb_ot_get_variation_glyph (hb_font_t *font HB_UNUSED,
 			   hb_codepoint_t *glyph,
 			   void *user_data HB_UNUSED)
 {
-  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
-  return ot_face->cmap->get_variation_glyph (unicode, variation_selector, glyph);
+  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
+  return ot_font->cmap->get_variation_glyph (unicode, variation_selector, glyph);
+}
+
+void
+_hb_ot_font_get_glyph_h_advances (hb_font_t *font,
+				  const hb_ot_font_t *ot_font,
+				  unsigned int count,
+				  const hb_codepoint_t *first_glyph,
+				  unsigned int glyph_stride,
+				  hb_position_t *first_advance,
+				  unsigned int advance_stride)
+{
+  const OT::hmtx_accelerator_t &hmtx = *ot_font->hmtx;
+
+  /* Variation deltas depend on coords; only cache the default instance. */
+  if (font->num_coords || !ot_font->advance_cache.get_size ())
+  {
+    hb_ot_var_cache_t *var_cache = _hb_ot_font_acquire_var_cache (ot_font->h_var_cache, hmtx, font);
+    float *scalars = var_cache ? var_cache->scalars : nullptr;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      *first_advance = font->em_scale_x (hmtx.get_advance (*first_glyph, font, scalars));
+      first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+      first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
+    }
+    _hb_ot_font_release_var_cache (ot_font->h_var_cache, var_cache);
+    return;
+  }
+
+  for (unsigned int i = 0; i < count; i++)
+  {
+    unsigned int v;
+    if (!ot_font->advance_cache.get (*first_glyph, &v))
+    {
+      v = hmtx.get_advance (*first_glyph, font);
+      ot_font->advance_cache.set (*first_glyph, v);
+    }
+    *first_advance = font->em_scale_x (v);
+    first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+    first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
+  }
 }
 
 static void
@@ -106,15 +455,9 @@ hb_ot_get_glyph_h_advances (hb_font_t* font, void* font_data,
 			    unsigned advance_stride,
 			    void *user_data HB_UNUSED)
 {
-  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
-  const OT::hmtx_accelerator_t &hmtx = *ot_face->hmtx;
-
-  for (unsigned int i = 0; i < count; i++)
-  {
-    *first_advance = font->em_scale_x (hmtx.get_advance (*first_glyph, font));
-    first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
-    first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
-  }
+  _hb_ot_font_get_glyph_h_advances (font, (const hb_ot_font_t *) font_data, count,
+				    first_glyph, glyph_stride,
+				    first_advance, advance_stride);
 }
 
 static void
@@ -126,15 +469,98 @@ hb_ot_get_glyph_v_advances (hb_font_t* font, void* font_data,
 			    unsigned advance_stride,
 			    void *user_data HB_UNUSED)
 {
-  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
-  const OT::vmtx_accelerator_t &vmtx = *ot_face->vmtx;
+  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
+  const OT::vmtx_accelerator_t &vmtx = *ot_font->ot_face->vmtx;
 
+  hb_ot_var_cache_t *var_cache = _hb_ot_font_acquire_var_cache (ot_font->v_var_cache, vmtx, font);
+  float *scalars = var_cache ? var_cache->scalars : nullptr;
   for (unsigned int i = 0; i < count; i++)
   {
-    *first_advance = font->em_scale_y (-(int) vmtx.get_advance (*first_glyph, font));
+    *first_advance = font->em_scale_y (-(int) vmtx.get_advance (*first_glyph, font, scalars));
     first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
     first_advance = &StructAtOffsetUnaligned<hb_position_t> (first_advance, advance_stride);
   }
+  _hb_ot_font_release_var_cache (ot_font->v_var_cache, var_cache);
+}
+
+/* Unscaled y of the vertical origin of glyph, from VORG or else from the
+ * glyph outline and vmtx; false if neither has it. */
+static bool
+_hb_ot_get_glyph_v_origin_y (hb_font_t *font,
+			     const hb_ot_font_t *ot_font,
+			     const OT::VORG &VORG,
+			     hb_codepoint_t glyph,
+			     int *y)
+{
+  /* The outline and side bearing vary; only cache the default instance. */
+  bool use_cache = !font->num_coords;
+  unsigned int v;
+  if (use_cache && ot_font->v_origin_cache.get (glyph, &v))
+  {
+    *y = (int16_t) v;
+    return true;
+  }
+
+  if (VORG.has_data ())
+    *y = VORG.get_y_origin (glyph);
+  else
+  {
+    const hb_ot_face_t *ot_face = ot_font->ot_face;
+    hb_glyph_extents_t extents = {0};
+    if (!ot_face->glyf->get_extents (font, glyph, &extents))
+      return false;
+    *y = extents.y_bearing + (int) ot_face->vmtx->get_side_bearing (glyph);
+  }
+
+  if (use_cache && *y == (int16_t) *y)
+    ot_font->v_origin_cache.set (glyph, *y & 0xFFFFu);
+  return true;
+}
+
+static hb_bool_t
+hb_ot_get_glyph_v_origins (hb_font_t *font,
+			   void *font_data,
+			   unsigned int count,
+			   const hb_codepoint_t *first_glyph,
+			   unsigned int glyph_stride,
+			   hb_position_t *first_x,
+			   unsigned int x_stride,
+			   hb_position_t *first_y,
+			   unsigned int y_stride,
+			   void *user_data HB_UNUSED)
+{
+  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
+  const OT::VORG &VORG = *ot_font->ot_face->VORG;
+
+  font->get_glyph_h_advances (count, first_glyph, glyph_stride, first_x, x_stride);
+
+  bool have_ascender = false;
+  hb_position_t ascender = 0;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    *first_x /= 2;
+
+    int y;
+    if (_hb_ot_get_glyph_v_origin_y (font, ot_font, VORG, *first_glyph, &y))
+      *first_y = font->em_scale_y (y);
+    else
+    {
+      if (!have_ascender)
+      {
+	hb_font_extents_t font_extents;
+	font->get_h_extents_with_fallback (&font_extents);
+	ascender = font_extents.ascender;
+	have_ascender = true;
+      }
+      *first_y = ascender;
+    }
+
+    first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+    first_x = &StructAtOffsetUnaligned<hb_position_t> (first_x, x_stride);
+    first_y = &StructAtOffsetUnaligned<hb_position_t> (first_y, y_stride);
+  }
+
+  return true;
 }
 
 static hb_bool_t
@@ -143,32 +569,77 @@ hb_ot_get_glyph_v_origin (hb_font_t *font,
 			  hb_codepoint_t glyph,
 			  hb_position_t *x,
 			  hb_position_t *y,
-			  void *user_data HB_UNUSED)
+			  void *user_data)
 {
-  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
+  return hb_ot_get_glyph_v_origins (font, font_data, 1, &glyph, 0, x, 0, y, 0, user_data);
+}
 
-  *x = font->get_glyph_h_advance (glyph) / 2;
+static void
+scale_glyph_extents (hb_font_t *font, hb_glyph_extents_t *extents)
+{
+  // TODO Hook up side-bearings variations.
+  extents->x_bearing = font->em_scale_x (extents->x_bearing);
+  extents->y_bearing = font->em_scale_y (extents->y_bearing);
+  extents->width     = font->em_scale_x (extents->width);
+  extents->height    = font->em_scale_y (extents->height);
+}
 
-  const OT::VORG &VORG = *ot_face->VORG;
-  if (VORG.has_data ())
-  {
-    *y = font->em_scale_y (VORG.get_y_origin (glyph));
-    return true;
-  }
+/* The tables glyph extents come from, fetched once per call. */
+struct hb_ot_extents_tables_t
+{
+  hb_ot_extents_tables_t (const hb_ot_face_t *ot_face) :
+    sbix (*ot_face->sbix),
+    glyf (*ot_face->glyf)
+#if !defined(HB_NO_OT_FONT_CFF)
+    , cff1 (*ot_face->cff1)
+    , cff2 (*ot_face->cff2)
+#endif
+#if !defined(HB_NO_OT_FONT_BITMAP)
+    , CBDT (*ot_face->CBDT)
+#endif
+  {}
 
-  hb_glyph_extents_t extents = {0};
-  if (ot_face->glyf->get_extents (glyph, &extents))
+  bool get_extents (hb_font_t *font, hb_codepoint_t glyph, hb_glyph_extents_t *extents) const
   {
-    const OT::vmtx_accelerator_t &vmtx = *ot_face->vmtx;
-    hb_position_t tsb = vmtx.get_side_bearing (glyph);
-    *y = font->em_scale_y (extents.y_bearing + tsb);
-    return true;
+    bool ret = sbix.get_extents (font, glyph, extents);
+    if (!ret)
+      ret = glyf.get_extents (font, glyph, extents);
+#if !defined(HB_NO_OT_FONT_CFF)
+    if (!ret)
+      ret = cff1.get_extents (glyph, extents);
+    if (!ret)
+      ret = cff2.get_extents (font, glyph, extents);
+#endif
+#if !defined(HB_NO_OT_FONT_BITMAP)
+    if (!ret)
+      ret = CBDT.get_extents (font, glyph, extents);
+#endif
+    return ret;
   }
 
-  hb_font_extents_t font_extents;
-  font->get_h_extents_with_fallback (&font_extents);
-  *y = font_extents.ascender;
+  const OT::sbix_accelerator_t &sbix;
+  const OT::glyf_accelerator_t &glyf;
+#if !defined(HB_NO_OT_FONT_CFF)
+  const OT::cff1_accelerator_t &cff1;
+  const OT::cff2_accelerator_t &cff2;
+#endif
+#if !defined(HB_NO_OT_FONT_BITMAP)
+  const OT::CBDT_accelerator_t &CBDT;
+#endif
+};
 
+/* Bitmap and variable extents depend on the font's ppem and coordinates;
+ * start over whenever the font changed.  Returns whether to use the cache. */
+static bool
+_hb_ot_font_validate_extents_cache (hb_font_t *font, const hb_ot_font_t *ot_font)
+{
+  if (!ot_font->extents_cache.get_size ())
+    return false;
+  if (unlikely ((unsigned int) ot_font->extents_serial.get_relaxed () != font->serial))
+  {
+    ot_font->extents_cache.clear ();
+    ot_font->extents_serial.set_relaxed (font->serial);
+  }
   return true;
 }
 
@@ -179,25 +650,50 @@ hb_ot_get_glyph_extents (hb_font_t *font,
 			 hb_glyph_extents_t *extents,
 			 void *user_data HB_UNUSED)
 {
-  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
-  bool ret = ot_face->sbix->get_extents (font, glyph, extents);
-  if (!ret)
-    ret = ot_face->glyf->get_extents (glyph, extents);
-#if !defined(HB_NO_OT_FONT_CFF)
-  if (!ret)
-    ret = ot_face->cff1->get_extents (glyph, extents);
-  if (!ret)
-    ret = ot_face->cff2->get_extents (font, glyph, extents);
-#endif
-#if !defined(HB_NO_OT_FONT_BITMAP)
-  if (!ret)
-    ret = ot_face->CBDT->get_extents (font, glyph, extents);
-#endif
-  // TODO Hook up side-bearings variations.
-  extents->x_bearing = font->em_scale_x (extents->x_bearing);
-  extents->y_bearing = font->em_scale_y (extents->y_bearing);
-  extents->width     = font->em_scale_x (extents->width);
-  extents->height    = font->em_scale_y (extents->height);
+  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
+  bool use_cache = _hb_ot_font_validate_extents_cache (font, ot_font);
+  if (use_cache && ot_font->extents_cache.get (glyph, extents))
+  {
+    scale_glyph_extents (font, extents);
+    return true;
+  }
+
+  bool ret = hb_ot_extents_tables_t (ot_font->ot_face).get_extents (font, glyph, extents);
+  if (ret && use_cache)
+    ot_font->extents_cache.set (glyph, *extents);
+  scale_glyph_extents (font, extents);
+  return ret;
+}
+
+static unsigned int
+hb_ot_get_glyph_extents_array (hb_font_t *font,
+			       void *font_data,
+			       unsigned int count,
+			       const hb_codepoint_t *first_glyph,
+			       unsigned int glyph_stride,
+			       hb_glyph_extents_t *first_extents,
+			       unsigned int extents_stride,
+			       void *user_data HB_UNUSED)
+{
+  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
+  bool use_cache = _hb_ot_font_validate_extents_cache (font, ot_font);
+  hb_ot_extents_tables_t tables (ot_font->ot_face);
+
+  unsigned int ret = 0;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    if (use_cache && ot_font->extents_cache.get (*first_glyph, first_extents))
+      ret++;
+    else if (tables.get_extents (font, *first_glyph, first_extents))
+    {
+      if (use_cache)
+	ot_font->extents_cache.set (*first_glyph, *first_extents);
+      ret++;
+    }
+    scale_glyph_extents (font, first_extents);
+    first_glyph = &StructAtOffsetUnaligned<hb_codepoint_t> (first_glyph, glyph_stride);
+    first_extents = &StructAtOffsetUnaligned<hb_glyph_extents_t> (first_extents, extents_stride);
+  }
   return ret;
 }
 
@@ -208,8 +704,12 @@ hb_ot_get_glyph_name (hb_font_t *font HB_UNUSED,
                       char *name, unsigned int size,
                       void *user_data HB_UNUSED)
 {
-  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
-  return ot_face->post->get_glyph_name (glyph, name, size);
+  const hb_ot_face_t *ot_face = ((const hb_ot_font_t *) font_data)->ot_face;
+  if (ot_face->post->get_glyph_name (glyph, name, size)) return true;
+#if !defined(HB_NO_OT_FONT_CFF)
+  if (ot_face->cff1->get_glyph_name (glyph, name, size)) return true;
+#endif
+  return false;
 }
 
 static hb_bool_t
@@ -219,8 +719,12 @@ hb_ot_get_glyph_from_name (hb_font_t *font HB_UNUSED,
                            hb_codepoint_t *glyph,
                            void *user_data HB_UNUSED)
 {
-  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
-  return ot_face->post->get_glyph_from_name (name, len, glyph);
+  const hb_ot_face_t *ot_face = ((const hb_ot_font_t *) font_data)->ot_face;
+  if (ot_face->post->get_glyph_from_name (name, len, glyph)) return true;
+#if !defined(HB_NO_OT_FONT_CFF)
+  if (ot_face->cff1->get_glyph_from_name (name, len, glyph)) return true;
+#endif
+  return false;
 }
 
 static hb_bool_t
@@ -229,12 +733,24 @@ hb_ot_get_font_h_extents (hb_font_t *font,
 			  hb_font_extents_t *metrics,
 			  void *user_data HB_UNUSED)
 {
-  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
-  const OT::hmtx_accelerator_t &hmtx = *ot_face->hmtx;
-  metrics->ascender = font->em_scale_y (hmtx.ascender);
-  metrics->descender = font->em_scale_y (hmtx.descender);
-  metrics->line_gap = font->em_scale_y (hmtx.line_gap);
-  // TODO Hook up variations.
+  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
+  const OT::hmtx_accelerator_t &hmtx = *ot_font->hmtx;
+  if (!font->num_coords)
+  {
+    metrics->ascender = font->em_scale_y (hmtx.ascender);
+    metrics->descender = font->em_scale_y (hmtx.descender);
+    metrics->line_gap = font->em_scale_y (hmtx.line_gap);
+    return hmtx.has_font_extents;
+  }
+
+  if (!ot_font->h_metrics_cache.get (font, metrics))
+  {
+    const OT::MVAR &mvar = *ot_font->ot_face->MVAR;
+    metrics->ascender = font->em_scalef_y (hmtx.ascender + mvar.get_var (HB_TAG ('h','a','s','c'), font));
+    metrics->descender = font->em_scalef_y (hmtx.descender + mvar.get_var (HB_TAG ('h','d','s','c'), font));
+    metrics->line_gap = font->em_scalef_y (hmtx.line_gap + mvar.get_var (HB_TAG ('h','l','g','p'), font));
+    ot_font->h_metrics_cache.set (font, *metrics);
+  }
   return hmtx.has_font_extents;
 }
 
@@ -244,12 +760,24 @@ hb_ot_get_font_v_extents (hb_font_t *font,
 			  hb_font_extents_t *metrics,
 			  void *user_data HB_UNUSED)
 {
-  const hb_ot_face_t *ot_face = (const hb_ot_face_t *) font_data;
-  const OT::vmtx_accelerator_t &vmtx = *ot_face->vmtx;
-  metrics->ascender = font->em_scale_x (vmtx.ascender);
-  metrics->descender = font->em_scale_x (vmtx.descender);
-  metrics->line_gap = font->em_scale_x (vmtx.line_gap);
-  // TODO Hook up variations.
+  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font_data;
+  const OT::vmtx_accelerator_t &vmtx = *ot_font->ot_face->vmtx;
+  if (!font->num_coords)
+  {
+    metrics->ascender = font->em_scale_x (vmtx.ascender);
+    metrics->descender = font->em_scale_x (vmtx.descender);
+    metrics->line_gap = font->em_scale_x (vmtx.line_gap);
+    return vmtx.has_font_extents;
+  }
+
+  if (!ot_font->v_metrics_cache.get (font, metrics))
+  {
+    const OT::MVAR &mvar = *ot_font->ot_face->MVAR;
+    metrics->ascender = font->em_scalef_x (vmtx.ascender + mvar.get_var (HB_TAG ('v','a','s','c'), font));
+    metrics->descender = font->em_scalef_x (vmtx.descender + mvar.get_var (HB_TAG ('v','d','s','c'), font));
+    metrics->line_gap = font->em_scalef_x (vmtx.line_gap + mvar.get_var (HB_TAG ('v','l','g','p'), font));
+    ot_font->v_metrics_cache.set (font, *metrics);
+  }
   return vmtx.has_font_extents;
 }
 
@@ -272,7 +800,9 @@ static struct hb_ot_font_funcs_lazy_loader_t : hb_font_funcs_lazy_loader_t<hb_ot
     hb_font_funcs_set_glyph_v_advances_func (funcs, hb_ot_get_glyph_v_advances, nullptr, nullptr);
     //hb_font_funcs_set_glyph_h_origin_func (funcs, hb_ot_get_glyph_h_origin, nullptr, nullptr);
     hb_font_funcs_set_glyph_v_origin_func (funcs, hb_ot_get_glyph_v_origin, nullptr, nullptr);
+    hb_font_funcs_set_glyph_v_origins_func (funcs, hb_ot_get_glyph_v_origins, nullptr, nullptr);
     hb_font_funcs_set_glyph_extents_func (funcs, hb_ot_get_glyph_extents, nullptr, nullptr);
+    hb_font_funcs_set_glyph_extents_array_func (funcs, hb_ot_get_glyph_extents_array, nullptr, nullptr);
     //hb_font_funcs_set_glyph_contour_point_func (funcs, hb_ot_get_glyph_contour_point, nullptr, nullptr);
     hb_font_funcs_set_glyph_name_func (funcs, hb_ot_get_glyph_name, nullptr, nullptr);
     hb_font_funcs_set_glyph_from_name_func (funcs, hb_ot_get_glyph_from_name, nullptr, nullptr);
@@ -310,8 +840,87 @@ _hb_ot_get_font_funcs ()
 void
 hb_ot_font_set_funcs (hb_font_t *font)
 {
+  if (hb_object_is_immutable (font))
+    return;
+
+  hb_ot_font_t *ot_font = _hb_ot_font_create (font);
+  if (unlikely (!ot_font))
+    return;
+
   hb_font_set_funcs (font,
 		     _hb_ot_get_font_funcs (),
-		     &font->face->table,
-		     nullptr);
+		     ot_font,
+		     _hb_ot_font_destroy);
+  font->ot_font = ot_font;
+}
+
+/**
+ * hb_ot_font_set_cache_sizes:
+ * @font: a font using the OpenType font functions.
+ * @cmap_cache_size: number of entries in the character-to-glyph cache.
+ * @advance_cache_size: number of entries in the glyph-advance cache.
+ *
+ * Resizes the per-font lookup caches that hb_ot_font_set_funcs() attaches
+ * to @font.  Sizes are rounded down to a power of two; zero disables the
+ * respective cache.  The defaults (256 entries each) can be changed at
+ * build time by defining HB_OT_FONT_CMAP_CACHE_SIZE and
+ * HB_OT_FONT_ADVANCE_CACHE_SIZE.  Large caches help scripts with big
+ * repertoires, like CJK, where the default cache thrashes.
+ *
+ * This function is not thread-safe: call it before @font is used for
+ * shaping, like other font setters.
+ *
+ * Return value: %true if @font uses the OpenType font functions, unless
+ * it is immutable; %false otherwise.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_ot_font_set_cache_sizes (hb_font_t    *font,
+			    unsigned int  cmap_cache_size,
+			    unsigned int  advance_cache_size)
+{
+  if (hb_object_is_immutable (font) ||
+      font->klass != _hb_ot_get_font_funcs ())
+    return false;
+
+  hb_ot_font_t *ot_font = (hb_ot_font_t *) font->user_data;
+
+  ot_font->cmap_cache.fini ();
+  ot_font->advance_cache.fini ();
+  return ot_font->cmap_cache.init (cmap_cache_size) &&
+	 ot_font->advance_cache.init (advance_cache_size);
+}
+
+unsigned int
+_hb_ot_font_get_memory_usage (const hb_font_t *font)
+{
+  if (font->klass != _hb_ot_get_font_funcs ())
+    return 0;
+
+  const hb_ot_font_t *ot_font = (const hb_ot_font_t *) font->user_data;
+  return sizeof (*ot_font) +
+	 ot_font->cmap_cache.get_size () * sizeof (hb_atomic_int_t) +
+	 ot_font->advance_cache.get_size () * sizeof (hb_atomic_int_t) +
+	 ot_font->v_origin_cache.get_size () * sizeof (hb_atomic_int_t) +
+	 ot_font->extents_cache.get_size () * 4 * sizeof (hb_atomic_int_t);
+}
+
+bool
+_hb_ot_font_has_face_cmap (const hb_font_t *font)
+{
+  /* Sub-fonts that don't override anything ask their parent. */
+  const hb_font_t *face_font = font;
+  while (face_font->klass == hb_font_funcs_get_empty () && face_font->parent)
+    face_font = face_font->parent;
+
+  return face_font->klass == _hb_ot_get_font_funcs () &&
+	 face_font->face == font->face;
+}
+
+
+HB_INTERNAL unsigned int
+_glyf_get_advance_var (hb_font_t *font, hb_codepoint_t glyph, bool vertical)
+{
+  return font->face->table.glyf->get_advance_var (font, glyph, vertical);
 }
@@ -39,6 +39,11 @@ HB_BEGIN_DECLS
 HB_EXTERN void
 hb_ot_font_set_funcs (hb_font_t *font);
 
+HB_EXTERN hb_bool_t
+hb_ot_font_set_cache_sizes (hb_font_t    *font,
+			    unsigned int  cmap_cache_size,
+			    unsigned int  advance_cache_size);
+
 
 HB_END_DECLS
 
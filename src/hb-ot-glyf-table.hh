@@ -29,8 +29,15 @@
 
 #include "hb-open-type.hh"
 #include "hb-ot-head-table.hh"
+#include "hb-ot-hmtx-table.hh"
+#include "hb-ot-var-gvar-table.hh"
 #include "hb-subset-glyf.hh"
 
+#ifndef HB_GLYF_MAX_COMPOSITE_DEPTH
+#define HB_GLYF_MAX_COMPOSITE_DEPTH 10
+#endif
+
+
 namespace OT {
 
 
@@ -171,6 +178,65 @@ struct glyf
       return size;
     }
 
+    bool is_anchored () const { return !(flags & ARGS_ARE_XY_VALUES); }
+
+    /* For anchored components: the matched point in the glyph so far, and
+     * the one in this component. */
+    void get_anchor_points (unsigned int &point1, unsigned int &point2) const
+    {
+      const HBUINT8 *p = &StructAfter<const HBUINT8> (glyphIndex);
+      if (flags & ARG_1_AND_2_ARE_WORDS)
+      {
+	point1 = ((const HBUINT16 *) p)[0];
+	point2 = ((const HBUINT16 *) p)[1];
+      }
+      else
+      {
+	point1 = p[0];
+	point2 = p[1];
+      }
+    }
+
+    /* matrix is {xx, yx, xy, yy}; trans is zero for anchored components. */
+    void get_transformation (float (&matrix)[4], contour_point_t &trans) const
+    {
+      matrix[0] = matrix[3] = 1.f;
+      matrix[1] = matrix[2] = 0.f;
+
+      int tx, ty;
+      const HBINT8 *p = &StructAfter<const HBINT8> (glyphIndex);
+      if (flags & ARG_1_AND_2_ARE_WORDS)
+      {
+	tx = *(const HBINT16 *) p;
+	p += HBINT16::static_size;
+	ty = *(const HBINT16 *) p;
+	p += HBINT16::static_size;
+      }
+      else
+      {
+	tx = *p++;
+	ty = *p++;
+      }
+      if (is_anchored ()) tx = ty = 0;
+      trans.init ((float) tx, (float) ty);
+
+      const F2DOT14 *scales = (const F2DOT14 *) p;
+      if (flags & WE_HAVE_A_SCALE)
+	matrix[0] = matrix[3] = scales[0].to_float ();
+      else if (flags & WE_HAVE_AN_X_AND_Y_SCALE)
+      {
+	matrix[0] = scales[0].to_float ();
+	matrix[3] = scales[1].to_float ();
+      }
+      else if (flags & WE_HAVE_A_TWO_BY_TWO)
+      {
+	matrix[0] = scales[0].to_float ();
+	matrix[1] = scales[1].to_float ();
+	matrix[2] = scales[2].to_float ();
+	matrix[3] = scales[3].to_float ();
+      }
+    }
+
     struct Iterator
     {
       const char *glyph_start;
@@ -228,9 +294,10 @@ struct glyf
 
   struct accelerator_t
   {
-    void init (hb_face_t *face)
+    void init (hb_face_t *face_)
     {
       memset (this, 0, sizeof (accelerator_t));
+      face = face_;
 
       const OT::head &head = *face->table.head;
       if (head.indexToLocFormat > 1 || head.glyphDataFormat != 0)
@@ -250,6 +317,12 @@ struct glyf
       glyf_table.destroy ();
     }
 
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (loca_table);
+      usage->add_blob (glyf_table);
+    }
+
     /*
      * Returns true if the referenced glyph is a valid glyph and a composite glyph.
      * If true is returned a pointer to the composite glyph will be written into
@@ -440,12 +513,42 @@ struct glyf
       return true;
     }
 
-    bool get_extents (hb_codepoint_t glyph, hb_glyph_extents_t *extents) const
+    bool get_extents (hb_font_t *font, hb_codepoint_t glyph, hb_glyph_extents_t *extents) const
     {
       unsigned int start_offset, end_offset;
       if (!get_offsets (glyph, &start_offset, &end_offset))
 	return false;
 
+      if (font->num_coords && face->table.gvar->has_data ())
+      {
+	hb_vector_t<contour_point_t> points;
+	if (likely (get_points_var (font, glyph, points)))
+	{
+	  *extents = {0};
+	  unsigned int count = points.length - PHANTOM_COUNT;
+	  if (!count)
+	    return true; /* Empty glyph; zero extents. */
+
+	  float x_min = points[0].x, x_max = points[0].x;
+	  float y_min = points[0].y, y_max = points[0].y;
+	  for (unsigned int i = 1; i < count; i++)
+	  {
+	    x_min = hb_min (x_min, points[i].x);
+	    x_max = hb_max (x_max, points[i].x);
+	    y_min = hb_min (y_min, points[i].y);
+	    y_max = hb_max (y_max, points[i].y);
+	  }
+	  /* Like rasterizers, put the origin at the left phantom point, which
+	   * is where the side bearing from hmtx says it is. */
+	  float origin = points[count + PHANTOM_LEFT].x;
+	  extents->x_bearing = round_half_up (x_min - origin);
+	  extents->y_bearing = round_half_up (y_max);
+	  extents->width     = round_half_up (x_max - origin) - extents->x_bearing;
+	  extents->height    = round_half_up (y_min) - extents->y_bearing;
+	  return true;
+	}
+      }
+
       if (end_offset - start_offset < GlyphHeader::static_size)
 	return true; /* Empty glyph; zero extents. */
 
@@ -459,7 +562,276 @@ struct glyf
       return true;
     }
 
+    /* Advance from the varied phantom points, for fonts without HVAR/VVAR. */
+    unsigned int get_advance_var (hb_font_t *font, hb_codepoint_t glyph, bool vertical) const
+    {
+      hb_vector_t<contour_point_t> points;
+      if (!font->num_coords ||
+	  !face->table.gvar->has_data () ||
+	  unlikely (!get_points_var (font, glyph, points, true)))
+	return vertical ? face->table.vmtx->get_advance (glyph) : face->table.hmtx->get_advance (glyph);
+
+      const contour_point_t *phantoms = &points[points.length - PHANTOM_COUNT];
+      float advance = vertical ?
+		      phantoms[PHANTOM_TOP].y - phantoms[PHANTOM_BOTTOM].y :
+		      phantoms[PHANTOM_RIGHT].x - phantoms[PHANTOM_LEFT].x;
+      return advance > 0.f ? round_half_up (advance) : 0;
+    }
+
+    private:
+    /* Four extra points after the outline carry the glyph's metrics, so
+     * that gvar can vary them like any other point. */
+    enum phantom_point_index_t
+    {
+      PHANTOM_LEFT   = 0,
+      PHANTOM_RIGHT  = 1,
+      PHANTOM_TOP    = 2,
+      PHANTOM_BOTTOM = 3,
+      PHANTOM_COUNT  = 4
+    };
+
+    /* Rounds like rasterizers round varied points. */
+    static int round_half_up (float v) { return (int) floorf (v + .5f); }
+
+    void init_phantom_points (hb_codepoint_t glyph,
+			      const GlyphHeader &header,
+			      contour_point_t *phantoms) const
+    {
+      int h_delta = (int) header.xMin - (int) face->table.hmtx->get_side_bearing (glyph);
+      int v_orig  = (int) header.yMax + (int) face->table.vmtx->get_side_bearing (glyph);
+      int h_adv = face->table.hmtx->get_advance (glyph);
+      int v_adv = face->table.vmtx->get_advance (glyph);
+
+      for (unsigned int i = 0; i < PHANTOM_COUNT; i++)
+	phantoms[i].init ();
+      phantoms[PHANTOM_LEFT].x = h_delta;
+      phantoms[PHANTOM_RIGHT].x = h_delta + h_adv;
+      phantoms[PHANTOM_TOP].y = v_orig;
+      phantoms[PHANTOM_BOTTOM].y = v_orig - v_adv;
+    }
+
+    /* Decodes the points of a simple glyph and the last point of each of
+     * its contours.  With count_only, points are left zero. */
+    static bool get_simple_points (const char *glyph, const char *glyph_end,
+				   unsigned int num_contours,
+				   hb_vector_t<contour_point_t> &points /* OUT */,
+				   hb_vector_t<unsigned int> &end_points /* OUT */,
+				   bool count_only)
+    {
+      const HBUINT16 *end_pts = &StructAtOffset<HBUINT16> (glyph, GlyphHeader::static_size);
+      const char *p = (const char *) (end_pts + num_contours);
+      if (unlikely (p + 2 > glyph_end))
+	return false;
+
+      unsigned int num_points = num_contours ? end_pts[num_contours - 1] + 1 : 0;
+      if (unlikely (!points.resize (num_points)))
+	return false;
+      for (unsigned int i = 0; i < num_points; i++)
+	points[i].init ();
+      if (count_only)
+	return true;
+
+      if (unlikely (!end_points.resize (num_contours)))
+	return false;
+      for (unsigned int i = 0; i < num_contours; i++)
+      {
+	end_points[i] = end_pts[i];
+	if (unlikely (end_points[i] >= num_points || (i && end_points[i] < end_points[i - 1])))
+	  return false;
+      }
+
+      p += 2 + (uint16_t) StructAtOffset<HBUINT16> (p, 0);
+
+      hb_vector_t<uint8_t> flags;
+      if (unlikely (!flags.resize (num_points)))
+	return false;
+      for (unsigned int i = 0; i < num_points;)
+      {
+	if (unlikely (p + 1 > glyph_end))
+	  return false;
+	uint8_t flag = *p++;
+	flags[i++] = flag;
+	if (flag & FLAG_REPEAT)
+	{
+	  if (unlikely (p + 1 > glyph_end))
+	    return false;
+	  unsigned int repeat = (uint8_t) *p++;
+	  for (; repeat && i < num_points; repeat--)
+	    flags[i++] = flag;
+	}
+      }
+
+      if (unlikely (!read_coordinates (p, glyph_end, flags, points, true, FLAG_X_SHORT, FLAG_X_SAME) ||
+		    !read_coordinates (p, glyph_end, flags, points, false, FLAG_Y_SHORT, FLAG_Y_SAME)))
+	return false;
+
+      return true;
+    }
+
+    static bool read_coordinates (const char *&p, const char *glyph_end,
+				  const hb_vector_t<uint8_t> &flags,
+				  hb_vector_t<contour_point_t> &points /* IN/OUT */,
+				  bool is_x, uint8_t short_flag, uint8_t same_flag)
+    {
+      int v = 0;
+      for (unsigned int i = 0; i < points.length; i++)
+      {
+	uint8_t flag = flags[i];
+	if (flag & short_flag)
+	{
+	  if (unlikely (p + 1 > glyph_end))
+	    return false;
+	  if (flag & same_flag)
+	    v += (uint8_t) *p++;
+	  else
+	    v -= (uint8_t) *p++;
+	}
+	else if (!(flag & same_flag))
+	{
+	  if (unlikely (p + 2 > glyph_end))
+	    return false;
+	  v += (int16_t) StructAtOffset<HBINT16> (p, 0);
+	  p += 2;
+	}
+	if (is_x)
+	  points[i].x = v;
+	else
+	  points[i].y = v;
+      }
+      return true;
+    }
+
+    /* Outline points of glyph at font's variation coordinates, with
+     * components resolved, followed by its PHANTOM_COUNT phantom points.
+     * With phantom_only, only the phantom points are meaningful. */
+    bool get_points_var (hb_font_t *font, hb_codepoint_t glyph,
+			 hb_vector_t<contour_point_t> &points /* OUT */,
+			 bool phantom_only = false,
+			 unsigned int depth = 0) const
+    {
+      if (unlikely (depth > HB_GLYF_MAX_COMPOSITE_DEPTH))
+	return false;
+
+      unsigned int start_offset, end_offset;
+      if (unlikely (!get_offsets (glyph, &start_offset, &end_offset)))
+	return false;
+
+      const char *glyph_data = (const char *) glyf_table->dataZ.arrayZ + start_offset;
+      const char *glyph_end = glyph_data + (end_offset - start_offset);
+      const GlyphHeader &header = end_offset - start_offset < GlyphHeader::static_size ?
+				  Null (GlyphHeader) :
+				  StructAtOffset<GlyphHeader> (glyph_data, 0);
+
+      hb_vector_t<unsigned int> end_points;
+      CompositeGlyphHeader::Iterator composite;
+      bool is_composite = header.numberOfContours < 0;
+      if (is_composite)
+      {
+	/* One point per component, holding its offset. */
+	if (unlikely (!CompositeGlyphHeader::get_iterator (glyph_data, glyph_end - glyph_data, &composite)))
+	  return false;
+	CompositeGlyphHeader::Iterator it = composite;
+	points.resize (0);
+	do
+	{
+	  float matrix[4];
+	  contour_point_t *p = points.push ();
+	  it.current->get_transformation (matrix, *p);
+	}
+	while (it.move_to_next ());
+	if (unlikely (points.in_error ()))
+	  return false;
+      }
+      else if (header.numberOfContours > 0)
+      {
+	if (unlikely (!get_simple_points (glyph_data, glyph_end, header.numberOfContours,
+					  points, end_points, phantom_only)))
+	  return false;
+      }
+      else
+	points.resize (0);
+
+      unsigned int num_points = points.length;
+      if (unlikely (!points.resize (num_points + PHANTOM_COUNT)))
+	return false;
+      init_phantom_points (glyph, header, &points[num_points]);
+
+      if (unlikely (!face->table.gvar->apply_deltas_to_points (glyph, font, points.as_array (),
+							       end_points.as_array ())))
+	return false;
+
+      if (!is_composite)
+	return true;
+
+      /* Resolve the components, now that their offsets are varied. */
+      hb_vector_t<contour_point_t> all_points;
+      contour_point_t phantoms[PHANTOM_COUNT];
+      for (unsigned int i = 0; i < PHANTOM_COUNT; i++)
+	phantoms[i] = points[num_points + i];
+
+      unsigned int component = 0;
+      do
+      {
+	const CompositeGlyphHeader &comp = *composite.current;
+	contour_point_t offset = points[component++];
+	if (phantom_only && !(comp.flags & CompositeGlyphHeader::USE_MY_METRICS))
+	  continue;
+
+	hb_vector_t<contour_point_t> comp_points;
+	if (unlikely (!get_points_var (font, comp.glyphIndex, comp_points, phantom_only, depth + 1)))
+	  return false;
+
+	float matrix[4];
+	contour_point_t unused;
+	comp.get_transformation (matrix, unused);
+	for (unsigned int i = 0; i < comp_points.length; i++)
+	{
+	  float x = comp_points[i].x, y = comp_points[i].y;
+	  comp_points[i].x = matrix[0] * x + matrix[2] * y;
+	  comp_points[i].y = matrix[1] * x + matrix[3] * y;
+	}
+
+	unsigned int comp_count = comp_points.length - PHANTOM_COUNT;
+	if (comp.is_anchored ())
+	{
+	  unsigned int point1, point2;
+	  comp.get_anchor_points (point1, point2);
+	  if (!phantom_only && point1 < all_points.length && point2 < comp_count)
+	    offset.init (all_points[point1].x - comp_points[point2].x,
+			 all_points[point1].y - comp_points[point2].y);
+	  else
+	    offset.init ();
+	}
+	else if ((comp.flags & CompositeGlyphHeader::SCALED_COMPONENT_OFFSET) &&
+		 !(comp.flags & CompositeGlyphHeader::UNSCALED_COMPONENT_OFFSET))
+	{
+	  float x = offset.x, y = offset.y;
+	  offset.init (matrix[0] * x + matrix[2] * y,
+		       matrix[1] * x + matrix[3] * y);
+	}
+	for (unsigned int i = 0; i < comp_points.length; i++)
+	  comp_points[i].translate (offset);
+
+	if (comp.flags & CompositeGlyphHeader::USE_MY_METRICS)
+	  for (unsigned int i = 0; i < PHANTOM_COUNT; i++)
+	    phantoms[i] = comp_points[comp_count + i];
+
+	if (!phantom_only)
+	  for (unsigned int i = 0; i < comp_count; i++)
+	    all_points.push (comp_points[i]);
+      }
+      while (composite.move_to_next ());
+
+      for (unsigned int i = 0; i < PHANTOM_COUNT; i++)
+	all_points.push (phantoms[i]);
+      if (unlikely (all_points.in_error ()))
+	return false;
+      points = hb_move (all_points);
+      return true;
+    }
+
     private:
+    hb_face_t *face;
     bool short_offset;
     unsigned int num_glyphs;
     hb_blob_ptr_t<loca> loca_table;
@@ -124,6 +124,19 @@ struct hdmx
     hdmx *hdmx_prime = c->serializer->start_embed <hdmx> ();
     if (unlikely (!hdmx_prime)) return_trace (false);
 
+    /* Resolve the old glyph of each new one once, rather than for every
+     * device record; the rows are then plain gathers.  Dropped glyphs
+     * get an old gid past the widths, so they read as zero. */
+    unsigned num_glyphs = get_num_glyphs ();
+    hb_vector_t<unsigned> old_gids;
+    if (unlikely (!old_gids.resize (c->plan->num_output_glyphs ()))) return_trace (false);
+    for (unsigned new_gid = 0; new_gid < old_gids.length; new_gid++)
+    {
+      hb_codepoint_t old_gid = c->plan->reverse_glyph_map->get (new_gid);
+      old_gids[new_gid] = old_gid == HB_MAP_VALUE_INVALID || c->plan->is_empty_glyph (old_gid)
+			? num_glyphs : old_gid;
+    }
+
     auto it =
     + hb_iota ((unsigned) numRecords)
     | hb_map ([&] (unsigned _)
@@ -131,15 +144,11 @@ struct hdmx
 	  const DeviceRecord *device_record =
 	    &StructAtOffset<DeviceRecord> (&firstDeviceRecord,
 					   _ * sizeDeviceRecord);
+	  const HBUINT8 *widths = device_record->widthsZ.arrayZ;
 	  auto row =
-	    + hb_iota (c->plan->num_output_glyphs ())
-	    | hb_map (c->plan->reverse_glyph_map)
-	    | hb_map ([=] (hb_codepoint_t _)
-		      {
-			if (c->plan->is_empty_glyph (_))
-			  return Null(HBUINT8);
-			return device_record->widthsZ.as_array (get_num_glyphs ()) [_];
-		      })
+	    + hb_iter (old_gids)
+	    | hb_map ([=] (unsigned old_gid) -> uint8_t
+		      { return old_gid < num_glyphs ? (uint8_t) widths[old_gid] : 0; })
 	    ;
 	  return hb_pair ((unsigned) device_record->pixelSize, +row);
 	})
@@ -42,6 +42,10 @@
 #define HB_OT_TAG_vmtx HB_TAG('v','m','t','x')
 
 
+HB_INTERNAL unsigned int
+_glyf_get_advance_var (hb_font_t *font, hb_codepoint_t glyph, bool vertical);
+
+
 namespace OT {
 
 
@@ -214,6 +218,12 @@ struct hmtxvmtx
       var_table.destroy ();
     }
 
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (table);
+      usage->add_blob (var_table);
+    }
+
     /* TODO Add variations version. */
     unsigned int get_side_bearing (hb_codepoint_t glyph) const
     {
@@ -243,17 +253,34 @@ struct hmtxvmtx
       return table->longMetricZ[hb_min (glyph, (uint32_t) num_advances - 1)].advance;
     }
 
+    /* var_cache, if not null, is from create_var_cache() and holds the
+     * region scalars for font's coords; it is only used if the font has
+     * no scalars of its own for the variation store. */
     unsigned int get_advance (hb_codepoint_t  glyph,
-			      hb_font_t      *font) const
+			      hb_font_t      *font,
+			      float          *var_cache = nullptr) const
     {
       unsigned int advance = get_advance (glyph);
-      if (likely (glyph < num_metrics))
-      {
-	advance += (font->num_coords ? var_table->get_advance_var (glyph, font->coords, font->num_coords) : 0); // TODO Optimize?!
-      }
-      return advance;
+      if (unlikely (glyph >= num_metrics) || !font->num_coords)
+	return advance;
+
+      if (var_table.get_length ())
+	return advance + var_table->get_advance_var (glyph, font, var_cache);
+
+      return _glyf_get_advance_var (font, glyph, T::tableTag == HB_OT_TAG_vmtx);
+    }
+
+    /* Whether get_advance() on font would use a var_cache. */
+    bool wants_var_cache (hb_font_t *font) const
+    {
+      return font->num_coords &&
+	     var_table.get_length () &&
+	     !var_table->has_font_scalars (font);
     }
 
+    float *create_var_cache () const { return var_table->create_cache (); }
+    void reset_var_cache (float *cache) const { var_table->reset_cache (cache); }
+
     unsigned int num_advances_for_subset (const hb_subset_plan_t *plan) const
     {
       unsigned int num_advances = plan->num_output_glyphs ();
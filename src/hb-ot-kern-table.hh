@@ -37,6 +37,15 @@
  */
 #define HB_OT_TAG_kern HB_TAG('k','e','r','n')
 
+/* Format 0 pairs hashed per face, across subtables; the maps take roughly
+ * 32 bytes per pair. */
+#ifndef HB_KERN_MAX_HASHED_PAIRS
+#define HB_KERN_MAX_HASHED_PAIRS 65536
+#endif
+#ifndef HB_KERN_MAX_PAIR_MAPS
+#define HB_KERN_MAX_PAIR_MAPS 8
+#endif
+
 
 namespace OT {
 
@@ -304,6 +313,50 @@ struct kern
   bool apply (AAT::hb_aat_apply_context_t *c) const
   { return dispatch (c); }
 
+  struct accelerator_t
+  {
+    void init (hb_face_t *face)
+    {
+      this->table = hb_sanitize_context_t().reference_table<kern> (face);
+
+      /* Format 0 subtables of old TrueType fonts can have tens of thousands
+       * of pairs; hash them so that kerning does not binary-search the
+       * pair list for every glyph pair. */
+      this->num_pair_maps = HB_KERN_MAX_PAIR_MAPS;
+      this->pair_maps = (AAT::pair_map_t *) calloc (this->num_pair_maps, sizeof (AAT::pair_map_t));
+      if (unlikely (!this->pair_maps))
+	this->num_pair_maps = 0;
+      for (unsigned int i = 0; i < this->num_pair_maps; i++)
+	this->pair_maps[i].init ();
+
+      switch (table->get_type ()) {
+      case 0: table->u.ot.collect_pair_maps (pair_maps, num_pair_maps, HB_KERN_MAX_HASHED_PAIRS); break;
+      case 1: table->u.aat.collect_pair_maps (pair_maps, num_pair_maps, HB_KERN_MAX_HASHED_PAIRS); break;
+      default: break;
+      }
+    }
+
+    void fini ()
+    {
+      for (unsigned int i = 0; i < this->num_pair_maps; i++)
+	this->pair_maps[i].fini ();
+      free (this->pair_maps);
+      this->table.destroy ();
+    }
+
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (this->table);
+      usage->heap += this->num_pair_maps * sizeof (AAT::pair_map_t);
+      for (unsigned int i = 0; i < this->num_pair_maps; i++)
+	usage->heap += this->pair_maps[i].get_heap_size ();
+    }
+
+    hb_blob_ptr_t<kern> table;
+    unsigned int num_pair_maps;
+    AAT::pair_map_t *pair_maps;
+  };
+
   template <typename context_t, typename ...Ts>
   typename context_t::return_t dispatch (context_t *c, Ts&&... ds) const
   {
@@ -334,6 +387,8 @@ struct kern
   DEFINE_SIZE_UNION (4, version32);
 };
 
+struct kern_accelerator_t : kern::accelerator_t {};
+
 } /* namespace OT */
 
 
@@ -1029,6 +1029,10 @@ struct Coverage
     }
   }
 
+  /* The sorted glyphs of a format 1 coverage; nullptr for other formats. */
+  const SortedArrayOf<GlyphID> *get_glyph_array () const
+  { return u.format == 1 ? &u.format1.glyphArray : nullptr; }
+
   template <typename Iterator,
 	    hb_requires (hb_is_sorted_iterator_of (Iterator, const GlyphID))>
   bool serialize (hb_serialize_context_t *c, Iterator glyphs)
@@ -1220,7 +1224,7 @@ struct ClassDefFormat1
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_glyph_map_t &glyph_map = *c->plan->glyph_map;
     hb_sorted_vector_t<GlyphID> glyphs;
     hb_vector_t<HBUINT16> klasses;
 
@@ -1369,7 +1373,7 @@ struct ClassDefFormat2
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_glyph_map_t &glyph_map = *c->plan->glyph_map;
     hb_vector_t<GlyphID> glyphs;
     hb_vector_t<HBUINT16> klasses;
 
@@ -1641,14 +1645,30 @@ struct VarRegionAxis
   DEFINE_SIZE_STATIC (6);
 };
 
+/* Region scalars are in [0, 1]. */
+#define VAR_REGION_CACHE_INVALID 2.f
+
 struct VarRegionList
 {
+  /* If cache is not null, it holds one scalar per region for the
+   * same coords, or VAR_REGION_CACHE_INVALID where not computed yet.
+   * Complete caches, such as the font's from
+   * VariationStore::get_font_scalars(), are only read. */
   float evaluate (unsigned int region_index,
-			 const int *coords, unsigned int coord_len) const
+		  const int *coords, unsigned int coord_len,
+		  float *cache = nullptr) const
   {
     if (unlikely (region_index >= regionCount))
       return 0.;
 
+    float *cached_value = nullptr;
+    if (cache)
+    {
+      cached_value = &cache[region_index];
+      if (likely (*cached_value != VAR_REGION_CACHE_INVALID))
+	return *cached_value;
+    }
+
     const VarRegionAxis *axes = axesZ.arrayZ + (region_index * axisCount);
 
     float v = 1.;
@@ -1658,9 +1678,15 @@ struct VarRegionList
       int coord = i < coord_len ? coords[i] : 0;
       float factor = axes[i].evaluate (coord);
       if (factor == 0.f)
-	return 0.;
+      {
+	v = 0.;
+	break;
+      }
       v *= factor;
     }
+
+    if (cached_value)
+      *cached_value = v;
     return v;
   }
 
@@ -1695,7 +1721,8 @@ struct VarData
 
   float get_delta (unsigned int inner,
 			  const int *coords, unsigned int coord_count,
-			  const VarRegionList &regions) const
+			  const VarRegionList &regions,
+			  float *cache = nullptr) const
   {
     if (unlikely (inner >= itemCount))
       return 0.;
@@ -1712,13 +1739,13 @@ struct VarData
    const HBINT16 *scursor = reinterpret_cast<const HBINT16 *> (row);
    for (; i < scount; i++)
    {
-     float scalar = regions.evaluate (regionIndices.arrayZ[i], coords, coord_count);
+     float scalar = regions.evaluate (regionIndices.arrayZ[i], coords, coord_count, cache);
      delta += scalar * *scursor++;
    }
    const HBINT8 *bcursor = reinterpret_cast<const HBINT8 *> (scursor);
    for (; i < count; i++)
    {
-     float scalar = regions.evaluate (regionIndices.arrayZ[i], coords, coord_count);
+     float scalar = regions.evaluate (regionIndices.arrayZ[i], coords, coord_count, cache);
      delta += scalar * *bcursor++;
    }
 
@@ -1728,12 +1755,13 @@ struct VarData
   void get_scalars (int *coords, unsigned int coord_count,
                     const VarRegionList &regions,
                     float *scalars /*OUT */,
-                    unsigned int num_scalars) const
+                    unsigned int num_scalars,
+                    float *region_cache = nullptr) const
   {
     assert (num_scalars == regionIndices.len);
    for (unsigned int i = 0; i < num_scalars; i++)
    {
-     scalars[i] = regions.evaluate (regionIndices.arrayZ[i], coords, coord_count);
+     scalars[i] = regions.evaluate (regionIndices.arrayZ[i], coords, coord_count, region_cache);
    }
   }
 
@@ -1760,22 +1788,85 @@ struct VarData
 struct VariationStore
 {
   float get_delta (unsigned int outer, unsigned int inner,
-		   const int *coords, unsigned int coord_count) const
+		   const int *coords, unsigned int coord_count,
+		   float *cache = nullptr) const
   {
     if (unlikely (outer >= dataSets.len))
       return 0.;
 
     return (this+dataSets[outer]).get_delta (inner,
 					     coords, coord_count,
-					     this+regions);
+					     this+regions,
+					     cache);
   }
 
   float get_delta (unsigned int index,
-		   const int *coords, unsigned int coord_count) const
+		   const int *coords, unsigned int coord_count,
+		   float *cache = nullptr) const
   {
     unsigned int outer = index >> 16;
     unsigned int inner = index & 0xFFFF;
-    return get_delta (outer, inner, coords, coord_count);
+    return get_delta (outer, inner, coords, coord_count, cache);
+  }
+
+  /* Uses the font's scalars if it has them for this store, else cache,
+   * which must be for font's coords. */
+  float get_delta (unsigned int outer, unsigned int inner, hb_font_t *font,
+		   float *cache = nullptr) const
+  { return get_delta (outer, inner, font->coords, font->num_coords, get_font_cache (font, cache)); }
+
+  float get_delta (unsigned int index, hb_font_t *font,
+		   float *cache = nullptr) const
+  { return get_delta (index, font->coords, font->num_coords, get_font_cache (font, cache)); }
+
+  /* Region scalar cache for get_delta(); must be reset whenever the coords
+   * change.  Returns nullptr if allocation fails or there are no regions. */
+  float *create_cache () const
+  {
+    unsigned int count = (this+regions).get_region_count ();
+    if (!count)
+      return nullptr;
+    float *cache = (float *) malloc (count * sizeof (float));
+    if (likely (cache))
+      reset_cache (cache);
+    return cache;
+  }
+
+  void reset_cache (float *cache) const
+  {
+    if (!cache) return;
+    unsigned int count = (this+regions).get_region_count ();
+    for (unsigned int i = 0; i < count; i++)
+      cache[i] = VAR_REGION_CACHE_INVALID;
+  }
+
+  static void destroy_cache (float *cache) { free (cache); }
+
+  /* Scalars of all regions at font's coords, computed on first use after
+   * the coords change and kept on font.  Returns nullptr if font has no
+   * coords or no room left for this store. */
+  const float *get_font_scalars (hb_font_t *font) const
+  {
+    if (!font->num_coords)
+      return nullptr;
+    const float *scalars = font->get_var_scalars (this);
+    if (likely (scalars) || font->var_scalars_full ())
+      return scalars;
+
+    const VarRegionList &region_list = this+regions;
+    unsigned int count = region_list.get_region_count ();
+    if (!count)
+      return nullptr;
+    hb_font_t::var_scalars_t *entry = (hb_font_t::var_scalars_t *)
+				      malloc (sizeof (*entry) + count * sizeof (float));
+    if (unlikely (!entry))
+      return nullptr;
+    entry->store = this;
+    entry->scalars = (float *) (entry + 1);
+    reset_cache (entry->scalars);
+    for (unsigned int i = 0; i < count; i++)
+      region_list.evaluate (i, font->coords, font->num_coords, entry->scalars);
+    return font->add_var_scalars (entry);
   }
 
   bool sanitize (hb_sanitize_context_t *c) const
@@ -1790,13 +1881,25 @@ struct VariationStore
   unsigned int get_region_index_count (unsigned int ivs) const
   { return (this+dataSets[ivs]).get_region_index_count (); }
 
+  /* If region_scalars is not null, it holds the scalars of all regions
+   * at coords, as from get_font_scalars(), and is only looked up. */
   void get_scalars (unsigned int ivs,
 		    int *coords, unsigned int coord_count,
 		    float *scalars /*OUT*/,
-		    unsigned int num_scalars) const
+		    unsigned int num_scalars,
+		    const float *region_scalars = nullptr) const
   {
     (this+dataSets[ivs]).get_scalars (coords, coord_count, this+regions,
-                                      &scalars[0], num_scalars);
+                                      &scalars[0], num_scalars,
+                                      const_cast<float *> (region_scalars));
+  }
+
+  private:
+  /* The font's scalars are a complete cache, which evaluate() only reads. */
+  float *get_font_cache (hb_font_t *font, float *cache) const
+  {
+    const float *scalars = get_font_scalars (font);
+    return scalars ? const_cast<float *> (scalars) : cache;
   }
 
   protected:
@@ -2107,7 +2210,7 @@ struct VariationDevice
 
   float get_delta (hb_font_t *font, const VariationStore &store) const
   {
-    return store.get_delta (outerIndex, innerIndex, font->coords, font->num_coords);
+    return store.get_delta (outerIndex, innerIndex, font);
   }
 
   protected:
@@ -2156,6 +2259,24 @@ struct Device
     }
   }
 
+  Device* copy (hb_serialize_context_t *c) const
+  {
+    TRACE_SERIALIZE (this);
+    unsigned int size;
+    switch (u.b.format) {
+    case 1: case 2: case 3:
+      size = u.hinting.get_size (); break;
+    case 0x8000:
+      size = VariationDevice::static_size; break;
+    default:
+      return_trace (nullptr);
+    }
+    Device *out = c->allocate_size<Device> (size);
+    if (unlikely (!out)) return_trace (nullptr);
+    memcpy (out, this, size);
+    return_trace (out);
+  }
+
   bool sanitize (hb_sanitize_context_t *c) const
   {
     TRACE_SANITIZE (this);
@@ -339,6 +339,11 @@ struct MarkGlyphSets
  */
 
 
+#ifndef HB_OT_LAYOUT_GDEF_GLYPH_PROPS_MAX_GLYPHS
+/* Fonts with more glyphs than this look glyph props up in GDEF directly. */
+#define HB_OT_LAYOUT_GDEF_GLYPH_PROPS_MAX_GLYPHS 16384
+#endif
+
 struct GDEF
 {
   static constexpr hb_tag_t tableTag = HB_OT_TAG_GDEF;
@@ -422,11 +427,98 @@ struct GDEF
 	hb_blob_destroy (this->table.get_blob ());
 	this->table = hb_blob_get_empty ();
       }
+      num_glyphs = face->get_num_glyphs ();
+      glyph_props.init ();
     }
 
-    void fini () { this->table.destroy (); }
+    void fini ()
+    {
+      uint32_t *props = glyph_props.get_relaxed ();
+      if (props && props != &Null (uint32_t))
+	free (props);
+      this->table.destroy ();
+    }
+
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (this->table);
+      const uint32_t *props = glyph_props.get_relaxed ();
+      if (props && props != &Null (uint32_t))
+	usage->heap += num_glyphs * sizeof (uint32_t);
+    }
+
+    unsigned int get_glyph_props (hb_codepoint_t glyph) const
+    {
+      const uint32_t *props = get_props_array ();
+      if (props && glyph < num_glyphs)
+	return props[glyph] & 0xFFFFu;
+      return table->get_glyph_props (glyph);
+    }
+
+    bool mark_set_covers (unsigned int set_index, hb_codepoint_t glyph) const
+    {
+      const uint32_t *props = get_props_array ();
+      if (props && glyph < num_glyphs && set_index < 16)
+	return (props[glyph] >> (16 + set_index)) & 1;
+      return table->mark_set_covers (set_index, glyph);
+    }
 
     hb_blob_ptr_t<GDEF> table;
+
+    private:
+    /* For fonts with glyph classes and not too many glyphs, a dense array
+     * of glyph props in the low 16 bits, and membership in the first 16
+     * mark glyph sets in the high 16 bits.  Built on first use; Null if
+     * not worth it. */
+    const uint32_t *get_props_array () const
+    {
+    retry:
+      const uint32_t *props = glyph_props.get ();
+      if (likely (props))
+	return props == &Null (uint32_t) ? nullptr : props;
+
+      uint32_t *p = create_props_array ();
+      if (!p)
+	p = const_cast<uint32_t *> (&Null (uint32_t));
+      if (unlikely (!glyph_props.cmpexch (nullptr, p)))
+      {
+	if (p != &Null (uint32_t))
+	  free (p);
+	goto retry;
+      }
+      return p == &Null (uint32_t) ? nullptr : p;
+    }
+
+    uint32_t *create_props_array () const
+    {
+      if (!table->has_glyph_classes () ||
+	  !num_glyphs || num_glyphs > HB_OT_LAYOUT_GDEF_GLYPH_PROPS_MAX_GLYPHS)
+	return nullptr;
+
+      uint32_t *props = (uint32_t *) calloc (num_glyphs, sizeof (props[0]));
+      if (unlikely (!props))
+	return nullptr;
+
+      unsigned int num_sets = table->has_mark_sets () ? 16 : 0;
+      for (unsigned int glyph = 0; glyph < num_glyphs; glyph++)
+      {
+	unsigned int glyph_props = table->get_glyph_props (glyph);
+	if (unlikely (glyph_props > 0xFFFFu))
+	{
+	  free (props);
+	  return nullptr;
+	}
+	props[glyph] = glyph_props;
+	if (glyph_props & HB_OT_LAYOUT_GLYPH_PROPS_MARK)
+	  for (unsigned int i = 0; i < num_sets; i++)
+	    if (table->mark_set_covers (i, glyph))
+	      props[glyph] |= 1u << (16 + i);
+      }
+      return props;
+    }
+
+    unsigned int num_glyphs;
+    mutable hb_atomic_ptr_t<uint32_t> glyph_props;
   };
 
   unsigned int get_size () const
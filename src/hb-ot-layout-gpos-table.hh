@@ -132,30 +132,50 @@ struct ValueFormat : HBUINT16
 
     if (!use_x_device && !use_y_device) return ret;
 
-    const VariationStore &store = c->var_store;
-
     /* pixel -> fractional pixel */
     if (format & xPlaDevice) {
-      if (use_x_device) glyph_pos.x_offset  += (base + get_device (values, &ret)).get_x_delta (font, store);
+      if (use_x_device) glyph_pos.x_offset  += get_device_delta (c, base + get_device (values, &ret), false);
       values++;
     }
     if (format & yPlaDevice) {
-      if (use_y_device) glyph_pos.y_offset  += (base + get_device (values, &ret)).get_y_delta (font, store);
+      if (use_y_device) glyph_pos.y_offset  += get_device_delta (c, base + get_device (values, &ret), true);
       values++;
     }
     if (format & xAdvDevice) {
-      if (horizontal && use_x_device) glyph_pos.x_advance += (base + get_device (values, &ret)).get_x_delta (font, store);
+      if (horizontal && use_x_device) glyph_pos.x_advance += get_device_delta (c, base + get_device (values, &ret), false);
       values++;
     }
     if (format & yAdvDevice) {
       /* y_advance values grow downward but font-space grows upward, hence negation */
-      if (!horizontal && use_y_device) glyph_pos.y_advance -= (base + get_device (values, &ret)).get_y_delta (font, store);
+      if (!horizontal && use_y_device) glyph_pos.y_advance -= get_device_delta (c, base + get_device (values, &ret), true);
       values++;
     }
     return ret;
   }
 
   private:
+  /* The same pairs get kerned over and over, so remember evaluated
+   * deltas on the font instead of decoding the table each time. */
+  static hb_position_t get_device_delta (hb_ot_apply_context_t *c,
+					 const Device &device,
+					 bool vertical)
+  {
+    if (&device == &Null (Device)) return 0;
+
+    hb_font_t *font = c->font;
+    hb_position_t delta;
+    hb_ot_device_cache_t *cache = hb_ot_layout_get_device_cache (font);
+    if (cache && cache->get (font->serial, &device, vertical, &delta))
+      return delta;
+
+    delta = vertical ? device.get_y_delta (font, c->var_store)
+		     : device.get_x_delta (font, c->var_store);
+
+    if (cache)
+      cache->set (font->serial, &device, vertical, delta);
+    return delta;
+  }
+
   bool sanitize_value_devices (hb_sanitize_context_t *c, const void *base, const Value *values) const
   {
     unsigned int format = *this;
@@ -219,6 +239,32 @@ struct ValueFormat : HBUINT16
     return_trace (true);
   }
 
+  /* Copies one value record.  Device offsets are relative to base in
+   * the source and to out_base in the copy. */
+  bool copy_values (hb_serialize_context_t *c,
+		    const void *base,
+		    const void *out_base,
+		    const Value *values) const
+  {
+    TRACE_SERIALIZE (this);
+    unsigned int size = get_size ();
+    Value *out = c->allocate_size<Value> (size);
+    if (unlikely (!out)) return_trace (false);
+    memcpy (out, values, size);
+
+    if (!has_device ()) return_trace (true);
+
+    unsigned int format = *this;
+    unsigned int i = hb_popcount (format & (xPlacement | yPlacement | xAdvance | yAdvance));
+    for (unsigned int flag = xPlaDevice; flag <= yAdvDevice; flag <<= 1)
+      if (format & flag)
+      {
+	get_device (&out[i]).serialize_copy (c, base+get_device (&values[i]), out_base);
+	i++;
+      }
+    return_trace (!c->in_error ());
+  }
+
   /* Just sanitize referenced Device tables.  Doesn't check the values themselves. */
   bool sanitize_values_stride_unsafe (hb_sanitize_context_t *c, const void *base, const Value *values, unsigned int count, unsigned int stride) const
   {
@@ -302,10 +348,24 @@ struct AnchorFormat3
     *x = font->em_fscale_x (xCoordinate);
     *y = font->em_fscale_y (yCoordinate);
 
-    if (font->x_ppem || font->num_coords)
+    bool x_delta = (font->x_ppem || font->num_coords) && !xDeviceTable.is_null ();
+    bool y_delta = (font->y_ppem || font->num_coords) && !yDeviceTable.is_null ();
+    if (!x_delta && !y_delta)
+      return;
+
+    /* Evaluating deltas is expensive and the same marks attach over and
+     * over, so remember the outcome on the font. */
+    hb_ot_anchor_cache_t *cache = hb_ot_layout_get_anchor_cache (font);
+    if (cache && cache->get (font->serial, this, x, y))
+      return;
+
+    if (x_delta)
       *x += (this+xDeviceTable).get_x_delta (font, c->var_store);
-    if (font->y_ppem || font->num_coords)
+    if (y_delta)
       *y += (this+yDeviceTable).get_y_delta (font, c->var_store);
+
+    if (cache)
+      cache->set (font->serial, this, *x, *y);
   }
 
   bool sanitize (hb_sanitize_context_t *c) const
@@ -848,11 +908,100 @@ struct PairPosFormat2
     return_trace (true);
   }
 
+  /* Classes that lose all their glyphs are dropped and the rest
+   * renumbered in their original order, so the value matrix shrinks to
+   * the class pairs that can still match.  Class 0 is always kept. */
   bool subset (hb_subset_context_t *c) const
   {
     TRACE_SUBSET (this);
-    // TODO(subset)
-    return_trace (false);
+    const hb_set_t &glyphset = *c->plan->glyphset ();
+    const hb_glyph_map_t &glyph_map = *c->plan->glyph_map;
+    const ClassDef &class_def1 = this+classDef1;
+    const ClassDef &class_def2 = this+classDef2;
+
+    hb_sorted_vector_t<GlyphID> covered;
+    hb_vector_t<unsigned int> klass1_map, klass2_map;
+    if (unlikely (!klass1_map.resize (class1Count) || !klass2_map.resize (class2Count)))
+      return_trace (false);
+    /* Entries hold 1 + the new class; 0 means the class is dropped. */
+    if (class1Count) klass1_map[0] = 1;
+    if (class2Count) klass2_map[0] = 1;
+
+    hb_vector_t<GlyphID> glyphs1, glyphs2;
+    hb_vector_t<unsigned int> old_klasses1, old_klasses2;
+
+    + hb_iter (this+coverage)
+    | hb_filter (glyphset)
+    | hb_apply ([&] (hb_codepoint_t g)
+		{
+		  unsigned int klass = class_def1.get_class (g);
+		  if (unlikely (klass >= class1Count)) return;
+		  covered.push (glyph_map[g]);
+		  if (!klass) return;
+		  klass1_map[klass] = 1;
+		  glyphs1.push (glyph_map[g]);
+		  old_klasses1.push (klass);
+		})
+    ;
+    if (!covered.length) return_trace (false);
+
+    + hb_iter (glyphset)
+    | hb_apply ([&] (hb_codepoint_t g)
+		{
+		  unsigned int klass = class_def2.get_class (g);
+		  if (!klass || unlikely (klass >= class2Count)) return;
+		  klass2_map[klass] = 1;
+		  glyphs2.push (glyph_map[g]);
+		  old_klasses2.push (klass);
+		})
+    ;
+
+    hb_vector_t<unsigned int> old_klass1_of, old_klass2_of;
+    for (unsigned int i = 0; i < klass1_map.length; i++)
+      if (klass1_map[i]) { old_klass1_of.push (i); klass1_map[i] = old_klass1_of.length; }
+    for (unsigned int i = 0; i < klass2_map.length; i++)
+      if (klass2_map[i]) { old_klass2_of.push (i); klass2_map[i] = old_klass2_of.length; }
+
+    hb_vector_t<HBUINT16> klasses1, klasses2;
+    for (unsigned int i = 0; i < old_klasses1.length; i++)
+      klasses1.push (klass1_map[old_klasses1[i]] - 1);
+    for (unsigned int i = 0; i < old_klasses2.length; i++)
+      klasses2.push (klass2_map[old_klasses2[i]] - 1);
+
+    c->serializer->propagate_error (covered, glyphs1, glyphs2);
+    c->serializer->propagate_error (klasses1, klasses2);
+    c->serializer->propagate_error (old_klass1_of, old_klass2_of);
+    if (unlikely (c->serializer->in_error ())) return_trace (false);
+
+    PairPosFormat2 *out = c->serializer->start_embed<PairPosFormat2> ();
+    if (unlikely (!c->serializer->extend_min (out))) return_trace (false);
+    out->format = format;
+    out->valueFormat1 = valueFormat1;
+    out->valueFormat2 = valueFormat2;
+    out->class1Count = old_klass1_of.length;
+    out->class2Count = old_klass2_of.length;
+
+    unsigned int len1 = valueFormat1.get_len ();
+    unsigned int len2 = valueFormat2.get_len ();
+    unsigned int record_len = len1 + len2;
+    for (unsigned int i = 0; i < old_klass1_of.length; i++)
+      for (unsigned int j = 0; j < old_klass2_of.length; j++)
+      {
+	const Value *v = &values[record_len * (old_klass1_of[i] * class2Count + old_klass2_of[j])];
+	if (unlikely (!valueFormat1.copy_values (c->serializer, this, out, v) ||
+		      !valueFormat2.copy_values (c->serializer, this, out, v + len1)))
+	  return_trace (false);
+      }
+
+    if (unlikely (!out->coverage.serialize (c->serializer, out)
+			       .serialize (c->serializer, covered.as_array ())))
+      return_trace (false);
+    out->classDef1.serialize (c->serializer, out);
+    ClassDef_serialize (c->serializer, glyphs1, klasses1);
+    out->classDef2.serialize (c->serializer, out);
+    ClassDef_serialize (c->serializer, glyphs2, klasses2);
+
+    return_trace (!c->serializer->in_error ());
   }
 
   bool sanitize (hb_sanitize_context_t *c) const
@@ -1601,6 +1750,8 @@ struct GPOS : GSUBGPOS
 {
   static constexpr hb_tag_t tableTag = HB_OT_TAG_GPOS;
 
+  typedef PosLookup lookup_t;
+
   const PosLookup& get_lookup (unsigned int i) const
   { return CastR<PosLookup> (GSUBGPOS::get_lookup (i)); }
 
@@ -1696,11 +1847,10 @@ propagate_attachment_offsets (hb_glyph_position_t *pos,
 }
 
 void
-GPOS::position_start (hb_font_t *font HB_UNUSED, hb_buffer_t *buffer)
+GPOS::position_start (hb_font_t *font HB_UNUSED, hb_buffer_t *buffer HB_UNUSED)
 {
-  unsigned int count = buffer->len;
-  for (unsigned int i = 0; i < count; i++)
-    buffer->pos[i].attach_chain() = buffer->pos[i].attach_type() = 0;
+  /* attach_chain() and attach_type() live in the positions, which
+   * hb_ot_position() has just cleared; nothing to do. */
 }
 
 void
@@ -1733,13 +1883,13 @@ struct GPOS_accelerator_t : GPOS::accelerator_t {};
 template <typename context_t>
 /*static*/ inline typename context_t::return_t PosLookup::dispatch_recurse_func (context_t *c, unsigned int lookup_index)
 {
-  const PosLookup &l = c->face->table.GPOS.get_relaxed ()->table->get_lookup (lookup_index);
+  const PosLookup &l = c->face->table.GPOS.get_relaxed ()->get_lookup (lookup_index);
   return l.dispatch (c);
 }
 
 /*static*/ inline bool PosLookup::apply_recurse_func (hb_ot_apply_context_t *c, unsigned int lookup_index)
 {
-  const PosLookup &l = c->face->table.GPOS.get_relaxed ()->table->get_lookup (lookup_index);
+  const PosLookup &l = c->face->table.GPOS.get_relaxed ()->get_lookup (lookup_index);
   unsigned int saved_lookup_props = c->lookup_props;
   unsigned int saved_lookup_index = c->lookup_index;
   c->set_lookup_index (lookup_index);
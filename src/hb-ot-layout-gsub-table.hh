@@ -32,6 +32,12 @@
 #include "hb-ot-layout-gsubgpos.hh"
 
 
+#ifndef HB_OT_LAYOUT_LIGATURE_INDEX_MIN_LIGATURES
+/* Ligature sets at least this long get their ligatures indexed by second
+ * component, instead of being matched one by one. */
+#define HB_OT_LAYOUT_LIGATURE_INDEX_MIN_LIGATURES 8
+#endif
+
 namespace OT {
 
 
@@ -68,16 +74,24 @@ struct SingleSubstFormat1
   bool would_apply (hb_would_apply_context_t *c) const
   { return c->len == 1 && (this+coverage).get_coverage (c->glyphs[0]) != NOT_COVERED; }
 
-  bool apply (hb_ot_apply_context_t *c) const
+  bool get_substitute (hb_codepoint_t glyph_id, hb_codepoint_t *substitute) const
   {
-    TRACE_APPLY (this);
-    hb_codepoint_t glyph_id = c->buffer->cur().codepoint;
     unsigned int index = (this+coverage).get_coverage (glyph_id);
-    if (likely (index == NOT_COVERED)) return_trace (false);
+    if (likely (index == NOT_COVERED)) return false;
 
     /* According to the Adobe Annotated OpenType Suite, result is always
      * limited to 16bit. */
-    glyph_id = (glyph_id + deltaGlyphID) & 0xFFFFu;
+    *substitute = (glyph_id + deltaGlyphID) & 0xFFFFu;
+    return true;
+  }
+
+  bool apply (hb_ot_apply_context_t *c) const
+  {
+    TRACE_APPLY (this);
+    hb_codepoint_t glyph_id;
+    if (likely (!get_substitute (c->buffer->cur().codepoint, &glyph_id)))
+      return_trace (false);
+
     c->replace_glyph (glyph_id);
 
     return_trace (true);
@@ -98,7 +112,7 @@ struct SingleSubstFormat1
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_glyph_map_t &glyph_map = *c->plan->glyph_map;
 
     hb_sorted_vector_t<GlyphID> from;
     hb_vector_t<GlyphID> to;
@@ -161,15 +175,25 @@ struct SingleSubstFormat2
   bool would_apply (hb_would_apply_context_t *c) const
   { return c->len == 1 && (this+coverage).get_coverage (c->glyphs[0]) != NOT_COVERED; }
 
+  bool get_substitute (hb_codepoint_t glyph_id, hb_codepoint_t *substitute_) const
+  {
+    unsigned int index = (this+coverage).get_coverage (glyph_id);
+    if (likely (index == NOT_COVERED)) return false;
+
+    if (unlikely (index >= substitute.len)) return false;
+
+    *substitute_ = substitute[index];
+    return true;
+  }
+
   bool apply (hb_ot_apply_context_t *c) const
   {
     TRACE_APPLY (this);
-    unsigned int index = (this+coverage).get_coverage (c->buffer->cur().codepoint);
-    if (likely (index == NOT_COVERED)) return_trace (false);
-
-    if (unlikely (index >= substitute.len)) return_trace (false);
+    hb_codepoint_t glyph_id;
+    if (likely (!get_substitute (c->buffer->cur().codepoint, &glyph_id)))
+      return_trace (false);
 
-    c->replace_glyph (substitute[index]);
+    c->replace_glyph (glyph_id);
 
     return_trace (true);
   }
@@ -189,7 +213,7 @@ struct SingleSubstFormat2
   {
     TRACE_SUBSET (this);
     const hb_set_t &glyphset = *c->plan->glyphset ();
-    const hb_map_t &glyph_map = *c->plan->glyph_map;
+    const hb_glyph_map_t &glyph_map = *c->plan->glyph_map;
 
     hb_sorted_vector_t<GlyphID> from;
     hb_vector_t<GlyphID> to;
@@ -725,6 +749,13 @@ struct Ligature
     return_trace (ligGlyph.sanitize (c) && component.sanitize (c));
   }
 
+  /* Whether apply() can ever succeed. */
+  bool may_apply () const
+  { return component.lenP1 && component.lenP1 <= HB_MAX_CONTEXT_LENGTH; }
+  /* The second component; -1 if there is none. */
+  hb_codepoint_t get_second_component () const
+  { return component.lenP1 > 1 ? (hb_codepoint_t) component[1] : (hb_codepoint_t) -1; }
+
   protected:
   GlyphID	ligGlyph;		/* GlyphID of ligature to substitute */
   HeadlessArrayOf<GlyphID>
@@ -782,6 +813,107 @@ struct LigatureSet
     return_trace (false);
   }
 
+  /* The ligatures that can apply, by second component; see build_index(). */
+  struct index_entry_t
+  {
+    static int cmp (const index_entry_t *a, const index_entry_t *b)
+    { return a->second < b->second ? -1 : a->second > b->second ? +1 : 0; }
+
+    hb_codepoint_t second;	/* -1 for single glyphs. */
+    unsigned int ligature;	/* Index in the set. */
+  };
+
+  unsigned int get_index_length () const
+  {
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < ligature.len; i++)
+      count += (this+ligature[i]).may_apply ();
+    return count;
+  }
+
+  /* Fills in get_index_length() entries, sorted by second component and
+   * then by preference; single-glyph ligatures come last. */
+  void build_index (index_entry_t *index) const
+  {
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < ligature.len; i++)
+    {
+      const Ligature &lig = this+ligature[i];
+      if (!lig.may_apply ()) continue;
+      index[count].second = lig.get_second_component ();
+      index[count].ligature = i;
+      count++;
+    }
+    hb_stable_sort (index, count, index_entry_t::cmp);
+  }
+
+  /* Like apply(), but only tries the ligatures whose second component
+   * could be matched next, found through index. */
+  bool apply (hb_ot_apply_context_t *c, hb_array_t<const index_entry_t> index) const
+  {
+    TRACE_APPLY (this);
+
+    /* Failed matches flag the text they looked at as unsafe to concat.
+     * Try every ligature to flag just the same text. */
+    if (c->buffer->flags & HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT)
+      return_trace (apply (c));
+
+    /* Usually there is one glyph that can be next; more if default
+     * ignorables that may or may not be skipped come first. */
+    enum { MAX_SECONDS = 4 };
+    hb_codepoint_t seconds[MAX_SECONDS + 1];
+    unsigned int num_seconds = 0;
+    bool too_many = false;
+    c->iter_input.reset (c->buffer->idx, 1);
+    c->iter_input.peek_next ([&] (hb_codepoint_t g)
+			     {
+			       for (unsigned int i = 0; i < num_seconds; i++)
+				 if (seconds[i] == g) return;
+			       if (num_seconds == MAX_SECONDS)
+				 too_many = true;
+			       else
+				 seconds[num_seconds++] = g;
+			     });
+    if (unlikely (too_many))
+      return_trace (apply (c));
+    seconds[num_seconds++] = (hb_codepoint_t) -1; /* Single glyphs. */
+
+    /* Each second component has a run of entries in the index. */
+    unsigned int starts[MAX_SECONDS + 1], ends[MAX_SECONDS + 1];
+    for (unsigned int i = 0; i < num_seconds; i++)
+    {
+      unsigned int lo = 0, hi = index.length;
+      while (lo < hi)
+      {
+	unsigned int mid = (lo + hi) / 2;
+	if (index[mid].second < seconds[i])
+	  lo = mid + 1;
+	else
+	  hi = mid;
+      }
+      starts[i] = ends[i] = lo;
+      while (ends[i] < index.length && index[ends[i]].second == seconds[i])
+	ends[i]++;
+    }
+
+    /* Merge the runs to try ligatures in order of preference. */
+    for (;;)
+    {
+      unsigned int best = num_seconds;
+      for (unsigned int i = 0; i < num_seconds; i++)
+	if (starts[i] < ends[i] &&
+	    (best == num_seconds || index[starts[i]].ligature < index[starts[best]].ligature))
+	  best = i;
+      if (best == num_seconds)
+	break;
+
+      const Ligature &lig = this+ligature[index[starts[best]++].ligature];
+      if (lig.apply (c)) return_trace (true);
+    }
+
+    return_trace (false);
+  }
+
   bool serialize (hb_serialize_context_t *c,
 		  hb_array_t<const GlyphID> ligatures,
 		  hb_array_t<const unsigned int> component_count_list,
@@ -869,9 +1001,89 @@ struct LigatureSubstFormat1
     if (likely (index == NOT_COVERED)) return_trace (false);
 
     const LigatureSet &lig_set = this+ligatureSet[index];
+
+    const apply_cache_t *cache = c->get_apply_cache (*this);
+    if (cache && cache->has_index (index))
+      return_trace (lig_set.apply (c, cache->get_index (index)));
+
     return_trace (lig_set.apply (c));
   }
 
+  /* Indices of the ligature sets too long to try one by one, in one
+   * block: num_sets + 1 entry offsets, then the entries. */
+  struct apply_cache_t : hb_apply_cache_t
+  {
+    bool has_index (unsigned int set_index) const
+    { return set_index < num_sets && get_starts ()[set_index] != get_starts ()[set_index + 1]; }
+    hb_array_t<const LigatureSet::index_entry_t> get_index (unsigned int set_index) const
+    {
+      const unsigned int *starts = get_starts ();
+      return hb_array (get_entries () + starts[set_index], starts[set_index + 1] - starts[set_index]);
+    }
+
+    const unsigned int *get_starts () const
+    { return &StructAtOffset<const unsigned int> (this, sizeof (*this)); }
+    const LigatureSet::index_entry_t *get_entries () const
+    { return &StructAtOffset<const LigatureSet::index_entry_t> (get_starts (), (num_sets + 1) * sizeof (unsigned int)); }
+
+    unsigned int num_sets;
+  };
+
+  /* Builds the set indices, if any set is long enough and the face's
+   * budget allows; see hb_ot_apply_context_t::get_apply_cache(). */
+  hb_apply_cache_t *create_apply_cache (hb_atomic_int_t &budget) const
+  {
+    hb_apply_cache_t *nothing = const_cast<hb_apply_cache_t *> (&Null (hb_apply_cache_t));
+
+    unsigned int num_sets = ligatureSet.len;
+    unsigned int num_entries = 0;
+    for (unsigned int i = 0; i < num_sets; i++)
+    {
+      const LigatureSet &lig_set = this+ligatureSet[i];
+      unsigned int length = lig_set.get_index_length ();
+      if (length >= HB_OT_LAYOUT_LIGATURE_INDEX_MIN_LIGATURES)
+	num_entries += length;
+    }
+    if (!num_entries)
+      return nothing;
+
+    unsigned int size = sizeof (apply_cache_t) +
+			(num_sets + 1) * sizeof (unsigned int) +
+			num_entries * sizeof (LigatureSet::index_entry_t);
+    if (budget.add (-(int) size) < (int) size)
+    {
+      budget.add (size);
+      return nothing;
+    }
+
+    apply_cache_t *cache = (apply_cache_t *) malloc (size);
+    if (unlikely (!cache))
+    {
+      budget.add (size);
+      return nothing;
+    }
+    cache->size = size;
+    cache->num_sets = num_sets;
+
+    unsigned int *starts = const_cast<unsigned int *> (cache->get_starts ());
+    LigatureSet::index_entry_t *entries = const_cast<LigatureSet::index_entry_t *> (cache->get_entries ());
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < num_sets; i++)
+    {
+      starts[i] = count;
+      const LigatureSet &lig_set = this+ligatureSet[i];
+      unsigned int length = lig_set.get_index_length ();
+      if (length >= HB_OT_LAYOUT_LIGATURE_INDEX_MIN_LIGATURES)
+      {
+	lig_set.build_index (entries + count);
+	count += length;
+      }
+    }
+    starts[num_sets] = count;
+
+    return cache;
+  }
+
   bool serialize (hb_serialize_context_t *c,
 		  hb_sorted_array_t<const GlyphID> first_glyphs,
 		  hb_array_t<const unsigned int> ligature_per_first_glyph_count_list,
@@ -973,6 +1185,7 @@ struct ExtensionSubst : Extension<ExtensionSubst>
   typedef struct SubstLookupSubTable SubTable;
 
   bool is_reverse () const;
+  bool closes_per_glyph () const;
 };
 
 
@@ -1051,14 +1264,29 @@ struct ReverseChainSingleSubstFormat1
     const OffsetArrayOf<Coverage> &lookahead = StructAfter<OffsetArrayOf<Coverage>> (backtrack);
     const ArrayOf<GlyphID> &substitute = StructAfter<ArrayOf<GlyphID>> (lookahead);
 
-  unsigned int start_index = 0, end_index = 0;
+    /* Going backward, each glyph is matched against the same context
+     * Coverages again from the following positions; remember the answers. */
+    match_func_t match_func = match_coverage;
+    hb_cached_coverages_t cached_backtrack, cached_lookahead;
+    const void *backtrack_data = this, *lookahead_data = this;
+    const apply_cache_t *cache = c->get_apply_cache (*this);
+    if (cache)
+    {
+      cached_backtrack = {this, (const HBUINT16 *) backtrack.arrayZ, 0, &cache->context};
+      cached_lookahead = {this, (const HBUINT16 *) lookahead.arrayZ, backtrack.len, &cache->context};
+      match_func = match_coverage_cached;
+      backtrack_data = &cached_backtrack;
+      lookahead_data = &cached_lookahead;
+    }
+
+    unsigned int start_index = 0, end_index = 0;
     if (match_backtrack (c,
 			 backtrack.len, (HBUINT16 *) backtrack.arrayZ,
-			 match_coverage, this,
+			 match_func, backtrack_data,
 			 &start_index) &&
         match_lookahead (c,
 			 lookahead.len, (HBUINT16 *) lookahead.arrayZ,
-			 match_coverage, this,
+			 match_func, lookahead_data,
 			 1, &end_index))
     {
       c->buffer->unsafe_to_break_from_outbuffer (start_index, end_index);
@@ -1072,6 +1300,41 @@ struct ReverseChainSingleSubstFormat1
     return_trace (false);
   }
 
+  /* Coverage cache for the context Coverages. */
+  struct apply_cache_t : hb_apply_cache_t
+  {
+    mutable hb_coverage_cache_t context;
+  };
+
+  /* Builds the cache if there is context to match and the face's budget
+   * allows; see hb_ot_apply_context_t::get_apply_cache(). */
+  hb_apply_cache_t *create_apply_cache (hb_atomic_int_t &budget) const
+  {
+    hb_apply_cache_t *nothing = const_cast<hb_apply_cache_t *> (&Null (hb_apply_cache_t));
+
+    const OffsetArrayOf<Coverage> &lookahead = StructAfter<OffsetArrayOf<Coverage>> (backtrack);
+    if (!backtrack.len && !lookahead.len)
+      return nothing;
+
+    unsigned int size = sizeof (apply_cache_t);
+    if (budget.add (-(int) size) < (int) size)
+    {
+      budget.add (size);
+      return nothing;
+    }
+
+    apply_cache_t *cache = (apply_cache_t *) malloc (size);
+    if (unlikely (!cache))
+    {
+      budget.add (size);
+      return nothing;
+    }
+    cache->size = size;
+    cache->context.init ();
+
+    return cache;
+  }
+
   bool subset (hb_subset_context_t *c) const
   {
     TRACE_SUBSET (this);
@@ -1204,6 +1467,27 @@ struct SubstLookup : Lookup
     return lookup_type_is_reverse (type);
   }
 
+  /* Single, multiple and alternate substitutions close over each glyph
+   * on its own, independent of the others. */
+  HB_INTERNAL static bool lookup_type_closes_per_glyph (unsigned int lookup_type)
+  {
+    return lookup_type == SubTable::Single ||
+	   lookup_type == SubTable::Multiple ||
+	   lookup_type == SubTable::Alternate;
+  }
+
+  bool closes_per_glyph () const
+  {
+    unsigned int type = get_type ();
+    if (likely (type != SubTable::Extension))
+      return lookup_type_closes_per_glyph (type);
+    unsigned int count = get_subtable_count ();
+    for (unsigned int i = 0; i < count; i++)
+      if (!CastR<ExtensionSubst> (get_subtable (i)).closes_per_glyph ())
+	return false;
+    return true;
+  }
+
   bool apply (hb_ot_apply_context_t *c) const
   {
     TRACE_APPLY (this);
@@ -1223,13 +1507,20 @@ struct SubstLookup : Lookup
 
     c->set_recurse_func (dispatch_closure_recurse_func);
 
-    hb_closure_context_t::return_t ret = dispatch (c);
+    hb_closure_context_t::return_t ret = dispatch_closure (c, this_index);
 
     c->flush ();
 
     return ret;
   }
 
+  hb_closure_context_t::return_t dispatch_closure (hb_closure_context_t *c, unsigned int this_index) const
+  {
+    if (closes_per_glyph ())
+      return c->dispatch_new_glyphs (*this, this_index);
+    return dispatch (c);
+  }
+
   hb_collect_glyphs_context_t::return_t collect_glyphs (hb_collect_glyphs_context_t *c) const
   {
     c->set_recurse_func (dispatch_recurse_func<hb_collect_glyphs_context_t>);
@@ -1316,20 +1607,7 @@ struct SubstLookup : Lookup
   template <typename context_t>
   HB_INTERNAL static typename context_t::return_t dispatch_recurse_func (context_t *c, unsigned int lookup_index);
 
-  HB_INTERNAL static hb_closure_context_t::return_t dispatch_closure_recurse_func (hb_closure_context_t *c, unsigned int lookup_index)
-  {
-    if (!c->should_visit_lookup (lookup_index))
-      return hb_void_t ();
-
-    hb_closure_context_t::return_t ret = dispatch_recurse_func (c, lookup_index);
-
-    /* While in theory we should flush here, it will cause timeouts because a recursive
-     * lookup can keep growing the glyph set.  Skip, and outer loop will retry up to
-     * HB_CLOSURE_MAX_STAGES time, which should be enough for every realistic font. */
-    //c->flush ();
-
-    return ret;
-  }
+  HB_INTERNAL static hb_closure_context_t::return_t dispatch_closure_recurse_func (hb_closure_context_t *c, unsigned int lookup_index);
 
   template <typename context_t, typename ...Ts>
   typename context_t::return_t dispatch (context_t *c, Ts&&... ds) const
@@ -1351,6 +1629,8 @@ struct GSUB : GSUBGPOS
 {
   static constexpr hb_tag_t tableTag = HB_OT_TAG_GSUB;
 
+  typedef SubstLookup lookup_t;
+
   const SubstLookup& get_lookup (unsigned int i) const
   { return CastR<SubstLookup> (GSUBGPOS::get_lookup (i)); }
 
@@ -1367,7 +1647,141 @@ struct GSUB : GSUBGPOS
 };
 
 
-struct GSUB_accelerator_t : GSUB::accelerator_t {};
+/* Remembers recent glyph closures.  Closure is monotonic and idempotent,
+ * so the closure of a set containing an earlier input can start from
+ * that earlier output instead of from scratch. */
+struct hb_closure_cache_t
+{
+  void init ()
+  {
+    lock.init ();
+    serial = 0;
+    for (unsigned int i = 0; i < ARRAY_LENGTH (entries); i++)
+      entries[i].init ();
+  }
+  void fini ()
+  {
+    for (unsigned int i = 0; i < ARRAY_LENGTH (entries); i++)
+      entries[i].fini ();
+    lock.fini ();
+  }
+
+  /* Adds to glyphs the largest cached closure whose input it contains.
+   * A null lookups means all lookups. */
+  void seed (const hb_set_t *lookups, hb_set_t *glyphs)
+  {
+    hb_lock_t l (lock);
+    entry_t *best = nullptr;
+    for (unsigned int i = 0; i < ARRAY_LENGTH (entries); i++)
+    {
+      entry_t *entry = &entries[i];
+      if (entry->matches (lookups) && entry->input.is_subset (glyphs) &&
+	  (!best || entry->output.get_population () > best->output.get_population ()))
+	best = entry;
+    }
+    if (best)
+    {
+      best->last_used = ++serial;
+      glyphs->union_ (&best->output);
+    }
+  }
+
+  void store (const hb_set_t *lookups, const hb_set_t *input, const hb_set_t *output)
+  {
+    hb_lock_t l (lock);
+    entry_t *victim = &entries[0];
+    for (unsigned int i = 0; i < ARRAY_LENGTH (entries); i++)
+    {
+      entry_t *entry = &entries[i];
+      if (entry->matches (lookups) && entry->input.is_equal (input))
+	return; /* Same result as what we have. */
+      if (entry->last_used < victim->last_used)
+	victim = entry;
+    }
+    victim->all_lookups = !lookups;
+    if (lookups)
+      victim->lookups.set (lookups);
+    victim->input.set (input);
+    victim->output.set (output);
+    victim->last_used = ++serial;
+    if (unlikely (victim->lookups.in_error () ||
+		  victim->input.in_error () ||
+		  victim->output.in_error ()))
+    {
+      victim->fini ();
+      victim->init ();
+    }
+  }
+
+  private:
+  struct entry_t
+  {
+    void init ()
+    {
+      lookups.init_shallow ();
+      input.init_shallow ();
+      output.init_shallow ();
+      all_lookups = false;
+      last_used = 0;
+    }
+    void fini ()
+    {
+      lookups.fini_shallow ();
+      input.fini_shallow ();
+      output.fini_shallow ();
+    }
+
+    bool matches (const hb_set_t *lookups_) const
+    {
+      if (!last_used) return false;
+      if (!lookups_) return all_lookups;
+      return !all_lookups && lookups.is_equal (lookups_);
+    }
+
+    hb_set_t lookups;
+    hb_set_t input;
+    hb_set_t output;
+    bool all_lookups;
+    unsigned int last_used; /* 0 means unused. */
+  };
+
+  hb_mutex_t lock;
+  unsigned int serial;
+  entry_t entries[4];
+};
+
+struct GSUB_accelerator_t : GSUB::accelerator_t
+{
+  void init (hb_face_t *face)
+  {
+    GSUB::accelerator_t::init (face);
+    closure_cache = (hb_closure_cache_t *) calloc (1, sizeof (hb_closure_cache_t));
+    if (likely (closure_cache))
+      closure_cache->init ();
+  }
+  void fini ()
+  {
+    if (closure_cache)
+    {
+      closure_cache->fini ();
+      free (closure_cache);
+    }
+    GSUB::accelerator_t::fini ();
+  }
+  void trim ()
+  {
+    if (closure_cache)
+    {
+      closure_cache->fini ();
+      closure_cache->init ();
+    }
+    GSUB::accelerator_t::trim ();
+  }
+
+  /* Allocated separately to keep the accelerator's Null instance small.
+   * May be nullptr. */
+  hb_closure_cache_t *closure_cache;
+};
 
 
 /* Out-of-class implementation for methods recursing */
@@ -1380,16 +1794,37 @@ struct GSUB_accelerator_t : GSUB::accelerator_t {};
   return SubstLookup::lookup_type_is_reverse (type);
 }
 
+/*static*/ inline bool ExtensionSubst::closes_per_glyph () const
+{
+  return SubstLookup::lookup_type_closes_per_glyph (get_type ());
+}
+
 template <typename context_t>
 /*static*/ inline typename context_t::return_t SubstLookup::dispatch_recurse_func (context_t *c, unsigned int lookup_index)
 {
-  const SubstLookup &l = c->face->table.GSUB.get_relaxed ()->table->get_lookup (lookup_index);
+  const SubstLookup &l = c->face->table.GSUB.get_relaxed ()->get_lookup (lookup_index);
   return l.dispatch (c);
 }
 
+/*static*/ inline hb_closure_context_t::return_t SubstLookup::dispatch_closure_recurse_func (hb_closure_context_t *c, unsigned int lookup_index)
+{
+  if (!c->should_visit_lookup (lookup_index))
+    return hb_void_t ();
+
+  const SubstLookup &l = c->face->table.GSUB.get_relaxed ()->get_lookup (lookup_index);
+  hb_closure_context_t::return_t ret = l.dispatch_closure (c, lookup_index);
+
+  /* While in theory we should flush here, it will cause timeouts because a recursive
+   * lookup can keep growing the glyph set.  Skip, and outer loop will retry up to
+   * HB_CLOSURE_MAX_STAGES time, which should be enough for every realistic font. */
+  //c->flush ();
+
+  return ret;
+}
+
 /*static*/ inline bool SubstLookup::apply_recurse_func (hb_ot_apply_context_t *c, unsigned int lookup_index)
 {
-  const SubstLookup &l = c->face->table.GSUB.get_relaxed ()->table->get_lookup (lookup_index);
+  const SubstLookup &l = c->face->table.GSUB.get_relaxed ()->get_lookup (lookup_index);
   unsigned int saved_lookup_props = c->lookup_props;
   unsigned int saved_lookup_index = c->lookup_index;
   c->set_lookup_index (lookup_index);
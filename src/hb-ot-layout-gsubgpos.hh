@@ -31,6 +31,7 @@
 
 #include "hb.hh"
 #include "hb-buffer.hh"
+#include "hb-cache.hh"
 #include "hb-map.hh"
 #include "hb-set.hh"
 #include "hb-ot-map.hh"
@@ -38,6 +39,18 @@
 #include "hb-ot-layout-gdef-table.hh"
 
 
+#ifndef HB_OT_LAYOUT_INLINE_SUBTABLES
+/* Subtables a lookup accelerator keeps without allocating. */
+#define HB_OT_LAYOUT_INLINE_SUBTABLES 1
+#endif
+
+#ifndef HB_OT_LAYOUT_LAZY_SANITIZE_MIN_LENGTH
+/* GSUB/GPOS tables at least this long have their lookups sanitized, and
+ * their lookup accelerators built, on first use rather than on load. */
+#define HB_OT_LAYOUT_LAZY_SANITIZE_MIN_LENGTH (64 * 1024)
+#endif
+
+
 namespace OT {
 
 
@@ -58,6 +71,47 @@ struct hb_intersects_context_t :
 			     debug_depth (0) {}
 };
 
+/* What closure has done per lookup so far; kept across passes. */
+struct hb_closure_done_lookups_t
+{
+  hb_closure_done_lookups_t () { init (); }
+  ~hb_closure_done_lookups_t () { fini (); }
+
+  void init ()
+  {
+    populations.init ();
+    glyphs.init ();
+  }
+  void fini ()
+  {
+    for (unsigned int i = 0; i < glyphs.length; i++)
+      hb_set_destroy (glyphs[i]);
+    glyphs.fini ();
+    populations.fini ();
+  }
+
+  /* The glyphs lookup_index has closed over, or nullptr on allocation
+   * failure. */
+  hb_set_t *get_glyphs (unsigned int lookup_index)
+  {
+    if (lookup_index >= glyphs.length)
+    {
+      unsigned int old_length = glyphs.length;
+      if (unlikely (!glyphs.resize (lookup_index + 1)))
+	return nullptr;
+      for (unsigned int i = old_length; i < glyphs.length; i++)
+	glyphs[i] = nullptr;
+    }
+    if (!glyphs[lookup_index])
+      glyphs[lookup_index] = hb_set_create ();
+    hb_set_t *set = glyphs[lookup_index];
+    return likely (!set->in_error ()) ? set : nullptr;
+  }
+
+  hb_map_t populations;		/* Glyph count at each lookup's last visit. */
+  hb_vector_t<hb_set_t *> glyphs;	/* See get_glyphs(); by lookup index. */
+};
+
 struct hb_closure_context_t :
        hb_dispatch_context_t<hb_closure_context_t, hb_void_t, 0>
 {
@@ -80,14 +134,44 @@ struct hb_closure_context_t :
   {
     if (is_lookup_done (lookup_index))
       return false;
-    done_lookups->set (lookup_index, glyphs->get_population ());
+    done_lookups->populations.set (lookup_index, glyphs->get_population ());
     return true;
   }
 
   bool is_lookup_done (unsigned int lookup_index)
   {
     /* Have we visited this lookup with the current set of glyphs? */
-    return done_lookups->get (lookup_index) == glyphs->get_population ();
+    return done_lookups->populations.get (lookup_index) == glyphs->get_population ();
+  }
+
+  /* For lookups whose closure works glyph by glyph: closes obj over only
+   * the glyphs it hasn't seen at an earlier visit.  What those produced
+   * is in glyphs or output already. */
+  template <typename T>
+  return_t dispatch_new_glyphs (const T &obj, unsigned int lookup_index)
+  {
+    hb_set_t *done = done_lookups->get_glyphs (lookup_index);
+    if (unlikely (!done))
+      return obj.dispatch (this);
+
+    if (done->is_empty ())
+    {
+      done->set (glyphs);
+      return obj.dispatch (this);
+    }
+
+    hb_set_t new_glyphs;
+    new_glyphs.set (glyphs);
+    new_glyphs.subtract (done);
+    if (unlikely (new_glyphs.in_error ()))
+      return obj.dispatch (this);
+    done->set (glyphs);
+
+    hb_set_t *saved_glyphs = glyphs;
+    glyphs = &new_glyphs;
+    obj.dispatch (this);
+    glyphs = saved_glyphs;
+    return default_return_value ();
   }
 
   hb_face_t *face;
@@ -99,7 +183,7 @@ struct hb_closure_context_t :
 
   hb_closure_context_t (hb_face_t *face_,
 			hb_set_t *glyphs_,
-			hb_map_t *done_lookups_,
+			hb_closure_done_lookups_t *done_lookups_,
 			unsigned int nesting_level_left_ = HB_MAX_NESTING_LEVEL) :
 			  face (face_),
 			  glyphs (glyphs_),
@@ -119,7 +203,7 @@ struct hb_closure_context_t :
   }
 
   private:
-  hb_map_t *done_lookups;
+  hb_closure_done_lookups_t *done_lookups;
 };
 
 
@@ -252,6 +336,81 @@ struct hb_add_coverage_context_t :
 };
 
 
+/* Data a subtable builds on first use to speed up applying it, held by
+ * the lookup accelerator; see hb_ot_apply_context_t::get_apply_cache().
+ * A single malloc()ed
+ * block starting with its own size.  Null (hb_apply_cache_t) stands for
+ * "nothing worth building". */
+struct hb_apply_cache_t
+{
+  unsigned int size;
+};
+
+/* A native-endian copy of a large format 1 Coverage's glyphs, in
+ * Eytzinger (breadth-first) order: the first probes of every search
+ * share a few cache lines, and there are no byteswaps.  Built on first
+ * use by the subtable's hb_applicable_t, charged to the face's
+ * coverage_index_budget.  Null (hb_coverage_index_t) stands for "not
+ * worth building". */
+struct hb_coverage_index_t
+{
+  static hb_coverage_index_t *create (const Coverage &coverage,
+				      hb_atomic_int_t &budget)
+  {
+    hb_coverage_index_t *nothing = const_cast<hb_coverage_index_t *> (&Null (hb_coverage_index_t));
+
+    const SortedArrayOf<GlyphID> *glyphs = coverage.get_glyph_array ();
+    if (!glyphs || glyphs->len < HB_OT_LAYOUT_COVERAGE_INDEX_MIN_GLYPHS)
+      return nothing;
+
+    unsigned int count = glyphs->len;
+    unsigned int size = sizeof (hb_coverage_index_t) + count * sizeof (uint16_t);
+    if (budget.add (-(int) size) < (int) size)
+    {
+      budget.add (size);
+      return nothing;
+    }
+
+    hb_coverage_index_t *index = (hb_coverage_index_t *) malloc (size);
+    if (unlikely (!index))
+    {
+      budget.add (size);
+      return nothing;
+    }
+    index->size = size;
+    index->count = count;
+    index->fill (glyphs->arrayZ, 0, 1);
+    return index;
+  }
+
+  bool has (hb_codepoint_t g) const
+  {
+    if (unlikely (g > 0xFFFFu)) return false;
+    /* Walk down the implicit tree; k ends up past a leaf, and the node
+     * we last went right from, if any, holds the largest glyph <= g. */
+    unsigned int k = 1;
+    while (k <= count)
+      k = 2 * k + (glyphs[k] < g);
+    k >>= hb_ctz (~k) + 1;
+    return k && glyphs[k] == g;
+  }
+
+  private:
+  /* In-order walk of the tree rooted at k, taking sorted glyphs from i on. */
+  unsigned int fill (const GlyphID *sorted, unsigned int i, unsigned int k)
+  {
+    if (k > count) return i;
+    i = fill (sorted, i, 2 * k);
+    glyphs[k] = sorted[i++];
+    return fill (sorted, i, 2 * k + 1);
+  }
+
+  public:
+  unsigned int size;
+  unsigned int count;
+  uint16_t glyphs[1]; /* 1-based; count + 1 entries, glyphs[0] unused. */
+};
+
 struct hb_ot_apply_context_t :
        hb_dispatch_context_t<hb_ot_apply_context_t, bool, HB_DEBUG_APPLY>
 {
@@ -285,11 +444,18 @@ struct hb_ot_apply_context_t :
       MATCH_MAYBE
     };
 
+    /* Whether info passes the checks done before it is compared to
+     * what is being matched. */
+    bool may_match_any (const hb_glyph_info_t &info) const
+    {
+      return (info.mask & mask) &&
+	     (!syllable || syllable == info.syllable ());
+    }
+
     may_match_t may_match (const hb_glyph_info_t &info,
 			   const HBUINT16        *glyph_data) const
     {
-      if (!(info.mask & mask) ||
-	  (syllable && syllable != info.syllable ()))
+      if (!may_match_any (info))
 	return MATCH_NO;
 
       if (match_func)
@@ -392,10 +558,38 @@ struct hb_ot_apply_context_t :
 	}
 
 	if (skip == matcher_t::SKIP_NO)
+	{
+	  /* Other text up to here might have matched. */
+	  c->buffer->unsafe_to_concat (c->buffer->idx, idx + 1);
 	  return false;
+	}
       }
+      /* More text after the end might have matched. */
+      c->buffer->unsafe_to_concat (c->buffer->idx, end);
       return false;
     }
+    /* Calls record with every glyph the next call to next() could match,
+     * whatever it is matched against, without moving or flagging the
+     * buffer. */
+    template <typename Recorder>
+    void peek_next (Recorder record) const
+    {
+      for (unsigned int i = idx + 1; i + num_items <= end; i++)
+      {
+	const hb_glyph_info_t &info = c->buffer->info[i];
+
+	matcher_t::may_skip_t skip = matcher.may_skip (c, info);
+	if (unlikely (skip == matcher_t::SKIP_YES))
+	  continue;
+
+	if (matcher.may_match_any (info))
+	  record (info.codepoint);
+
+	if (skip == matcher_t::SKIP_NO)
+	  return;
+      }
+    }
+
     bool prev ()
     {
       assert (num_items > 0);
@@ -419,8 +613,12 @@ struct hb_ot_apply_context_t :
 	}
 
 	if (skip == matcher_t::SKIP_NO)
+	{
+	  c->buffer->unsafe_to_concat_from_outbuffer (idx, c->buffer->idx + 1);
 	  return false;
+	}
       }
+      c->buffer->unsafe_to_concat_from_outbuffer (0, c->buffer->idx + 1);
       return false;
     }
 
@@ -447,7 +645,10 @@ struct hb_ot_apply_context_t :
       return default_return_value ();
 
     nesting_level_left--;
+    hb_atomic_ptr_t<hb_apply_cache_t> *saved_subtable_cache = subtable_cache;
+    subtable_cache = nullptr;
     bool ret = recurse_func (this, sub_lookup_index);
+    subtable_cache = saved_subtable_cache;
     nesting_level_left++;
     return ret;
   }
@@ -459,6 +660,7 @@ struct hb_ot_apply_context_t :
   hb_buffer_t *buffer;
   recurse_func_t recurse_func;
   const GDEF &gdef;
+  const GDEF::accelerator_t &gdef_accel;
   const VariationStore &var_store;
 
   hb_direction_t direction;
@@ -476,6 +678,13 @@ struct hb_ot_apply_context_t :
 
   uint32_t random_state;
 
+  /* Mark filtering set membership, keyed by set index and glyph. */
+  mutable hb_cache_t<24, 1, 8> mark_set_cache;
+
+  /* Cache slot of the subtable being applied through a lookup
+   * accelerator; nullptr otherwise. */
+  hb_atomic_ptr_t<hb_apply_cache_t> *subtable_cache;
+
 
   hb_ot_apply_context_t (unsigned int table_index_,
 		      hb_font_t *font_,
@@ -484,6 +693,7 @@ struct hb_ot_apply_context_t :
 			font (font_), face (font->face), buffer (buffer_),
 			recurse_func (nullptr),
 			gdef (*face->table.GDEF->table),
+			gdef_accel (*face->table.GDEF),
 			var_store (gdef.get_var_store ()),
 			direction (buffer_->props.direction),
 			lookup_mask (1),
@@ -496,7 +706,12 @@ struct hb_ot_apply_context_t :
 			auto_zwnj (true),
 			auto_zwj (true),
 			random (false),
-			random_state (1) { init_iters (); }
+			random_state (1),
+			subtable_cache (nullptr)
+  {
+    init_iters ();
+    mark_set_cache.init ();
+  }
 
   void init_iters ()
   {
@@ -527,7 +742,7 @@ struct hb_ot_apply_context_t :
      * match_props has the set index.
      */
     if (match_props & LookupFlag::UseMarkFilteringSet)
-      return gdef.mark_set_covers (match_props >> 16, glyph);
+      return mark_set_covers (match_props >> 16, glyph);
 
     /* The second byte of match_props has the meaning
      * "ignore marks of attachment type different than
@@ -539,6 +754,52 @@ struct hb_ot_apply_context_t :
     return true;
   }
 
+  /* Skipping iterators ask about the same few marks over and over.  Unless
+   * GDEF has them in its dense props array, each answer is a binary search
+   * in the mark glyph set. */
+  bool mark_set_covers (unsigned int set_index, hb_codepoint_t glyph) const
+  {
+    if (unlikely (set_index > 0xFFu || glyph > 0xFFFFu))
+      return gdef_accel.mark_set_covers (set_index, glyph);
+
+    unsigned int key = (set_index << 16) | glyph;
+    unsigned int v;
+    if (mark_set_cache.get (key, &v))
+      return v;
+    bool covers = gdef_accel.mark_set_covers (set_index, glyph);
+    mark_set_cache.set (key, covers);
+    return covers;
+  }
+
+  /* Returns the cache of the subtable being applied, creating it with
+   * obj.create_apply_cache() on first use, or nullptr if there is none.
+   * create_apply_cache() charges the face's budget and returns
+   * Null (hb_apply_cache_t) if there is nothing to build. */
+  template <typename T>
+  const typename T::apply_cache_t *get_apply_cache (const T &obj)
+  {
+    hb_atomic_ptr_t<hb_apply_cache_t> *slot = subtable_cache;
+    if (!slot) return nullptr;
+
+    hb_apply_cache_t *cache = slot->get ();
+    if (unlikely (!cache))
+    {
+      cache = obj.create_apply_cache (face->apply_cache_budget);
+      if (unlikely (!slot->cmpexch (nullptr, cache)))
+      {
+	/* Lost the race; someone else built one. */
+	if (cache != &Null (hb_apply_cache_t))
+	{
+	  face->apply_cache_budget.add (cache->size);
+	  free (cache);
+	}
+	cache = slot->get ();
+      }
+    }
+
+    return cache == &Null (hb_apply_cache_t) ? nullptr : (const typename T::apply_cache_t *) cache;
+  }
+
   bool check_glyph_property (const hb_glyph_info_t *info,
 			     unsigned int  match_props) const
   {
@@ -579,7 +840,7 @@ struct hb_ot_apply_context_t :
     if (component)
       add_in |= HB_OT_LAYOUT_GLYPH_PROPS_MULTIPLIED;
     if (likely (has_glyph_classes))
-      _hb_glyph_info_set_glyph_props (&buffer->cur(), add_in | gdef.get_glyph_props (glyph_index));
+      _hb_glyph_info_set_glyph_props (&buffer->cur(), add_in | gdef_accel.get_glyph_props (glyph_index));
     else if (class_guess)
       _hb_glyph_info_set_glyph_props (&buffer->cur(), add_in | class_guess);
   }
@@ -619,31 +880,134 @@ struct hb_get_subtables_context_t :
     return typed_obj->apply (c);
   }
 
+  template <typename Type>
+  HB_INTERNAL static bool substitute_to (const void *obj, hb_codepoint_t glyph, hb_codepoint_t *substitute)
+  {
+    const Type *typed_obj = (const Type *) obj;
+    return typed_obj->get_substitute (glyph, substitute);
+  }
+
   typedef bool (*hb_apply_func_t) (const void *obj, OT::hb_ot_apply_context_t *c);
+  typedef bool (*hb_substitute_func_t) (const void *obj, hb_codepoint_t glyph, hb_codepoint_t *substitute);
+
+  /* Subtables that substitute one glyph for another, and nothing else,
+   * implement get_substitute(). */
+  template <typename Type>
+  static auto _get_substitute_func (hb_priority<1>) ->
+  hb_head_tt<hb_substitute_func_t, decltype (hb_declval (const Type &).get_substitute (0, nullptr))>
+  { return substitute_to<Type>; }
+  template <typename Type>
+  static hb_substitute_func_t _get_substitute_func (hb_priority<0>) { return nullptr; }
 
   struct hb_applicable_t
   {
     template <typename T>
-    void init (const T &obj_, hb_apply_func_t apply_func_)
+    void init (const T &obj_, hb_apply_func_t apply_func_, hb_substitute_func_t substitute_func_,
+	       unsigned int num_glyphs)
     {
       obj = &obj_;
       apply_func = apply_func_;
-      digest.init ();
-      obj_.get_coverage ().add_coverage (&digest);
+      substitute_func = substitute_func_;
+      coverage = &obj_.get_coverage ();
+      hb_set_digest_adaptive_t::builder_t builder;
+      builder.init ();
+      coverage->add_coverage (&builder);
+      digest.init (builder, num_glyphs);
+      coverage_cache.init ();
+      coverage_index.init ();
+      cache.init ();
+    }
+    void fini ()
+    {
+      hb_coverage_index_t *index = coverage_index.get_relaxed ();
+      if (index && index != &Null (hb_coverage_index_t))
+	free (index);
+      hb_apply_cache_t *p = cache.get_relaxed ();
+      if (p && p != &Null (hb_apply_cache_t))
+	free (p);
+    }
+
+    /* Drops the coverage index and apply cache, to be rebuilt on next use. */
+    void trim ()
+    {
+      fini ();
+      coverage_index.set_relaxed (nullptr);
+      cache.set_relaxed (nullptr);
+      coverage_cache.clear ();
+    }
+
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      const hb_coverage_index_t *index = coverage_index.get ();
+      if (index)
+	usage->heap += index->size;
+      const hb_apply_cache_t *p = cache.get ();
+      if (p)
+	usage->heap += p->size;
     }
 
     bool apply (OT::hb_ot_apply_context_t *c) const
     {
-      return digest.may_have (c->buffer->cur().codepoint) && apply_func (obj, c);
+      hb_codepoint_t g = c->buffer->cur().codepoint;
+      if (!digest.may_have (g) || !is_covered (g, c->face))
+	return false;
+      c->subtable_cache = &cache;
+      bool ret = apply_func (obj, c);
+      c->subtable_cache = nullptr;
+      return ret;
     }
 
+    bool can_substitute () const { return substitute_func; }
+    bool substitute (hb_codepoint_t g, hb_codepoint_t *substitute, hb_face_t *face) const
+    { return digest.may_have (g) && is_covered (g, face) && substitute_func (obj, g, substitute); }
+
     private:
+    /* The digest lets through many glyphs for subtables with large or
+     * scattered coverage; remember recent answers so that repeated
+     * false positives don't keep hitting the binary search. */
+    bool is_covered (hb_codepoint_t g, hb_face_t *face) const
+    {
+      unsigned int v;
+      if (coverage_cache.get (g, &v))
+	return v;
+      const hb_coverage_index_t *index = get_coverage_index (face);
+      bool covered = index ? index->has (g) : coverage->get_coverage (g) != NOT_COVERED;
+      coverage_cache.set (g, covered);
+      return covered;
+    }
+
+    const hb_coverage_index_t *get_coverage_index (hb_face_t *face) const
+    {
+      hb_coverage_index_t *index = coverage_index.get ();
+      if (unlikely (!index))
+      {
+	index = hb_coverage_index_t::create (*coverage, face->coverage_index_budget);
+	if (unlikely (!coverage_index.cmpexch (nullptr, index)))
+	{
+	  /* Lost the race; someone else built one. */
+	  if (index != &Null (hb_coverage_index_t))
+	  {
+	    face->coverage_index_budget.add (index->size);
+	    free (index);
+	  }
+	  index = coverage_index.get ();
+	}
+      }
+      return index == &Null (hb_coverage_index_t) ? nullptr : index;
+    }
+
     const void *obj;
     hb_apply_func_t apply_func;
-    hb_set_digest_t digest;
+    hb_substitute_func_t substitute_func;
+    const Coverage *coverage;
+    hb_set_digest_adaptive_t digest;
+    mutable hb_cache_t<16, 1, 6> coverage_cache;
+    mutable hb_atomic_ptr_t<hb_coverage_index_t> coverage_index;
+    mutable hb_atomic_ptr_t<hb_apply_cache_t> cache;
   };
 
-  typedef hb_vector_t<hb_applicable_t> array_t;
+  /* Most lookups have a single subtable; keep that in the accelerator. */
+  typedef hb_vector_t<hb_applicable_t, HB_OT_LAYOUT_INLINE_SUBTABLES> array_t;
 
   /* Dispatch interface. */
   const char *get_name () { return "GET_SUBTABLES"; }
@@ -651,16 +1015,18 @@ struct hb_get_subtables_context_t :
   return_t dispatch (const T &obj)
   {
     hb_applicable_t *entry = array.push();
-    entry->init (obj, apply_to<T>);
+    entry->init (obj, apply_to<T>, _get_substitute_func<T> (hb_prioritize), num_glyphs);
     return hb_void_t ();
   }
   static return_t default_return_value () { return hb_void_t (); }
 
-  hb_get_subtables_context_t (array_t &array_) :
+  hb_get_subtables_context_t (array_t &array_, unsigned int num_glyphs_) :
 			      array (array_),
+			      num_glyphs (num_glyphs_),
 			      debug_depth (0) {}
 
   array_t &array;
+  unsigned int num_glyphs;
   unsigned int debug_depth;
 };
 
@@ -751,12 +1117,71 @@ static inline bool match_class (hb_codepoint_t glyph_id, const HBUINT16 &value,
   const ClassDef &class_def = *reinterpret_cast<const ClassDef *>(data);
   return class_def.get_class (glyph_id) == value;
 }
+
+/* Glyph classes of one ClassDef, remembered by glyph; see
+ * ChainContextFormat2::apply_cache_t. */
+typedef hb_cache_t<16, 16, 7> hb_class_cache_t;
+
+struct hb_cached_class_def_t
+{
+  unsigned int get_class (hb_codepoint_t glyph_id) const
+  {
+    if (unlikely (glyph_id > 0xFFFFu))
+      return class_def->get_class (glyph_id);
+
+    unsigned int klass;
+    if (cache->get (glyph_id, &klass))
+      return klass;
+    klass = class_def->get_class (glyph_id);
+    cache->set (glyph_id, klass);
+    return klass;
+  }
+
+  const ClassDef *class_def;
+  hb_class_cache_t *cache;
+};
+static inline bool match_class_cached (hb_codepoint_t glyph_id, const HBUINT16 &value, const void *data)
+{
+  const hb_cached_class_def_t &class_def = *reinterpret_cast<const hb_cached_class_def_t *>(data);
+  return class_def.get_class (glyph_id) == value;
+}
 static inline bool match_coverage (hb_codepoint_t glyph_id, const HBUINT16 &value, const void *data)
 {
   const OffsetTo<Coverage> &coverage = (const OffsetTo<Coverage>&)value;
   return (data+coverage).get_coverage (glyph_id) != NOT_COVERED;
 }
 
+/* Which of the first eight context Coverages of a subtable recently seen
+ * glyphs are in: the low byte flags the Coverages already looked up, the
+ * high byte holds their answers.  See
+ * ReverseChainSingleSubstFormat1::apply_cache_t. */
+typedef hb_cache_t<16, 16, 7> hb_coverage_cache_t;
+
+struct hb_cached_coverages_t
+{
+  const void *base;
+  const HBUINT16 *coverages; /* Offsets of the Coverages, from base. */
+  unsigned int first; /* Position of coverages[0] among the cached ones. */
+  hb_coverage_cache_t *cache;
+};
+static inline bool match_coverage_cached (hb_codepoint_t glyph_id, const HBUINT16 &value, const void *data)
+{
+  const hb_cached_coverages_t &coverages = *reinterpret_cast<const hb_cached_coverages_t *>(data);
+  unsigned int i = coverages.first + (&value - coverages.coverages);
+  if (unlikely (i >= 8 || glyph_id > 0xFFFFu))
+    return match_coverage (glyph_id, value, coverages.base);
+
+  unsigned int v;
+  if (!coverages.cache->get (glyph_id, &v))
+    v = 0;
+  else if (v & (1u << i))
+    return (v >> (8 + i)) & 1;
+
+  bool covered = match_coverage (glyph_id, value, coverages.base);
+  coverages.cache->set (glyph_id, v | (1u << i) | ((unsigned) covered << (8 + i)));
+  return covered;
+}
+
 static inline bool would_match_input (hb_would_apply_context_t *c,
 				      unsigned int count, /* Including the first glyph (not matched) */
 				      const HBUINT16 input[], /* Array of input values--start with second glyph */
@@ -1592,6 +2017,8 @@ struct ContextFormat2
 
   bool would_apply (hb_would_apply_context_t *c) const
   {
+    if (get_coverage ().get_coverage (c->glyphs[0]) == NOT_COVERED)
+      return false;
     const ClassDef &class_def = this+classDef;
     unsigned int index = class_def.get_class (c->glyphs[0]);
     const RuleSet &rule_set = this+ruleSet[index];
@@ -1699,6 +2126,8 @@ struct ContextFormat3
 
   bool would_apply (hb_would_apply_context_t *c) const
   {
+    if (get_coverage ().get_coverage (c->glyphs[0]) == NOT_COVERED)
+      return false;
     const LookupRecord *lookupRecord = &StructAfter<LookupRecord> (coverageZ.as_array (glyphCount));
     struct ContextApplyLookupContext lookup_context = {
       {match_coverage},
@@ -2247,6 +2676,8 @@ struct ChainContextFormat2
 
   bool would_apply (hb_would_apply_context_t *c) const
   {
+    if (get_coverage ().get_coverage (c->glyphs[0]) == NOT_COVERED)
+      return false;
     const ClassDef &backtrack_class_def = this+backtrackClassDef;
     const ClassDef &input_class_def = this+inputClassDef;
     const ClassDef &lookahead_class_def = this+lookaheadClassDef;
@@ -2274,6 +2705,26 @@ struct ChainContextFormat2
     const ClassDef &input_class_def = this+inputClassDef;
     const ClassDef &lookahead_class_def = this+lookaheadClassDef;
 
+    const apply_cache_t *cache = c->get_apply_cache (*this);
+    if (cache)
+    {
+      /* Rules at neighbouring positions look at the same glyphs again;
+       * don't redo their class lookups. */
+      hb_cached_class_def_t backtrack = {&backtrack_class_def, &cache->backtrack};
+      hb_cached_class_def_t input = {&input_class_def, &cache->input};
+      hb_cached_class_def_t lookahead = {&lookahead_class_def, &cache->lookahead};
+
+      index = input.get_class (c->buffer->cur().codepoint);
+      const ChainRuleSet &rule_set = this+ruleSet[index];
+      struct ChainContextApplyLookupContext lookup_context = {
+	{match_class_cached},
+	{&backtrack,
+	 &input,
+	 &lookahead}
+      };
+      return_trace (rule_set.apply (c, lookup_context));
+    }
+
     index = input_class_def.get_class (c->buffer->cur().codepoint);
     const ChainRuleSet &rule_set = this+ruleSet[index];
     struct ChainContextApplyLookupContext lookup_context = {
@@ -2285,6 +2736,40 @@ struct ChainContextFormat2
     return_trace (rule_set.apply (c, lookup_context));
   }
 
+  /* Class caches for the three ClassDefs. */
+  struct apply_cache_t : hb_apply_cache_t
+  {
+    mutable hb_class_cache_t backtrack;
+    mutable hb_class_cache_t input;
+    mutable hb_class_cache_t lookahead;
+  };
+
+  /* See hb_ot_apply_context_t::get_apply_cache(). */
+  hb_apply_cache_t *create_apply_cache (hb_atomic_int_t &budget) const
+  {
+    hb_apply_cache_t *nothing = const_cast<hb_apply_cache_t *> (&Null (hb_apply_cache_t));
+
+    unsigned int size = sizeof (apply_cache_t);
+    if (budget.add (-(int) size) < (int) size)
+    {
+      budget.add (size);
+      return nothing;
+    }
+
+    apply_cache_t *cache = (apply_cache_t *) malloc (size);
+    if (unlikely (!cache))
+    {
+      budget.add (size);
+      return nothing;
+    }
+    cache->size = size;
+    cache->backtrack.init ();
+    cache->input.init ();
+    cache->lookahead.init ();
+
+    return cache;
+  }
+
   bool subset (hb_subset_context_t *c) const
   {
     TRACE_SUBSET (this);
@@ -2390,6 +2875,8 @@ struct ChainContextFormat3
 
   bool would_apply (hb_would_apply_context_t *c) const
   {
+    if (get_coverage ().get_coverage (c->glyphs[0]) == NOT_COVERED)
+      return false;
     const OffsetArrayOf<Coverage> &input = StructAfter<OffsetArrayOf<Coverage>> (backtrack);
     const OffsetArrayOf<Coverage> &lookahead = StructAfter<OffsetArrayOf<Coverage>> (input);
     const ArrayOf<LookupRecord> &lookup = StructAfter<ArrayOf<LookupRecord>> (lookahead);
@@ -2580,22 +3067,158 @@ struct Extension
  * GSUB/GPOS Common
  */
 
+/* Exact bitmap of the glyphs a lookup may start matching at, for lookups
+ * whose coverage is big enough for the digest to be flooded.  The Null
+ * bitmap is not exact and lets everything through. */
+struct hb_ot_layout_lookup_bitmap_t
+{
+  bool may_have (hb_codepoint_t g) const
+  {
+    if (!exact) return true;
+    g -= min_glyph;
+    return g < length && (elts[g / ELT_BITS] & ((elt_t) 1 << (g % ELT_BITS)));
+  }
+
+  static hb_ot_layout_lookup_bitmap_t *create (const hb_set_t &glyphs)
+  {
+    hb_codepoint_t min_glyph = glyphs.get_min ();
+    unsigned int length = glyphs.get_max () - min_glyph + 1;
+    hb_ot_layout_lookup_bitmap_t *bitmap = (hb_ot_layout_lookup_bitmap_t *) calloc (1, get_size (length));
+    if (unlikely (!bitmap))
+      return nullptr;
+
+    bitmap->exact = true;
+    bitmap->min_glyph = min_glyph;
+    bitmap->length = length;
+    for (hb_codepoint_t g = HB_SET_VALUE_INVALID; glyphs.next (&g);)
+    {
+      unsigned int i = g - min_glyph;
+      bitmap->elts[i / ELT_BITS] |= (elt_t) 1 << (i % ELT_BITS);
+    }
+    return bitmap;
+  }
+
+  static unsigned int get_size (unsigned int length)
+  { return offsetof (hb_ot_layout_lookup_bitmap_t, elts) + (length + ELT_BITS - 1) / ELT_BITS * sizeof (elt_t); }
+
+  typedef unsigned long long elt_t;
+  enum { ELT_BITS = sizeof (elt_t) * 8 };
+
+  bool exact;
+  hb_codepoint_t min_glyph;
+  unsigned int length;
+  elt_t elts[VAR];
+};
+
+#ifndef HB_OT_LAYOUT_LOOKUP_BITMAP_MIN_GLYPHS
+/* Below this many glyphs the digest is accurate enough. */
+#define HB_OT_LAYOUT_LOOKUP_BITMAP_MIN_GLYPHS 64
+#endif
+
 struct hb_ot_layout_lookup_accelerator_t
 {
   template <typename TLookup>
-  void init (const TLookup &lookup)
+  void init (const TLookup &lookup, unsigned int num_glyphs)
   {
-    digest.init ();
-    lookup.add_coverage (&digest);
+    hb_set_digest_adaptive_t::builder_t builder;
+    builder.init ();
+    lookup.add_coverage (&builder);
+    digest.init (builder, num_glyphs);
 
     subtables.init ();
-    OT::hb_get_subtables_context_t c_get_subtables (subtables);
+    OT::hb_get_subtables_context_t c_get_subtables (subtables, num_glyphs);
     lookup.dispatch (&c_get_subtables);
+
+    single = subtables.length;
+    for (unsigned int i = 0; i < subtables.length; i++)
+      single = single && subtables[i].can_substitute ();
+
+    bitmap.init ();
+  }
+  void fini ()
+  {
+    for (unsigned int i = 0; i < subtables.length; i++)
+      subtables[i].fini ();
+    subtables.fini ();
+    hb_ot_layout_lookup_bitmap_t *b = bitmap.get_relaxed ();
+    if (b && b->exact)
+      free (b);
+  }
+
+  /* Drops the bitmap and subtable caches; the caller resets the budgets
+   * they were charged to. */
+  void trim ()
+  {
+    for (unsigned int i = 0; i < subtables.length; i++)
+      subtables[i].trim ();
+    hb_ot_layout_lookup_bitmap_t *b = bitmap.get_relaxed ();
+    if (b && b->exact)
+      free (b);
+    bitmap.set_relaxed (nullptr);
+  }
+
+  void add_memory_usage (hb_memory_usage_t *usage) const
+  {
+    usage->add_vector (subtables);
+    for (unsigned int i = 0; i < subtables.length; i++)
+      subtables[i].add_memory_usage (usage);
+    const hb_ot_layout_lookup_bitmap_t *b = bitmap.get ();
+    if (b && b->exact)
+      usage->heap += hb_ot_layout_lookup_bitmap_t::get_size (b->length);
+  }
+
+  /* Builds the exact coverage bitmap, if worth it and if budget (bytes)
+   * allows.  Safe to call from multiple threads. */
+  template <typename TLookup>
+  void ensure_bitmap (const TLookup &lookup, hb_atomic_int_t &budget) const
+  {
+    if (likely (bitmap.get_relaxed ()))
+      return;
+
+    hb_ot_layout_lookup_bitmap_t *b = nullptr;
+    int reserved = 0;
+
+    hb_set_t glyphs;
+    if (budget.get_relaxed () > 0)
+    {
+      lookup.add_coverage (&glyphs);
+      if (glyphs.get_population () >= HB_OT_LAYOUT_LOOKUP_BITMAP_MIN_GLYPHS)
+      {
+	reserved = hb_ot_layout_lookup_bitmap_t::get_size (glyphs.get_max () - glyphs.get_min () + 1);
+	if (budget.add (-reserved) >= reserved)
+	  b = hb_ot_layout_lookup_bitmap_t::create (glyphs);
+      }
+    }
+    glyphs.fini ();
+
+    if (!b)
+    {
+      if (reserved)
+	budget.add (reserved);
+      b = const_cast<hb_ot_layout_lookup_bitmap_t *> (&Null (hb_ot_layout_lookup_bitmap_t));
+    }
+
+    if (unlikely (!bitmap.cmpexch (nullptr, b)))
+    {
+      /* Lost the race; someone else built one. */
+      if (b->exact)
+      {
+	free (b);
+	budget.add (reserved);
+      }
+    }
   }
-  void fini () { subtables.fini (); }
 
   bool may_have (hb_codepoint_t g) const
-  { return digest.may_have (g); }
+  {
+    if (!digest.may_have (g)) return false;
+    const hb_ot_layout_lookup_bitmap_t *b = bitmap.get ();
+    return !b || b->may_have (g);
+  }
+
+  /* Whether the lookup may cover any of the glyphs added to glyphs. */
+  bool may_intersect (const hb_set_digest_adaptive_t::builder_t &glyphs) const
+  { return digest.may_have (glyphs); }
 
   bool apply (hb_ot_apply_context_t *c) const
   {
@@ -2605,11 +3228,396 @@ struct hb_ot_layout_lookup_accelerator_t
     return false;
   }
 
+  /* Whether all subtables are single substitutions.  Those need neither
+   * context nor the output buffer, and can be applied with substitute(). */
+  bool is_single () const { return single; }
+  bool substitute (hb_codepoint_t g, hb_codepoint_t *substitute, hb_face_t *face) const
+  {
+    for (unsigned int i = 0; i < subtables.length; i++)
+      if (subtables[i].substitute (g, substitute, face))
+	return true;
+    return false;
+  }
+
   private:
-  hb_set_digest_t digest;
+  hb_set_digest_adaptive_t digest;
   hb_get_subtables_context_t::array_t subtables;
+  bool single;
+  mutable hb_atomic_ptr_t<hb_ot_layout_lookup_bitmap_t> bitmap;
+};
+
+/* Remembers, per LangSys, the feature index each feature tag resolves to,
+ * so plans for an already seen script and language skip the FeatureIndex
+ * scans.  Entries are immutable once published and never evicted; once
+ * all slots are taken, further LangSys are looked up the slow way. */
+struct hb_langsys_feature_cache_t
+{
+  void init ()
+  {
+    for (unsigned int i = 0; i < ARRAY_LENGTH (slots); i++)
+      slots[i].init ();
+  }
+  void fini ()
+  {
+    for (unsigned int i = 0; i < ARRAY_LENGTH (slots); i++)
+      destroy (slots[i].get_relaxed ());
+  }
+
+  /* Returns false if the LangSys is not cached and could not be added. */
+  template <typename TTable>
+  bool find_feature (const TTable &g,
+		     unsigned int script_index,
+		     unsigned int language_index,
+		     hb_tag_t feature_tag,
+		     unsigned int *feature_index /* OUT */)
+  {
+    const entry_t *entry = get_entry (g, script_index, language_index);
+    if (unlikely (!entry))
+      return false;
+    hb_codepoint_t index = entry->features.get (feature_tag);
+    *feature_index = index == HB_MAP_VALUE_INVALID ? (unsigned) Index::NOT_FOUND_INDEX : index;
+    return true;
+  }
+
+  private:
+  struct entry_t
+  {
+    unsigned int key;
+    hb_map_t features; /* Feature tag to feature index. */
+  };
+
+  static unsigned int make_key (unsigned int script_index, unsigned int language_index)
+  { return ((script_index & 0xFFFFu) << 16) | (language_index & 0xFFFFu); }
+
+  template <typename TTable>
+  static entry_t *create (const TTable &g, unsigned int script_index, unsigned int language_index)
+  {
+    entry_t *entry = (entry_t *) calloc (1, sizeof (entry_t));
+    if (unlikely (!entry))
+      return nullptr;
+    entry->key = make_key (script_index, language_index);
+    entry->features.init ();
+
+    const LangSys &l = g.get_script (script_index).get_lang_sys (language_index);
+    unsigned int num_features = l.get_feature_count ();
+    for (unsigned int i = 0; i < num_features; i++)
+    {
+      unsigned int f_index = l.get_feature_index (i);
+      hb_tag_t tag = g.get_feature_tag (f_index);
+      /* The first match wins, as in a linear scan. */
+      if (!entry->features.has (tag))
+	entry->features.set (tag, f_index);
+    }
+
+    if (unlikely (entry->features.in_error ()))
+    {
+      destroy (entry);
+      return nullptr;
+    }
+    return entry;
+  }
+
+  static void destroy (entry_t *entry)
+  {
+    if (!entry)
+      return;
+    entry->features.fini ();
+    free (entry);
+  }
+
+  template <typename TTable>
+  const entry_t *get_entry (const TTable &g, unsigned int script_index, unsigned int language_index)
+  {
+    unsigned int key = make_key (script_index, language_index);
+    entry_t *created = nullptr;
+    for (unsigned int i = 0; i < ARRAY_LENGTH (slots); i++)
+    {
+    retry:
+      entry_t *entry = slots[i].get ();
+      if (entry)
+      {
+	if (entry->key != key)
+	  continue;
+	destroy (created); /* Another thread added it meanwhile. */
+	return entry;
+      }
+
+      if (!created)
+      {
+	created = create (g, script_index, language_index);
+	if (unlikely (!created))
+	  return nullptr;
+      }
+      if (unlikely (!slots[i].cmpexch (nullptr, created)))
+	goto retry;
+      return created;
+    }
+    destroy (created);
+    return nullptr;
+  }
+
+  hb_atomic_ptr_t<entry_t> slots[16];
+};
+
+/* Answers to collection queries, built on first use; see
+ * hb_ot_layout_collect_features() and hb_ot_layout_lookup_collect_glyphs(). */
+struct hb_collect_cache_t
+{
+  /* Features and their lookups under all scripts and languages. */
+  struct features_t
+  {
+    struct tag_entry_t
+    {
+      void init () { feature_indexes.init_shallow (); lookup_indexes.init_shallow (); }
+      void fini () { feature_indexes.fini_shallow (); lookup_indexes.fini_shallow (); }
+
+      hb_set_t feature_indexes;
+      hb_set_t lookup_indexes;
+    };
+
+    void init ()
+    {
+      feature_indexes.init_shallow ();
+      lookup_indexes.init_shallow ();
+      tag_entries.init ();
+      tags.init ();
+    }
+    void fini ()
+    {
+      for (unsigned int i = 0; i < tag_entries.length; i++)
+	tag_entries[i].fini ();
+      tag_entries.fini ();
+      tags.fini ();
+      feature_indexes.fini_shallow ();
+      lookup_indexes.fini_shallow ();
+    }
+
+    bool in_error () const
+    {
+      if (feature_indexes.in_error () || lookup_indexes.in_error () ||
+	  tag_entries.in_error () || tags.in_error ())
+	return true;
+      for (unsigned int i = 0; i < tag_entries.length; i++)
+	if (tag_entries[i].feature_indexes.in_error () ||
+	    tag_entries[i].lookup_indexes.in_error ())
+	  return true;
+      return false;
+    }
+
+    /* For feature tags, or all features if nullptr. */
+    void collect_features (const hb_tag_t *features, hb_set_t *out) const
+    { collect (features, &features_t::feature_indexes, &tag_entry_t::feature_indexes, out); }
+    void collect_lookups (const hb_tag_t *features, hb_set_t *out) const
+    { collect (features, &features_t::lookup_indexes, &tag_entry_t::lookup_indexes, out); }
+
+    unsigned int get_heap_size () const
+    {
+      unsigned int size = feature_indexes.get_heap_size () +
+			  lookup_indexes.get_heap_size () +
+			  tag_entries.get_heap_size () +
+			  tags.get_heap_size ();
+      for (unsigned int i = 0; i < tag_entries.length; i++)
+	size += tag_entries[i].feature_indexes.get_heap_size () +
+		tag_entries[i].lookup_indexes.get_heap_size ();
+      return size;
+    }
+
+    hb_set_t feature_indexes;
+    hb_set_t lookup_indexes;
+    hb_vector_t<tag_entry_t> tag_entries;
+    hb_map_t tags; /* Feature tag to index into tag_entries. */
+
+    private:
+    void collect (const hb_tag_t *features,
+		  hb_set_t features_t::*all,
+		  hb_set_t tag_entry_t::*per_tag,
+		  hb_set_t *out) const
+    {
+      if (!features)
+      {
+	out->union_ (&(this->*all));
+	return;
+      }
+      for (; *features; features++)
+      {
+	hb_codepoint_t i = tags.get (*features);
+	if (i != HB_MAP_VALUE_INVALID)
+	  out->union_ (&(tag_entries[i].*per_tag));
+      }
+    }
+  };
+
+  /* What a lookup collects into each of the four sets. */
+  struct glyphs_t
+  {
+    void init ()
+    {
+      before.init_shallow ();
+      input.init_shallow ();
+      after.init_shallow ();
+      output.init_shallow ();
+    }
+    void fini ()
+    {
+      before.fini_shallow ();
+      input.fini_shallow ();
+      after.fini_shallow ();
+      output.fini_shallow ();
+    }
+
+    bool in_error () const
+    { return before.in_error () || input.in_error () || after.in_error () || output.in_error (); }
+
+    unsigned int get_heap_size () const
+    {
+      return before.get_heap_size () + input.get_heap_size () +
+	     after.get_heap_size () + output.get_heap_size ();
+    }
+
+    hb_set_t before;
+    hb_set_t input;
+    hb_set_t after;
+    hb_set_t output;
+    unsigned int size; /* Charged to the face's budget. */
+  };
+
+  void init (unsigned int lookup_count_)
+  {
+    features.init ();
+    lookups = (hb_atomic_ptr_t<glyphs_t> *) calloc (lookup_count_, sizeof (lookups[0]));
+    lookup_count = likely (lookups) ? lookup_count_ : 0;
+  }
+  void fini ()
+  {
+    destroy (features.get_relaxed ());
+    for (unsigned int i = 0; i < lookup_count; i++)
+      destroy (lookups[i].get_relaxed ());
+    free (lookups);
+  }
+
+  void add_memory_usage (hb_memory_usage_t *usage) const
+  {
+    usage->heap += sizeof (*this) + lookup_count * sizeof (lookups[0]);
+    const features_t *f = features.get ();
+    if (f)
+      usage->heap += sizeof (*f) + f->get_heap_size ();
+    for (unsigned int i = 0; i < lookup_count; i++)
+    {
+      const glyphs_t *g = lookups[i].get ();
+      if (g)
+	usage->heap += g->size;
+    }
+  }
+
+  template <typename Type>
+  static Type *create ()
+  {
+    Type *p = (Type *) calloc (1, sizeof (Type));
+    if (likely (p))
+      p->init ();
+    return p;
+  }
+  template <typename Type>
+  static void destroy (Type *p)
+  {
+    if (!p)
+      return;
+    p->fini ();
+    free (p);
+  }
+
+  hb_atomic_ptr_t<features_t> features;
+  hb_atomic_ptr_t<glyphs_t> *lookups; /* By lookup index. */
+  unsigned int lookup_count;
 };
 
+#ifndef HB_OT_LAYOUT_WOULD_APPLY_CACHE_BITS
+#define HB_OT_LAYOUT_WOULD_APPLY_CACHE_BITS 8
+#endif
+
+/* Remembers would_apply() answers for short glyph sequences; complex
+ * shapers probe the same few sequences against the same lookups for every
+ * plan they build.  Direct-mapped: a colliding query evicts the entry. */
+struct hb_would_apply_cache_t
+{
+  enum { MAX_GLYPHS = 3 };
+
+  void init ()
+  {
+    lock.init ();
+    for (unsigned int i = 0; i < ARRAY_LENGTH (entries); i++)
+      entries[i].len = 0; /* Unused. */
+  }
+  void fini () { lock.fini (); }
+
+  bool get (unsigned int lookup_index,
+	    const hb_codepoint_t *glyphs, unsigned int len,
+	    bool zero_context, bool *result)
+  {
+    if (unlikely (!len || len > MAX_GLYPHS))
+      return false;
+    hb_lock_t l (lock);
+    const entry_t &entry = entries[hash (lookup_index, glyphs, len, zero_context)];
+    if (!entry.matches (lookup_index, glyphs, len, zero_context))
+      return false;
+    *result = entry.result;
+    return true;
+  }
+
+  void set (unsigned int lookup_index,
+	    const hb_codepoint_t *glyphs, unsigned int len,
+	    bool zero_context, bool result)
+  {
+    if (unlikely (!len || len > MAX_GLYPHS))
+      return;
+    hb_lock_t l (lock);
+    entry_t &entry = entries[hash (lookup_index, glyphs, len, zero_context)];
+    entry.lookup_index = lookup_index;
+    for (unsigned int i = 0; i < len; i++)
+      entry.glyphs[i] = glyphs[i];
+    entry.len = len;
+    entry.zero_context = zero_context;
+    entry.result = result;
+  }
+
+  private:
+  struct entry_t
+  {
+    bool matches (unsigned int lookup_index_,
+		  const hb_codepoint_t *glyphs_, unsigned int len_,
+		  bool zero_context_) const
+    {
+      if (len != len_ || lookup_index != lookup_index_ || zero_context != zero_context_)
+	return false;
+      for (unsigned int i = 0; i < len; i++)
+	if (glyphs[i] != glyphs_[i])
+	  return false;
+      return true;
+    }
+
+    unsigned int lookup_index;
+    hb_codepoint_t glyphs[MAX_GLYPHS];
+    unsigned char len;
+    bool zero_context;
+    bool result;
+  };
+
+  static unsigned int hash (unsigned int lookup_index,
+			    const hb_codepoint_t *glyphs, unsigned int len,
+			    bool zero_context)
+  {
+    uint32_t h = lookup_index * 2 + zero_context;
+    for (unsigned int i = 0; i < len; i++)
+      h = h * 31 + glyphs[i];
+    h *= 2654435761u;
+    return h >> (32 - HB_OT_LAYOUT_WOULD_APPLY_CACHE_BITS);
+  }
+
+  hb_mutex_t lock;
+  entry_t entries[1u << HB_OT_LAYOUT_WOULD_APPLY_CACHE_BITS];
+};
+
+
 struct GSUBGPOS
 {
   bool has_data () const { return version.to_int (); }
@@ -2704,12 +3712,69 @@ struct GSUBGPOS
 		  (version.to_int () < 0x00010001u || featureVars.sanitize (c, this)));
   }
 
+  /* Like sanitize(), but only checks the LookupList itself, not the
+   * lookups it points to; each has to pass sanitize_lookup() before use. */
+  template <typename TLookup>
+  bool sanitize_shallow (hb_sanitize_context_t *c) const
+  {
+    TRACE_SANITIZE (this);
+    typedef OffsetListOf<TLookup> TLookupList;
+    return_trace (version.sanitize (c) &&
+		  likely (version.major == 1) &&
+		  scriptList.sanitize (c, this) &&
+		  featureList.sanitize (c, this) &&
+		  CastR<OffsetTo<TLookupList>> (lookupList).sanitize_shallow (c, this) &&
+		  (this+CastR<OffsetTo<TLookupList>> (lookupList)).sanitize_shallow (c) &&
+		  (version.to_int () < 0x00010001u || featureVars.sanitize (c, this)));
+  }
+
+  template <typename TLookup>
+  bool sanitize_lookup (hb_sanitize_context_t *c, unsigned int i) const
+  {
+    TRACE_SANITIZE (this);
+    typedef OffsetListOf<TLookup> TLookupList;
+    const TLookupList &list = this+CastR<OffsetTo<TLookupList>> (lookupList);
+    return_trace (i < list.len && list.arrayZ[i].sanitize (c, &list));
+  }
+
+  /* Sanitizes T like sanitize_shallow() does. */
+  template <typename T>
+  struct shallow_t
+  {
+    bool sanitize (hb_sanitize_context_t *c) const
+    { return CastR<GSUBGPOS> (*this).template sanitize_shallow<typename T::lookup_t> (c); }
+  };
+
   template <typename T>
   struct accelerator_t
   {
+    typedef typename T::lookup_t lookup_t;
+
     void init (hb_face_t *face)
     {
-      this->table = hb_sanitize_context_t().reference_table<T> (face);
+      this->num_glyphs = face->get_num_glyphs ();
+      this->lookup_states = nullptr;
+      this->lock.init ();
+      this->langsys_cache = (hb_langsys_feature_cache_t *) calloc (1, sizeof (hb_langsys_feature_cache_t));
+      if (likely (this->langsys_cache))
+	this->langsys_cache->init ();
+
+      /* Big tables often have hundreds of lookups of which a request only
+       * uses a few; check those as they are used instead of all upfront. */
+      hb_blob_t *blob = hb_face_reference_table (face, T::tableTag);
+      bool lazy = !hb_face_is_trusted (face) &&
+		  hb_blob_get_length (blob) >= HB_OT_LAYOUT_LAZY_SANITIZE_MIN_LENGTH;
+      if (!lazy)
+      {
+	hb_blob_destroy (blob);
+	this->table = hb_sanitize_context_t().reference_table<T> (face);
+      }
+      else
+      {
+	hb_sanitize_context_t c;
+	c.set_num_glyphs (this->num_glyphs);
+	this->table = c.sanitize_blob<shallow_t<T>> (blob);
+      }
       if (unlikely (this->table->is_blacklisted (this->table.get_blob (), face)))
       {
 	hb_blob_destroy (this->table.get_blob ());
@@ -2718,25 +3783,170 @@ struct GSUBGPOS
 
       this->lookup_count = table->get_lookup_count ();
 
+      this->collect_cache = (hb_collect_cache_t *) calloc (1, sizeof (hb_collect_cache_t));
+      if (likely (this->collect_cache))
+	this->collect_cache->init (this->lookup_count);
+      this->would_apply_cache.set_relaxed (nullptr);
+
       this->accels = (hb_ot_layout_lookup_accelerator_t *) calloc (this->lookup_count, sizeof (hb_ot_layout_lookup_accelerator_t));
+      if (lazy && likely (this->accels))
+      {
+	this->lookup_states = (hb_atomic_int_t *) calloc (this->lookup_count, sizeof (hb_atomic_int_t));
+	if (unlikely (!this->lookup_states))
+	{
+	  free (this->accels);
+	  this->accels = nullptr;
+	}
+      }
       if (unlikely (!this->accels))
 	this->lookup_count = 0;
+      if (this->lookup_states)
+	return;
 
       for (unsigned int i = 0; i < this->lookup_count; i++)
-	this->accels[i].init (table->get_lookup (i));
+	this->accels[i].init (table->get_lookup (i), this->num_glyphs);
     }
 
     void fini ()
     {
       for (unsigned int i = 0; i < this->lookup_count; i++)
-	this->accels[i].fini ();
+	if (is_ready (i))
+	  this->accels[i].fini ();
       free (this->accels);
+      free (this->lookup_states);
+      if (this->langsys_cache)
+      {
+	this->langsys_cache->fini ();
+	free (this->langsys_cache);
+      }
+      if (this->collect_cache)
+      {
+	this->collect_cache->fini ();
+	free (this->collect_cache);
+      }
+      hb_collect_cache_t::destroy (this->would_apply_cache.get_relaxed ());
+      this->lock.fini ();
       this->table.destroy ();
     }
 
+    /* Drops what the lookups and queries cached, but not the lookup
+     * accelerators themselves: shape plans point to those. */
+    void trim ()
+    {
+      for (unsigned int i = 0; i < this->lookup_count; i++)
+	if (is_ready (i))
+	  this->accels[i].trim ();
+      if (this->langsys_cache)
+      {
+	this->langsys_cache->fini ();
+	this->langsys_cache->init ();
+      }
+      if (this->collect_cache)
+      {
+	this->collect_cache->fini ();
+	this->collect_cache->init (this->lookup_count);
+      }
+      hb_collect_cache_t::destroy (this->would_apply_cache.get_relaxed ());
+      this->would_apply_cache.set_relaxed (nullptr);
+    }
+
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (this->table);
+      usage->heap += this->lookup_count * sizeof (this->accels[0]);
+      if (this->lookup_states)
+	usage->heap += this->lookup_count * sizeof (this->lookup_states[0]);
+      /* Lookups may be getting ready on other threads. */
+      for (unsigned int i = 0; i < this->lookup_count; i++)
+	if (!this->lookup_states || this->lookup_states[i].get () == LOOKUP_READY)
+	  this->accels[i].add_memory_usage (usage);
+      if (this->collect_cache)
+	this->collect_cache->add_memory_usage (usage);
+      if (this->would_apply_cache.get_relaxed ())
+	usage->heap += sizeof (hb_would_apply_cache_t);
+    }
+
+    /* Lookup i, or Null if it does not exist or failed sanitizing. */
+    const lookup_t &get_lookup (unsigned int i) const
+    {
+      if (unlikely (!ensure_lookup (i)))
+	return Null (lookup_t);
+      return table->get_lookup (i);
+    }
+
+    /* Accelerator of lookup i, or nullptr if get_lookup() is Null. */
+    const hb_ot_layout_lookup_accelerator_t *get_accel (unsigned int i) const
+    {
+      if (unlikely (!ensure_lookup (i)))
+	return nullptr;
+      return &this->accels[i];
+    }
+
+    private:
+    enum lookup_state_t
+    {
+      LOOKUP_PENDING = 0,
+      LOOKUP_READY,
+      LOOKUP_INVALID,
+    };
+
+    bool is_ready (unsigned int i) const
+    { return !this->lookup_states || this->lookup_states[i].get_relaxed () == LOOKUP_READY; }
+
+    bool ensure_lookup (unsigned int i) const
+    {
+      if (unlikely (i >= this->lookup_count))
+	return false;
+      if (likely (!this->lookup_states))
+	return true;
+      int state = this->lookup_states[i].get ();
+      if (likely (state != LOOKUP_PENDING))
+	return state == LOOKUP_READY;
+      return const_cast<accelerator_t *> (this)->init_lookup (i);
+    }
+
+    bool init_lookup (unsigned int i)
+    {
+      hb_lock_t l (this->lock);
+      int state = this->lookup_states[i].get_relaxed ();
+      if (state == LOOKUP_PENDING)
+      {
+	/* The blob is immutable by now, so a lookup that needs edits to
+	 * pass is treated like one whose offset the full check neutered. */
+	hb_sanitize_context_t c;
+	c.set_num_glyphs (this->num_glyphs);
+	c.init (this->table.get_blob ());
+	c.start_processing ();
+	bool sane = table->template sanitize_lookup<lookup_t> (&c, i);
+	c.end_processing ();
+
+	if (sane)
+	{
+	  this->accels[i].init (table->get_lookup (i), this->num_glyphs);
+	  state = LOOKUP_READY;
+	}
+	else
+	  state = LOOKUP_INVALID;
+	this->lookup_states[i].set (state);
+      }
+      return state == LOOKUP_READY;
+    }
+
+    public:
     hb_blob_ptr_t<T> table;
     unsigned int lookup_count;
+    unsigned int num_glyphs;
     hb_ot_layout_lookup_accelerator_t *accels;
+    /* Per-lookup lookup_state_t when sanitizing lazily, else nullptr. */
+    hb_atomic_int_t *lookup_states;
+    hb_mutex_t lock;
+    /* Allocated separately to keep the accelerator's Null instance small.
+     * May be nullptr. */
+    hb_langsys_feature_cache_t *langsys_cache;
+    /* Same; may be nullptr. */
+    hb_collect_cache_t *collect_cache;
+    /* Created on first use; see hb_ot_layout_lookup_would_substitute(). */
+    hb_atomic_ptr_t<hb_would_apply_cache_t> would_apply_cache;
   };
 
   protected:
@@ -75,7 +75,10 @@
 bool
 hb_ot_layout_has_kerning (hb_face_t *face)
 {
-  return face->table.kern->has_data ();
+#if defined(HB_NO_OT_KERN)
+  return false;
+#endif
+  return face->table.kern->table->has_data ();
 }
 
 
@@ -92,7 +95,10 @@ hb_ot_layout_has_kerning (hb_face_t *face)
 bool
 hb_ot_layout_has_machine_kerning (hb_face_t *face)
 {
-  return face->table.kern->has_state_machine ();
+#if defined(HB_NO_OT_KERN)
+  return false;
+#endif
+  return face->table.kern->table->has_state_machine ();
 }
 
 
@@ -113,21 +119,28 @@ hb_ot_layout_has_machine_kerning (hb_face_t *face)
 bool
 hb_ot_layout_has_cross_kerning (hb_face_t *face)
 {
-  return face->table.kern->has_cross_stream ();
+#if defined(HB_NO_OT_KERN)
+  return false;
+#endif
+  return face->table.kern->table->has_cross_stream ();
 }
 
+#if !defined(HB_NO_OT_KERN)
 void
 hb_ot_layout_kern (const hb_ot_shape_plan_t *plan,
 		   hb_font_t *font,
 		   hb_buffer_t  *buffer)
 {
-  hb_blob_t *blob = font->face->table.kern.get_blob ();
-  const AAT::kern& kern = *blob->as<AAT::kern> ();
+  const OT::kern_accelerator_t &accel = *font->face->table.kern;
+  hb_blob_t *blob = accel.table.get_blob ();
+  const AAT::kern& kern = *accel.table;
 
   AAT::hb_aat_apply_context_t c (plan, font, buffer, blob);
+  c.set_pair_maps (accel.pair_maps, accel.num_pair_maps);
 
   kern.apply (&c);
 }
+#endif
 
 
 /*
@@ -246,7 +259,7 @@ _hb_ot_layout_set_glyph_props (hb_font_t *font,
 {
   _hb_buffer_assert_gsubgpos_vars (buffer);
 
-  const OT::GDEF &gdef = *font->face->table.GDEF->table;
+  const OT::GDEF::accelerator_t &gdef = *font->face->table.GDEF;
   unsigned int count = buffer->len;
   for (unsigned int i = 0; i < count; i++)
   {
@@ -429,6 +442,28 @@ get_gsubgpos_table (hb_face_t *face,
   }
 }
 
+static OT::hb_langsys_feature_cache_t *
+get_langsys_feature_cache (hb_face_t *face,
+			   hb_tag_t   table_tag)
+{
+  switch (table_tag) {
+    case HB_OT_TAG_GSUB: return face->table.GSUB->langsys_cache;
+    case HB_OT_TAG_GPOS: return face->table.GPOS->langsys_cache;
+    default:             return nullptr;
+  }
+}
+
+static OT::hb_collect_cache_t *
+get_collect_cache (hb_face_t *face,
+		   hb_tag_t   table_tag)
+{
+  switch (table_tag) {
+    case HB_OT_TAG_GSUB: return face->table.GSUB->collect_cache;
+    case HB_OT_TAG_GPOS: return face->table.GPOS->collect_cache;
+    default:             return nullptr;
+  }
+}
+
 
 /**
  * hb_ot_layout_table_get_script_tags:
@@ -908,6 +943,16 @@ hb_ot_layout_language_find_feature (hb_face_t    *face,
 {
   static_assert ((OT::Index::NOT_FOUND_INDEX == HB_OT_LAYOUT_NO_FEATURE_INDEX), "");
   const OT::GSUBGPOS &g = get_gsubgpos_table (face, table_tag);
+
+  OT::hb_langsys_feature_cache_t *cache = get_langsys_feature_cache (face, table_tag);
+  unsigned int cached_index;
+  if (likely (cache) &&
+      cache->find_feature (g, script_index, language_index, feature_tag, &cached_index))
+  {
+    if (feature_index) *feature_index = cached_index;
+    return cached_index != HB_OT_LAYOUT_NO_FEATURE_INDEX;
+  }
+
   const OT::LangSys &l = g.get_script (script_index).get_lang_sys (language_index);
 
   unsigned int num_features = l.get_feature_count ();
@@ -1108,6 +1153,115 @@ script_collect_features (hb_collect_features_context_t *c,
 }
 
 
+static void
+collect_features (hb_face_t      *face,
+		  hb_tag_t        table_tag,
+		  const hb_tag_t *scripts,
+		  const hb_tag_t *languages,
+		  const hb_tag_t *features,
+		  hb_set_t       *feature_indexes /* OUT */)
+{
+  hb_collect_features_context_t c (face, table_tag, feature_indexes);
+  if (!scripts)
+  {
+    /* All scripts. */
+    unsigned int count = c.g.get_script_count ();
+    for (unsigned int script_index = 0; script_index < count; script_index++)
+      script_collect_features (&c,
+			       c.g.get_script (script_index),
+			       languages,
+			       features);
+  }
+  else
+  {
+    for (; *scripts; scripts++)
+    {
+      unsigned int script_index;
+      if (c.g.find_script_index (*scripts, &script_index))
+	script_collect_features (&c,
+				 c.g.get_script (script_index),
+				 languages,
+				 features);
+    }
+  }
+}
+
+/* Builds what collect_features() finds under all scripts and languages,
+ * for all features and per feature tag, and the features' lookups. */
+static OT::hb_collect_cache_t::features_t *
+create_collect_features (hb_face_t *face,
+			 hb_tag_t   table_tag)
+{
+  typedef OT::hb_collect_cache_t::features_t features_t;
+  features_t *cached = OT::hb_collect_cache_t::create<features_t> ();
+  if (unlikely (!cached))
+    return nullptr;
+
+  const OT::GSUBGPOS &g = get_gsubgpos_table (face, table_tag);
+  collect_features (face, table_tag, nullptr, nullptr, nullptr, &cached->feature_indexes);
+
+  for (hb_codepoint_t feature_index = HB_SET_VALUE_INVALID;
+       cached->feature_indexes.next (&feature_index);)
+  {
+    g.get_feature (feature_index).add_lookup_indexes_to (&cached->lookup_indexes);
+
+    /* A tag only finds the first feature with it in each LangSys, and
+     * never the required feature; redo the walk for each tag. */
+    hb_tag_t tags[2] = {g.get_feature_tag (feature_index), HB_TAG_NONE};
+    if (cached->tags.has (tags[0]))
+      continue;
+    OT::hb_collect_cache_t::features_t::tag_entry_t *entry = cached->tag_entries.push ();
+    if (unlikely (cached->tag_entries.in_error ()))
+      break;
+    entry->init ();
+    cached->tags.set (tags[0], cached->tag_entries.length - 1);
+    collect_features (face, table_tag, nullptr, nullptr, tags, &entry->feature_indexes);
+    for (hb_codepoint_t i = HB_SET_VALUE_INVALID; entry->feature_indexes.next (&i);)
+      g.get_feature (i).add_lookup_indexes_to (&entry->lookup_indexes);
+  }
+
+  if (unlikely (cached->in_error ()))
+  {
+    OT::hb_collect_cache_t::destroy (cached);
+    return nullptr;
+  }
+
+  /* Computed here so that concurrent readers don't race on it. */
+  cached->feature_indexes.get_population ();
+  cached->lookup_indexes.get_population ();
+  for (unsigned int i = 0; i < cached->tag_entries.length; i++)
+  {
+    cached->tag_entries[i].feature_indexes.get_population ();
+    cached->tag_entries[i].lookup_indexes.get_population ();
+  }
+  return cached;
+}
+
+static const OT::hb_collect_cache_t::features_t *
+get_collect_features (hb_face_t *face,
+		      hb_tag_t   table_tag)
+{
+  OT::hb_collect_cache_t *cache = get_collect_cache (face, table_tag);
+  if (unlikely (!cache))
+    return nullptr;
+
+retry:
+  OT::hb_collect_cache_t::features_t *cached = cache->features.get ();
+  if (unlikely (!cached))
+  {
+    cached = create_collect_features (face, table_tag);
+    if (unlikely (!cached))
+      return nullptr;
+    if (unlikely (!cache->features.cmpexch (nullptr, cached)))
+    {
+      OT::hb_collect_cache_t::destroy (cached);
+      goto retry;
+    }
+  }
+  return cached;
+}
+
+
 /**
  * hb_ot_layout_collect_features:
  * @face: #hb_face_t to work upon
@@ -1133,29 +1287,15 @@ hb_ot_layout_collect_features (hb_face_t      *face,
                                const hb_tag_t *features,
                                hb_set_t       *feature_indexes /* OUT */)
 {
-  hb_collect_features_context_t c (face, table_tag, feature_indexes);
-  if (!scripts)
+  const OT::hb_collect_cache_t::features_t *cached;
+  if (!scripts && !languages &&
+      (cached = get_collect_features (face, table_tag)))
   {
-    /* All scripts. */
-    unsigned int count = c.g.get_script_count ();
-    for (unsigned int script_index = 0; script_index < count; script_index++)
-      script_collect_features (&c,
-			       c.g.get_script (script_index),
-			       languages,
-			       features);
-  }
-  else
-  {
-    for (; *scripts; scripts++)
-    {
-      unsigned int script_index;
-      if (c.g.find_script_index (*scripts, &script_index))
-	script_collect_features (&c,
-				 c.g.get_script (script_index),
-				 languages,
-				 features);
-    }
+    cached->collect_features (features, feature_indexes);
+    return;
   }
+
+  collect_features (face, table_tag, scripts, languages, features, feature_indexes);
 }
 
 
@@ -1184,10 +1324,18 @@ hb_ot_layout_collect_lookups (hb_face_t      *face,
 			      const hb_tag_t *features,
 			      hb_set_t       *lookup_indexes /* OUT */)
 {
+  const OT::hb_collect_cache_t::features_t *cached;
+  if (!scripts && !languages &&
+      (cached = get_collect_features (face, table_tag)))
+  {
+    cached->collect_lookups (features, lookup_indexes);
+    return;
+  }
+
   const OT::GSUBGPOS &g = get_gsubgpos_table (face, table_tag);
 
   hb_set_t feature_indexes;
-  hb_ot_layout_collect_features (face, table_tag, scripts, languages, features, &feature_indexes);
+  collect_features (face, table_tag, scripts, languages, features, &feature_indexes);
 
   for (hb_codepoint_t feature_index = HB_SET_VALUE_INVALID;
        hb_set_next (&feature_indexes, &feature_index);)
@@ -1195,6 +1343,100 @@ hb_ot_layout_collect_lookups (hb_face_t      *face,
 }
 
 
+static void
+collect_glyphs (hb_face_t    *face,
+		hb_tag_t      table_tag,
+		unsigned int  lookup_index,
+		hb_set_t     *glyphs_before, /* OUT.  May be NULL */
+		hb_set_t     *glyphs_input,  /* OUT.  May be NULL */
+		hb_set_t     *glyphs_after,  /* OUT.  May be NULL */
+		hb_set_t     *glyphs_output  /* OUT.  May be NULL */)
+{
+  OT::hb_collect_glyphs_context_t c (face,
+				     glyphs_before,
+				     glyphs_input,
+				     glyphs_after,
+				     glyphs_output);
+
+  switch (table_tag)
+  {
+    case HB_OT_TAG_GSUB:
+    {
+      const OT::SubstLookup& l = face->table.GSUB->get_lookup (lookup_index);
+      l.collect_glyphs (&c);
+      return;
+    }
+    case HB_OT_TAG_GPOS:
+    {
+      const OT::PosLookup& l = face->table.GPOS->get_lookup (lookup_index);
+      l.collect_glyphs (&c);
+      return;
+    }
+  }
+}
+
+/* Answers from the glyphs remembered for the lookup, collecting them
+ * first if needed.  Returns false if that failed. */
+static bool
+collect_glyphs_cached (hb_face_t    *face,
+		       hb_tag_t      table_tag,
+		       unsigned int  lookup_index,
+		       hb_set_t     *glyphs_before,
+		       hb_set_t     *glyphs_input,
+		       hb_set_t     *glyphs_after,
+		       hb_set_t     *glyphs_output)
+{
+  typedef OT::hb_collect_cache_t::glyphs_t glyphs_t;
+  OT::hb_collect_cache_t *cache = get_collect_cache (face, table_tag);
+  if (unlikely (!cache || lookup_index >= cache->lookup_count))
+    return false;
+
+  glyphs_t *cached = cache->lookups[lookup_index].get ();
+  bool owned = false;
+  if (unlikely (!cached))
+  {
+    cached = OT::hb_collect_cache_t::create<glyphs_t> ();
+    if (unlikely (!cached))
+      return false;
+    collect_glyphs (face, table_tag, lookup_index,
+		    &cached->before, &cached->input, &cached->after, &cached->output);
+    if (unlikely (cached->in_error ()))
+    {
+      OT::hb_collect_cache_t::destroy (cached);
+      return false;
+    }
+    /* Computed here so that concurrent readers don't race on it. */
+    cached->before.get_population ();
+    cached->input.get_population ();
+    cached->after.get_population ();
+    cached->output.get_population ();
+
+    /* Past the budget, answer this once without keeping it. */
+    int size = cached->size = sizeof (*cached) + cached->get_heap_size ();
+    hb_atomic_int_t &budget = face->collect_glyphs_budget;
+    if (budget.add (-size) < size)
+    {
+      budget.add (size);
+      owned = true;
+    }
+    else if (unlikely (!cache->lookups[lookup_index].cmpexch (nullptr, cached)))
+    {
+      /* Lost the race; use ours this once. */
+      budget.add (size);
+      owned = true;
+    }
+  }
+
+  if (glyphs_before) glyphs_before->union_ (&cached->before);
+  if (glyphs_input)  glyphs_input->union_ (&cached->input);
+  if (glyphs_after)  glyphs_after->union_ (&cached->after);
+  if (glyphs_output) glyphs_output->union_ (&cached->output);
+
+  if (owned)
+    OT::hb_collect_cache_t::destroy (cached);
+  return true;
+}
+
 /**
  * hb_ot_layout_lookup_collect_glyphs:
  * @face: #hb_face_t to work upon
@@ -1219,27 +1461,12 @@ hb_ot_layout_lookup_collect_glyphs (hb_face_t    *face,
 				    hb_set_t     *glyphs_after,  /* OUT.  May be NULL */
 				    hb_set_t     *glyphs_output  /* OUT.  May be NULL */)
 {
-  OT::hb_collect_glyphs_context_t c (face,
-				     glyphs_before,
-				     glyphs_input,
-				     glyphs_after,
-				     glyphs_output);
+  if (collect_glyphs_cached (face, table_tag, lookup_index,
+			    glyphs_before, glyphs_input, glyphs_after, glyphs_output))
+    return;
 
-  switch (table_tag)
-  {
-    case HB_OT_TAG_GSUB:
-    {
-      const OT::SubstLookup& l = face->table.GSUB->table->get_lookup (lookup_index);
-      l.collect_glyphs (&c);
-      return;
-    }
-    case HB_OT_TAG_GPOS:
-    {
-      const OT::PosLookup& l = face->table.GPOS->table->get_lookup (lookup_index);
-      l.collect_glyphs (&c);
-      return;
-    }
-  }
+  collect_glyphs (face, table_tag, lookup_index,
+		  glyphs_before, glyphs_input, glyphs_after, glyphs_output);
 }
 
 
@@ -1326,6 +1553,25 @@ hb_ot_layout_has_substitution (hb_face_t *face)
 }
 
 
+static OT::hb_would_apply_cache_t *
+get_would_apply_cache (const OT::GSUB_accelerator_t &gsub)
+{
+retry:
+  OT::hb_would_apply_cache_t *cache = gsub.would_apply_cache.get ();
+  if (unlikely (!cache))
+  {
+    cache = OT::hb_collect_cache_t::create<OT::hb_would_apply_cache_t> ();
+    if (unlikely (!cache))
+      return nullptr;
+    if (unlikely (!const_cast<OT::GSUB_accelerator_t &> (gsub).would_apply_cache.cmpexch (nullptr, cache)))
+    {
+      OT::hb_collect_cache_t::destroy (cache);
+      goto retry;
+    }
+  }
+  return cache;
+}
+
 /**
  * hb_ot_layout_lookup_would_substitute:
  * @face: #hb_face_t to work upon
@@ -1348,12 +1594,25 @@ hb_ot_layout_lookup_would_substitute (hb_face_t            *face,
 				      unsigned int          glyphs_length,
 				      hb_bool_t             zero_context)
 {
-  if (unlikely (lookup_index >= face->table.GSUB->lookup_count)) return false;
+  const OT::GSUB_accelerator_t &gsub = *face->table.GSUB;
+  const OT::hb_ot_layout_lookup_accelerator_t *accel = gsub.get_accel (lookup_index);
+  if (unlikely (!accel)) return false;
+  /* The digest rules most probes out more cheaply than the cache could. */
+  if (unlikely (!glyphs_length) || !accel->may_have (glyphs[0])) return false;
+
+  OT::hb_would_apply_cache_t *cache = get_would_apply_cache (gsub);
+  bool ret;
+  if (cache && cache->get (lookup_index, glyphs, glyphs_length, zero_context, &ret))
+    return ret;
+
   OT::hb_would_apply_context_t c (face, glyphs, glyphs_length, (bool) zero_context);
 
-  const OT::SubstLookup& l = face->table.GSUB->table->get_lookup (lookup_index);
+  const OT::SubstLookup& l = gsub.get_lookup (lookup_index);
 
-  return l.would_apply (&c, &face->table.GSUB->accels[lookup_index]);
+  ret = l.would_apply (&c, accel);
+  if (cache)
+    cache->set (lookup_index, glyphs, glyphs_length, zero_context, ret);
+  return ret;
 }
 
 
@@ -1373,56 +1632,6 @@ hb_ot_layout_substitute_start (hb_font_t    *font,
 _hb_ot_layout_set_glyph_props (font, buffer);
 }
 
-void
-hb_ot_layout_delete_glyphs_inplace (hb_buffer_t *buffer,
-				    bool (*filter) (const hb_glyph_info_t *info))
-{
-  /* Merge clusters and delete filtered glyphs.
-   * NOTE! We can't use out-buffer as we have positioning data. */
-  unsigned int j = 0;
-  unsigned int count = buffer->len;
-  hb_glyph_info_t *info = buffer->info;
-  hb_glyph_position_t *pos = buffer->pos;
-  for (unsigned int i = 0; i < count; i++)
-  {
-    if (filter (&info[i]))
-    {
-      /* Merge clusters.
-       * Same logic as buffer->delete_glyph(), but for in-place removal. */
-
-      unsigned int cluster = info[i].cluster;
-      if (i + 1 < count && cluster == info[i + 1].cluster)
-	continue; /* Cluster survives; do nothing. */
-
-      if (j)
-      {
-	/* Merge cluster backward. */
-	if (cluster < info[j - 1].cluster)
-	{
-	  unsigned int mask = info[i].mask;
-	  unsigned int old_cluster = info[j - 1].cluster;
-	  for (unsigned k = j; k && info[k - 1].cluster == old_cluster; k--)
-	    buffer->set_cluster (info[k - 1], cluster, mask);
-	}
-	continue;
-      }
-
-      if (i + 1 < count)
-	buffer->merge_clusters (i, i + 2); /* Merge cluster forward. */
-
-      continue;
-    }
-
-    if (j != i)
-    {
-      info[j] = info[i];
-      pos[j] = pos[i];
-    }
-    j++;
-  }
-  buffer->len = j;
-}
-
 /**
  * hb_ot_layout_lookup_substitute_closure:
  * @face: #hb_face_t to work upon
@@ -1439,10 +1648,10 @@ hb_ot_layout_lookup_substitute_closure (hb_face_t    *face,
 				        unsigned int  lookup_index,
 				        hb_set_t     *glyphs /* OUT */)
 {
-  hb_map_t done_lookups;
+  OT::hb_closure_done_lookups_t done_lookups;
   OT::hb_closure_context_t c (face, glyphs, &done_lookups);
 
-  const OT::SubstLookup& l = face->table.GSUB->table->get_lookup (lookup_index);
+  const OT::SubstLookup& l = face->table.GSUB->get_lookup (lookup_index);
 
   l.closure (&c, lookup_index);
 }
@@ -1463,27 +1672,180 @@ hb_ot_layout_lookups_substitute_closure (hb_face_t      *face,
                                          const hb_set_t *lookups,
                                          hb_set_t       *glyphs /* OUT */)
 {
-  hb_map_t done_lookups;
-  OT::hb_closure_context_t c (face, glyphs, &done_lookups);
-  const OT::GSUB& gsub = *face->table.GSUB->table;
+  hb_ot_layout_lookups_substitute_closure_count (face, lookups, glyphs);
+}
 
-  unsigned int iteration_count = 0;
-  unsigned int glyphs_length;
-  do
+/**
+ * hb_ot_layout_lookups_substitute_closure_parallel:
+ * @face: #hb_face_t to work upon
+ * @lookups: The set of lookups to query
+ * @glyphs: (out): Array of glyphs comprising the transitive closure of the lookups
+ * @executor: (nullable): executor to run the closure on, or %NULL
+ * @user_data: data to pass to @executor
+ *
+ * Like hb_ot_layout_lookups_substitute_closure(), but each pass over the
+ * lookups is split into jobs over groups of lookups, run through @executor,
+ * for example on a thread pool.  Each job works on its own copy of the
+ * glyphs from the end of the previous pass; the copies are merged between
+ * passes.  The result is the same as with
+ * hb_ot_layout_lookups_substitute_closure().  With a %NULL @executor the
+ * closure is computed on the calling thread.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_ot_layout_lookups_substitute_closure_parallel (hb_face_t          *face,
+						  const hb_set_t     *lookups,
+						  hb_set_t           *glyphs /* OUT */,
+						  hb_executor_func_t  executor,
+						  void               *user_data)
+{
+  hb_ot_layout_lookups_substitute_closure_count (face, lookups, glyphs, executor, user_data);
+}
+
+/* Lookups per job of a parallel closure pass; lookups differ a lot in
+ * cost, so keep groups small enough to spread the big ones around. */
+#ifndef HB_CLOSURE_JOB_LOOKUPS
+#define HB_CLOSURE_JOB_LOOKUPS 8
+#endif
+
+struct hb_closure_jobs_t
+{
+  hb_face_t *face;
+  hb_vector_t<unsigned int> lookups;
+  hb_vector_t<hb_set_t> glyphs; /* One per job. */
+  /* One per job; a job always gets the same lookups, and its glyphs only
+   * grow, so these stay valid across passes. */
+  hb_vector_t<OT::hb_closure_done_lookups_t> done_lookups;
+
+  static void run (unsigned int index, void *job_data)
+  {
+    hb_closure_jobs_t *c = (hb_closure_jobs_t *) job_data;
+    const OT::GSUB_accelerator_t &gsub = *c->face->table.GSUB;
+    unsigned int start = index * HB_CLOSURE_JOB_LOOKUPS;
+    unsigned int end = hb_min (c->lookups.length, start + HB_CLOSURE_JOB_LOOKUPS);
+
+    OT::hb_closure_context_t cc (c->face, &c->glyphs[index], &c->done_lookups[index]);
+    for (unsigned int i = start; i < end; i++)
+      gsub.get_lookup (c->lookups[i]).closure (&cc, c->lookups[i]);
+  }
+};
+
+/* Runs closure passes through executor until the glyphs stop changing.
+ * Returns false if it couldn't get going, leaving glyphs alone. */
+static bool
+_hb_ot_layout_lookups_substitute_closure_jobs (hb_face_t          *face,
+					       const hb_set_t     *lookups,
+					       hb_set_t           *glyphs,
+					       hb_executor_func_t  executor,
+					       void               *user_data,
+					       unsigned int       *iteration_count)
+{
+  const OT::GSUB_accelerator_t &gsub = *face->table.GSUB;
+
+  hb_closure_jobs_t c;
+  c.face = face;
+  c.lookups.init ();
+  c.glyphs.init ();
+  c.done_lookups.init ();
+  if (lookups != nullptr)
+  {
+    for (hb_codepoint_t lookup_index = HB_SET_VALUE_INVALID; hb_set_next (lookups, &lookup_index);)
+      c.lookups.push (lookup_index);
+  }
+  else
+  {
+    for (unsigned int i = 0; i < gsub.lookup_count; i++)
+      c.lookups.push (i);
+  }
+
+  unsigned int count = (c.lookups.length + HB_CLOSURE_JOB_LOOKUPS - 1) / HB_CLOSURE_JOB_LOOKUPS;
+  bool ret = false;
+  if (count > 1 && likely (!c.lookups.in_error () &&
+			    c.glyphs.resize (count) &&
+			    c.done_lookups.resize (count)))
   {
-    glyphs_length = glyphs->get_population ();
-    if (lookups != nullptr)
+    for (unsigned int i = 0; i < count; i++)
     {
-      for (hb_codepoint_t lookup_index = HB_SET_VALUE_INVALID; hb_set_next (lookups, &lookup_index);)
-        gsub.get_lookup (lookup_index).closure (&c, lookup_index);
+      c.glyphs[i].init_shallow ();
+      c.done_lookups[i].init ();
     }
-    else
+
+    unsigned int glyphs_length;
+    do
+    {
+      glyphs_length = glyphs->get_population ();
+      /* Copy here rather than in the jobs; reading glyphs concurrently
+       * would race on its cached population. */
+      for (unsigned int i = 0; i < count; i++)
+	c.glyphs[i].set (glyphs);
+      executor (count, hb_closure_jobs_t::run, &c, user_data);
+      for (unsigned int i = 0; i < count; i++)
+	glyphs->union_ (&c.glyphs[i]);
+    } while ((*iteration_count)++ <= HB_CLOSURE_MAX_STAGES &&
+	     glyphs_length != glyphs->get_population ());
+
+    for (unsigned int i = 0; i < count; i++)
     {
-      for (unsigned int i = 0; i < gsub.get_lookup_count (); i++)
-        gsub.get_lookup (i).closure (&c, i);
+      c.glyphs[i].fini_shallow ();
+      c.done_lookups[i].fini ();
     }
-  } while (iteration_count++ <= HB_CLOSURE_MAX_STAGES &&
-	   glyphs_length != glyphs->get_population ());
+    ret = true;
+  }
+
+  c.done_lookups.fini ();
+  c.glyphs.fini ();
+  c.lookups.fini ();
+  return ret;
+}
+
+unsigned int
+hb_ot_layout_lookups_substitute_closure_count (hb_face_t          *face,
+					      const hb_set_t     *lookups,
+					      hb_set_t           *glyphs /* OUT */,
+					      hb_executor_func_t  executor,
+					      void               *user_data)
+{
+  OT::hb_closure_cache_t *cache = face->table.GSUB->closure_cache;
+  hb_set_t input;
+  if (cache)
+  {
+    input.set (glyphs);
+    cache->seed (lookups, glyphs);
+  }
+
+  unsigned int iteration_count = 0;
+  if (!executor ||
+      !_hb_ot_layout_lookups_substitute_closure_jobs (face, lookups, glyphs,
+						      executor, user_data,
+						      &iteration_count))
+  {
+    OT::hb_closure_done_lookups_t done_lookups;
+    OT::hb_closure_context_t c (face, glyphs, &done_lookups);
+    const OT::GSUB_accelerator_t &gsub = *face->table.GSUB;
+
+    unsigned int glyphs_length;
+    do
+    {
+      glyphs_length = glyphs->get_population ();
+      if (lookups != nullptr)
+      {
+	for (hb_codepoint_t lookup_index = HB_SET_VALUE_INVALID; hb_set_next (lookups, &lookup_index);)
+	  gsub.get_lookup (lookup_index).closure (&c, lookup_index);
+      }
+      else
+      {
+	for (unsigned int i = 0; i < gsub.lookup_count; i++)
+	  gsub.get_lookup (i).closure (&c, i);
+      }
+    } while (iteration_count++ <= HB_CLOSURE_MAX_STAGES &&
+	     glyphs_length != glyphs->get_population ());
+  }
+
+  if (cache && likely (!input.in_error () && !glyphs->in_error ()))
+    cache->store (lookups, &input, glyphs);
+
+  return iteration_count;
 }
 
 /*
@@ -1548,6 +1910,82 @@ hb_ot_layout_position_finish_offsets (hb_font_t *font, hb_buffer_t *buffer)
   OT::GPOS::position_finish_offsets (font, buffer);
 }
 
+hb_ot_anchor_cache_t *
+hb_ot_layout_get_anchor_cache (hb_font_t *font)
+{
+retry:
+  hb_ot_anchor_cache_t *cache = font->anchor_cache.get ();
+  if (unlikely (!cache))
+  {
+    if (unlikely (hb_object_is_inert (font)))
+      return nullptr;
+
+    cache = (hb_ot_anchor_cache_t *) calloc (1, sizeof (hb_ot_anchor_cache_t));
+    if (unlikely (!cache))
+      return nullptr;
+    cache->lock.init ();
+
+    if (unlikely (!font->anchor_cache.cmpexch (nullptr, cache)))
+    {
+      _hb_ot_anchor_cache_destroy (cache);
+      goto retry;
+    }
+  }
+  return cache;
+}
+
+void
+_hb_ot_anchor_cache_destroy (hb_ot_anchor_cache_t *cache)
+{
+  if (!cache) return;
+  cache->lock.fini ();
+  free (cache);
+}
+
+unsigned int
+_hb_ot_anchor_cache_get_memory_usage (hb_ot_anchor_cache_t *cache)
+{
+  return cache ? sizeof (*cache) : 0;
+}
+
+hb_ot_device_cache_t *
+hb_ot_layout_get_device_cache (hb_font_t *font)
+{
+retry:
+  hb_ot_device_cache_t *cache = font->device_cache.get ();
+  if (unlikely (!cache))
+  {
+    if (unlikely (hb_object_is_inert (font)))
+      return nullptr;
+
+    cache = (hb_ot_device_cache_t *) calloc (1, sizeof (hb_ot_device_cache_t));
+    if (unlikely (!cache))
+      return nullptr;
+    cache->lock.init ();
+
+    if (unlikely (!font->device_cache.cmpexch (nullptr, cache)))
+    {
+      _hb_ot_device_cache_destroy (cache);
+      goto retry;
+    }
+  }
+  return cache;
+}
+
+void
+_hb_ot_device_cache_destroy (hb_ot_device_cache_t *cache)
+{
+  if (!cache) return;
+  cache->lock.fini ();
+  free (cache);
+}
+
+unsigned int
+_hb_ot_device_cache_get_memory_usage (hb_ot_device_cache_t *cache)
+{
+  return cache ? sizeof (*cache) : 0;
+}
+
 
 /**
  * hb_ot_layout_get_size_params:
@@ -1757,11 +2195,9 @@ struct GSUBProxy
   typedef OT::SubstLookup Lookup;
 
   GSUBProxy (hb_face_t *face) :
-    table (*face->table.GSUB->table),
-    accels (face->table.GSUB->accels) {}
+    accel (*face->table.GSUB) {}
 
-  const OT::GSUB &table;
-  const OT::hb_ot_layout_lookup_accelerator_t *accels;
+  const OT::GSUB_accelerator_t &accel;
 };
 
 struct GPOSProxy
@@ -1771,29 +2207,46 @@ struct GPOSProxy
   typedef OT::PosLookup Lookup;
 
   GPOSProxy (hb_face_t *face) :
-    table (*face->table.GPOS->table),
-    accels (face->table.GPOS->accels) {}
+    accel (*face->table.GPOS) {}
 
-  const OT::GPOS &table;
-  const OT::hb_ot_layout_lookup_accelerator_t *accels;
+  const OT::GPOS_accelerator_t &accel;
 };
 
 
+/* With counted, also tally attempts and applies into stats; see
+ * hb_ot_shape_plan_enable_lookup_stats(). */
+template <bool counted>
 static inline bool
 apply_forward (OT::hb_ot_apply_context_t *c,
-	       const OT::hb_ot_layout_lookup_accelerator_t &accel)
+	       const OT::hb_ot_layout_lookup_accelerator_t &accel,
+	       hb_ot_lookup_stats_t *stats)
 {
   bool ret = false;
   hb_buffer_t *buffer = c->buffer;
   while (buffer->idx < buffer->len && buffer->successful)
   {
-    bool applied = false;
-    if (accel.may_have (buffer->cur().codepoint) &&
-	(buffer->cur().mask & c->lookup_mask) &&
-	c->check_glyph_property (&buffer->cur(), c->lookup_props))
-     {
-       applied = accel.apply (c);
-     }
+    /* Find the next glyph the lookup may apply to first, and pass over
+     * the ones before it in one go, instead of testing and copying them
+     * to the output one at a time between attempts. */
+    const hb_glyph_info_t *info = buffer->info;
+    unsigned int start = buffer->idx, end = start, len = buffer->len;
+    while (end < len &&
+	   !(accel.may_have (info[end].codepoint) &&
+	     (info[end].mask & c->lookup_mask) &&
+	     c->check_glyph_property (&info[end], c->lookup_props)))
+      end++;
+    if (end > start)
+    {
+      buffer->next_glyphs (end - start);
+      continue;
+    }
+
+    bool applied = accel.apply (c);
+    if (counted)
+    {
+      stats->attempts++;
+      stats->applies += applied;
+    }
 
     if (applied)
       ret = true;
@@ -1803,49 +2256,110 @@ apply_forward (OT::hb_ot_apply_context_t *c,
   return ret;
 }
 
+template <bool counted>
 static inline bool
 apply_backward (OT::hb_ot_apply_context_t *c,
-	       const OT::hb_ot_layout_lookup_accelerator_t &accel)
+	       const OT::hb_ot_layout_lookup_accelerator_t &accel,
+	       hb_ot_lookup_stats_t *stats)
 {
   bool ret = false;
   hb_buffer_t *buffer = c->buffer;
-  do
+  const hb_glyph_info_t *info = buffer->info;
+  int i = (int) buffer->idx;
+  while (true)
   {
-    if (accel.may_have (buffer->cur().codepoint) &&
-	(buffer->cur().mask & c->lookup_mask) &&
-	c->check_glyph_property (&buffer->cur(), c->lookup_props))
-     ret |= accel.apply (c);
+    /* As in apply_forward(), find the next glyph the lookup may apply
+     * to first. */
+    while (i >= 0 &&
+	   !(accel.may_have (info[i].codepoint) &&
+	     (info[i].mask & c->lookup_mask) &&
+	     c->check_glyph_property (&info[i], c->lookup_props)))
+      i--;
+    if (i < 0)
+      break;
+
+    buffer->idx = i;
+    bool applied = accel.apply (c);
+    if (counted)
+    {
+      stats->attempts++;
+      stats->applies += applied;
+    }
+    ret |= applied;
 
     /* The reverse lookup doesn't "advance" cursor (for good reason). */
-    buffer->idx--;
+    i--;
+  }
+  buffer->idx = (unsigned int) -1;
+  return ret;
+}
 
+/* Replaces glyphs in place, without the output buffer or going through the
+ * apply context for each glyph. */
+template <bool counted>
+static inline bool
+apply_single (OT::hb_ot_apply_context_t *c,
+	      const OT::hb_ot_layout_lookup_accelerator_t &accel,
+	      hb_ot_lookup_stats_t *stats)
+{
+  bool ret = false;
+  hb_buffer_t *buffer = c->buffer;
+  hb_glyph_info_t *info = buffer->info;
+  unsigned int count = buffer->len;
+  for (buffer->idx = 0; buffer->idx < count; buffer->idx++)
+  {
+    hb_codepoint_t substitute;
+    if (accel.may_have (info[buffer->idx].codepoint) &&
+	(info[buffer->idx].mask & c->lookup_mask) &&
+	c->check_glyph_property (&info[buffer->idx], c->lookup_props))
+    {
+      if (counted)
+	stats->attempts++;
+      if (accel.substitute (info[buffer->idx].codepoint, &substitute, c->face))
+      {
+	if (counted)
+	  stats->applies++;
+	c->replace_glyph_inplace (substitute);
+	ret = true;
+      }
+    }
   }
-  while ((int) buffer->idx >= 0);
   return ret;
 }
 
-template <typename Proxy>
-static inline void
+/* Returns whether the lookup applied anywhere; if not, the buffer glyphs
+ * are unchanged. */
+template <typename Proxy, bool counted = false>
+static inline bool
 apply_string (OT::hb_ot_apply_context_t *c,
 	      const typename Proxy::Lookup &lookup,
-	      const OT::hb_ot_layout_lookup_accelerator_t &accel)
+	      const OT::hb_ot_layout_lookup_accelerator_t &accel,
+	      hb_ot_lookup_stats_t *stats = nullptr)
 {
   hb_buffer_t *buffer = c->buffer;
+  bool ret;
 
   if (unlikely (!buffer->len || !c->lookup_mask))
-    return;
+    return false;
 
   c->set_lookup_props (lookup.get_props ());
 
-  if (likely (!lookup.is_reverse ()))
+  accel.ensure_bitmap (lookup, c->face->lookup_bitmap_budget);
+
+  if (Proxy::table_index == 0u && accel.is_single ())
+  {
+    /* in-place single substitution */
+    buffer->remove_output ();
+    ret = apply_single<counted> (c, accel, stats);
+  }
+  else if (likely (!lookup.is_reverse ()))
   {
     /* in/out forward substitution/positioning */
     if (Proxy::table_index == 0u)
       buffer->clear_output ();
     buffer->idx = 0;
 
-    bool ret;
-    ret = apply_forward (c, accel);
+    ret = apply_forward<counted> (c, accel, stats);
     if (ret)
     {
       if (!Proxy::inplace)
@@ -1861,8 +2375,79 @@ apply_string (OT::hb_ot_apply_context_t *c,
       buffer->remove_output ();
     buffer->idx = buffer->len - 1;
 
-    apply_backward (c, accel);
+    ret = apply_backward<counted> (c, accel, stats);
   }
+  return ret;
+}
+
+/* Union of the masks of all glyphs.  Lookups don't add mask bits, so this
+ * stays a superset until the next pause. */
+static inline hb_mask_t
+_hb_buffer_get_mask_union (const hb_buffer_t *buffer)
+{
+  hb_mask_t mask = 0;
+  const hb_glyph_info_t *info = buffer->info;
+  unsigned int count = buffer->len;
+  for (unsigned int i = 0; i < count; i++)
+    mask |= info[i].mask;
+  return mask;
+}
+
+#ifndef HB_OT_LAYOUT_BUFFER_DIGEST_MAX_LEN
+/* Digesting a buffer costs about as much as walking it for a few lookups;
+ * longer buffers, and buffers shaped with fewer lookups, are only walked. */
+#define HB_OT_LAYOUT_BUFFER_DIGEST_MAX_LEN 64
+#endif
+#ifndef HB_OT_LAYOUT_BUFFER_DIGEST_MIN_LOOKUPS
+#define HB_OT_LAYOUT_BUFFER_DIGEST_MIN_LOOKUPS 16
+#endif
+
+/* Digest of the glyphs, for skipping lookups that cover none of them.  It
+ * stays valid until a substitution applies.  Returns false, leaving no
+ * digest, if the buffer is too long to be worth it. */
+static inline bool
+_hb_buffer_get_digest (const hb_buffer_t *buffer,
+		       hb_set_digest_adaptive_t::builder_t *digest)
+{
+  unsigned int count = buffer->len;
+  if (count > HB_OT_LAYOUT_BUFFER_DIGEST_MAX_LEN)
+    return false;
+
+  digest->init ();
+  const hb_glyph_info_t *info = buffer->info;
+  for (unsigned int i = 0; i < count; i++)
+    digest->add (info[i].codepoint);
+  return true;
+}
+
+template <typename Proxy>
+inline void hb_ot_map_t::compile_lookups (const Proxy &proxy)
+{
+  const unsigned int table_index = proxy.table_index;
+  const hb_vector_t<lookup_map_t> &lookup_maps = lookups[table_index];
+  if (unlikely (!compiled[table_index].resize (lookup_maps.length)))
+    return;
+  for (unsigned int i = 0; i < lookup_maps.length; i++)
+  {
+    const lookup_map_t &lookup_map = lookup_maps[i];
+    compiled_lookup_t &lookup = compiled[table_index][i];
+    lookup.lookup = &proxy.accel.get_lookup (lookup_map.index);
+    lookup.accel = proxy.accel.get_accel (lookup_map.index);
+    /* Lookups that failed sanitizing never match. */
+    lookup.mask = lookup.accel ? lookup_map.mask : 0;
+    lookup.index = lookup_map.index;
+    lookup.auto_zwnj = lookup_map.auto_zwnj;
+    lookup.auto_zwj = lookup_map.auto_zwj;
+    lookup.random = lookup_map.random;
+  }
+}
+
+void hb_ot_map_t::compile_lookups (hb_face_t *face)
+{
+  if (lookups[0].length)
+    compile_lookups (GSUBProxy (face));
+  if (lookups[1].length)
+    compile_lookups (GPOSProxy (face));
 }
 
 template <typename Proxy>
@@ -1876,31 +2461,83 @@ inline void hb_ot_map_t::apply (const Proxy &proxy,
   OT::hb_ot_apply_context_t c (table_index, font, buffer);
   c.set_recurse_func (Proxy::Lookup::apply_recurse_func);
 
+  /* Shapers like Indic and USE set feature masks per syllable, so many
+   * lookups only apply to a few syllables, or none at all in a given run.
+   * Skip the ones whose mask no glyph carries.  Likewise, for short runs
+   * skip the lookups that cover none of the glyphs without walking the
+   * buffer; fonts with hundreds of lookups spend most of their time there. */
+  hb_mask_t buffer_mask = _hb_buffer_get_mask_union (buffer);
+
+  /* If compiling failed to allocate, only the pauses run. */
+  const compiled_lookup_t *lookup = compiled[table_index].arrayZ ();
+  unsigned int num_lookups = compiled[table_index].length;
+  hb_ot_lookup_stats_t *lookup_stats = stats[table_index];
+
+  /* Built when first needed, and again after substitutions or pauses. */
+  hb_set_digest_adaptive_t::builder_t buffer_digest;
+  bool use_digest = num_lookups >= HB_OT_LAYOUT_BUFFER_DIGEST_MIN_LOOKUPS;
+  bool digest_stale = true;
+
   for (unsigned int stage_index = 0; stage_index < stages[table_index].length; stage_index++) {
     const stage_map_t *stage = &stages[table_index][stage_index];
-    for (; i < stage->last_lookup; i++)
+    for (unsigned int end = hb_min (stage->last_lookup, num_lookups); i < end; i++)
     {
-      unsigned int lookup_index = lookups[table_index][i].index;
+      unsigned int lookup_index = lookup[i].index;
       if (!buffer->message (font, "start lookup %d", lookup_index)) continue;
+      hb_buffer_trace_scope_t trace (buffer, font, HB_BUFFER_TRACE_EVENT_TYPE_LOOKUP,
+				     table_index ? HB_OT_TAG_GPOS : HB_OT_TAG_GSUB,
+				     lookup_index);
       c.set_lookup_index (lookup_index);
-      c.set_lookup_mask (lookups[table_index][i].mask);
-      c.set_auto_zwj (lookups[table_index][i].auto_zwj);
-      c.set_auto_zwnj (lookups[table_index][i].auto_zwnj);
-      if (lookups[table_index][i].random)
+      c.set_lookup_mask (lookup[i].mask);
+      c.set_auto_zwj (lookup[i].auto_zwj);
+      c.set_auto_zwnj (lookup[i].auto_zwnj);
+      if (lookup[i].random)
       {
 	c.set_random (true);
 	buffer->unsafe_to_break_all ();
       }
-      apply_string<Proxy> (&c,
-			   proxy.table.get_lookup (lookup_index),
-			   proxy.accels[lookup_index]);
+      bool skip = !(lookup[i].mask & buffer_mask);
+      if (!skip && use_digest)
+      {
+	if (digest_stale)
+	{
+	  use_digest = _hb_buffer_get_digest (buffer, &buffer_digest);
+	  digest_stale = false;
+	}
+	skip = use_digest && !lookup[i].accel->may_intersect (buffer_digest);
+      }
+      if (!skip)
+      {
+	/* With a caller budget, walking the buffer is charged too. */
+	if (unlikely (buffer->max_ops_budget) &&
+	    (buffer->max_ops -= buffer->len) <= 0)
+	  return;
+
+	const typename Proxy::Lookup &l = *static_cast<const typename Proxy::Lookup *> (lookup[i].lookup);
+	bool applied;
+	if (likely (!lookup_stats))
+	  applied = apply_string<Proxy> (&c, l, *lookup[i].accel);
+	else
+	{
+	  uint64_t start_time = _hb_trace_now ();
+	  applied = apply_string<Proxy, true> (&c, l, *lookup[i].accel, &lookup_stats[i]);
+	  lookup_stats[i].time += _hb_trace_now () - start_time;
+	  lookup_stats[i].runs++;
+	}
+	if (applied && !Proxy::inplace)
+	  digest_stale = true;
+      }
       (void) buffer->message (font, "end lookup %d", lookup_index);
     }
+    i = stage->last_lookup;
 
     if (stage->pause_func)
     {
       buffer->clear_output ();
       stage->pause_func (plan, font, buffer);
+      buffer_mask = _hb_buffer_get_mask_union (buffer);
+      use_digest = num_lookups >= HB_OT_LAYOUT_BUFFER_DIGEST_MIN_LOOKUPS;
+      digest_stale = true;
     }
   }
 }
@@ -342,6 +342,13 @@ hb_ot_layout_lookups_substitute_closure (hb_face_t      *face,
                                          const hb_set_t *lookups,
                                          hb_set_t       *glyphs);
 
+HB_EXTERN void
+hb_ot_layout_lookups_substitute_closure_parallel (hb_face_t          *face,
+						  const hb_set_t     *lookups,
+						  hb_set_t           *glyphs,
+						  hb_executor_func_t  executor,
+						  void               *user_data);
+
 
 #ifdef HB_NOT_IMPLEMENTED
 /* Note: You better have GDEF when using this API, or marks won't do much. */
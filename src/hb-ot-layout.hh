@@ -68,6 +68,15 @@ hb_ot_layout_table_find_feature (hb_face_t    *face,
 				 hb_tag_t      feature_tag,
 				 unsigned int *feature_index);
 
+/* Same as hb_ot_layout_lookups_substitute_closure_parallel(); returns the
+ * number of passes over the lookups it took to reach a fixed point. */
+HB_INTERNAL unsigned int
+hb_ot_layout_lookups_substitute_closure_count (hb_face_t          *face,
+					      const hb_set_t     *lookups,
+					      hb_set_t           *glyphs /* OUT */,
+					      hb_executor_func_t  executor = nullptr,
+					      void               *user_data = nullptr);
+
 
 /*
  * GDEF
@@ -102,9 +111,60 @@ HB_INTERNAL void
 hb_ot_layout_substitute_start (hb_font_t    *font,
 			       hb_buffer_t  *buffer);
 
-HB_INTERNAL void
+/* Deletes the glyphs @filter returns true for, merging their clusters
+ * into their neighbours'.  @filter is called once per glyph, in order, on
+ * a non-const hb_glyph_info_t, so that it may also rewrite glyphs it
+ * keeps; callers use that to fuse their own pass into this one. */
+template <typename Filter>
+static inline void
 hb_ot_layout_delete_glyphs_inplace (hb_buffer_t *buffer,
-				    bool (*filter) (const hb_glyph_info_t *info));
+				    Filter       filter)
+{
+  /* Merge clusters and delete filtered glyphs.
+   * NOTE! We can't use out-buffer as we have positioning data. */
+  unsigned int j = 0;
+  unsigned int count = buffer->len;
+  hb_glyph_info_t *info = buffer->info;
+  hb_glyph_position_t *pos = buffer->pos;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    if (filter (info[i]))
+    {
+      /* Merge clusters.
+       * Same logic as buffer->delete_glyph(), but for in-place removal. */
+
+      unsigned int cluster = info[i].cluster;
+      if (i + 1 < count && cluster == info[i + 1].cluster)
+	continue; /* Cluster survives; do nothing. */
+
+      if (j)
+      {
+	/* Merge cluster backward. */
+	if (cluster < info[j - 1].cluster)
+	{
+	  unsigned int mask = info[i].mask;
+	  unsigned int old_cluster = info[j - 1].cluster;
+	  for (unsigned k = j; k && info[k - 1].cluster == old_cluster; k--)
+	    buffer->set_cluster (info[k - 1], cluster, mask);
+	}
+	continue;
+      }
+
+      if (i + 1 < count)
+	buffer->merge_clusters (i, i + 2); /* Merge cluster forward. */
+
+      continue;
+    }
+
+    if (j != i)
+    {
+      info[j] = info[i];
+      pos[j] = pos[i];
+    }
+    j++;
+  }
+  buffer->len = j;
+}
 
 namespace OT {
   struct hb_ot_apply_context_t;
@@ -133,6 +193,117 @@ HB_INTERNAL void
 hb_ot_layout_position_finish_offsets (hb_font_t    *font,
 				      hb_buffer_t  *buffer);
 
+#ifndef HB_OT_ANCHOR_CACHE_SIZE
+#define HB_OT_ANCHOR_CACHE_SIZE 256
+#endif
+
+/* Positions of GPOS anchors that need Device or VariationDevice deltas,
+ * keyed by anchor; emptied whenever the font serial changes. */
+struct hb_ot_anchor_cache_t
+{
+  struct entry_t
+  {
+    const void *anchor;
+    float x, y;
+  };
+
+  static unsigned int bucket (const void *anchor)
+  {
+    unsigned int h = (unsigned int) ((uintptr_t) anchor >> 1) * 2654435761u;
+    return (h >> 16) % HB_OT_ANCHOR_CACHE_SIZE;
+  }
+
+  bool get (unsigned int font_serial, const void *anchor, float *x, float *y)
+  {
+    hb_lock_t l (lock);
+    const entry_t &e = entries[bucket (anchor)];
+    if (serial != font_serial || e.anchor != anchor)
+      return false;
+    *x = e.x;
+    *y = e.y;
+    return true;
+  }
+
+  void set (unsigned int font_serial, const void *anchor, float x, float y)
+  {
+    hb_lock_t l (lock);
+    if (serial != font_serial)
+    {
+      memset (entries, 0, sizeof (entries));
+      serial = font_serial;
+    }
+    entry_t &e = entries[bucket (anchor)];
+    e.anchor = anchor;
+    e.x = x;
+    e.y = y;
+  }
+
+  hb_mutex_t lock;
+  unsigned int serial;
+  entry_t entries[HB_OT_ANCHOR_CACHE_SIZE];
+};
+
+/* Creates the anchor cache of font on first use; nullptr if that fails. */
+HB_INTERNAL hb_ot_anchor_cache_t *
+hb_ot_layout_get_anchor_cache (hb_font_t *font);
+
+#ifndef HB_OT_DEVICE_CACHE_SIZE
+#define HB_OT_DEVICE_CACHE_SIZE 256
+#endif
+
+/* Deltas of GPOS value-record Device and VariationDevice tables, keyed by
+ * table and axis; emptied whenever the font serial changes.  Kerning
+ * pairs with hinting deltas repeat a lot in UI text. */
+struct hb_ot_device_cache_t
+{
+  struct entry_t
+  {
+    const void *device;
+    unsigned int vertical;
+    hb_position_t delta;
+  };
+
+  static unsigned int bucket (const void *device, bool vertical)
+  {
+    unsigned int h = (unsigned int) ((uintptr_t) device * 2 + vertical) * 2654435761u;
+    return (h >> 16) % HB_OT_DEVICE_CACHE_SIZE;
+  }
+
+  bool get (unsigned int font_serial, const void *device, bool vertical,
+	    hb_position_t *delta)
+  {
+    hb_lock_t l (lock);
+    const entry_t &e = entries[bucket (device, vertical)];
+    if (serial != font_serial || e.device != device || e.vertical != vertical)
+      return false;
+    *delta = e.delta;
+    return true;
+  }
+
+  void set (unsigned int font_serial, const void *device, bool vertical,
+	    hb_position_t delta)
+  {
+    hb_lock_t l (lock);
+    if (serial != font_serial)
+    {
+      memset (entries, 0, sizeof (entries));
+      serial = font_serial;
+    }
+    entry_t &e = entries[bucket (device, vertical)];
+    e.device = device;
+    e.vertical = vertical;
+    e.delta = delta;
+  }
+
+  hb_mutex_t lock;
+  unsigned int serial;
+  entry_t entries[HB_OT_DEVICE_CACHE_SIZE];
+};
+
+/* Creates the device cache of font on first use; nullptr if that fails. */
+HB_INTERNAL hb_ot_device_cache_t *
+hb_ot_layout_get_device_cache (hb_font_t *font);
+
 
 /*
  * Buffer var routines.
@@ -200,12 +371,16 @@ enum hb_unicode_props_flags_t {
 };
 HB_MARK_AS_FLAG_T (hb_unicode_props_flags_t);
 
+/* uprops, if given, holds the properties of info->codepoint as
+ * looked up by hb_unicode_funcs_t::get_props(). */
 static inline void
-_hb_glyph_info_set_unicode_props (hb_glyph_info_t *info, hb_buffer_t *buffer)
+_hb_glyph_info_set_unicode_props (hb_glyph_info_t *info, hb_buffer_t *buffer,
+				  const hb_unicode_props_t *uprops = nullptr)
 {
   hb_unicode_funcs_t *unicode = buffer->unicode;
   unsigned int u = info->codepoint;
-  unsigned int gen_cat = (unsigned int) unicode->general_category (u);
+  unsigned int gen_cat = uprops ? uprops->general_category :
+		       (unsigned int) unicode->general_category (u);
   unsigned int props = gen_cat;
 
   if (u >= 0x80u)
@@ -240,8 +415,11 @@ _hb_glyph_info_set_unicode_props (hb_glyph_info_t *info, hb_buffer_t *buffer)
 
     if (unlikely (HB_UNICODE_GENERAL_CATEGORY_IS_MARK (gen_cat)))
     {
+      buffer->scratch_flags |= HB_BUFFER_SCRATCH_FLAG_HAS_MARKS;
       props |= UPROPS_MASK_CONTINUATION;
-      props |= unicode->modified_combining_class (u)<<8;
+      props |= (uprops ?
+		unicode->modified_combining_class (u, (hb_unicode_combining_class_t) uprops->combining_class) :
+		unicode->modified_combining_class (u))<<8;
     }
   }
 
@@ -37,6 +37,102 @@ void hb_ot_map_t::collect_lookups (unsigned int table_index, hb_set_t *lookups_o
     hb_set_add (lookups_out, lookups[table_index][i].index);
 }
 
+bool hb_ot_map_t::serialize (hb_vector_t<uint32_t> &out) const
+{
+  out.push (global_mask);
+
+  out.push (features.length);
+  for (unsigned int i = 0; i < features.length; i++)
+  {
+    const feature_map_t &f = features[i];
+    out.push (f.tag);
+    out.push (f.index[0]);
+    out.push (f.index[1]);
+    out.push (f.stage[0]);
+    out.push (f.stage[1]);
+    out.push (f.shift);
+    out.push (f.mask);
+    out.push (f._1_mask);
+    out.push (f.needs_fallback | (f.auto_zwnj << 1) | (f.auto_zwj << 2) | (f.random << 3));
+  }
+
+  for (unsigned int table_index = 0; table_index < 2; table_index++)
+  {
+    out.push (lookups[table_index].length);
+    for (unsigned int i = 0; i < lookups[table_index].length; i++)
+    {
+      const lookup_map_t &l = lookups[table_index][i];
+      out.push (l.index);
+      out.push (l.auto_zwnj | (l.auto_zwj << 1) | (l.random << 2));
+      out.push (l.mask);
+    }
+
+    out.push (stages[table_index].length);
+    for (unsigned int i = 0; i < stages[table_index].length; i++)
+      out.push (stages[table_index][i].last_lookup);
+  }
+
+  return !out.in_error ();
+}
+
+bool hb_ot_map_t::enable_stats ()
+{
+  for (unsigned int table_index = 0; table_index < 2; table_index++)
+  {
+    if (stats[table_index] || !lookups[table_index].length)
+      continue;
+    stats[table_index] = (hb_ot_lookup_stats_t *) calloc (lookups[table_index].length,
+							  sizeof (stats[table_index][0]));
+    if (unlikely (!stats[table_index]))
+      return false;
+  }
+  reset_stats ();
+  return true;
+}
+
+void hb_ot_map_t::reset_stats ()
+{
+  for (unsigned int table_index = 0; table_index < 2; table_index++)
+  {
+    if (!stats[table_index])
+      continue;
+    for (unsigned int i = 0; i < lookups[table_index].length; i++)
+    {
+      hb_ot_lookup_stats_t &s = stats[table_index][i];
+      memset (&s, 0, sizeof (s));
+      s.table_tag = table_index ? HB_OT_TAG_GPOS : HB_OT_TAG_GSUB;
+      s.lookup_index = lookups[table_index][i].index;
+    }
+  }
+}
+
+unsigned int hb_ot_map_t::get_stats (unsigned int start_offset,
+				     unsigned int *stats_count /* IN/OUT */,
+				     hb_ot_lookup_stats_t *stats_ /* OUT */) const
+{
+  unsigned int total = 0;
+  for (unsigned int table_index = 0; table_index < 2; table_index++)
+    if (stats[table_index])
+      total += lookups[table_index].length;
+
+  if (stats_count)
+  {
+    unsigned int count = 0;
+    unsigned int offset = 0;
+    for (unsigned int table_index = 0; table_index < 2; table_index++)
+    {
+      if (!stats[table_index])
+	continue;
+      for (unsigned int i = 0; i < lookups[table_index].length; i++, offset++)
+	if (offset >= start_offset && count < *stats_count)
+	  stats_[count++] = stats[table_index][i];
+    }
+    *stats_count = count;
+  }
+
+  return total;
+}
+
 
 hb_ot_map_builder_t::hb_ot_map_builder_t (hb_face_t *face_,
 					  const hb_segment_properties_t *props_)
@@ -80,6 +176,7 @@ void hb_ot_map_builder_t::add_feature (hb_tag_t tag,
 				       unsigned int value)
 {
   if (unlikely (!tag)) return;
+  HB_ALLOC_STATS_SCOPE (MAP);
   feature_info_t *info = feature_infos.push();
   info->tag = tag;
   info->seq = feature_infos.length;
@@ -133,8 +230,110 @@ hb_ot_map_builder_t::add_lookups (hb_ot_map_t  &m,
 }
 
 
+static bool
+read_words (hb_array_t<const uint32_t> &data, unsigned int count, const uint32_t **words)
+{
+  if (unlikely (count > data.length)) return false;
+  *words = data.arrayZ;
+  data += count;
+  return true;
+}
+
+bool
+hb_ot_map_builder_t::compile_serialized (hb_ot_map_t                &m,
+					 hb_array_t<const uint32_t> &data)
+{
+  HB_ALLOC_STATS_SCOPE (MAP);
+
+  /* The stages compile() would make; pause functions aren't serialized. */
+  add_gsub_pause (nullptr);
+  add_gpos_pause (nullptr);
+
+  for (unsigned int table_index = 0; table_index < 2; table_index++)
+  {
+    m.chosen_script[table_index] = chosen_script[table_index];
+    m.found_script[table_index] = found_script[table_index];
+  }
+
+  const uint32_t *w;
+  if (unlikely (!read_words (data, 2, &w))) return false;
+  m.global_mask = w[0];
+  unsigned int feature_count = w[1];
+
+  if (unlikely (feature_count > data.length / 9)) return false;
+  m.features.alloc (feature_count);
+  for (unsigned int i = 0; i < feature_count; i++)
+  {
+    read_words (data, 9, &w);
+    /* get_mask() and friends bsearch these. */
+    if (unlikely (i && w[0] <= m.features[i - 1].tag)) return false;
+    hb_ot_map_t::feature_map_t *map = m.features.push ();
+    map->tag = w[0];
+    map->index[0] = w[1];
+    map->index[1] = w[2];
+    map->stage[0] = w[3];
+    map->stage[1] = w[4];
+    map->shift = w[5];
+    map->mask = w[6];
+    map->_1_mask = w[7];
+    map->needs_fallback = w[8] & 1;
+    map->auto_zwnj = (w[8] >> 1) & 1;
+    map->auto_zwj = (w[8] >> 2) & 1;
+    map->random = (w[8] >> 3) & 1;
+    if (unlikely (map->shift >= 8 * sizeof (hb_mask_t))) return false;
+  }
+
+  for (unsigned int table_index = 0; table_index < 2; table_index++)
+  {
+    unsigned int table_lookup_count = hb_ot_layout_table_get_lookup_count (face, table_tags[table_index]);
+
+    if (unlikely (!read_words (data, 1, &w))) return false;
+    unsigned int lookup_count = w[0];
+    if (unlikely (lookup_count > data.length / 3)) return false;
+    m.lookups[table_index].alloc (lookup_count);
+    for (unsigned int i = 0; i < lookup_count; i++)
+    {
+      read_words (data, 3, &w);
+      if (unlikely (w[0] >= table_lookup_count)) return false;
+      hb_ot_map_t::lookup_map_t *lookup = m.lookups[table_index].push ();
+      lookup->index = w[0];
+      lookup->auto_zwnj = w[1] & 1;
+      lookup->auto_zwj = (w[1] >> 1) & 1;
+      lookup->random = (w[1] >> 2) & 1;
+      lookup->mask = w[2];
+    }
+
+    if (unlikely (!read_words (data, 1, &w))) return false;
+    unsigned int stage_count = w[0];
+    if (unlikely (stage_count != stages[table_index].length ||
+		  !read_words (data, stage_count, &w)))
+      return false;
+    m.stages[table_index].alloc (stage_count);
+    for (unsigned int i = 0; i < stage_count; i++)
+    {
+      if (unlikely (w[i] > lookup_count || (i && w[i] < w[i - 1]))) return false;
+      hb_ot_map_t::stage_map_t *stage_map = m.stages[table_index].push ();
+      stage_map->last_lookup = w[i];
+      stage_map->pause_func = stages[table_index][i].pause_func;
+    }
+
+    for (unsigned int i = 0; i < m.features.length; i++)
+      if (unlikely (m.features[i].stage[table_index] > stage_count)) return false;
+  }
+
+  if (unlikely (m.features.in_error () ||
+		m.lookups[0].in_error () || m.lookups[1].in_error () ||
+		m.stages[0].in_error () || m.stages[1].in_error ()))
+    return false;
+
+  m.compile_lookups (face);
+  return true;
+}
+
+
 void hb_ot_map_builder_t::add_pause (unsigned int table_index, hb_ot_map_t::pause_func_t pause_func)
 {
+  HB_ALLOC_STATS_SCOPE (MAP);
   stage_info_t *s = stages[table_index].push ();
   s->index = current_stage[table_index];
   s->pause_func = pause_func;
@@ -146,6 +345,8 @@ void
 hb_ot_map_builder_t::compile (hb_ot_map_t                  &m,
 			      const hb_ot_shape_plan_key_t &key)
 {
+  HB_ALLOC_STATS_SCOPE (MAP);
+
   static_assert ((!(HB_GLYPH_FLAG_DEFINED & (HB_GLYPH_FLAG_DEFINED + 1))), "");
   unsigned int global_bit_mask = HB_GLYPH_FLAG_DEFINED + 1;
   unsigned int global_bit_shift = hb_popcount (HB_GLYPH_FLAG_DEFINED);
@@ -201,6 +402,7 @@ hb_ot_map_builder_t::compile (hb_ot_map_t                  &m,
 
   /* Allocate bits now */
   unsigned int next_bit = global_bit_shift + 1;
+  m.features.alloc (feature_infos.length);
 
   for (unsigned int i = 0; i < feature_infos.length; i++)
   {
@@ -331,4 +533,6 @@ hb_ot_map_builder_t::compile (hb_ot_map_t                  &m,
       }
     }
   }
+
+  m.compile_lookups (face);
 }
@@ -29,14 +29,30 @@
 #ifndef HB_OT_MAP_HH
 #define HB_OT_MAP_HH
 
+#include "hb-blob.hh"
 #include "hb-buffer.hh"
 
 
 #define HB_OT_MAP_MAX_BITS 8u
 #define HB_OT_MAP_MAX_VALUE ((1u << HB_OT_MAP_MAX_BITS) - 1u)
 
+/* Inline capacities of the map builder's vectors; enough for the
+ * features and pauses of most shapers, so building a map doesn't
+ * allocate for them. */
+#ifndef HB_OT_MAP_BUILDER_INLINE_FEATURES
+#define HB_OT_MAP_BUILDER_INLINE_FEATURES 48
+#endif
+#ifndef HB_OT_MAP_BUILDER_INLINE_STAGES
+#define HB_OT_MAP_BUILDER_INLINE_STAGES 16
+#endif
+
 struct hb_ot_shape_plan_t;
 
+namespace OT {
+  struct Lookup;
+  struct hb_ot_layout_lookup_accelerator_t;
+}
+
 static const hb_tag_t table_tags[2] = {HB_OT_TAG_GSUB, HB_OT_TAG_GPOS};
 
 struct hb_ot_map_t
@@ -76,6 +92,18 @@ struct hb_ot_map_t
     }
   };
 
+  /* What apply() needs of a lookup, resolved once when the map is
+   * compiled; parallel to lookups[]. */
+  struct compiled_lookup_t {
+    const OT::Lookup *lookup;
+    const OT::hb_ot_layout_lookup_accelerator_t *accel;
+    hb_mask_t mask;
+    unsigned short index;
+    unsigned short auto_zwnj : 1;
+    unsigned short auto_zwj : 1;
+    unsigned short random : 1;
+  };
+
   typedef void (*pause_func_t) (const struct hb_ot_shape_plan_t *plan, hb_font_t *font, hb_buffer_t *buffer);
 
   struct stage_map_t {
@@ -91,6 +119,7 @@ struct hb_ot_map_t
     for (unsigned int table_index = 0; table_index < 2; table_index++)
     {
       lookups[table_index].init ();
+      compiled[table_index].init ();
       stages[table_index].init ();
     }
   }
@@ -100,7 +129,23 @@ struct hb_ot_map_t
     for (unsigned int table_index = 0; table_index < 2; table_index++)
     {
       lookups[table_index].fini ();
+      compiled[table_index].fini ();
       stages[table_index].fini ();
+      free (stats[table_index]);
+      stats[table_index] = nullptr;
+    }
+  }
+
+  void add_memory_usage (hb_memory_usage_t *usage) const
+  {
+    usage->add_vector (features);
+    for (unsigned int table_index = 0; table_index < 2; table_index++)
+    {
+      usage->add_vector (lookups[table_index]);
+      usage->add_vector (compiled[table_index]);
+      usage->add_vector (stages[table_index]);
+      if (stats[table_index])
+	usage->heap += lookups[table_index].length * sizeof (stats[table_index][0]);
     }
   }
 
@@ -125,6 +170,17 @@ struct hb_ot_map_t
     return map ? map->_1_mask : 0;
   }
 
+  /* Whether applying table_index can do anything at all. */
+  bool has_work (unsigned int table_index) const
+  {
+    if (lookups[table_index].length)
+      return true;
+    for (unsigned int i = 0; i < stages[table_index].length; i++)
+      if (stages[table_index][i].pause_func)
+	return true;
+    return false;
+  }
+
   unsigned int get_feature_index (unsigned int table_index, hb_tag_t feature_tag) const
   {
     const feature_map_t *map = features.bsearch (feature_tag);
@@ -153,6 +209,17 @@ struct hb_ot_map_t
   }
 
   HB_INTERNAL void collect_lookups (unsigned int table_index, hb_set_t *lookups) const;
+  /* Appends what compile() computed to out, for
+   * hb_ot_map_builder_t::compile_serialized(). */
+  HB_INTERNAL bool serialize (hb_vector_t<uint32_t> &out) const;
+  HB_INTERNAL bool enable_stats ();
+  HB_INTERNAL void reset_stats ();
+  HB_INTERNAL unsigned int get_stats (unsigned int start_offset,
+				      unsigned int *stats_count /* IN/OUT */,
+				      hb_ot_lookup_stats_t *stats_ /* OUT */) const;
+  template <typename Proxy>
+  HB_INTERNAL inline void compile_lookups (const Proxy &proxy);
+  HB_INTERNAL void compile_lookups (hb_face_t *face);
   template <typename Proxy>
   HB_INTERNAL inline void apply (const Proxy &proxy,
 				 const struct hb_ot_shape_plan_t *plan, hb_font_t *font, hb_buffer_t *buffer) const;
@@ -169,7 +236,10 @@ struct hb_ot_map_t
 
   hb_sorted_vector_t<feature_map_t> features;
   hb_vector_t<lookup_map_t> lookups[2]; /* GSUB/GPOS */
+  hb_vector_t<compiled_lookup_t> compiled[2]; /* GSUB/GPOS */
   hb_vector_t<stage_map_t> stages[2]; /* GSUB/GPOS */
+  /* Parallel to lookups[]; null until enable_stats(). */
+  hb_ot_lookup_stats_t *stats[2]; /* GSUB/GPOS */
 };
 
 enum hb_ot_map_feature_flags_t
@@ -228,6 +298,13 @@ struct hb_ot_map_builder_t
   HB_INTERNAL void compile (hb_ot_map_t                  &m,
 			    const hb_ot_shape_plan_key_t &key);
 
+  /* Like compile(), but takes the features and lookups it would select
+   * from the output of hb_ot_map_t::serialize() for the same face and
+   * builder input.  Consumes what it reads from data.  Returns false if
+   * data doesn't fit this face and builder. */
+  HB_INTERNAL bool compile_serialized (hb_ot_map_t                &m,
+				       hb_array_t<const uint32_t> &data);
+
   private:
 
   HB_INTERNAL void add_lookups (hb_ot_map_t  &m,
@@ -275,8 +352,8 @@ struct hb_ot_map_builder_t
   private:
 
   unsigned int current_stage[2]; /* GSUB/GPOS */
-  hb_vector_t<feature_info_t> feature_infos;
-  hb_vector_t<stage_info_t> stages[2]; /* GSUB/GPOS */
+  hb_vector_t<feature_info_t, HB_OT_MAP_BUILDER_INLINE_FEATURES> feature_infos;
+  hb_vector_t<stage_info_t, HB_OT_MAP_BUILDER_INLINE_STAGES> stages[2]; /* GSUB/GPOS */
 };
 
 
@@ -30,6 +30,7 @@
 #include "hb-open-type.hh"
 #include "hb-ot-layout-common.hh"
 #include "hb-ot-math.h"
+#include "hb-cache.hh"
 
 namespace OT {
 
@@ -339,10 +340,16 @@ struct MathKernInfo
 			     hb_ot_math_kern_t kern,
 			     hb_position_t correction_height,
 			     hb_font_t *font) const
-  {
-    unsigned int index = (this+mathKernCoverage).get_coverage (glyph);
-    return mathKernInfoRecords[index].get_kerning (kern, correction_height, font, this);
-  }
+  { return get_record_kerning (get_coverage (glyph), kern, correction_height, font); }
+
+  unsigned int get_coverage (hb_codepoint_t glyph) const
+  { return (this+mathKernCoverage).get_coverage (glyph); }
+
+  hb_position_t get_record_kerning (unsigned int index,
+				    hb_ot_math_kern_t kern,
+				    hb_position_t correction_height,
+				    hb_font_t *font) const
+  { return mathKernInfoRecords[index].get_kerning (kern, correction_height, font, this); }
 
   protected:
   OffsetTo<Coverage>		mathKernCoverage;    /* Offset to Coverage table -
@@ -388,6 +395,8 @@ struct MathGlyphInfo
 			     hb_font_t *font) const
   { return (this+mathKernInfo).get_kerning (glyph, kern, correction_height, font); }
 
+  const MathKernInfo &get_kern_info () const { return this+mathKernInfo; }
+
   protected:
   /* Offset to MathItalicsCorrectionInfo table -
    * from the beginning of MathGlyphInfo table. */
@@ -608,7 +617,7 @@ struct MathVariants
 				   unsigned int start_offset,
 				   unsigned int *variants_count, /* IN/OUT */
 				   hb_ot_math_glyph_variant_t *variants /* OUT */) const
-  { return get_glyph_construction (glyph, direction, font)
+  { return get_glyph_construction (get_glyph_construction_index (glyph, direction))
 	   .get_variants (direction, font, start_offset, variants_count, variants); }
 
   unsigned int get_glyph_parts (hb_codepoint_t glyph,
@@ -618,17 +627,15 @@ struct MathVariants
 				       unsigned int *parts_count, /* IN/OUT */
 				       hb_ot_math_glyph_part_t *parts /* OUT */,
 				       hb_position_t *italics_correction /* OUT */) const
-  { return get_glyph_construction (glyph, direction, font)
+  { return get_glyph_construction (get_glyph_construction_index (glyph, direction))
 	   .get_assembly ()
 	   .get_parts (direction, font,
 		       start_offset, parts_count, parts,
 		       italics_correction); }
 
-  private:
-  const MathGlyphConstruction &
-  get_glyph_construction (hb_codepoint_t glyph,
-			  hb_direction_t direction,
-			  hb_font_t *font HB_UNUSED) const
+  /* Index into glyphConstruction, or NOT_COVERED. */
+  unsigned int get_glyph_construction_index (hb_codepoint_t glyph,
+					     hb_direction_t direction) const
   {
     bool vertical = HB_DIRECTION_IS_VERTICAL (direction);
     unsigned int count = vertical ? vertGlyphCount : horizGlyphCount;
@@ -636,11 +643,19 @@ struct MathVariants
 						  : horizGlyphCoverage;
 
     unsigned int index = (this+coverage).get_coverage (glyph);
-    if (unlikely (index >= count)) return Null (MathGlyphConstruction);
+    if (unlikely (index >= count)) return NOT_COVERED;
 
     if (!vertical)
       index += vertGlyphCount;
 
+    return index;
+  }
+
+  const MathGlyphConstruction &
+  get_glyph_construction (unsigned int index) const
+  {
+    if (unlikely (index >= vertGlyphCount + horizGlyphCount))
+      return Null (MathGlyphConstruction);
     return this+glyphConstruction[index];
   }
 
@@ -701,6 +716,115 @@ struct MATH
 
   const MathVariants &get_variants () const    { return this+mathVariants; }
 
+  /* Caches the coverage lookups of glyph constructions and kerning, which
+   * renderers repeat for the same delimiters and operators over and over.
+   * Results are still scaled per call, since that only takes a multiply. */
+  struct accelerator_t
+  {
+    void init (hb_face_t *face)
+    {
+      table = hb_sanitize_context_t().reference_table<MATH> (face);
+      cache = (cache_t *) malloc (sizeof (cache_t));
+      if (likely (cache))
+      {
+	cache->construction.init ();
+	cache->kern.init ();
+      }
+    }
+    void fini ()
+    {
+      free (cache);
+      table.destroy ();
+    }
+
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (table);
+      if (cache)
+	usage->heap += sizeof (*cache);
+    }
+
+    bool has_data () const { return table->has_data (); }
+
+    hb_position_t get_constant (hb_ot_math_constant_t  constant,
+				hb_font_t		*font) const
+    { return table->get_constant (constant, font); }
+
+    const MathGlyphInfo &get_glyph_info () const { return table->get_glyph_info (); }
+
+    const MathVariants &get_variants () const    { return table->get_variants (); }
+
+    hb_position_t get_kerning (hb_codepoint_t glyph,
+			       hb_ot_math_kern_t kern,
+			       hb_position_t correction_height,
+			       hb_font_t *font) const
+    {
+      const MathKernInfo &info = get_glyph_info ().get_kern_info ();
+      unsigned int index;
+      if (unlikely (glyph > 0xFFFFu || !cache))
+	index = info.get_coverage (glyph);
+      else if (!cache->kern.get (glyph, &index))
+      {
+	index = info.get_coverage (glyph);
+	cache->kern.set (glyph, index & 0xFFFFu);
+      }
+      else if (index == 0xFFFFu)
+	index = NOT_COVERED;
+      return info.get_record_kerning (index, kern, correction_height, font);
+    }
+
+    unsigned int get_glyph_variants (hb_codepoint_t glyph,
+				     hb_direction_t direction,
+				     hb_font_t *font,
+				     unsigned int start_offset,
+				     unsigned int *variants_count, /* IN/OUT */
+				     hb_ot_math_glyph_variant_t *variants /* OUT */) const
+    { return get_variants ().get_glyph_construction (get_glyph_construction_index (glyph, direction))
+	     .get_variants (direction, font, start_offset, variants_count, variants); }
+
+    unsigned int get_glyph_parts (hb_codepoint_t glyph,
+				  hb_direction_t direction,
+				  hb_font_t *font,
+				  unsigned int start_offset,
+				  unsigned int *parts_count, /* IN/OUT */
+				  hb_ot_math_glyph_part_t *parts /* OUT */,
+				  hb_position_t *italics_correction /* OUT */) const
+    { return get_variants ().get_glyph_construction (get_glyph_construction_index (glyph, direction))
+	     .get_assembly ()
+	     .get_parts (direction, font,
+			 start_offset, parts_count, parts,
+			 italics_correction); }
+
+    private:
+    unsigned int get_glyph_construction_index (hb_codepoint_t glyph,
+					       hb_direction_t direction) const
+    {
+      if (unlikely (glyph > 0xFFFFu || !cache))
+	return get_variants ().get_glyph_construction_index (glyph, direction);
+      unsigned int key = (glyph << 1) | HB_DIRECTION_IS_VERTICAL (direction);
+      unsigned int index;
+      if (cache->construction.get (key, &index))
+	return index == CONSTRUCTION_NOT_COVERED ? NOT_COVERED : index;
+      index = get_variants ().get_glyph_construction_index (glyph, direction);
+      cache->construction.set (key, index == NOT_COVERED ? (unsigned) CONSTRUCTION_NOT_COVERED : index);
+      return index;
+    }
+
+    /* Construction indices go up to twice the number of coverage entries. */
+    enum { CONSTRUCTION_NOT_COVERED = (1u << 17) - 1 };
+
+    /* Kept out of line, so that the accelerator stays small enough for
+     * the Null pool. */
+    struct cache_t
+    {
+      hb_cache_t<17, 17, 7> construction;
+      hb_cache_t<16, 16, 7> kern;
+    };
+
+    hb_blob_ptr_t<MATH> table;
+    cache_t *cache; /* nullptr if allocation failed. */
+  };
+
   protected:
   FixedVersion<>version;		/* Version of the MATH table
 					 * initially set to 0x00010000u */
@@ -712,6 +836,8 @@ struct MATH
   DEFINE_SIZE_STATIC (10);
 };
 
+struct MATH_accelerator_t : MATH::accelerator_t {};
+
 } /* namespace OT */
 
 
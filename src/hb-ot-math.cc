@@ -58,6 +58,9 @@
 hb_bool_t
 hb_ot_math_has_data (hb_face_t *face)
 {
+#if defined(HB_NO_MATH)
+  return false;
+#endif
   return face->table.MATH->has_data ();
 }
 
@@ -80,6 +83,9 @@ hb_position_t
 hb_ot_math_get_constant (hb_font_t *font,
 			 hb_ot_math_constant_t constant)
 {
+#if defined(HB_NO_MATH)
+  return 0;
+#endif
   return font->face->table.MATH->get_constant(constant, font);
 }
 
@@ -96,6 +102,9 @@ hb_position_t
 hb_ot_math_get_glyph_italics_correction (hb_font_t *font,
 					 hb_codepoint_t glyph)
 {
+#if defined(HB_NO_MATH)
+  return 0;
+#endif
   return font->face->table.MATH->get_glyph_info().get_italics_correction (glyph, font);
 }
 
@@ -112,6 +121,9 @@ hb_position_t
 hb_ot_math_get_glyph_top_accent_attachment (hb_font_t *font,
 					    hb_codepoint_t glyph)
 {
+#if defined(HB_NO_MATH)
+  return 0;
+#endif
   return font->face->table.MATH->get_glyph_info().get_top_accent_attachment (glyph, font);
 }
 
@@ -128,6 +140,9 @@ hb_bool_t
 hb_ot_math_is_glyph_extended_shape (hb_face_t *face,
 				    hb_codepoint_t glyph)
 {
+#if defined(HB_NO_MATH)
+  return false;
+#endif
   return face->table.MATH->get_glyph_info().is_extended_shape (glyph);
 }
 
@@ -154,10 +169,13 @@ hb_ot_math_get_glyph_kerning (hb_font_t *font,
 			      hb_ot_math_kern_t kern,
 			      hb_position_t correction_height)
 {
-  return font->face->table.MATH->get_glyph_info().get_kerning (glyph,
-							       kern,
-							       correction_height,
-							       font);
+#if defined(HB_NO_MATH)
+  return 0;
+#endif
+  return font->face->table.MATH->get_kerning (glyph,
+					      kern,
+					      correction_height,
+					      font);
 }
 
 /**
@@ -187,10 +205,15 @@ hb_ot_math_get_glyph_variants (hb_font_t *font,
 			       unsigned int *variants_count, /* IN/OUT */
 			       hb_ot_math_glyph_variant_t *variants /* OUT */)
 {
-  return font->face->table.MATH->get_variants().get_glyph_variants (glyph, direction, font,
-								    start_offset,
-								    variants_count,
-								    variants);
+#if defined(HB_NO_MATH)
+  if (variants_count)
+    *variants_count = 0;
+  return 0;
+#endif
+  return font->face->table.MATH->get_glyph_variants (glyph, direction, font,
+						     start_offset,
+						     variants_count,
+						     variants);
 }
 
 /**
@@ -211,6 +234,9 @@ hb_position_t
 hb_ot_math_get_min_connector_overlap (hb_font_t *font,
 				      hb_direction_t direction)
 {
+#if defined(HB_NO_MATH)
+  return 0;
+#endif
   return font->face->table.MATH->get_variants().get_min_connector_overlap (direction, font);
 }
 
@@ -243,11 +269,18 @@ hb_ot_math_get_glyph_assembly (hb_font_t *font,
 			       hb_ot_math_glyph_part_t *parts, /* OUT */
 			       hb_position_t *italics_correction /* OUT */)
 {
-  return font->face->table.MATH->get_variants().get_glyph_parts (glyph,
-								 direction,
-								 font,
-								 start_offset,
-								 parts_count,
-								 parts,
-								 italics_correction);
+#if defined(HB_NO_MATH)
+  if (parts_count)
+    *parts_count = 0;
+  if (italics_correction)
+    *italics_correction = 0;
+  return 0;
+#endif
+  return font->face->table.MATH->get_glyph_parts (glyph,
+						  direction,
+						  font,
+						  start_offset,
+						  parts_count,
+						  parts,
+						  italics_correction);
 }
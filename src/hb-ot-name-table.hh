@@ -95,14 +95,30 @@ struct NameRecord
     return UNSUPPORTED;
   }
 
+  /* Records pointing at a string range already copied (localized names
+   * often share one string across platforms) link to the existing object
+   * instead of copying and hashing it again.  Identical strings at
+   * different source ranges still dedup in pop_pack(). */
   NameRecord* copy (hb_serialize_context_t *c,
 		    const void *src_base,
-		    const void *dst_base) const
+		    const void *dst_base,
+		    hb_map_t *string_objidx) const
   {
     TRACE_SERIALIZE (this);
     auto *out = c->embed (this);
     if (unlikely (!out)) return_trace (nullptr);
-    out->offset.serialize_copy (c, src_base + offset, dst_base, length);
+    out->offset = 0;
+
+    unsigned key = ((unsigned) offset << 16) | length;
+    unsigned objidx = string_objidx->get (key);
+    if (objidx == HB_MAP_VALUE_INVALID)
+    {
+      c->push ();
+      (src_base+offset).copy (c, length);
+      objidx = c->pop_pack ();
+      string_objidx->set (key, objidx);
+    }
+    c->add_link (out->offset, objidx, dst_base);
     return_trace (out);
   }
 
@@ -189,8 +205,9 @@ struct name
 
     const void *dst_string_pool = &(this + this->stringOffset);
 
+    hb_map_t string_objidx;
     + it
-    | hb_apply ([&] (const NameRecord& _) { c->copy (_, src_string_pool, dst_string_pool); })
+    | hb_apply ([&] (const NameRecord& _) { c->copy (_, src_string_pool, dst_string_pool, &string_objidx); })
     ;
 
     if (unlikely (c->ran_out_of_room)) return_trace (false);
@@ -273,25 +290,71 @@ struct name
 	this->names[j++] = this->names[i];
       }
       this->names.resize (j);
+
+      /* Languages are unique pointers, so lookups can hash them instead
+       * of comparing their strings like the sort above does. */
+      this->lookup.init ();
+      unsigned int size = 2;
+      while (size < 2 * this->names.length)
+	size <<= 1;
+      if (likely (this->lookup.resize (size)))
+      {
+	memset (this->lookup.arrayZ (), 0, this->lookup.get_size ());
+	for (unsigned int i = 0; i < this->names.length; i++)
+	{
+	  unsigned int h = hash (this->names[i].name_id, this->names[i].language);
+	  while (this->lookup[h & (size - 1)])
+	    h++;
+	  this->lookup[h & (size - 1)] = i + 1;
+	}
+      }
     }
 
     void fini ()
     {
+      this->lookup.fini ();
       this->names.fini ();
       this->table.destroy ();
     }
 
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (this->table);
+      usage->add_vector (this->names);
+      usage->add_vector (this->lookup);
+    }
+
     int get_index (hb_ot_name_id_t   name_id,
 			  hb_language_t     language,
 			  unsigned int     *width=nullptr) const
     {
-      const hb_ot_name_entry_t key = {name_id, {0}, language};
-      const hb_ot_name_entry_t *entry = (const hb_ot_name_entry_t *)
-					hb_bsearch (&key,
-						    (const hb_ot_name_entry_t *) this->names,
-						    this->names.length,
-						    sizeof (key),
-						    _hb_ot_name_entry_cmp_key);
+      const hb_ot_name_entry_t *entry = nullptr;
+      if (likely (this->lookup.length))
+      {
+	unsigned int mask = this->lookup.length - 1;
+	for (unsigned int h = hash (name_id, language);; h++)
+	{
+	  unsigned int i = this->lookup[h & mask];
+	  if (!i)
+	    break;
+	  if (this->names[i - 1].name_id == name_id &&
+	      this->names[i - 1].language == language)
+	  {
+	    entry = &this->names[i - 1];
+	    break;
+	  }
+	}
+      }
+      else
+      {
+	const hb_ot_name_entry_t key = {name_id, {0}, language};
+	entry = (const hb_ot_name_entry_t *)
+		hb_bsearch (&key,
+			    (const hb_ot_name_entry_t *) this->names,
+			    this->names.length,
+			    sizeof (key),
+			    _hb_ot_name_entry_cmp_key);
+      }
       if (!entry)
         return -1;
 
@@ -310,8 +373,14 @@ struct name
     }
 
     private:
+    static unsigned int hash (hb_ot_name_id_t name_id, hb_language_t language)
+    { return ((uint32_t) (uintptr_t) language * 31u + name_id) * 2654435761u >> 15; }
+
     const char *pool;
     unsigned int pool_len;
+    /* Open-addressed (name_id, language) lookup into names; slots hold
+     * an index into names plus one, zero for free slots. */
+    hb_vector_t<uint16_t> lookup;
     public:
     hb_blob_ptr_t<name> table;
     hb_vector_t<hb_ot_name_entry_t> names;
@@ -222,3 +222,75 @@ hb_ot_name_get_utf32 (hb_face_t       *face,
 {
   return hb_ot_name_get_utf<hb_utf32_t> (face, name_id, language, text_size, text);
 }
+
+/**
+ * hb_ot_name_get_utf8_batch:
+ * @face: font face.
+ * @language: language to fetch the names for.
+ * @name_ids_count: number of names to fetch.
+ * @name_ids: (array length=name_ids_count): OpenType name identifiers to fetch.
+ * @lengths: (out caller-allocates) (array length=name_ids_count) (allow-none):
+ *           length of each name, or 0 if the face lacks it.
+ * @text_size: (inout) (allow-none): input size of @text buffer, and output size of
+ *                                   text written to buffer.
+ * @text: (out caller-allocates) (array length=text_size): buffer to write fetched names into.
+ *
+ * Fetches several font names from the OpenType 'name' table at once,
+ * like calling hb_ot_name_get_utf8() for each of @name_ids.
+ *
+ * The names are written to @text one after the other, each
+ * NUL-terminated and in the order of @name_ids, names the face lacks
+ * as empty strings.  Name i thus starts after the first i @lengths,
+ * each plus one.  Writing stops at the first name that does not fit
+ * in full.
+ * If @language is #HB_LANGUAGE_INVALID, English ("en") is assumed.
+ *
+ * Returns: size @text needs to hold all names in full, NULs included.
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_ot_name_get_utf8_batch (hb_face_t             *face,
+			   hb_language_t          language,
+			   unsigned int           name_ids_count,
+			   const hb_ot_name_id_t *name_ids,
+			   unsigned int          *lengths   /* OUT */,
+			   unsigned int          *text_size /* IN/OUT */,
+			   char                  *text      /* OUT */)
+{
+  const OT::name_accelerator_t &name = *face->table.name;
+
+  if (!language)
+    language = hb_language_from_string ("en", 2);
+
+  unsigned int room = text_size ? *text_size : 0;
+  unsigned int written = 0;
+  unsigned int total = 0;
+  for (unsigned int i = 0; i < name_ids_count; i++)
+  {
+    unsigned int length = 0;
+    unsigned int width;
+    int idx = name.get_index (name_ids[i], language, &width);
+    if (idx != -1)
+    {
+      hb_bytes_t bytes = name.get_name (idx);
+      unsigned int size = written == total ? room - written : 0;
+      char *out = text + written;
+      if (width == 2) /* UTF16-BE */
+	length = hb_ot_name_convert_utf<hb_utf16_be_t, hb_utf8_t> (bytes, &size, (hb_utf8_t::codepoint_t *) out);
+      else if (width == 1) /* ASCII */
+	length = hb_ot_name_convert_utf<hb_ascii_t, hb_utf8_t> (bytes, &size, (hb_utf8_t::codepoint_t *) out);
+    }
+    else if (written == total && written < room)
+      text[written] = 0;
+
+    if (lengths)
+      lengths[i] = length;
+    total += length + 1;
+    if (written + length + 1 == total && total <= room)
+      written = total;
+  }
+
+  if (text_size)
+    *text_size = written;
+  return total;
+}
@@ -123,6 +123,15 @@ hb_ot_name_get_utf32 (hb_face_t       *face,
 		      unsigned int    *text_size /* IN/OUT */,
 		      uint32_t        *text      /* OUT */);
 
+HB_EXTERN unsigned int
+hb_ot_name_get_utf8_batch (hb_face_t             *face,
+			   hb_language_t          language,
+			   unsigned int           name_ids_count,
+			   const hb_ot_name_id_t *name_ids,
+			   unsigned int          *lengths   /* OUT */,
+			   unsigned int          *text_size /* IN/OUT */,
+			   char                  *text      /* OUT */);
+
 
 HB_END_DECLS
 
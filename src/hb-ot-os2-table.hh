@@ -173,27 +173,18 @@ struct OS2
   void _update_unicode_ranges (const hb_set_t *codepoints,
 			       HBUINT32 ulUnicodeRange[4]) const
   {
+    uint32_t ranges[4] = {0};
+    _hb_ot_os2_get_unicode_range_bits (codepoints, ranges);
+
+    /* the spec says that bit 57 ("Non Plane 0") implies that there's
+       at least one codepoint beyond the BMP; so I also include all
+       the non-BMP codepoints here */
+    hb_codepoint_t cp = 0xFFFFu;
+    if (codepoints->next (&cp) && cp <= 0x110000)
+      ranges[1] |= 1u << 25;
+
     for (unsigned int i = 0; i < 4; i++)
-      ulUnicodeRange[i] = 0;
-
-    hb_codepoint_t cp = HB_SET_VALUE_INVALID;
-    while (codepoints->next (&cp)) {
-      unsigned int bit = _hb_ot_os2_get_unicode_range_bit (cp);
-      if (bit < 128)
-      {
-	unsigned int block = bit / 32;
-	unsigned int bit_in_block = bit % 32;
-	unsigned int mask = 1 << bit_in_block;
-	ulUnicodeRange[block] = ulUnicodeRange[block] | mask;
-      }
-      if (cp >= 0x10000 && cp <= 0x110000)
-      {
-	/* the spec says that bit 57 ("Non Plane 0") implies that there's
-	   at least one codepoint beyond the BMP; so I also include all
-	   the non-BMP codepoints here */
-	ulUnicodeRange[1] = ulUnicodeRange[1] | (1 << 25);
-      }
-    }
+      ulUnicodeRange[i] = ranges[i];
   }
 
   static void find_min_and_max_codepoint (const hb_set_t *codepoints,
@@ -28,6 +28,7 @@
 #define HB_OT_OS2_UNICODE_RANGES_HH
 
 #include "hb.hh"
+#include "hb-set.hh"
 
 namespace OT {
 
@@ -230,7 +231,7 @@ static const OS2Range _hb_os2_unicode_ranges[] =
  * _hb_ot_os2_get_unicode_range_bit:
  * Returns the bit to be set in os/2 ulUnicodeOS2Range for a given codepoint.
  **/
-static unsigned int
+static inline unsigned int
 _hb_ot_os2_get_unicode_range_bit (hb_codepoint_t cp)
 {
   OS2Range *range = (OS2Range*) hb_bsearch (&cp, _hb_os2_unicode_ranges,
@@ -242,6 +243,42 @@ _hb_ot_os2_get_unicode_range_bit (hb_codepoint_t cp)
   return -1;
 }
 
+/**
+ * _hb_ot_os2_get_unicode_range_bits:
+ * Sets in ulUnicodeRange the bits of every range holding at least one
+ * of the codepoints.  Walks the ranges, looking each one up in the set,
+ * rather than visiting every codepoint.
+ **/
+static inline void
+_hb_ot_os2_get_unicode_range_bits (const hb_set_t *codepoints,
+				   uint32_t ulUnicodeRange[4])
+{
+  unsigned int count = ARRAY_LENGTH (_hb_os2_unicode_ranges);
+  unsigned int i = 0;
+  while (i < count)
+  {
+    /* First codepoint at or after the range start. */
+    hb_codepoint_t cp = _hb_os2_unicode_ranges[i].start ?
+			_hb_os2_unicode_ranges[i].start - 1 :
+			HB_SET_VALUE_INVALID;
+    if (!codepoints->next (&cp))
+      break;
+
+    /* Skip ranges it lies past; it is either in the next one or in the
+     * gap before it. */
+    while (i < count && _hb_os2_unicode_ranges[i].end < cp)
+      i++;
+    if (i == count)
+      break;
+    if (_hb_os2_unicode_ranges[i].start <= cp)
+    {
+      unsigned int bit = _hb_os2_unicode_ranges[i].bit;
+      ulUnicodeRange[bit / 32] |= 1u << (bit % 32);
+      i++;
+    }
+  }
+}
+
 } /* namespace OT */
 
 #endif /* HB_OT_OS2_UNICODE_RANGES_HH */
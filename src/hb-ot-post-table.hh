@@ -125,6 +125,14 @@ struct post
       table.destroy ();
     }
 
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    {
+      usage->add_blob (table);
+      usage->add_vector (index_to_offset);
+      if (gids_sorted_by_name.get ())
+	usage->heap += get_glyph_count () * sizeof (uint16_t);
+    }
+
     bool get_glyph_name (hb_codepoint_t glyph,
 			 char *buf, unsigned int buf_len) const
     {
@@ -45,8 +45,7 @@ static const hb_tag_t arabic_fallback_features[] =
 };
 
 static OT::SubstLookup *
-arabic_fallback_synthesize_lookup_single (const hb_ot_shape_plan_t *plan HB_UNUSED,
-					  hb_font_t *font,
+arabic_fallback_synthesize_lookup_single (hb_font_t *font,
 					  unsigned int feature_index)
 {
   OT::GlyphID glyphs[SHAPING_TABLE_LAST - SHAPING_TABLE_FIRST + 1];
@@ -96,8 +95,7 @@ arabic_fallback_synthesize_lookup_single (const hb_ot_shape_plan_t *plan HB_UNUS
 }
 
 static OT::SubstLookup *
-arabic_fallback_synthesize_lookup_ligature (const hb_ot_shape_plan_t *plan HB_UNUSED,
-					    hb_font_t *font)
+arabic_fallback_synthesize_lookup_ligature (hb_font_t *font)
 {
   OT::GlyphID first_glyphs[ARRAY_LENGTH_CONST (ligature_table)];
   unsigned int first_glyphs_indirection[ARRAY_LENGTH_CONST (ligature_table)];
@@ -174,28 +172,38 @@ arabic_fallback_synthesize_lookup_ligature (const hb_ot_shape_plan_t *plan HB_UN
 }
 
 static OT::SubstLookup *
-arabic_fallback_synthesize_lookup (const hb_ot_shape_plan_t *plan,
-				   hb_font_t *font,
+arabic_fallback_synthesize_lookup (hb_font_t *font,
 				   unsigned int feature_index)
 {
   if (feature_index < 4)
-    return arabic_fallback_synthesize_lookup_single (plan, font, feature_index);
+    return arabic_fallback_synthesize_lookup_single (font, feature_index);
   else
-    return arabic_fallback_synthesize_lookup_ligature (plan, font);
+    return arabic_fallback_synthesize_lookup_ligature (font);
 }
 
 #define ARABIC_FALLBACK_MAX_LOOKUPS 5
 
-struct arabic_fallback_plan_t
+/* Lookups synthesized for a face, shared by all Arabic plans on that face.
+ * Only the masks differ between plans, so those live in the plan below. */
+struct arabic_fallback_face_t
 {
   unsigned int num_lookups;
   bool free_lookups;
 
-  hb_mask_t mask_array[ARABIC_FALLBACK_MAX_LOOKUPS];
+  hb_tag_t tag_array[ARABIC_FALLBACK_MAX_LOOKUPS];
   OT::SubstLookup *lookup_array[ARABIC_FALLBACK_MAX_LOOKUPS];
   OT::hb_ot_layout_lookup_accelerator_t accel_array[ARABIC_FALLBACK_MAX_LOOKUPS];
 };
 
+struct arabic_fallback_plan_t
+{
+  unsigned int num_lookups;
+
+  hb_mask_t mask_array[ARABIC_FALLBACK_MAX_LOOKUPS];
+  const OT::SubstLookup *lookup_array[ARABIC_FALLBACK_MAX_LOOKUPS];
+  const OT::hb_ot_layout_lookup_accelerator_t *accel_array[ARABIC_FALLBACK_MAX_LOOKUPS];
+};
+
 #if defined(_WIN32) && !defined(HB_NO_WIN1256)
 #define HB_WITH_WIN1256
 #endif
@@ -215,8 +223,7 @@ struct ManifestLookup
 typedef OT::ArrayOf<ManifestLookup> Manifest;
 
 static bool
-arabic_fallback_plan_init_win1256 (arabic_fallback_plan_t *fallback_plan HB_UNUSED,
-				   const hb_ot_shape_plan_t *plan HB_UNUSED,
+arabic_fallback_face_init_win1256 (arabic_fallback_face_t *fallback_face HB_UNUSED,
 				   hb_font_t *font HB_UNUSED)
 {
 #ifdef HB_WITH_WIN1256
@@ -238,20 +245,17 @@ arabic_fallback_plan_init_win1256 (arabic_fallback_plan_t *fallback_plan HB_UNUS
   unsigned int count = manifest.len;
   for (unsigned int i = 0; i < count; i++)
   {
-    fallback_plan->mask_array[j] = plan->map.get_1_mask (manifest[i].tag);
-    if (fallback_plan->mask_array[j])
+    fallback_face->tag_array[j] = manifest[i].tag;
+    fallback_face->lookup_array[j] = const_cast<OT::SubstLookup*> (&(&manifest+manifest[i].lookupOffset));
+    if (fallback_face->lookup_array[j])
     {
-      fallback_plan->lookup_array[j] = const_cast<OT::SubstLookup*> (&(&manifest+manifest[i].lookupOffset));
-      if (fallback_plan->lookup_array[j])
-      {
-	fallback_plan->accel_array[j].init (*fallback_plan->lookup_array[j]);
-	j++;
-      }
+      fallback_face->accel_array[j].init (*fallback_face->lookup_array[j], font->face->get_num_glyphs ());
+      j++;
     }
   }
 
-  fallback_plan->num_lookups = j;
-  fallback_plan->free_lookups = false;
+  fallback_face->num_lookups = j;
+  fallback_face->free_lookups = false;
 
   return j > 0;
 #else
@@ -260,72 +264,103 @@ arabic_fallback_plan_init_win1256 (arabic_fallback_plan_t *fallback_plan HB_UNUS
 }
 
 static bool
-arabic_fallback_plan_init_unicode (arabic_fallback_plan_t *fallback_plan,
-				   const hb_ot_shape_plan_t *plan,
+arabic_fallback_face_init_unicode (arabic_fallback_face_t *fallback_face,
 				   hb_font_t *font)
 {
   static_assert ((ARRAY_LENGTH_CONST(arabic_fallback_features) <= ARABIC_FALLBACK_MAX_LOOKUPS), "");
   unsigned int j = 0;
   for (unsigned int i = 0; i < ARRAY_LENGTH(arabic_fallback_features) ; i++)
   {
-    fallback_plan->mask_array[j] = plan->map.get_1_mask (arabic_fallback_features[i]);
-    if (fallback_plan->mask_array[j])
+    fallback_face->tag_array[j] = arabic_fallback_features[i];
+    fallback_face->lookup_array[j] = arabic_fallback_synthesize_lookup (font, i);
+    if (fallback_face->lookup_array[j])
     {
-      fallback_plan->lookup_array[j] = arabic_fallback_synthesize_lookup (plan, font, i);
-      if (fallback_plan->lookup_array[j])
-      {
-	fallback_plan->accel_array[j].init (*fallback_plan->lookup_array[j]);
-	j++;
-      }
+      fallback_face->accel_array[j].init (*fallback_face->lookup_array[j], font->face->get_num_glyphs ());
+      j++;
     }
   }
 
-  fallback_plan->num_lookups = j;
-  fallback_plan->free_lookups = true;
+  fallback_face->num_lookups = j;
+  fallback_face->free_lookups = true;
 
   return j > 0;
 }
 
-static arabic_fallback_plan_t *
-arabic_fallback_plan_create (const hb_ot_shape_plan_t *plan,
-			     hb_font_t *font)
+/* Synthesizes the lookups for all fallback features, whether or not the
+ * plan at hand enables them; the result is keyed on the face alone, so it
+ * assumes the glyph mapping of @font is that of its face's cmap.  Returns
+ * an object with no lookups if the face has no fallback, and nullptr on
+ * allocation failure. */
+static arabic_fallback_face_t *
+arabic_fallback_face_create (hb_font_t *font)
 {
-  arabic_fallback_plan_t *fallback_plan = (arabic_fallback_plan_t *) calloc (1, sizeof (arabic_fallback_plan_t));
-  if (unlikely (!fallback_plan))
-    return const_cast<arabic_fallback_plan_t *> (&Null(arabic_fallback_plan_t));
+  arabic_fallback_face_t *fallback_face = (arabic_fallback_face_t *) calloc (1, sizeof (arabic_fallback_face_t));
+  if (unlikely (!fallback_face))
+    return nullptr;
 
-  fallback_plan->num_lookups = 0;
-  fallback_plan->free_lookups = false;
+  fallback_face->num_lookups = 0;
+  fallback_face->free_lookups = false;
 
   /* Try synthesizing GSUB table using Unicode Arabic Presentation Forms,
    * in case the font has cmap entries for the presentation-forms characters. */
-  if (arabic_fallback_plan_init_unicode (fallback_plan, plan, font))
-    return fallback_plan;
+  if (arabic_fallback_face_init_unicode (fallback_face, font))
+    return fallback_face;
 
   /* See if this looks like a Windows-1256-encoded font.  If it does, use a
    * hand-coded GSUB table. */
-  if (arabic_fallback_plan_init_win1256 (fallback_plan, plan, font))
-    return fallback_plan;
+  if (arabic_fallback_face_init_win1256 (fallback_face, font))
+    return fallback_face;
 
-  assert (fallback_plan->num_lookups == 0);
-  free (fallback_plan);
-  return const_cast<arabic_fallback_plan_t *> (&Null(arabic_fallback_plan_t));
+  assert (fallback_face->num_lookups == 0);
+  return fallback_face;
 }
 
 static void
-arabic_fallback_plan_destroy (arabic_fallback_plan_t *fallback_plan)
+arabic_fallback_face_destroy (arabic_fallback_face_t *fallback_face)
 {
-  if (!fallback_plan || fallback_plan->num_lookups == 0)
+  if (!fallback_face)
     return;
 
-  for (unsigned int i = 0; i < fallback_plan->num_lookups; i++)
-    if (fallback_plan->lookup_array[i])
+  for (unsigned int i = 0; i < fallback_face->num_lookups; i++)
+  {
+    fallback_face->accel_array[i].fini ();
+    if (fallback_face->free_lookups)
+      free (fallback_face->lookup_array[i]);
+  }
+
+  free (fallback_face);
+}
+
+/* Returns an object with no lookups if the plan enables none of those of
+ * fallback_face, and nullptr on allocation failure. */
+static arabic_fallback_plan_t *
+arabic_fallback_plan_create (const hb_ot_shape_plan_t *plan,
+			     const arabic_fallback_face_t *fallback_face)
+{
+  arabic_fallback_plan_t *fallback_plan = (arabic_fallback_plan_t *) calloc (1, sizeof (arabic_fallback_plan_t));
+  if (unlikely (!fallback_plan))
+    return nullptr;
+
+  unsigned int j = 0;
+  for (unsigned int i = 0; i < fallback_face->num_lookups; i++)
+  {
+    fallback_plan->mask_array[j] = plan->map.get_1_mask (fallback_face->tag_array[i]);
+    if (fallback_plan->mask_array[j])
     {
-      fallback_plan->accel_array[i].fini ();
-      if (fallback_plan->free_lookups)
-	free (fallback_plan->lookup_array[i]);
+      fallback_plan->lookup_array[j] = fallback_face->lookup_array[i];
+      fallback_plan->accel_array[j] = &fallback_face->accel_array[i];
+      j++;
     }
+  }
 
+  fallback_plan->num_lookups = j;
+
+  return fallback_plan;
+}
+
+static void
+arabic_fallback_plan_destroy (arabic_fallback_plan_t *fallback_plan)
+{
   free (fallback_plan);
 }
 
@@ -334,14 +369,17 @@ arabic_fallback_plan_shape (arabic_fallback_plan_t *fallback_plan,
 			    hb_font_t *font,
 			    hb_buffer_t *buffer)
 {
+  if (!fallback_plan->num_lookups)
+    return;
+
   OT::hb_ot_apply_context_t c (0, font, buffer);
   for (unsigned int i = 0; i < fallback_plan->num_lookups; i++)
-    if (fallback_plan->lookup_array[i]) {
-      c.set_lookup_mask (fallback_plan->mask_array[i]);
-      hb_ot_layout_substitute_lookup (&c,
-				      *fallback_plan->lookup_array[i],
-				      fallback_plan->accel_array[i]);
-    }
+  {
+    c.set_lookup_mask (fallback_plan->mask_array[i]);
+    hb_ot_layout_substitute_lookup (&c,
+				    *fallback_plan->lookup_array[i],
+				    *fallback_plan->accel_array[i]);
+  }
 }
 
 
@@ -160,12 +160,10 @@ static const uint8_t joining_table[] =
 static unsigned int
 joining_type (hb_codepoint_t u)
 {
+  if (hb_in_range<hb_codepoint_t> (u, 0x0600u, 0x08E2u)) return joining_table[u - 0x0600u + joining_offset_0x0600u];
+
   switch (u >> 12)
   {
-    case 0x0u:
-      if (hb_in_range<hb_codepoint_t> (u, 0x0600u, 0x08E2u)) return joining_table[u - 0x0600u + joining_offset_0x0600u];
-      break;
-
     case 0x1u:
       if (hb_in_range<hb_codepoint_t> (u, 0x1806u, 0x18AAu)) return joining_table[u - 0x1806u + joining_offset_0x1806u];
       break;
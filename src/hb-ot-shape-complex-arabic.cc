@@ -28,6 +28,8 @@
 #include "hb-ot-shape-complex-arabic.hh"
 #include "hb-ot-shape.hh"
 
+#if !defined(HB_NO_OT_SHAPE_COMPLEX_ARABIC)
+
 
 /* buffer var allocations */
 #define arabic_shaping_action() complex_var_u8_0() /* arabic shaping action */
@@ -274,6 +276,12 @@ data_create_arabic (const hb_ot_shape_plan_t *plan)
   return arabic_plan;
 }
 
+void
+arabic_fallback_face_data_destroy (arabic_fallback_face_t *data)
+{
+  arabic_fallback_face_destroy (data);
+}
+
 void
 data_destroy_arabic (void *data)
 {
@@ -320,6 +328,18 @@ arabic_joining (hb_buffer_t *buffer)
       info[prev].arabic_shaping_action() = entry->prev_action;
       buffer->unsafe_to_break (prev, i + 1);
     }
+    else if (prev == (unsigned int) -1)
+    {
+      /* Text before might join this one. */
+      if (this_type >= JOINING_TYPE_R)
+	buffer->unsafe_to_concat (0, i + 1);
+    }
+    else if (this_type >= JOINING_TYPE_R || (2 <= state && state <= 5))
+    {
+      /* States that have a possible prev_action: other text in between
+       * might join the two. */
+      buffer->unsafe_to_concat (prev, i + 1);
+    }
 
     info[i].arabic_shaping_action() = entry->curr_action;
 
@@ -337,6 +357,8 @@ arabic_joining (hb_buffer_t *buffer)
     const arabic_state_table_entry *entry = &arabic_state_table[state][this_type];
     if (entry->prev_action != NONE && prev != (unsigned int) -1)
       info[prev].arabic_shaping_action() = entry->prev_action;
+    else if (2 <= state && state <= 5 && prev != (unsigned int) -1)
+      buffer->unsafe_to_concat (prev, buffer->len);
     break;
   }
 }
@@ -396,8 +418,25 @@ retry:
   arabic_fallback_plan_t *fallback_plan = arabic_plan->fallback_plan;
   if (unlikely (!fallback_plan))
   {
-    /* This sucks.  We need a font to build the fallback plan... */
-    fallback_plan = arabic_fallback_plan_create (plan, font);
+    hb_ot_face_data_t *face_data = font->face->data.ot.get_stored ();
+  retry_face:
+    arabic_fallback_face_t *fallback_face = face_data->arabic_fallback;
+    if (unlikely (!fallback_face))
+    {
+      /* This sucks.  We need a font to build the fallback lookups... */
+      fallback_face = arabic_fallback_face_create (font);
+      if (unlikely (!fallback_face))
+	return;
+      if (unlikely (!face_data->arabic_fallback.cmpexch (nullptr, fallback_face)))
+      {
+	arabic_fallback_face_destroy (fallback_face);
+	goto retry_face;
+      }
+    }
+
+    fallback_plan = arabic_fallback_plan_create (plan, fallback_face);
+    if (unlikely (!fallback_plan))
+      return;
     if (unlikely (!arabic_plan->fallback_plan.cmpexch (nullptr, fallback_plan)))
     {
       arabic_fallback_plan_destroy (fallback_plan);
@@ -710,3 +749,6 @@ const hb_ot_complex_shaper_t _hb_ot_complex_shaper_arabic =
   HB_OT_SHAPE_ZERO_WIDTH_MARKS_BY_GDEF_LATE,
   true, /* fallback_position */
 };
+
+
+#endif
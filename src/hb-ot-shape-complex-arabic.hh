@@ -35,6 +35,7 @@
 
 
 struct arabic_shape_plan_t;
+struct arabic_fallback_face_t;
 
 HB_INTERNAL void *
 data_create_arabic (const hb_ot_shape_plan_t *plan);
@@ -42,6 +43,9 @@ data_create_arabic (const hb_ot_shape_plan_t *plan);
 HB_INTERNAL void
 data_destroy_arabic (void *data);
 
+HB_INTERNAL void
+arabic_fallback_face_data_destroy (arabic_fallback_face_t *data);
+
 HB_INTERNAL void
 setup_masks_arabic_plan (const arabic_shape_plan_t *arabic_plan,
 			 hb_buffer_t               *buffer,
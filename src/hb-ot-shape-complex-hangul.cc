@@ -25,6 +25,9 @@
  */
 
 #include "hb-ot-shape-complex.hh"
+#include "hb-ot-cmap-table.hh"
+
+#if !defined(HB_NO_OT_SHAPE_COMPLEX_HANGUL)
 
 
 /* Hangul shaper */
@@ -117,6 +120,98 @@ data_destroy_hangul (void *data)
 /* buffer var allocations */
 #define hangul_shaping_feature() complex_var_u8_0() /* hangul jamo shaping feature */
 
+/* Which of the characters preprocess_text_hangul() asks the font about
+ * the face's cmap maps: the precomposed syllables, the Hangul Jamo block
+ * and the dotted circle, in that order.  Shared by all fonts of the face
+ * that use the OpenType font functions; see get_hangul_face().
+ *
+ * Each chunk holds the bits of 16 characters, plus FILLED once they were
+ * looked up.  Chunks are filled on first use, since any text only uses a
+ * fraction of the syllables; threads racing to fill one store the same
+ * value. */
+struct hangul_face_t
+{
+  enum {
+    JAMO_START = SCount,
+    DOTTED_CIRCLE = JAMO_START + 0x100u,
+    CHAR_COUNT,
+    FILLED = 1u << 16
+  };
+
+  static bool get_index (hb_codepoint_t u, unsigned int *index)
+  {
+    if (isCombinedS (u)) *index = u - SBase;
+    else if (hb_in_range<hb_codepoint_t> (u, 0x1100u, 0x11FFu)) *index = JAMO_START + (u - 0x1100u);
+    else if (u == 0x25CCu) *index = DOTTED_CIRCLE;
+    else return false;
+    return true;
+  }
+
+  static hb_codepoint_t get_char (unsigned int index)
+  {
+    if (index < JAMO_START) return SBase + index;
+    if (index < DOTTED_CIRCLE) return 0x1100u + (index - JAMO_START);
+    return 0x25CCu;
+  }
+
+  bool has_glyph (hb_face_t *face, unsigned int index) const
+  {
+    hb_atomic_int_t &chunk = chunks[index / 16];
+    unsigned int bits = chunk.get_relaxed ();
+    if (unlikely (!(bits & FILLED)))
+    {
+      const OT::cmap_accelerator_t &cmap = *face->table.cmap;
+      unsigned int first = index - index % 16;
+      unsigned int last = hb_min (first + 16, (unsigned int) CHAR_COUNT);
+      hb_codepoint_t glyph;
+      bits = FILLED;
+      for (unsigned int i = first; i < last; i++)
+	if (cmap.get_nominal_glyph (get_char (i), &glyph))
+	  bits |= 1u << (i - first);
+      chunk.set_relaxed (bits);
+    }
+    return (bits >> (index % 16)) & 1;
+  }
+
+  mutable hb_atomic_int_t chunks[(CHAR_COUNT + 15) / 16];
+};
+
+/* The bits are only valid for fonts whose glyph mapping is the face's
+ * cmap; returns nullptr for others, which ask the font instead. */
+static const hangul_face_t *
+get_hangul_face (hb_font_t *font)
+{
+  if (!font->ot_font)
+    return nullptr;
+
+  hb_ot_face_data_t *face_data = font->face->data.ot.get_stored ();
+retry:
+  hangul_face_t *hangul_face = face_data->hangul.get ();
+  if (unlikely (!hangul_face))
+  {
+    hangul_face = (hangul_face_t *) calloc (1, sizeof (hangul_face_t));
+    if (unlikely (!hangul_face))
+      return nullptr;
+    if (unlikely (!face_data->hangul.cmpexch (nullptr, hangul_face)))
+    {
+      free (hangul_face);
+      goto retry;
+    }
+  }
+  return hangul_face;
+}
+
+static bool
+hangul_has_glyph (const hangul_face_t *hangul_face,
+		  hb_font_t           *font,
+		  hb_codepoint_t       u)
+{
+  unsigned int index;
+  if (hangul_face && likely (hangul_face_t::get_index (u, &index)))
+    return hangul_face->has_glyph (font->face, index);
+  return font->has_glyph (u);
+}
+
 static bool
 is_zero_width_char (hb_font_t *font,
 		    hb_codepoint_t unicode)
@@ -180,6 +275,8 @@ preprocess_text_hangul (const hb_ot_shape_plan_t *plan HB_UNUSED,
    *   decompose.
    */
 
+  const hangul_face_t *hangul_face = get_hangul_face (font);
+
   buffer->clear_output ();
   unsigned int start = 0, end = 0; /* Extent of most recently seen syllable;
 				    * valid only if start < end
@@ -215,7 +312,7 @@ preprocess_text_hangul (const hb_ot_shape_plan_t *plan HB_UNUSED,
       {
 	/* No valid syllable as base for tone mark; try to insert dotted circle. */
       if (!(buffer->flags & HB_BUFFER_FLAG_DO_NOT_INSERT_DOTTED_CIRCLE) &&
-	  font->has_glyph (0x25CCu))
+	  hangul_has_glyph (hangul_face, font, 0x25CCu))
 	{
 	  hb_codepoint_t chars[2];
 	  if (!is_zero_width_char (font, u)) {
@@ -265,7 +362,7 @@ preprocess_text_hangul (const hb_ot_shape_plan_t *plan HB_UNUSED,
 	{
 	  /* Try to compose; if this succeeds, end is set to start+1. */
 	  hb_codepoint_t s = SBase + (l - LBase) * NCount + (v - VBase) * TCount + tindex;
-	  if (font->has_glyph (s))
+	  if (hangul_has_glyph (hangul_face, font, s))
 	  {
 	    buffer->replace_glyphs (t ? 3 : 2, 1, &s);
 	    if (unlikely (!buffer->successful))
@@ -302,7 +399,7 @@ preprocess_text_hangul (const hb_ot_shape_plan_t *plan HB_UNUSED,
     {
       /* Have <LV>, <LVT>, or <LV,T> */
       hb_codepoint_t s = u;
-      bool has_glyph = font->has_glyph (s);
+      bool has_glyph = hangul_has_glyph (hangul_face, font, s);
       unsigned int lindex = (s - SBase) / NCount;
       unsigned int nindex = (s - SBase) % NCount;
       unsigned int vindex = nindex / TCount;
@@ -315,7 +412,7 @@ preprocess_text_hangul (const hb_ot_shape_plan_t *plan HB_UNUSED,
 	/* <LV,T>, try to combine. */
 	unsigned int new_tindex = buffer->cur(+1).codepoint - TBase;
 	hb_codepoint_t new_s = s + new_tindex;
-	if (font->has_glyph (new_s))
+	if (hangul_has_glyph (hangul_face, font, new_s))
 	{
 	  buffer->replace_glyphs (2, 1, &new_s);
 	  if (unlikely (!buffer->successful))
@@ -338,9 +435,9 @@ preprocess_text_hangul (const hb_ot_shape_plan_t *plan HB_UNUSED,
 	hb_codepoint_t decomposed[3] = {LBase + lindex,
 					VBase + vindex,
 					TBase + tindex};
-	if (font->has_glyph (decomposed[0]) &&
-	    font->has_glyph (decomposed[1]) &&
-	    (!tindex || font->has_glyph (decomposed[2])))
+	if (hangul_has_glyph (hangul_face, font, decomposed[0]) &&
+	    hangul_has_glyph (hangul_face, font, decomposed[1]) &&
+	    (!tindex || hangul_has_glyph (hangul_face, font, decomposed[2])))
 	{
 	  unsigned int s_len = tindex ? 3 : 2;
 	  buffer->replace_glyphs (1, s_len, decomposed);
@@ -430,3 +527,6 @@ const hb_ot_complex_shaper_t _hb_ot_complex_shaper_hangul =
   HB_OT_SHAPE_ZERO_WIDTH_MARKS_NONE,
   false, /* fallback_position */
 };
+
+
+#endif
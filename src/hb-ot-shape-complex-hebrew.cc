@@ -26,6 +26,8 @@
 
 #include "hb-ot-shape-complex.hh"
 
+#if !defined(HB_NO_OT_SHAPE_COMPLEX_HEBREW)
+
 
 static bool
 compose_hebrew (const hb_ot_shape_normalize_context_t *c,
@@ -176,3 +178,6 @@ const hb_ot_complex_shaper_t _hb_ot_complex_shaper_hebrew =
   HB_OT_SHAPE_ZERO_WIDTH_MARKS_BY_GDEF_LATE,
   true, /* fallback_position */
 };
+
+
+#endif
@@ -16,6 +16,8 @@
 
 #include "hb-ot-shape-complex-indic.hh"
 
+#if !defined(HB_NO_OT_SHAPE_COMPLEX_INDIC_TABLE)
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-macros"
 
@@ -487,4 +489,6 @@ hb_indic_get_categories (hb_codepoint_t u)
 #undef IMC_TR
 #undef IMC_VOL
 
+#endif
+
 /* == End of generated table == */
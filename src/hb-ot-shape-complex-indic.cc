@@ -27,6 +27,9 @@
 #include "hb-ot-shape-complex-indic.hh"
 #include "hb-ot-shape-complex-vowel-constraints.hh"
 #include "hb-ot-layout.hh"
+#include "hb-map.hh"
+
+#if !defined(HB_NO_OT_SHAPE_COMPLEX_INDIC)
 
 
 /*
@@ -244,12 +247,160 @@ struct would_substitute_feature_t
     return false;
   }
 
+  /* Appends what would_substitute() results depend on. */
+  void push_key (hb_vector_t<unsigned int> *key) const
+  {
+    key->push (zero_context);
+    key->push (count);
+    for (unsigned int i = 0; i < count; i++)
+      key->push (lookups[i].index);
+  }
+
   private:
   const hb_ot_map_t::lookup_map_t *lookups;
   unsigned int count;
   bool zero_context;
 };
 
+
+/*
+ * Consonant positions only depend on the face, the virama glyph, and the
+ * lookups of the blwf, pstf and pref features, but finding each one takes
+ * up to six would_substitute() probes.  Remember them per face, so that
+ * every plan with the same lookups shares the answers.
+ */
+
+#define INDIC_POSITION_CACHE_ENTRIES 4
+
+struct indic_position_cache_t
+{
+  /* Returns the cache of face, creating it on first use; nullptr on
+   * allocation failure. */
+  static indic_position_cache_t *get (hb_face_t *face)
+  {
+  retry:
+    indic_position_cache_t *cache = face->indic_position_cache.get ();
+    if (likely (cache))
+      return cache;
+    if (unlikely (hb_object_is_inert (face)))
+      return nullptr;
+
+    cache = (indic_position_cache_t *) calloc (1, sizeof (indic_position_cache_t));
+    if (unlikely (!cache))
+      return nullptr;
+    cache->init ();
+    if (unlikely (!face->indic_position_cache.cmpexch (nullptr, cache)))
+    {
+      destroy (cache);
+      goto retry; /* Lost the race. */
+    }
+    return cache;
+  }
+
+  static void destroy (indic_position_cache_t *cache)
+  {
+    if (!cache) return;
+    for (unsigned int i = 0; i < ARRAY_LENGTH (cache->entries); i++)
+      cache->entries[i].fini ();
+    cache->mutex.fini ();
+    free (cache);
+  }
+
+  void lock () { mutex.lock (); }
+  void unlock () { mutex.unlock (); }
+
+  /* Must hold the lock; the positions stay valid until it is released. */
+  const hb_map_t *find (const hb_vector_t<unsigned int> &position_key, hb_codepoint_t virama)
+  {
+    entry_t *entry = find_entry (position_key, virama);
+    return entry ? &entry->positions : nullptr;
+  }
+
+  /* Must hold the lock.  Like find(), but replaces the least recently used
+   * entry if there is none; nullptr on allocation failure. */
+  hb_map_t *find_or_add (const hb_vector_t<unsigned int> &position_key, hb_codepoint_t virama)
+  {
+    entry_t *entry = find_entry (position_key, virama);
+    if (entry)
+      return &entry->positions;
+
+    entry_t *victim = &entries[0];
+    for (unsigned int i = 1; i < ARRAY_LENGTH (entries); i++)
+      if (entries[i].last_used < victim->last_used)
+	victim = &entries[i];
+
+    victim->key.resize (0);
+    victim->key.alloc (position_key.length);
+    for (unsigned int i = 0; i < position_key.length; i++)
+      victim->key.push (position_key[i]);
+    victim->virama = virama;
+    victim->positions.clear ();
+    victim->last_used = ++serial;
+    if (unlikely (victim->key.in_error ()))
+    {
+      victim->fini ();
+      victim->init ();
+      return nullptr;
+    }
+    return &victim->positions;
+  }
+
+  private:
+  void init ()
+  {
+    mutex.init ();
+    serial = 0;
+    for (unsigned int i = 0; i < ARRAY_LENGTH (entries); i++)
+      entries[i].init ();
+  }
+
+  struct entry_t;
+  entry_t *find_entry (const hb_vector_t<unsigned int> &position_key, hb_codepoint_t virama)
+  {
+    for (unsigned int i = 0; i < ARRAY_LENGTH (entries); i++)
+    {
+      entry_t *entry = &entries[i];
+      if (entry->last_used && entry->virama == virama && entry->key == position_key)
+      {
+	entry->last_used = ++serial;
+	return entry;
+      }
+    }
+    return nullptr;
+  }
+
+  struct entry_t
+  {
+    void init ()
+    {
+      key.init ();
+      positions.init ();
+      virama = 0;
+      last_used = 0;
+    }
+    void fini ()
+    {
+      key.fini ();
+      positions.fini ();
+    }
+
+    hb_vector_t<unsigned int> key;
+    hb_codepoint_t virama;
+    hb_map_t positions;
+    unsigned int last_used;
+  };
+
+  hb_mutex_t mutex;
+  unsigned int serial;
+  entry_t entries[INDIC_POSITION_CACHE_ENTRIES];
+};
+
+void
+_hb_indic_position_cache_destroy (indic_position_cache_t *cache)
+{
+  indic_position_cache_t::destroy (cache);
+}
+
 struct indic_shape_plan_t
 {
   bool load_virama_glyph (hb_font_t *font, hb_codepoint_t *pglyph) const
@@ -281,6 +432,7 @@ struct indic_shape_plan_t
   would_substitute_feature_t pref;
   would_substitute_feature_t blwf;
   would_substitute_feature_t pstf;
+  hb_vector_t<unsigned int> position_key; /* For indic_position_cache_t. */
 
   hb_mask_t mask_array[INDIC_NUM_FEATURES];
 };
@@ -318,6 +470,17 @@ data_create_indic (const hb_ot_shape_plan_t *plan)
   indic_plan->blwf.init (&plan->map, HB_TAG('b','l','w','f'), zero_context);
   indic_plan->pstf.init (&plan->map, HB_TAG('p','s','t','f'), zero_context);
 
+  indic_plan->position_key.init ();
+  indic_plan->blwf.push_key (&indic_plan->position_key);
+  indic_plan->pstf.push_key (&indic_plan->position_key);
+  indic_plan->pref.push_key (&indic_plan->position_key);
+  if (unlikely (indic_plan->position_key.in_error ()))
+  {
+    indic_plan->position_key.fini ();
+    free (indic_plan);
+    return nullptr;
+  }
+
   for (unsigned int i = 0; i < ARRAY_LENGTH (indic_plan->mask_array); i++)
     indic_plan->mask_array[i] = (indic_features[i].flags & F_GLOBAL) ?
 				 0 : plan->map.get_1_mask (indic_features[i].tag);
@@ -328,6 +491,8 @@ data_create_indic (const hb_ot_shape_plan_t *plan)
 static void
 data_destroy_indic (void *data)
 {
+  indic_shape_plan_t *indic_plan = (indic_shape_plan_t *) data;
+  indic_plan->position_key.fini ();
   free (data);
 }
 
@@ -410,6 +575,9 @@ compare_indic_order (const hb_glyph_info_t *pa, const hb_glyph_info_t *pb)
 }
 
 
+/* Marks consonants whose position update_consonant_positions() has not
+ * found in the cache; positions themselves are below POS_END. */
+#define INDIC_POSITION_PENDING 0x80u
 
 static void
 update_consonant_positions (const hb_ot_shape_plan_t *plan,
@@ -422,18 +590,57 @@ update_consonant_positions (const hb_ot_shape_plan_t *plan,
     return;
 
   hb_codepoint_t virama;
-  if (indic_plan->load_virama_glyph (font, &virama))
+  if (!indic_plan->load_virama_glyph (font, &virama))
+    return;
+
+  hb_face_t *face = font->face;
+  indic_position_cache_t *cache = indic_position_cache_t::get (face);
+  unsigned int count = buffer->len;
+  hb_glyph_info_t *info = buffer->info;
+
+  if (unlikely (!cache))
   {
-    hb_face_t *face = font->face;
-    unsigned int count = buffer->len;
-    hb_glyph_info_t *info = buffer->info;
     for (unsigned int i = 0; i < count; i++)
       if (info[i].indic_position() == POS_BASE_C)
+	info[i].indic_position() = consonant_position_from_face (indic_plan, info[i].codepoint, virama, face);
+    return;
+  }
+
+  /* Take what the cache knows, and mark the rest as pending. */
+  bool pending = false;
+  cache->lock ();
+  const hb_map_t *known = cache->find (indic_plan->position_key, virama);
+  for (unsigned int i = 0; i < count; i++)
+    if (info[i].indic_position() == POS_BASE_C)
+    {
+      hb_codepoint_t position = known ? known->get (info[i].codepoint) : HB_MAP_VALUE_INVALID;
+      if (position == HB_MAP_VALUE_INVALID)
       {
-	hb_codepoint_t consonant = info[i].codepoint;
-	info[i].indic_position() = consonant_position_from_face (indic_plan, consonant, virama, face);
+	position = INDIC_POSITION_PENDING;
+	pending = true;
       }
-  }
+      info[i].indic_position() = position;
+    }
+  cache->unlock ();
+  if (!pending)
+    return;
+
+  /* Probe the face without holding the lock. */
+  for (unsigned int i = 0; i < count; i++)
+    if (info[i].indic_position() == INDIC_POSITION_PENDING)
+      info[i].indic_position() = INDIC_POSITION_PENDING |
+				 consonant_position_from_face (indic_plan, info[i].codepoint, virama, face);
+
+  cache->lock ();
+  hb_map_t *positions = cache->find_or_add (indic_plan->position_key, virama);
+  for (unsigned int i = 0; i < count; i++)
+    if (info[i].indic_position() & INDIC_POSITION_PENDING)
+    {
+      info[i].indic_position() &= ~INDIC_POSITION_PENDING;
+      if (positions)
+	positions->set (info[i].codepoint, info[i].indic_position());
+    }
+  cache->unlock ();
 }
 
 
@@ -1642,3 +1849,6 @@ const hb_ot_complex_shaper_t _hb_ot_complex_shaper_indic =
   HB_OT_SHAPE_ZERO_WIDTH_MARKS_NONE,
   false, /* fallback_position */
 };
+
+
+#endif
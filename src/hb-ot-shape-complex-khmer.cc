@@ -27,6 +27,8 @@
 #include "hb-ot-shape-complex-khmer.hh"
 #include "hb-ot-layout.hh"
 
+#if !defined(HB_NO_OT_SHAPE_COMPLEX_KHMER)
+
 
 /*
  * Khmer shaper.
@@ -502,3 +504,6 @@ const hb_ot_complex_shaper_t _hb_ot_complex_shaper_khmer =
   HB_OT_SHAPE_ZERO_WIDTH_MARKS_NONE,
   false, /* fallback_position */
 };
+
+
+#endif
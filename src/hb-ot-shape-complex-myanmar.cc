@@ -26,6 +26,8 @@
 
 #include "hb-ot-shape-complex-myanmar.hh"
 
+#if !defined(HB_NO_OT_SHAPE_COMPLEX_MYANMAR)
+
 
 /*
  * Myanmar shaper.
@@ -415,3 +417,6 @@ const hb_ot_complex_shaper_t _hb_ot_complex_shaper_myanmar_zawgyi =
   HB_OT_SHAPE_ZERO_WIDTH_MARKS_NONE,
   false, /* fallback_position */
 };
+
+
+#endif
@@ -25,6 +25,9 @@
  */
 
 #include "hb-ot-shape-complex.hh"
+#include "hb-ot-cmap-table.hh"
+
+#if !defined(HB_NO_OT_SHAPE_COMPLEX_THAI)
 
 
 /* Thai / Lao shaper */
@@ -90,8 +93,79 @@ enum thai_action_t
   RD   /* Remove descender from base */
 };
 
+/* Which of the Windows (U+F700..F71F) and Mac (U+F880..F89F) PUA
+ * characters the face's cmap maps.  Shared by all fonts of the face that
+ * use the OpenType font functions; see get_thai_pua_face(). */
+struct thai_pua_face_t
+{
+  uint32_t win;
+  uint32_t mac;
+};
+
+static thai_pua_face_t *
+thai_pua_face_create (hb_face_t *face)
+{
+  thai_pua_face_t *pua_face = (thai_pua_face_t *) calloc (1, sizeof (thai_pua_face_t));
+  if (unlikely (!pua_face))
+    return nullptr;
+
+  const OT::cmap_accelerator_t &cmap = *face->table.cmap;
+  hb_codepoint_t glyph;
+  for (unsigned int i = 0; i < 32; i++)
+  {
+    if (cmap.get_nominal_glyph (0xF700u + i, &glyph))
+      pua_face->win |= 1u << i;
+    if (cmap.get_nominal_glyph (0xF880u + i, &glyph))
+      pua_face->mac |= 1u << i;
+  }
+
+  return pua_face;
+}
+
+/* The bits are only valid for fonts whose glyph mapping is the face's
+ * cmap; returns nullptr for others, which ask the font instead. */
+static const thai_pua_face_t *
+get_thai_pua_face (hb_font_t *font)
+{
+  if (!font->ot_font)
+    return nullptr;
+
+  hb_ot_face_data_t *face_data = font->face->data.ot.get_stored ();
+retry:
+  thai_pua_face_t *pua_face = face_data->thai_pua.get ();
+  if (unlikely (!pua_face))
+  {
+    pua_face = thai_pua_face_create (font->face);
+    if (unlikely (!pua_face))
+      return nullptr;
+    if (unlikely (!face_data->thai_pua.cmpexch (nullptr, pua_face)))
+    {
+      free (pua_face);
+      goto retry;
+    }
+  }
+  return pua_face;
+}
+
+static bool
+thai_pua_has_glyph (const thai_pua_face_t *pua_face,
+		    hb_font_t             *font,
+		    hb_codepoint_t         u)
+{
+  if (pua_face)
+  {
+    if (hb_in_range<hb_codepoint_t> (u, 0xF700u, 0xF71Fu))
+      return (pua_face->win >> (u - 0xF700u)) & 1;
+    if (hb_in_range<hb_codepoint_t> (u, 0xF880u, 0xF89Fu))
+      return (pua_face->mac >> (u - 0xF880u)) & 1;
+  }
+  hb_codepoint_t glyph;
+  return hb_font_get_glyph (font, u, 0, &glyph);
+}
+
 static hb_codepoint_t
-thai_pua_shape (hb_codepoint_t u, thai_action_t action, hb_font_t *font)
+thai_pua_shape (hb_codepoint_t u, thai_action_t action,
+		const thai_pua_face_t *pua_face, hb_font_t *font)
 {
   struct thai_pua_mapping_t {
     hb_codepoint_t u;
@@ -148,10 +222,9 @@ thai_pua_shape (hb_codepoint_t u, thai_action_t action, hb_font_t *font)
   for (; pua_mappings->u; pua_mappings++)
     if (pua_mappings->u == u)
     {
-      hb_codepoint_t glyph;
-      if (hb_font_get_glyph (font, pua_mappings->win_pua, 0, &glyph))
+      if (thai_pua_has_glyph (pua_face, font, pua_mappings->win_pua))
 	return pua_mappings->win_pua;
-      if (hb_font_get_glyph (font, pua_mappings->mac_pua, 0, &glyph))
+      if (thai_pua_has_glyph (pua_face, font, pua_mappings->mac_pua))
 	return pua_mappings->mac_pua;
       break;
     }
@@ -222,6 +295,7 @@ do_thai_pua_shaping (const hb_ot_shape_plan_t *plan HB_UNUSED,
   return;
 #endif
 
+  const thai_pua_face_t *pua_face = nullptr;
   thai_above_state_t above_state = thai_above_start_state[NOT_CONSONANT];
   thai_below_state_t below_state = thai_below_start_state[NOT_CONSONANT];
   unsigned int base = 0;
@@ -249,10 +323,12 @@ do_thai_pua_shaping (const hb_ot_shape_plan_t *plan HB_UNUSED,
     thai_action_t action = above_edge.action != NOP ? above_edge.action : below_edge.action;
 
     buffer->unsafe_to_break (base, i);
+    if (action != NOP && !pua_face)
+      pua_face = get_thai_pua_face (font);
     if (action == RD)
-      info[base].codepoint = thai_pua_shape (info[base].codepoint, action, font);
+      info[base].codepoint = thai_pua_shape (info[base].codepoint, action, pua_face, font);
     else
-      info[i].codepoint = thai_pua_shape (info[i].codepoint, action, font);
+      info[i].codepoint = thai_pua_shape (info[i].codepoint, action, pua_face, font);
   }
 }
 
@@ -337,6 +413,7 @@ preprocess_text_thai (const hb_ot_shape_plan_t *plan,
     /* Make Nikhahit be recognized as a ccc=0 mark when zeroing widths. */
     unsigned int end = buffer->out_len;
     _hb_glyph_info_set_general_category (&buffer->out_info[end - 2], HB_UNICODE_GENERAL_CATEGORY_NON_SPACING_MARK);
+    buffer->scratch_flags |= HB_BUFFER_SCRATCH_FLAG_HAS_MARKS;
 
     /* Ok, let's see... */
     unsigned int start = end - 2;
@@ -385,3 +462,6 @@ const hb_ot_complex_shaper_t _hb_ot_complex_shaper_thai =
   HB_OT_SHAPE_ZERO_WIDTH_MARKS_BY_GDEF_LATE,
   false,/* fallback_position */
 };
+
+
+#endif
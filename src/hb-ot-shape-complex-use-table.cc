@@ -17,6 +17,8 @@
 
 #include "hb-ot-shape-complex-use.hh"
 
+#if !defined(HB_NO_OT_SHAPE_COMPLEX_USE)
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-macros"
 #define B	USE_B	/* BASE */
@@ -845,4 +847,6 @@ hb_use_get_category (hb_codepoint_t u)
 #undef VMPst
 #undef VMAbv
 
+#endif
+
 /* == End of generated table == */
@@ -30,6 +30,8 @@
 #include "hb-ot-shape-complex-arabic.hh"
 #include "hb-ot-shape-complex-vowel-constraints.hh"
 
+#if !defined(HB_NO_OT_SHAPE_COMPLEX_USE)
+
 /* buffer var allocations */
 #define use_category() complex_var_u8_0()
 
@@ -640,3 +642,6 @@ const hb_ot_complex_shaper_t _hb_ot_complex_shaper_use =
   HB_OT_SHAPE_ZERO_WIDTH_MARKS_BY_GDEF_EARLY,
   false, /* fallback_position */
 };
+
+
+#endif
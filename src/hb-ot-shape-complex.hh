@@ -167,6 +167,33 @@ struct hb_ot_complex_shaper_t
   bool fallback_position;
 };
 
+/* Scripts of shapers compiled out (see hb-config.hh) get the default one. */
+#if defined(HB_NO_OT_SHAPE_COMPLEX_ARABIC)
+#define _hb_ot_complex_shaper_arabic _hb_ot_complex_shaper_default
+#endif
+#if defined(HB_NO_OT_SHAPE_COMPLEX_HANGUL)
+#define _hb_ot_complex_shaper_hangul _hb_ot_complex_shaper_default
+#endif
+#if defined(HB_NO_OT_SHAPE_COMPLEX_HEBREW)
+#define _hb_ot_complex_shaper_hebrew _hb_ot_complex_shaper_default
+#endif
+#if defined(HB_NO_OT_SHAPE_COMPLEX_INDIC)
+#define _hb_ot_complex_shaper_indic _hb_ot_complex_shaper_default
+#endif
+#if defined(HB_NO_OT_SHAPE_COMPLEX_KHMER)
+#define _hb_ot_complex_shaper_khmer _hb_ot_complex_shaper_default
+#endif
+#if defined(HB_NO_OT_SHAPE_COMPLEX_MYANMAR)
+#define _hb_ot_complex_shaper_myanmar _hb_ot_complex_shaper_default
+#define _hb_ot_complex_shaper_myanmar_zawgyi _hb_ot_complex_shaper_default
+#endif
+#if defined(HB_NO_OT_SHAPE_COMPLEX_THAI)
+#define _hb_ot_complex_shaper_thai _hb_ot_complex_shaper_default
+#endif
+#if defined(HB_NO_OT_SHAPE_COMPLEX_USE)
+#define _hb_ot_complex_shaper_use _hb_ot_complex_shaper_default
+#endif
+
 #define HB_COMPLEX_SHAPER_IMPLEMENT(name) extern HB_INTERNAL const hb_ot_complex_shaper_t _hb_ot_complex_shaper_##name;
 HB_COMPLEX_SHAPERS_IMPLEMENT_SHAPERS
 #undef HB_COMPLEX_SHAPER_IMPLEMENT
@@ -181,6 +181,36 @@ _hb_ot_shape_fallback_mark_position_recategorize_marks (const hb_ot_shape_plan_t
 }
 
 
+/* Remembers glyph extents for the duration of one buffer.  Text that needs
+ * fallback mark positioning tends to reuse a handful of marks and bases, and
+ * with glyf or CFF each get_glyph_extents() call means parsing an outline. */
+struct fallback_extents_cache_t
+{
+  fallback_extents_cache_t (hb_font_t *font_) : font (font_)
+  {
+    for (unsigned int i = 0; i < ARRAY_LENGTH (glyphs); i++)
+      glyphs[i] = HB_SET_VALUE_INVALID;
+  }
+
+  bool get_glyph_extents (hb_codepoint_t glyph, hb_glyph_extents_t *extents)
+  {
+    unsigned int i = glyph % ARRAY_LENGTH (glyphs);
+    if (glyphs[i] != glyph)
+    {
+      glyphs[i] = glyph;
+      found[i] = font->get_glyph_extents (glyph, &items[i]);
+    }
+    *extents = items[i];
+    return found[i];
+  }
+
+  private:
+  hb_font_t *font;
+  hb_codepoint_t glyphs[32];
+  hb_glyph_extents_t items[32];
+  bool found[32];
+};
+
 static void
 zero_mark_advances (hb_buffer_t *buffer,
 		    unsigned int start,
@@ -204,13 +234,14 @@ zero_mark_advances (hb_buffer_t *buffer,
 static inline void
 position_mark (const hb_ot_shape_plan_t *plan HB_UNUSED,
 	       hb_font_t *font,
+	       fallback_extents_cache_t *extents_cache,
 	       hb_buffer_t  *buffer,
 	       hb_glyph_extents_t &base_extents,
 	       unsigned int i,
 	       unsigned int combining_class)
 {
   hb_glyph_extents_t mark_extents;
-  if (!font->get_glyph_extents (buffer->info[i].codepoint, &mark_extents))
+  if (!extents_cache->get_glyph_extents (buffer->info[i].codepoint, &mark_extents))
     return;
 
   hb_position_t y_gap = font->y_scale / 16;
@@ -311,18 +342,23 @@ position_mark (const hb_ot_shape_plan_t *plan HB_UNUSED,
 static inline void
 position_around_base (const hb_ot_shape_plan_t *plan,
 		      hb_font_t *font,
+		      fallback_extents_cache_t *extents_cache,
 		      hb_buffer_t  *buffer,
 		      unsigned int base,
 		      unsigned int end,
 		      bool adjust_offsets_when_zeroing)
 {
+  /* No marks on this base; don't bother with its extents. */
+  if (end - base < 2)
+    return;
+
   hb_direction_t horiz_dir = HB_DIRECTION_INVALID;
 
   buffer->unsafe_to_break (base, end);
 
   hb_glyph_extents_t base_extents;
-  if (!font->get_glyph_extents (buffer->info[base].codepoint,
-				&base_extents))
+  if (!extents_cache->get_glyph_extents (buffer->info[base].codepoint,
+					 &base_extents))
   {
     /* If extents don't work, zero marks and go home. */
     zero_mark_advances (buffer, base + 1, end, adjust_offsets_when_zeroing);
@@ -386,7 +422,7 @@ position_around_base (const hb_ot_shape_plan_t *plan,
         cluster_extents = component_extents;
       }
 
-      position_mark (plan, font, buffer, cluster_extents, i, this_combining_class);
+      position_mark (plan, font, extents_cache, buffer, cluster_extents, i, this_combining_class);
 
       buffer->pos[i].x_advance = 0;
       buffer->pos[i].y_advance = 0;
@@ -407,6 +443,7 @@ position_around_base (const hb_ot_shape_plan_t *plan,
 static inline void
 position_cluster (const hb_ot_shape_plan_t *plan,
 		  hb_font_t *font,
+		  fallback_extents_cache_t *extents_cache,
 		  hb_buffer_t  *buffer,
 		  unsigned int start,
 		  unsigned int end,
@@ -426,7 +463,7 @@ position_cluster (const hb_ot_shape_plan_t *plan,
 	if (!HB_UNICODE_GENERAL_CATEGORY_IS_MARK (_hb_glyph_info_get_general_category (&info[j])))
 	  break;
 
-      position_around_base (plan, font, buffer, i, j, adjust_offsets_when_zeroing);
+      position_around_base (plan, font, extents_cache, buffer, i, j, adjust_offsets_when_zeroing);
 
       i = j - 1;
     }
@@ -444,15 +481,17 @@ _hb_ot_shape_fallback_mark_position (const hb_ot_shape_plan_t *plan,
 
   _hb_buffer_assert_gsubgpos_vars (buffer);
 
+  fallback_extents_cache_t extents_cache (font);
+
   unsigned int start = 0;
   unsigned int count = buffer->len;
   hb_glyph_info_t *info = buffer->info;
   for (unsigned int i = 1; i < count; i++)
     if (likely (!HB_UNICODE_GENERAL_CATEGORY_IS_MARK (_hb_glyph_info_get_general_category (&info[i])))) {
-      position_cluster (plan, font, buffer, start, i, adjust_offsets_when_zeroing);
+      position_cluster (plan, font, &extents_cache, buffer, start, i, adjust_offsets_when_zeroing);
       start = i;
     }
-  position_cluster (plan, font, buffer, start, count, adjust_offsets_when_zeroing);
+  position_cluster (plan, font, &extents_cache, buffer, start, count, adjust_offsets_when_zeroing);
 }
 
 
@@ -88,6 +88,170 @@ compose_unicode (const hb_ot_shape_normalize_context_t *c,
   return (bool) c->unicode->compose (a, b, ab);
 }
 
+
+#ifndef HB_OT_COMPOSE_CACHE_SIZE
+#define HB_OT_COMPOSE_CACHE_SIZE 256
+#endif
+#ifndef HB_OT_DECOMPOSE_CACHE_SIZE
+#define HB_OT_DECOMPOSE_CACHE_SIZE 128
+#endif
+
+/* What the normalizer worked out for a font, so it need not ask the
+ * font again: recomposition results, (starter, mark) to the composed
+ * character and its glyph, or to NOT_COMPOSED if that doesn't compose
+ * or the font lacks it; and what decompose_current_character() did with
+ * characters the font has no glyph for.  Only used with the default
+ * Unicode functions, and dropped whenever the font's serial changes. */
+struct hb_ot_normalize_cache_t
+{
+  static constexpr hb_codepoint_t NOT_COMPOSED = (hb_codepoint_t) -1;
+
+  struct compose_entry_t
+  {
+    hb_codepoint_t a, b; /* b is a mark, so zero marks an empty entry. */
+    hb_codepoint_t ab;
+    hb_codepoint_t glyph;
+  };
+
+  enum decision_t
+  {
+    EMPTY,		/* Unused entry. */
+    GLYPH,		/* Kept, with glyphs[0]. */
+    SPACE_FALLBACK,	/* Kept, with the space glyph glyphs[0]. */
+    DECOMPOSED		/* Replaced with len chars and glyphs. */
+  };
+
+  enum { MAX_DECOMPOSED = 4 };
+
+  struct decompose_entry_t
+  {
+    hb_codepoint_t u;
+    uint8_t decision;
+    uint8_t len;
+    uint8_t space_type;
+    hb_codepoint_t chars[MAX_DECOMPOSED];
+    hb_codepoint_t glyphs[MAX_DECOMPOSED];
+  };
+
+  static unsigned int bucket (hb_codepoint_t a, hb_codepoint_t b)
+  { return ((a * 31u + b) * 2654435761u >> 16) % HB_OT_COMPOSE_CACHE_SIZE; }
+  static unsigned int bucket (hb_codepoint_t u)
+  { return (u * 2654435761u >> 16) % HB_OT_DECOMPOSE_CACHE_SIZE; }
+
+  bool get_composed (unsigned int font_serial, hb_codepoint_t a, hb_codepoint_t b,
+		     hb_codepoint_t *ab, hb_codepoint_t *glyph)
+  {
+    hb_lock_t l (lock);
+    const compose_entry_t &e = composed[bucket (a, b)];
+    if (serial != font_serial || !e.b || e.a != a || e.b != b)
+      return false;
+    *ab = e.ab;
+    *glyph = e.glyph;
+    return true;
+  }
+
+  void set_composed (unsigned int font_serial, hb_codepoint_t a, hb_codepoint_t b,
+		     hb_codepoint_t ab, hb_codepoint_t glyph)
+  {
+    hb_lock_t l (lock);
+    reset_if_stale (font_serial);
+    compose_entry_t &e = composed[bucket (a, b)];
+    e.a = a;
+    e.b = b;
+    e.ab = ab;
+    e.glyph = glyph;
+  }
+
+  bool get_decomposed (unsigned int font_serial, hb_codepoint_t u,
+		       decompose_entry_t *entry)
+  {
+    hb_lock_t l (lock);
+    const decompose_entry_t &e = decomposed[bucket (u)];
+    if (serial != font_serial || e.decision == EMPTY || e.u != u)
+      return false;
+    *entry = e;
+    return true;
+  }
+
+  void set_decomposed (unsigned int font_serial, const decompose_entry_t &entry)
+  {
+    hb_lock_t l (lock);
+    reset_if_stale (font_serial);
+    decomposed[bucket (entry.u)] = entry;
+  }
+
+  private:
+  void reset_if_stale (unsigned int font_serial)
+  {
+    if (serial == font_serial) return;
+    memset (composed, 0, sizeof (composed));
+    memset (decomposed, 0, sizeof (decomposed));
+    serial = font_serial;
+  }
+
+  public:
+  hb_mutex_t lock;
+  unsigned int serial;
+  compose_entry_t composed[HB_OT_COMPOSE_CACHE_SIZE];
+  decompose_entry_t decomposed[HB_OT_DECOMPOSE_CACHE_SIZE];
+};
+
+/* Creates the normalizer cache of font on first use; nullptr if that fails. */
+static hb_ot_normalize_cache_t *
+get_normalize_cache (hb_font_t *font)
+{
+retry:
+  hb_ot_normalize_cache_t *cache = font->normalize_cache.get ();
+  if (unlikely (!cache))
+  {
+    if (unlikely (hb_object_is_inert (font)))
+      return nullptr;
+
+    cache = (hb_ot_normalize_cache_t *) calloc (1, sizeof (hb_ot_normalize_cache_t));
+    if (unlikely (!cache))
+      return nullptr;
+    cache->lock.init ();
+
+    if (unlikely (!font->normalize_cache.cmpexch (nullptr, cache)))
+    {
+      _hb_ot_normalize_cache_destroy (cache);
+      goto retry;
+    }
+  }
+  return cache;
+}
+
+void
+_hb_ot_normalize_cache_destroy (hb_ot_normalize_cache_t *cache)
+{
+  if (!cache) return;
+  cache->lock.fini ();
+  free (cache);
+}
+
+unsigned int
+_hb_ot_normalize_cache_get_memory_usage (hb_ot_normalize_cache_t *cache)
+{
+  return cache ? sizeof (*cache) : 0;
+}
+
+/* Whether a and b compose to a character the font has a glyph for. */
+static inline bool
+compose_to_glyph (const hb_ot_shape_normalize_context_t *c,
+		  hb_ot_normalize_cache_t *cache,
+		  hb_codepoint_t a, hb_codepoint_t b,
+		  hb_codepoint_t *ab, hb_codepoint_t *glyph)
+{
+  if (cache && cache->get_composed (c->font->serial, a, b, ab, glyph))
+    return *ab != hb_ot_normalize_cache_t::NOT_COMPOSED;
+
+  bool ret = c->compose (c, a, b, ab) &&
+	     c->font->get_nominal_glyph (*ab, glyph);
+  if (cache)
+    cache->set_composed (c->font->serial, a, b, ret ? *ab : hb_ot_normalize_cache_t::NOT_COMPOSED, ret ? *glyph : 0);
+  return ret;
+}
+
 static inline void
 set_glyph (hb_glyph_info_t &info, hb_font_t *font)
 {
@@ -159,6 +323,30 @@ decompose (const hb_ot_shape_normalize_context_t *c, bool shortest, hb_codepoint
   return 0;
 }
 
+static inline void
+apply_decision (hb_buffer_t *buffer,
+		const hb_ot_normalize_cache_t::decompose_entry_t &e)
+{
+  switch (e.decision)
+  {
+  case hb_ot_normalize_cache_t::DECOMPOSED:
+    for (unsigned int i = 0; i < e.len; i++)
+      output_char (buffer, e.chars[i], e.glyphs[i]);
+    skip_char (buffer);
+    return;
+
+  case hb_ot_normalize_cache_t::SPACE_FALLBACK:
+    _hb_glyph_info_set_unicode_space_fallback_type (&buffer->cur(), (hb_unicode_funcs_t::space_t) e.space_type);
+    next_char (buffer, e.glyphs[0]);
+    buffer->scratch_flags |= HB_BUFFER_SCRATCH_FLAG_HAS_SPACE_FALLBACK;
+    return;
+
+  default:
+    next_char (buffer, e.glyphs[0]);
+    return;
+  }
+}
+
 static inline void
 decompose_current_character (const hb_ot_shape_normalize_context_t *c, bool shortest)
 {
@@ -172,9 +360,36 @@ decompose_current_character (const hb_ot_shape_normalize_context_t *c, bool shor
     return;
   }
 
-  if (decompose (c, shortest, u))
+  /* The font lacks u.  What to do instead only depends on the font, so
+   * is remembered for the next time u comes along. */
+  hb_ot_normalize_cache_t *cache = shortest && c->decompose == decompose_unicode ?
+				   c->cache : nullptr;
+  hb_ot_normalize_cache_t::decompose_entry_t e;
+  if (cache && cache->get_decomposed (c->font->serial, u, &e))
+  {
+    apply_decision (buffer, e);
+    return;
+  }
+  e.u = u;
+  e.len = 0;
+  e.space_type = hb_unicode_funcs_t::NOT_SPACE;
+
+  unsigned int out_len = buffer->out_len;
+  unsigned int ret = decompose (c, shortest, u);
+  if (ret)
   {
     skip_char (buffer);
+    if (cache && ret <= hb_ot_normalize_cache_t::MAX_DECOMPOSED && buffer->successful)
+    {
+      e.decision = hb_ot_normalize_cache_t::DECOMPOSED;
+      e.len = ret;
+      for (unsigned int i = 0; i < ret; i++)
+      {
+	e.chars[i] = buffer->out_info[out_len + i].codepoint;
+	e.glyphs[i] = buffer->out_info[out_len + i].glyph_index();
+      }
+      cache->set_decomposed (c->font->serial, e);
+    }
     return;
   }
 
@@ -184,32 +399,32 @@ decompose_current_character (const hb_ot_shape_normalize_context_t *c, bool shor
     return;
   }
 
+  e.decision = hb_ot_normalize_cache_t::GLYPH;
+  e.glyphs[0] = glyph; /* glyph is initialized in earlier branches. */
+
   if (_hb_glyph_info_is_unicode_space (&buffer->cur()))
   {
     hb_codepoint_t space_glyph;
     hb_unicode_funcs_t::space_t space_type = buffer->unicode->space_fallback_type (u);
     if (space_type != hb_unicode_funcs_t::NOT_SPACE && c->font->get_nominal_glyph (0x0020u, &space_glyph))
     {
-      _hb_glyph_info_set_unicode_space_fallback_type (&buffer->cur(), space_type);
-      next_char (buffer, space_glyph);
-      buffer->scratch_flags |= HB_BUFFER_SCRATCH_FLAG_HAS_SPACE_FALLBACK;
-      return;
+      e.decision = hb_ot_normalize_cache_t::SPACE_FALLBACK;
+      e.space_type = space_type;
+      e.glyphs[0] = space_glyph;
     }
   }
-
-  if (u == 0x2011u)
+  else if (u == 0x2011u)
   {
     /* U+2011 is the only sensible character that is a no-break version of another character
      * and not a space.  The space ones are handled already.  Handle this lone one. */
     hb_codepoint_t other_glyph;
     if (c->font->get_nominal_glyph (0x2010u, &other_glyph))
-    {
-      next_char (buffer, other_glyph);
-      return;
-    }
+      e.glyphs[0] = other_glyph;
   }
 
-  next_char (buffer, glyph); /* glyph is initialized in earlier branches. */
+  if (cache)
+    cache->set_decomposed (c->font->serial, e);
+  apply_decision (buffer, e);
 }
 
 static inline void
@@ -297,15 +512,6 @@ _hb_ot_shape_normalize (const hb_ot_shape_plan_t *plan,
       mode = HB_OT_SHAPE_NORMALIZATION_MODE_COMPOSED_DIACRITICS;
   }
 
-  const hb_ot_shape_normalize_context_t c = {
-    plan,
-    buffer,
-    font,
-    buffer->unicode,
-    plan->shaper->decompose ? plan->shaper->decompose : decompose_unicode,
-    plan->shaper->compose   ? plan->shaper->compose   : compose_unicode
-  };
-
   bool always_short_circuit = mode == HB_OT_SHAPE_NORMALIZATION_MODE_NONE;
   bool might_short_circuit = always_short_circuit ||
 			     (mode != HB_OT_SHAPE_NORMALIZATION_MODE_DECOMPOSED &&
@@ -319,6 +525,36 @@ _hb_ot_shape_normalize (const hb_ot_shape_plan_t *plan,
    * this way. */
 
 
+  /* Without marks every cluster is simple.  If the font also has glyphs for
+   * all the characters, none of the rounds below can change anything, so
+   * skip them without a round trip through the output buffer. */
+  unsigned int done = 0;
+  if (might_short_circuit &&
+      !(buffer->scratch_flags & HB_BUFFER_SCRATCH_FLAG_HAS_MARKS))
+  {
+    done = font->get_nominal_glyphs (buffer->len,
+				     &buffer->info[0].codepoint,
+				     sizeof (buffer->info[0]),
+				     &buffer->info[0].glyph_index(),
+				     sizeof (buffer->info[0]));
+    if (done == buffer->len)
+      return;
+  }
+
+
+  /* Documents repeat the same few decompositions and compositions;
+   * remember them per font, unless the Unicode functions might differ. */
+  const hb_ot_shape_normalize_context_t c = {
+    plan,
+    buffer,
+    font,
+    buffer->unicode,
+    plan->shaper->decompose ? plan->shaper->decompose : decompose_unicode,
+    plan->shaper->compose   ? plan->shaper->compose   : compose_unicode,
+    buffer->unicode == hb_unicode_funcs_get_default () ? get_normalize_cache (font) : nullptr
+  };
+
+
   /* First round, decompose */
 
   bool all_simple = true;
@@ -326,6 +562,7 @@ _hb_ot_shape_normalize (const hb_ot_shape_plan_t *plan,
     buffer->clear_output ();
     count = buffer->len;
     buffer->idx = 0;
+    buffer->next_glyphs (done); /* Already looked up above. */
     do
     {
       unsigned int end;
@@ -420,6 +657,9 @@ _hb_ot_shape_normalize (const hb_ot_shape_plan_t *plan,
     /* As noted in the comment earlier, we don't try to combine
      * ccc=0 chars with their previous Starter. */
 
+    /* A shaper's own composition may differ per plan. */
+    hb_ot_normalize_cache_t *cache = c.compose == compose_unicode ? c.cache : nullptr;
+
     buffer->clear_output ();
     count = buffer->len;
     unsigned int starter = 0;
@@ -437,13 +677,11 @@ _hb_ot_shape_normalize (const hb_ot_shape_plan_t *plan,
 	     * smaller than this character's. */
 	    (starter == buffer->out_len - 1 ||
 	     info_cc (buffer->prev()) < info_cc (buffer->cur())) &&
-	    /* And compose. */
-	    c.compose (&c,
-		       buffer->out_info[starter].codepoint,
-		       buffer->cur().codepoint,
-		       &composed) &&
-	    /* And the font has glyph for the composite. */
-	    font->get_nominal_glyph (composed, &glyph))
+	    /* And compose, to a composite the font has a glyph for. */
+	    compose_to_glyph (&c, cache,
+			      buffer->out_info[starter].codepoint,
+			      buffer->cur().codepoint,
+			      &composed, &glyph))
 	{
 	  /* Composes. */
 	  buffer->next_glyph (); /* Copy to out-buffer. */
@@ -34,6 +34,7 @@
 #define glyph_index()	var1.u32
 
 struct hb_ot_shape_plan_t;
+struct hb_ot_normalize_cache_t;
 
 enum hb_ot_shape_normalization_mode_t {
   HB_OT_SHAPE_NORMALIZATION_MODE_NONE,
@@ -64,6 +65,7 @@ struct hb_ot_shape_normalize_context_t
 		   hb_codepoint_t  a,
 		   hb_codepoint_t  b,
 		   hb_codepoint_t *ab);
+  hb_ot_normalize_cache_t *cache; /* May be nullptr. */
 };
 
 
@@ -30,6 +30,7 @@
 
 #include "hb-ot-shape.hh"
 #include "hb-ot-shape-complex.hh"
+#include "hb-ot-shape-complex-arabic.hh"
 #include "hb-ot-shape-fallback.hh"
 #include "hb-ot-shape-normalize.hh"
 
@@ -87,15 +88,22 @@ hb_ot_shape_planner_t::hb_ot_shape_planner_t (hb_face_t                     *fac
     shaper = &_hb_ot_complex_shaper_default;
 }
 
-void
+bool
 hb_ot_shape_planner_t::compile (hb_ot_shape_plan_t           &plan,
-				const hb_ot_shape_plan_key_t &key)
+				const hb_ot_shape_plan_key_t &key,
+				hb_array_t<const uint32_t>   *serialized_map)
 {
   plan.props = props;
   plan.shaper = shaper;
-  map.compile (plan.map, key);
+  if (!serialized_map)
+    map.compile (plan.map, key);
+  else if (unlikely (!map.compile_serialized (plan.map, *serialized_map) ||
+		     serialized_map->length /* Trailing garbage. */))
+    return false;
+#if !defined(HB_NO_AAT)
   if (apply_morx)
     aat_map.compile (plan.aat_map);
+#endif
 
   plan.frac_mask = plan.map.get_1_mask (HB_TAG ('f','r','a','c'));
   plan.numr_mask = plan.map.get_1_mask (HB_TAG ('n','u','m','r'));
@@ -160,14 +168,39 @@ hb_ot_shape_planner_t::compile (hb_ot_shape_plan_t           &plan,
 
   /* Currently we always apply trak. */
   plan.apply_trak = plan.requested_tracking && hb_aat_layout_has_tracking (face);
+
+  plan.cmap_glyphs_final = !plan.apply_morx &&
+			   !plan.map.has_work (0) &&
+			   !plan.shaper->postprocess_glyphs;
+
+  if (HB_DIRECTION_IS_BACKWARD (props.direction))
+  {
+    /* Walk the cmap rather than the Unicode mirroring data, which we can't
+     * enumerate; mirroring pairs are involutions, so each supported mirror
+     * tells us its source. */
+    hb_unicode_funcs_t *unicode = hb_unicode_funcs_get_default ();
+    hb_set_t unicodes;
+    hb_face_collect_unicodes (face, &unicodes);
+    for (hb_codepoint_t u = HB_SET_VALUE_INVALID;
+	 unicodes.next (&u) && u < 0x10000u;)
+    {
+      hb_codepoint_t m = unicode->mirroring (u);
+      if (m != u && m < 0x10000u && unicode->mirroring (m) == u)
+	plan.mirrors.set (m, u);
+    }
+  }
+
+  return true;
 }
 
 bool
 hb_ot_shape_plan_t::init0 (hb_face_t                     *face,
-			   const hb_shape_plan_key_t     *key)
+			   const hb_shape_plan_key_t     *key,
+			   hb_array_t<const uint32_t>    *serialized_map)
 {
   map.init ();
   aat_map.init ();
+  mirrors.init ();
 
   hb_ot_shape_planner_t planner (face,
 				 &key->props);
@@ -176,7 +209,13 @@ hb_ot_shape_plan_t::init0 (hb_face_t                     *face,
 				key->user_features,
 				key->num_user_features);
 
-  planner.compile (*this, key->ot);
+  if (unlikely (!planner.compile (*this, key->ot, serialized_map)))
+  {
+    map.fini ();
+    aat_map.fini ();
+    mirrors.fini ();
+    return false;
+  }
 
   if (shaper->data_create)
   {
@@ -196,15 +235,18 @@ hb_ot_shape_plan_t::fini ()
 
   map.fini ();
   aat_map.fini ();
+  mirrors.fini ();
 }
 
 void
 hb_ot_shape_plan_t::substitute (hb_font_t   *font,
 				hb_buffer_t *buffer) const
 {
+#if !defined(HB_NO_AAT)
   if (unlikely (apply_morx))
     hb_aat_layout_substitute (this, font, buffer);
   else
+#endif
     map.substitute (this, font, buffer);
 }
 
@@ -214,15 +256,21 @@ hb_ot_shape_plan_t::position (hb_font_t   *font,
 {
   if (this->apply_gpos)
     map.position (this, font, buffer);
+#if !defined(HB_NO_AAT)
   else if (this->apply_kerx)
     hb_aat_layout_position (this, font, buffer);
+#endif
+#if !defined(HB_NO_OT_KERN)
   else if (this->apply_kern)
     hb_ot_layout_kern (this, font, buffer);
+#endif
   else
     _hb_ot_shape_fallback_kern (this, font, buffer);
 
+#if !defined(HB_NO_AAT)
   if (this->apply_trak)
     hb_aat_layout_track (this, font, buffer);
+#endif
 }
 
 
@@ -318,6 +366,7 @@ hb_ot_shape_collect_features (hb_ot_shape_planner_t          *planner,
 		      feature->value);
   }
 
+#if !defined(HB_NO_AAT)
   if (planner->apply_morx)
   {
     hb_aat_map_builder_t *aat_map = &planner->aat_map;
@@ -327,6 +376,7 @@ hb_ot_shape_collect_features (hb_ot_shape_planner_t          *planner,
       aat_map->add_feature (feature->tag, feature->value);
     }
   }
+#endif
 
   if (planner->shaper->override_features)
     planner->shaper->override_features (planner);
@@ -337,17 +387,21 @@ hb_ot_shape_collect_features (hb_ot_shape_planner_t          *planner,
  * shaper face data
  */
 
-struct hb_ot_face_data_t {};
-
 hb_ot_face_data_t *
 _hb_ot_shaper_face_data_create (hb_face_t *face)
 {
-  return (hb_ot_face_data_t *) HB_SHAPER_DATA_SUCCEEDED;
+  return (hb_ot_face_data_t *) calloc (1, sizeof (hb_ot_face_data_t));
 }
 
 void
 _hb_ot_shaper_face_data_destroy (hb_ot_face_data_t *data)
 {
+#if !defined(HB_NO_OT_SHAPE_COMPLEX_ARABIC)
+  arabic_fallback_face_data_destroy (data->arabic_fallback);
+#endif
+  free (data->hangul.get ());
+  free (data->thai_pua.get ());
+  free (data);
 }
 
 
@@ -393,6 +447,10 @@ struct hb_ot_shape_context_t
 
 /* Prepare */
 
+#ifndef HB_OT_SHAPE_UNICODE_PROPS_BATCH
+#define HB_OT_SHAPE_UNICODE_PROPS_BATCH 64
+#endif
+
 static void
 hb_set_unicode_props (hb_buffer_t *buffer)
 {
@@ -406,9 +464,26 @@ hb_set_unicode_props (hb_buffer_t *buffer)
    */
   unsigned int count = buffer->len;
   hb_glyph_info_t *info = buffer->info;
+
+  /* Look properties up in batches, through the batch unicode funcs. */
+  hb_unicode_props_t uprops[HB_OT_SHAPE_UNICODE_PROPS_BATCH];
+  unsigned int batch_start = 0, batch_end = 0;
+  auto get_uprops = [&] (unsigned int i) -> const hb_unicode_props_t *
+  {
+    if (i >= batch_end)
+    {
+      batch_start = i;
+      batch_end = hb_min (count, i + HB_OT_SHAPE_UNICODE_PROPS_BATCH);
+      buffer->unicode->get_props (batch_end - batch_start,
+				  &info[i].codepoint, sizeof (info[0]),
+				  uprops);
+    }
+    return &uprops[i - batch_start];
+  };
+
   for (unsigned int i = 0; i < count; i++)
   {
-    _hb_glyph_info_set_unicode_props (&info[i], buffer);
+    _hb_glyph_info_set_unicode_props (&info[i], buffer, get_uprops (i));
 
     /* Marks are already set as continuation by the above line.
      * Handle Emoji_Modifier and ZWJ-continuation. */
@@ -424,7 +499,7 @@ hb_set_unicode_props (hb_buffer_t *buffer)
 	  _hb_unicode_is_emoji_Extended_Pictographic (info[i + 1].codepoint))
       {
         i++;
-	_hb_glyph_info_set_unicode_props (&info[i], buffer);
+	_hb_glyph_info_set_unicode_props (&info[i], buffer, get_uprops (i));
 	_hb_glyph_info_set_continuation (&info[i]);
       }
     }
@@ -539,6 +614,34 @@ hb_ot_mirror_chars (const hb_ot_shape_context_t *c)
 
   unsigned int count = buffer->len;
   hb_glyph_info_t *info = buffer->info;
+
+  /* The plan knows which BMP characters have a mirror the font supports,
+   * if the font and the Unicode functions are the ones it was made with. */
+  if (unicode == hb_unicode_funcs_get_default () &&
+      _hb_ot_font_has_face_cmap (c->font))
+  {
+    const hb_map_t &mirrors = c->plan->mirrors;
+    for (unsigned int i = 0; i < count; i++)
+    {
+      hb_codepoint_t u = info[i].codepoint;
+      hb_codepoint_t m;
+      if (unlikely (u >= 0x10000u))
+      {
+	m = unicode->mirroring (u);
+	if (m == u || !c->font->has_glyph (m))
+	  m = HB_MAP_VALUE_INVALID;
+      }
+      else
+	m = mirrors.get (u);
+
+      if (likely (m == HB_MAP_VALUE_INVALID))
+	info[i].mask |= rtlm_mask;
+      else
+	info[i].codepoint = m;
+    }
+    return;
+  }
+
   for (unsigned int i = 0; i < count; i++) {
     hb_codepoint_t codepoint = unicode->mirroring (info[i].codepoint);
     if (likely (codepoint == info[i].codepoint || !c->font->has_glyph (codepoint)))
@@ -608,6 +711,102 @@ hb_ot_shape_initialize_masks (const hb_ot_shape_context_t *c)
   buffer->reset_masks (global_mask);
 }
 
+/* A cluster range with no ranged-feature boundary inside it, and the
+ * combined effect of all ranged features on it. */
+struct hb_ot_shape_mask_range_t
+{
+  unsigned int start;
+  unsigned int end;
+  hb_mask_t mask;
+  hb_mask_t value;
+
+  int cmp (unsigned int cluster) const
+  { return cluster < start ? -1 : cluster >= end ? 1 : 0; }
+
+  static int cmp_point (const void *pa, const void *pb)
+  {
+    unsigned int a = * (const unsigned int *) pa;
+    unsigned int b = * (const unsigned int *) pb;
+    return a < b ? -1 : a > b ? 1 : 0;
+  }
+};
+
+/* Applies all ranged user features in one pass over the buffer.  Feature
+ * boundaries split the cluster space into ranges; each range gets the masks
+ * of all features covering it, in feature order, so later features still
+ * override earlier ones.  Returns false on allocation failure. */
+static bool
+hb_ot_shape_setup_ranged_masks (const hb_ot_shape_context_t *c)
+{
+  hb_ot_map_t *map = &c->plan->map;
+  hb_buffer_t *buffer = c->buffer;
+
+  /* Scratch lives in the buffer's arena until the end of shaping. */
+  unsigned int *points = buffer->arena.alloc_array<unsigned int> (2 * c->num_user_features);
+  hb_ot_shape_mask_range_t *range_array = buffer->arena.alloc_array<hb_ot_shape_mask_range_t> (2 * c->num_user_features);
+  if (unlikely (!points || !range_array))
+    return false;
+
+  unsigned int num_points = 0;
+  for (unsigned int i = 0; i < c->num_user_features; i++)
+  {
+    const hb_feature_t *feature = &c->user_features[i];
+    if (feature->start == 0 && feature->end == (unsigned int) -1)
+      continue;
+    points[num_points++] = feature->start;
+    points[num_points++] = feature->end;
+  }
+  hb_array (points, num_points).qsort (hb_ot_shape_mask_range_t::cmp_point);
+
+  unsigned int num_ranges = 0;
+  for (unsigned int i = 1; i < num_points; i++)
+  {
+    if (points[i] == points[i - 1])
+      continue;
+    hb_ot_shape_mask_range_t *range = &range_array[num_ranges++];
+    range->start = points[i - 1];
+    range->end = points[i];
+    range->mask = range->value = 0;
+  }
+  if (!num_ranges)
+    return true;
+  hb_sorted_array_t<hb_ot_shape_mask_range_t> ranges (range_array, num_ranges);
+
+  for (unsigned int i = 0; i < c->num_user_features; i++)
+  {
+    const hb_feature_t *feature = &c->user_features[i];
+    if (feature->start == 0 && feature->end == (unsigned int) -1)
+      continue;
+    unsigned int shift;
+    hb_mask_t mask = map->get_mask (feature->tag, &shift);
+    hb_mask_t value = (feature->value << shift) & mask;
+    unsigned int j;
+    if (!mask || !ranges.bfind (feature->start, &j))
+      continue;
+    for (; j < ranges.length && ranges[j].start < feature->end; j++)
+    {
+      ranges[j].mask |= mask;
+      ranges[j].value = (ranges[j].value & ~mask) | value;
+    }
+  }
+
+  /* Clusters are mostly monotone, so check the last range first. */
+  hb_glyph_info_t *info = buffer->info;
+  unsigned int count = buffer->len;
+  unsigned int j = 0;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    unsigned int cluster = info[i].cluster;
+    if (ranges[j].cmp (cluster) && !ranges.bfind (cluster, &j))
+    {
+      j = 0;
+      continue;
+    }
+    info[i].mask = (info[i].mask & ~ranges[j].mask) | ranges[j].value;
+  }
+  return true;
+}
+
 static inline void
 hb_ot_shape_setup_masks (const hb_ot_shape_context_t *c)
 {
@@ -619,6 +818,15 @@ hb_ot_shape_setup_masks (const hb_ot_shape_context_t *c)
   if (c->plan->shaper->setup_masks)
     c->plan->shaper->setup_masks (c->plan, buffer, c->font);
 
+  /* With more than one ranged feature, do a single pass over the buffer
+   * instead of one per feature. */
+  unsigned int num_ranged = 0;
+  for (unsigned int i = 0; i < c->num_user_features; i++)
+    if (!(c->user_features[i].start == 0 && c->user_features[i].end == (unsigned int)-1))
+      num_ranged++;
+  if (num_ranged > 1 && hb_ot_shape_setup_ranged_masks (c))
+    return;
+
   for (unsigned int i = 0; i < c->num_user_features; i++)
   {
     const hb_feature_t *feature = &c->user_features[i];
@@ -630,47 +838,78 @@ hb_ot_shape_setup_masks (const hb_ot_shape_context_t *c)
   }
 }
 
+/* Zeroes the positions of default-ignorables left in the buffer and,
+ * with morx, of deleted glyphs, in one pass. */
 static void
-hb_ot_zero_width_default_ignorables (const hb_buffer_t *buffer)
+hb_ot_zero_width_default_ignorables (const hb_buffer_t *buffer,
+				     bool               zero_deleted)
 {
-  if (!(buffer->scratch_flags & HB_BUFFER_SCRATCH_FLAG_HAS_DEFAULT_IGNORABLES) ||
-      (buffer->flags & HB_BUFFER_FLAG_PRESERVE_DEFAULT_IGNORABLES) ||
-      (buffer->flags & HB_BUFFER_FLAG_REMOVE_DEFAULT_IGNORABLES))
+  bool zero_ignorables = (buffer->scratch_flags & HB_BUFFER_SCRATCH_FLAG_HAS_DEFAULT_IGNORABLES) &&
+			 !(buffer->flags & HB_BUFFER_FLAG_PRESERVE_DEFAULT_IGNORABLES) &&
+			 !(buffer->flags & HB_BUFFER_FLAG_REMOVE_DEFAULT_IGNORABLES);
+  if (!zero_ignorables && !zero_deleted)
     return;
 
-  unsigned int count = buffer->len;
-  hb_glyph_info_t *info = buffer->info;
-  hb_glyph_position_t *pos = buffer->pos;
-  unsigned int i = 0;
-  for (i = 0; i < count; i++)
-    if (unlikely (_hb_glyph_info_is_default_ignorable (&info[i])))
-      pos[i].x_advance = pos[i].y_advance = pos[i].x_offset = pos[i].y_offset = 0;
+  hb_array_t<hb_glyph_info_t> info = buffer->info_array ();
+  hb_array_t<hb_glyph_position_t> pos = buffer->pos_array ();
+  + hb_zip (info, pos)
+  | hb_filter ([=] (const hb_glyph_info_t &info)
+	       {
+		 return (zero_ignorables && unlikely (_hb_glyph_info_is_default_ignorable (&info))) ||
+			(zero_deleted && unlikely (info.codepoint == AAT::DELETED_GLYPH));
+	       }, hb_first)
+  | hb_map (hb_second)
+  | hb_apply ([] (hb_glyph_position_t &pos)
+	      { pos.x_advance = pos.y_advance = pos.x_offset = pos.y_offset = 0; })
+  ;
 }
 
+/* Replaces default-ignorables with the invisible glyph, or deletes them,
+ * and with morx deletes the glyphs it marked deleted.  Replacing and
+ * deleting share one pass. */
 static void
 hb_ot_hide_default_ignorables (hb_buffer_t *buffer,
-			       hb_font_t   *font)
+			       hb_font_t   *font,
+			       bool         remove_deleted)
 {
   if (!(buffer->scratch_flags & HB_BUFFER_SCRATCH_FLAG_HAS_DEFAULT_IGNORABLES) ||
       (buffer->flags & HB_BUFFER_FLAG_PRESERVE_DEFAULT_IGNORABLES))
+  {
+    if (remove_deleted)
+      hb_ot_layout_delete_glyphs_inplace (buffer, [] (const hb_glyph_info_t &info)
+					  { return info.codepoint == AAT::DELETED_GLYPH; });
     return;
-
-  unsigned int count = buffer->len;
-  hb_glyph_info_t *info = buffer->info;
+  }
 
   hb_codepoint_t invisible = buffer->invisible;
   if (!(buffer->flags & HB_BUFFER_FLAG_REMOVE_DEFAULT_IGNORABLES) &&
       (invisible || font->get_nominal_glyph (' ', &invisible)))
   {
     /* Replace default-ignorables with a zero-advance invisible glyph. */
-    for (unsigned int i = 0; i < count; i++)
-    {
-      if (_hb_glyph_info_is_default_ignorable (&info[i]))
-	info[i].codepoint = invisible;
-    }
+    if (!remove_deleted)
+      + hb_iter (buffer->info_array ())
+      | hb_filter ([] (const hb_glyph_info_t &info)
+		   { return _hb_glyph_info_is_default_ignorable (&info); })
+      | hb_apply ([=] (hb_glyph_info_t &info) { info.codepoint = invisible; })
+      ;
+    else
+      hb_ot_layout_delete_glyphs_inplace (buffer, [=] (hb_glyph_info_t &info)
+					  {
+					    if (_hb_glyph_info_is_default_ignorable (&info))
+					      info.codepoint = invisible;
+					    return info.codepoint == AAT::DELETED_GLYPH;
+					  });
   }
   else
-    hb_ot_layout_delete_glyphs_inplace (buffer, _hb_glyph_info_is_default_ignorable);
+  {
+    hb_ot_layout_delete_glyphs_inplace (buffer, [] (const hb_glyph_info_t &info)
+					{ return _hb_glyph_info_is_default_ignorable (&info); });
+    /* Not fused: clusters merged by the first pass change the masks the
+     * second one carries over. */
+    if (remove_deleted)
+      hb_ot_layout_delete_glyphs_inplace (buffer, [] (const hb_glyph_info_t &info)
+					  { return info.codepoint == AAT::DELETED_GLYPH; });
+  }
 }
 
 
@@ -712,6 +951,9 @@ hb_synthesize_glyph_classes (hb_buffer_t *buffer)
   }
 }
 
+static inline void
+hb_ot_position_default (const hb_ot_shape_context_t *c);
+
 static inline void
 hb_ot_substitute_default (const hb_ot_shape_context_t *c)
 {
@@ -731,6 +973,16 @@ hb_ot_substitute_default (const hb_ot_shape_context_t *c)
 
   hb_ot_map_glyphs_fast (buffer);
 
+  /* If these are the final glyphs, fetch their advances now, while the
+   * buffer is still in cache, instead of in hb_ot_position(). */
+  if (c->plan->cmap_glyphs_final &&
+      !(buffer->scratch_flags & HB_BUFFER_SCRATCH_FLAG_HAS_DEFAULT_IGNORABLES))
+  {
+    buffer->clear_positions ();
+    hb_ot_position_default (c);
+    buffer->scratch_flags |= HB_BUFFER_SCRATCH_FLAG_HAS_DEFAULT_POSITIONS;
+  }
+
   HB_BUFFER_DEALLOCATE_VAR (buffer, glyph_index);
 }
 
@@ -760,9 +1012,12 @@ hb_ot_substitute_pre (const hb_ot_shape_context_t *c)
 static inline void
 hb_ot_substitute_post (const hb_ot_shape_context_t *c)
 {
-  hb_ot_hide_default_ignorables (c->buffer, c->font);
-  if (c->plan->apply_morx)
-    hb_aat_layout_remove_deleted_glyphs (c->buffer);
+  /* morx flags the glyphs it deletes; so does an invisible glyph of
+   * DELETED_GLYPH, once hiding made it. */
+  hb_ot_hide_default_ignorables (c->buffer, c->font,
+				 c->plan->apply_morx &&
+				 ((c->buffer->scratch_flags & HB_BUFFER_SCRATCH_FLAG_AAT_HAS_DELETED) ||
+				  c->buffer->invisible == AAT::DELETED_GLYPH));
 
   if (c->plan->shaper->postprocess_glyphs)
     c->plan->shaper->postprocess_glyphs (c->plan, c->buffer, c->font);
@@ -809,26 +1064,32 @@ hb_ot_position_default (const hb_ot_shape_context_t *c)
   hb_glyph_info_t *info = c->buffer->info;
   hb_glyph_position_t *pos = c->buffer->pos;
 
+  /* Leaves offsets relative to the horizontal origin, which is what
+   * hb_ot_position_complex() works with; it moves them to the origin of
+   * direction when done.  So horizontal text needs no pass here. */
   if (HB_DIRECTION_IS_HORIZONTAL (direction))
   {
     c->font->get_glyph_h_advances (count, &info[0].codepoint, sizeof(info[0]),
                                    &pos[0].x_advance, sizeof(pos[0]));
-    /* The nil glyph_h_origin() func returns 0, so no need to apply it. */
-    if (c->font->has_glyph_h_origin_func ())
-      for (unsigned int i = 0; i < count; i++)
-	c->font->subtract_glyph_h_origin (info[i].codepoint,
-					  &pos[i].x_offset,
-					  &pos[i].y_offset);
   }
   else
   {
     c->font->get_glyph_v_advances (count, &info[0].codepoint, sizeof(info[0]),
                                    &pos[0].y_advance, sizeof(pos[0]));
+    /* Offsets are still zero; fetch the origins into them and negate. */
+    c->font->get_glyph_v_origins_with_fallback (count, &info[0].codepoint, sizeof(info[0]),
+						&pos[0].x_offset, sizeof(pos[0]),
+						&pos[0].y_offset, sizeof(pos[0]));
+    bool h_origin = c->font->has_glyph_h_origin_func ();
     for (unsigned int i = 0; i < count; i++)
     {
-      c->font->subtract_glyph_v_origin (info[i].codepoint,
-					&pos[i].x_offset,
-					&pos[i].y_offset);
+      pos[i].x_offset = -pos[i].x_offset;
+      pos[i].y_offset = -pos[i].y_offset;
+      /* The nil glyph_h_origin() func returns 0, so no need to apply it. */
+      if (h_origin)
+	c->font->add_glyph_h_origin (info[i].codepoint,
+				     &pos[i].x_offset,
+				     &pos[i].y_offset);
     }
   }
   if (c->buffer->scratch_flags & HB_BUFFER_SCRATCH_FLAG_HAS_SPACE_FALLBACK)
@@ -854,14 +1115,8 @@ hb_ot_position_complex (const hb_ot_shape_context_t *c)
   bool adjust_offsets_when_zeroing = c->plan->adjust_mark_positioning_when_zeroing &&
 				     HB_DIRECTION_IS_FORWARD (c->buffer->props.direction);
 
-  /* We change glyph origin to what GPOS expects (horizontal), apply GPOS, change it back. */
-
-  /* The nil glyph_h_origin() func returns 0, so no need to apply it. */
-  if (c->font->has_glyph_h_origin_func ())
-    for (unsigned int i = 0; i < count; i++)
-      c->font->add_glyph_h_origin (info[i].codepoint,
-				   &pos[i].x_offset,
-				   &pos[i].y_offset);
+  /* Offsets come in relative to the horizontal origin, which is what GPOS
+   * expects; apply GPOS, then change them back. */
 
   hb_ot_layout_position_start (c->font, c->buffer);
 
@@ -895,9 +1150,9 @@ hb_ot_position_complex (const hb_ot_shape_context_t *c)
 
   /* Finish off.  Has to follow a certain order. */
   hb_ot_layout_position_finish_advances (c->font, c->buffer);
-  hb_ot_zero_width_default_ignorables (c->buffer);
-  if (c->plan->apply_morx)
-    hb_aat_layout_zero_width_deleted_glyphs (c->buffer);
+  hb_ot_zero_width_default_ignorables (c->buffer,
+				       c->plan->apply_morx &&
+				       (c->buffer->scratch_flags & HB_BUFFER_SCRATCH_FLAG_AAT_HAS_DELETED));
   hb_ot_layout_position_finish_offsets (c->font, c->buffer);
 
   /* The nil glyph_h_origin() func returns 0, so no need to apply it. */
@@ -915,9 +1170,12 @@ hb_ot_position_complex (const hb_ot_shape_context_t *c)
 static inline void
 hb_ot_position (const hb_ot_shape_context_t *c)
 {
-  c->buffer->clear_positions ();
+  if (!(c->buffer->scratch_flags & HB_BUFFER_SCRATCH_FLAG_HAS_DEFAULT_POSITIONS))
+  {
+    c->buffer->clear_positions ();
 
-  hb_ot_position_default (c);
+    hb_ot_position_default (c);
+  }
 
   hb_ot_position_complex (c);
 
@@ -933,7 +1191,7 @@ hb_propagate_flags (hb_buffer_t *buffer)
   /* Propagate cluster-level glyph flags to be the same on all cluster glyphs.
    * Simplifies using them. */
 
-  if (!(buffer->scratch_flags & HB_BUFFER_SCRATCH_FLAG_HAS_UNSAFE_TO_BREAK))
+  if (!(buffer->scratch_flags & HB_BUFFER_SCRATCH_FLAG_HAS_GLYPH_FLAGS))
     return;
 
   hb_glyph_info_t *info = buffer->info;
@@ -942,11 +1200,7 @@ hb_propagate_flags (hb_buffer_t *buffer)
   {
     unsigned int mask = 0;
     for (unsigned int i = start; i < end; i++)
-      if (info[i].mask & HB_GLYPH_FLAG_UNSAFE_TO_BREAK)
-      {
-	 mask = HB_GLYPH_FLAG_UNSAFE_TO_BREAK;
-	 break;
-      }
+      mask |= info[i].mask & HB_GLYPH_FLAG_DEFINED;
     if (mask)
       for (unsigned int i = start; i < end; i++)
 	info[i].mask |= mask;
@@ -970,6 +1224,10 @@ hb_ot_shape_internal (hb_ot_shape_context_t *c)
     c->buffer->max_ops = hb_max (c->buffer->len * HB_BUFFER_MAX_OPS_FACTOR,
 			      (unsigned) HB_BUFFER_MAX_OPS_MIN);
   }
+  if (c->buffer->max_ops_budget)
+    c->buffer->max_ops = hb_min ((unsigned) c->buffer->max_ops,
+				 hb_min (c->buffer->max_ops_budget,
+					 (unsigned) HB_BUFFER_MAX_OPS_DEFAULT));
 
   /* Save the original direction, we use it later. */
   c->target_direction = c->buffer->props.direction;
@@ -999,9 +1257,11 @@ hb_ot_shape_internal (hb_ot_shape_context_t *c)
 
   c->buffer->props.direction = c->target_direction;
 
+  c->buffer->max_ops_exhausted = c->buffer->max_ops_budget && c->buffer->max_ops <= 0;
   c->buffer->max_len = HB_BUFFER_MAX_LEN_DEFAULT;
   c->buffer->max_ops = HB_BUFFER_MAX_OPS_DEFAULT;
   c->buffer->deallocate_var_all ();
+  c->buffer->arena.reset ();
 }
 
 
@@ -1032,6 +1292,74 @@ hb_ot_shape_plan_collect_lookups (hb_shape_plan_t *shape_plan,
   shape_plan->ot.collect_lookups (table_tag, lookup_indexes);
 }
 
+/**
+ * hb_ot_shape_plan_enable_lookup_stats:
+ * @shape_plan: a shape plan.
+ *
+ * Makes every later hb_shape_plan_execute() with @shape_plan count, per
+ * GSUB and GPOS lookup in the plan, how often it ran, how many glyphs it
+ * was tried on and applied to, and the time it took.  Lookups invoked
+ * from within other lookups count toward the outer one.  Counters are
+ * not synchronized; use a plan from hb_shape_plan_create() that no other
+ * thread shapes with.
+ *
+ * Calling this again resets the counters.
+ *
+ * Return value: false if allocating the counters failed.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_ot_shape_plan_enable_lookup_stats (hb_shape_plan_t *shape_plan)
+{
+  if (unlikely (hb_object_is_inert (shape_plan)))
+    return false;
+  return shape_plan->ot.map.enable_stats ();
+}
+
+/**
+ * hb_ot_shape_plan_get_lookup_stats:
+ * @shape_plan: a shape plan.
+ * @start_offset: offset of the first entry to retrieve.
+ * @stats_count: (inout) (allow-none): Input = the maximum number of
+ * entries to return; Output = the actual number of entries returned.
+ * @stats: (out) (array length=stats_count): the counters, GSUB lookups
+ * first, in the order the plan applies them.
+ *
+ * Fetches the counters collected since
+ * hb_ot_shape_plan_enable_lookup_stats() or
+ * hb_ot_shape_plan_reset_lookup_stats().
+ *
+ * Return value: total number of entries, or zero if counting was never
+ * enabled on @shape_plan.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_ot_shape_plan_get_lookup_stats (hb_shape_plan_t      *shape_plan,
+				   unsigned int          start_offset,
+				   unsigned int         *stats_count /* IN/OUT */,
+				   hb_ot_lookup_stats_t *stats /* OUT */)
+{
+  return shape_plan->ot.map.get_stats (start_offset, stats_count, stats);
+}
+
+/**
+ * hb_ot_shape_plan_reset_lookup_stats:
+ * @shape_plan: a shape plan.
+ *
+ * Zeroes the counters of @shape_plan, if counting is enabled.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_ot_shape_plan_reset_lookup_stats (hb_shape_plan_t *shape_plan)
+{
+  if (unlikely (hb_object_is_inert (shape_plan)))
+    return;
+  shape_plan->ot.map.reset_stats ();
+}
+
 
 /* TODO Move this to hb-ot-shape-normalize, make it do decompose, and make it public. */
 static void
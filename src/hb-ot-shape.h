@@ -48,6 +48,41 @@ hb_ot_shape_plan_collect_lookups (hb_shape_plan_t *shape_plan,
 				  hb_tag_t         table_tag,
 				  hb_set_t        *lookup_indexes /* OUT */);
 
+/**
+ * hb_ot_lookup_stats_t:
+ * @table_tag: %HB_OT_TAG_GSUB or %HB_OT_TAG_GPOS.
+ * @lookup_index: the lookup's index in the table.
+ * @runs: how many times the lookup was run over a buffer.
+ * @attempts: how many glyphs the lookup was tried on.
+ * @applies: how many of those attempts applied.
+ * @time: time spent running the lookup, in nanoseconds.
+ *
+ * Execution counters for one lookup of a shape plan, see
+ * hb_ot_shape_plan_enable_lookup_stats().
+ *
+ * Since: REPLACEME
+ */
+typedef struct hb_ot_lookup_stats_t {
+  hb_tag_t      table_tag;
+  unsigned int  lookup_index;
+  unsigned int  runs;
+  unsigned int  attempts;
+  unsigned int  applies;
+  uint64_t      time;
+} hb_ot_lookup_stats_t;
+
+HB_EXTERN hb_bool_t
+hb_ot_shape_plan_enable_lookup_stats (hb_shape_plan_t *shape_plan);
+
+HB_EXTERN unsigned int
+hb_ot_shape_plan_get_lookup_stats (hb_shape_plan_t      *shape_plan,
+				   unsigned int          start_offset,
+				   unsigned int         *stats_count /* IN/OUT */,
+				   hb_ot_lookup_stats_t *stats /* OUT */);
+
+HB_EXTERN void
+hb_ot_shape_plan_reset_lookup_stats (hb_shape_plan_t *shape_plan);
+
 HB_END_DECLS
 
 #endif /* HB_OT_SHAPE_H */
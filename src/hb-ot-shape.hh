@@ -31,6 +31,7 @@
 
 #include "hb-ot-map.hh"
 #include "hb-aat-map.hh"
+#include "hb-map.hh"
 
 
 struct hb_ot_shape_plan_key_t
@@ -70,6 +71,10 @@ struct hb_ot_shape_plan_t
   hb_mask_t kern_mask;
   hb_mask_t trak_mask;
 
+  /* For backward directions: characters whose mirror the face has in
+   * cmap, to that mirror.  BMP only. */
+  hb_map_t mirrors;
+
   bool requested_kerning : 1;
   bool requested_tracking : 1;
   bool has_frac : 1;
@@ -85,6 +90,10 @@ struct hb_ot_shape_plan_t
   bool apply_morx : 1;
   bool apply_trak : 1;
 
+  /* Nothing changes the glyphs cmap gives, other than hiding default
+   * ignorables. */
+  bool cmap_glyphs_final : 1;
+
   void collect_lookups (hb_tag_t table_tag, hb_set_t *lookups) const
   {
     unsigned int table_index;
@@ -96,8 +105,11 @@ struct hb_ot_shape_plan_t
     map.collect_lookups (table_index, lookups);
   }
 
+  /* If serialized_map is not nullptr, the map is restored from it instead
+   * of compiled; see hb_ot_map_builder_t::compile_serialized(). */
   HB_INTERNAL bool init0 (hb_face_t                     *face,
-			  const hb_shape_plan_key_t     *key);
+			  const hb_shape_plan_key_t     *key,
+			  hb_array_t<const uint32_t>    *serialized_map = nullptr);
   HB_INTERNAL void fini ();
 
   HB_INTERNAL void substitute (hb_font_t *font, hb_buffer_t *buffer) const;
@@ -121,8 +133,27 @@ struct hb_ot_shape_planner_t
   HB_INTERNAL hb_ot_shape_planner_t (hb_face_t                     *face,
 				     const hb_segment_properties_t *props);
 
-  HB_INTERNAL void compile (hb_ot_shape_plan_t           &plan,
-			    const hb_ot_shape_plan_key_t &key);
+  HB_INTERNAL bool compile (hb_ot_shape_plan_t           &plan,
+			    const hb_ot_shape_plan_key_t &key,
+			    hb_array_t<const uint32_t>   *serialized_map = nullptr);
+};
+
+
+struct arabic_fallback_face_t;
+struct hangul_face_t;
+struct thai_pua_face_t;
+
+struct hb_ot_face_data_t
+{
+  /* Arabic fallback lookups synthesized from cmap, shared by all Arabic
+   * plans on the face.  Created lazily; see hb-ot-shape-complex-arabic.cc. */
+  hb_atomic_ptr_t<arabic_fallback_face_t> arabic_fallback;
+
+  /* Bitmaps of the characters the Hangul and Thai shapers look up that
+   * cmap maps.  Plain allocations, created lazily; see
+   * hb-ot-shape-complex-hangul.cc and hb-ot-shape-complex-thai.cc. */
+  hb_atomic_ptr_t<hangul_face_t> hangul;
+  hb_atomic_ptr_t<thai_pua_face_t> thai_pua;
 };
 
 
@@ -324,6 +324,47 @@ parse_private_use_subtag (const char     *private_use_subtag,
   return true;
 }
 
+static void
+hb_ot_tags_from_language_string (const char            *lang_str,
+				 hb_language_ot_tags_t *tags)
+{
+  const char *s, *limit, *private_use_subtag;
+  unsigned int script_count = 1;
+
+  limit = nullptr;
+  private_use_subtag = nullptr;
+  if (lang_str[0] == 'x' && lang_str[1] == '-')
+  {
+    private_use_subtag = lang_str;
+  } else {
+    for (s = lang_str + 1; *s; s++)
+    {
+      if (s[-1] == '-' && s[1] == '-')
+      {
+	if (s[0] == 'x')
+	{
+	  private_use_subtag = s;
+	  if (!limit)
+	    limit = s - 1;
+	  break;
+	} else if (!limit)
+	{
+	  limit = s - 1;
+	}
+      }
+    }
+    if (!limit)
+      limit = s;
+  }
+
+  tags->script_tag = 0;
+  parse_private_use_subtag (private_use_subtag, &script_count, &tags->script_tag, "-hbsc", TOLOWER);
+
+  tags->language_count = ARRAY_LENGTH (tags->language_tags);
+  if (parse_private_use_subtag (private_use_subtag, &tags->language_count, tags->language_tags, "-hbot", TOUPPER))
+    hb_ot_tags_from_language (lang_str, limit, &tags->language_count, tags->language_tags);
+}
+
 /**
  * hb_ot_tags_from_script_and_language:
  * @script: an #hb_script_t to convert.
@@ -358,41 +399,30 @@ hb_ot_tags_from_script_and_language (hb_script_t   script,
   }
   else
   {
-    const char *lang_str, *s, *limit, *private_use_subtag;
-    bool needs_language;
-
-    lang_str = hb_language_to_string (language);
-    limit = nullptr;
-    private_use_subtag = nullptr;
-    if (lang_str[0] == 'x' && lang_str[1] == '-')
+    /* Parsing the BCP 47 string only depends on the language, and
+     * languages are interned, so do it once per language. */
+    const hb_language_ot_tags_t *tags = _hb_language_get_ot_tags (language);
+    hb_language_ot_tags_t computed;
+    if (unlikely (!tags))
     {
-      private_use_subtag = lang_str;
-    } else {
-      for (s = lang_str + 1; *s; s++)
-      {
-	if (s[-1] == '-' && s[1] == '-')
-	{
-	  if (s[0] == 'x')
-	  {
-	    private_use_subtag = s;
-	    if (!limit)
-	      limit = s - 1;
-	    break;
-	  } else if (!limit)
-	  {
-	    limit = s - 1;
-	  }
-	}
-      }
-      if (!limit)
-	limit = s;
+      hb_ot_tags_from_language_string (hb_language_to_string (language), &computed);
+      tags = _hb_language_set_ot_tags (language, &computed);
     }
 
-    needs_script = parse_private_use_subtag (private_use_subtag, script_count, script_tags, "-hbsc", TOLOWER);
-    needs_language = parse_private_use_subtag (private_use_subtag, language_count, language_tags, "-hbot", TOUPPER);
+    if (tags->script_tag && script_count && script_tags && *script_count)
+    {
+      script_tags[0] = tags->script_tag;
+      *script_count = 1;
+      needs_script = false;
+    }
 
-    if (needs_language && language_count && language_tags && *language_count)
-      hb_ot_tags_from_language (lang_str, limit, language_count, language_tags);
+    if (language_count && language_tags && *language_count)
+    {
+      unsigned int count = hb_min (*language_count, tags->language_count);
+      for (unsigned int i = 0; i < count; i++)
+	language_tags[i] = tags->language_tags[i];
+      *language_count = count;
+    }
   }
 
   if (needs_script && script_count && script_tags && *script_count)
@@ -0,0 +1,611 @@
+/*
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#ifndef HB_OT_VAR_GVAR_TABLE_HH
+#define HB_OT_VAR_GVAR_TABLE_HH
+
+#include "hb-open-type.hh"
+#include "hb-font.hh"
+
+/*
+ * gvar -- Glyph Variation Table
+ * https://docs.microsoft.com/en-us/typography/opentype/spec/gvar
+ */
+#define HB_OT_TAG_gvar HB_TAG('g','v','a','r')
+
+namespace OT {
+
+struct contour_point_t
+{
+  void init (float x_ = 0.f, float y_ = 0.f) { x = x_; y = y_; }
+
+  void translate (const contour_point_t &p) { x += p.x; y += p.y; }
+
+  float x, y;
+};
+
+struct TupleVarHeader
+{
+  unsigned int get_size (unsigned int axis_count) const
+  {
+    return min_size +
+	   (has_peak () ? axis_count * F2DOT14::static_size : 0) +
+	   (has_intermediate () ? 2 * axis_count * F2DOT14::static_size : 0);
+  }
+
+  const TupleVarHeader &get_next (unsigned int axis_count) const
+  { return StructAtOffset<TupleVarHeader> (this, get_size (axis_count)); }
+
+  /* Same as VarRegionAxis::evaluate(), per axis. */
+  static float axis_scalar (int coord, int start, int peak, int end)
+  {
+    if (unlikely (start > peak || peak > end))
+      return 1.f;
+    if (unlikely (start < 0 && end > 0 && peak != 0))
+      return 1.f;
+
+    if (peak == 0 || coord == peak)
+      return 1.f;
+
+    if (coord <= start || end <= coord)
+      return 0.f;
+
+    if (coord < peak)
+      return float (coord - start) / (peak - start);
+    else
+      return float (end - coord) / (end - peak);
+  }
+
+  static float peak_scalar (const F2DOT14 *peak_tuple,
+			    const int *coords, unsigned int coord_count,
+			    unsigned int axis_count)
+  {
+    float scalar = 1.f;
+    for (unsigned int i = 0; i < axis_count; i++)
+    {
+      int coord = i < coord_count ? coords[i] : 0;
+      int peak = peak_tuple[i];
+      scalar *= axis_scalar (coord, hb_min (peak, 0), peak, hb_max (peak, 0));
+      if (scalar == 0.f)
+	return 0.f;
+    }
+    return scalar;
+  }
+
+  /* shared_scalars, if not null, holds peak_scalar() of each shared tuple. */
+  float calculate_scalar (const int *coords, unsigned int coord_count,
+			  unsigned int axis_count,
+			  hb_array_t<const F2DOT14> shared_tuples,
+			  const float *shared_scalars) const
+  {
+    const F2DOT14 *peak_tuple;
+    if (has_peak ())
+      peak_tuple = &StructAfter<F2DOT14> (tupleIndex);
+    else
+    {
+      unsigned int index = get_index ();
+      if (unlikely ((index + 1) * axis_count > shared_tuples.length))
+	return 0.f;
+      if (shared_scalars && !has_intermediate ())
+	return shared_scalars[index];
+      peak_tuple = &shared_tuples[index * axis_count];
+    }
+
+    if (!has_intermediate ())
+      return peak_scalar (peak_tuple, coords, coord_count, axis_count);
+
+    const F2DOT14 *start_tuple = &StructAtOffset<F2DOT14> (this, get_size (axis_count) - 2 * axis_count * F2DOT14::static_size);
+    const F2DOT14 *end_tuple = start_tuple + axis_count;
+    float scalar = 1.f;
+    for (unsigned int i = 0; i < axis_count; i++)
+    {
+      int coord = i < coord_count ? coords[i] : 0;
+      scalar *= axis_scalar (coord, start_tuple[i], peak_tuple[i], end_tuple[i]);
+      if (scalar == 0.f)
+	return 0.f;
+    }
+    return scalar;
+  }
+
+  unsigned int get_data_size () const { return varDataSize; }
+
+  bool has_peak () const { return tupleIndex & EMBEDDED_PEAK_TUPLE; }
+  bool has_intermediate () const { return tupleIndex & INTERMEDIATE_REGION; }
+  bool has_private_points () const { return tupleIndex & PRIVATE_POINT_NUMBERS; }
+  unsigned int get_index () const { return tupleIndex & TUPLE_INDEX_MASK; }
+
+  protected:
+  enum flags_t
+  {
+    EMBEDDED_PEAK_TUPLE = 0x8000u,
+    INTERMEDIATE_REGION = 0x4000u,
+    PRIVATE_POINT_NUMBERS = 0x2000u,
+    TUPLE_INDEX_MASK = 0x0FFFu
+  };
+
+  HBUINT16	varDataSize;	/* The size in bytes of the serialized
+				 * data for this tuple variation table. */
+  HBUINT16	tupleIndex;	/* A packed field. The high 4 bits are flags (see below).
+				   The low 12 bits are an index into a shared tuple
+				   records array. */
+  /* UnsizedArrayOf<F2DOT14> peakTuple - optional */
+				/* Peak tuple record for this tuple variation table — optional,
+				 * determined by flags in the tupleIndex value.
+				 *
+				 * Note that this must always be included in the 'cvar' table. */
+  /* UnsizedArrayOf<F2DOT14> intermediateStartTuple - optional */
+				/* Intermediate start tuple record for this tuple variation table — optional,
+				   determined by flags in the tupleIndex value. */
+  /* UnsizedArrayOf<F2DOT14> intermediateEndTuple - optional */
+				/* Intermediate end tuple record for this tuple variation table — optional,
+				 * determined by flags in the tupleIndex value. */
+  public:
+  DEFINE_SIZE_MIN (4);
+};
+
+struct GlyphVarData
+{
+  /* Unpacks packed point numbers at p, advancing it.  No points means all
+   * points. */
+  static bool unpack_points (const HBUINT8 *&p,
+			     hb_vector_t<unsigned int> &points /* OUT */,
+			     const HBUINT8 *end)
+  {
+    enum packed_point_flag_t
+    {
+      POINTS_ARE_WORDS     = 0x80,
+      POINT_RUN_COUNT_MASK = 0x7F
+    };
+
+    if (unlikely (p + 1 > end)) return false;
+    unsigned int count = *p++;
+    if (count & POINTS_ARE_WORDS)
+    {
+      if (unlikely (p + 1 > end)) return false;
+      count = ((count & POINT_RUN_COUNT_MASK) << 8) | *p++;
+    }
+    if (unlikely (!points.resize (count))) return false;
+
+    unsigned int n = 0;
+    unsigned int i = 0;
+    while (i < count)
+    {
+      if (unlikely (p + 1 > end)) return false;
+      unsigned int control = *p++;
+      unsigned int run_count = (control & POINT_RUN_COUNT_MASK) + 1;
+      if (control & POINTS_ARE_WORDS)
+      {
+	for (unsigned int j = 0; j < run_count && i < count; j++, i++)
+	{
+	  if (unlikely (p + HBUINT16::static_size > end)) return false;
+	  n += StructAtOffset<HBUINT16> (p, 0);
+	  points[i] = n;
+	  p += HBUINT16::static_size;
+	}
+      }
+      else
+      {
+	for (unsigned int j = 0; j < run_count && i < count; j++, i++)
+	{
+	  if (unlikely (p + 1 > end)) return false;
+	  n += *p++;
+	  points[i] = n;
+	}
+      }
+    }
+    return true;
+  }
+
+  /* Unpacks deltas.length packed deltas at p, advancing it. */
+  static bool unpack_deltas (const HBUINT8 *&p,
+			     hb_vector_t<int> &deltas /* IN/OUT */,
+			     const HBUINT8 *end)
+  {
+    enum packed_delta_flag_t
+    {
+      DELTAS_ARE_ZERO      = 0x80,
+      DELTAS_ARE_WORDS     = 0x40,
+      DELTA_RUN_COUNT_MASK = 0x3F
+    };
+
+    unsigned int i = 0;
+    unsigned int count = deltas.length;
+    while (i < count)
+    {
+      if (unlikely (p + 1 > end)) return false;
+      unsigned int control = *p++;
+      unsigned int run_count = (control & DELTA_RUN_COUNT_MASK) + 1;
+      unsigned int j;
+      if (control & DELTAS_ARE_ZERO)
+	for (j = 0; j < run_count && i < count; j++, i++)
+	  deltas[i] = 0;
+      else if (control & DELTAS_ARE_WORDS)
+	for (j = 0; j < run_count && i < count; j++, i++)
+	{
+	  if (unlikely (p + HBUINT16::static_size > end)) return false;
+	  deltas[i] = StructAtOffset<HBINT16> (p, 0);
+	  p += HBUINT16::static_size;
+	}
+      else
+	for (j = 0; j < run_count && i < count; j++, i++)
+	{
+	  if (unlikely (p + 1 > end)) return false;
+	  deltas[i] = StructAtOffset<HBINT8> (p, 0);
+	  p++;
+	}
+      if (unlikely (j < run_count))
+	return false;
+    }
+    return true;
+  }
+
+  bool has_shared_point_numbers () const { return tupleVarCount & SHARED_POINT_NUMBERS; }
+  unsigned int get_tuple_count () const { return tupleVarCount & COUNT_MASK; }
+  const HBUINT8 *get_serialized_data () const { return &StructAtOffset<HBUINT8> (this, data); }
+  const TupleVarHeader &get_tuple_var_header () const { return StructAfter<TupleVarHeader> (data); }
+
+  protected:
+  enum
+  {
+    SHARED_POINT_NUMBERS = 0x8000u,
+    COUNT_MASK           = 0x0FFFu
+  };
+
+  HBUINT16	tupleVarCount;	/* A packed field. The high 4 bits are flags, and the
+				 * low 12 bits are the number of tuple variation tables
+				 * for this glyph. The number of tuple variation tables
+				 * can be any number between 1 and 4095. */
+  HBUINT16	data;		/* Offset from the start of the GlyphVariationData table
+				 * to the serialized data. */
+  /* TupleVarHeader tupleVarHeaders[] */
+				/* Array of tuple variation headers. */
+  public:
+  DEFINE_SIZE_MIN (4);
+};
+
+struct gvar
+{
+  static constexpr hb_tag_t tableTag = HB_OT_TAG_gvar;
+
+  bool sanitize (hb_sanitize_context_t *c) const
+  {
+    TRACE_SANITIZE (this);
+    return_trace (c->check_struct (this) &&
+		  version.major == 1 &&
+		  glyphCount == c->get_num_glyphs () &&
+		  c->check_array ((const F2DOT14 *) &(this+sharedTuples), axisCount * sharedTupleCount) &&
+		  (is_long_offset () ?
+		   c->check_array (get_long_offset_array (), glyphCount + 1) :
+		   c->check_array (get_short_offset_array (), glyphCount + 1)) &&
+		  get_offset (0) <= get_offset (glyphCount) &&
+		  c->check_range ((const HBUINT8 *) &(this+dataZ) + get_offset (0),
+				  get_offset (glyphCount) - get_offset (0)));
+  }
+
+  /* The glyph's variation data, or empty. */
+  hb_bytes_t get_glyph_var_data (hb_codepoint_t glyph) const
+  {
+    if (unlikely (glyph >= glyphCount))
+      return hb_bytes_t ();
+    unsigned int start = get_offset (glyph);
+    unsigned int end = get_offset (glyph + 1);
+    if (unlikely (start < get_offset (0) || start > end || end > get_offset (glyphCount) ||
+		  end - start < GlyphVarData::min_size))
+      return hb_bytes_t ();
+    return hb_bytes_t ((const char *) &(this+dataZ) + start, end - start);
+  }
+
+  hb_array_t<const F2DOT14> get_shared_tuples () const
+  { return (this+sharedTuples).as_array (sharedTupleCount * axisCount); }
+
+  unsigned int get_axis_count () const { return axisCount; }
+
+  protected:
+  bool is_long_offset () const { return (flags & 1) != 0; }
+
+  unsigned int get_offset (unsigned int i) const
+  {
+    if (is_long_offset ())
+      return get_long_offset_array ()[i];
+    else
+      return get_short_offset_array ()[i] * 2;
+  }
+
+  const HBUINT32 *get_long_offset_array () const { return (const HBUINT32 *) offsetZ.arrayZ; }
+  const HBUINT16 *get_short_offset_array () const { return (const HBUINT16 *) offsetZ.arrayZ; }
+
+  public:
+  struct accelerator_t
+  {
+    void init (hb_face_t *face)
+    {
+      table = hb_sanitize_context_t ().reference_table<gvar> (face);
+    }
+
+    void fini () { table.destroy (); }
+
+    void add_memory_usage (hb_memory_usage_t *usage) const
+    { usage->add_blob (table); }
+
+    bool has_data () const { return table->glyphCount != 0; }
+
+    /* Adds glyph's deltas at font's coords to its points.  For simple glyphs
+     * end_points holds the last point of each contour, so that untouched
+     * points can be inferred; composites pass none.  The four phantom
+     * points come last and are never inferred. */
+    bool apply_deltas_to_points (hb_codepoint_t glyph,
+				 hb_font_t *font,
+				 const hb_array_t<contour_point_t> points,
+				 const hb_array_t<const unsigned int> end_points) const
+    {
+      if (!font->num_coords)
+	return true;
+
+      hb_bytes_t bytes = table->get_glyph_var_data (glyph);
+      if (!bytes.length)
+	return true; /* No variations for this glyph. */
+
+      const GlyphVarData &var_data = StructAtOffset<GlyphVarData> (bytes.arrayZ, 0);
+      const HBUINT8 *end = (const HBUINT8 *) bytes.arrayZ + bytes.length;
+      const HBUINT8 *p = var_data.get_serialized_data ();
+      if (unlikely (p > end))
+	return false;
+
+      hb_vector_t<unsigned int> shared_indices;
+      if (var_data.has_shared_point_numbers () &&
+	  unlikely (!GlyphVarData::unpack_points (p, shared_indices, end)))
+	return false;
+
+      unsigned int axis_count = table->get_axis_count ();
+      hb_array_t<const F2DOT14> shared_tuples = table->get_shared_tuples ();
+      const float *shared_scalars = get_shared_scalars (font);
+
+      hb_vector_t<contour_point_t> orig_points;
+      hb_vector_t<contour_point_t> deltas;
+      hb_vector_t<bool> touched;
+      hb_vector_t<unsigned int> private_indices;
+      hb_vector_t<int> x_deltas, y_deltas;
+
+      if (end_points.length)
+      {
+	if (unlikely (!orig_points.resize (points.length)))
+	  return false;
+	for (unsigned int i = 0; i < points.length; i++)
+	  orig_points[i] = points[i];
+      }
+
+      const TupleVarHeader *header = &var_data.get_tuple_var_header ();
+      unsigned int count = var_data.get_tuple_count ();
+      for (unsigned int i = 0; i < count; i++)
+      {
+	if (unlikely ((const HBUINT8 *) header + TupleVarHeader::min_size > end ||
+		      (const HBUINT8 *) header + header->get_size (axis_count) > end))
+	  return false;
+
+	const HBUINT8 *tuple_data = p;
+	const HBUINT8 *tuple_end = p + header->get_data_size ();
+	if (unlikely (tuple_end > end))
+	  return false;
+	p = tuple_end;
+
+	float scalar = header->calculate_scalar (font->coords, font->num_coords,
+						 axis_count, shared_tuples, shared_scalars);
+	const TupleVarHeader *this_header = header;
+	header = &header->get_next (axis_count);
+	if (scalar == 0.f)
+	  continue;
+
+	const hb_vector_t<unsigned int> *indices = &shared_indices;
+	if (this_header->has_private_points ())
+	{
+	  if (unlikely (!GlyphVarData::unpack_points (tuple_data, private_indices, tuple_end)))
+	    return false;
+	  indices = &private_indices;
+	}
+
+	bool apply_to_all = !indices->length;
+	unsigned int num_deltas = apply_to_all ? points.length : indices->length;
+	if (unlikely (!x_deltas.resize (num_deltas) ||
+		      !y_deltas.resize (num_deltas) ||
+		      !GlyphVarData::unpack_deltas (tuple_data, x_deltas, tuple_end) ||
+		      !GlyphVarData::unpack_deltas (tuple_data, y_deltas, tuple_end)))
+	  return false;
+
+	if (apply_to_all)
+	{
+	  for (unsigned int j = 0; j < num_deltas; j++)
+	  {
+	    points[j].x += x_deltas[j] * scalar;
+	    points[j].y += y_deltas[j] * scalar;
+	  }
+	  continue;
+	}
+
+	if (unlikely (!deltas.resize (points.length) ||
+		      !touched.resize (points.length)))
+	  return false;
+	for (unsigned int j = 0; j < points.length; j++)
+	{
+	  deltas[j].init ();
+	  touched[j] = false;
+	}
+	for (unsigned int j = 0; j < num_deltas; j++)
+	{
+	  unsigned int index = (*indices)[j];
+	  if (unlikely (index >= points.length))
+	    continue;
+	  touched[index] = true;
+	  deltas[index].init (x_deltas[j], y_deltas[j]);
+	}
+
+	if (end_points.length)
+	{
+	  /* Untouched points move with their touched neighbours in the
+	   * default outline. */
+	  infer_deltas (orig_points.as_array (), deltas.as_array (),
+			touched.as_array (), end_points);
+	}
+
+	for (unsigned int j = 0; j < points.length; j++)
+	{
+	  points[j].x += deltas[j].x * scalar;
+	  points[j].y += deltas[j].y * scalar;
+	}
+      }
+
+      return true;
+    }
+
+    private:
+    /* Peak scalars of the shared tuples at font's coords, kept on font. */
+    const float *get_shared_scalars (hb_font_t *font) const
+    {
+      hb_array_t<const F2DOT14> shared_tuples = table->get_shared_tuples ();
+      unsigned int count = table->sharedTupleCount;
+      if (!count || !table->axisCount)
+	return nullptr;
+      const float *scalars = font->get_var_scalars (shared_tuples.arrayZ);
+      if (likely (scalars) || font->var_scalars_full ())
+	return scalars;
+
+      hb_font_t::var_scalars_t *entry = (hb_font_t::var_scalars_t *)
+					malloc (sizeof (*entry) + count * sizeof (float));
+      if (unlikely (!entry))
+	return nullptr;
+      entry->store = shared_tuples.arrayZ;
+      entry->scalars = (float *) (entry + 1);
+      unsigned int axis_count = table->axisCount;
+      for (unsigned int i = 0; i < count; i++)
+	entry->scalars[i] = TupleVarHeader::peak_scalar (&shared_tuples[i * axis_count],
+							 font->coords, font->num_coords,
+							 axis_count);
+      return font->add_var_scalars (entry);
+    }
+
+    static float infer_delta (float target_val, float prev_val, float next_val,
+			      float prev_delta, float next_delta)
+    {
+      if (prev_val == next_val)
+	return (prev_delta == next_delta) ? prev_delta : 0.f;
+      else if (target_val <= hb_min (prev_val, next_val))
+	return (prev_val < next_val) ? prev_delta : next_delta;
+      else if (target_val >= hb_max (prev_val, next_val))
+	return (prev_val > next_val) ? prev_delta : next_delta;
+
+      float r = (target_val - prev_val) / (next_val - prev_val);
+      return (1.f - r) * prev_delta + r * next_delta;
+    }
+
+    /* Interpolates deltas of untouched points of each contour from the
+     * nearest touched points before and after them, using the default
+     * outline in orig_points. */
+    static void infer_deltas (const hb_array_t<const contour_point_t> orig_points,
+			      hb_array_t<contour_point_t> deltas,
+			      const hb_array_t<const bool> touched,
+			      const hb_array_t<const unsigned int> end_points)
+    {
+      unsigned int start_point = 0;
+      for (unsigned int c = 0; c < end_points.length; c++)
+      {
+	unsigned int end_point = end_points[c];
+	if (unlikely (end_point < start_point || end_point >= orig_points.length))
+	  return;
+	infer_contour_deltas (orig_points, deltas, touched, start_point, end_point);
+	start_point = end_point + 1;
+      }
+    }
+
+    static void infer_contour_deltas (const hb_array_t<const contour_point_t> orig_points,
+				      hb_array_t<contour_point_t> deltas,
+				      const hb_array_t<const bool> touched,
+				      unsigned int start_point, unsigned int end_point)
+    {
+      unsigned int untouched_count = 0;
+      for (unsigned int i = start_point; i <= end_point; i++)
+	if (!touched[i])
+	  untouched_count++;
+      if (!untouched_count || untouched_count > end_point - start_point)
+	return; /* Nothing to infer, or nothing to infer from. */
+
+      unsigned int first_touched = start_point;
+      while (!touched[first_touched])
+	first_touched++;
+
+      /* Walk the gaps between consecutive touched points, wrapping around. */
+      unsigned int prev = first_touched;
+      do
+      {
+	unsigned int next = prev;
+	do
+	  next = next == end_point ? start_point : next + 1;
+	while (!touched[next]);
+
+	for (unsigned int i = prev == end_point ? start_point : prev + 1;
+	     i != next;
+	     i = i == end_point ? start_point : i + 1)
+	{
+	  deltas[i].x = infer_delta (orig_points[i].x, orig_points[prev].x, orig_points[next].x,
+				     deltas[prev].x, deltas[next].x);
+	  deltas[i].y = infer_delta (orig_points[i].y, orig_points[prev].y, orig_points[next].y,
+				     deltas[prev].y, deltas[next].y);
+	}
+	prev = next;
+      }
+      while (prev != first_touched);
+    }
+
+    private:
+    hb_blob_ptr_t<gvar> table;
+  };
+
+  protected:
+  FixedVersion<>version;	/* Version of gvar table. Set to 0x00010000u. */
+  HBUINT16	axisCount;	/* The number of variation axes for this font. This must be
+				 * the same number as axisCount in the 'fvar' table. */
+  HBUINT16	sharedTupleCount;
+				/* The number of shared tuple records. Shared tuple records
+				 * can be referenced within glyph variation data tables for
+				 * multiple glyphs, as opposed to other tuple records stored
+				 * directly within a glyph variation data table. */
+  LNNOffsetTo<UnsizedArrayOf<F2DOT14> >
+		sharedTuples;	/* Offset from the start of this table to the shared tuple
+				 * records array. */
+  HBUINT16	glyphCount;	/* The number of glyphs in this font. This must match the
+				 * number of glyphs stored elsewhere in the font. */
+  HBUINT16	flags;		/* Bit-field that gives the format of the offset array
+				 * that follows. If bit 0 is clear, the offsets are uint16;
+				 * if bit 0 is set, the offsets are uint32. */
+  LNNOffsetTo<UnsizedArrayOf<HBUINT8> >
+		dataZ;		/* Offset from the start of this table to the array of
+				 * GlyphVariationData tables. */
+  UnsizedArrayOf<HBUINT8>
+		offsetZ;	/* Offsets from the start of the GlyphVariationData array
+				 * to each GlyphVariationData table. */
+  public:
+  DEFINE_SIZE_MIN (20);
+};
+
+struct gvar_accelerator_t : gvar::accelerator_t {};
+
+} /* namespace OT */
+
+#endif /* HB_OT_VAR_GVAR_TABLE_HH */
@@ -115,12 +115,25 @@ struct HVARVVAR
   }
 
   float get_advance_var (hb_codepoint_t glyph,
-			 const int *coords, unsigned int coord_count) const
+			 const int *coords, unsigned int coord_count,
+			 float *cache = nullptr) const
   {
     unsigned int varidx = (this+advMap).map (glyph);
-    return (this+varStore).get_delta (varidx, coords, coord_count);
+    return (this+varStore).get_delta (varidx, coords, coord_count, cache);
   }
 
+  float get_advance_var (hb_codepoint_t glyph, hb_font_t *font,
+			 float *cache = nullptr) const
+  {
+    unsigned int varidx = (this+advMap).map (glyph);
+    return (this+varStore).get_delta (varidx, font, cache);
+  }
+
+  float *create_cache () const { return (this+varStore).create_cache (); }
+  void reset_cache (float *cache) const { (this+varStore).reset_cache (cache); }
+  bool has_font_scalars (hb_font_t *font) const
+  { return (this+varStore).get_font_scalars (font); }
+
   bool has_sidebearing_deltas () const { return lsbMap && rsbMap; }
 
   protected:
@@ -86,6 +86,18 @@ struct MVAR
     return (this+varStore).get_delta (record->varIdx, coords, coord_count);
   }
 
+  float get_var (hb_tag_t tag, hb_font_t *font) const
+  {
+    const VariationValueRecord *record;
+    record = (VariationValueRecord *) bsearch (&tag, valuesZ.arrayZ,
+					       valueRecordCount, valueRecordSize,
+					       tag_compare);
+    if (!record)
+      return 0.;
+
+    return (this+varStore).get_delta (record->varIdx, font);
+  }
+
 protected:
   static int tag_compare (const void *pa, const void *pb)
   {
@@ -99,4 +99,87 @@ struct hb_pool_t
 };
 
 
+/* Bump allocator for scratch memory that lives until the next reset().
+ * Allocations that don't fit the current chunk get their own block;
+ * reset() then replaces the chunk with one big enough for all of them,
+ * so a steady workload stops calling malloc after the first round. */
+
+struct hb_arena_t
+{
+  void init ()
+  {
+    chunk = nullptr;
+    size = used = 0;
+    overflow_size = 0;
+    overflow.init ();
+  }
+
+  void fini ()
+  {
+    reset ();
+    ::free (chunk);
+    overflow.fini ();
+    init ();
+  }
+
+  void *alloc (unsigned int n)
+  {
+    n = (n + ALIGN - 1) & ~(ALIGN - 1);
+    if (likely (n <= size - used))
+    {
+      void *p = chunk + used;
+      used += n;
+      return p;
+    }
+
+    if (unlikely (!overflow.alloc (overflow.length + 1))) return nullptr;
+    void *p = malloc (n);
+    if (unlikely (!p)) return nullptr;
+    overflow.push (p);
+    overflow_size += n;
+    return p;
+  }
+
+  template <typename T>
+  T *alloc_array (unsigned int count)
+  {
+    static_assert (alignof (T) <= ALIGN, "");
+    if (unlikely (hb_unsigned_mul_overflows (count, sizeof (T)))) return nullptr;
+    return (T *) alloc (count * sizeof (T));
+  }
+
+  void reset ()
+  {
+    if (unlikely (overflow.length))
+    {
+      unsigned int new_size = size + overflow_size;
+      char *new_chunk = (char *) malloc (new_size);
+      if (likely (new_chunk))
+      {
+	::free (chunk);
+	chunk = new_chunk;
+	size = new_size;
+      }
+
+      + hb_iter (overflow)
+      | hb_apply ([] (void *_) { ::free (_); })
+      ;
+      overflow.resize (0);
+      overflow_size = 0;
+    }
+    used = 0;
+  }
+
+  private:
+
+  static constexpr unsigned ALIGN = sizeof (void *) * 2;
+
+  char *chunk;
+  unsigned int size;
+  unsigned int used;
+  unsigned int overflow_size;
+  hb_vector_t<void *> overflow;
+};
+
+
 #endif /* HB_POOL_HH */
@@ -300,6 +300,7 @@ struct hb_sanitize_context_t :
   template <typename Type>
   hb_blob_t *sanitize_blob (hb_blob_t *blob)
   {
+    HB_ALLOC_STATS_SCOPE (SANITIZE);
     bool sane;
 
     init (blob);
@@ -336,6 +337,18 @@ struct hb_sanitize_context_t :
     else
     {
       if (edit_count && !writable) {
+	if (hb_blob_is_immutable (blob))
+	{
+	  /* Possibly shared, eg. cached by the face; edit a copy instead. */
+	  hb_blob_t *copy = hb_blob_copy_writable_or_fail (blob);
+	  if (copy)
+	  {
+	    hb_blob_destroy (blob);
+	    blob = copy;
+	    hb_blob_destroy (this->blob);
+	    this->blob = hb_blob_reference (copy);
+	  }
+	}
         start = hb_blob_get_data_writable (blob, nullptr);
 	end = start + blob->length;
 
@@ -367,11 +380,28 @@ struct hb_sanitize_context_t :
   template <typename Type>
   hb_blob_t *reference_table (const hb_face_t *face, hb_tag_t tableTag = Type::tableTag)
   {
+    HB_ALLOC_STATS_SCOPE (SANITIZE);
+    if (hb_face_is_trusted (face))
+      return trust_blob<Type> (hb_face_reference_table (face, tableTag));
     if (!num_glyphs_set)
       set_num_glyphs (hb_face_get_glyph_count (face));
     return sanitize_blob<Type> (hb_face_reference_table (face, tableTag));
   }
 
+  /* For tables validated elsewhere: only make sure the fixed-size
+   * header is there. */
+  template <typename Type>
+  static hb_blob_t *trust_blob (hb_blob_t *blob)
+  {
+    if (unlikely (hb_blob_get_length (blob) < Type::min_size))
+    {
+      hb_blob_destroy (blob);
+      return hb_blob_get_empty ();
+    }
+    hb_blob_make_immutable (blob);
+    return blob;
+  }
+
   mutable unsigned int debug_depth;
   const char *start, *end;
   mutable int max_ops;
@@ -48,23 +48,30 @@ struct hb_serialize_context_t
   struct range_t
   {
     char *head, *tail;
+    unsigned int generation; /* Of the packed area tail points into. */
   };
 
   struct object_t : range_t
   {
     void fini () { links.fini (); }
 
+    /* Only valid once hash_value is set, by pop_pack(). */
     bool operator == (const object_t &o) const
     {
-      return (tail - head == o.tail - o.head)
+      return (hash_value == o.hash_value)
+	  && (tail - head == o.tail - o.head)
 	  && (links.length == o.links.length)
 	  && 0 == hb_memcmp (head, o.head, tail - head)
 	  && links.as_bytes () == o.links.as_bytes ();
     }
-    uint32_t hash () const
+    uint32_t hash () const { return hash_value; }
+
+    /* The size goes into the hash, so that objects of different sizes
+     * are told apart by the hash check above. */
+    uint32_t compute_hash () const
     {
-      return hb_bytes_t (head, tail - head).hash () ^
-	     links.as_bytes ().hash ();
+      return (hb_bytes_t (head, tail - head).hash () ^
+	      links.as_bytes ().hash ()) + (tail - head) * 31u;
     }
 
     struct link_t
@@ -77,14 +84,18 @@ struct hb_serialize_context_t
 
     hb_vector_t<link_t> links;
     object_t *next;
+    uint32_t hash_value;
   };
 
-  range_t snapshot () { range_t s = {head, tail} ; return s; }
+  range_t snapshot () { range_t s = {head, tail, generation} ; return s; }
 
 
   hb_serialize_context_t (void *start_, unsigned int size) :
     start ((char *) start_),
     end (start + size),
+    buffer_end (end),
+    chunk (nullptr),
+    generation (0),
     current (nullptr)
   { reset (); }
   ~hb_serialize_context_t () { fini (); }
@@ -104,19 +115,26 @@ struct hb_serialize_context_t
       _->fini ();
     }
     object_pool.fini ();
+
+    free (chunk);
+    chunk = nullptr;
+    generation = 0;
   }
 
   bool in_error () const { return !this->successful; }
 
   void reset ()
   {
+    fini ();
+
     this->successful = true;
     this->ran_out_of_room = false;
     this->head = this->start;
+    this->end = this->buffer_end;
     this->tail = this->end;
     this->debug_depth = 0;
+    this->num_deduped = 0;
 
-    fini ();
     this->packed.push (nullptr);
   }
 
@@ -153,10 +171,11 @@ struct hb_serialize_context_t
   void end_serialize ()
   {
     DEBUG_MSG_LEVEL (SERIALIZE, this->start, 0, -1,
-		     "end [%p..%p] serialized %u bytes; %s",
+		     "end [%p..%p] serialized %u bytes; %s; %u of %u objects deduplicated",
 		     this->start, this->end,
 		     (unsigned) (this->head - this->start),
-		     this->successful ? "successful" : "UNSUCCESSFUL");
+		     this->successful ? "successful" : "UNSUCCESSFUL",
+		     this->num_deduped, this->num_deduped + this->packed.length - 1);
 
     propagate_error (packed, packed_map);
 
@@ -183,6 +202,7 @@ struct hb_serialize_context_t
     {
       obj->head = head;
       obj->tail = tail;
+      obj->generation = generation;
       obj->next = current;
       current = obj;
     }
@@ -212,13 +232,25 @@ struct hb_serialize_context_t
       return 0;
     }
 
+    /* Hashed once here; the map asks for it again on every probe and
+     * every resize. */
+    obj->hash_value = obj->compute_hash ();
+
     objidx_t objidx = packed_map.get (obj);
     if (objidx)
     {
+      num_deduped++;
       obj->fini ();
       return objidx;
     }
 
+    if (unlikely (chunk && tail - chunk < ptrdiff_t (len) &&
+		  !grow_packed (len)))
+    {
+      obj->fini ();
+      return 0;
+    }
+
     tail -= len;
     memmove (tail, obj->head, len);
 
@@ -239,6 +271,7 @@ struct hb_serialize_context_t
 
   void revert (range_t snap)
   {
+    assert (snap.generation == generation);
     assert (snap.head <= head);
     assert (tail <= snap.tail);
     head = snap.head;
@@ -339,7 +372,9 @@ struct hb_serialize_context_t
   {
     if (unlikely (!this->successful)) return nullptr;
 
-    if (this->tail - this->head < ptrdiff_t (size))
+    if (this->head_end () - this->head < ptrdiff_t (size) &&
+	!(this->tail != this->end && !chunk && grow_packed (0) &&
+	  this->head_end () - this->head >= ptrdiff_t (size)))
     {
       err_ran_out_of_room ();
       this->successful = false;
@@ -420,6 +455,56 @@ struct hb_serialize_context_t
   Type *extend (Type &obj, Ts&&... ds)
   { return extend (hb_addressof (obj), hb_forward<Ts> (ds)...); }
 
+  /* Packed objects start out at the tail end of the buffer.  When the
+   * buffer fills up, they are moved to a separately allocated chunk that
+   * grows as needed, leaving the whole buffer to the objects still under
+   * construction.  Those cannot move, so the buffer itself never grows.
+   *
+   * Snapshots taken before a move must not be reverted to after it;
+   * revert() checks the generation they were taken in. */
+  char *head_end () const { return chunk ? buffer_end : tail; }
+
+  bool grow_packed (unsigned int size)
+  {
+    unsigned int used = end - tail;
+    unsigned int old_size = chunk ? end - chunk : 0;
+    unsigned int new_size = hb_max (old_size + (old_size >> 1), 4096u);
+    if (unlikely (used + size < used)) /* Overflowed. */
+    {
+      err_other_error ();
+      return false;
+    }
+    new_size = hb_max (new_size, used + size);
+
+    char *new_chunk = (char *) malloc (new_size);
+    if (unlikely (!new_chunk))
+    {
+      err_other_error ();
+      return false;
+    }
+    char *new_end = new_chunk + new_size;
+    memcpy (new_end - used, tail, used);
+
+    /* Relocate everything pointing into the packed area. */
+    for (object_t *obj : ++hb_iter (packed))
+    {
+      obj->head = new_end - (end - obj->head);
+      obj->tail = new_end - (end - obj->tail);
+    }
+    for (object_t *obj = current; obj; obj = obj->next)
+    {
+      obj->tail = new_end - (end - obj->tail);
+      obj->generation = generation + 1;
+    }
+
+    free (chunk);
+    chunk = new_chunk;
+    generation++;
+    tail = new_end - used;
+    end = new_end;
+    return true;
+  }
+
   /* Output routines. */
   hb_bytes_t copy_bytes () const
   {
@@ -451,11 +536,19 @@ struct hb_serialize_context_t
   public: /* TODO Make private. */
   char *start, *head, *tail, *end;
   unsigned int debug_depth;
+  unsigned int num_deduped; /* pop_pack() calls that found an existing copy. */
   bool successful;
   bool ran_out_of_room;
 
   private:
 
+  /* End of the buffer we were given; packed objects may be elsewhere. */
+  char *buffer_end;
+  /* Storage for packed objects once they outgrow the buffer, or nullptr. */
+  char *chunk;
+  /* Bumped whenever the packed objects move; see revert(). */
+  unsigned int generation;
+
   /* Object memory pool. */
   hb_pool_t<object_t> object_pool;
 
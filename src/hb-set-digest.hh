@@ -100,6 +100,10 @@ struct hb_set_digest_lowest_bits_t
   bool may_have (hb_codepoint_t g) const
   { return !!(mask & mask_for (g)); }
 
+  /* Whether the two sets may have a glyph in common. */
+  bool may_have (const hb_set_digest_lowest_bits_t &o) const
+  { return !!(mask & o.mask); }
+
   private:
 
   static mask_t mask_for (hb_codepoint_t g)
@@ -147,6 +151,11 @@ struct hb_set_digest_combiner_t
     return head.may_have (g) && tail.may_have (g);
   }
 
+  bool may_have (const hb_set_digest_combiner_t &o) const
+  {
+    return head.may_have (o.head) && tail.may_have (o.tail);
+  }
+
   private:
   head_t head;
   tail_t tail;
@@ -171,4 +180,132 @@ typedef hb_set_digest_combiner_t
 > hb_set_digest_t;
 
 
+/*
+ * hb_set_digest_adaptive_t
+ *
+ * Same filter as hb_set_digest_t, but with the three shifts picked per
+ * set instead of fixed at 4, 0 and 9.  The fixed shifts suit the compact
+ * coverages of typical Latin fonts; big CJK or emoji fonts have lookups
+ * whose coverage spans thousands of glyph ids and floods some of them.
+ *
+ * Sets are added to a builder_t, which tracks a mask for every candidate
+ * shift at once; init() then keeps the three that best filter the font's
+ * glyphs.  Two adaptive digests would not in general share their shifts,
+ * so sets are only compared against a builder_t, which has them all.
+ */
+struct hb_set_digest_adaptive_t
+{
+  typedef unsigned long mask_t;
+  static constexpr unsigned mask_bits = sizeof (mask_t) * 8;
+  enum { NUM_SHIFTS = 12, NUM_MASKS = 3, MIN_SHIFT_DISTANCE = 3 };
+
+  struct builder_t
+  {
+    void init ()
+    {
+      for (unsigned int i = 0; i < NUM_SHIFTS; i++)
+	masks[i] = 0;
+    }
+
+    void add (hb_codepoint_t g)
+    {
+      for (unsigned int i = 0; i < NUM_SHIFTS; i++)
+	masks[i] |= mask_for (g, i);
+    }
+
+    bool add_range (hb_codepoint_t a, hb_codepoint_t b)
+    {
+      for (unsigned int i = 0; i < NUM_SHIFTS; i++)
+	if ((b >> i) - (a >> i) >= mask_bits - 1)
+	  masks[i] = (mask_t) -1;
+	else
+	{
+	  mask_t ma = mask_for (a, i);
+	  mask_t mb = mask_for (b, i);
+	  masks[i] |= mb + (mb - ma) - (mb < ma);
+	}
+      return true;
+    }
+
+    template <typename T>
+    void add_array (const T *array, unsigned int count, unsigned int stride=sizeof(T))
+    {
+      for (unsigned int i = 0; i < count; i++)
+      {
+	add (*array);
+	array = (const T *) (stride + (const char *) array);
+      }
+    }
+    template <typename T>
+    bool add_sorted_array (const T *array, unsigned int count, unsigned int stride=sizeof(T))
+    {
+      add_array (array, count, stride);
+      return true;
+    }
+
+    mask_t masks[NUM_SHIFTS]; /* By shift. */
+  };
+
+  void init (const builder_t &b, unsigned int num_glyphs)
+  {
+    /* The share of the font's glyphs that each mask lets through; at
+     * large shifts the font only spans a few of the mask's bits. */
+    float density[NUM_SHIFTS];
+    for (unsigned int i = 0; i < NUM_SHIFTS; i++)
+    {
+      unsigned int buckets = num_glyphs ? ((num_glyphs - 1) >> i) + 1 : 1;
+      mask_t reachable = buckets >= mask_bits ? (mask_t) -1 : (((mask_t) 1) << buckets) - 1;
+      density[i] = (float) hb_popcount (b.masks[i] & reachable) / hb_popcount (reachable);
+    }
+
+    /* Masks whose shifts are close look at mostly the same glyph id bits,
+     * so only pick ones far enough apart to filter roughly independently;
+     * then the false positive rate is about the product of densities.
+     * Start from the fixed shifts, so only a strictly better choice
+     * changes anything. */
+    unsigned int best[NUM_MASKS] = {4, 0, 9};
+    float best_score = density[4] * density[0] * density[9];
+    for (unsigned int i = 0; i < NUM_SHIFTS; i++)
+      for (unsigned int j = i + MIN_SHIFT_DISTANCE; j < NUM_SHIFTS; j++)
+	for (unsigned int k = j + MIN_SHIFT_DISTANCE; k < NUM_SHIFTS; k++)
+	{
+	  float score = density[i] * density[j] * density[k];
+	  if (score < best_score)
+	  {
+	    best_score = score;
+	    best[0] = i; best[1] = j; best[2] = k;
+	  }
+	}
+
+    for (unsigned int i = 0; i < NUM_MASKS; i++)
+    {
+      shifts[i] = best[i];
+      masks[i] = b.masks[best[i]];
+    }
+  }
+
+  bool may_have (hb_codepoint_t g) const
+  {
+    return (masks[0] & mask_for (g, shifts[0])) &&
+	   (masks[1] & mask_for (g, shifts[1])) &&
+	   (masks[2] & mask_for (g, shifts[2]));
+  }
+
+  /* Whether the set may have a glyph in common with the one added to b. */
+  bool may_have (const builder_t &b) const
+  {
+    return (masks[0] & b.masks[shifts[0]]) &&
+	   (masks[1] & b.masks[shifts[1]]) &&
+	   (masks[2] & b.masks[shifts[2]]);
+  }
+
+  private:
+  static mask_t mask_for (hb_codepoint_t g, unsigned int shift)
+  { return ((mask_t) 1) << ((g >> shift) & (mask_bits - 1)); }
+
+  mask_t masks[NUM_MASKS];
+  uint8_t shifts[NUM_MASKS];
+};
+
+
 #endif /* HB_SET_DIGEST_HH */
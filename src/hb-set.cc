@@ -239,6 +239,29 @@ hb_set_add_range (hb_set_t       *set,
   set->add_range (first, last);
 }
 
+/**
+ * hb_set_add_sorted_array:
+ * @set: a set.
+ * @sorted_codepoints: (array length=num_codepoints): codepoints to add, in
+ * increasing order.
+ * @num_codepoints: number of codepoints in @sorted_codepoints.
+ *
+ * Adds all of @sorted_codepoints to @set.  This is faster than calling
+ * hb_set_add() for each, as runs of codepoints that fall on the same page
+ * of the set are added without looking the page up again.  Unsorted input
+ * is still added correctly, just more slowly.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_set_add_sorted_array (hb_set_t             *set,
+			 const hb_codepoint_t *sorted_codepoints,
+			 unsigned int          num_codepoints)
+{
+  if (!set->add_sorted_array (sorted_codepoints, num_codepoints))
+    set->add_array (sorted_codepoints, num_codepoints);
+}
+
 /**
  * hb_set_del:
  * @set: a set.
@@ -393,15 +416,18 @@ hb_set_symmetric_difference (hb_set_t       *set,
  * hb_set_invert:
  * @set: a set.
  *
- * 
+ * Inverts the contents of @set: afterwards it contains exactly the
+ * numbers it did not contain before.  This takes constant time, and
+ * further operations on the set cost in proportion to the numbers it
+ * does not contain, so sets of almost everything are cheap to build
+ * this way.
  *
  * Since: 0.9.10
- *
- * Deprecated: 1.6.1
  **/
 void
-hb_set_invert (hb_set_t *set HB_UNUSED)
+hb_set_invert (hb_set_t *set)
 {
+  set->invert ();
 }
 
 /**
@@ -472,6 +498,34 @@ hb_set_next (const hb_set_t *set,
   return set->next (codepoint);
 }
 
+/**
+ * hb_set_next_many:
+ * @set: a set.
+ * @codepoint: value to start after.
+ * @out: (out) (array length=size): array to write values to.
+ * @size: size of @out.
+ *
+ * Writes the numbers in @set that are greater than @codepoint to @out, in
+ * increasing order, until @out is full.  Pass the last value written as
+ * @codepoint to continue.  To iterate a large set, this is much faster
+ * than calling hb_set_next() for each value.
+ *
+ * Set @codepoint to %HB_SET_VALUE_INVALID to get started.
+ *
+ * Return value: the number of values written; less than @size only if
+ * there are no more.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_set_next_many (const hb_set_t *set,
+		  hb_codepoint_t  codepoint,
+		  hb_codepoint_t *out,
+		  unsigned int    size)
+{
+  return set->next_many (codepoint, out, size);
+}
+
 /**
  * hb_set_previous:
  * @set: a set.
@@ -59,13 +59,7 @@ struct hb_set_t
     unsigned int len () const
     { return ARRAY_LENGTH_CONST (v); }
 
-    bool is_empty () const
-    {
-      for (unsigned int i = 0; i < len (); i++)
-        if (v[i])
-	  return false;
-      return true;
-    }
+    bool is_empty () const { return v.is_zero (); }
 
     void add (hb_codepoint_t g) { elt (g) |= mask (g); }
     void del (hb_codepoint_t g) { elt (g) &= ~mask (g); }
@@ -87,19 +81,29 @@ struct hb_set_t
 	*lb |= ((mask (b) << 1) - 1);
       }
     }
+    void del_range (hb_codepoint_t a, hb_codepoint_t b)
+    {
+      elt_t *la = &elt (a);
+      elt_t *lb = &elt (b);
+      if (la == lb)
+        *la &= ~((mask (b) << 1) - mask(a));
+      else
+      {
+	*la &= mask (a) - 1;
+	la++;
+
+	memset (la, 0, (char *) lb - (char *) la);
+
+	*lb &= ~((mask (b) << 1) - 1);
+      }
+    }
 
     bool is_equal (const page_t *other) const
     {
       return 0 == hb_memcmp (&v, &other->v, sizeof (v));
     }
 
-    unsigned int get_population () const
-    {
-      unsigned int pop = 0;
-      for (unsigned int i = 0; i < len (); i++)
-        pop += hb_popcount (v[i]);
-      return pop;
-    }
+    unsigned int get_population () const { return v.get_population (); }
 
     bool next (hb_codepoint_t *codepoint) const
     {
@@ -134,7 +138,7 @@ struct hb_set_t
       unsigned int i = m / ELT_BITS;
       unsigned int j = m & ELT_MASK;
 
-      const elt_t vv = v[i] & ((elt_t (1) << (j + 1)) - 1);
+      const elt_t vv = v[i] & ((elt_t (2) << j) - 1);
       for (const elt_t *p = &vv; (int) i >= 0; p = &v[--i])
 	if (*p)
 	{
@@ -157,7 +161,7 @@ struct hb_set_t
       for (int i = len () - 1; i >= 0; i--)
         if (v[i])
 	  return i * ELT_BITS + elt_get_max (v[i]);
-      return 0;
+      return INVALID;
     }
 
     typedef unsigned long long elt_t;
@@ -185,13 +189,17 @@ struct hb_set_t
 
   hb_object_header_t header;
   bool successful; /* Allocations successful */
-  mutable unsigned int population;
+  /* If set, the set holds every value the pages below do *not* have; this
+   * makes sets of nearly everything take space for their holes only. */
+  bool inverted;
+  mutable unsigned int population; /* Of the pages, not the set. */
   hb_sorted_vector_t<page_map_t> page_map;
   hb_vector_t<page_t> pages;
 
   void init_shallow ()
   {
     successful = true;
+    inverted = false;
     population = 0;
     page_map.init ();
     pages.init ();
@@ -215,6 +223,9 @@ struct hb_set_t
 
   bool in_error () const { return !successful; }
 
+  unsigned int get_heap_size () const
+  { return page_map.get_heap_size () + pages.get_heap_size (); }
+
   bool resize (unsigned int count)
   {
     if (unlikely (!successful)) return false;
@@ -240,11 +251,18 @@ struct hb_set_t
     if (unlikely (hb_object_is_immutable (this)))
       return;
     population = 0;
+    inverted = false;
     page_map.resize (0);
     pages.resize (0);
   }
   bool is_empty () const
   {
+    if (unlikely (inverted))
+    {
+      /* Only if the pages have every value. */
+      hb_codepoint_t first = INVALID, last = INVALID;
+      return bits_next_range (&first, &last) && first == 0 && last == INVALID - 1;
+    }
     unsigned int count = pages.length;
     for (unsigned int i = 0; i < count; i++)
       if (!pages[i].is_empty ())
@@ -254,41 +272,31 @@ struct hb_set_t
 
   void dirty () { population = (unsigned int) -1; }
 
-  void add (hb_codepoint_t g)
+  /* Turns the set into its complement, in constant time. */
+  void invert ()
   {
+    if (unlikely (hb_object_is_immutable (this)))
+      return;
     if (unlikely (!successful)) return;
-    if (unlikely (g == INVALID)) return;
-    dirty ();
-    page_t *page = page_for_insert (g); if (unlikely (!page)) return;
-    page->add (g);
+    inverted = !inverted;
+  }
+  bool is_inverted () const { return inverted; }
+
+  void add (hb_codepoint_t g)
+  {
+    if (unlikely (inverted)) bits_del (g);
+    else bits_add (g);
   }
   bool add_range (hb_codepoint_t a, hb_codepoint_t b)
   {
-    if (unlikely (!successful)) return true; /* https://github.com/harfbuzz/harfbuzz/issues/657 */
-    if (unlikely (a > b || a == INVALID || b == INVALID)) return false;
-    dirty ();
-    unsigned int ma = get_major (a);
-    unsigned int mb = get_major (b);
-    if (ma == mb)
+    if (unlikely (inverted))
     {
-      page_t *page = page_for_insert (a); if (unlikely (!page)) return false;
-      page->add_range (a, b);
-    }
-    else
-    {
-      page_t *page = page_for_insert (a); if (unlikely (!page)) return false;
-      page->add_range (a, major_start (ma + 1) - 1);
-
-      for (unsigned int m = ma + 1; m < mb; m++)
-      {
-	page = page_for_insert (major_start (m)); if (unlikely (!page)) return false;
-	page->init1 ();
-      }
-
-      page = page_for_insert (b); if (unlikely (!page)) return false;
-      page->add_range (major_start (mb), b);
+      if (unlikely (!successful)) return true;
+      if (unlikely (a > b || a == INVALID || b == INVALID)) return false;
+      bits_del_range (a, b);
+      return true;
     }
-    return true;
+    return bits_add_range (a, b);
   }
 
   template <typename T>
@@ -297,6 +305,12 @@ struct hb_set_t
     if (unlikely (!successful)) return;
     if (!count) return;
     dirty ();
+    if (unlikely (inverted))
+    {
+      for (; count; count--, array = (const T *) ((const char *) array + stride))
+	bits_del (*array);
+      return;
+    }
     hb_codepoint_t g = *array;
     while (count)
     {
@@ -325,6 +339,17 @@ struct hb_set_t
     dirty ();
     hb_codepoint_t g = *array;
     hb_codepoint_t last_g = g;
+    if (unlikely (inverted))
+    {
+      for (; count; count--, array = (const T *) ((const char *) array + stride))
+      {
+	g = *array;
+	if (g < last_g) return false;
+	last_g = g;
+	bits_del (g);
+      }
+      return true;
+    }
     while (count)
     {
       unsigned int m = get_major (g);
@@ -348,28 +373,18 @@ struct hb_set_t
 
   void del (hb_codepoint_t g)
   {
-    /* TODO perform op even if !successful. */
-    if (unlikely (!successful)) return;
-    page_t *page = page_for (g);
-    if (!page)
-      return;
-    dirty ();
-    page->del (g);
+    if (unlikely (inverted)) bits_add (g);
+    else bits_del (g);
   }
   void del_range (hb_codepoint_t a, hb_codepoint_t b)
   {
-    /* TODO perform op even if !successful. */
-    /* TODO Optimize, like add_range(). */
-    if (unlikely (!successful)) return;
-    for (unsigned int i = a; i < b + 1; i++)
-      del (i);
+    if (unlikely (inverted)) bits_add_range (a, b);
+    else bits_del_range (a, b);
   }
   bool get (hb_codepoint_t g) const
   {
-    const page_t *page = page_for (g);
-    if (!page)
-      return false;
-    return page->get (g);
+    if (unlikely (g == INVALID)) return false;
+    return bits_get (g) != inverted;
   }
 
   /* Has interface. */
@@ -395,13 +410,31 @@ struct hb_set_t
     if (!resize (count))
       return;
     population = other->population;
+    inverted = other->inverted;
     memcpy ((void *) pages, (const void *) other->pages, count * pages.item_size);
     memcpy ((void *) page_map, (const void *) other->page_map, count * page_map.item_size);
   }
 
   bool is_equal (const hb_set_t *other) const
   {
-    if (get_population () != other->get_population ())
+    if (unlikely (inverted != other->inverted))
+    {
+      /* Compare as ranges; O(runs). */
+      hb_codepoint_t a_first = INVALID, a_last = INVALID;
+      hb_codepoint_t b_first = INVALID, b_last = INVALID;
+      bool a_more, b_more;
+      do
+      {
+	a_more = next_range (&a_first, &a_last);
+	b_more = other->next_range (&b_first, &b_last);
+	if (a_more != b_more || a_first != b_first || a_last != b_last)
+	  return false;
+      }
+      while (a_more);
+      return true;
+    }
+
+    if (bits_get_population () != other->bits_get_population ())
       return false;
 
     unsigned int na = pages.length;
@@ -428,6 +461,14 @@ struct hb_set_t
 
   bool is_subset (const hb_set_t *larger_set) const
   {
+    if (unlikely (inverted || larger_set->inverted))
+    {
+      hb_set_t difference;
+      difference.set (this);
+      difference.subtract (larger_set);
+      return !difference.in_error () && difference.is_empty ();
+    }
+
     if (get_population () > larger_set->get_population ())
       return false;
 
@@ -453,10 +494,20 @@ struct hb_set_t
 
     unsigned int count = 0, newCount = 0;
     unsigned int a = 0, b = 0;
+    unsigned int write_index = 0;
     for (; a < na && b < nb; )
     {
       if (page_map[a].major == other->page_map[b].major)
       {
+	if (!Op::passthru_left)
+	{
+	  /* Pages of ours without a match go away; move the rest to the
+	   * front, so that the in-place pass below never overwrites a page
+	   * map entry it has yet to read. */
+	  if (write_index < a)
+	    page_map[write_index] = page_map[a];
+	  write_index++;
+	}
         count++;
 	a++;
 	b++;
@@ -479,6 +530,14 @@ struct hb_set_t
     if (Op::passthru_right)
       count += nb - b;
 
+    if (!Op::passthru_left)
+    {
+      na = write_index;
+      next_page = write_index;
+      if (unlikely (!compact_pages (write_index)))
+	return;
+    }
+
     if (count > pages.length)
       if (!resize (count))
         return;
@@ -495,7 +554,7 @@ struct hb_set_t
 	b--;
 	count--;
 	page_map[count] = page_map[a];
-	Op::process (page_at (count).v, page_at (a).v, other->page_at (b).v);
+	page_at (count).v = page_at (a).v.template process<Op> (other->page_at (b).v);
       }
       else if (page_map[a - 1].major > other->page_map[b - 1].major)
       {
@@ -539,26 +598,305 @@ struct hb_set_t
       resize (newCount);
   }
 
+  /* With one or both operands inverted, each operation maps onto one on
+   * the pages (a, b) and possibly inverting the result:
+   *
+   *		~a, b		a, ~b		~a, ~b
+   * union	~(a - b)	~(b - a)	~(a & b)
+   * intersect	b - a		a - b		~(a | b)
+   * subtract	~(a | b)	a & b		b - a
+   * xor		~(a ^ b)	~(a ^ b)	a ^ b
+   */
   void union_ (const hb_set_t *other)
   {
-    process<HbOpOr> (other);
+    if (likely (!inverted && !other->inverted)) process<HbOpOr> (other);
+    else if (!other->inverted) process<HbOpMinus> (other);
+    else if (!inverted) { process<HbOpReverseMinus> (other); inverted = true; }
+    else process<HbOpAnd> (other);
   }
   void intersect (const hb_set_t *other)
   {
-    process<HbOpAnd> (other);
+    if (likely (!inverted && !other->inverted)) process<HbOpAnd> (other);
+    else if (!other->inverted) { process<HbOpReverseMinus> (other); inverted = false; }
+    else if (!inverted) process<HbOpMinus> (other);
+    else process<HbOpOr> (other);
   }
   void subtract (const hb_set_t *other)
   {
-    process<HbOpMinus> (other);
+    if (likely (!inverted && !other->inverted)) process<HbOpMinus> (other);
+    else if (!other->inverted) process<HbOpOr> (other);
+    else if (!inverted) process<HbOpAnd> (other);
+    else { process<HbOpReverseMinus> (other); inverted = false; }
   }
   void symmetric_difference (const hb_set_t *other)
   {
     process<HbOpXor> (other);
+    if (unlikely (other->inverted))
+      inverted = !inverted;
   }
   bool next (hb_codepoint_t *codepoint) const
+  {
+    if (likely (!inverted)) return bits_next (codepoint);
+
+    /* The next hole in the pages. */
+    hb_codepoint_t old = *codepoint;
+    if (unlikely (old + 1 == INVALID))
+    {
+      *codepoint = INVALID;
+      return false;
+    }
+    hb_codepoint_t v = old;
+    bits_next (&v);
+    if (old + 1 < v)
+    {
+      *codepoint = old + 1;
+      return true;
+    }
+    v = old;
+    bits_next_range (&old, &v);
+    *codepoint = v + 1;
+    return *codepoint != INVALID;
+  }
+  bool previous (hb_codepoint_t *codepoint) const
+  {
+    if (likely (!inverted)) return bits_previous (codepoint);
+
+    hb_codepoint_t old = *codepoint;
+    if (unlikely (old - 1 == INVALID))
+    {
+      *codepoint = INVALID;
+      return false;
+    }
+    hb_codepoint_t v = old;
+    bits_previous (&v);
+    if (old - 1 > v || v == INVALID)
+    {
+      *codepoint = old - 1;
+      return true;
+    }
+    v = old;
+    bits_previous_range (&v, &old);
+    *codepoint = v - 1;
+    return *codepoint != INVALID;
+  }
+  /* Writes up to size values greater than codepoint to out, in order;
+   * returns how many.  Walks pages directly instead of searching the
+   * page map for every value like next() does. */
+  unsigned int next_many (hb_codepoint_t codepoint,
+			  hb_codepoint_t *out,
+			  unsigned int size) const
+  {
+    if (unlikely (!size)) return 0;
+
+    if (unlikely (inverted))
+    {
+      unsigned int n = 0;
+      hb_codepoint_t first, last = codepoint;
+      while (n < size && next_range (&first, &last))
+	for (hb_codepoint_t g = first; n < size && g <= last; g++)
+	  out[n++] = g;
+      return n;
+    }
+
+    unsigned int i = 0;
+    unsigned int start_bit = 0;
+    if (codepoint != INVALID)
+    {
+      page_map_t map = {get_major (codepoint), 0};
+      page_map.bfind (map, &i, HB_BFIND_NOT_FOUND_STORE_CLOSEST);
+      if (i < page_map.length && page_map[i].major == map.major)
+      {
+	start_bit = (codepoint + 1) & page_t::MASK;
+	if (!start_bit)
+	  i++;
+      }
+    }
+
+    unsigned int n = 0;
+    for (; i < page_map.length; i++, start_bit = 0)
+    {
+      const page_t &page = pages[page_map[i].index];
+      hb_codepoint_t base = page_map[i].major * page_t::PAGE_BITS;
+      for (unsigned int j = start_bit / page_t::ELT_BITS; j < page.len (); j++)
+      {
+	page_t::elt_t bits = page.v[j];
+	if (j == start_bit / page_t::ELT_BITS)
+	  bits &= ~((page_t::elt_t (1) << (start_bit & page_t::ELT_MASK)) - 1);
+	while (bits)
+	{
+	  out[n++] = base + j * page_t::ELT_BITS + page_t::elt_get_min (bits);
+	  if (n == size)
+	    return n;
+	  bits &= bits - 1;
+	}
+      }
+    }
+    return n;
+  }
+
+  bool next_range (hb_codepoint_t *first, hb_codepoint_t *last) const
+  {
+    if (likely (!inverted)) return bits_next_range (first, last);
+
+    if (!next (last))
+    {
+      *last = *first = INVALID;
+      return false;
+    }
+
+    *first = *last;
+    hb_codepoint_t i = *last;
+    bits_next (&i);
+    *last = i - 1;
+    return true;
+  }
+  bool previous_range (hb_codepoint_t *first, hb_codepoint_t *last) const
+  {
+    if (likely (!inverted)) return bits_previous_range (first, last);
+
+    if (!previous (first))
+    {
+      *last = *first = INVALID;
+      return false;
+    }
+
+    *last = *first;
+    hb_codepoint_t i = *first;
+    bits_previous (&i);
+    *first = i + 1;
+    return true;
+  }
+
+  unsigned int get_population () const
+  {
+    unsigned int pop = bits_get_population ();
+    return unlikely (inverted) ? INVALID - pop : pop;
+  }
+  hb_codepoint_t get_min () const
+  {
+    hb_codepoint_t v = INVALID;
+    next (&v);
+    return v;
+  }
+  hb_codepoint_t get_max () const
+  {
+    hb_codepoint_t v = INVALID;
+    previous (&v);
+    return v;
+  }
+
+  static constexpr hb_codepoint_t INVALID = HB_SET_VALUE_INVALID;
+
+  /*
+   * Iterator implementation.
+   */
+  struct iter_t : hb_iter_with_fallback_t<iter_t, hb_codepoint_t>
+  {
+    static constexpr bool is_sorted_iterator = true;
+    iter_t (const hb_set_t &s_ = Null(hb_set_t)) :
+      s (&s_), v (INVALID), l (s->get_population () + 1) { __next__ (); }
+
+    typedef hb_codepoint_t __item_t__;
+    hb_codepoint_t __item__ () const { return v; }
+    bool __more__ () const { return v != INVALID; }
+    void __next__ () { s->next (&v); if (l) l--; }
+    void __prev__ () { s->previous (&v); }
+    unsigned __len__ () const { return l; }
+    iter_t end () const { return iter_t (*s); }
+    bool operator != (const iter_t& o) const
+    { return s != o.s || v != o.v; }
+
+    protected:
+    const hb_set_t *s;
+    hb_codepoint_t v;
+    unsigned l;
+  };
+  iter_t iter () const { return iter_t (*this); }
+  operator iter_t () const { return iter (); }
+
+  protected:
+
+  /*
+   * The values actually held in the pages; what the set holds is these,
+   * or everything but these if the set is inverted.
+   */
+
+  void bits_add (hb_codepoint_t g)
+  {
+    if (unlikely (!successful)) return;
+    if (unlikely (g == INVALID)) return;
+    dirty ();
+    page_t *page = page_for_insert (g); if (unlikely (!page)) return;
+    page->add (g);
+  }
+  bool bits_add_range (hb_codepoint_t a, hb_codepoint_t b)
+  {
+    if (unlikely (!successful)) return true; /* https://github.com/harfbuzz/harfbuzz/issues/657 */
+    if (unlikely (a > b || a == INVALID || b == INVALID)) return false;
+    dirty ();
+    unsigned int ma = get_major (a);
+    unsigned int mb = get_major (b);
+    if (ma == mb)
+    {
+      page_t *page = page_for_insert (a); if (unlikely (!page)) return false;
+      page->add_range (a, b);
+    }
+    else
+    {
+      page_t *page = page_for_insert (a); if (unlikely (!page)) return false;
+      page->add_range (a, major_start (ma + 1) - 1);
+
+      for (unsigned int m = ma + 1; m < mb; m++)
+      {
+	page = page_for_insert (major_start (m)); if (unlikely (!page)) return false;
+	page->init1 ();
+      }
+
+      page = page_for_insert (b); if (unlikely (!page)) return false;
+      page->add_range (major_start (mb), b);
+    }
+    return true;
+  }
+  void bits_del (hb_codepoint_t g)
+  {
+    /* TODO perform op even if !successful. */
+    if (unlikely (!successful)) return;
+    page_t *page = page_for (g);
+    if (!page)
+      return;
+    dirty ();
+    page->del (g);
+  }
+  void bits_del_range (hb_codepoint_t a, hb_codepoint_t b)
+  {
+    /* TODO perform op even if !successful. */
+    if (unlikely (!successful)) return;
+    if (unlikely (a > b || a == INVALID)) return;
+    dirty ();
+    unsigned int ma = get_major (a);
+    unsigned int mb = get_major (b);
+    page_map_t map = {ma, 0};
+    unsigned int i;
+    page_map.bfind (map, &i, HB_BFIND_NOT_FOUND_STORE_CLOSEST);
+    for (; i < page_map.length && page_map[i].major <= mb; i++)
+    {
+      unsigned int m = page_map[i].major;
+      page_at (i).del_range (m == ma ? a : major_start (m),
+			     m == mb ? b : major_start (m) + page_t::MASK);
+    }
+  }
+  bool bits_get (hb_codepoint_t g) const
+  {
+    const page_t *page = page_for (g);
+    if (!page)
+      return false;
+    return page->get (g);
+  }
+
+  bool bits_next (hb_codepoint_t *codepoint) const
   {
     if (unlikely (*codepoint == INVALID)) {
-      *codepoint = get_min ();
+      *codepoint = bits_get_min ();
       return *codepoint != INVALID;
     }
 
@@ -586,10 +924,10 @@ struct hb_set_t
     *codepoint = INVALID;
     return false;
   }
-  bool previous (hb_codepoint_t *codepoint) const
+  bool bits_previous (hb_codepoint_t *codepoint) const
   {
     if (unlikely (*codepoint == INVALID)) {
-      *codepoint = get_max ();
+      *codepoint = bits_get_max ();
       return *codepoint != INVALID;
     }
 
@@ -617,44 +955,80 @@ struct hb_set_t
     *codepoint = INVALID;
     return false;
   }
-  bool next_range (hb_codepoint_t *first, hb_codepoint_t *last) const
+  bool bits_next_range (hb_codepoint_t *first, hb_codepoint_t *last) const
   {
-    hb_codepoint_t i;
-
-    i = *last;
-    if (!next (&i))
+    hb_codepoint_t i = *last;
+    if (!bits_next (&i))
     {
       *last = *first = INVALID;
       return false;
     }
 
-    /* TODO Speed up. */
-    *last = *first = i;
-    while (next (&i) && i == *last + 1)
-      (*last)++;
-
+    *first = i;
+    *last = bits_run_end (i);
     return true;
   }
-  bool previous_range (hb_codepoint_t *first, hb_codepoint_t *last) const
+  bool bits_previous_range (hb_codepoint_t *first, hb_codepoint_t *last) const
   {
-    hb_codepoint_t i;
-
-    i = *first;
-    if (!previous (&i))
+    hb_codepoint_t i = *first;
+    if (!bits_previous (&i))
     {
       *last = *first = INVALID;
       return false;
     }
 
-    /* TODO Speed up. */
-    *last = *first = i;
-    while (previous (&i) && i == *first - 1)
-      (*first)--;
-
+    *last = i;
+    *first = bits_run_start (i);
     return true;
   }
+  /* Last value of the run of values in the pages that g, which must be in
+   * them, is part of; looks at whole words instead of single bits.  Value
+   * INVALID is never in the pages, so this can't overflow. */
+  hb_codepoint_t bits_run_end (hb_codepoint_t g) const
+  {
+    page_map_t map = {get_major (g), 0};
+    unsigned int i;
+    page_map.bfind (map, &i);
+    unsigned int j = (g & page_t::MASK) / page_t::ELT_BITS;
+    page_t::elt_t bits = ~page_at (i).v[j] & ~(page_at (i).mask (g) - 1);
+    for (;;)
+    {
+      if (bits)
+	return major_start (page_map[i].major) + j * page_t::ELT_BITS + page_t::elt_get_min (bits) - 1;
+      if (++j == page_at (i).len ())
+      {
+	if (i + 1 == page_map.length || page_map[i + 1].major != page_map[i].major + 1)
+	  return major_start (page_map[i].major + 1) - 1;
+	i++;
+	j = 0;
+      }
+      bits = ~page_at (i).v[j];
+    }
+  }
+  hb_codepoint_t bits_run_start (hb_codepoint_t g) const
+  {
+    page_map_t map = {get_major (g), 0};
+    unsigned int i;
+    page_map.bfind (map, &i);
+    unsigned int j = (g & page_t::MASK) / page_t::ELT_BITS;
+    page_t::elt_t bits = ~page_at (i).v[j] & (page_at (i).mask (g) - 1);
+    for (;;)
+    {
+      if (bits)
+	return major_start (page_map[i].major) + j * page_t::ELT_BITS + page_t::elt_get_max (bits) + 1;
+      if (!j)
+      {
+	if (!i || page_map[i - 1].major + 1 != page_map[i].major)
+	  return major_start (page_map[i].major);
+	i--;
+	j = page_at (i).len ();
+      }
+      j--;
+      bits = ~page_at (i).v[j];
+    }
+  }
 
-  unsigned int get_population () const
+  unsigned int bits_get_population () const
   {
     if (population != (unsigned int) -1)
       return population;
@@ -667,7 +1041,7 @@ struct hb_set_t
     population = pop;
     return pop;
   }
-  hb_codepoint_t get_min () const
+  hb_codepoint_t bits_get_min () const
   {
     unsigned int count = pages.length;
     for (unsigned int i = 0; i < count; i++)
@@ -675,45 +1049,40 @@ struct hb_set_t
         return page_map[i].major * page_t::PAGE_BITS + page_at (i).get_min ();
     return INVALID;
   }
-  hb_codepoint_t get_max () const
+  hb_codepoint_t bits_get_max () const
   {
     unsigned int count = pages.length;
-    for (int i = count - 1; i >= 0; i++)
+    for (int i = count - 1; i >= 0; i--)
       if (!page_at (i).is_empty ())
         return page_map[(unsigned) i].major * page_t::PAGE_BITS + page_at (i).get_max ();
     return INVALID;
   }
 
-  static constexpr hb_codepoint_t INVALID = HB_SET_VALUE_INVALID;
-
-  /*
-   * Iterator implementation.
-   */
-  struct iter_t : hb_iter_with_fallback_t<iter_t, hb_codepoint_t>
+  /* Moves the pages the first count page map entries point to, to the
+   * front of pages, so that pages past count are free to reuse. */
+  bool compact_pages (unsigned int count)
   {
-    static constexpr bool is_sorted_iterator = true;
-    iter_t (const hb_set_t &s_ = Null(hb_set_t)) :
-      s (&s_), v (INVALID), l (s->get_population () + 1) { __next__ (); }
-
-    typedef hb_codepoint_t __item_t__;
-    hb_codepoint_t __item__ () const { return v; }
-    bool __more__ () const { return v != INVALID; }
-    void __next__ () { s->next (&v); if (l) l--; }
-    void __prev__ () { s->previous (&v); }
-    unsigned __len__ () const { return l; }
-    iter_t end () const { return iter_t (*s); }
-    bool operator != (const iter_t& o) const
-    { return s != o.s || v != o.v; }
-
-    protected:
-    const hb_set_t *s;
-    hb_codepoint_t v;
-    unsigned l;
-  };
-  iter_t iter () const { return iter_t (*this); }
-  operator iter_t () const { return iter (); }
+    hb_vector_t<unsigned int> page_map_index;
+    if (unlikely (!page_map_index.resize (pages.length)))
+    {
+      successful = false;
+      return false;
+    }
+    for (unsigned int i = 0; i < page_map_index.length; i++)
+      page_map_index[i] = (unsigned int) -1;
+    for (unsigned int i = 0; i < count; i++)
+      page_map_index[page_map[i].index] = i;
 
-  protected:
+    unsigned int write_index = 0;
+    for (unsigned int i = 0; i < page_map_index.length; i++)
+    {
+      if (page_map_index[i] == (unsigned int) -1) continue;
+      if (write_index < i)
+	pages[write_index] = pages[i];
+      page_map[page_map_index[i]].index = write_index++;
+    }
+    return true;
+  }
 
   page_t *page_for_insert (hb_codepoint_t g)
   {
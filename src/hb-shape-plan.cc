@@ -108,15 +108,48 @@ hb_shape_plan_key_t::init (bool                           copy,
   }
   else
   {
+    /* The face remembers which shaper the default order picked for it, as
+     * (serial << 4) | HB_SHAPER_ORDER, to skip probing next time.  Face
+     * data never changes once loaded, so this holds until the order does.
+     * Read the serial first; a new order is published before its serial. */
+    static_assert (HB_SHAPERS_COUNT < 16, "");
+    unsigned int serial = _hb_shapers_get_serial () & 0x0FFFFFFFu;
+    int chosen = face->default_shaper.get_relaxed ();
+    if (chosen && (unsigned int) chosen >> 4 == serial)
+    {
+      unsigned int order = chosen & 0xF;
+      if (false)
+	;
+#define HB_SHAPER_IMPLEMENT(shaper) \
+      else if (order == HB_SHAPER_ORDER (shaper)) \
+      { \
+	this->shaper_func = _hb_##shaper##_shape; \
+	this->shaper_name = #shaper; \
+	return true; \
+      }
+#include "hb-shaper-list.hh"
+#undef HB_SHAPER_IMPLEMENT
+    }
+
+#define HB_SHAPER_REMEMBER(shaper) \
+	HB_STMT_START { \
+	  if (face->data.shaper && !hb_object_is_inert (face)) \
+	    face->default_shaper.set_relaxed ((int) (serial << 4 | HB_SHAPER_ORDER (shaper))); \
+	} HB_STMT_END
+
     const hb_shaper_entry_t *shapers = _hb_shapers_get ();
     for (unsigned int i = 0; i < HB_SHAPERS_COUNT; i++)
       if (false)
 	;
 #define HB_SHAPER_IMPLEMENT(shaper) \
       else if (shapers[i].func == _hb_##shaper##_shape) \
-	HB_SHAPER_PLAN (shaper);
+      { \
+	HB_SHAPER_REMEMBER (shaper); \
+	HB_SHAPER_PLAN (shaper); \
+      }
 #include "hb-shaper-list.hh"
 #undef HB_SHAPER_IMPLEMENT
+#undef HB_SHAPER_REMEMBER
   }
 #undef HB_SHAPER_PLAN
 
@@ -152,11 +185,272 @@ hb_shape_plan_key_t::equal (const hb_shape_plan_key_t *other)
 	 this->shaper_func == other->shaper_func;
 }
 
+uint32_t
+hb_shape_plan_key_t::hash () const
+{
+  /* Must only mix in what equal() compares. */
+  uint32_t h = hb_hash ((unsigned int) props.direction);
+  h = h * 31 + hb_hash ((unsigned int) props.script);
+  h = h * 31 + hb_hash ((uintptr_t) props.language);
+  for (unsigned int i = 0; i < num_user_features; i++)
+  {
+    h = h * 31 + hb_hash (user_features[i].tag);
+    h = h * 31 + hb_hash (user_features[i].value);
+    h = h * 31 + (user_features[i].start == HB_FEATURE_GLOBAL_START &&
+		  user_features[i].end   == HB_FEATURE_GLOBAL_END);
+  }
+  h = h * 31 + hb_hash (ot.variations_index[0]);
+  h = h * 31 + hb_hash (ot.variations_index[1]);
+  h = h * 31 + hb_hash ((uintptr_t) shaper_func);
+  return h;
+}
+
+
+/*
+ * hb_shape_plan_cache_t
+ */
+
+void
+hb_shape_plan_cache_t::init ()
+{
+  lock.init ();
+  buckets = nullptr;
+  bucket_mask = 0;
+  head = tail = nullptr;
+  count = 0;
+  capacity = HB_SHAPE_PLAN_CACHE_DEFAULT_CAPACITY;
+  hits = misses = evictions = 0;
+}
+
+void
+hb_shape_plan_cache_t::fini ()
+{
+  destroy_nodes ();
+  lock.fini ();
+}
+
+void
+hb_shape_plan_cache_t::clear ()
+{
+  hb_lock_t l (lock);
+  destroy_nodes ();
+}
+
+void
+hb_shape_plan_cache_t::destroy_nodes ()
+{
+  for (node_t *node = head; node; )
+  {
+    node_t *next = node->next;
+    hb_shape_plan_destroy (node->shape_plan);
+    free (node);
+    node = next;
+  }
+  free (buckets);
+  buckets = nullptr;
+  head = tail = nullptr;
+  count = 0;
+}
+
+hb_shape_plan_cache_t::node_t *
+hb_shape_plan_cache_t::find (const hb_shape_plan_key_t *key, uint32_t hash) const
+{
+  if (unlikely (!buckets)) return nullptr;
+  for (node_t *node = buckets[hash & bucket_mask]; node; node = node->next_in_bucket)
+    if (node->hash == hash && node->shape_plan->key.equal (key))
+      return node;
+  return nullptr;
+}
+
+void
+hb_shape_plan_cache_t::promote (node_t *node)
+{
+  if (node == head) return;
+
+  /* Detach from LRU list... */
+  node->prev->next = node->next;
+  if (node->next)
+    node->next->prev = node->prev;
+  else
+    tail = node->prev;
+
+  /* ...and put it in front. */
+  node->prev = nullptr;
+  node->next = head;
+  head->prev = node;
+  head = node;
+}
+
+void
+hb_shape_plan_cache_t::unlink (node_t *node)
+{
+  if (node->prev)
+    node->prev->next = node->next;
+  else
+    head = node->next;
+  if (node->next)
+    node->next->prev = node->prev;
+  else
+    tail = node->prev;
+
+  node_t **p = &buckets[node->hash & bucket_mask];
+  while (*p != node)
+    p = &(*p)->next_in_bucket;
+  *p = node->next_in_bucket;
+
+  count--;
+}
+
+void
+hb_shape_plan_cache_t::evict_to (unsigned int max_count)
+{
+  while (count > max_count)
+  {
+    node_t *node = tail;
+    unlink (node);
+    DEBUG_MSG_FUNC (SHAPE_PLAN, node->shape_plan, "evicted from cache");
+    hb_shape_plan_destroy (node->shape_plan);
+    free (node);
+    evictions++;
+  }
+}
+
+bool
+hb_shape_plan_cache_t::resize_buckets (unsigned int new_capacity)
+{
+  /* Keep load factor at or below one. */
+  unsigned int new_size = 1u << hb_bit_storage (hb_min (hb_max (new_capacity, 8u), 65536u) - 1);
+  if (buckets && new_size == bucket_mask + 1)
+    return true;
+
+  node_t **new_buckets = (node_t **) calloc (new_size, sizeof (node_t *));
+  if (unlikely (!new_buckets))
+    return buckets != nullptr;
+
+  for (node_t *node = head; node; node = node->next)
+  {
+    unsigned int i = node->hash & (new_size - 1);
+    node->next_in_bucket = new_buckets[i];
+    new_buckets[i] = node;
+  }
+
+  free (buckets);
+  buckets = new_buckets;
+  bucket_mask = new_size - 1;
+  return true;
+}
+
+hb_shape_plan_t *
+hb_shape_plan_cache_t::lookup (const hb_shape_plan_key_t *key, uint32_t hash)
+{
+  hb_lock_t l (lock);
+
+  node_t *node = find (key, hash);
+  if (!node)
+  {
+    misses++;
+    return nullptr;
+  }
+
+  hits++;
+  promote (node);
+  return hb_shape_plan_reference (node->shape_plan);
+}
+
+hb_shape_plan_t *
+hb_shape_plan_cache_t::insert (hb_shape_plan_t *shape_plan, uint32_t hash)
+{
+  hb_lock_t l (lock);
+
+  /* Another thread might have beaten us to it. */
+  node_t *node = find (&shape_plan->key, hash);
+  if (node)
+  {
+    hb_shape_plan_destroy (shape_plan);
+    promote (node);
+    return hb_shape_plan_reference (node->shape_plan);
+  }
+
+  if (unlikely (!capacity || !resize_buckets (capacity)))
+    return shape_plan;
+
+  node = (node_t *) calloc (1, sizeof (node_t));
+  if (unlikely (!node))
+    return shape_plan;
+
+  evict_to (capacity - 1);
+
+  node->shape_plan = shape_plan;
+  node->hash = hash;
+  node->next_in_bucket = buckets[hash & bucket_mask];
+  buckets[hash & bucket_mask] = node;
+  node->prev = nullptr;
+  node->next = head;
+  if (head)
+    head->prev = node;
+  else
+    tail = node;
+  head = node;
+  count++;
+
+  return hb_shape_plan_reference (shape_plan);
+}
+
+void
+hb_shape_plan_cache_t::set_capacity (unsigned int new_capacity)
+{
+  hb_lock_t l (lock);
+
+  capacity = new_capacity;
+  evict_to (capacity);
+  if (buckets && capacity)
+    resize_buckets (capacity);
+}
+
+void
+hb_shape_plan_cache_t::get_stats (unsigned int *count_,
+				  unsigned int *hits_,
+				  unsigned int *misses_,
+				  unsigned int *evictions_)
+{
+  hb_lock_t l (lock);
+
+  if (count_) *count_ = count;
+  if (hits_) *hits_ = hits;
+  if (misses_) *misses_ = misses;
+  if (evictions_) *evictions_ = evictions;
+}
+
+void
+hb_shape_plan_cache_t::add_memory_usage (hb_memory_usage_t *usage)
+{
+  hb_lock_t l (lock);
+
+  if (buckets)
+    usage->heap += (bucket_mask + 1) * sizeof (buckets[0]);
+  for (const node_t *node = head; node; node = node->next)
+  {
+    const hb_shape_plan_t *shape_plan = node->shape_plan;
+    usage->heap += sizeof (*node) + sizeof (*shape_plan);
+    usage->heap += shape_plan->key.num_user_features * sizeof (hb_feature_t);
+    shape_plan->ot.map.add_memory_usage (usage);
+    usage->add_vector (shape_plan->ot.aat_map.chain_flags);
+    usage->add_vector (shape_plan->ot.aat_map.subtable_digests);
+  }
+}
+
 
 /*
  * hb_shape_plan_t
  */
 
+DEFINE_NULL_INSTANCE (hb_shape_plan_t) =
+{
+  HB_OBJECT_HEADER_STATIC,
+
+  /* Zero for the rest is fine. */
+};
+
 
 /**
  * hb_shape_plan_create: (Xconstructor)
@@ -185,21 +479,20 @@ hb_shape_plan_create (hb_face_t                     *face,
 				shaper_list);
 }
 
-hb_shape_plan_t *
-hb_shape_plan_create2 (hb_face_t                     *face,
+/* If ot_key is not nullptr, it is used instead of what coords select.
+ * serialized_map is as for hb_ot_shape_plan_t::init0(). */
+static hb_shape_plan_t *
+_hb_shape_plan_create (hb_face_t                     *face,
 		       const hb_segment_properties_t *props,
 		       const hb_feature_t            *user_features,
 		       unsigned int                   num_user_features,
 		       const int                     *coords,
 		       unsigned int                   num_coords,
-		       const char * const            *shaper_list)
+		       const char * const            *shaper_list,
+		       const hb_ot_shape_plan_key_t  *ot_key,
+		       hb_array_t<const uint32_t>    *serialized_map)
 {
-  DEBUG_MSG_FUNC (SHAPE_PLAN, nullptr,
-		  "face=%p num_features=%d num_coords=%d shaper_list=%p",
-		  face,
-		  num_user_features,
-		  num_coords,
-		  shaper_list);
+  HB_ALLOC_STATS_SCOPE (SHAPE_PLAN);
 
   assert (props->direction != HB_DIRECTION_INVALID);
 
@@ -224,7 +517,9 @@ hb_shape_plan_create2 (hb_face_t                     *face,
 				       num_coords,
 				       shaper_list)))
     goto bail2;
-  if (unlikely (!shape_plan->ot.init0 (face, &shape_plan->key)))
+  if (ot_key)
+    shape_plan->key.ot = *ot_key;
+  if (unlikely (!shape_plan->ot.init0 (face, &shape_plan->key, serialized_map)))
     goto bail3;
 
   return shape_plan;
@@ -237,6 +532,29 @@ bail:
   return hb_shape_plan_get_empty ();
 }
 
+hb_shape_plan_t *
+hb_shape_plan_create2 (hb_face_t                     *face,
+		       const hb_segment_properties_t *props,
+		       const hb_feature_t            *user_features,
+		       unsigned int                   num_user_features,
+		       const int                     *coords,
+		       unsigned int                   num_coords,
+		       const char * const            *shaper_list)
+{
+  DEBUG_MSG_FUNC (SHAPE_PLAN, nullptr,
+		  "face=%p num_features=%d num_coords=%d shaper_list=%p",
+		  face,
+		  num_user_features,
+		  num_coords,
+		  shaper_list);
+
+  return _hb_shape_plan_create (face, props,
+				user_features, num_user_features,
+				coords, num_coords,
+				shaper_list,
+				nullptr, nullptr);
+}
+
 /**
  * hb_shape_plan_get_empty:
  *
@@ -384,6 +702,8 @@ hb_shape_plan_execute (hb_shape_plan_t    *shape_plan,
   assert (shape_plan->face_unsafe == font->face);
   assert (hb_segment_properties_equal (&shape_plan->key.props, &buffer->props));
 
+  hb_buffer_trace_scope_t trace (buffer, font, HB_BUFFER_TRACE_EVENT_TYPE_SHAPE, 0, 0);
+
 #define HB_SHAPER_EXECUTE(shaper) \
 	HB_STMT_START { \
 	  return font->data.shaper && \
@@ -449,12 +769,11 @@ hb_shape_plan_create_cached2 (hb_face_t                     *face,
 		  face,
 		  num_user_features,
 		  shaper_list);
-
-retry:
-  hb_face_t::plan_node_t *cached_plan_nodes = face->shape_plans;
+  HB_ALLOC_STATS_SCOPE (SHAPE_PLAN);
 
   bool dont_cache = hb_object_is_inert (face);
 
+  uint32_t hash = 0;
   if (likely (!dont_cache))
   {
     hb_shape_plan_key_t key;
@@ -468,12 +787,13 @@ retry:
 		   shaper_list))
       return hb_shape_plan_get_empty ();
 
-    for (hb_face_t::plan_node_t *node = cached_plan_nodes; node; node = node->next)
-      if (node->shape_plan->key.equal (&key))
-      {
-        DEBUG_MSG_FUNC (SHAPE_PLAN, node->shape_plan, "fulfilled from cache");
-        return hb_shape_plan_reference (node->shape_plan);
-      }
+    hash = key.hash ();
+    hb_shape_plan_t *cached = face->shape_plans.lookup (&key, hash);
+    if (cached)
+    {
+      DEBUG_MSG_FUNC (SHAPE_PLAN, cached, "fulfilled from cache");
+      return cached;
+    }
   }
 
   hb_shape_plan_t *shape_plan = hb_shape_plan_create2 (face, props,
@@ -481,23 +801,305 @@ retry:
 						       coords, num_coords,
 						       shaper_list);
 
-  if (unlikely (dont_cache))
+  if (unlikely (dont_cache || hb_object_is_inert (shape_plan)))
     return shape_plan;
 
-  hb_face_t::plan_node_t *node = (hb_face_t::plan_node_t *) calloc (1, sizeof (hb_face_t::plan_node_t));
-  if (unlikely (!node))
-    return shape_plan;
+  shape_plan = face->shape_plans.insert (shape_plan, hash);
+  DEBUG_MSG_FUNC (SHAPE_PLAN, shape_plan, "inserted into cache");
 
-  node->shape_plan = shape_plan;
-  node->next = cached_plan_nodes;
+  return shape_plan;
+}
+
+/**
+ * hb_shape_plan_cache_set_capacity:
+ * @face: a face.
+ * @capacity: maximum number of shape plans to keep cached for @face.
+ *
+ * Sets how many shape plans hb_shape_plan_create_cached() and friends keep
+ * around for @face.  When the cache is full, the least-recently-used plan
+ * is evicted.  Setting @capacity to zero disables caching and drops all
+ * currently cached plans.  Plans held by clients are not affected.
+ *
+ * Unlike most face setters, this can be called after @face is made
+ * immutable.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_shape_plan_cache_set_capacity (hb_face_t    *face,
+				  unsigned int  capacity)
+{
+  if (unlikely (hb_object_is_inert (face)))
+    return;
+
+  face->shape_plans.set_capacity (capacity);
+}
+
+/**
+ * hb_shape_plan_cache_get_capacity:
+ * @face: a face.
+ *
+ * Return value: maximum number of shape plans cached for @face.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_shape_plan_cache_get_capacity (hb_face_t *face)
+{
+  if (unlikely (hb_object_is_inert (face)))
+    return 0;
 
-  if (unlikely (!face->shape_plans.cmpexch (cached_plan_nodes, node)))
+  return face->shape_plans.get_capacity ();
+}
+
+/**
+ * hb_shape_plan_cache_get_stats:
+ * @face: a face.
+ * @count: (out) (optional): number of plans currently cached.
+ * @hits: (out) (optional): number of lookups fulfilled from the cache.
+ * @misses: (out) (optional): number of lookups that had to create a plan.
+ * @evictions: (out) (optional): number of plans dropped to honor capacity.
+ *
+ * Fetches statistics of the shape-plan cache of @face, useful for sizing
+ * it with hb_shape_plan_cache_set_capacity().
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_shape_plan_cache_get_stats (hb_face_t    *face,
+			       unsigned int *count,    /* OUT */
+			       unsigned int *hits,     /* OUT */
+			       unsigned int *misses,   /* OUT */
+			       unsigned int *evictions /* OUT */)
+{
+  if (unlikely (hb_object_is_inert (face)))
   {
-    hb_shape_plan_destroy (shape_plan);
-    free (node);
-    goto retry;
+    if (count) *count = 0;
+    if (hits) *hits = 0;
+    if (misses) *misses = 0;
+    if (evictions) *evictions = 0;
+    return;
   }
-  DEBUG_MSG_FUNC (SHAPE_PLAN, shape_plan, "inserted into cache");
 
-  return hb_shape_plan_reference (shape_plan);
+  face->shape_plans.get_stats (count, hits, misses, evictions);
+}
+
+
+/*
+ * Serialization
+ */
+
+#define HB_SHAPE_PLAN_SERIALIZED_MAGIC HB_TAG ('h','b','s','p')
+#define HB_SHAPE_PLAN_SERIALIZED_VERSION 1u
+
+static void
+push_string (hb_vector_t<uint32_t> &out, const char *str)
+{
+  unsigned int len = str ? strlen (str) : 0;
+  out.push (len);
+  unsigned int start = out.length;
+  out.resize (start + (len + 3) / 4);
+  if (likely (!out.in_error ()))
+  {
+    memset (&out[start], 0, (len + 3) / 4 * 4);
+    memcpy (&out[start], str, len);
+  }
+}
+
+static bool
+read_words (hb_array_t<const uint32_t> &data, unsigned int count, const uint32_t **words)
+{
+  if (unlikely (count > data.length)) return false;
+  *words = data.arrayZ;
+  data += count;
+  return true;
+}
+
+static bool
+read_string (hb_array_t<const uint32_t> &data, const char **str, unsigned int *len)
+{
+  const uint32_t *w;
+  if (unlikely (!read_words (data, 1, &w))) return false;
+  *len = w[0];
+  if (unlikely (*len > data.length * 4 ||
+		!read_words (data, (*len + 3) / 4, &w))) return false;
+  *str = (const char *) w;
+  return true;
+}
+
+/**
+ * hb_shape_plan_serialize:
+ * @shape_plan: a shape plan.
+ *
+ * Saves what creating @shape_plan computed about the OpenType features and
+ * lookups to apply, along with the key it was created for, such that
+ * hb_shape_plan_create_cached_from_blob() can recreate it for the same face
+ * without redoing that work; for example, in another process.
+ *
+ * The blob is tied to the GSUB and GPOS tables of the face @shape_plan was
+ * created for, and is only readable on machines of the same endianness.
+ * The face must still be alive.
+ *
+ * Return value: (transfer full): The serialized plan, or the empty blob if
+ * @shape_plan is the empty plan or allocation fails.
+ *
+ * Since: REPLACEME
+ **/
+hb_blob_t *
+hb_shape_plan_serialize (hb_shape_plan_t *shape_plan)
+{
+  if (unlikely (hb_object_is_inert (shape_plan)))
+    return hb_blob_get_empty ();
+
+  const hb_shape_plan_key_t &key = shape_plan->key;
+  hb_vector_t<uint32_t> out;
+
+  out.push (HB_SHAPE_PLAN_SERIALIZED_MAGIC);
+  out.push (HB_SHAPE_PLAN_SERIALIZED_VERSION);
+  out.push (shape_plan->face_unsafe->get_layout_checksum ());
+  out.push (key.props.direction);
+  out.push (key.props.script);
+  push_string (out, hb_language_to_string (key.props.language));
+  push_string (out, key.shaper_name);
+  out.push (key.num_user_features);
+  for (unsigned int i = 0; i < key.num_user_features; i++)
+  {
+    out.push (key.user_features[i].tag);
+    out.push (key.user_features[i].value);
+    out.push (key.user_features[i].start);
+    out.push (key.user_features[i].end);
+  }
+  out.push (key.ot.variations_index[0]);
+  out.push (key.ot.variations_index[1]);
+
+  if (unlikely (!shape_plan->ot.map.serialize (out)))
+  {
+    out.fini ();
+    return hb_blob_get_empty ();
+  }
+
+  unsigned int size = out.length * sizeof (out[0]);
+  void *data = malloc (size);
+  if (unlikely (!data))
+  {
+    out.fini ();
+    return hb_blob_get_empty ();
+  }
+  memcpy (data, out.arrayZ (), size);
+  out.fini ();
+
+  return hb_blob_create ((const char *) data, size,
+			 HB_MEMORY_MODE_WRITABLE,
+			 data, free);
+}
+
+/**
+ * hb_shape_plan_create_cached_from_blob:
+ * @face: a face.
+ * @blob: a blob returned by hb_shape_plan_serialize().
+ *
+ * Recreates the shape plan serialized into @blob for @face, skipping the
+ * OpenType feature and lookup selection, and adds it to the shape-plan
+ * cache of @face such that shaping with the same parameters uses it.  If
+ * a plan for those parameters is cached already, that one is returned.
+ *
+ * Fails if @blob was not serialized from a plan for a face with the same
+ * GSUB and GPOS tables, or is otherwise unusable.
+ *
+ * Return value: (transfer full): The shape plan, or the empty plan on
+ * failure.
+ *
+ * Since: REPLACEME
+ **/
+hb_shape_plan_t *
+hb_shape_plan_create_cached_from_blob (hb_face_t *face,
+				       hb_blob_t *blob)
+{
+  if (unlikely (hb_object_is_inert (face) ||
+		(uintptr_t) blob->data % alignof (uint32_t)))
+    return hb_shape_plan_get_empty ();
+
+  hb_array_t<const uint32_t> data ((const uint32_t *) blob->data,
+				   blob->length / sizeof (uint32_t));
+  const uint32_t *w;
+  if (unlikely (!read_words (data, 5, &w) ||
+		w[0] != HB_SHAPE_PLAN_SERIALIZED_MAGIC ||
+		w[1] != HB_SHAPE_PLAN_SERIALIZED_VERSION ||
+		w[2] != face->get_layout_checksum ()))
+    return hb_shape_plan_get_empty ();
+
+  hb_segment_properties_t props = HB_SEGMENT_PROPERTIES_DEFAULT;
+  props.direction = (hb_direction_t) w[3];
+  props.script = (hb_script_t) w[4];
+  if (unlikely (!HB_DIRECTION_IS_VALID (props.direction)))
+    return hb_shape_plan_get_empty ();
+
+  const char *str;
+  unsigned int len;
+  if (unlikely (!read_string (data, &str, &len)))
+    return hb_shape_plan_get_empty ();
+  props.language = len ? hb_language_from_string (str, len) : HB_LANGUAGE_INVALID;
+
+  char shaper_name[32];
+  if (unlikely (!read_string (data, &str, &len) || len >= sizeof (shaper_name)))
+    return hb_shape_plan_get_empty ();
+  memcpy (shaper_name, str, len);
+  shaper_name[len] = '\0';
+  const char * const shaper_list[] = {shaper_name, nullptr};
+
+  if (unlikely (!read_words (data, 1, &w) || w[0] > data.length / 4))
+    return hb_shape_plan_get_empty ();
+  unsigned int num_user_features = w[0];
+  hb_vector_t<hb_feature_t> user_features;
+  user_features.resize (num_user_features);
+  if (unlikely (user_features.in_error ()))
+    return hb_shape_plan_get_empty ();
+  read_words (data, 4 * num_user_features, &w);
+  for (unsigned int i = 0; i < num_user_features; i++)
+  {
+    user_features[i].tag = w[4 * i + 0];
+    user_features[i].value = w[4 * i + 1];
+    user_features[i].start = w[4 * i + 2];
+    user_features[i].end = w[4 * i + 3];
+  }
+
+  hb_ot_shape_plan_key_t ot_key;
+  if (unlikely (!read_words (data, 2, &w)))
+  {
+    user_features.fini ();
+    return hb_shape_plan_get_empty ();
+  }
+  ot_key.variations_index[0] = w[0];
+  ot_key.variations_index[1] = w[1];
+
+  hb_shape_plan_key_t key;
+  if (unlikely (!key.init (false,
+			   face,
+			   &props,
+			   user_features.arrayZ (),
+			   num_user_features,
+			   nullptr, 0,
+			   shaper_list)))
+  {
+    user_features.fini ();
+    return hb_shape_plan_get_empty ();
+  }
+  key.ot = ot_key;
+
+  uint32_t hash = key.hash ();
+  hb_shape_plan_t *shape_plan = face->shape_plans.lookup (&key, hash);
+  if (!shape_plan)
+  {
+    shape_plan = _hb_shape_plan_create (face, &props,
+					user_features.arrayZ (), num_user_features,
+					nullptr, 0,
+					shaper_list,
+					&ot_key, hb_addressof (data));
+    if (likely (!hb_object_is_inert (shape_plan)))
+      shape_plan = face->shape_plans.insert (shape_plan, hash);
+  }
+  DEBUG_MSG_FUNC (SHAPE_PLAN, shape_plan, "created from blob");
+
+  user_features.fini ();
+  return shape_plan;
 }
@@ -103,6 +103,29 @@ HB_EXTERN const char *
 hb_shape_plan_get_shaper (hb_shape_plan_t *shape_plan);
 
 
+HB_EXTERN hb_blob_t *
+hb_shape_plan_serialize (hb_shape_plan_t *shape_plan);
+
+HB_EXTERN hb_shape_plan_t *
+hb_shape_plan_create_cached_from_blob (hb_face_t *face,
+				       hb_blob_t *blob);
+
+
+HB_EXTERN void
+hb_shape_plan_cache_set_capacity (hb_face_t    *face,
+				  unsigned int  capacity);
+
+HB_EXTERN unsigned int
+hb_shape_plan_cache_get_capacity (hb_face_t *face);
+
+HB_EXTERN void
+hb_shape_plan_cache_get_stats (hb_face_t    *face,
+			       unsigned int *count,    /* OUT */
+			       unsigned int *hits,     /* OUT */
+			       unsigned int *misses,   /* OUT */
+			       unsigned int *evictions /* OUT */);
+
+
 HB_END_DECLS
 
 #endif /* HB_SHAPE_PLAN_H */
@@ -58,6 +58,8 @@ struct hb_shape_plan_key_t
   HB_INTERNAL bool user_features_match (const hb_shape_plan_key_t *other);
 
   HB_INTERNAL bool equal (const hb_shape_plan_key_t *other);
+
+  HB_INTERNAL uint32_t hash () const;
 };
 
 struct hb_shape_plan_t
@@ -67,6 +69,79 @@ struct hb_shape_plan_t
   hb_shape_plan_key_t key;
   hb_ot_shape_plan_t ot;
 };
+DECLARE_NULL_INSTANCE (hb_shape_plan_t);
+
+
+/*
+ * hb_shape_plan_cache_t
+ *
+ * Bounded per-face cache of shape plans.  Plans are hashed by their key
+ * and kept on an LRU list; when the cache is full, the least-recently-used
+ * plan is dropped.  Plans handed out to clients stay alive through their
+ * own reference even if evicted.
+ */
+
+#ifndef HB_SHAPE_PLAN_CACHE_DEFAULT_CAPACITY
+#define HB_SHAPE_PLAN_CACHE_DEFAULT_CAPACITY 128
+#endif
+
+struct hb_shape_plan_cache_t
+{
+  struct node_t
+  {
+    hb_shape_plan_t *shape_plan;
+    uint32_t hash;
+    node_t *next_in_bucket;
+    node_t *prev; /* Towards most-recently-used. */
+    node_t *next; /* Towards least-recently-used. */
+  };
+
+  HB_INTERNAL void init ();
+  HB_INTERNAL void fini ();
+
+  /* Returns a new reference to a cached plan matching key, or nullptr. */
+  HB_INTERNAL hb_shape_plan_t *lookup (const hb_shape_plan_key_t *key,
+				       uint32_t hash);
+  /* Takes over the reference to shape_plan.  Returns a new reference to
+   * the plan that ended up in the cache, which might be a plan another
+   * thread inserted meanwhile. */
+  HB_INTERNAL hb_shape_plan_t *insert (hb_shape_plan_t *shape_plan,
+				       uint32_t hash);
+
+  /* Drops all plans; the capacity and statistics stay. */
+  HB_INTERNAL void clear ();
+
+  HB_INTERNAL void set_capacity (unsigned int new_capacity);
+  unsigned int get_capacity () const { return capacity; }
+
+  HB_INTERNAL void get_stats (unsigned int *count,
+			      unsigned int *hits,
+			      unsigned int *misses,
+			      unsigned int *evictions);
+
+  /* Cached plans and the cache's own nodes; shaper data isn't counted. */
+  HB_INTERNAL void add_memory_usage (hb_memory_usage_t *usage);
+
+  private:
+  node_t *find (const hb_shape_plan_key_t *key, uint32_t hash) const;
+  void promote (node_t *node);
+  void unlink (node_t *node);
+  void evict_to (unsigned int max_count);
+  void destroy_nodes ();
+  bool resize_buckets (unsigned int new_capacity);
+
+  hb_mutex_t lock;
+  node_t **buckets;
+  unsigned int bucket_mask;
+  node_t *head;
+  node_t *tail;
+  unsigned int count;
+  unsigned int capacity;
+
+  unsigned int hits;
+  unsigned int misses;
+  unsigned int evictions;
+};
 
 
 #endif /* HB_SHAPE_PLAN_HH */
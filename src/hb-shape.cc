@@ -93,7 +93,8 @@ void free_static_shaper_list ()
 /**
  * hb_shape_list_shapers:
  *
- * Retrieves the list of shapers supported by HarfBuzz.
+ * Retrieves the list of shapers supported by HarfBuzz, in the order they
+ * are tried when no shaper list is given.
  *
  * Return value: (transfer none) (array zero-terminated=1): an array of
  *    constant strings
@@ -103,9 +104,556 @@ void free_static_shaper_list ()
 const char **
 hb_shape_list_shapers ()
 {
+  const char **pinned = _hb_shapers_get_pinned_list ();
+  if (pinned)
+    return pinned;
   return static_shaper_list.get_unconst ();
 }
 
+/**
+ * hb_shape_set_shaper_list:
+ * @shaper_list: (array zero-terminated=1) (allow-none): a %NULL-terminated
+ *    array of shapers to prefer, or %NULL
+ *
+ * Sets the order shapers are tried in when hb_shape_full() and friends are
+ * not given a shaper list, overriding the `HB_SHAPER_LIST` environment
+ * variable.  Shapers in @shaper_list come first, in the given order, and
+ * the rest follow in their default order; unknown names are ignored.  If
+ * @shaper_list is %NULL, the order from `HB_SHAPER_LIST` is used again.
+ *
+ * Setting the order before shaping anything saves reading the
+ * environment.  Shape plans created afterwards follow the new order.
+ *
+ * Return value: false if memory allocation failed, true otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_set_shaper_list (const char * const *shaper_list)
+{
+  return _hb_shapers_pin (shaper_list);
+}
+
+
+/*
+ * hb_shape_cache_t
+ *
+ * Optional per-font cache of shaped output, for clients that shape the
+ * same words over and over (relayout, editing, resizing).  Entries are
+ * keyed on the shape plan, the serials of the font and its parents, the
+ * buffer settings and user features, the text with its clusters relative
+ * to the first one, and the pre- and post-context.  Everything a hit
+ * returns, including the HB_GLYPH_FLAG_UNSAFE_TO_BREAK flags, is what
+ * shaping that buffer produced; clients pick word boundaries that are safe
+ * to break at and shape (and thus cache) each word on its own.
+ *
+ * The context takes part in the key: the flags alone don't tell whether
+ * a word shapes the same next to different text, as Arabic joining looks
+ * at the context without marking anything.
+ *
+ * Font funcs are assumed to return the same for the same font serial.
+ */
+
+#ifndef HB_SHAPE_CACHE_MAX_LENGTH
+#define HB_SHAPE_CACHE_MAX_LENGTH 32
+#endif
+#ifndef HB_SHAPE_CACHE_MAX_FEATURES
+#define HB_SHAPE_CACHE_MAX_FEATURES 16
+#endif
+#ifndef HB_SHAPE_CACHE_MAX_FONT_DEPTH
+#define HB_SHAPE_CACHE_MAX_FONT_DEPTH 4
+#endif
+
+#define HB_SHAPE_CACHE_MAX_KEY_LENGTH \
+	(1 + HB_SHAPE_CACHE_MAX_FONT_DEPTH + \
+	 4 + \
+	 1 + 4 * HB_SHAPE_CACHE_MAX_FEATURES + \
+	 2 * (1 + hb_buffer_t::CONTEXT_LENGTH) + \
+	 1 + 2 * HB_SHAPE_CACHE_MAX_LENGTH)
+
+struct hb_shape_cache_t
+{
+  struct node_t
+  {
+    hb_shape_plan_t *shape_plan;
+    uint32_t hash;
+    unsigned int key_len;
+    unsigned int len;
+    node_t *next_in_bucket;
+    node_t *prev; /* Towards most-recently-used. */
+    node_t *next; /* Towards least-recently-used. */
+
+    /* Followed by key_len words of key, then len glyph infos, their
+     * cluster relative to the first input cluster, and len positions. */
+    uint32_t *key () { return (uint32_t *) (this + 1); }
+    hb_glyph_info_t *info () { return (hb_glyph_info_t *) (key () + key_len); }
+    hb_glyph_position_t *pos () { return (hb_glyph_position_t *) (info () + len); }
+
+    static unsigned int get_size (unsigned int key_len, unsigned int len)
+    {
+      return sizeof (node_t) + key_len * sizeof (uint32_t) +
+	     len * (sizeof (hb_glyph_info_t) + sizeof (hb_glyph_position_t));
+    }
+    unsigned int get_size () const { return get_size (key_len, len); }
+  };
+
+  struct key_t
+  {
+    uint32_t words[HB_SHAPE_CACHE_MAX_KEY_LENGTH];
+    unsigned int len;
+    uint32_t hash;
+    uint32_t base_cluster;
+
+    /* Returns false if the buffer shouldn't be cached. */
+    bool init (hb_shape_plan_t    *shape_plan,
+	       hb_font_t          *font,
+	       hb_buffer_t        *buffer,
+	       const hb_feature_t *features,
+	       unsigned int        num_features)
+    {
+      if (buffer->content_type != HB_BUFFER_CONTENT_TYPE_UNICODE ||
+	  !buffer->len || buffer->len > HB_SHAPE_CACHE_MAX_LENGTH ||
+	  num_features > HB_SHAPE_CACHE_MAX_FEATURES ||
+	  buffer->message_func)
+	return false;
+
+      unsigned int n = 0;
+
+      unsigned int depth = 0;
+      n++;
+      for (hb_font_t *f = font; !hb_object_is_inert (f); f = f->parent)
+      {
+	if (unlikely (depth == HB_SHAPE_CACHE_MAX_FONT_DEPTH))
+	  return false;
+	words[n++] = f->serial;
+	depth++;
+      }
+      words[0] = depth;
+
+      words[n++] = buffer->flags;
+      words[n++] = buffer->cluster_level;
+      words[n++] = buffer->replacement;
+      words[n++] = buffer->invisible;
+
+      words[n++] = num_features;
+      for (unsigned int i = 0; i < num_features; i++)
+      {
+	words[n++] = features[i].tag;
+	words[n++] = features[i].value;
+	words[n++] = features[i].start;
+	words[n++] = features[i].end;
+      }
+
+      for (unsigned int side = 0; side < 2; side++)
+      {
+	words[n++] = buffer->context_len[side];
+	for (unsigned int i = 0; i < buffer->context_len[side]; i++)
+	  words[n++] = buffer->context[side][i];
+      }
+
+      const hb_glyph_info_t *info = buffer->info;
+      base_cluster = info[0].cluster;
+      words[n++] = buffer->len;
+      for (unsigned int i = 0; i < buffer->len; i++)
+      {
+	words[n++] = info[i].codepoint;
+	words[n++] = info[i].cluster - base_cluster;
+      }
+
+      len = n;
+      hash = hb_hash ((uintptr_t) shape_plan);
+      for (unsigned int i = 0; i < n; i++)
+	hash = hash * 31 + words[i];
+      return true;
+    }
+  };
+
+  void init ()
+  {
+    lock.init ();
+    buckets = nullptr;
+    bucket_mask = 0;
+    head = tail = nullptr;
+    count = 0;
+    capacity = 0;
+    memory = 0;
+    hits = misses = evictions = 0;
+  }
+
+  void fini ()
+  {
+    for (node_t *node = head; node; )
+    {
+      node_t *next = node->next;
+      hb_shape_plan_destroy (node->shape_plan);
+      free (node);
+      node = next;
+    }
+    free (buckets);
+    buckets = nullptr;
+    head = tail = nullptr;
+    count = 0;
+    lock.fini ();
+  }
+
+  /* Fills buffer with the cached output for key, if any. */
+  bool lookup (hb_shape_plan_t *shape_plan,
+	       const key_t     &key,
+	       hb_buffer_t     *buffer)
+  {
+    hb_lock_t l (lock);
+
+    node_t *node = find (shape_plan, key);
+    if (!node || unlikely (!buffer->ensure (node->len)))
+    {
+      misses++;
+      return false;
+    }
+
+    hits++;
+    promote (node);
+
+    unsigned int len = node->len;
+    hb_glyph_info_t *info = buffer->info;
+    memcpy (info, node->info (), len * sizeof (info[0]));
+    memcpy (buffer->pos, node->pos (), len * sizeof (buffer->pos[0]));
+    for (unsigned int i = 0; i < len; i++)
+      info[i].cluster += key.base_cluster;
+
+    buffer->len = len;
+    buffer->idx = 0;
+    buffer->have_output = false;
+    buffer->out_len = 0;
+    buffer->have_positions = true;
+    return true;
+  }
+
+  /* Remembers the output the buffer was just shaped to. */
+  void insert (hb_shape_plan_t *shape_plan,
+	       const key_t     &key,
+	       hb_buffer_t     *buffer)
+  {
+    unsigned int len = buffer->len;
+    if (unlikely (!len || !buffer->have_positions))
+      return;
+
+    hb_lock_t l (lock);
+
+    /* Another thread might have beaten us to it. */
+    if (find (shape_plan, key))
+      return;
+
+    if (unlikely (!capacity || !resize_buckets (capacity)))
+      return;
+
+    node_t *node = (node_t *) malloc (node_t::get_size (key.len, len));
+    if (unlikely (!node))
+      return;
+
+    evict_to (capacity - 1);
+
+    node->shape_plan = hb_shape_plan_reference (shape_plan);
+    node->hash = key.hash;
+    node->key_len = key.len;
+    node->len = len;
+    memcpy (node->key (), key.words, key.len * sizeof (key.words[0]));
+    hb_glyph_info_t *info = node->info ();
+    memcpy (info, buffer->info, len * sizeof (info[0]));
+    memcpy (node->pos (), buffer->pos, len * sizeof (buffer->pos[0]));
+    for (unsigned int i = 0; i < len; i++)
+      info[i].cluster -= key.base_cluster;
+
+    node->next_in_bucket = buckets[key.hash & bucket_mask];
+    buckets[key.hash & bucket_mask] = node;
+    node->prev = nullptr;
+    node->next = head;
+    if (head)
+      head->prev = node;
+    else
+      tail = node;
+    head = node;
+    count++;
+    memory += node->get_size ();
+  }
+
+  void set_capacity (unsigned int new_capacity)
+  {
+    hb_lock_t l (lock);
+
+    capacity = new_capacity;
+    evict_to (capacity);
+    if (buckets && capacity)
+      resize_buckets (capacity);
+  }
+
+  unsigned int get_capacity () const { return capacity; }
+
+  void get_stats (unsigned int *count_,
+		  unsigned int *hits_,
+		  unsigned int *misses_,
+		  unsigned int *evictions_)
+  {
+    hb_lock_t l (lock);
+
+    if (count_) *count_ = count;
+    if (hits_) *hits_ = hits;
+    if (misses_) *misses_ = misses;
+    if (evictions_) *evictions_ = evictions;
+  }
+
+  unsigned int get_memory_usage ()
+  {
+    hb_lock_t l (lock);
+
+    return sizeof (*this) + (buckets ? (bucket_mask + 1) * sizeof (node_t *) : 0) + memory;
+  }
+
+  private:
+  node_t *find (hb_shape_plan_t *shape_plan, const key_t &key) const
+  {
+    if (unlikely (!buckets)) return nullptr;
+    for (node_t *node = buckets[key.hash & bucket_mask]; node; node = node->next_in_bucket)
+      if (node->hash == key.hash &&
+	  node->shape_plan == shape_plan &&
+	  node->key_len == key.len &&
+	  0 == memcmp (node->key (), key.words, key.len * sizeof (key.words[0])))
+	return node;
+    return nullptr;
+  }
+
+  void promote (node_t *node)
+  {
+    if (node == head) return;
+
+    /* Detach from LRU list... */
+    node->prev->next = node->next;
+    if (node->next)
+      node->next->prev = node->prev;
+    else
+      tail = node->prev;
+
+    /* ...and put it in front. */
+    node->prev = nullptr;
+    node->next = head;
+    head->prev = node;
+    head = node;
+  }
+
+  void unlink (node_t *node)
+  {
+    if (node->prev)
+      node->prev->next = node->next;
+    else
+      head = node->next;
+    if (node->next)
+      node->next->prev = node->prev;
+    else
+      tail = node->prev;
+
+    node_t **p = &buckets[node->hash & bucket_mask];
+    while (*p != node)
+      p = &(*p)->next_in_bucket;
+    *p = node->next_in_bucket;
+
+    count--;
+    memory -= node->get_size ();
+  }
+
+  void evict_to (unsigned int max_count)
+  {
+    while (count > max_count)
+    {
+      node_t *node = tail;
+      unlink (node);
+      hb_shape_plan_destroy (node->shape_plan);
+      free (node);
+      evictions++;
+    }
+  }
+
+  bool resize_buckets (unsigned int new_capacity)
+  {
+    /* Keep load factor at or below one. */
+    unsigned int new_size = 1u << hb_bit_storage (hb_min (hb_max (new_capacity, 8u), 65536u) - 1);
+    if (buckets && new_size == bucket_mask + 1)
+      return true;
+
+    node_t **new_buckets = (node_t **) calloc (new_size, sizeof (node_t *));
+    if (unlikely (!new_buckets))
+      return buckets != nullptr;
+
+    for (node_t *node = head; node; node = node->next)
+    {
+      unsigned int i = node->hash & (new_size - 1);
+      node->next_in_bucket = new_buckets[i];
+      new_buckets[i] = node;
+    }
+
+    free (buckets);
+    buckets = new_buckets;
+    bucket_mask = new_size - 1;
+    return true;
+  }
+
+  hb_mutex_t lock;
+  node_t **buckets;
+  unsigned int bucket_mask;
+  node_t *head;
+  node_t *tail;
+  unsigned int count;
+  unsigned int capacity;
+  unsigned int memory; /* Bytes of nodes. */
+
+  unsigned int hits;
+  unsigned int misses;
+  unsigned int evictions;
+};
+
+void
+_hb_shape_cache_destroy (hb_shape_cache_t *cache)
+{
+  if (!cache) return;
+  cache->fini ();
+  free (cache);
+}
+
+unsigned int
+_hb_shape_cache_get_memory_usage (hb_shape_cache_t *cache)
+{
+  return cache ? cache->get_memory_usage () : 0;
+}
+
+/* Executes shape_plan on buffer, going through the shape cache of font if
+ * it has one. */
+static hb_bool_t
+_hb_shape_plan_execute_cached (hb_shape_plan_t    *shape_plan,
+			       hb_font_t          *font,
+			       hb_buffer_t        *buffer,
+			       const hb_feature_t *features,
+			       unsigned int        num_features)
+{
+  hb_shape_cache_t *cache = font->shape_cache.get ();
+  hb_shape_cache_t::key_t key;
+  bool cacheable = cache && key.init (shape_plan, font, buffer, features, num_features);
+
+  hb_bool_t res;
+  buffer->max_ops_exhausted = false;
+  if (cacheable && cache->lookup (shape_plan, key, buffer))
+    res = true;
+  else
+  {
+    res = hb_shape_plan_execute (shape_plan, font, buffer, features, num_features);
+    if (res && cacheable && !buffer->max_ops_exhausted)
+      cache->insert (shape_plan, key, buffer);
+  }
+
+  if (res)
+    buffer->content_type = HB_BUFFER_CONTENT_TYPE_GLYPHS;
+  return res;
+}
+
+/**
+ * hb_shape_cache_set_capacity:
+ * @font: a font.
+ * @capacity: maximum number of shaped buffers to keep cached for @font.
+ *
+ * Enables caching the output of hb_shape_full() and friends on @font, for
+ * clients that shape the same words repeatedly.  Buffers of up to 32
+ * characters are cached, keyed on everything that affects their shaping:
+ * shape plan, font settings, buffer flags, features, text and context.
+ * Clusters are cached relative to the cluster of the first character, so
+ * the same word at a different offset still hits.  Clients would
+ * typically split text at positions where HB_GLYPH_FLAG_UNSAFE_TO_BREAK
+ * is not set and shape each piece on its own.
+ *
+ * When the cache is full, the least-recently-used output is evicted.
+ * Setting @capacity to zero, the default, disables caching and drops all
+ * currently cached output.  The cache assumes that the font functions of
+ * @font return the same results as long as the font itself is not
+ * modified.
+ *
+ * Unlike most font setters, this can be called after @font is made
+ * immutable.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_shape_cache_set_capacity (hb_font_t    *font,
+			     unsigned int  capacity)
+{
+  if (unlikely (hb_object_is_inert (font)))
+    return;
+
+retry:
+  hb_shape_cache_t *cache = font->shape_cache.get ();
+  if (!cache)
+  {
+    if (!capacity)
+      return;
+    cache = (hb_shape_cache_t *) calloc (1, sizeof (hb_shape_cache_t));
+    if (unlikely (!cache))
+      return;
+    cache->init ();
+    if (unlikely (!font->shape_cache.cmpexch (nullptr, cache)))
+    {
+      _hb_shape_cache_destroy (cache);
+      goto retry;
+    }
+  }
+
+  cache->set_capacity (capacity);
+}
+
+/**
+ * hb_shape_cache_get_capacity:
+ * @font: a font.
+ *
+ * Return value: maximum number of shaped buffers cached for @font.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_shape_cache_get_capacity (hb_font_t *font)
+{
+  hb_shape_cache_t *cache = font->shape_cache.get ();
+  return cache ? cache->get_capacity () : 0;
+}
+
+/**
+ * hb_shape_cache_get_stats:
+ * @font: a font.
+ * @count: (out) (optional): number of shaped buffers currently cached.
+ * @hits: (out) (optional): number of buffers filled from the cache.
+ * @misses: (out) (optional): number of cacheable buffers that had to be
+ *   shaped.
+ * @evictions: (out) (optional): number of entries dropped to honor
+ *   capacity.
+ *
+ * Fetches statistics of the shape cache of @font, useful for sizing it
+ * with hb_shape_cache_set_capacity().
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_shape_cache_get_stats (hb_font_t    *font,
+			  unsigned int *count,    /* OUT */
+			  unsigned int *hits,     /* OUT */
+			  unsigned int *misses,   /* OUT */
+			  unsigned int *evictions /* OUT */)
+{
+  hb_shape_cache_t *cache = font->shape_cache.get ();
+  if (cache)
+  {
+    cache->get_stats (count, hits, misses, evictions);
+    return;
+  }
+
+  if (count) *count = 0;
+  if (hits) *hits = 0;
+  if (misses) *misses = 0;
+  if (evictions) *evictions = 0;
+}
+
 
 /**
  * hb_shape_full:
@@ -121,7 +669,8 @@ hb_shape_list_shapers ()
  * shapers will be used in the given order, otherwise the default shapers list
  * will be used.
  *
- * Return value: false if all shapers failed, true otherwise
+ * Return value: false if all shapers failed or the operation budget set
+ * with hb_buffer_set_max_ops() ran out, true otherwise
  *
  * Since: 0.9.2
  **/
@@ -136,12 +685,9 @@ hb_shape_full (hb_font_t          *font,
 							      features, num_features,
 							      font->coords, font->num_coords,
 							      shaper_list);
-  hb_bool_t res = hb_shape_plan_execute (shape_plan, font, buffer, features, num_features);
+  hb_bool_t res = _hb_shape_plan_execute_cached (shape_plan, font, buffer, features, num_features);
   hb_shape_plan_destroy (shape_plan);
-
-  if (res)
-    buffer->content_type = HB_BUFFER_CONTENT_TYPE_GLYPHS;
-  return res;
+  return res && !buffer->max_ops_exhausted;
 }
 
 /**
@@ -166,3 +712,314 @@ hb_shape (hb_font_t           *font,
 {
   hb_shape_full (font, buffer, features, num_features, nullptr);
 }
+
+
+/* Whether a plan made for @prev can be used to shape @run as well. */
+static bool
+_hb_shape_run_plan_matches (const hb_shape_run_t *prev,
+			    const hb_shape_run_t *run)
+{
+  hb_font_t *font = run->font;
+  return font->face == prev->font->face &&
+	 hb_segment_properties_equal (&run->buffer->props, &prev->buffer->props) &&
+	 run->num_features == prev->num_features &&
+	 (run->features == prev->features ||
+	  0 == memcmp (run->features, prev->features,
+		       run->num_features * sizeof (run->features[0]))) &&
+	 font->num_coords == prev->font->num_coords &&
+	 (font->coords == prev->font->coords ||
+	  0 == memcmp (font->coords, prev->font->coords,
+		       font->num_coords * sizeof (font->coords[0])));
+}
+
+/**
+ * hb_shape_batch:
+ * @runs: (array length=num_runs): an array of runs to shape
+ * @num_runs: the length of @runs array
+ * @shaper_list: (array zero-terminated=1) (allow-none): a %NULL-terminated
+ *    array of shapers to use or %NULL
+ *
+ * Shapes each run in @runs, as if by calling hb_shape_full() on it.  This is
+ * meant for a paragraph that has been itemized into many runs: when a run
+ * has the same face, segment properties, features and variation coordinates
+ * as the one before it, the shape plan of that run is reused without
+ * looking it up again.  Ordering runs so that similar ones are adjacent
+ * makes this more effective.
+ *
+ * Runs are shaped independently of each other, so callers that want to
+ * shape in parallel can split @runs among threads, as long as no buffer
+ * appears twice.
+ *
+ * Return value: false if all shapers failed for any of the runs, or its
+ * operation budget ran out, true otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_batch (const hb_shape_run_t *runs,
+		unsigned int          num_runs,
+		const char * const   *shaper_list)
+{
+  hb_bool_t ret = true;
+  hb_shape_plan_t *shape_plan = nullptr;
+  for (unsigned int i = 0; i < num_runs; i++)
+  {
+    const hb_shape_run_t *run = &runs[i];
+    hb_font_t *font = run->font;
+    hb_buffer_t *buffer = run->buffer;
+
+    if (!shape_plan || !_hb_shape_run_plan_matches (&runs[i - 1], run))
+    {
+      hb_shape_plan_destroy (shape_plan);
+      shape_plan = hb_shape_plan_create_cached2 (font->face, &buffer->props,
+						 run->features, run->num_features,
+						 font->coords, font->num_coords,
+						 shaper_list);
+    }
+
+    if (!_hb_shape_plan_execute_cached (shape_plan, font, buffer,
+					run->features, run->num_features) ||
+	buffer->max_ops_exhausted)
+      ret = false;
+  }
+  hb_shape_plan_destroy (shape_plan);
+  return ret;
+}
+
+/* Runs per job of hb_shape_batch_parallel(); big enough for plan reuse
+ * within a job to pay off, small enough to spread a paragraph around. */
+#ifndef HB_SHAPE_BATCH_JOB_RUNS
+#define HB_SHAPE_BATCH_JOB_RUNS 8
+#endif
+
+struct hb_shape_batch_job_t
+{
+  const hb_shape_run_t *runs;
+  unsigned int num_runs;
+  const char * const *shaper_list;
+  hb_atomic_int_t failed;
+
+  static void run (unsigned int index, void *job_data)
+  {
+    hb_shape_batch_job_t *c = (hb_shape_batch_job_t *) job_data;
+    unsigned int start = index * HB_SHAPE_BATCH_JOB_RUNS;
+    unsigned int count = hb_min (c->num_runs - start, (unsigned) HB_SHAPE_BATCH_JOB_RUNS);
+    if (!hb_shape_batch (c->runs + start, count, c->shaper_list))
+      c->failed.set (1);
+  }
+};
+
+/**
+ * hb_shape_batch_parallel:
+ * @runs: (array length=num_runs): an array of runs to shape
+ * @num_runs: the length of @runs array
+ * @shaper_list: (array zero-terminated=1) (allow-none): a %NULL-terminated
+ *    array of shapers to use or %NULL
+ * @executor: (nullable): executor to shape on, or %NULL
+ * @user_data: data to pass to @executor
+ *
+ * Like hb_shape_batch(), but splits @runs into groups of consecutive runs
+ * and shapes each group as a separate job run through @executor, for
+ * example on a thread pool.  Runs may share fonts and faces; no buffer may
+ * appear twice.  With a %NULL @executor the groups are shaped one after
+ * the other on the calling thread.
+ *
+ * Return value: false if all shapers failed for any of the runs, true
+ * otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_batch_parallel (const hb_shape_run_t *runs,
+			 unsigned int          num_runs,
+			 const char * const   *shaper_list,
+			 hb_executor_func_t    executor,
+			 void                 *user_data)
+{
+  if (!num_runs)
+    return true;
+
+  hb_shape_batch_job_t c;
+  c.runs = runs;
+  c.num_runs = num_runs;
+  c.shaper_list = shaper_list;
+  c.failed.set_relaxed (0);
+
+  unsigned int count = (num_runs + HB_SHAPE_BATCH_JOB_RUNS - 1) / HB_SHAPE_BATCH_JOB_RUNS;
+  if (executor && count > 1)
+    executor (count, hb_shape_batch_job_t::run, &c, user_data);
+  else
+    for (unsigned int i = 0; i < count; i++)
+      hb_shape_batch_job_t::run (i, &c);
+
+  return !c.failed.get ();
+}
+
+
+/* First glyph, in logical order, whose cluster is at or after cluster. */
+static unsigned int
+_hb_shape_find_cluster (const hb_glyph_info_t *info,
+			unsigned int           len,
+			unsigned int           cluster)
+{
+  unsigned int lo = 0, hi = len;
+  while (lo < hi)
+  {
+    unsigned int mid = lo + (hi - lo) / 2;
+    if (info[mid].cluster < cluster) lo = mid + 1; else hi = mid;
+  }
+  return lo;
+}
+
+static bool
+_hb_shape_unsafe_to_break_before (const hb_glyph_info_t *info, unsigned int i)
+{
+  return info[i].cluster == info[i - 1].cluster ||
+	 (info[i].mask & HB_GLYPH_FLAG_UNSAFE_TO_BREAK);
+}
+
+/**
+ * hb_shape_reshape_range:
+ * @font: an #hb_font_t to use for shaping
+ * @buffer: a buffer previously shaped with @font, @features and the text
+ *    before the edit
+ * @text: a Unicode buffer holding the whole text after the edit
+ * @start: cluster where the edit starts
+ * @old_end: cluster where the edit ended in the text before the edit
+ * @new_end: cluster where the edit ends in @text
+ * @features: (array length=num_features) (allow-none): an array of user
+ *    specified #hb_feature_t or %NULL
+ * @num_features: the length of @features array
+ *
+ * Updates @buffer to the shaping output of @text after the text between
+ * clusters @start and @old_end was replaced with what is between @start
+ * and @new_end in @text.  Instead of shaping all of @text, only the edit
+ * and the text around it up to the nearest boundaries that are safe to
+ * break at, as marked by %HB_GLYPH_FLAG_UNSAFE_TO_BREAK, are reshaped and
+ * spliced into @buffer; clusters after the edit are shifted by
+ * @new_end - @old_end.  The result is the same as shaping @text with
+ * hb_shape_full().
+ *
+ * Clusters of @buffer and @text must grow monotonically in logical order,
+ * as they do when adding text with hb_buffer_add_utf8() and friends.  With
+ * %HB_BUFFER_CLUSTER_LEVEL_CHARACTERS they might not, and all of @text is
+ * reshaped.
+ *
+ * Return value: false if shaping failed, in which case @buffer is not
+ *    modified; true otherwise
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_shape_reshape_range (hb_font_t          *font,
+			hb_buffer_t        *buffer,
+			hb_buffer_t        *text,
+			unsigned int        start,
+			unsigned int        old_end,
+			unsigned int        new_end,
+			const hb_feature_t *features,
+			unsigned int        num_features)
+{
+  if (unlikely (buffer->content_type != HB_BUFFER_CONTENT_TYPE_GLYPHS ||
+		(buffer->len && !buffer->have_positions) ||
+		text->content_type != HB_BUFFER_CONTENT_TYPE_UNICODE ||
+		start > old_end || start > new_end ||
+		hb_object_is_immutable (buffer)))
+    return false;
+
+  bool backward = HB_DIRECTION_IS_BACKWARD (buffer->props.direction);
+  if (backward)
+    buffer->reverse ();
+
+  /* Find the glyphs to reshape: those of the edit, widened by one cluster
+   * on each side, as the clusters next to the edit see different context
+   * now; then on to the nearest boundaries safe to break at. */
+  const hb_glyph_info_t *info = buffer->info;
+  unsigned int len = buffer->len;
+  unsigned int glyph_start = 0, glyph_end = len;
+  if (text->cluster_level != HB_BUFFER_CLUSTER_LEVEL_CHARACTERS)
+  {
+    glyph_start = _hb_shape_find_cluster (info, len, start);
+    if (glyph_start)
+    {
+      glyph_start--;
+      while (glyph_start && _hb_shape_unsafe_to_break_before (info, glyph_start))
+	glyph_start--;
+    }
+
+    glyph_end = _hb_shape_find_cluster (info, len, old_end);
+    if (glyph_end < len)
+    {
+      glyph_end++;
+      while (glyph_end < len && _hb_shape_unsafe_to_break_before (info, glyph_end))
+	glyph_end++;
+    }
+  }
+
+  /* The same window in text. */
+  int delta = (int) new_end - (int) old_end;
+  const hb_glyph_info_t *text_info = text->info;
+  unsigned int text_len = text->len;
+  unsigned int text_start = glyph_start ? _hb_shape_find_cluster (text_info, text_len, info[glyph_start].cluster) : 0;
+  unsigned int text_end = glyph_end < len ? _hb_shape_find_cluster (text_info, text_len, info[glyph_end].cluster + delta) : text_len;
+  text_end = hb_max (text_start, text_end);
+
+  hb_buffer_t *window = hb_buffer_create ();
+  window->props = text->props;
+  window->flags = text->flags;
+  window->cluster_level = text->cluster_level;
+  window->replacement = text->replacement;
+  window->invisible = text->invisible;
+  if (text_start)
+    window->flags = (hb_buffer_flags_t) (window->flags & ~HB_BUFFER_FLAG_BOT);
+  if (text_end < text_len)
+    window->flags = (hb_buffer_flags_t) (window->flags & ~HB_BUFFER_FLAG_EOT);
+
+  /* Context comes from the text around the window, or the context of text
+   * at its ends. */
+  window->content_type = HB_BUFFER_CONTENT_TYPE_UNICODE;
+  for (unsigned int i = text_start; i && window->context_len[0] < hb_buffer_t::CONTEXT_LENGTH; i--)
+    window->context[0][window->context_len[0]++] = text_info[i - 1].codepoint;
+  for (unsigned int i = 0; i < text->context_len[0] && window->context_len[0] < hb_buffer_t::CONTEXT_LENGTH; i++)
+    window->context[0][window->context_len[0]++] = text->context[0][i];
+  for (unsigned int i = text_end; i < text_len && window->context_len[1] < hb_buffer_t::CONTEXT_LENGTH; i++)
+    window->context[1][window->context_len[1]++] = text_info[i].codepoint;
+  for (unsigned int i = 0; i < text->context_len[1] && window->context_len[1] < hb_buffer_t::CONTEXT_LENGTH; i++)
+    window->context[1][window->context_len[1]++] = text->context[1][i];
+
+  for (unsigned int i = text_start; i < text_end; i++)
+    window->add (text_info[i].codepoint, text_info[i].cluster);
+
+  bool ret = window->successful &&
+	     hb_shape_full (font, window, features, num_features, nullptr);
+
+  /* Splice the window in. */
+  unsigned int window_len = window->len;
+  unsigned int tail_len = len - glyph_end;
+  unsigned int new_len = glyph_start + window_len + tail_len;
+  if (ret)
+    ret = buffer->ensure (new_len);
+  if (ret)
+  {
+    if (backward)
+      window->reverse ();
+
+    hb_glyph_info_t *out_info = buffer->info;
+    hb_glyph_position_t *out_pos = buffer->pos;
+    memmove (out_info + glyph_start + window_len, out_info + glyph_end, tail_len * sizeof (out_info[0]));
+    memmove (out_pos + glyph_start + window_len, out_pos + glyph_end, tail_len * sizeof (out_pos[0]));
+    memcpy (out_info + glyph_start, window->info, window_len * sizeof (out_info[0]));
+    memcpy (out_pos + glyph_start, window->pos, window_len * sizeof (out_pos[0]));
+    for (unsigned int i = glyph_start + window_len; i < new_len; i++)
+      out_info[i].cluster += delta;
+    buffer->len = new_len;
+    buffer->have_positions = true;
+  }
+
+  hb_buffer_destroy (window);
+
+  if (backward)
+    buffer->reverse ();
+
+  return ret;
+}
@@ -56,6 +56,72 @@ hb_shape_full (hb_font_t          *font,
 HB_EXTERN const char **
 hb_shape_list_shapers (void);
 
+HB_EXTERN hb_bool_t
+hb_shape_set_shaper_list (const char * const *shaper_list);
+
+
+/**
+ * hb_shape_run_t:
+ * @font: the #hb_font_t to shape @buffer with
+ * @buffer: the #hb_buffer_t to shape
+ * @features: (array length=num_features) (allow-none): an array of user
+ *    specified #hb_feature_t or %NULL
+ * @num_features: the length of @features array
+ *
+ * One run of text for hb_shape_batch().
+ *
+ * Since: REPLACEME
+ */
+typedef struct hb_shape_run_t
+{
+  hb_font_t          *font;
+  hb_buffer_t        *buffer;
+  const hb_feature_t *features;
+  unsigned int        num_features;
+
+  /*< private >*/
+  void *reserved1;
+  void *reserved2;
+} hb_shape_run_t;
+
+HB_EXTERN hb_bool_t
+hb_shape_batch (const hb_shape_run_t *runs,
+		unsigned int          num_runs,
+		const char * const   *shaper_list);
+
+HB_EXTERN hb_bool_t
+hb_shape_batch_parallel (const hb_shape_run_t *runs,
+			 unsigned int          num_runs,
+			 const char * const   *shaper_list,
+			 hb_executor_func_t    executor,
+			 void                 *user_data);
+
+
+HB_EXTERN hb_bool_t
+hb_shape_reshape_range (hb_font_t          *font,
+			hb_buffer_t        *buffer,
+			hb_buffer_t        *text,
+			unsigned int        start,
+			unsigned int        old_end,
+			unsigned int        new_end,
+			const hb_feature_t *features,
+			unsigned int        num_features);
+
+
+HB_EXTERN void
+hb_shape_cache_set_capacity (hb_font_t    *font,
+			     unsigned int  capacity);
+
+HB_EXTERN unsigned int
+hb_shape_cache_get_capacity (hb_font_t *font);
+
+HB_EXTERN void
+hb_shape_cache_get_stats (hb_font_t    *font,
+			  unsigned int *count,    /* OUT */
+			  unsigned int *hits,     /* OUT */
+			  unsigned int *misses,   /* OUT */
+			  unsigned int *evictions /* OUT */);
+
 
 HB_END_DECLS
 
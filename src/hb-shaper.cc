@@ -39,6 +39,24 @@ static const hb_shaper_entry_t all_shapers[] = {
 static void free_static_shapers ();
 #endif
 
+/* Moves the shaper called name, if any, to position *i, past the shapers
+ * preferred so far. */
+static void
+prefer_shaper (hb_shaper_entry_t *shapers, unsigned int *i,
+	       const char *name, unsigned int len)
+{
+  for (unsigned int j = *i; j < ARRAY_LENGTH (all_shapers); j++)
+    if (len == strlen (shapers[j].name) &&
+	0 == strncmp (shapers[j].name, name, len))
+    {
+      /* Reorder this shaper to position i */
+      struct hb_shaper_entry_t t = shapers[j];
+      memmove (&shapers[*i + 1], &shapers[*i], sizeof (shapers[*i]) * (j - *i));
+      shapers[*i] = t;
+      (*i)++;
+    }
+}
+
 static struct hb_shapers_lazy_loader_t : hb_lazy_loader_t<const hb_shaper_entry_t,
 							  hb_shapers_lazy_loader_t>
 {
@@ -63,16 +81,7 @@ static struct hb_shapers_lazy_loader_t : hb_lazy_loader_t<const hb_shaper_entry_
       if (!end)
 	end = p + strlen (p);
 
-      for (unsigned int j = i; j < ARRAY_LENGTH (all_shapers); j++)
-	if (end - p == (int) strlen (shapers[j].name) &&
-	    0 == strncmp (shapers[j].name, p, end - p))
-	{
-	  /* Reorder this shaper to position i */
-	 struct hb_shaper_entry_t t = shapers[j];
-	 memmove (&shapers[i + 1], &shapers[i], sizeof (shapers[i]) * (j - i));
-	 shapers[i] = t;
-	 i++;
-	}
+      prefer_shaper (shapers, &i, p, end - p);
 
       if (!*end)
 	break;
@@ -98,8 +107,92 @@ void free_static_shapers ()
 }
 #endif
 
+
+/* Shaper orders set with hb_shape_set_shaper_list().  Replaced ones are
+ * kept until exit, as plans being created may still be reading them. */
+struct hb_pinned_shapers_t
+{
+  hb_pinned_shapers_t *prev;
+  hb_shaper_entry_t shapers[HB_SHAPERS_COUNT];
+  const char *list[HB_SHAPERS_COUNT + 1];
+};
+
+static hb_atomic_ptr_t<hb_pinned_shapers_t> pinned_shapers;
+static hb_atomic_int_t shapers_serial;
+
+#if HB_USE_ATEXIT
+static
+void free_pinned_shapers ()
+{
+  hb_pinned_shapers_t *p = pinned_shapers.get ();
+  pinned_shapers.set_relaxed (nullptr);
+  while (p)
+  {
+    hb_pinned_shapers_t *prev = p->prev;
+    free (p);
+    p = prev;
+  }
+}
+#endif
+
 const hb_shaper_entry_t *
 _hb_shapers_get ()
 {
+  hb_pinned_shapers_t *pinned = pinned_shapers.get ();
+  if (pinned)
+    return pinned->shapers;
   return static_shapers.get_unconst ();
 }
+
+const char **
+_hb_shapers_get_pinned_list ()
+{
+  hb_pinned_shapers_t *pinned = pinned_shapers.get ();
+  return pinned ? pinned->list : nullptr;
+}
+
+unsigned int
+_hb_shapers_get_serial ()
+{
+  return (unsigned int) shapers_serial.get ();
+}
+
+bool
+_hb_shapers_pin (const char * const *shaper_list)
+{
+  hb_pinned_shapers_t *pinned = (hb_pinned_shapers_t *) calloc (1, sizeof (hb_pinned_shapers_t));
+  if (unlikely (!pinned))
+    return false;
+
+  if (shaper_list)
+  {
+    memcpy (pinned->shapers, all_shapers, sizeof (all_shapers));
+    unsigned int i = 0;
+    for (; *shaper_list; shaper_list++)
+      prefer_shaper (pinned->shapers, &i, *shaper_list, strlen (*shaper_list));
+  }
+  else
+    memcpy (pinned->shapers, static_shapers.get (), sizeof (all_shapers));
+
+  for (unsigned int i = 0; i < HB_SHAPERS_COUNT; i++)
+    pinned->list[i] = pinned->shapers[i].name;
+  pinned->list[HB_SHAPERS_COUNT] = nullptr;
+
+  hb_pinned_shapers_t *prev;
+  do
+  {
+    prev = pinned_shapers.get ();
+    pinned->prev = prev;
+  }
+  while (!pinned_shapers.cmpexch (prev, pinned));
+
+#if HB_USE_ATEXIT
+  if (!prev)
+    atexit (free_pinned_shapers);
+#endif
+
+  /* After publishing, so that whoever sees the new serial sees the new
+   * order as well. */
+  shapers_serial.inc ();
+  return true;
+}
@@ -49,6 +49,18 @@ struct hb_shaper_entry_t {
 HB_INTERNAL const hb_shaper_entry_t *
 _hb_shapers_get ();
 
+/* The shaper names as set by _hb_shapers_pin(), or nullptr if never set. */
+HB_INTERNAL const char **
+_hb_shapers_get_pinned_list ();
+
+/* Changes every time _hb_shapers_pin() is called. */
+HB_INTERNAL unsigned int
+_hb_shapers_get_serial ();
+
+/* Makes shaper_list, or if nullptr the environment's order, the default. */
+HB_INTERNAL bool
+_hb_shapers_pin (const char * const *shaper_list);
+
 
 template <typename Data, unsigned int WheresData, typename T>
 struct hb_shaper_lazy_loader_t;
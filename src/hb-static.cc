@@ -73,4 +73,25 @@ hb_face_t::load_upem () const
   return ret;
 }
 
+unsigned int
+hb_face_t::load_layout_checksum () const
+{
+  static const hb_tag_t tags[] = {HB_OT_TAG_GSUB, HB_OT_TAG_GPOS};
+  uint32_t h = 2166136261u;
+  for (unsigned int i = 0; i < ARRAY_LENGTH (tags); i++)
+  {
+    hb_blob_t *blob = reference_table (tags[i]);
+    const uint8_t *bytes = (const uint8_t *) blob->data;
+    unsigned int length = blob->length;
+    h = (h ^ length) * 16777619u;
+    for (unsigned int j = 0; j < length; j++)
+      h = (h ^ bytes[j]) * 16777619u;
+    hb_blob_destroy (blob);
+  }
+
+  unsigned int ret = h ? h : 1; /* 0 means not computed yet. */
+  layout_checksum.set_relaxed (ret);
+  return ret;
+}
+
 #endif
@@ -67,6 +67,7 @@ hb_plan_subset_cff_fdselect (const hb_subset_plan_t *plan,
     if (set == &Null (hb_set_t))
       return false;
     hb_codepoint_t  prev_fd = CFF_UNDEF_CODE;
+    unsigned int    range = 0;
     for (hb_codepoint_t i = 0; i < subset_num_glyphs; i++)
     {
       hb_codepoint_t	glyph;
@@ -76,7 +77,7 @@ hb_plan_subset_cff_fdselect (const hb_subset_plan_t *plan,
 	/* fonttools retains FDSelect & font dicts for missing glyphs. do the same */
 	glyph = i;
       }
-      fd = src.get_fd (glyph);
+      fd = src.get_fd (glyph, range);
       set->add (fd);
 
       if (fd != prev_fd)
@@ -32,6 +32,13 @@
 #include "hb-subset-plan.hh"
 #include "hb-cff-interp-cs-common.hh"
 
+/* Glyph ranges subroutine closures are collected in, at most, when
+ * subsetting on an executor.  Each range parses the subroutines it
+ * reaches on its own, so more ranges repeat more work. */
+#ifndef HB_SUBSET_CFF_MAX_COLLECT_JOBS
+#define HB_SUBSET_CFF_MAX_COLLECT_JOBS 8
+#endif
+
 namespace CFF {
 
 /* Used for writing a temporary charstring */
@@ -295,7 +302,16 @@ struct subr_flattener_t
       return false;
     for (unsigned int i = 0; i < plan->num_output_glyphs (); i++)
       flat_charstrings[i].init ();
-    for (unsigned int i = 0; i < plan->num_output_glyphs (); i++)
+    return plan->for_each_glyph_range ([&] (unsigned int start, unsigned int end)
+				       { return flatten_range (flat_charstrings, start, end); });
+  }
+
+  bool flatten_range (str_buff_vec_t &flat_charstrings,
+		      unsigned int start, unsigned int end) const
+  {
+    /* Set up again for every glyph, keeping its storage. */
+    cs_interpreter_t<ENV, OPSET, flatten_param_t> interp;
+    for (unsigned int i = start; i < end; i++)
     {
       hb_codepoint_t  glyph;
       if (!plan->old_gid_for_new_gid (i, &glyph))
@@ -305,10 +321,9 @@ struct subr_flattener_t
       	continue;
       }
       const byte_str_t str = (*acc.charStrings)[glyph];
-      unsigned int fd = acc.fdSelect->get_fd (glyph);
+      unsigned int fd = acc.get_fd (glyph);
       if (unlikely (fd >= acc.fdCount))
       	return false;
-      cs_interpreter_t<ENV, OPSET, flatten_param_t> interp;
       interp.env.init (str, acc, fd);
       flatten_param_t  param = { flat_charstrings[i], plan->drop_hints };
       if (unlikely (!interp.interpret (param)))
@@ -402,6 +417,9 @@ struct parsed_cs_str_t : parsed_values_t<parsed_cs_op_t>
     parsed = false;
     hint_dropped = false;
     has_prefix_ = false;
+    context_free = false;
+    context_free_args = 0;
+    call_depth = 0;
   }
 
   void add_op (op_code_t op, const byte_str_ref_t& str_ref)
@@ -446,6 +464,22 @@ struct parsed_cs_str_t : parsed_values_t<parsed_cs_op_t>
   bool is_vsindex_dropped () const { return vsindex_dropped; }
   void set_vsindex_dropped ()      { vsindex_dropped = true; }
 
+  /* A subroutine is context-free for a number of arguments once it has been
+   * seen to run from that many to an empty argument stack without touching
+   * hints, the width or the variation state, nor calling through a number
+   * its caller pushed.  Calling it again with as many arguments can only
+   * have the same effect. */
+  bool is_context_free (unsigned int num_args) const
+  { return context_free && context_free_args == num_args; }
+  unsigned int get_call_depth () const { return call_depth; }
+  void set_context_free (unsigned int num_args, unsigned int depth)
+  {
+    if (context_free) return;
+    context_free = true;
+    context_free_args = num_args;
+    call_depth = depth;
+  }
+
   bool has_prefix () const          { return has_prefix_; }
   op_code_t prefix_op () const         { return prefix_op_; }
   const number_t &prefix_num () const { return prefix_num_; }
@@ -455,6 +489,9 @@ struct parsed_cs_str_t : parsed_values_t<parsed_cs_op_t>
   bool    hint_dropped;
   bool    vsindex_dropped;
   bool    has_prefix_;
+  bool    context_free;
+  unsigned int context_free_args;
+  unsigned int call_depth;
   op_code_t	prefix_op_;
   number_t 	prefix_num_;
 
@@ -477,6 +514,79 @@ struct parsed_cs_str_vec_t : hb_vector_t<parsed_cs_str_t>
   typedef hb_vector_t<parsed_cs_str_t> SUPER;
 };
 
+/* Charstrings and subroutines parsed by earlier subsets of a font, so
+ * that a later one only has to parse the glyphs it is first to retain.
+ * Strings are only ever added; subsetters copy out the ones they use.
+ * Charstrings are indexed by source glyph id. */
+struct parsed_cs_cache_t
+{
+  template <typename ACC>
+  void init (const ACC &acc)
+  {
+    lock.init ();
+    parsed_glyphs = hb_set_create ();
+    charstrings.init (acc.is_valid () ? acc.charStrings->count : 0);
+    global_subrs.init (acc.is_valid () ? acc.globalSubrs->count : 0);
+    local_subrs.init ();
+    valid = acc.is_valid () &&
+	    parsed_glyphs != hb_set_get_empty () &&
+	    local_subrs.resize (acc.fdCount) &&
+	    charstrings.length == acc.charStrings->count &&
+	    global_subrs.length == acc.globalSubrs->count;
+    for (unsigned int i = 0; i < local_subrs.length; i++)
+    {
+      local_subrs[i].init (acc.privateDicts[i].localSubrs->count);
+      valid = valid && local_subrs[i].length == acc.privateDicts[i].localSubrs->count;
+    }
+  }
+
+  void fini ()
+  {
+    hb_set_destroy (parsed_glyphs);
+    charstrings.fini ();
+    global_subrs.fini ();
+    local_subrs.fini_deep ();
+    lock.fini ();
+  }
+
+  hb_mutex_t			lock;
+  bool				valid;
+  hb_set_t			*parsed_glyphs;
+  parsed_cs_str_vec_t		charstrings;
+  parsed_cs_str_vec_t		global_subrs;
+  hb_vector_t<parsed_cs_str_vec_t>  local_subrs;
+};
+
+/* Returns the Source, holding an accelerator and parsed_cs_cache_t, that
+ * subsets of face share, creating it on first use.  If face can't hold
+ * it, the Source is only for this subset and *owned is set. */
+template <typename Source>
+static inline Source *
+get_subset_source (hb_face_t *face, hb_user_data_key_t *key, bool *owned)
+{
+  *owned = false;
+  Source *source = (Source *) hb_face_get_user_data (face, key);
+  if (likely (source))
+    return source;
+
+  source = (Source *) calloc (1, sizeof (Source));
+  if (unlikely (!source))
+    return nullptr;
+  source->init (face);
+  if (hb_face_set_user_data (face, key, source, Source::destroy, false))
+    return source;
+
+  /* Another thread was first, or face is inert. */
+  Source *other = (Source *) hb_face_get_user_data (face, key);
+  if (other)
+  {
+    Source::destroy (source);
+    return other;
+  }
+  *owned = true;
+  return source;
+}
+
 struct subr_subset_param_t
 {
   void init (parsed_cs_str_t *parsed_charstring_,
@@ -491,6 +601,100 @@ struct subr_subset_param_t
     global_closure = global_closure_;
     local_closure = local_closure_;
     drop_hints = drop_hints_;
+    num_frames = 0;
+  }
+
+  /* Keep track of the subroutines being interpreted, to find out which ones
+   * are context-free (see parsed_cs_str_t).  Calls to those are recorded
+   * without interpreting them again.
+   *
+   * Argument values never matter to subsetting, except for subroutine
+   * numbers; a subroutine calling through a number its caller pushed is not
+   * context-free.  Each frame remembers how many of the arguments on the
+   * stack are still its caller's. */
+  template <typename ENV, typename SUBRS>
+  bool skip_call (op_code_t op, cs_type_t type, ENV &env,
+		  const biased_subrs_t<SUBRS> &subrs, hb_set_t *closure,
+		  bool settled)
+  {
+    unsigned int count = env.argStack.get_count ();
+    if (unlikely (!count))
+      return false;
+    for (unsigned int i = 0; i < num_frames; i++)
+      if (count <= frames[i].caller_args)
+	frames[i].clean = false;
+    if (!settled)
+      return false;
+
+    int n = env.argStack[count - 1].to_int () + subrs.get_bias ();
+    if (unlikely (n < 0 || (unsigned int) n >= subrs.get_count ()))
+      return false;
+    parsed_cs_str_vec_t *parsed_subrs = type == CSType_LocalSubr ? parsed_local_subrs : parsed_global_subrs;
+    if (unlikely ((unsigned int) n >= parsed_subrs->length))
+      return false;
+    const parsed_cs_str_t &parsed_str = (*parsed_subrs)[n];
+    if (!parsed_str.is_context_free (count - 1) ||
+	env.callStack.get_count () + parsed_str.get_call_depth () >= kMaxCallLimit)
+      return false;
+
+    byte_str_ref_t str_ref = env.str_ref;
+    env.clear_args ();
+    current_parsed_str->add_call_op (op, str_ref, n);
+    /* Subroutines it calls are in the closure already. */
+    hb_set_add (closure, n);
+    if (type == CSType_LocalSubr)
+      taint_global_frames ();
+    set_caller_args (0);
+    if (num_frames)
+      frames[num_frames - 1].call_depth = hb_max (frames[num_frames - 1].call_depth,
+						  parsed_str.get_call_depth () + 1);
+    return true;
+  }
+
+  /* Called once the subroutine number is popped and current_parsed_str
+   * set to the callee.  Unless settled, the callee may see the width. */
+  template <typename ENV>
+  void enter_subr (ENV &env, cs_type_t type, bool settled)
+  {
+    unsigned int count = env.argStack.get_count ();
+    if (type == CSType_LocalSubr)
+      taint_global_frames ();
+    set_caller_args (count);
+    if (unlikely (num_frames >= kMaxCallLimit))
+      return;
+    frame_t &frame = frames[num_frames++];
+    frame.str = current_parsed_str;
+    frame.global = type == CSType_GlobalSubr;
+    frame.clean = settled;
+    frame.num_args = count;
+    frame.caller_args = count;
+    frame.call_depth = 0;
+  }
+
+  template <typename ENV>
+  void leave_subr (ENV &env)
+  {
+    if (unlikely (!num_frames))
+      return;
+    const frame_t &frame = frames[--num_frames];
+    if (frame.clean && env.argStack.is_empty ())
+      frame.str->set_context_free (frame.num_args, frame.call_depth);
+    set_caller_args (env.argStack.get_count ());
+    if (num_frames)
+      frames[num_frames - 1].call_depth = hb_max (frames[num_frames - 1].call_depth,
+						  frame.call_depth + 1);
+  }
+
+  /* After any operator that consumes arguments. */
+  template <typename ENV>
+  void consumed_args (ENV &env) { set_caller_args (env.argStack.get_count ()); }
+
+  /* Hints, width and variation state: anything interpreting the rest of the
+   * charstring depends on. */
+  void taint ()
+  {
+    for (unsigned int i = 0; i < num_frames; i++)
+      frames[i].clean = false;
   }
 
   parsed_cs_str_t *get_parsed_str_for_context (call_context_t &context)
@@ -539,6 +743,33 @@ struct subr_subset_param_t
   hb_set_t      *global_closure;
   hb_set_t      *local_closure;
   bool	  drop_hints;
+
+  protected:
+  void set_caller_args (unsigned int count)
+  {
+    for (unsigned int i = 0; i < num_frames; i++)
+      frames[i].caller_args = hb_min (frames[i].caller_args, count);
+  }
+
+  /* Global subroutines calling local ones depend on the font dict. */
+  void taint_global_frames ()
+  {
+    for (unsigned int i = 0; i < num_frames; i++)
+      if (frames[i].global)
+	frames[i].clean = false;
+  }
+
+  struct frame_t
+  {
+    parsed_cs_str_t	*str;
+    bool		global;
+    bool		clean;
+    unsigned int	num_args;
+    unsigned int	caller_args;
+    unsigned int	call_depth;
+  };
+  frame_t		frames[kMaxCallLimit];
+  unsigned int		num_frames;
 };
 
 struct subr_remap_t : remap_t
@@ -618,8 +849,9 @@ struct subr_remap_ts
 template <typename SUBSETTER, typename SUBRS, typename ACC, typename ENV, typename OPSET, op_code_t endchar_op=OpCode_Invalid>
 struct subr_subsetter_t
 {
-  subr_subsetter_t (ACC &acc_, const hb_subset_plan_t *plan_)
-    : acc (acc_), plan (plan_)
+  subr_subsetter_t (ACC &acc_, const hb_subset_plan_t *plan_,
+		    parsed_cs_cache_t *cache_ = nullptr)
+    : acc (acc_), plan (plan_), cache (cache_)
   {
     parsed_charstrings.init ();
     parsed_global_subrs.init ();
@@ -665,30 +897,12 @@ struct subr_subsetter_t
       return false;
 
     /* phase 1 & 2 */
-    for (unsigned int i = 0; i < plan->num_output_glyphs (); i++)
+    if (!cache || !collect_subrs_cached ())
     {
-      hb_codepoint_t  glyph;
-      if (!plan->old_gid_for_new_gid (i, &glyph))
-      	continue;
-      const byte_str_t str = (*acc.charStrings)[glyph];
-      unsigned int fd = acc.fdSelect->get_fd (glyph);
-      if (unlikely (fd >= acc.fdCount))
-      	return false;
-
-      cs_interpreter_t<ENV, OPSET, subr_subset_param_t> interp;
-      interp.env.init (str, acc, fd);
-
-      subr_subset_param_t  param;
-      param.init (&parsed_charstrings[i],
-		  &parsed_global_subrs,  &parsed_local_subrs[fd],
-		  closures.global_closure, closures.local_closures[fd],
-		  plan->drop_hints);
-
-      if (unlikely (!interp.interpret (param)))
+      closures.reset ();
+      if (unlikely (!collect_subrs (parsed_charstrings, nullptr,
+				    parsed_global_subrs, parsed_local_subrs, closures)))
 	return false;
-
-      /* finalize parsed string esp. copy CFF1 width or CFF2 vsindex to the parsed charstring for encoding */
-      SUBSETTER::finalize_parsed_str (interp.env, param, parsed_charstrings[i]);
     }
 
     if (plan->drop_hints)
@@ -699,7 +913,7 @@ struct subr_subsetter_t
 	hb_codepoint_t  glyph;
 	if (!plan->old_gid_for_new_gid (i, &glyph))
 	  continue;
-	unsigned int fd = acc.fdSelect->get_fd (glyph);
+	unsigned int fd = acc.get_fd (glyph);
 	if (unlikely (fd >= acc.fdCount))
 	  return false;
 	subr_subset_param_t  param;
@@ -724,7 +938,7 @@ struct subr_subsetter_t
 	hb_codepoint_t  glyph;
 	if (!plan->old_gid_for_new_gid (i, &glyph))
 	  continue;
-	unsigned int fd = acc.fdSelect->get_fd (glyph);
+	unsigned int fd = acc.get_fd (glyph);
 	if (unlikely (fd >= acc.fdCount))
 	  return false;
 	subr_subset_param_t  param;
@@ -741,11 +955,209 @@ struct subr_subsetter_t
     return true;
   }
 
+  protected:
+  /* Subroutines parsed, and closures collected, by one range of glyphs. */
+  struct collect_job_t
+  {
+    bool init (const ACC &acc)
+    {
+      closures.init (acc.fdCount);
+      parsed_global_subrs.init (acc.globalSubrs->count);
+      parsed_local_subrs.init ();
+      if (unlikely (!parsed_local_subrs.resize (acc.fdCount)))
+	return false;
+      for (unsigned int i = 0; i < acc.fdCount; i++)
+	parsed_local_subrs[i].init (acc.privateDicts[i].localSubrs->count);
+      return closures.valid;
+    }
+    void fini ()
+    {
+      closures.fini ();
+      parsed_global_subrs.fini ();
+      parsed_local_subrs.fini_deep ();
+    }
+
+    subr_closures_t		closures;
+    parsed_cs_str_vec_t		parsed_global_subrs;
+    hb_vector_t<parsed_cs_str_vec_t>  parsed_local_subrs;
+  };
+
+  /* Interprets the retained glyphs, parsing them into charstrings and the
+   * subroutines they reach into global_subrs and local_subrs.  Without
+   * cached_glyphs, charstrings are indexed by new glyph id; with it, by
+   * source glyph id, and glyphs in cached_glyphs are skipped.
+   *
+   * Glyph ranges are interpreted as separate jobs, each parsing the
+   * subroutines it reaches into its own copies.  A subroutine parses the
+   * same from whichever glyph reaches it first, so taking each one from
+   * the earliest range that parsed it, and merging the closures, gives
+   * what interpreting all glyphs in order would. */
+  bool collect_subrs (parsed_cs_str_vec_t &charstrings,
+		      const hb_set_t *cached_glyphs,
+		      parsed_cs_str_vec_t &global_subrs,
+		      hb_vector_t<parsed_cs_str_vec_t> &local_subrs,
+		      subr_closures_t &closures_)
+  {
+    unsigned int num_glyphs = plan->num_output_glyphs ();
+    unsigned int glyphs_per_job = hb_max ((unsigned int) HB_SUBSET_GLYPHS_PER_JOB,
+					  (num_glyphs + HB_SUBSET_CFF_MAX_COLLECT_JOBS - 1) / HB_SUBSET_CFF_MAX_COLLECT_JOBS);
+    unsigned int num_jobs = plan->get_num_glyph_jobs (glyphs_per_job);
+    if (num_jobs < 2)
+      return collect_subrs_range (0, num_glyphs, charstrings, cached_glyphs,
+				  global_subrs, local_subrs, closures_);
+
+    hb_vector_t<collect_job_t> jobs;
+    bool ret = jobs.resize (num_jobs);
+    for (unsigned int j = 0; ret && j < num_jobs; j++)
+      ret = jobs[j].init (acc);
+
+    ret = ret && plan->for_each_glyph_range ([&] (unsigned int start, unsigned int end)
+    {
+      collect_job_t &job = jobs[start / glyphs_per_job];
+      return collect_subrs_range (start, end, charstrings, cached_glyphs,
+				  job.parsed_global_subrs, job.parsed_local_subrs, job.closures);
+    }, glyphs_per_job);
+
+    for (unsigned int j = 0; ret && j < num_jobs; j++)
+    {
+      collect_job_t &job = jobs[j];
+      hb_set_union (closures_.global_closure, job.closures.global_closure);
+      merge_parsed_subrs (global_subrs, job.parsed_global_subrs);
+      for (unsigned int fd = 0; fd < acc.fdCount; fd++)
+      {
+	hb_set_union (closures_.local_closures[fd], job.closures.local_closures[fd]);
+	merge_parsed_subrs (local_subrs[fd], job.parsed_local_subrs[fd]);
+      }
+    }
+
+    for (unsigned int j = 0; j < jobs.length; j++)
+      jobs[j].fini ();
+    jobs.fini ();
+    return ret;
+  }
+
+  static void merge_parsed_subrs (parsed_cs_str_vec_t &subrs, parsed_cs_str_vec_t &job_subrs)
+  {
+    for (unsigned int i = 0; i < subrs.length; i++)
+      if (!subrs[i].is_parsed () && job_subrs[i].is_parsed ())
+      {
+	subrs[i].fini ();
+	subrs[i] = hb_move (job_subrs[i]);
+      }
+  }
+
+  bool collect_subrs_range (unsigned int start, unsigned int end,
+			    parsed_cs_str_vec_t &charstrings,
+			    const hb_set_t *cached_glyphs,
+			    parsed_cs_str_vec_t &global_subrs,
+			    hb_vector_t<parsed_cs_str_vec_t> &local_subrs,
+			    subr_closures_t &closures_)
+  {
+    /* Set up again for every glyph, keeping its storage. */
+    cs_interpreter_t<ENV, OPSET, subr_subset_param_t> interp;
+    for (unsigned int i = start; i < end; i++)
+    {
+      hb_codepoint_t  glyph;
+      if (!plan->old_gid_for_new_gid (i, &glyph))
+      	continue;
+      if (cached_glyphs && cached_glyphs->has (glyph))
+	continue;
+      if (unlikely (cached_glyphs && glyph >= charstrings.length))
+	return false;
+      parsed_cs_str_t &charstring = charstrings[cached_glyphs ? glyph : i];
+      const byte_str_t str = (*acc.charStrings)[glyph];
+      unsigned int fd = acc.get_fd (glyph);
+      if (unlikely (fd >= acc.fdCount))
+      	return false;
+
+      interp.env.init (str, acc, fd);
+
+      subr_subset_param_t  param;
+      param.init (&charstring,
+		  &global_subrs,  &local_subrs[fd],
+		  closures_.global_closure, closures_.local_closures[fd],
+		  plan->drop_hints);
+
+      if (unlikely (!interp.interpret (param)))
+	return false;
+
+      /* finalize parsed string esp. copy CFF1 width or CFF2 vsindex to the parsed charstring for encoding */
+      SUBSETTER::finalize_parsed_str (interp.env, param, charstring);
+    }
+    return true;
+  }
+
+  /* Parses the retained glyphs the cache doesn't have yet into it, then
+   * copies what this subset uses out of it, which leaves the cache as it
+   * was once hints are marked for dropping.  Closures are collected from
+   * the parsed strings, like they are after dropping hints. */
+  bool collect_subrs_cached ()
+  {
+    hb_lock_t l (cache->lock);
+    if (unlikely (!cache->valid))
+      return false;
+
+    subr_closures_t  scratch;
+    scratch.init (acc.fdCount);
+    bool ret = scratch.valid &&
+	       collect_subrs (cache->charstrings, cache->parsed_glyphs,
+			      cache->global_subrs, cache->local_subrs, scratch);
+    scratch.fini ();
+    if (unlikely (!ret))
+    {
+      /* Subroutines may be half-parsed now. */
+      cache->valid = false;
+      return false;
+    }
+
+    for (unsigned int i = 0; i < plan->num_output_glyphs (); i++)
+    {
+      hb_codepoint_t  glyph;
+      if (!plan->old_gid_for_new_gid (i, &glyph))
+	continue;
+      hb_set_add (cache->parsed_glyphs, glyph);
+      unsigned int fd = acc.get_fd (glyph);
+      parsed_charstrings[i] = cache->charstrings[glyph];
+      subr_subset_param_t  param;
+      param.init (&parsed_charstrings[i],
+		  &cache->global_subrs,  &cache->local_subrs[fd],
+		  closures.global_closure, closures.local_closures[fd],
+		  plan->drop_hints);
+      collect_subr_refs_in_str (parsed_charstrings[i], param);
+    }
+    if (unlikely (cache->parsed_glyphs->in_error ()))
+      cache->valid = false;
+
+    copy_closure (parsed_global_subrs, cache->global_subrs, closures.global_closure);
+    for (unsigned int fd = 0; fd < acc.fdCount; fd++)
+      copy_closure (parsed_local_subrs[fd], cache->local_subrs[fd], closures.local_closures[fd]);
+    return true;
+  }
+
+  static void copy_closure (parsed_cs_str_vec_t &subrs, const parsed_cs_str_vec_t &cached_subrs,
+			    const hb_set_t *closure)
+  {
+    for (hb_codepoint_t n = HB_SET_VALUE_INVALID; hb_set_next (closure, &n);)
+      subrs[n] = cached_subrs[n];
+  }
+
+  public:
   bool encode_charstrings (str_buff_vec_t &buffArray) const
   {
     if (unlikely (!buffArray.resize (plan->num_output_glyphs ())))
       return false;
-    for (unsigned int i = 0; i < plan->num_output_glyphs (); i++)
+    /* Subroutine closures and remaps are final by now; only the
+     * per-glyph buffers are written. */
+    return plan->for_each_glyph_range ([&] (unsigned int start, unsigned int end)
+				       { return encode_charstrings_range (buffArray, start, end); });
+  }
+
+  bool encode_charstrings_range (str_buff_vec_t &buffArray,
+				 unsigned int start, unsigned int end) const
+  {
+    /* Set up again for every glyph, keeping its storage. */
+    cs_interpreter_t<ENV, OPSET, flatten_param_t> interp;
+    for (unsigned int i = start; i < end; i++)
     {
       hb_codepoint_t  glyph;
       if (!plan->old_gid_for_new_gid (i, &glyph))
@@ -754,7 +1166,7 @@ struct subr_subsetter_t
       	if (endchar_op != OpCode_Invalid) buffArray[i].push (endchar_op);
       	continue;
       }
-      unsigned int  fd = acc.fdSelect->get_fd (glyph);
+      unsigned int  fd = acc.get_fd (glyph);
       if (unlikely (fd >= acc.fdCount))
       	return false;
       if (unlikely (!encode_str (parsed_charstrings[i], fd, buffArray[i])))
@@ -926,6 +1338,9 @@ struct subr_subsetter_t
 				  hb_set_t *closure,
 				  const subr_subset_param_t &param)
   {
+    /* Subroutines already in the closure have had their references collected. */
+    if (hb_set_has (closure, subr_num))
+      return;
     hb_set_add (closure, subr_num);
     collect_subr_refs_in_str (subrs[subr_num], param);
   }
@@ -998,6 +1413,7 @@ struct subr_subsetter_t
   protected:
   const ACC   			&acc;
   const hb_subset_plan_t	*plan;
+  parsed_cs_cache_t		*cache;
 
   subr_closures_t		closures;
 
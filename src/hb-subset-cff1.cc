@@ -351,11 +351,13 @@ struct cff1_cs_opset_subr_subset_t : cff1_cs_opset_t<cff1_cs_opset_subr_subset_t
       case OpCode_return:
 	param.current_parsed_str->add_op (op, env.str_ref);
 	param.current_parsed_str->set_parsed ();
+	param.leave_subr (env);
 	env.return_from_subr ();
 	param.set_current_str (env, false);
 	break;
 
       case OpCode_endchar:
+	param.taint ();
 	param.current_parsed_str->add_op (op, env.str_ref);
 	param.current_parsed_str->set_parsed ();
 	SUPER::process_op (op, env, param);
@@ -369,8 +371,20 @@ struct cff1_cs_opset_subr_subset_t : cff1_cs_opset_t<cff1_cs_opset_subr_subset_t
 	process_call_subr (op, CSType_GlobalSubr, env, param, env.globalSubrs, param.global_closure);
 	break;
 
+      case OpCode_hstem:
+      case OpCode_hstemhm:
+      case OpCode_vstem:
+      case OpCode_vstemhm:
+      case OpCode_hintmask:
+      case OpCode_cntrmask:
+	param.taint ();
+	SUPER::process_op (op, env, param);
+	param.current_parsed_str->add_op (op, env.str_ref);
+	break;
+
       default:
 	SUPER::process_op (op, env, param);
+	param.consumed_args (env);
 	param.current_parsed_str->add_op (op, env.str_ref);
 	break;
     }
@@ -381,11 +395,14 @@ struct cff1_cs_opset_subr_subset_t : cff1_cs_opset_t<cff1_cs_opset_subr_subset_t
 				 cff1_cs_interp_env_t &env, subr_subset_param_t& param,
 				 cff1_biased_subrs_t& subrs, hb_set_t *closure)
   {
+    if (param.skip_call (op, type, env, subrs, closure, env.processed_width))
+      return;
     byte_str_ref_t    str_ref = env.str_ref;
     env.call_subr (subrs, type);
     param.current_parsed_str->add_call_op (op, str_ref, env.context.subr_num);
     hb_set_add (closure, env.context.subr_num);
     param.set_current_str (env, true);
+    param.enter_subr (env, type, env.processed_width);
   }
 
   private:
@@ -394,8 +411,9 @@ struct cff1_cs_opset_subr_subset_t : cff1_cs_opset_t<cff1_cs_opset_subr_subset_t
 
 struct cff1_subr_subsetter_t : subr_subsetter_t<cff1_subr_subsetter_t, CFF1Subrs, const OT::cff1::accelerator_subset_t, cff1_cs_interp_env_t, cff1_cs_opset_subr_subset_t, OpCode_endchar>
 {
-  cff1_subr_subsetter_t (const OT::cff1::accelerator_subset_t &acc, const hb_subset_plan_t *plan)
-    : subr_subsetter_t (acc, plan) {}
+  cff1_subr_subsetter_t (const OT::cff1::accelerator_subset_t &acc, const hb_subset_plan_t *plan,
+			 parsed_cs_cache_t *cache)
+    : subr_subsetter_t (acc, plan, cache) {}
 
   static void finalize_parsed_str (cff1_cs_interp_env_t &env, subr_subset_param_t& param, parsed_cs_str_t &charstring)
   {
@@ -599,7 +617,8 @@ struct cff_subset_plan {
   }
 
   bool create (const OT::cff1::accelerator_subset_t &acc,
-	       hb_subset_plan_t *plan)
+	       hb_subset_plan_t *plan,
+	       parsed_cs_cache_t *cache)
   {
     /* make sure notdef is first */
     hb_codepoint_t old_glyph;
@@ -706,7 +725,7 @@ struct cff_subset_plan {
     }
     else
     {
-      cff1_subr_subsetter_t       subr_subsetter (acc, plan);
+      cff1_subr_subsetter_t       subr_subsetter (acc, plan, cache);
 
       /* Subset subrs: collect used subroutines, leaving all unused ones behind */
       if (!subr_subsetter.subset ())
@@ -1066,13 +1085,13 @@ static inline bool _write_cff1 (const cff_subset_plan &plan,
 
 static bool
 _hb_subset_cff1 (const OT::cff1::accelerator_subset_t  &acc,
-		const char		*data,
 		hb_subset_plan_t	*plan,
+		parsed_cs_cache_t	*cache,
 		hb_blob_t		**prime /* OUT */)
 {
   cff_subset_plan cff_plan;
 
-  if (unlikely (!cff_plan.create (acc, plan)))
+  if (unlikely (!cff_plan.create (acc, plan, cache)))
   {
     DEBUG_MSG(SUBSET, nullptr, "Failed to generate a cff subsetting plan.");
     return false;
@@ -1102,19 +1121,46 @@ _hb_subset_cff1 (const OT::cff1::accelerator_subset_t  &acc,
  *
  * Return value: subsetted cff table.
  **/
+/* What subsets of one face share: the accelerator, and the charstrings
+ * parsed so far. */
+struct cff1_subset_source_t
+{
+  void init (hb_face_t *face)
+  {
+    acc.init (face);
+    cache.init (acc);
+  }
+
+  static void destroy (void *data)
+  {
+    cff1_subset_source_t *source = (cff1_subset_source_t *) data;
+    source->cache.fini ();
+    source->acc.fini ();
+    free (source);
+  }
+
+  OT::cff1::accelerator_subset_t acc;
+  parsed_cs_cache_t cache;
+};
+
+static hb_user_data_key_t cff1_subset_source_key;
+
 bool
 hb_subset_cff1 (hb_subset_plan_t *plan,
 		hb_blob_t       **prime /* OUT */)
 {
-  hb_blob_t *cff_blob = hb_sanitize_context_t().reference_table<CFF::cff1> (plan->source);
-  const char *data = hb_blob_get_data(cff_blob, nullptr);
+  bool owned;
+  cff1_subset_source_t *source = get_subset_source<cff1_subset_source_t> (plan->source,
+									  &cff1_subset_source_key,
+									  &owned);
+  if (unlikely (!source))
+    return false;
 
-  OT::cff1::accelerator_subset_t acc;
-  acc.init(plan->source);
+  const OT::cff1::accelerator_subset_t &acc = source->acc;
   bool result = likely (acc.is_valid ()) &&
-			_hb_subset_cff1 (acc, data, plan, prime);
-  hb_blob_destroy (cff_blob);
-  acc.fini ();
+		_hb_subset_cff1 (acc, plan, &source->cache, prime);
 
+  if (owned)
+    cff1_subset_source_t::destroy (source);
   return result;
 }
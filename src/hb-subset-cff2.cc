@@ -138,7 +138,7 @@ struct cff2_cs_opset_flatten_t : cff2_cs_opset_t<cff2_cs_opset_flatten_t, flatte
     {
       const blend_arg_t &arg1 = env.argStack[i + j];
       if (unlikely (!((arg1.blending () && (arg.numValues == arg1.numValues) && (arg1.valueIndex == j) &&
-	      (arg1.deltas.length == env.get_region_count ())))))
+	      (arg1.numDeltas == env.get_region_count ())))))
       {
       	env.set_error ();
       	return;
@@ -148,9 +148,9 @@ struct cff2_cs_opset_flatten_t : cff2_cs_opset_t<cff2_cs_opset_flatten_t, flatte
     /* flatten deltas for each value */
     for (unsigned int j = 0; j < arg.numValues; j++)
     {
-      const blend_arg_t &arg1 = env.argStack[i + j];
-      for (unsigned int k = 0; k < arg1.deltas.length; k++)
-	encoder.encode_num (arg1.deltas[k]);
+      hb_array_t<const number_t> deltas = env.get_deltas (env.argStack[i + j]);
+      for (unsigned int k = 0; k < deltas.length; k++)
+	encoder.encode_num (deltas[k]);
     }
     /* flatten the number of values followed by blend operator */
     encoder.encode_int (arg.numValues);
@@ -183,11 +183,13 @@ struct cff2_cs_opset_subr_subset_t : cff2_cs_opset_t<cff2_cs_opset_subr_subset_t
 
       case OpCode_return:
 	param.current_parsed_str->set_parsed ();
+	param.leave_subr (env);
 	env.return_from_subr ();
 	param.set_current_str (env, false);
 	break;
 
       case OpCode_endchar:
+	param.taint ();
 	param.current_parsed_str->set_parsed ();
 	SUPER::process_op (op, env, param);
 	break;
@@ -200,8 +202,22 @@ struct cff2_cs_opset_subr_subset_t : cff2_cs_opset_t<cff2_cs_opset_subr_subset_t
 	process_call_subr (op, CSType_GlobalSubr, env, param, env.globalSubrs, param.global_closure);
 	break;
 
+      case OpCode_hstem:
+      case OpCode_hstemhm:
+      case OpCode_vstem:
+      case OpCode_vstemhm:
+      case OpCode_hintmask:
+      case OpCode_cntrmask:
+      case OpCode_blendcs:
+      case OpCode_vsindexcs:
+	param.taint ();
+	SUPER::process_op (op, env, param);
+	param.current_parsed_str->add_op (op, env.str_ref);
+	break;
+
       default:
 	SUPER::process_op (op, env, param);
+	param.consumed_args (env);
 	param.current_parsed_str->add_op (op, env.str_ref);
 	break;
     }
@@ -212,11 +228,14 @@ struct cff2_cs_opset_subr_subset_t : cff2_cs_opset_t<cff2_cs_opset_subr_subset_t
 				 cff2_cs_interp_env_t &env, subr_subset_param_t& param,
 				 cff2_biased_subrs_t& subrs, hb_set_t *closure)
   {
+    if (param.skip_call (op, type, env, subrs, closure, true))
+      return;
     byte_str_ref_t    str_ref = env.str_ref;
     env.call_subr (subrs, type);
     param.current_parsed_str->add_call_op (op, str_ref, env.context.subr_num);
     hb_set_add (closure, env.context.subr_num);
     param.set_current_str (env, true);
+    param.enter_subr (env, type, true);
   }
 
   private:
@@ -225,8 +244,9 @@ struct cff2_cs_opset_subr_subset_t : cff2_cs_opset_t<cff2_cs_opset_subr_subset_t
 
 struct cff2_subr_subsetter_t : subr_subsetter_t<cff2_subr_subsetter_t, CFF2Subrs, const OT::cff2::accelerator_subset_t, cff2_cs_interp_env_t, cff2_cs_opset_subr_subset_t>
 {
-  cff2_subr_subsetter_t (const OT::cff2::accelerator_subset_t &acc, const hb_subset_plan_t *plan)
-    : subr_subsetter_t (acc, plan) {}
+  cff2_subr_subsetter_t (const OT::cff2::accelerator_subset_t &acc, const hb_subset_plan_t *plan,
+			 parsed_cs_cache_t *cache)
+    : subr_subsetter_t (acc, plan, cache) {}
 
   static void finalize_parsed_str (cff2_cs_interp_env_t &env, subr_subset_param_t& param, parsed_cs_str_t &charstring)
   {
@@ -268,7 +288,8 @@ struct cff2_subset_plan {
   }
 
   bool create (const OT::cff2::accelerator_subset_t &acc,
-	      hb_subset_plan_t *plan)
+	      hb_subset_plan_t *plan,
+	      parsed_cs_cache_t *cache)
   {
     final_size = 0;
     orig_fdcount = acc.fdArray->count;
@@ -299,7 +320,7 @@ struct cff2_subset_plan {
     }
     else
     {
-      cff2_subr_subsetter_t	subr_subsetter (acc, plan);
+      cff2_subr_subsetter_t	subr_subsetter (acc, plan, cache);
 
       /* Subset subrs: collect used subroutines, leaving all unused ones behind */
       if (!subr_subsetter.subset ())
@@ -573,13 +594,13 @@ static inline bool _write_cff2 (const cff2_subset_plan &plan,
 
 static bool
 _hb_subset_cff2 (const OT::cff2::accelerator_subset_t  &acc,
-		const char		      *data,
 		hb_subset_plan_t		*plan,
+		parsed_cs_cache_t		*cache,
 		hb_blob_t		       **prime /* OUT */)
 {
   cff2_subset_plan cff2_plan;
 
-  if (unlikely (!cff2_plan.create (acc, plan)))
+  if (unlikely (!cff2_plan.create (acc, plan, cache)))
   {
     DEBUG_MSG(SUBSET, nullptr, "Failed to generate a cff2 subsetting plan.");
     return false;
@@ -609,20 +630,46 @@ _hb_subset_cff2 (const OT::cff2::accelerator_subset_t  &acc,
  *
  * Return value: subsetted cff2 table.
  **/
+/* What subsets of one face share: the accelerator, and the charstrings
+ * parsed so far. */
+struct cff2_subset_source_t
+{
+  void init (hb_face_t *face)
+  {
+    acc.init (face);
+    cache.init (acc);
+  }
+
+  static void destroy (void *data)
+  {
+    cff2_subset_source_t *source = (cff2_subset_source_t *) data;
+    source->cache.fini ();
+    source->acc.fini ();
+    free (source);
+  }
+
+  OT::cff2::accelerator_subset_t acc;
+  parsed_cs_cache_t cache;
+};
+
+static hb_user_data_key_t cff2_subset_source_key;
+
 bool
 hb_subset_cff2 (hb_subset_plan_t *plan,
 		hb_blob_t       **prime /* OUT */)
 {
-  hb_blob_t *cff2_blob = hb_sanitize_context_t().reference_table<CFF::cff2> (plan->source);
-  const char *data = hb_blob_get_data(cff2_blob, nullptr);
+  bool owned;
+  cff2_subset_source_t *source = get_subset_source<cff2_subset_source_t> (plan->source,
+									  &cff2_subset_source_key,
+									  &owned);
+  if (unlikely (!source))
+    return false;
 
-  OT::cff2::accelerator_subset_t acc;
-  acc.init(plan->source);
+  const OT::cff2::accelerator_subset_t &acc = source->acc;
   bool result = likely (acc.is_valid ()) &&
-		_hb_subset_cff2 (acc, data, plan, prime);
-
-  hb_blob_destroy (cff2_blob);
-  acc.fini ();
+		_hb_subset_cff2 (acc, plan, &source->cache, prime);
 
+  if (owned)
+    cff2_subset_source_t::destroy (source);
   return result;
 }
@@ -29,64 +29,81 @@
 #include "hb-set.h"
 #include "hb-subset-glyf.hh"
 
-struct loca_data_t
+/* glyf' is written in one pass into a buffer that grows as glyphs are
+ * appended; loca' is filled with long offsets along the way and packed
+ * down to short offsets at the end if they fit. */
+struct glyf_prime_data_t
 {
-  bool          is_short;
-  void         *data;
-  unsigned int  size;
+  char         *data;
+  unsigned int  length;
+  unsigned int  allocated;
 
-  inline bool
-  _write_loca_entry (unsigned int  id,
-                     unsigned int  offset)
+  bool
+  _grow (unsigned int size)
   {
-    unsigned int entry_size = is_short ? sizeof (OT::HBUINT16) : sizeof (OT::HBUINT32);
-    if ((id + 1) * entry_size <= size)
-    {
-      if (is_short) {
-        ((OT::HBUINT16*) data) [id] = offset / 2;
-      } else {
-        ((OT::HBUINT32*) data) [id] = offset;
-      }
+    if (likely (size <= allocated))
       return true;
+
+    unsigned int new_allocated = allocated;
+    while (size > new_allocated)
+    {
+      unsigned int grown = new_allocated + (new_allocated >> 1) + 64;
+      if (unlikely (grown < new_allocated))
+	return false;
+      new_allocated = grown;
     }
 
-    // Offset was not written because the write is out of bounds.
-    DEBUG_MSG(SUBSET,
-              nullptr,
-              "WARNING: Attempted to write an out of bounds loca entry at index %d. Loca size is %d.",
-              id,
-              size);
-    return false;
+    char *new_data = (char *) realloc (data, new_allocated);
+    if (unlikely (!new_data))
+    {
+      DEBUG_MSG(SUBSET, nullptr, "Failed to grow glyf prime to %d bytes.", new_allocated);
+      return false;
+    }
+    data = new_data;
+    allocated = new_allocated;
+    return true;
+  }
+
+  char *
+  _append (unsigned int size)
+  {
+    /* One extra byte for the padding that follows every glyph. */
+    if (unlikely (size >= (unsigned int) -1 - length ||
+		  !_grow (length + size + 1)))
+      return nullptr;
+    char *p = data + length;
+    length += size;
+    return p;
+  }
+
+  void
+  _pad ()
+  {
+    // TODO: don't align to two bytes if using long loca.
+    if (length % 2)
+      data[length++] = 0; /* _append () reserved room for this. */
   }
 };
 
 /*
  * If hints are being dropped find the range which in glyf at which
- * the hinting instructions are located. Add them to the instruction_ranges
- * vector.
+ * the hinting instructions are located.
  */
 static bool
-_add_instructions_range (const OT::glyf::accelerator_t &glyf,
-                         hb_codepoint_t                 glyph_id,
-                         unsigned int                   glyph_start_offset,
-                         unsigned int                   glyph_end_offset,
-                         bool                           drop_hints,
-                         hb_vector_t<unsigned int>     *instruction_ranges /* OUT */)
+_get_instructions_range (const OT::glyf::accelerator_t &glyf,
+			 hb_codepoint_t                 glyph_id,
+			 unsigned int                   glyph_start_offset,
+			 unsigned int                   glyph_end_offset,
+			 bool                           drop_hints,
+			 unsigned int                  *instruction_start /* OUT */,
+			 unsigned int                  *instruction_end /* OUT */)
 {
-  if (!instruction_ranges->resize (instruction_ranges->length + 2))
-  {
-    DEBUG_MSG(SUBSET, nullptr, "Failed to resize instruction_ranges.");
-    return false;
-  }
-  unsigned int *instruction_start = &(*instruction_ranges)[instruction_ranges->length - 2];
-  *instruction_start = 0;
-  unsigned int *instruction_end = &(*instruction_ranges)[instruction_ranges->length - 1];
-  *instruction_end = 0;
+  *instruction_start = *instruction_end = 0;
 
   if (drop_hints)
   {
     if (unlikely (!glyf.get_instruction_offsets (glyph_start_offset, glyph_end_offset,
-                                                 instruction_start, instruction_end)))
+						 instruction_start, instruction_end)))
     {
       DEBUG_MSG(SUBSET, nullptr, "Unable to get instruction offsets for %d", glyph_id);
       return false;
@@ -96,57 +113,6 @@ _add_instructions_range (const OT::glyf::accelerator_t &glyf,
   return true;
 }
 
-static bool
-_calculate_glyf_and_loca_prime_size (const OT::glyf::accelerator_t &glyf,
-                                     const hb_subset_plan_t        *plan,
-                                     loca_data_t                   *loca_data, /* OUT */
-				     unsigned int                  *glyf_size /* OUT */,
-				     hb_vector_t<unsigned int>     *instruction_ranges /* OUT */)
-{
-  unsigned int total = 0;
-
-  hb_codepoint_t next_glyph = HB_SET_VALUE_INVALID;
-  while (plan->glyphset ()->next (&next_glyph))
-  {
-    unsigned int start_offset = 0, end_offset = 0;
-    if (unlikely (!(glyf.get_offsets (next_glyph, &start_offset, &end_offset) &&
-		    glyf.remove_padding (start_offset, &end_offset))))
-    {
-      DEBUG_MSG(SUBSET, nullptr, "Invalid gid %d", next_glyph);
-      start_offset = end_offset = 0;
-    }
-
-    bool is_zero_length = end_offset - start_offset < OT::glyf::GlyphHeader::static_size;
-    if (!_add_instructions_range (glyf,
-                                  next_glyph,
-                                  start_offset,
-                                  end_offset,
-                                  plan->drop_hints && !is_zero_length,
-                                  instruction_ranges))
-      return false;
-
-    if (is_zero_length)
-      continue; /* 0-length glyph */
-
-    total += end_offset - start_offset
-             - ((*instruction_ranges)[instruction_ranges->length - 1]
-                - (*instruction_ranges)[instruction_ranges->length - 2]);
-    /* round2 so short loca will work */
-    total += total % 2;
-  }
-
-  *glyf_size = total;
-  loca_data->is_short = (total <= 131070);
-  loca_data->size = (plan->num_output_glyphs () + 1)
-      * (loca_data->is_short ? sizeof (OT::HBUINT16) : sizeof (OT::HBUINT32));
-
-  DEBUG_MSG(SUBSET, nullptr, "preparing to subset glyf: final size %d, loca size %d, using %s loca",
-	    total,
-	    loca_data->size,
-	    loca_data->is_short ? "short" : "long");
-  return true;
-}
-
 static void
 _update_components (const hb_subset_plan_t *plan,
 		    char                   *glyph_start,
@@ -184,132 +150,558 @@ static bool _remove_composite_instruction_flag (char *glyf_prime, unsigned int l
 }
 
 static bool
-_write_glyf_and_loca_prime (const hb_subset_plan_t        *plan,
-			    const OT::glyf::accelerator_t &glyf,
-			    const char                    *glyf_data,
-			    hb_vector_t<unsigned int>     &instruction_ranges,
-			    unsigned int                   glyf_prime_size,
-			    char                          *glyf_prime_data /* OUT */,
-			    loca_data_t                   *loca_prime /* OUT */)
+_write_glyph (const hb_subset_plan_t        *plan,
+	      const OT::glyf::accelerator_t &glyf,
+	      const char                    *glyf_data,
+	      hb_codepoint_t                 old_gid,
+	      glyf_prime_data_t             *glyf_prime /* OUT */)
+{
+  unsigned int start_offset = 0, end_offset = 0;
+  if (unlikely (!(glyf.get_offsets (old_gid, &start_offset, &end_offset) &&
+		  glyf.remove_padding (start_offset, &end_offset))))
+  {
+    DEBUG_MSG(SUBSET, nullptr, "Invalid gid %d", old_gid);
+    start_offset = end_offset = 0;
+  }
+
+  if (end_offset - start_offset < OT::glyf::GlyphHeader::static_size)
+    return true; /* 0-length glyph */
+
+  unsigned int instruction_start, instruction_end;
+  if (unlikely (!_get_instructions_range (glyf, old_gid,
+					  start_offset, end_offset,
+					  plan->drop_hints,
+					  &instruction_start, &instruction_end)))
+    return false;
+
+  unsigned int length = end_offset - start_offset - (instruction_end - instruction_start);
+  char *glyph_prime = glyf_prime->_append (length);
+  if (unlikely (!glyph_prime))
+    return false;
+
+  if (instruction_start == instruction_end)
+    memcpy (glyph_prime, glyf_data + start_offset, length);
+  else
+  {
+    memcpy (glyph_prime, glyf_data + start_offset, instruction_start - start_offset);
+    memcpy (glyph_prime + instruction_start - start_offset, glyf_data + instruction_end, end_offset - instruction_end);
+    /* if the instructions end at the end this was a composite glyph, else simple */
+    if (instruction_end == end_offset)
+    {
+      if (unlikely (!_remove_composite_instruction_flag (glyph_prime, length))) return false;
+    }
+    else
+      /* zero instruction length, which is just before instruction_start */
+      memset (glyph_prime + instruction_start - start_offset - 2, 0, 2);
+  }
+
+  _update_components (plan, glyph_prime, length);
+  glyf_prime->_pad ();
+  return true;
+}
+
+/*
+ * Simple glyphs are copied as is unless hints are dropped, so a run of
+ * them that sits back to back in the source glyf, and whose padding the
+ * subset would leave alone, is copied with a single memcpy.  Stops at the
+ * first glyph that needs per-glyph work (composites, trimmed padding)
+ * and returns the number of glyphs copied in *run_length.
+ */
+static bool
+_copy_simple_glyph_run (const hb_subset_plan_t        *plan,
+			const OT::glyf::accelerator_t &glyf,
+			const char                    *glyf_data,
+			hb_codepoint_t                 new_gid,
+			hb_codepoint_t                 old_gid,
+			glyf_prime_data_t             *glyf_prime /* OUT */,
+			OT::HBUINT32                  *loca_prime /* OUT */,
+			unsigned int                  *run_length /* OUT */)
 {
-  char *glyf_prime_data_next = glyf_prime_data;
+  unsigned int num_output_glyphs = plan->num_output_glyphs ();
+  unsigned int run_start = 0, run_end = 0;
+  unsigned int count = 0;
+  while (new_gid + count < num_output_glyphs)
+  {
+    hb_codepoint_t gid;
+    if (!plan->old_gid_for_new_gid (new_gid + count, &gid) || gid != old_gid + count)
+      break;
 
-  bool success = true;
+    unsigned int start_offset, end_offset;
+    if (!glyf.get_offsets (gid, &start_offset, &end_offset) ||
+	(count && start_offset != run_end))
+      break;
 
+    if (end_offset - start_offset >= OT::glyf::GlyphHeader::static_size)
+    {
+      const OT::glyf::GlyphHeader &header = StructAtOffset<OT::glyf::GlyphHeader> (glyf_data, start_offset);
+      unsigned int trimmed_end = end_offset;
+      if ((int16_t) header.numberOfContours < 0 ||
+	  !glyf.remove_padding (start_offset, &trimmed_end))
+	break;
+      /* The subset pads to two bytes with a zero; anything else is trimmed. */
+      if ((end_offset - start_offset) % 2 ||
+	  (trimmed_end != end_offset &&
+	   (trimmed_end + 1 != end_offset || glyf_data[trimmed_end])))
+	break;
+    }
+    else if (start_offset != end_offset)
+      break; /* Dropped by _write_glyph (). */
+
+    if (!count)
+      run_start = start_offset;
+    loca_prime[new_gid + count] = glyf_prime->length + (start_offset - run_start);
+    run_end = end_offset;
+    count++;
+  }
 
-  unsigned int i = 0;
-  hb_codepoint_t new_gid;
-  for (new_gid = 0; new_gid < plan->num_output_glyphs (); new_gid++)
+  *run_length = count;
+  if (!count || run_end == run_start)
+    return true;
+
+  char *run_prime = glyf_prime->_append (run_end - run_start);
+  if (unlikely (!run_prime))
+    return false;
+  memcpy (run_prime, glyf_data + run_start, run_end - run_start);
+  return true;
+}
+
+static bool
+_write_glyf_and_loca_prime (const hb_subset_plan_t        *plan,
+			    const OT::glyf::accelerator_t &glyf,
+			    const char                    *glyf_data,
+			    glyf_prime_data_t             *glyf_prime /* OUT */,
+			    OT::HBUINT32                  *loca_prime /* OUT */)
+{
+  unsigned int num_output_glyphs = plan->num_output_glyphs ();
+  for (hb_codepoint_t new_gid = 0; new_gid < num_output_glyphs; new_gid++)
   {
+    loca_prime[new_gid] = glyf_prime->length;
+
     hb_codepoint_t old_gid;
     if (!plan->old_gid_for_new_gid (new_gid, &old_gid))
+      continue; // Empty glyph, the loca entry is all it needs.
+
+    if (!plan->drop_hints)
     {
-      // Empty glyph, add a loca entry and carry on.
-      loca_prime->_write_loca_entry (new_gid,
-                                     glyf_prime_data_next - glyf_prime_data);
-      continue;
+      unsigned int run_length;
+      if (unlikely (!_copy_simple_glyph_run (plan, glyf, glyf_data,
+					     new_gid, old_gid,
+					     glyf_prime, loca_prime,
+					     &run_length)))
+	return false;
+      if (run_length)
+      {
+	new_gid += run_length - 1;
+	continue;
+      }
     }
 
+    if (unlikely (!_write_glyph (plan, glyf, glyf_data, old_gid, glyf_prime)))
+      return false;
+  }
+
+  // loca table has n+1 entries where the last entry signifies the end location of the last
+  // glyph.
+  loca_prime[num_output_glyphs] = glyf_prime->length;
+  return true;
+}
 
-    unsigned int start_offset = 0, end_offset = 0;
-    if (unlikely (!(glyf.get_offsets (old_gid, &start_offset, &end_offset) &&
-		    glyf.remove_padding (start_offset, &end_offset))))
-      end_offset = start_offset = 0;
+/*
+ * WOFF2 glyf transform, section 5.1 of the WOFF2 spec.  glyf' is split
+ * into the streams below, which compress better than the glyphs
+ * themselves; the decoder rebuilds glyf and loca, so loca' is empty.
+ */
+struct woff2_glyf_streams_t
+{
+  enum {
+    ON_CURVE		= 0x01,
+    X_SHORT		= 0x02,
+    Y_SHORT		= 0x04,
+    REPEAT		= 0x08,
+    X_SAME_OR_POSITIVE	= 0x10,
+    Y_SAME_OR_POSITIVE	= 0x20,
+    OVERLAP_SIMPLE	= 0x40,
+
+    ARG_1_AND_2_ARE_WORDS	= 0x0001,
+    WE_HAVE_A_SCALE		= 0x0008,
+    MORE_COMPONENTS		= 0x0020,
+    WE_HAVE_AN_X_AND_Y_SCALE	= 0x0040,
+    WE_HAVE_A_TWO_BY_TWO	= 0x0080,
+    WE_HAVE_INSTRUCTIONS	= 0x0100,
+  };
+
+  hb_vector_t<char> n_contour;
+  hb_vector_t<char> n_points;
+  hb_vector_t<char> flags;
+  hb_vector_t<char> glyph;
+  hb_vector_t<char> composite;
+  hb_vector_t<char> bbox_bitmap;
+  hb_vector_t<char> bbox;
+  hb_vector_t<char> instruction;
+  hb_vector_t<char> overlap_bitmap;
+  bool has_overlap;
+
+  /* Scratch for decoding one simple glyph. */
+  hb_vector_t<uint8_t> point_flags;
+  hb_vector_t<int> xs, ys;
+
+  static unsigned int _get_u16 (const uint8_t *p) { return (p[0] << 8) | p[1]; }
+  static int _get_i16 (const uint8_t *p) { return (int16_t) _get_u16 (p); }
+
+  static void _push_u8 (hb_vector_t<char> &s, unsigned int v) { s.push ((char) v); }
+  static void _push_u16 (hb_vector_t<char> &s, unsigned int v)
+  { _push_u8 (s, v >> 8); _push_u8 (s, v); }
+  static void _push_u32 (hb_vector_t<char> &s, unsigned int v)
+  { _push_u16 (s, v >> 16); _push_u16 (s, v); }
+  static void _push_bytes (hb_vector_t<char> &s, const uint8_t *p, unsigned int len)
+  {
+    if (unlikely (!s.alloc (s.length + len))) return;
+    for (unsigned int i = 0; i < len; i++)
+      s.push ((char) p[i]);
+  }
+  static void _push_255_u16 (hb_vector_t<char> &s, unsigned int v)
+  {
+    if (v < 253) _push_u8 (s, v);
+    else if (v < 506) { _push_u8 (s, 255); _push_u8 (s, v - 253); }
+    else if (v < 762) { _push_u8 (s, 254); _push_u8 (s, v - 506); }
+    else { _push_u8 (s, 253); _push_u16 (s, v); }
+  }
+  static void _set_bit (hb_vector_t<char> &bitmap, unsigned int gid)
+  { bitmap[gid >> 3] = bitmap[gid >> 3] | (0x80 >> (gid & 7)); }
 
-    unsigned int instruction_start = instruction_ranges[i * 2];
-    unsigned int instruction_end = instruction_ranges[i * 2 + 1];
+  void _push_triplet (bool on_curve, int dx, int dy)
+  {
+    unsigned int abs_x = dx < 0 ? -dx : dx;
+    unsigned int abs_y = dy < 0 ? -dy : dy;
+    unsigned int on_curve_bit = on_curve ? 0 : 128;
+    unsigned int x_sign_bit = dx < 0 ? 0 : 1;
+    unsigned int y_sign_bit = dy < 0 ? 0 : 1;
+    unsigned int xy_sign_bits = x_sign_bit + 2 * y_sign_bit;
+
+    if (dx == 0 && abs_y < 1280)
+    {
+      _push_u8 (flags, on_curve_bit + ((abs_y & 0xF00) >> 7) + y_sign_bit);
+      _push_u8 (glyph, abs_y);
+    }
+    else if (dy == 0 && abs_x < 1280)
+    {
+      _push_u8 (flags, on_curve_bit + 10 + ((abs_x & 0xF00) >> 7) + x_sign_bit);
+      _push_u8 (glyph, abs_x);
+    }
+    else if (abs_x < 65 && abs_y < 65)
+    {
+      _push_u8 (flags, on_curve_bit + 20 + ((abs_x - 1) & 0x30) + (((abs_y - 1) & 0x30) >> 2) + xy_sign_bits);
+      _push_u8 (glyph, (((abs_x - 1) & 0xF) << 4) | ((abs_y - 1) & 0xF));
+    }
+    else if (abs_x < 769 && abs_y < 769)
+    {
+      _push_u8 (flags, on_curve_bit + 84 + 12 * (((abs_x - 1) & 0x300) >> 8) + (((abs_y - 1) & 0x300) >> 6) + xy_sign_bits);
+      _push_u8 (glyph, abs_x - 1);
+      _push_u8 (glyph, abs_y - 1);
+    }
+    else if (abs_x < 4096 && abs_y < 4096)
+    {
+      _push_u8 (flags, on_curve_bit + 120 + xy_sign_bits);
+      _push_u8 (glyph, abs_x >> 4);
+      _push_u8 (glyph, ((abs_x & 0xF) << 4) | (abs_y >> 8));
+      _push_u8 (glyph, abs_y);
+    }
+    else
+    {
+      _push_u8 (flags, on_curve_bit + 124 + xy_sign_bits);
+      _push_u16 (glyph, abs_x);
+      _push_u16 (glyph, abs_y);
+    }
+  }
 
-    int length = end_offset - start_offset - (instruction_end - instruction_start);
+  bool _add_simple_glyph (unsigned int gid, const uint8_t *p, const uint8_t *end)
+  {
+    unsigned int num_contours = _get_u16 (p);
+    const uint8_t *q = p + OT::glyf::GlyphHeader::static_size;
+    if (unlikely (end - q < 2 * (int) num_contours + 2)) return false;
 
-    if (glyf_prime_data_next + length > glyf_prime_data + glyf_prime_size)
+    _push_u16 (n_contour, num_contours);
+    unsigned int num_points = 0;
+    for (unsigned int i = 0; i < num_contours; i++, q += 2)
     {
-      DEBUG_MSG(SUBSET,
-                nullptr,
-                "WARNING: Attempted to write an out of bounds glyph entry for gid %d (length %d)",
-                i, length);
+      unsigned int end_point = _get_u16 (q);
+      if (unlikely (end_point < num_points)) return false;
+      _push_255_u16 (n_points, end_point + 1 - num_points);
+      num_points = end_point + 1;
+    }
+
+    unsigned int instruction_length = _get_u16 (q);
+    q += 2;
+    if (unlikely (end - q < (int) instruction_length)) return false;
+    const uint8_t *instructions = q;
+    q += instruction_length;
+
+    if (unlikely (!point_flags.resize (num_points) ||
+		  !xs.resize (num_points) || !ys.resize (num_points)))
       return false;
+    for (unsigned int i = 0; i < num_points;)
+    {
+      if (unlikely (q >= end)) return false;
+      uint8_t flag = *q++;
+      unsigned int repeat = 1;
+      if (flag & REPEAT)
+      {
+	if (unlikely (q >= end)) return false;
+	repeat += *q++;
+      }
+      if (unlikely (repeat > num_points - i)) return false;
+      while (repeat--)
+	point_flags[i++] = flag;
     }
 
-    if (instruction_start == instruction_end)
-      memcpy (glyf_prime_data_next, glyf_data + start_offset, length);
-    else
+    int x = 0;
+    for (unsigned int i = 0; i < num_points; i++)
+    {
+      uint8_t flag = point_flags[i];
+      if (flag & X_SHORT)
+      {
+	if (unlikely (q + 1 > end)) return false;
+	x += flag & X_SAME_OR_POSITIVE ? *q : -(int) *q;
+	q++;
+      }
+      else if (!(flag & X_SAME_OR_POSITIVE))
+      {
+	if (unlikely (q + 2 > end)) return false;
+	x += _get_i16 (q);
+	q += 2;
+      }
+      xs[i] = x;
+    }
+    int y = 0;
+    for (unsigned int i = 0; i < num_points; i++)
     {
-      memcpy (glyf_prime_data_next, glyf_data + start_offset, instruction_start - start_offset);
-      memcpy (glyf_prime_data_next + instruction_start - start_offset, glyf_data + instruction_end, end_offset - instruction_end);
-      /* if the instructions end at the end this was a composite glyph, else simple */
-      if (instruction_end == end_offset)
+      uint8_t flag = point_flags[i];
+      if (flag & Y_SHORT)
       {
-	if (unlikely (!_remove_composite_instruction_flag (glyf_prime_data_next, length))) return false;
+	if (unlikely (q + 1 > end)) return false;
+	y += flag & Y_SAME_OR_POSITIVE ? *q : -(int) *q;
+	q++;
       }
-      else
-	/* zero instruction length, which is just before instruction_start */
-	memset (glyf_prime_data_next + instruction_start - start_offset - 2, 0, 2);
+      else if (!(flag & Y_SAME_OR_POSITIVE))
+      {
+	if (unlikely (q + 2 > end)) return false;
+	y += _get_i16 (q);
+	q += 2;
+      }
+      ys[i] = y;
+    }
+
+    int x_min = 0, y_min = 0, x_max = 0, y_max = 0;
+    int last_x = 0, last_y = 0;
+    for (unsigned int i = 0; i < num_points; i++)
+    {
+      _push_triplet (point_flags[i] & ON_CURVE, xs[i] - last_x, ys[i] - last_y);
+      last_x = xs[i];
+      last_y = ys[i];
+      if (!i || xs[i] < x_min) x_min = xs[i];
+      if (!i || xs[i] > x_max) x_max = xs[i];
+      if (!i || ys[i] < y_min) y_min = ys[i];
+      if (!i || ys[i] > y_max) y_max = ys[i];
     }
 
-    success = success && loca_prime->_write_loca_entry (new_gid,
-                                                        glyf_prime_data_next - glyf_prime_data);
-    _update_components (plan, glyf_prime_data_next, length);
+    /* The decoder computes the bounding box of simple glyphs from their
+     * points; only boxes that differ are stored. */
+    if (x_min != _get_i16 (p + 2) || y_min != _get_i16 (p + 4) ||
+	x_max != _get_i16 (p + 6) || y_max != _get_i16 (p + 8))
+    {
+      _set_bit (bbox_bitmap, gid);
+      _push_bytes (bbox, p + 2, 8);
+    }
 
-    // TODO: don't align to two bytes if using long loca.
-    glyf_prime_data_next += length + (length % 2); // Align to 2 bytes for short loca.
+    if (num_points && (point_flags[0] & OVERLAP_SIMPLE))
+    {
+      _set_bit (overlap_bitmap, gid);
+      has_overlap = true;
+    }
 
-    i++;
+    _push_255_u16 (glyph, instruction_length);
+    _push_bytes (instruction, instructions, instruction_length);
+    return true;
   }
 
-  // loca table has n+1 entries where the last entry signifies the end location of the last
-  // glyph.
-  success = success && loca_prime->_write_loca_entry (new_gid,
-                                                      glyf_prime_data_next - glyf_prime_data);
-  return success;
+  bool _add_composite_glyph (unsigned int gid, const uint8_t *p, const uint8_t *end)
+  {
+    _push_u16 (n_contour, 0xFFFF);
+    _set_bit (bbox_bitmap, gid);
+    _push_bytes (bbox, p + 2, 8);
+
+    const uint8_t *components = p + OT::glyf::GlyphHeader::static_size;
+    const uint8_t *q = components;
+    unsigned int flag;
+    bool have_instructions = false;
+    do
+    {
+      if (unlikely (end - q < 4)) return false;
+      flag = _get_u16 (q);
+      unsigned int size = 4 + (flag & ARG_1_AND_2_ARE_WORDS ? 4 : 2);
+      if (flag & WE_HAVE_A_SCALE) size += 2;
+      else if (flag & WE_HAVE_AN_X_AND_Y_SCALE) size += 4;
+      else if (flag & WE_HAVE_A_TWO_BY_TWO) size += 8;
+      if (unlikely (end - q < (int) size)) return false;
+      have_instructions = have_instructions || (flag & WE_HAVE_INSTRUCTIONS);
+      q += size;
+    } while (flag & MORE_COMPONENTS);
+    _push_bytes (composite, components, q - components);
+
+    if (have_instructions)
+    {
+      if (unlikely (end - q < 2)) return false;
+      unsigned int instruction_length = _get_u16 (q);
+      q += 2;
+      if (unlikely (end - q < (int) instruction_length)) return false;
+      _push_255_u16 (glyph, instruction_length);
+      _push_bytes (instruction, q, instruction_length);
+    }
+    return true;
+  }
+
+  bool add_glyph (unsigned int gid, const char *data, unsigned int length)
+  {
+    const uint8_t *p = (const uint8_t *) data;
+    int num_contours = length >= OT::glyf::GlyphHeader::static_size ? _get_i16 (p) : 0;
+    if (num_contours > 0)
+      return _add_simple_glyph (gid, p, p + length);
+    if (num_contours < 0)
+      return _add_composite_glyph (gid, p, p + length);
+    _push_u16 (n_contour, 0);
+    return true;
+  }
+
+  hb_blob_t *serialize (unsigned int num_glyphs, bool is_short) const
+  {
+    const hb_vector_t<char> *streams[] = {&n_contour, &n_points, &flags, &glyph,
+					  &composite, &bbox_bitmap, &bbox, &instruction};
+    hb_vector_t<char> out;
+    _push_u16 (out, 0); /* reserved */
+    _push_u16 (out, has_overlap ? 1 : 0); /* optionFlags: overlapSimpleBitmap present */
+    _push_u16 (out, num_glyphs);
+    _push_u16 (out, is_short ? 0 : 1);
+    _push_u32 (out, n_contour.length);
+    _push_u32 (out, n_points.length);
+    _push_u32 (out, flags.length);
+    _push_u32 (out, glyph.length);
+    _push_u32 (out, composite.length);
+    _push_u32 (out, bbox_bitmap.length + bbox.length);
+    _push_u32 (out, instruction.length);
+    for (unsigned int i = 0; i < ARRAY_LENGTH (streams); i++)
+      _push_bytes (out, (const uint8_t *) streams[i]->arrayZ (), streams[i]->length);
+    if (has_overlap)
+      _push_bytes (out, (const uint8_t *) overlap_bitmap.arrayZ (), overlap_bitmap.length);
+    if (unlikely (out.in_error ()))
+      return nullptr;
+
+    return hb_blob_create (out.arrayZ (), out.length,
+			   HB_MEMORY_MODE_DUPLICATE, nullptr, nullptr);
+  }
+
+  bool in_error () const
+  {
+    return n_contour.in_error () || n_points.in_error () || flags.in_error () ||
+	   glyph.in_error () || composite.in_error () || bbox_bitmap.in_error () ||
+	   bbox.in_error () || instruction.in_error () || overlap_bitmap.in_error ();
+  }
+};
+
+static hb_blob_t *
+_woff2_transform_glyf (const glyf_prime_data_t &glyf_prime,
+		       const OT::HBUINT32       *loca_prime,
+		       unsigned int              num_glyphs,
+		       bool                      is_short)
+{
+  woff2_glyf_streams_t streams;
+  streams.has_overlap = false;
+  unsigned int bitmap_size = 4 * ((num_glyphs + 31) / 32);
+  if (unlikely (!streams.bbox_bitmap.resize (bitmap_size) ||
+		!streams.overlap_bitmap.resize (bitmap_size)))
+    return nullptr;
+
+  for (unsigned int gid = 0; gid < num_glyphs; gid++)
+    if (unlikely (!streams.add_glyph (gid,
+				      glyf_prime.data + loca_prime[gid],
+				      loca_prime[gid + 1] - loca_prime[gid])))
+    {
+      DEBUG_MSG(SUBSET, nullptr, "Unable to transform glyph %d for WOFF2.", gid);
+      return nullptr;
+    }
+
+  if (unlikely (streams.in_error ()))
+    return nullptr;
+  return streams.serialize (num_glyphs, is_short);
 }
 
 static bool
 _hb_subset_glyf_and_loca (const OT::glyf::accelerator_t  &glyf,
 			  const char                     *glyf_data,
+			  unsigned int                    glyf_length,
 			  hb_subset_plan_t               *plan,
 			  bool                           *use_short_loca,
 			  hb_blob_t                     **glyf_prime_blob /* OUT */,
 			  hb_blob_t                     **loca_prime_blob /* OUT */)
 {
-  // TODO(grieger): Sanity check allocation size for the new table.
-  loca_data_t loca_prime;
-  unsigned int glyf_prime_size;
-  hb_vector_t<unsigned int> instruction_ranges;
-  instruction_ranges.init ();
-
-  if (unlikely (!_calculate_glyf_and_loca_prime_size (glyf,
-                                                      plan,
-                                                      &loca_prime,
-						      &glyf_prime_size,
-						      &instruction_ranges))) {
-    instruction_ranges.fini ();
+  unsigned int num_output_glyphs = plan->num_output_glyphs ();
+  unsigned int num_entries = num_output_glyphs + 1;
+  OT::HBUINT32 *loca_prime = (OT::HBUINT32 *) calloc (num_entries, sizeof (OT::HBUINT32));
+  if (unlikely (!loca_prime))
     return false;
-  }
-  *use_short_loca = loca_prime.is_short;
 
-  char *glyf_prime_data = (char *) calloc (1, glyf_prime_size);
-  loca_prime.data = (void *) calloc (1, loca_prime.size);
+  /* Start from the glyphs' average size in the source font; the buffer
+   * grows from there if the retained glyphs are larger than average. */
+  glyf_prime_data_t glyf_prime = {nullptr, 0, 0};
+  unsigned int num_glyphs = plan->source->get_num_glyphs ();
+  if (num_glyphs)
+    glyf_prime._grow ((unsigned int) hb_min ((uint64_t) glyf_length,
+					     (uint64_t) glyf_length * plan->glyphset ()->get_population () / num_glyphs));
+
   if (unlikely (!_write_glyf_and_loca_prime (plan, glyf, glyf_data,
-					     instruction_ranges,
-					     glyf_prime_size, glyf_prime_data,
-					     &loca_prime))) {
-    free (glyf_prime_data);
-    free (loca_prime.data);
-    instruction_ranges.fini ();
+					     &glyf_prime, loca_prime)))
+  {
+    free (glyf_prime.data);
+    free (loca_prime);
     return false;
   }
-  instruction_ranges.fini ();
-
-  *glyf_prime_blob = hb_blob_create (glyf_prime_data,
-                                     glyf_prime_size,
-                                     HB_MEMORY_MODE_READONLY,
-                                     glyf_prime_data,
-                                     free);
-  *loca_prime_blob = hb_blob_create ((char *) loca_prime.data,
-                                     loca_prime.size,
-                                     HB_MEMORY_MODE_READONLY,
-                                     loca_prime.data,
-                                     free);
+
+  bool is_short = glyf_prime.length <= 131070;
+  *use_short_loca = is_short;
+
+  if (plan->woff2_glyf_transform)
+  {
+    *glyf_prime_blob = _woff2_transform_glyf (glyf_prime, loca_prime,
+					      num_output_glyphs, is_short);
+    *loca_prime_blob = hb_blob_get_empty ();
+    free (glyf_prime.data);
+    free (loca_prime);
+    return *glyf_prime_blob != nullptr;
+  }
+
+  unsigned int loca_prime_size = num_entries * (is_short ? sizeof (OT::HBUINT16) : sizeof (OT::HBUINT32));
+  if (is_short)
+  {
+    /* Pack in place; entry i is read before any short entry overwrites it. */
+    OT::HBUINT16 *short_loca = (OT::HBUINT16 *) (void *) loca_prime;
+    for (unsigned int i = 0; i < num_entries; i++)
+      short_loca[i] = loca_prime[i] / 2;
+  }
+
+  DEBUG_MSG(SUBSET, nullptr, "subset glyf: final size %d, loca size %d, using %s loca",
+	    glyf_prime.length,
+	    loca_prime_size,
+	    is_short ? "short" : "long");
+
+  *glyf_prime_blob = hb_blob_create (glyf_prime.data,
+				     glyf_prime.length,
+				     HB_MEMORY_MODE_READONLY,
+				     glyf_prime.data,
+				     free);
+  *loca_prime_blob = hb_blob_create ((char *) loca_prime,
+				     loca_prime_size,
+				     HB_MEMORY_MODE_READONLY,
+				     loca_prime,
+				     free);
   return true;
 }
 
@@ -328,19 +720,19 @@ hb_subset_glyf_and_loca (hb_subset_plan_t *plan,
 			 hb_blob_t       **loca_prime /* OUT */)
 {
   hb_blob_t *glyf_blob = hb_sanitize_context_t ().reference_table<OT::glyf> (plan->source);
-  const char *glyf_data = hb_blob_get_data (glyf_blob, nullptr);
+  unsigned int glyf_length;
+  const char *glyf_data = hb_blob_get_data (glyf_blob, &glyf_length);
 
-  OT::glyf::accelerator_t glyf;
-  glyf.init (plan->source);
+  const OT::glyf::accelerator_t &glyf = *plan->source->table.glyf;
   bool result = _hb_subset_glyf_and_loca (glyf,
 					  glyf_data,
+					  glyf_length,
 					  plan,
 					  use_short_loca,
 					  glyf_prime,
 					  loca_prime);
 
   hb_blob_destroy (glyf_blob);
-  glyf.fini ();
 
   return result;
 }
@@ -49,6 +49,7 @@ hb_subset_input_create_or_fail ()
   input->drop_layout = true;
   input->desubroutinize = false;
   input->retain_gids = false;
+  input->woff2_glyf_transform = false;
 
   return input;
 }
@@ -179,3 +180,62 @@ hb_subset_input_get_retain_gids (hb_subset_input_t *subset_input)
 {
   return subset_input->retain_gids;
 }
+
+/**
+ * hb_subset_input_set_woff2_glyf_transform:
+ * @subset_input: a subset_input.
+ * @woff2_glyf_transform: If true the subsetter emits glyf in its WOFF2
+ * transformed form.
+ *
+ * Makes hb_subset() write the glyf table as the transformed glyf
+ * stream of WOFF2 (section 5.1 of the WOFF2 specification) and leave
+ * loca empty, ready to be compressed into a WOFF2 font as is.  The
+ * resulting face is only meant for a WOFF2 packer; it can't be used
+ * for rendering or shaping.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_subset_input_set_woff2_glyf_transform (hb_subset_input_t *subset_input,
+					  hb_bool_t          woff2_glyf_transform)
+{
+  subset_input->woff2_glyf_transform = woff2_glyf_transform;
+}
+
+/**
+ * hb_subset_input_get_woff2_glyf_transform:
+ * @subset_input: a subset_input.
+ *
+ * Returns: value of woff2_glyf_transform.
+ *
+ * Since: REPLACEME
+ **/
+hb_bool_t
+hb_subset_input_get_woff2_glyf_transform (hb_subset_input_t *subset_input)
+{
+  return subset_input->woff2_glyf_transform;
+}
+
+/**
+ * hb_subset_input_set_executor:
+ * @subset_input: a subset_input.
+ * @func: (nullable): executor to run table jobs on, or %NULL.
+ * @user_data: data to pass to @func.
+ *
+ * Makes hb_subset() subset the tables of the face as independent jobs
+ * run through @func, for example on a thread pool.  CFF tables are
+ * further split into jobs each covering a range of glyphs.  The
+ * resulting face is identical to the one produced without an executor.  Pass %NULL to
+ * subset tables one after the other on the calling thread, which is the
+ * default.
+ *
+ * Since: REPLACEME
+ **/
+void
+hb_subset_input_set_executor (hb_subset_input_t  *subset_input,
+			      hb_executor_func_t  func,
+			      void               *user_data)
+{
+  subset_input->executor_func = func;
+  subset_input->executor_data = user_data;
+}
@@ -34,6 +34,28 @@
 
 #include "hb-font.hh"
 
+/* Called at the beginning and end of each stage of hb_subset(), for
+ * profiling.  stage is one of the HB_SUBSET_STAGE_* values below, or the
+ * tag of the table being subset. */
+typedef void (*hb_subset_trace_func_t) (hb_tag_t stage, bool begin, void *user_data);
+
+#define HB_SUBSET_STAGE_PLAN		HB_TAG ('-','P','L','N')
+#define HB_SUBSET_STAGE_CMAP		HB_TAG ('-','C','M','P')
+#define HB_SUBSET_STAGE_GSUB_CLOSURE	HB_TAG ('-','C','L','O')
+#define HB_SUBSET_STAGE_COMPONENTS	HB_TAG ('-','C','O','M')
+#define HB_SUBSET_STAGE_REMOVE_INVALID	HB_TAG ('-','I','N','V')
+
+/* What each stage of plan creation did, for profiling.  Filled in when
+ * hb_subset_input_t::stats is set, and logged with DEBUG_MSG (SUBSET). */
+struct hb_subset_plan_stats_t
+{
+  unsigned int cmap_glyphs;		/* Glyphs added by the cmap lookup. */
+  unsigned int gsub_closure_glyphs;	/* Glyphs added by the GSUB closure. */
+  unsigned int gsub_closure_iterations;	/* Passes over the GSUB lookups. */
+  unsigned int component_glyphs;	/* Glyphs added for composites and seac. */
+  unsigned int invalid_glyphs;		/* Glyphs removed for being out of range. */
+};
+
 struct hb_subset_input_t
 {
   hb_object_header_t header;
@@ -46,6 +68,21 @@ struct hb_subset_input_t
   bool drop_layout : 1;
   bool desubroutinize : 1;
   bool retain_gids : 1;
+  bool woff2_glyf_transform : 1;
+
+  hb_executor_func_t executor_func;
+  void *executor_data;
+
+  hb_subset_trace_func_t trace_func;
+  void *trace_data;
+  hb_subset_plan_stats_t *stats;
+
+  void trace (hb_tag_t stage, bool begin) const
+  {
+    if (unlikely (trace_func))
+      trace_func (stage, begin, trace_data);
+  }
+
   /* TODO
    *
    * features
@@ -27,29 +27,47 @@
 #include "hb-subset-plan.hh"
 #include "hb-map.hh"
 #include "hb-set.hh"
+#include "hb-ot-layout.hh"
 
 #include "hb-ot-cmap-table.hh"
 #include "hb-ot-glyf-table.hh"
 #include "hb-ot-cff1-table.hh"
 
+/* Adds the components of composite glyphs in glyphs, transitively.  Walks
+ * glyphs in increasing order, adding to it as it goes, so that loca and
+ * glyf are read front to back; components past the walk are reached by the
+ * walk itself, and the few before it are expanded right away off a stack.
+ * Glyphs not in the font end the walk; they have no components. */
 static void
-_add_gid_and_children (const OT::glyf::accelerator_t &glyf,
-		       hb_codepoint_t gid,
-		       hb_set_t *gids_to_retain)
+_add_composite_components (const OT::glyf::accelerator_t &glyf,
+			   hb_set_t *glyphs,
+			   unsigned int num_glyphs)
 {
-  if (hb_set_has (gids_to_retain, gid))
-    // Already visited this gid, ignore.
-    return;
-
-  hb_set_add (gids_to_retain, gid);
-
-  OT::glyf::CompositeGlyphHeader::Iterator composite;
-  if (glyf.get_composite (gid, &composite))
+  hb_vector_t<hb_codepoint_t> stack;
+  hb_codepoint_t gid = HB_SET_VALUE_INVALID;
+  while (glyphs->next (&gid) && gid < num_glyphs)
   {
-    do
+    hb_codepoint_t current = gid;
+    for (;;)
     {
-      _add_gid_and_children (glyf, (hb_codepoint_t) composite.current->glyphIndex, gids_to_retain);
-    } while (composite.move_to_next());
+      OT::glyf::CompositeGlyphHeader::Iterator composite;
+      if (glyf.get_composite (current, &composite))
+      {
+	do
+	{
+	  hb_codepoint_t component = composite.current->glyphIndex;
+	  if (glyphs->has (component))
+	    continue;
+	  glyphs->add (component);
+	  if (component < gid)
+	    stack.push (component);
+	} while (composite.move_to_next ());
+      }
+
+      if (!stack.length)
+	break;
+      current = stack.pop ();
+    }
   }
 }
 
@@ -66,8 +84,8 @@ _add_cff_seac_components (const OT::cff1::accelerator_t &cff,
   }
 }
 
-static void
-_gsub_closure (hb_face_t *face, hb_set_t *gids_to_retain)
+static unsigned int
+_gsub_closure (const hb_subset_input_t *input, hb_face_t *face, hb_set_t *gids_to_retain)
 {
   hb_set_t lookup_indices;
   hb_ot_layout_collect_lookups (face,
@@ -76,92 +94,198 @@ _gsub_closure (hb_face_t *face, hb_set_t *gids_to_retain)
 				nullptr,
 				nullptr,
 				&lookup_indices);
-  hb_ot_layout_lookups_substitute_closure (face,
-					   &lookup_indices,
-					   gids_to_retain);
+  return hb_ot_layout_lookups_substitute_closure_count (face,
+							&lookup_indices,
+							gids_to_retain,
+							input->executor_func,
+							input->executor_data);
 }
 
-static void
+static unsigned int
 _remove_invalid_gids (hb_set_t *glyphs,
 		      unsigned int num_glyphs)
 {
-  hb_codepoint_t gid = HB_SET_VALUE_INVALID;
-  while (glyphs->next (&gid))
+  unsigned int population = glyphs->get_population ();
+  glyphs->del_range (num_glyphs, HB_SET_VALUE_INVALID - 1);
+  return population - glyphs->get_population ();
+}
+
+/* Merge-joins the requested unicodes with the font's sorted cmap
+ * mappings, galloping ahead in the mappings so that small requests on
+ * large fonts stay cheap. */
+static void
+_add_mapped_unicodes (const hb_vector_t<OT::cmap::accelerator_t::mapping_t> &mappings,
+		      const hb_set_t *unicodes,
+		      hb_set_t *unicodes_to_retain,
+		      hb_map_t *codepoint_to_glyph,
+		      hb_set_t *gids_to_retain)
+{
+  unsigned int count = mappings.length;
+  unsigned int i = 0;
+  hb_codepoint_t batch[256];
+  hb_codepoint_t cp = HB_SET_VALUE_INVALID;
+  unsigned int n;
+  while (i < count && (n = unicodes->next_many (cp, batch, ARRAY_LENGTH (batch))))
   {
-    if (gid >= num_glyphs)
-      glyphs->del (gid);
+    for (unsigned int k = 0; k < n && i < count; k++)
+    {
+      cp = batch[k];
+      if (mappings[i].unicode < cp)
+      {
+	/* Find the first mapping at or after cp. */
+	unsigned int step = 1, lo = i, hi = i + 1;
+	while (hi < count && mappings[hi].unicode < cp)
+	{
+	  lo = hi;
+	  step *= 2;
+	  hi = hb_min (count, lo + step);
+	}
+	while (lo + 1 < hi)
+	{
+	  unsigned int mid = lo + (hi - lo) / 2;
+	  if (mappings[mid].unicode < cp) lo = mid; else hi = mid;
+	}
+	i = hi;
+	if (i == count) break;
+      }
+
+      if (mappings[i].unicode != cp)
+      {
+	DEBUG_MSG(SUBSET, nullptr, "Drop U+%04X; no gid", cp);
+	continue;
+      }
+      unicodes_to_retain->add (cp);
+      codepoint_to_glyph->set (cp, mappings[i].glyph);
+      gids_to_retain->add (mappings[i].glyph);
+      i++;
+    }
+    cp = batch[n - 1];
   }
 }
 
 static hb_set_t *
-_populate_gids_to_retain (hb_face_t *face,
+_populate_gids_to_retain (const hb_subset_input_t *input,
+			  hb_face_t *face,
 			  const hb_set_t *unicodes,
                           const hb_set_t *input_glyphs_to_retain,
 			  bool close_over_gsub,
 			  hb_set_t *unicodes_to_retain,
 			  hb_map_t *codepoint_to_glyph)
 {
-  OT::cmap::accelerator_t cmap;
-  OT::glyf::accelerator_t glyf;
-  OT::cff1::accelerator_t cff;
-  cmap.init (face);
-  glyf.init (face);
-  cff.init (face);
+  /* Use the face's own accelerators, so that subsetting the same face
+   * repeatedly doesn't parse these tables again every time. */
+  const OT::cmap::accelerator_t &cmap = *face->table.cmap;
+  const OT::glyf::accelerator_t &glyf = *face->table.glyf;
+  const OT::cff1::accelerator_t &cff = *face->table.cff1;
+
+  hb_subset_plan_stats_t stats = {};
 
   hb_set_t *initial_gids_to_retain = hb_set_create ();
   initial_gids_to_retain->add (0); // Not-def
   hb_set_union (initial_gids_to_retain, input_glyphs_to_retain);
+  unsigned int population = initial_gids_to_retain->get_population ();
 
-  hb_codepoint_t cp = HB_SET_VALUE_INVALID;
-  while (unicodes->next (&cp))
+  input->trace (HB_SUBSET_STAGE_CMAP, true);
+  const hb_vector_t<OT::cmap::accelerator_t::mapping_t> *mappings = cmap.get_mappings ();
+  if (likely (mappings))
+    _add_mapped_unicodes (*mappings, unicodes,
+			  unicodes_to_retain, codepoint_to_glyph, initial_gids_to_retain);
+  else
   {
-    hb_codepoint_t gid;
-    if (!cmap.get_nominal_glyph (cp, &gid))
+    hb_codepoint_t cp = HB_SET_VALUE_INVALID;
+    while (unicodes->next (&cp))
     {
-      DEBUG_MSG(SUBSET, nullptr, "Drop U+%04X; no gid", cp);
-      continue;
+      hb_codepoint_t gid;
+      if (!cmap.get_nominal_glyph (cp, &gid))
+      {
+	DEBUG_MSG(SUBSET, nullptr, "Drop U+%04X; no gid", cp);
+	continue;
+      }
+      unicodes_to_retain->add (cp);
+      codepoint_to_glyph->set (cp, gid);
+      initial_gids_to_retain->add (gid);
     }
-    unicodes_to_retain->add (cp);
-    codepoint_to_glyph->set (cp, gid);
-    initial_gids_to_retain->add (gid);
   }
+  input->trace (HB_SUBSET_STAGE_CMAP, false);
+  stats.cmap_glyphs = initial_gids_to_retain->get_population () - population;
+  population = initial_gids_to_retain->get_population ();
 
   if (close_over_gsub)
+  {
     // Add all glyphs needed for GSUB substitutions.
-    _gsub_closure (face, initial_gids_to_retain);
+    input->trace (HB_SUBSET_STAGE_GSUB_CLOSURE, true);
+    stats.gsub_closure_iterations = _gsub_closure (input, face, initial_gids_to_retain);
+    input->trace (HB_SUBSET_STAGE_GSUB_CLOSURE, false);
+    stats.gsub_closure_glyphs = initial_gids_to_retain->get_population () - population;
+    population = initial_gids_to_retain->get_population ();
+  }
 
   // Populate a full set of glyphs to retain by adding all referenced
   // composite glyphs.
-  hb_codepoint_t gid = HB_SET_VALUE_INVALID;
-  hb_set_t *all_gids_to_retain = hb_set_create ();
-  while (initial_gids_to_retain->next (&gid))
+  input->trace (HB_SUBSET_STAGE_COMPONENTS, true);
+  if (cff.is_valid ())
   {
-    _add_gid_and_children (glyf, gid, all_gids_to_retain);
-    if (cff.is_valid ())
-      _add_cff_seac_components (cff, gid, all_gids_to_retain);
+    hb_set_t seac_components;
+    hb_codepoint_t gid = HB_SET_VALUE_INVALID;
+    while (initial_gids_to_retain->next (&gid))
+      _add_cff_seac_components (cff, gid, &seac_components);
+    initial_gids_to_retain->union_ (&seac_components);
   }
-  hb_set_destroy (initial_gids_to_retain);
+  // Closed over in place.
+  hb_set_t *all_gids_to_retain = initial_gids_to_retain;
+  _add_composite_components (glyf, all_gids_to_retain, face->get_num_glyphs ());
+  input->trace (HB_SUBSET_STAGE_COMPONENTS, false);
+  stats.component_glyphs = all_gids_to_retain->get_population () - population;
 
-  _remove_invalid_gids (all_gids_to_retain, face->get_num_glyphs ());
+  input->trace (HB_SUBSET_STAGE_REMOVE_INVALID, true);
+  stats.invalid_glyphs = _remove_invalid_gids (all_gids_to_retain, face->get_num_glyphs ());
+  input->trace (HB_SUBSET_STAGE_REMOVE_INVALID, false);
 
-
-  cff.fini ();
-  glyf.fini ();
-  cmap.fini ();
+  DEBUG_MSG (SUBSET, nullptr,
+	     "plan-stats cmap_glyphs=%u gsub_closure_glyphs=%u gsub_closure_iterations=%u "
+	     "component_glyphs=%u invalid_glyphs=%u",
+	     stats.cmap_glyphs, stats.gsub_closure_glyphs, stats.gsub_closure_iterations,
+	     stats.component_glyphs, stats.invalid_glyphs);
+  if (input->stats)
+    *input->stats = stats;
 
   return all_gids_to_retain;
 }
 
+static hb_glyph_map_t *
+_glyph_map_create ()
+{
+  hb_glyph_map_t *map = (hb_glyph_map_t *) calloc (1, sizeof (hb_glyph_map_t));
+  if (likely (map))
+    map->init ();
+  return map;
+}
+
+static void
+_glyph_map_destroy (hb_glyph_map_t *map)
+{
+  if (!map) return;
+  map->fini ();
+  free (map);
+}
+
 static void
 _create_old_gid_to_new_gid_map (const hb_face_t                   *face,
                                 bool                               retain_gids,
 				hb_set_t                          *all_gids_to_retain,
-                                hb_map_t                          *glyph_map, /* OUT */
-                                hb_map_t                          *reverse_glyph_map, /* OUT */
+                                hb_glyph_map_t                    *glyph_map, /* OUT */
+                                hb_glyph_map_t                    *reverse_glyph_map, /* OUT */
                                 unsigned int                      *num_glyphs /* OUT */)
 {
   hb_codepoint_t gid = HB_SET_VALUE_INVALID;
   unsigned int length = 0;
+  if (!all_gids_to_retain->is_empty ())
+  {
+    glyph_map->alloc (all_gids_to_retain->get_max () + 1);
+    reverse_glyph_map->alloc (retain_gids
+			      ? all_gids_to_retain->get_max () + 1
+			      : all_gids_to_retain->get_population ());
+  }
   for (unsigned int i = 0; all_gids_to_retain->next (&gid); i++) {
     if (!retain_gids)
     {
@@ -205,6 +329,9 @@ hb_subset_plan_create (hb_face_t           *face,
   plan->drop_layout = input->drop_layout;
   plan->desubroutinize = input->desubroutinize;
   plan->retain_gids = input->retain_gids;
+  plan->woff2_glyf_transform = input->woff2_glyf_transform;
+  plan->executor_func = nullptr;
+  plan->executor_data = nullptr;
   plan->unicodes = hb_set_create ();
   plan->name_ids = hb_set_reference (input->name_ids);
   /* TODO Clean this up... */
@@ -213,9 +340,10 @@ hb_subset_plan_create (hb_face_t           *face,
   plan->source = hb_face_reference (face);
   plan->dest = hb_face_builder_create ();
   plan->codepoint_to_glyph = hb_map_create ();
-  plan->glyph_map = hb_map_create ();
-  plan->reverse_glyph_map = hb_map_create ();
-  plan->_glyphset = _populate_gids_to_retain (face,
+  plan->glyph_map = _glyph_map_create ();
+  plan->reverse_glyph_map = _glyph_map_create ();
+  plan->_glyphset = _populate_gids_to_retain (input,
+                                              face,
                                               input->unicodes,
                                               input->glyphs,
                                               !plan->drop_layout,
@@ -247,8 +375,8 @@ hb_subset_plan_destroy (hb_subset_plan_t *plan)
   hb_face_destroy (plan->source);
   hb_face_destroy (plan->dest);
   hb_map_destroy (plan->codepoint_to_glyph);
-  hb_map_destroy (plan->glyph_map);
-  hb_map_destroy (plan->reverse_glyph_map);
+  _glyph_map_destroy (plan->glyph_map);
+  _glyph_map_destroy (plan->reverse_glyph_map);
   hb_set_destroy (plan->_glyphset);
 
   free (plan);
@@ -35,6 +35,11 @@
 #include "hb-map.hh"
 #include "hb-set.hh"
 
+/* Output glyphs per job when a table is split across the executor. */
+#ifndef HB_SUBSET_GLYPHS_PER_JOB
+#define HB_SUBSET_GLYPHS_PER_JOB 256
+#endif
+
 struct hb_subset_plan_t
 {
   hb_object_header_t header;
@@ -43,6 +48,7 @@ struct hb_subset_plan_t
   bool drop_layout : 1;
   bool desubroutinize : 1;
   bool retain_gids : 1;
+  bool woff2_glyf_transform : 1;
 
   // For each cp that we'd like to retain maps to the corresponding gid.
   hb_set_t *unicodes;
@@ -54,8 +60,8 @@ struct hb_subset_plan_t
   hb_map_t *codepoint_to_glyph;
 
   // Old -> New glyph id mapping
-  hb_map_t *glyph_map;
-  hb_map_t *reverse_glyph_map;
+  hb_glyph_map_t *glyph_map;
+  hb_glyph_map_t *reverse_glyph_map;
 
   // Plan is only good for a specific source/dest so keep them with it
   hb_face_t *source;
@@ -64,6 +70,10 @@ struct hb_subset_plan_t
   unsigned int _num_output_glyphs;
   hb_set_t *_glyphset;
 
+  /* Only set while a table may split itself into glyph jobs. */
+  hb_executor_func_t executor_func;
+  void *executor_data;
+
  public:
 
   /*
@@ -125,6 +135,41 @@ struct hb_subset_plan_t
     return true;
   }
 
+  /*
+   * Number of jobs for_each_glyph_range() makes; one without an executor.
+   */
+  unsigned int
+  get_num_glyph_jobs (unsigned int glyphs_per_job = HB_SUBSET_GLYPHS_PER_JOB) const
+  {
+    if (!executor_func)
+      return 1;
+    return hb_max (1u, (num_output_glyphs () + glyphs_per_job - 1) / glyphs_per_job);
+  }
+
+  /*
+   * Calls func (start, end) for consecutive ranges of glyphs_per_job
+   * output glyph ids covering all of them.  With an executor, each range
+   * is a job of its own, so func must only write to per-glyph or per-range
+   * state.  Returns false if any call did.
+   */
+  template <typename Func>
+  bool for_each_glyph_range (const Func &func,
+			     unsigned int glyphs_per_job = HB_SUBSET_GLYPHS_PER_JOB) const
+  {
+    unsigned int num_glyphs = num_output_glyphs ();
+    unsigned int num_jobs = get_num_glyph_jobs (glyphs_per_job);
+    if (num_jobs < 2)
+      return func (0u, num_glyphs);
+
+    glyph_jobs_t<Func> jobs;
+    jobs.func = &func;
+    jobs.num_glyphs = num_glyphs;
+    jobs.glyphs_per_job = glyphs_per_job;
+    jobs.failed.set_relaxed (false);
+    executor_func (num_jobs, glyph_jobs_t<Func>::run, &jobs, executor_data);
+    return !jobs.failed.get_relaxed ();
+  }
+
   inline bool
   add_table (hb_tag_t tag,
 	     hb_blob_t *contents)
@@ -137,6 +182,25 @@ struct hb_subset_plan_t
     hb_blob_destroy (source_blob);
     return hb_face_builder_add_table (dest, tag, contents);
   }
+
+ private:
+  template <typename Func>
+  struct glyph_jobs_t
+  {
+    static void run (unsigned int index, void *job_data)
+    {
+      glyph_jobs_t *jobs = (glyph_jobs_t *) job_data;
+      unsigned int start = index * jobs->glyphs_per_job;
+      unsigned int end = hb_min (start + jobs->glyphs_per_job, jobs->num_glyphs);
+      if (!(*jobs->func) (start, end))
+	jobs->failed.set_relaxed (true);
+    }
+
+    const Func *func;
+    unsigned int num_glyphs;
+    unsigned int glyphs_per_job;
+    hb_atomic_int_t failed;
+  };
 };
 
 typedef struct hb_subset_plan_t hb_subset_plan_t;
@@ -47,6 +47,27 @@
 #include "hb-ot-layout-gsub-table.hh"
 #include "hb-ot-layout-gpos-table.hh"
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif /* HAVE_SYS_MMAN_H */
+
+#ifndef MAP_NORESERVE
+# define MAP_NORESERVE 0
+#endif
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+# define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* Serializer buffers are reserved this many times the source table size,
+ * so that a table fits on the first try and is serialized only once.
+ * Large reservations are mapped and only take memory as they are used. */
+#ifndef HB_SUBSET_RESERVE_FACTOR
+#define HB_SUBSET_RESERVE_FACTOR 8
+#endif
+#ifndef HB_SUBSET_MAP_THRESHOLD
+#define HB_SUBSET_MAP_THRESHOLD (1u << 20)
+#endif
+
 
 HB_UNUSED static inline unsigned int
 _plan_estimate_subset_table_size (hb_subset_plan_t *plan,
@@ -64,6 +85,64 @@ _plan_estimate_subset_table_size (hb_subset_plan_t *plan,
   return 512 + (unsigned int) (table_len * sqrt ((double) dst_glyphs / src_glyphs));
 }
 
+struct hb_subset_buffer_t
+{
+  hb_subset_buffer_t () : data (nullptr), size (0), mapped (false) {}
+  ~hb_subset_buffer_t () { fini (); }
+
+  void fini ()
+  {
+#if defined(HAVE_MMAP) && defined(MAP_ANONYMOUS) && !defined(HB_NO_MMAP)
+    if (mapped)
+      munmap (data, size);
+    else
+#endif
+      free (data);
+    data = nullptr;
+    size = 0;
+    mapped = false;
+  }
+
+  bool reserve (size_t new_size)
+  {
+    fini ();
+#if defined(HAVE_MMAP) && defined(MAP_ANONYMOUS) && !defined(HB_NO_MMAP)
+    /* Only where address space is plentiful. */
+    if (sizeof (void *) >= 8 && new_size >= HB_SUBSET_MAP_THRESHOLD)
+    {
+      void *p = mmap (nullptr, new_size, PROT_READ | PROT_WRITE,
+		      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (p != MAP_FAILED)
+      {
+	data = (char *) p;
+	size = new_size;
+	mapped = true;
+	return true;
+      }
+    }
+#endif
+    data = (char *) malloc (new_size);
+    if (unlikely (!data))
+      return false;
+    size = new_size;
+    return true;
+  }
+
+  char *data;
+  size_t size;
+  bool mapped;
+};
+
+static inline size_t
+_plan_reserve_subset_table_size (hb_subset_plan_t *plan,
+				 unsigned int table_len)
+{
+  size_t estimate = _plan_estimate_subset_table_size (plan, table_len);
+  if (sizeof (size_t) < 8)
+    return estimate;
+  return hb_max (estimate, (size_t) 512 + (size_t) table_len * HB_SUBSET_RESERVE_FACTOR);
+}
+
 template<typename TableType>
 static bool
 _subset2 (hb_subset_plan_t *plan)
@@ -75,28 +154,29 @@ _subset2 (hb_subset_plan_t *plan)
   hb_tag_t tag = TableType::tableTag;
   if (source_blob->data)
   {
-    hb_vector_t<char> buf;
+    hb_subset_buffer_t buf;
     /* TODO Not all tables are glyph-related.  'name' table size for example should not be
      * affected by number of glyphs.  Accommodate that. */
-    unsigned int buf_size = _plan_estimate_subset_table_size (plan, source_blob->length);
-    DEBUG_MSG(SUBSET, nullptr, "OT::%c%c%c%c initial estimated table size: %u bytes.", HB_UNTAG (tag), buf_size);
-    if (unlikely (!buf.alloc (buf_size)))
+    size_t buf_size = _plan_reserve_subset_table_size (plan, source_blob->length);
+    DEBUG_MSG(SUBSET, nullptr, "OT::%c%c%c%c initial reserved table size: %zu bytes.", HB_UNTAG (tag), buf_size);
+    if (unlikely (buf_size > (unsigned int) -1 || !buf.reserve (buf_size)))
     {
-      DEBUG_MSG(SUBSET, nullptr, "OT::%c%c%c%c failed to allocate %u bytes.", HB_UNTAG (tag), buf_size);
+      DEBUG_MSG(SUBSET, nullptr, "OT::%c%c%c%c failed to allocate %zu bytes.", HB_UNTAG (tag), buf_size);
       return false;
     }
   retry:
-    hb_serialize_context_t serializer ((void *) buf, buf_size);
+    hb_serialize_context_t serializer ((void *) buf.data, buf_size);
     serializer.start_serialize<TableType> ();
     hb_subset_context_t c (plan, &serializer);
     bool needed = table->subset (&c);
     if (serializer.ran_out_of_room)
     {
+      /* Only if the reservation was not enough. */
       buf_size += (buf_size >> 1) + 32;
-      DEBUG_MSG(SUBSET, nullptr, "OT::%c%c%c%c ran out of room; reallocating to %u bytes.", HB_UNTAG (tag), buf_size);
-      if (unlikely (!buf.alloc (buf_size)))
+      DEBUG_MSG(SUBSET, nullptr, "OT::%c%c%c%c ran out of room; reallocating to %zu bytes.", HB_UNTAG (tag), buf_size);
+      if (unlikely (buf_size > (unsigned int) -1 || !buf.reserve (buf_size)))
       {
-	DEBUG_MSG(SUBSET, nullptr, "OT::%c%c%c%c failed to reallocate %u bytes.", HB_UNTAG (tag), buf_size);
+	DEBUG_MSG(SUBSET, nullptr, "OT::%c%c%c%c failed to reallocate %zu bytes.", HB_UNTAG (tag), buf_size);
 	return false;
       }
       goto retry;
@@ -277,6 +357,107 @@ _should_drop_table (hb_subset_plan_t *plan, hb_tag_t tag)
   }
 }
 
+/* Tables whose subsetting splits itself into glyph jobs. */
+static bool
+_splits_into_glyph_jobs (hb_tag_t tag)
+{
+  switch (tag)
+  {
+    case HB_OT_TAG_cff1:
+    case HB_OT_TAG_cff2:
+      return true;
+    default:
+      return false;
+  }
+}
+
+struct hb_subset_jobs_t
+{
+  struct job_t
+  {
+    hb_tag_t tag;
+    hb_subset_plan_t plan; /* Copy of the main plan, with its own dest. */
+    bool deferred; /* Run on the calling thread after the others. */
+    bool success;
+  };
+
+  static void
+  run (unsigned int index, void *job_data)
+  {
+    hb_subset_jobs_t *jobs = (hb_subset_jobs_t *) job_data;
+    job_t &job = jobs->jobs[index];
+    if (!job.deferred)
+      jobs->run_job (&job);
+  }
+
+  void
+  run_job (job_t *job) const
+  {
+    if (unlikely (hb_object_is_inert (job->plan.dest)))
+      return;
+    input->trace (job->tag, true);
+    job->success = _subset_table (&job->plan, job->tag);
+    input->trace (job->tag, false);
+  }
+
+  const hb_subset_input_t *input;
+  hb_vector_t<job_t> jobs;
+};
+
+/* Subsets each table as a separate job on the input's executor, each
+ * into its own face-builder, then collects the results in the order
+ * the tables would have been added had they been subset serially.
+ * Tables that make glyph jobs of their own are subset afterwards, on
+ * this thread, so the executor is never called from one of its jobs. */
+static bool
+_subset_tables_with_executor (hb_subset_plan_t        *plan,
+			      const hb_subset_input_t *input,
+			      const hb_tag_t          *tags,
+			      unsigned int             count)
+{
+  hb_subset_jobs_t jobs;
+  jobs.input = input;
+  jobs.jobs.init ();
+  if (unlikely (!jobs.jobs.alloc (count)))
+    return false;
+
+  for (unsigned int i = 0; i < count; i++)
+  {
+    hb_subset_jobs_t::job_t *job = jobs.jobs.push ();
+    job->tag = tags[i];
+    job->plan = *plan;
+    job->plan.dest = hb_face_builder_create ();
+    job->deferred = _splits_into_glyph_jobs (tags[i]);
+    if (job->deferred)
+    {
+      job->plan.executor_func = input->executor_func;
+      job->plan.executor_data = input->executor_data;
+    }
+    job->success = false;
+  }
+
+  /* Precompute lazily-cached values that jobs would otherwise race on. */
+  plan->unicodes->get_population ();
+  plan->_glyphset->get_population ();
+
+  input->executor_func (jobs.jobs.length, hb_subset_jobs_t::run, &jobs, input->executor_data);
+  for (unsigned int i = 0; i < jobs.jobs.length; i++)
+    if (jobs.jobs[i].deferred)
+      jobs.run_job (&jobs.jobs[i]);
+
+  bool success = true;
+  for (unsigned int i = 0; i < jobs.jobs.length; i++)
+  {
+    hb_subset_jobs_t::job_t &job = jobs.jobs[i];
+    success = success && job.success &&
+	      hb_face_builder_append_tables (plan->dest, job.plan.dest);
+    hb_face_destroy (job.plan.dest);
+  }
+  jobs.jobs.fini ();
+
+  return success;
+}
+
 /**
  * hb_subset:
  * @source: font face data to be subset.
@@ -290,7 +471,12 @@ hb_subset (hb_face_t *source,
 {
   if (unlikely (!input || !source)) return hb_face_get_empty ();
 
+  input->trace (HB_SUBSET_STAGE_PLAN, true);
   hb_subset_plan_t *plan = hb_subset_plan_create (source, input);
+  input->trace (HB_SUBSET_STAGE_PLAN, false);
+
+  hb_vector_t<hb_tag_t> job_tags;
+  job_tags.init ();
 
   hb_tag_t table_tags[32];
   unsigned int offset = 0, count;
@@ -306,11 +492,23 @@ hb_subset (hb_face_t *source,
 	DEBUG_MSG(SUBSET, nullptr, "drop %c%c%c%c", HB_UNTAG (tag));
 	continue;
       }
+      if (input->executor_func)
+      {
+	job_tags.push (tag);
+	continue;
+      }
+      input->trace (tag, true);
       success = success && _subset_table (plan, tag);
+      input->trace (tag, false);
     }
     offset += count;
   } while (success && count == ARRAY_LENGTH (table_tags));
 
+  if (input->executor_func)
+    success = !job_tags.in_error () &&
+	      _subset_tables_with_executor (plan, input, job_tags.arrayZ (), job_tags.length);
+  job_tags.fini ();
+
   hb_face_t *result = success ? hb_face_reference (plan->dest) : hb_face_get_empty ();
   hb_subset_plan_destroy (plan);
   return result;
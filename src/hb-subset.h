@@ -81,6 +81,17 @@ hb_subset_input_set_retain_gids (hb_subset_input_t *subset_input,
 HB_EXTERN hb_bool_t
 hb_subset_input_get_retain_gids (hb_subset_input_t *subset_input);
 
+HB_EXTERN void
+hb_subset_input_set_woff2_glyf_transform (hb_subset_input_t *subset_input,
+					  hb_bool_t          woff2_glyf_transform);
+HB_EXTERN hb_bool_t
+hb_subset_input_get_woff2_glyf_transform (hb_subset_input_t *subset_input);
+
+HB_EXTERN void
+hb_subset_input_set_executor (hb_subset_input_t  *subset_input,
+			      hb_executor_func_t  func,
+			      void               *user_data);
+
 /* hb_subset () */
 HB_EXTERN hb_face_t *
 hb_subset (hb_face_t *source, hb_subset_input_t *input);
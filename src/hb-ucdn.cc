@@ -17,6 +17,7 @@
 #include "hb.hh"
 
 #include "hb-machinery.hh"
+#include "hb-unicode.hh"
 
 #include "ucdn.h"
 
@@ -225,6 +226,75 @@ hb_ucdn_decompose(hb_unicode_funcs_t *ufuncs HB_UNUSED,
     return ucdn_decompose(ab, a, b);
 }
 
+static void
+hb_ucdn_combining_class_batch(hb_unicode_funcs_t *ufuncs HB_UNUSED,
+			      unsigned int count,
+			      const hb_codepoint_t *first_unicode,
+			      unsigned int unicode_stride,
+			      hb_unicode_combining_class_t *first_class,
+			      unsigned int class_stride,
+			      void *user_data HB_UNUSED)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+	*first_class = (hb_unicode_combining_class_t) ucdn_get_combining_class(*first_unicode);
+	first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+	first_class = &StructAtOffsetUnaligned<hb_unicode_combining_class_t> (first_class, class_stride);
+    }
+}
+
+static void
+hb_ucdn_general_category_batch(hb_unicode_funcs_t *ufuncs HB_UNUSED,
+			       unsigned int count,
+			       const hb_codepoint_t *first_unicode,
+			       unsigned int unicode_stride,
+			       hb_unicode_general_category_t *first_category,
+			       unsigned int category_stride,
+			       void *user_data HB_UNUSED)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+	*first_category = (hb_unicode_general_category_t) ucdn_get_general_category(*first_unicode);
+	first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+	first_category = &StructAtOffsetUnaligned<hb_unicode_general_category_t> (first_category, category_stride);
+    }
+}
+
+static void
+hb_ucdn_script_batch(hb_unicode_funcs_t *ufuncs HB_UNUSED,
+		     unsigned int count,
+		     const hb_codepoint_t *first_unicode,
+		     unsigned int unicode_stride,
+		     hb_script_t *first_script,
+		     unsigned int script_stride,
+		     void *user_data HB_UNUSED)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+	*first_script = ucdn_script_translate[ucdn_get_script(*first_unicode)];
+	first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+	first_script = &StructAtOffsetUnaligned<hb_script_t> (first_script, script_stride);
+    }
+}
+
+
+static void
+hb_ucdn_get_props (const hb_codepoint_t *unicodes,
+		   unsigned int          stride,
+		   unsigned int          count,
+		   hb_unicode_props_t   *props)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+	int category, combining, script;
+	ucdn_get_properties (*unicodes, &category, &combining, &script);
+	props[i].script = ucdn_script_translate[script];
+	props[i].general_category = category;
+	props[i].combining_class = combining;
+	unicodes = &StructAtOffsetUnaligned<hb_codepoint_t> (unicodes, stride);
+    }
+}
+
 
 #if HB_USE_ATEXIT
 static void free_static_ucdn_funcs ();
@@ -242,6 +312,11 @@ static struct hb_ucdn_unicode_funcs_lazy_loader_t : hb_unicode_funcs_lazy_loader
     hb_unicode_funcs_set_script_func (funcs, hb_ucdn_script, nullptr, nullptr);
     hb_unicode_funcs_set_compose_func (funcs, hb_ucdn_compose, nullptr, nullptr);
     hb_unicode_funcs_set_decompose_func (funcs, hb_ucdn_decompose, nullptr, nullptr);
+    hb_unicode_funcs_set_combining_class_batch_func (funcs, hb_ucdn_combining_class_batch, nullptr, nullptr);
+    hb_unicode_funcs_set_general_category_batch_func (funcs, hb_ucdn_general_category_batch, nullptr, nullptr);
+    hb_unicode_funcs_set_script_batch_func (funcs, hb_ucdn_script_batch, nullptr, nullptr);
+    /* Last, as setting callbacks drops it. */
+    funcs->get_props_func = hb_ucdn_get_props;
 
     hb_unicode_funcs_make_immutable (funcs);
 
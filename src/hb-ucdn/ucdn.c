@@ -227,6 +227,16 @@ int ucdn_get_script(uint32_t code)
     return get_ucd_record(code)->script;
 }
 
+void ucdn_get_properties(uint32_t code, int *category, int *combining,
+        int *script)
+{
+    const UCDRecord *record = get_ucd_record(code);
+
+    *category = record->category;
+    *combining = record->combining;
+    *script = record->script;
+}
+
 int ucdn_get_linebreak_class(uint32_t code)
 {
     return get_ucd_record(code)->linebreak_class;
@@ -390,6 +390,18 @@ int ucdn_get_linebreak_class(uint32_t code);
  */
 int ucdn_get_resolved_linebreak_class(uint32_t code);
 
+/**
+ * Get general category, combining class and script of a codepoint
+ * with a single database lookup.
+ *
+ * @param code Unicode codepoint
+ * @param category output UCDN_GENERAL_CATEGORY_* value
+ * @param combining output canonical combining class
+ * @param script output UCDN_SCRIPT_* value
+ */
+void ucdn_get_properties(uint32_t code, int *category, int *combining,
+        int *script);
+
 /**
  * Check if codepoint can be mirrored.
  *
@@ -30,7 +30,9 @@
 
 #include "hb.hh"
 
+#include "hb-machinery.hh"
 #include "hb-unicode.hh"
+#include "hb-utf.hh"
 
 
 /**
@@ -122,6 +124,27 @@ hb_unicode_decompose_compatibility_nil (hb_unicode_funcs_t *ufuncs     HB_UNUSED
   return 0;
 }
 
+/* The default batch callbacks call the simple ones for each codepoint. */
+#define HB_UNICODE_FUNC_IMPLEMENT(return_type, name) \
+static void \
+hb_unicode_##name##_batch_nil (hb_unicode_funcs_t   *ufuncs, \
+			       unsigned int          count, \
+			       const hb_codepoint_t *first_unicode, \
+			       unsigned int          unicode_stride, \
+			       return_type          *first_result, \
+			       unsigned int          result_stride, \
+			       void                 *user_data HB_UNUSED) \
+{ \
+  for (unsigned int i = 0; i < count; i++) \
+  { \
+    *first_result = ufuncs->name (*first_unicode); \
+    first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride); \
+    first_result = &StructAtOffsetUnaligned<return_type> (first_result, result_stride); \
+  } \
+}
+HB_UNICODE_FUNCS_IMPLEMENT_CALLBACKS_BATCH
+#undef HB_UNICODE_FUNC_IMPLEMENT
+
 
 extern "C" hb_unicode_funcs_t *hb_glib_get_unicode_funcs ();
 extern "C" hb_unicode_funcs_t *hb_icu_get_unicode_funcs ();
@@ -177,6 +200,7 @@ hb_unicode_funcs_create (hb_unicode_funcs_t *parent)
    * onto it and it's immutable.  We should not copy the destroy notifiers
    * though. */
   ufuncs->user_data = parent->user_data;
+  ufuncs->get_props_func = parent->get_props_func;
 
   return ufuncs;
 }
@@ -341,6 +365,24 @@ hb_unicode_funcs_get_parent (hb_unicode_funcs_t *ufuncs)
 }
 
 
+/* Replacing a simple callback resets its batch version: to the default,
+ * which calls the new callback, or to the parent's along with it. */
+template <typename func_t>
+static inline void
+hb_unicode_funcs_reset_batch_func (hb_unicode_funcs_t *ufuncs HB_UNUSED,
+				   func_t              func HB_UNUSED) {}
+#define HB_UNICODE_FUNC_IMPLEMENT(return_type, name) \
+static inline void \
+hb_unicode_funcs_reset_batch_func (hb_unicode_funcs_t            *ufuncs, \
+				   hb_unicode_##name##_func_t     func) \
+{ \
+  hb_unicode_funcs_set_##name##_batch_func (ufuncs, \
+					    func ? hb_unicode_##name##_batch_nil : nullptr, \
+					    nullptr, nullptr); \
+}
+HB_UNICODE_FUNCS_IMPLEMENT_CALLBACKS_BATCH
+#undef HB_UNICODE_FUNC_IMPLEMENT
+
 #define HB_UNICODE_FUNC_IMPLEMENT(name)						\
 										\
 void										\
@@ -355,6 +397,9 @@ hb_unicode_funcs_set_##name##_func (hb_unicode_funcs_t		   *ufuncs,	\
   if (ufuncs->destroy.name)							\
     ufuncs->destroy.name (ufuncs->user_data.name);				\
 										\
+  /* The single-lookup hook no longer matches the callbacks. */		\
+  ufuncs->get_props_func = nullptr;						\
+										\
   if (func) {									\
     ufuncs->func.name = func;							\
     ufuncs->user_data.name = user_data;						\
@@ -364,6 +409,8 @@ hb_unicode_funcs_set_##name##_func (hb_unicode_funcs_t		   *ufuncs,	\
     ufuncs->user_data.name = ufuncs->parent->user_data.name;			\
     ufuncs->destroy.name = nullptr;						\
   }										\
+										\
+  hb_unicode_funcs_reset_batch_func (ufuncs, func);				\
 }
 
 HB_UNICODE_FUNCS_IMPLEMENT_CALLBACKS
@@ -447,6 +494,55 @@ hb_unicode_decompose_compatibility (hb_unicode_funcs_t *ufuncs,
 }
 
 
+void
+hb_unicode_funcs_t::get_props (unsigned int          count,
+			       const hb_codepoint_t *first_unicode,
+			       unsigned int          unicode_stride,
+			       hb_unicode_props_t   *props)
+{
+  if (get_props_func)
+  {
+    get_props_func (first_unicode, unicode_stride, count, props);
+    return;
+  }
+
+  hb_unicode_general_category_t categories[32];
+  hb_codepoint_t marks[32];
+  hb_unicode_combining_class_t classes[32];
+
+  while (count)
+  {
+    unsigned int n = hb_min (count, ARRAY_LENGTH (categories));
+    general_category_batch (n, first_unicode, unicode_stride,
+			    categories, sizeof (categories[0]));
+    script_batch (n, first_unicode, unicode_stride,
+		  &props[0].script, sizeof (props[0]));
+
+    /* Only marks need their combining class. */
+    unsigned int num_marks = 0;
+    for (unsigned int i = 0; i < n; i++)
+    {
+      props[i].general_category = categories[i];
+      props[i].combining_class = HB_UNICODE_COMBINING_CLASS_NOT_REORDERED;
+      if (HB_UNICODE_GENERAL_CATEGORY_IS_MARK (categories[i]))
+	marks[num_marks++] = *first_unicode;
+      first_unicode = &StructAtOffsetUnaligned<hb_codepoint_t> (first_unicode, unicode_stride);
+    }
+    if (num_marks)
+    {
+      combining_class_batch (num_marks, marks, sizeof (marks[0]),
+			     classes, sizeof (classes[0]));
+      for (unsigned int i = 0, j = 0; j < num_marks; i++)
+	if (HB_UNICODE_GENERAL_CATEGORY_IS_MARK (categories[i]))
+	  props[i].combining_class = classes[j++];
+    }
+
+    props += n;
+    count -= n;
+  }
+}
+
+
 /* See hb-unicode.hh for details. */
 const uint8_t
 _hb_modified_combining_class[256] =
@@ -575,3 +671,451 @@ _hb_unicode_is_emoji_Extended_Pictographic (hb_codepoint_t cp)
 		     sizeof (hb_unicode_range_t),
 		     hb_unicode_range_t::cmp);
 }
+
+bool
+_hb_unicode_is_emoji_Emoji_Presentation (hb_codepoint_t cp)
+{
+  return hb_bsearch (&cp, _hb_unicode_emoji_Emoji_Presentation_table,
+		     ARRAY_LENGTH (_hb_unicode_emoji_Emoji_Presentation_table),
+		     sizeof (hb_unicode_range_t),
+		     hb_unicode_range_t::cmp);
+}
+
+
+/*
+ * Itemization
+ */
+
+/* Brackets paired up for script resolution, after ICU's usc_impl.
+ * Sorted; openers are at even indices, their closers right after. */
+static const hb_codepoint_t _hb_itemize_paired_chars[] =
+{
+  0x0028u, 0x0029u, /* ASCII */
+  0x003Cu, 0x003Eu,
+  0x005Bu, 0x005Du,
+  0x007Bu, 0x007Du,
+  0x00ABu, 0x00BBu, /* Guillemets */
+  0x0F3Au, 0x0F3Bu, /* Tibetan */
+  0x0F3Cu, 0x0F3Du,
+  0x169Bu, 0x169Cu, /* Ogham */
+  0x2018u, 0x2019u, /* General punctuation */
+  0x201Cu, 0x201Du,
+  0x2039u, 0x203Au,
+  0x2045u, 0x2046u,
+  0x207Du, 0x207Eu,
+  0x208Du, 0x208Eu,
+  0x27E6u, 0x27E7u, /* Math */
+  0x27E8u, 0x27E9u,
+  0x27EAu, 0x27EBu,
+  0x27ECu, 0x27EDu,
+  0x27EEu, 0x27EFu,
+  0x2983u, 0x2984u,
+  0x2985u, 0x2986u,
+  0x2987u, 0x2988u,
+  0x2989u, 0x298Au,
+  0x298Bu, 0x298Cu,
+  0x3008u, 0x3009u, /* CJK */
+  0x300Au, 0x300Bu,
+  0x300Cu, 0x300Du,
+  0x300Eu, 0x300Fu,
+  0x3010u, 0x3011u,
+  0x3014u, 0x3015u,
+  0x3016u, 0x3017u,
+  0x3018u, 0x3019u,
+  0x301Au, 0x301Bu,
+  0xFF08u, 0xFF09u, /* Fullwidth */
+  0xFF3Bu, 0xFF3Du,
+  0xFF5Bu, 0xFF5Du,
+  0xFF5Fu, 0xFF60u,
+  0xFF62u, 0xFF63u,
+};
+
+static int
+_hb_itemize_paired_char_cmp (const void *pkey, const void *pitem)
+{
+  hb_codepoint_t key = * (const hb_codepoint_t *) pkey;
+  hb_codepoint_t item = * (const hb_codepoint_t *) pitem;
+  return key < item ? -1 : key > item ? +1 : 0;
+}
+
+/* Returns the index of u in _hb_itemize_paired_chars, or -1. */
+static inline int
+_hb_itemize_paired_char (hb_codepoint_t u)
+{
+  if (u < 0x0028u || u > 0xFF63u ||
+      (u > 0x007Du && u < 0x00ABu) ||
+      (u > 0x301Bu && u < 0xFF08u))
+    return -1;
+  const hb_codepoint_t *p = (const hb_codepoint_t *)
+			    hb_bsearch (&u, _hb_itemize_paired_chars,
+					ARRAY_LENGTH (_hb_itemize_paired_chars),
+					sizeof (_hb_itemize_paired_chars[0]),
+					_hb_itemize_paired_char_cmp);
+  return p ? p - _hb_itemize_paired_chars : -1;
+}
+
+/* Neither table has anything below U+00A9 or between U+3299 and U+1F000;
+ * skip the searches for most text. */
+static inline bool
+_hb_itemize_may_be_emoji (hb_codepoint_t u)
+{ return u >= 0x00A9u && (u <= 0x3299u || u >= 0x1F000u); }
+
+static inline bool
+_hb_itemize_is_script_real (hb_script_t script)
+{
+  return script != HB_SCRIPT_COMMON &&
+	 script != HB_SCRIPT_INHERITED &&
+	 script != HB_SCRIPT_UNKNOWN;
+}
+
+#ifndef HB_UNICODE_ITEMIZE_MAX_PARENS
+#define HB_UNICODE_ITEMIZE_MAX_PARENS 64
+#endif
+
+/* Splits text into runs of one script and emoji presentation, one
+ * character at a time.  Runs are counted from zero; only those numbered
+ * [start_offset, start_offset + capacity) are written out. */
+struct hb_unicode_itemizer_t
+{
+  hb_unicode_itemizer_t (unsigned int start_offset_,
+			 unsigned int capacity_,
+			 hb_unicode_run_t *runs_) :
+    start_offset (start_offset_), capacity (capacity_), runs (runs_) {}
+
+  void add (hb_codepoint_t u, hb_script_t sc, hb_codepoint_t next, unsigned int offset)
+  {
+    /* Emoji presentation, per emoji sequence; see UTS #51. */
+    bool continues = in_sequence &&
+		     (u == 0x200Du || u == 0xFE0Eu || u == 0xFE0Fu || u == 0x20E3u ||
+		      hb_in_range<hb_codepoint_t> (u, 0x1F3FBu, 0x1F3FFu) ||	/* Skin tones. */
+		      hb_in_range<hb_codepoint_t> (u, 0xE0020u, 0xE007Fu) ||	/* Tags. */
+		      (after_zwj && _hb_itemize_may_be_emoji (u) &&
+		       _hb_unicode_is_emoji_Extended_Pictographic (u)) ||
+		      (regional_indicator_open && hb_in_range<hb_codepoint_t> (u, 0x1F1E6u, 0x1F1FFu)));
+    if (continues)
+      regional_indicator_open = false;
+    else
+    {
+      regional_indicator_open = false;
+      if (hb_in_range<hb_codepoint_t> (u, 0x1F1E6u, 0x1F1FFu))
+      {
+	in_sequence = sequence_emoji = regional_indicator_open = true;
+      }
+      else if (hb_in_range<hb_codepoint_t> (u, '0', '9') || u == '#' || u == '*')
+      {
+	/* Keycap bases. */
+	sequence_emoji = next == 0x20E3u || next == 0xFE0Fu;
+	in_sequence = sequence_emoji;
+      }
+      else if (_hb_itemize_may_be_emoji (u) &&
+	       _hb_unicode_is_emoji_Extended_Pictographic (u))
+      {
+	in_sequence = true;
+	sequence_emoji = next == 0xFE0Fu ||
+			 hb_in_range<hb_codepoint_t> (next, 0x1F3FBu, 0x1F3FFu) ||
+			 (next != 0xFE0Eu && _hb_unicode_is_emoji_Emoji_Presentation (u));
+      }
+      else
+	in_sequence = sequence_emoji = false;
+    }
+    after_zwj = u == 0x200Du;
+
+    /* Script.  Common and Inherited characters, and closing brackets
+     * matching an earlier opening one, join the script run they are in;
+     * the first real script in a run gives the run its script. */
+    int pair = _hb_itemize_paired_char (u);
+    bool pop = false;
+    if (pair >= 0)
+    {
+      if (!(pair & 1))
+	push_paren (_hb_itemize_paired_chars[pair + 1]);
+      else
+      {
+	while (paren_count && parens[paren_count - 1].close != u)
+	  pop_paren ();
+	if (paren_count)
+	{
+	  sc = parens[paren_count - 1].script;
+	  pop = true;
+	}
+      }
+    }
+
+    bool new_run = !num_runs || sequence_emoji != (bool) current.emoji;
+    if (_hb_itemize_is_script_real (sc))
+    {
+      if (!_hb_itemize_is_script_real (script))
+	resolve (sc);
+      else if (sc != script)
+      {
+	close_run (offset);
+	script = sc;
+	script_run_first = num_runs;
+	fixup_count = 0;
+	open_run (offset);
+	new_run = false;
+      }
+    }
+    if (pop)
+      pop_paren ();
+
+    if (new_run)
+    {
+      if (num_runs)
+	close_run (offset);
+      open_run (offset);
+    }
+  }
+
+  unsigned int finish (unsigned int end_offset)
+  {
+    if (num_runs)
+      close_run (end_offset);
+    return num_runs;
+  }
+
+  private:
+
+  void open_run (unsigned int offset)
+  {
+    current.offset = offset;
+    current.emoji = sequence_emoji;
+    num_runs++;
+  }
+
+  void close_run (unsigned int end_offset)
+  {
+    unsigned int i = num_runs - 1;
+    if (i < start_offset || i - start_offset >= capacity)
+      return;
+    hb_unicode_run_t *run = &runs[i - start_offset];
+    run->offset = current.offset;
+    run->length = end_offset - current.offset;
+    run->emoji = current.emoji;
+    set_script (run, script);
+  }
+
+  void resolve (hb_script_t sc)
+  {
+    script = sc;
+
+    /* Earlier runs of this script run, and brackets opened in them,
+     * were waiting for a script. */
+    for (unsigned int i = hb_max (script_run_first, start_offset); i + 1 < num_runs; i++)
+    {
+      if (i - start_offset >= capacity)
+	break;
+      set_script (&runs[i - start_offset], sc);
+    }
+    for (unsigned int i = paren_count - fixup_count; i < paren_count; i++)
+      parens[i].script = sc;
+    fixup_count = 0;
+  }
+
+  static void set_script (hb_unicode_run_t *run, hb_script_t sc)
+  {
+    run->script = sc;
+    run->direction = _hb_itemize_is_script_real (sc) ?
+		     hb_script_get_horizontal_direction (sc) :
+		     HB_DIRECTION_INVALID;
+  }
+
+  void push_paren (hb_codepoint_t close)
+  {
+    if (unlikely (paren_count == ARRAY_LENGTH (parens)))
+    {
+      /* Forget the outermost bracket. */
+      memmove (parens, parens + 1, (paren_count - 1) * sizeof (parens[0]));
+      paren_count--;
+    }
+    parens[paren_count].close = close;
+    parens[paren_count].script = script;
+    paren_count++;
+    fixup_count = hb_min (fixup_count + 1, paren_count);
+  }
+
+  void pop_paren ()
+  {
+    paren_count--;
+    if (fixup_count)
+      fixup_count--;
+  }
+
+  unsigned int start_offset;
+  unsigned int capacity;
+  hb_unicode_run_t *runs;
+
+  unsigned int num_runs = 0;
+  hb_unicode_run_t current = {0, 0, HB_SCRIPT_COMMON, HB_DIRECTION_INVALID, false};
+
+  hb_script_t script = HB_SCRIPT_COMMON;
+  unsigned int script_run_first = 0;
+  struct { hb_codepoint_t close; hb_script_t script; } parens[HB_UNICODE_ITEMIZE_MAX_PARENS];
+  unsigned int paren_count = 0;
+  unsigned int fixup_count = 0;
+
+  bool in_sequence = false;
+  bool sequence_emoji = false;
+  bool after_zwj = false;
+  bool regional_indicator_open = false;
+};
+
+template <typename utf_t>
+static unsigned int
+hb_unicode_itemize (hb_unicode_funcs_t *ufuncs,
+		    const typename utf_t::codepoint_t *text,
+		    int text_length,
+		    unsigned int start_offset,
+		    unsigned int *run_count /* IN/OUT */,
+		    hb_unicode_run_t *runs /* OUT */)
+{
+  typedef typename utf_t::codepoint_t T;
+  const hb_codepoint_t replacement = 0xFFFDu;
+
+  if (text_length == -1)
+    text_length = utf_t::strlen (text);
+
+  hb_unicode_itemizer_t itemizer (start_offset, run_count ? *run_count : 0, runs);
+
+  /* Decode a chunk at a time so that scripts can be looked up through
+   * the batch callback. */
+  hb_codepoint_t unicodes[64 + 1];
+  hb_script_t scripts[64];
+  unsigned int offsets[64 + 1];
+
+  const T *next = text;
+  const T *end = text + text_length;
+  unsigned int count = 0;
+  if (next < end)
+  {
+    offsets[0] = 0;
+    next = utf_t::next (next, end, &unicodes[0], replacement);
+    count = 1;
+  }
+  while (count)
+  {
+    while (count < ARRAY_LENGTH (unicodes) && next < end)
+    {
+      offsets[count] = next - text;
+      next = utf_t::next (next, end, &unicodes[count], replacement);
+      count++;
+    }
+
+    /* The last character decoded is only there as lookahead for the one
+     * before it, unless the text ends with it. */
+    unsigned int n = next < end || count == ARRAY_LENGTH (unicodes) ? count - 1 : count;
+    ufuncs->script_batch (n, unicodes, sizeof (unicodes[0]), scripts, sizeof (scripts[0]));
+    for (unsigned int i = 0; i < n; i++)
+      itemizer.add (unicodes[i], scripts[i],
+		    i + 1 < count ? unicodes[i + 1] : 0,
+		    offsets[i]);
+
+    for (unsigned int i = n; i < count; i++)
+    {
+      unicodes[i - n] = unicodes[i];
+      offsets[i - n] = offsets[i];
+    }
+    count -= n;
+  }
+
+  unsigned int total = itemizer.finish (text_length);
+  if (run_count)
+    *run_count = hb_min (total - hb_min (start_offset, total), *run_count);
+  return total;
+}
+
+/**
+ * hb_unicode_itemize_utf8:
+ * @ufuncs: Unicode functions to look scripts up with.
+ * @text: (array length=text_length) (element-type uint8_t): UTF-8 text.
+ * @text_length: the length of @text, or -1 if it is %NULL terminated.
+ * @start_offset: index of the first run to return.
+ * @run_count: (inout) (allow-none): Input = the maximum number of runs to return;
+ *             Output = the actual number of runs returned (may be zero).
+ * @runs: (out) (array length=run_count): the runs found, with offsets and
+ *        lengths in bytes.
+ *
+ * Splits @text into runs of a single script and emoji presentation, in
+ * one pass over the text and with a single script lookup per character.
+ *
+ * Common and Inherited characters join the script of the text around
+ * them, and closing brackets take the script of the text their opening
+ * bracket was in.  Emoji sequences get emoji presentation if their first
+ * character defaults to it and is not followed by U+FE0E, or if it is
+ * followed by U+FE0F, a skin-tone modifier or, for keycaps, U+20E3.
+ *
+ * There are never more runs than characters.
+ *
+ * Return value: the total number of runs in @text.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_unicode_itemize_utf8 (hb_unicode_funcs_t *ufuncs,
+			 const char         *text,
+			 int                 text_length,
+			 unsigned int        start_offset,
+			 unsigned int       *run_count /* IN/OUT */,
+			 hb_unicode_run_t   *runs /* OUT */)
+{
+  return hb_unicode_itemize<hb_utf8_t> (ufuncs, (const uint8_t *) text, text_length,
+					start_offset, run_count, runs);
+}
+
+/**
+ * hb_unicode_itemize_utf16:
+ * @ufuncs: Unicode functions to look scripts up with.
+ * @text: (array length=text_length): UTF-16 text.
+ * @text_length: the length of @text, or -1 if it is %NULL terminated.
+ * @start_offset: index of the first run to return.
+ * @run_count: (inout) (allow-none): Input = the maximum number of runs to return;
+ *             Output = the actual number of runs returned (may be zero).
+ * @runs: (out) (array length=run_count): the runs found, with offsets and
+ *        lengths in 16-bit units.
+ *
+ * See hb_unicode_itemize_utf8().
+ *
+ * Return value: the total number of runs in @text.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_unicode_itemize_utf16 (hb_unicode_funcs_t *ufuncs,
+			  const uint16_t     *text,
+			  int                 text_length,
+			  unsigned int        start_offset,
+			  unsigned int       *run_count /* IN/OUT */,
+			  hb_unicode_run_t   *runs /* OUT */)
+{
+  return hb_unicode_itemize<hb_utf16_t> (ufuncs, text, text_length,
+					 start_offset, run_count, runs);
+}
+
+/**
+ * hb_unicode_itemize_utf32:
+ * @ufuncs: Unicode functions to look scripts up with.
+ * @text: (array length=text_length): UTF-32 text.
+ * @text_length: the length of @text, or -1 if it is %NULL terminated.
+ * @start_offset: index of the first run to return.
+ * @run_count: (inout) (allow-none): Input = the maximum number of runs to return;
+ *             Output = the actual number of runs returned (may be zero).
+ * @runs: (out) (array length=run_count): the runs found, with offsets and
+ *        lengths in characters.
+ *
+ * See hb_unicode_itemize_utf8().
+ *
+ * Return value: the total number of runs in @text.
+ *
+ * Since: REPLACEME
+ **/
+unsigned int
+hb_unicode_itemize_utf32 (hb_unicode_funcs_t *ufuncs,
+			  const uint32_t     *text,
+			  int                 text_length,
+			  unsigned int        start_offset,
+			  unsigned int       *run_count /* IN/OUT */,
+			  hb_unicode_run_t   *runs /* OUT */)
+{
+  return hb_unicode_itemize<hb_utf32_t> (ufuncs, text, text_length,
+					 start_offset, run_count, runs);
+}
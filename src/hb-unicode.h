@@ -251,6 +251,31 @@ typedef hb_bool_t			(*hb_unicode_decompose_func_t)		(hb_unicode_funcs_t *ufuncs,
 										 hb_codepoint_t     *b,
 										 void               *user_data);
 
+/* Batch variants: look up count codepoints, unicode_stride bytes apart,
+ * writing results result_stride bytes apart. */
+
+typedef void (*hb_unicode_combining_class_batch_func_t)	(hb_unicode_funcs_t             *ufuncs,
+							 unsigned int                    count,
+							 const hb_codepoint_t           *first_unicode,
+							 unsigned int                    unicode_stride,
+							 hb_unicode_combining_class_t   *first_class,
+							 unsigned int                    class_stride,
+							 void                           *user_data);
+typedef void (*hb_unicode_general_category_batch_func_t)	(hb_unicode_funcs_t             *ufuncs,
+							 unsigned int                    count,
+							 const hb_codepoint_t           *first_unicode,
+							 unsigned int                    unicode_stride,
+							 hb_unicode_general_category_t  *first_category,
+							 unsigned int                    category_stride,
+							 void                           *user_data);
+typedef void (*hb_unicode_script_batch_func_t)		(hb_unicode_funcs_t             *ufuncs,
+							 unsigned int                    count,
+							 const hb_codepoint_t           *first_unicode,
+							 unsigned int                    unicode_stride,
+							 hb_script_t                    *first_script,
+							 unsigned int                    script_stride,
+							 void                           *user_data);
+
 /* setters */
 
 /**
@@ -349,6 +374,63 @@ hb_unicode_funcs_set_decompose_func (hb_unicode_funcs_t *ufuncs,
 				     hb_unicode_decompose_func_t func,
 				     void *user_data, hb_destroy_func_t destroy);
 
+/**
+ * hb_unicode_funcs_set_combining_class_batch_func:
+ * @ufuncs: a Unicode function structure
+ * @func: (closure user_data) (destroy destroy) (scope notified):
+ * @user_data:
+ * @destroy:
+ *
+ * Sets a callback that looks up the combining class of many codepoints at
+ * once.  If not set, the one set with
+ * hb_unicode_funcs_set_combining_class_func() is called for each codepoint;
+ * setting that one also resets this to the default.
+ *
+ * Since: REPLACEME
+ **/
+HB_EXTERN void
+hb_unicode_funcs_set_combining_class_batch_func (hb_unicode_funcs_t *ufuncs,
+						  hb_unicode_combining_class_batch_func_t func,
+						  void *user_data, hb_destroy_func_t destroy);
+
+/**
+ * hb_unicode_funcs_set_general_category_batch_func:
+ * @ufuncs: a Unicode function structure
+ * @func: (closure user_data) (destroy destroy) (scope notified):
+ * @user_data:
+ * @destroy:
+ *
+ * Sets a callback that looks up the general category of many codepoints at
+ * once.  If not set, the one set with
+ * hb_unicode_funcs_set_general_category_func() is called for each codepoint;
+ * setting that one also resets this to the default.
+ *
+ * Since: REPLACEME
+ **/
+HB_EXTERN void
+hb_unicode_funcs_set_general_category_batch_func (hb_unicode_funcs_t *ufuncs,
+						   hb_unicode_general_category_batch_func_t func,
+						   void *user_data, hb_destroy_func_t destroy);
+
+/**
+ * hb_unicode_funcs_set_script_batch_func:
+ * @ufuncs: a Unicode function structure
+ * @func: (closure user_data) (destroy destroy) (scope notified):
+ * @user_data:
+ * @destroy:
+ *
+ * Sets a callback that looks up the script of many codepoints at
+ * once.  If not set, the one set with
+ * hb_unicode_funcs_set_script_func() is called for each codepoint;
+ * setting that one also resets this to the default.
+ *
+ * Since: REPLACEME
+ **/
+HB_EXTERN void
+hb_unicode_funcs_set_script_batch_func (hb_unicode_funcs_t *ufuncs,
+					 hb_unicode_script_batch_func_t func,
+					 void *user_data, hb_destroy_func_t destroy);
+
 /* accessors */
 
 /**
@@ -399,6 +481,60 @@ hb_unicode_decompose (hb_unicode_funcs_t *ufuncs,
 		      hb_codepoint_t     *a,
 		      hb_codepoint_t     *b);
 
+
+/*
+ * Itemization
+ */
+
+/**
+ * hb_unicode_run_t:
+ * @offset: index of the first code unit of the run in the text.
+ * @length: number of code units in the run.
+ * @script: script of the run; %HB_SCRIPT_COMMON if it has no character
+ *          of a real script.
+ * @direction: horizontal direction of @script, or %HB_DIRECTION_INVALID
+ *             if it has none.  Only a hint: bidi resolution is left to
+ *             the caller.
+ * @emoji: whether the run should use emoji presentation.
+ *
+ * A run of text of a single script and emoji presentation, as found by
+ * hb_unicode_itemize_utf8().
+ *
+ * Since: REPLACEME
+ */
+typedef struct hb_unicode_run_t
+{
+  unsigned int   offset;
+  unsigned int   length;
+  hb_script_t    script;
+  hb_direction_t direction;
+  hb_bool_t      emoji;
+} hb_unicode_run_t;
+
+HB_EXTERN unsigned int
+hb_unicode_itemize_utf8 (hb_unicode_funcs_t *ufuncs,
+			 const char         *text,
+			 int                 text_length,
+			 unsigned int        start_offset,
+			 unsigned int       *run_count /* IN/OUT */,
+			 hb_unicode_run_t   *runs /* OUT */);
+
+HB_EXTERN unsigned int
+hb_unicode_itemize_utf16 (hb_unicode_funcs_t *ufuncs,
+			  const uint16_t     *text,
+			  int                 text_length,
+			  unsigned int        start_offset,
+			  unsigned int       *run_count /* IN/OUT */,
+			  hb_unicode_run_t   *runs /* OUT */);
+
+HB_EXTERN unsigned int
+hb_unicode_itemize_utf32 (hb_unicode_funcs_t *ufuncs,
+			  const uint32_t     *text,
+			  int                 text_length,
+			  unsigned int        start_offset,
+			  unsigned int       *run_count /* IN/OUT */,
+			  hb_unicode_run_t   *runs /* OUT */);
+
 HB_END_DECLS
 
 #endif /* HB_UNICODE_H */
@@ -49,6 +49,9 @@ extern HB_INTERNAL const uint8_t _hb_modified_combining_class[256];
   HB_UNICODE_FUNC_IMPLEMENT (compose) \
   HB_UNICODE_FUNC_IMPLEMENT (decompose) \
   HB_UNICODE_FUNC_IMPLEMENT (decompose_compatibility) \
+  HB_UNICODE_FUNC_IMPLEMENT (combining_class_batch) \
+  HB_UNICODE_FUNC_IMPLEMENT (general_category_batch) \
+  HB_UNICODE_FUNC_IMPLEMENT (script_batch) \
   /* ^--- Add new callbacks here */
 
 /* Simple callbacks are those taking a hb_codepoint_t and returning a hb_codepoint_t */
@@ -60,6 +63,30 @@ extern HB_INTERNAL const uint8_t _hb_modified_combining_class[256];
   HB_UNICODE_FUNC_IMPLEMENT (hb_script_t, script) \
   /* ^--- Add new simple callbacks here */
 
+/* Batch callbacks are array versions of some of the simple ones */
+#define HB_UNICODE_FUNCS_IMPLEMENT_CALLBACKS_BATCH \
+  HB_UNICODE_FUNC_IMPLEMENT (hb_unicode_combining_class_t, combining_class) \
+  HB_UNICODE_FUNC_IMPLEMENT (hb_unicode_general_category_t, general_category) \
+  HB_UNICODE_FUNC_IMPLEMENT (hb_script_t, script) \
+  /* ^--- Add new batch callbacks here */
+
+/* Per-character properties the shaper needs up front; see
+ * hb_unicode_funcs_t::get_props(). */
+struct hb_unicode_props_t
+{
+  hb_script_t script;
+  uint8_t general_category;	/* hb_unicode_general_category_t */
+  uint8_t combining_class;	/* hb_unicode_combining_class_t; used for marks only */
+};
+
+/* Fills props for count codepoints read stride bytes apart, all from one
+ * lookup each.  Only the built-in implementations provide this, and it is
+ * dropped whenever any callback of the funcs is replaced. */
+typedef void (*hb_unicode_get_props_func_t) (const hb_codepoint_t *unicodes,
+					     unsigned int          stride,
+					     unsigned int          count,
+					     hb_unicode_props_t   *props);
+
 struct hb_unicode_funcs_t
 {
   hb_object_header_t header;
@@ -69,6 +96,14 @@ struct hb_unicode_funcs_t
 #define HB_UNICODE_FUNC_IMPLEMENT(return_type, name) \
   return_type name (hb_codepoint_t unicode) { return func.name (this, unicode, user_data.name); }
 HB_UNICODE_FUNCS_IMPLEMENT_CALLBACKS_SIMPLE
+#undef HB_UNICODE_FUNC_IMPLEMENT
+
+#define HB_UNICODE_FUNC_IMPLEMENT(return_type, name) \
+  void name##_batch (unsigned int count, \
+		     const hb_codepoint_t *first_unicode, unsigned int unicode_stride, \
+		     return_type *first_result, unsigned int result_stride) \
+  { func.name##_batch (this, count, first_unicode, unicode_stride, first_result, result_stride, user_data.name##_batch); }
+HB_UNICODE_FUNCS_IMPLEMENT_CALLBACKS_BATCH
 #undef HB_UNICODE_FUNC_IMPLEMENT
 
   hb_bool_t compose (hb_codepoint_t a, hb_codepoint_t b,
@@ -98,12 +133,30 @@ HB_UNICODE_FUNCS_IMPLEMENT_CALLBACKS_SIMPLE
     return ret;
   }
 
+  /* Looks up general category, script and, for marks, combining class of
+   * count codepoints: with the built-in single-lookup hook if there is
+   * one, else through the batch callbacks. */
+  HB_INTERNAL void get_props (unsigned int          count,
+			      const hb_codepoint_t *first_unicode,
+			      unsigned int          unicode_stride,
+			      hb_unicode_props_t   *props);
+
   unsigned int
   modified_combining_class (hb_codepoint_t u)
   {
     /* XXX This hack belongs to the Myanmar shaper. */
     if (unlikely (u == 0x1037u)) u = 0x103Au;
 
+    return modified_combining_class (u, combining_class (u));
+  }
+
+  /* Same, for when the combining class of u is already known. */
+  unsigned int
+  modified_combining_class (hb_codepoint_t u,
+			    hb_unicode_combining_class_t klass)
+  {
+    if (unlikely (u == 0x1037u)) return modified_combining_class (u);
+
     /* XXX This hack belongs to the USE shaper (for Tai Tham):
      * Reorder SAKOT to ensure it comes after any tone marks. */
     if (unlikely (u == 0x1A60u)) return 254;
@@ -114,7 +167,7 @@ HB_UNICODE_FUNCS_IMPLEMENT_CALLBACKS_SIMPLE
     /* Reorder TSA -PHRU to reorder before U+0F74 */
     if (unlikely (u == 0x0F39u)) return 127;
 
-    return _hb_modified_combining_class[combining_class (u)];
+    return _hb_modified_combining_class[klass];
   }
 
   static hb_bool_t
@@ -259,6 +312,8 @@ HB_UNICODE_FUNCS_IMPLEMENT_CALLBACKS_SIMPLE
     HB_UNICODE_FUNCS_IMPLEMENT_CALLBACKS
 #undef HB_UNICODE_FUNC_IMPLEMENT
   } destroy;
+
+  hb_unicode_get_props_func_t get_props_func;
 };
 DECLARE_NULL_INSTANCE (hb_unicode_funcs_t);
 
@@ -387,6 +442,9 @@ struct hb_unicode_range_t
  * Emoji.
  */
 
+HB_INTERNAL bool
+_hb_unicode_is_emoji_Emoji_Presentation (hb_codepoint_t cp);
+
 HB_INTERNAL bool
 _hb_unicode_is_emoji_Extended_Pictographic (hb_codepoint_t cp);
 
@@ -721,6 +721,15 @@ _hb_uniscribe_shape (hb_shape_plan_t    *shape_plan,
 
   HRESULT hr;
 
+#define MAX_ITEMS 256
+
+  /* Itemization only depends on the text, so it is kept when the buffer
+   * has to grow and shaping starts over. */
+  SCRIPT_ITEM items[MAX_ITEMS + 1];
+  ULONG script_tags[MAX_ITEMS];
+  int item_count = 0;
+  bool itemized = false;
+
 retry:
 
   unsigned int scratch_size;
@@ -780,6 +789,15 @@ retry:
 			      sizeof (GOFFSET) +
 			      sizeof (uint32_t));
 
+  /* Make room up front for as many glyphs as Uniscribe recommends
+   * planning for, so that shaping rarely runs out of it half-way. */
+  if (unlikely (glyphs_size < chars_len * 3 / 2 + 16))
+  {
+    if (unlikely (!buffer->ensure (buffer->allocated * 2)))
+      FAIL ("Buffer resize failed");
+    goto retry;
+  }
+
   ALLOCATE_ARRAY (WORD, glyphs, glyphs_size);
   ALLOCATE_ARRAY (SCRIPT_GLYPHPROP, glyph_props, glyphs_size);
   ALLOCATE_ARRAY (int, advances, glyphs_size);
@@ -796,31 +814,30 @@ retry:
 
 #undef ALLOCATE_ARRAY
 
-#define MAX_ITEMS 256
-
-  SCRIPT_ITEM items[MAX_ITEMS + 1];
-  SCRIPT_CONTROL bidi_control = {0};
-  SCRIPT_STATE bidi_state = {0};
-  ULONG script_tags[MAX_ITEMS];
-  int item_count;
-
-  /* MinGW32 doesn't define fMergeNeutralItems, so we bruteforce */
-  //bidi_control.fMergeNeutralItems = true;
-  *(uint32_t*)&bidi_control |= 1u<<24;
-
-  bidi_state.uBidiLevel = HB_DIRECTION_IS_FORWARD (buffer->props.direction) ? 0 : 1;
-  bidi_state.fOverrideDirection = 1;
-
-  hr = funcs->ScriptItemizeOpenType (pchars,
-				     chars_len,
-				     MAX_ITEMS,
-				     &bidi_control,
-				     &bidi_state,
-				     items,
-				     script_tags,
-				     &item_count);
-  if (unlikely (FAILED (hr)))
-    FAIL ("ScriptItemizeOpenType() failed: 0x%08lx", hr);
+  if (!itemized)
+  {
+    SCRIPT_CONTROL bidi_control = {0};
+    SCRIPT_STATE bidi_state = {0};
+
+    /* MinGW32 doesn't define fMergeNeutralItems, so we bruteforce */
+    //bidi_control.fMergeNeutralItems = true;
+    *(uint32_t*)&bidi_control |= 1u<<24;
+
+    bidi_state.uBidiLevel = HB_DIRECTION_IS_FORWARD (buffer->props.direction) ? 0 : 1;
+    bidi_state.fOverrideDirection = 1;
+
+    hr = funcs->ScriptItemizeOpenType (pchars,
+				       chars_len,
+				       MAX_ITEMS,
+				       &bidi_control,
+				       &bidi_state,
+				       items,
+				       script_tags,
+				       &item_count);
+    if (unlikely (FAILED (hr)))
+      FAIL ("ScriptItemizeOpenType() failed: 0x%08lx", hr);
+    itemized = true;
+  }
 
 #undef MAX_ITEMS
 
@@ -105,6 +105,25 @@ struct hb_utf8_t
     return text;
   }
 
+  /* Returns the end of the run of ASCII bytes starting at text.  Checks a
+   * word at a time while it can. */
+  static const codepoint_t *
+  ascii_end (const codepoint_t *text,
+	     const codepoint_t *end)
+  {
+    while (end - text >= 8)
+    {
+      uint64_t v;
+      memcpy (&v, text, sizeof (v));
+      if (v & 0x8080808080808080ull)
+	break;
+      text += 8;
+    }
+    while (text < end && *text <= 0x7Fu)
+      text++;
+    return text;
+  }
+
   static const codepoint_t *
   prev (const codepoint_t *text,
 	const codepoint_t *start,
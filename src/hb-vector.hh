@@ -32,8 +32,29 @@
 #include "hb-null.hh"
 
 
+/* Room for InlineCount items inside the vector itself, so that vectors
+ * that stay that small never allocate.  The vector tells it is in use by
+ * not having an allocated array; nothing points into it, so vectors can
+ * be moved bitwise, as a vector of vectors does on growing. */
+template <typename Type, unsigned int InlineCount>
+struct hb_vector_inline_storage_t
+{
+  Type *inline_array () { return reinterpret_cast<Type *> (inline_bytes); }
+  const Type *inline_array () const { return reinterpret_cast<const Type *> (inline_bytes); }
+
+  private:
+  alignas (Type) unsigned char inline_bytes[InlineCount * sizeof (Type)];
+};
 template <typename Type>
-struct hb_vector_t
+struct hb_vector_inline_storage_t<Type, 0>
+{
+  Type *inline_array () { return nullptr; }
+  const Type *inline_array () const { return nullptr; }
+};
+
+
+template <typename Type, unsigned int InlineCount = 0>
+struct hb_vector_t : hb_vector_inline_storage_t<Type, InlineCount>
 {
   typedef Type item_t;
   static constexpr unsigned item_size = hb_static_size (Type);
@@ -50,6 +71,7 @@ struct hb_vector_t
     allocated = o.allocated;
     length = o.length;
     arrayZ_ = o.arrayZ_;
+    steal_inline (o);
     o.init ();
   }
   ~hb_vector_t () { fini (); }
@@ -62,7 +84,8 @@ struct hb_vector_t
 
   void init ()
   {
-    allocated = length = 0;
+    allocated = InlineCount;
+    length = 0;
     arrayZ_ = nullptr;
   }
 
@@ -96,6 +119,7 @@ struct hb_vector_t
     allocated = o.allocated;
     length = o.length;
     arrayZ_ = o.arrayZ_;
+    steal_inline (o);
     o.init ();
     return *this;
   }
@@ -106,8 +130,8 @@ struct hb_vector_t
   bool operator == (const hb_vector_t &o) const { return as_array () == o.as_array (); }
   uint32_t hash () const { return as_array ().hash (); }
 
-  const Type * arrayZ () const { return arrayZ_; }
-        Type * arrayZ ()       { return arrayZ_; }
+  const Type * arrayZ () const { return arrayZ_ || !InlineCount ? arrayZ_ : this->inline_array (); }
+        Type * arrayZ ()       { return arrayZ_ || !InlineCount ? arrayZ_ : this->inline_array (); }
 
   Type& operator [] (int i_)
   {
@@ -129,6 +153,9 @@ struct hb_vector_t
 
   explicit operator bool () const { return length; }
   unsigned get_size () const { return length * item_size; }
+  /* Heap bytes held; inline storage doesn't count. */
+  unsigned get_heap_size () const
+  { return arrayZ_ && allocated > 0 ? allocated * sizeof (Type) : 0; }
 
   /* Sink interface. */
   template <typename T>
@@ -202,7 +229,13 @@ struct hb_vector_t
       (new_allocated < (unsigned) allocated) ||
       hb_unsigned_mul_overflows (new_allocated, sizeof (Type));
     if (likely (!overflows))
-      new_array = (Type *) realloc (arrayZ_, new_allocated * sizeof (Type));
+    {
+      if (arrayZ_ || !InlineCount)
+	new_array = (Type *) realloc (arrayZ_, new_allocated * sizeof (Type));
+      else if ((new_array = (Type *) malloc (new_allocated * sizeof (Type))))
+	/* Outgrowing the inline storage. */
+	memcpy ((void *) new_array, (const void *) this->inline_array (), length * sizeof (Type));
+    }
 
     if (unlikely (!new_array))
     {
@@ -283,10 +316,18 @@ struct hb_vector_t
   template <typename T>
   const Type *lsearch (const T &x, const Type *not_found = nullptr) const
   { return as_array ().lsearch (x, not_found); }
+
+  private:
+  /* After taking over o's fields: if o's items were inline, copy them. */
+  void steal_inline (hb_vector_t &o)
+  {
+    if (InlineCount && !arrayZ_)
+      memcpy ((void *) this->inline_array (), (const void *) o.inline_array (), length * sizeof (Type));
+  }
 };
 
-template <typename Type>
-struct hb_sorted_vector_t : hb_vector_t<Type>
+template <typename Type, unsigned int InlineCount = 0>
+struct hb_sorted_vector_t : hb_vector_t<Type, InlineCount>
 {
   hb_sorted_array_t<      Type> as_array ()       { return hb_sorted_array (this->arrayZ(), this->length); }
   hb_sorted_array_t<const Type> as_array () const { return hb_sorted_array (this->arrayZ(), this->length); }
@@ -34,6 +34,7 @@
 #include "hb-deprecated.h"
 #include "hb-face.h"
 #include "hb-font.h"
+#include "hb-font-cache.h"
 #include "hb-map.h"
 #include "hb-set.h"
 #include "hb-shape.h"
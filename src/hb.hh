@@ -133,6 +133,8 @@
 #include "config.h"
 #endif
 
+#include "hb-config.hh"
+
 /*
  * Following added based on what AC_USE_SYSTEM_EXTENSIONS adds to
  * config.h.in.  Copied here for the convenience of those embedding
@@ -212,6 +214,36 @@ extern "C" int hb_memalign_impl(void **memptr, size_t alignment, size_t size);
 
 #endif
 
+/* Opt-in allocation counting; see hb_alloc_stats_get().  Allocations are
+ * attributed to the innermost HB_ALLOC_STATS_SCOPE on the calling thread. */
+
+#ifdef HB_ALLOC_STATS
+extern "C" void* _hb_alloc_stats_malloc(size_t size);
+extern "C" void* _hb_alloc_stats_calloc(size_t nmemb, size_t size);
+extern "C" void* _hb_alloc_stats_realloc(void *ptr, size_t size);
+#undef malloc
+#undef calloc
+#undef realloc
+#define malloc _hb_alloc_stats_malloc
+#define calloc _hb_alloc_stats_calloc
+#define realloc _hb_alloc_stats_realloc
+
+extern thread_local hb_alloc_subsystem_t _hb_alloc_stats_subsystem;
+
+struct hb_alloc_stats_scope_t
+{
+  hb_alloc_stats_scope_t (hb_alloc_subsystem_t subsystem)
+    : saved (_hb_alloc_stats_subsystem) { _hb_alloc_stats_subsystem = subsystem; }
+  ~hb_alloc_stats_scope_t () { _hb_alloc_stats_subsystem = saved; }
+
+  hb_alloc_subsystem_t saved;
+};
+#define HB_ALLOC_STATS_SCOPE(subsystem) \
+  hb_alloc_stats_scope_t HB_PASTE (_hb_alloc_stats_scope, __LINE__) (HB_ALLOC_SUBSYSTEM_##subsystem)
+#else
+#define HB_ALLOC_STATS_SCOPE(subsystem)
+#endif
+
 
 /*
  * Compiler attributes
@@ -465,6 +497,19 @@ typedef uint64_t hb_vector_size_impl_t __attribute__((vector_size (HB_VECTOR_SIZ
 typedef uint64_t hb_vector_size_impl_t;
 #endif
 
+/* SIMD instruction sets for hb-algs.hh; only what the compiler targets
+ * is used, there is no runtime dispatch.  Define HB_NO_SIMD to disable. */
+#if !defined(HB_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define HB_SIMD_AVX2 1
+#elif !defined(HB_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define HB_SIMD_SSE2 1
+#elif !defined(HB_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define HB_SIMD_NEON 1
+#endif
+
 
 /* HB_NDEBUG disables some sanity checks that are very safe to disable and
  * should be disabled in production systems.  If NDEBUG is defined, enable
@@ -667,4 +712,27 @@ struct BEInt<Type, 4>
 #include "hb-vector.hh"	// Requires: hb-array hb-null
 #include "hb-object.hh"	// Requires: hb-atomic hb-mutex hb-vector
 
+
+/*
+ * Also for lack of a better place: the language half of
+ * hb_ot_tags_from_script_and_language(), which hb-ot-tag.cc memoizes
+ * on the interned hb_language_t.
+ */
+
+struct hb_language_ot_tags_t
+{
+  hb_tag_t script_tag;		/* From a -hbsc private-use subtag, or 0. */
+  unsigned int language_count;
+  hb_tag_t language_tags[HB_OT_MAX_TAGS_PER_LANGUAGE];
+};
+
+/* Returns nullptr if nothing was memoized yet; language must be valid. */
+HB_INTERNAL const hb_language_ot_tags_t *
+_hb_language_get_ot_tags (hb_language_t language);
+
+/* Returns the memoized tags, which may be tags itself on allocation failure. */
+HB_INTERNAL const hb_language_ot_tags_t *
+_hb_language_set_ot_tags (hb_language_t language,
+			  const hb_language_ot_tags_t *tags);
+
 #endif /* HB_HH */
@@ -0,0 +1,121 @@
+/*
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+
+#include "hb.hh"
+#include "hb-cache.hh"
+
+#include "hb.h"
+#include "hb-ot.h"
+
+#include <stdio.h>
+#include <time.h>
+
+/* Reports cmap-cache hit rates and shaping times of hb-ot-font for a range
+ * of cache sizes, to help choose hb_ot_font_set_cache_sizes() values for a
+ * given script.  Run on a CJK and on a Latin text to see the difference. */
+
+static const unsigned int sizes[] = {0, 256, 1024, 4096, 16384, 65536};
+
+int
+main (int argc, char **argv)
+{
+  if (argc < 3) {
+    fprintf (stderr, "usage: %s font-file text-file [iterations]\n", argv[0]);
+    exit (1);
+  }
+  unsigned int iterations = argc > 3 ? atoi (argv[3]) : 10;
+
+  hb_blob_t *blob = hb_blob_create_from_file (argv[1]);
+  hb_face_t *face = hb_face_create (blob, 0 /* first face */);
+  hb_blob_destroy (blob);
+  blob = hb_blob_create_from_file (argv[2]);
+  unsigned int text_len;
+  const char *text = hb_blob_get_data (blob, &text_len);
+
+  /* Split into lines, the way a paragraph shaper would see them. */
+  hb_vector_t<hb_buffer_t *> lines;
+  for (unsigned int start = 0; start < text_len;)
+  {
+    unsigned int end = start;
+    while (end < text_len && text[end] != '\n')
+      end++;
+    hb_buffer_t *buffer = hb_buffer_create ();
+    hb_buffer_add_utf8 (buffer, text + start, end - start, 0, -1);
+    hb_buffer_guess_segment_properties (buffer);
+    lines.push (buffer);
+    start = end + 1;
+  }
+
+  printf ("%8s %10s %12s\n", "size", "cmap-hits", "usec/iter");
+  for (unsigned int i = 0; i < ARRAY_LENGTH (sizes); i++)
+  {
+    hb_font_t *font = hb_font_create (face);
+    hb_ot_font_set_cache_sizes (font, sizes[i], sizes[i]);
+
+    /* Replay the codepoint stream through a cache of the same geometry. */
+    hb_cmap_dynamic_cache_t cache;
+    cache.init (sizes[i]);
+    unsigned int hits = 0, total = 0;
+    for (unsigned int j = 0; j < lines.length; j++)
+    {
+      unsigned int len;
+      hb_glyph_info_t *info = hb_buffer_get_glyph_infos (lines[j], &len);
+      for (unsigned int k = 0; k < len; k++, total++)
+      {
+	unsigned int v;
+	hb_codepoint_t glyph;
+	if (cache.get (info[k].codepoint, &v))
+	  hits++;
+	else if (hb_font_get_nominal_glyph (font, info[k].codepoint, &glyph))
+	  cache.set (info[k].codepoint, glyph);
+      }
+    }
+    cache.fini ();
+
+    hb_buffer_t *scratch = hb_buffer_create ();
+    clock_t begin = clock ();
+    for (unsigned int n = 0; n < iterations; n++)
+      for (unsigned int j = 0; j < lines.length; j++)
+      {
+	hb_segment_properties_t props;
+	hb_buffer_get_segment_properties (lines[j], &props);
+	hb_buffer_reset (scratch);
+	hb_buffer_append (scratch, lines[j], 0, -1);
+	hb_buffer_set_segment_properties (scratch, &props);
+	hb_shape (font, scratch, nullptr, 0);
+      }
+    double usec = (clock () - begin) * 1e6 / CLOCKS_PER_SEC / hb_max (iterations, 1u);
+    hb_buffer_destroy (scratch);
+
+    printf ("%8u %9.2f%% %12.0f\n", sizes[i], total ? 100. * hits / total : 0., usec);
+    hb_font_destroy (font);
+  }
+
+  for (unsigned int j = 0; j < lines.length; j++)
+    hb_buffer_destroy (lines[j]);
+  lines.fini ();
+  hb_blob_destroy (blob);
+  hb_face_destroy (face);
+
+  return 0;
+}
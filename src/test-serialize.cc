@@ -0,0 +1,99 @@
+/*
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb.hh"
+#include "hb-serialize.hh"
+#include "hb-open-type.hh"
+
+
+/* One object per item, each pointing at the one packed before it, under
+ * a root that points at the last.  Each object is three bytes. */
+static hb_bytes_t
+serialize_chain (char *buf, unsigned int buf_size, unsigned int count)
+{
+  hb_serialize_context_t c (buf, buf_size);
+  OT::Offset16 *root = c.start_serialize<OT::Offset16> ();
+  c.extend_min (root);
+
+  hb_serialize_context_t::objidx_t prev = 0;
+  for (unsigned int i = 0; i < count; i++)
+  {
+    OT::Offset16 *link = c.push<OT::Offset16> ();
+    c.extend_min (link);
+    OT::HBUINT8 *value = c.start_embed<OT::HBUINT8> ();
+    c.extend_min (value);
+    *value = i % 251;
+    c.add_link (*link, prev);
+    prev = c.pop_pack ();
+  }
+  c.add_link (*root, prev);
+  c.end_serialize ();
+
+  assert (!c.ran_out_of_room);
+  assert (!c.in_error ());
+  return c.copy_bytes ();
+}
+
+static void
+test_grow ()
+{
+  const unsigned int count = 10000;
+  char *big = (char *) malloc (count * 3 + 2);
+  char small[64];
+
+  hb_bytes_t expected = serialize_chain (big, count * 3 + 2, count);
+  hb_bytes_t result = serialize_chain (small, sizeof (small), count);
+
+  /* Values repeat, but the distinct offsets keep them from deduplicating. */
+  assert (expected.length == count * 3 + 2);
+  assert (result.length == expected.length);
+  assert (0 == memcmp (result.arrayZ, expected.arrayZ, expected.length));
+
+  free ((void *) expected.arrayZ);
+  free ((void *) result.arrayZ);
+  free (big);
+}
+
+static void
+test_out_of_room ()
+{
+  /* Objects under construction still have to fit the buffer. */
+  char small[8];
+  hb_serialize_context_t c (small, sizeof (small));
+  c.start_serialize<void> ();
+  c.push ();
+  assert (c.allocate_size<void> (4));
+  c.push ();
+  assert (!c.allocate_size<void> (8));
+  assert (c.ran_out_of_room);
+  c.pop_discard ();
+  c.pop_discard ();
+  c.end_serialize ();
+}
+
+int
+main (int argc, char **argv)
+{
+  test_grow ();
+  test_out_of_room ();
+  return 0;
+}
@@ -58,9 +58,55 @@ test_get_unicode_range_bit ()
   test (0x110000, -1);
 }
 
+static void
+test_bits (const hb_set_t *codepoints)
+{
+  uint32_t expected[4] = {0};
+  hb_codepoint_t cp = HB_SET_VALUE_INVALID;
+  while (codepoints->next (&cp))
+  {
+    unsigned int bit = OT::_hb_ot_os2_get_unicode_range_bit (cp);
+    if (bit < 128)
+      expected[bit / 32] |= 1u << (bit % 32);
+  }
+
+  uint32_t bits[4] = {0};
+  OT::_hb_ot_os2_get_unicode_range_bits (codepoints, bits);
+  for (unsigned int i = 0; i < 4; i++)
+    if (bits[i] != expected[i])
+    {
+      fprintf (stderr, "got incorrect ulUnicodeRange%u (0x%08X). Should have been 0x%08X.",
+	       i + 1, bits[i], expected[i]);
+      abort();
+    }
+}
+
+static void
+test_get_unicode_range_bits ()
+{
+  hb_set_t codepoints;
+  test_bits (&codepoints);
+
+  codepoints.add (0x0000);
+  codepoints.add (0x0042);
+  codepoints.add (0x0590); /* Hebrew, right after Armenian. */
+  codepoints.add (0x0850); /* In the gap after NKo. */
+  codepoints.add (0x30B1);
+  codepoints.add_range (0x4E00, 0x9FFF);
+  codepoints.add (0x10FFFD);
+  codepoints.add (0x110000);
+  test_bits (&codepoints);
+
+  codepoints.clear ();
+  for (hb_codepoint_t cp = 0; cp < 0x30000; cp += 97)
+    codepoints.add (cp);
+  test_bits (&codepoints);
+}
+
 int
 main ()
 {
   test_get_unicode_range_bit ();
+  test_get_unicode_range_bits ();
   return 0;
 }
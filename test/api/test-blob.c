@@ -322,6 +322,43 @@ test_blob_subblob (fixture_t *fixture, gconstpointer user_data)
     g_assert ('\0' == data[i]);
 }
 
+static void
+test_blob_from_file_shared (void)
+{
+#if GLIB_CHECK_VERSION(2,37,2)
+  char *path = g_test_build_filename (G_TEST_DIST, "fonts/Roboto-Regular.abc.ttf", NULL);
+#else
+  char *path = g_strdup ("fonts/Roboto-Regular.abc.ttf");
+#endif
+  hb_blob_t *blob1 = hb_blob_create_from_file (path);
+  hb_blob_t *blob2 = hb_blob_create_from_file (path);
+  unsigned int len1, len2;
+  const char *data1 = hb_blob_get_data (blob1, &len1);
+  const char *data2 = hb_blob_get_data (blob2, &len2);
+  char *writable;
+  char first;
+
+  /* Blobs of one file may share a mapping, but stay independent. */
+  g_assert_cmpint (len1, >, 0);
+  g_assert_cmpint (len1, ==, len2);
+  g_assert (0 == memcmp (data1, data2, len1));
+  first = data2[0];
+
+  writable = hb_blob_get_data_writable (blob1, NULL);
+  g_assert (writable);
+  writable[0] = ~first;
+  g_assert_cmpint (hb_blob_get_data (blob2, NULL)[0], ==, first);
+
+  hb_blob_destroy (blob1);
+  g_assert_cmpint (hb_blob_get_data (blob2, NULL)[0], ==, first);
+
+  blob1 = hb_blob_create_from_file (path);
+  g_assert (0 == memcmp (hb_blob_get_data (blob1, NULL), hb_blob_get_data (blob2, NULL), len1));
+  hb_blob_destroy (blob1);
+  hb_blob_destroy (blob2);
+  g_free (path);
+}
+
 
 int
 main (int argc, char **argv)
@@ -331,6 +368,7 @@ main (int argc, char **argv)
   hb_test_init (&argc, &argv);
 
   hb_test_add (test_blob_empty);
+  hb_test_add (test_blob_from_file_shared);
 
   for (i = 0; i < G_N_ELEMENTS (blob_names); i++)
   {
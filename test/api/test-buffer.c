@@ -412,6 +412,57 @@ test_buffer_utf8_conversion (void)
 }
 
 
+static void
+test_buffer_utf8_long_runs (void)
+{
+  /* Long ASCII runs around multi-byte and ill-formed sequences. */
+  static const char utf8[] =
+    "0123456789abcdefghij"	/* 20 ASCII */
+    "\303\251"			/* U+00E9 */
+    "klmnopqrs"			/* 9 ASCII */
+    "\377"			/* ill-formed */
+    "tuvwxyzABCDEFGHI"		/* 16 ASCII */
+    "\342\202"			/* truncated three-byte */
+    "JKLMNOPQ";			/* 8 ASCII */
+  hb_buffer_t *b;
+  hb_glyph_info_t *glyphs;
+  unsigned int len, bytes, i, j, cluster;
+
+  b = hb_buffer_create ();
+  hb_buffer_set_replacement_codepoint (b, (hb_codepoint_t) -1);
+
+  bytes = strlen (utf8);
+  hb_buffer_add_utf8 (b, utf8, bytes, 0, bytes);
+
+  glyphs = hb_buffer_get_glyph_infos (b, &len);
+  g_assert_cmpint (len, ==, 20 + 1 + 9 + 1 + 16 + 2 + 8);
+
+  for (i = 0, j = 0; i < bytes; j++)
+  {
+    unsigned char c = utf8[i];
+    cluster = i;
+    if (c < 0x80)
+    {
+      g_assert_cmphex (glyphs[j].codepoint, ==, c);
+      i++;
+    }
+    else if (c == 0xC3)
+    {
+      g_assert_cmphex (glyphs[j].codepoint, ==, 0x00E9);
+      i += 2;
+    }
+    else
+    {
+      g_assert_cmphex (glyphs[j].codepoint, ==, (hb_codepoint_t) -1);
+      i++;
+    }
+    g_assert_cmpint (glyphs[j].cluster, ==, cluster);
+  }
+  g_assert_cmpint (j, ==, len);
+
+  hb_buffer_destroy (b);
+}
+
 
 /* Following test table is adapted from glib/glib/tests/utf8-validate.c
  * with relicensing permission from Matthias Clasen. */
@@ -856,6 +907,196 @@ test_buffer_empty (void)
   g_assert (!hb_buffer_allocation_successful (b));
 }
 
+static void
+test_buffer_storage (void)
+{
+  /* Doubles give us malloc()-like alignment. */
+  double storage[1024];
+  hb_buffer_t *b;
+  hb_glyph_info_t *info;
+  unsigned int len, i;
+
+  b = hb_buffer_create_with_storage (storage, 4);
+  g_assert (b == hb_buffer_get_empty ());
+
+  b = hb_buffer_create_with_storage (storage, sizeof (storage));
+  g_assert (b != hb_buffer_get_empty ());
+  g_assert (hb_buffer_allocation_successful (b));
+  g_assert ((char *) b >= (char *) storage && (char *) b < (char *) storage + sizeof (storage));
+
+  hb_buffer_add_utf32 (b, utf32, G_N_ELEMENTS (utf32), 0, -1);
+  info = hb_buffer_get_glyph_infos (b, &len);
+  g_assert_cmpint (len, ==, G_N_ELEMENTS (utf32));
+  g_assert ((char *) info > (char *) storage && (char *) info < (char *) storage + sizeof (storage));
+
+  /* Outgrow the storage. */
+  for (i = 0; i < 100; i++)
+    hb_buffer_add_utf32 (b, utf32, G_N_ELEMENTS (utf32), 0, -1);
+  g_assert (hb_buffer_allocation_successful (b));
+  info = hb_buffer_get_glyph_infos (b, &len);
+  g_assert_cmpint (len, ==, 101 * G_N_ELEMENTS (utf32));
+  for (i = 0; i < len; i++)
+    g_assert_cmphex (info[i].codepoint, ==, utf32[i % G_N_ELEMENTS (utf32)]);
+
+  hb_buffer_destroy (b);
+
+  /* Reusable after destroy. */
+  b = hb_buffer_create_with_storage (storage, sizeof (storage));
+  g_assert (hb_buffer_allocation_successful (b));
+  g_assert_cmpint (hb_buffer_get_length (b), ==, 0);
+  hb_buffer_destroy (b);
+}
+
+static void
+test_buffer_serialize_binary (void)
+{
+  static const hb_codepoint_t glyphs[] = {1000, 3, 70000, 3, 0};
+  hb_buffer_t *b, *b2;
+  hb_glyph_info_t *info, *info2;
+  hb_glyph_position_t *pos, *pos2;
+  char buf[1024], out[1024];
+  const char *end;
+  unsigned int len, len2, consumed, total, start, n, i;
+
+  g_assert (hb_buffer_serialize_format_from_string ("binary", -1) == HB_BUFFER_SERIALIZE_FORMAT_BINARY);
+  g_assert_cmpstr (hb_buffer_serialize_format_to_string (HB_BUFFER_SERIALIZE_FORMAT_BINARY), ==, "binary");
+
+  b = hb_buffer_create ();
+  for (i = 0; i < G_N_ELEMENTS (glyphs); i++)
+    hb_buffer_add (b, glyphs[i], 10 - 2 * i);
+  hb_buffer_set_content_type (b, HB_BUFFER_CONTENT_TYPE_GLYPHS);
+  pos = hb_buffer_get_glyph_positions (b, &len);
+  for (i = 0; i < len; i++)
+  {
+    pos[i].x_advance = 500 + i;
+    pos[i].y_advance = -(int) i;
+    pos[i].x_offset = i % 2 ? -100000 : 0;
+    pos[i].y_offset = 7;
+  }
+
+  /* Everything at once. */
+  n = hb_buffer_serialize_glyphs (b, 0, len, buf, sizeof (buf), &consumed,
+				  NULL, HB_BUFFER_SERIALIZE_FORMAT_BINARY,
+				  HB_BUFFER_SERIALIZE_FLAG_DEFAULT);
+  g_assert_cmpuint (n, ==, len);
+
+  b2 = hb_buffer_create ();
+  g_assert (hb_buffer_deserialize_glyphs (b2, buf, consumed, &end, NULL,
+					  HB_BUFFER_SERIALIZE_FORMAT_BINARY));
+  g_assert (end == buf + consumed);
+  info = hb_buffer_get_glyph_infos (b, NULL);
+  info2 = hb_buffer_get_glyph_infos (b2, &len2);
+  pos2 = hb_buffer_get_glyph_positions (b2, NULL);
+  g_assert_cmpuint (len2, ==, len);
+  for (i = 0; i < len; i++)
+  {
+    g_assert_cmpuint (info2[i].codepoint, ==, info[i].codepoint);
+    g_assert_cmpuint (info2[i].cluster, ==, info[i].cluster);
+    g_assert_cmpint (pos2[i].x_advance, ==, pos[i].x_advance);
+    g_assert_cmpint (pos2[i].y_advance, ==, pos[i].y_advance);
+    g_assert_cmpint (pos2[i].x_offset, ==, pos[i].x_offset);
+    g_assert_cmpint (pos2[i].y_offset, ==, pos[i].y_offset);
+  }
+
+  /* In chunks through a small buffer, concatenated; and without
+   * positions. */
+  total = 0;
+  for (start = 0; start < len; start += n)
+  {
+    n = hb_buffer_serialize_glyphs (b, start, len, buf, 16, &consumed,
+				    NULL, HB_BUFFER_SERIALIZE_FORMAT_BINARY,
+				    HB_BUFFER_SERIALIZE_FLAG_NO_POSITIONS);
+    g_assert_cmpuint (n, >, 0);
+    memcpy (out + total, buf, consumed);
+    total += consumed;
+  }
+  hb_buffer_clear_contents (b2);
+  g_assert (hb_buffer_deserialize_glyphs (b2, out, total, NULL, NULL,
+					  HB_BUFFER_SERIALIZE_FORMAT_BINARY));
+  info2 = hb_buffer_get_glyph_infos (b2, &len2);
+  pos2 = hb_buffer_get_glyph_positions (b2, NULL);
+  g_assert_cmpuint (len2, ==, len);
+  for (i = 0; i < len; i++)
+  {
+    g_assert_cmpuint (info2[i].codepoint, ==, info[i].codepoint);
+    g_assert_cmpuint (info2[i].cluster, ==, info[i].cluster);
+    g_assert_cmpint (pos2[i].x_advance, ==, 0);
+  }
+
+  /* Truncated input. */
+  hb_buffer_clear_contents (b2);
+  g_assert (!hb_buffer_deserialize_glyphs (b2, out, total - 1, NULL, NULL,
+					   HB_BUFFER_SERIALIZE_FORMAT_BINARY));
+
+  hb_buffer_destroy (b2);
+  hb_buffer_destroy (b);
+}
+
+typedef struct
+{
+  char str[32768];
+  unsigned int len;
+} output_t;
+
+static hb_bool_t
+append_func (const char *data, unsigned int length, void *user_data)
+{
+  output_t *out = (output_t *) user_data;
+  g_assert_cmpuint (out->len + length, <, sizeof (out->str));
+  memcpy (out->str + out->len, data, length);
+  out->len += length;
+  out->str[out->len] = '\0';
+  return TRUE;
+}
+
+static void
+test_buffer_serialize_write (void)
+{
+  hb_buffer_t *b;
+  hb_glyph_position_t *pos;
+  static output_t s;
+  unsigned int i;
+
+  b = hb_buffer_create ();
+  hb_buffer_add (b, 1000, 0);
+  hb_buffer_add (b, 3, 4294967295u);
+  hb_buffer_set_content_type (b, HB_BUFFER_CONTENT_TYPE_GLYPHS);
+  pos = hb_buffer_get_glyph_positions (b, NULL);
+  pos[0].x_advance = 500;
+  pos[1].x_offset = -2147483647 - 1;
+  pos[1].y_offset = 7;
+  pos[1].x_advance = -10;
+  pos[1].y_advance = 2147483647;
+
+  s.len = 0;
+  g_assert (hb_buffer_serialize_glyphs_write (b, 0, 2, NULL,
+					      HB_BUFFER_SERIALIZE_FORMAT_TEXT,
+					      HB_BUFFER_SERIALIZE_FLAG_NO_GLYPH_NAMES,
+					      append_func, &s));
+  g_assert_cmpstr (s.str, ==, "1000=0+500|3=4294967295@-2147483648,7+-10,2147483647");
+
+  s.len = 0;
+  g_assert (hb_buffer_serialize_glyphs_write (b, 0, 2, NULL,
+					      HB_BUFFER_SERIALIZE_FORMAT_JSON,
+					      HB_BUFFER_SERIALIZE_FLAG_NO_GLYPH_NAMES,
+					      append_func, &s));
+  g_assert_cmpstr (s.str, ==, "{\"g\":1000,\"cl\":0,\"dx\":0,\"dy\":0,\"ax\":500,\"ay\":0},"
+				"{\"g\":3,\"cl\":4294967295,\"dx\":-2147483648,\"dy\":7,\"ax\":-10,\"ay\":2147483647}");
+
+  /* More than fits one internal chunk. */
+  for (i = 0; i < 1000; i++)
+    hb_buffer_add (b, 3, i);
+  s.len = 0;
+  g_assert (hb_buffer_serialize_glyphs_write (b, 2, hb_buffer_get_length (b), NULL,
+					      HB_BUFFER_SERIALIZE_FORMAT_TEXT,
+					      HB_BUFFER_SERIALIZE_FLAG_NO_POSITIONS,
+					      append_func, &s));
+  g_assert (g_str_has_prefix (s.str, "|gid3=0|gid3=1|"));
+  g_assert (g_str_has_suffix (s.str, "|gid3=998|gid3=999"));
+
+  hb_buffer_destroy (b);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -876,10 +1117,14 @@ main (int argc, char **argv)
   hb_test_add_fixture (fixture, GINT_TO_POINTER (BUFFER_EMPTY), test_buffer_allocation);
 
   hb_test_add (test_buffer_utf8_conversion);
+  hb_test_add (test_buffer_utf8_long_runs);
   hb_test_add (test_buffer_utf8_validity);
   hb_test_add (test_buffer_utf16_conversion);
   hb_test_add (test_buffer_utf32_conversion);
   hb_test_add (test_buffer_empty);
+  hb_test_add (test_buffer_storage);
+  hb_test_add (test_buffer_serialize_binary);
+  hb_test_add (test_buffer_serialize_write);
 
   return hb_test_run();
 }
@@ -93,6 +93,24 @@ test_collect_unicodes (void)
   hb_face_destroy (face);
 }
 
+static void
+test_covers_unicodes (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.format4.ttf");
+  const hb_codepoint_t text[] = {0x61, 0x62, 0x63, 0x64, 0x61};
+
+  g_assert_cmpuint (hb_face_covers_unicodes (face, 3, text, sizeof (text[0])), ==, 3);
+  g_assert_cmpuint (hb_face_covers_unicodes (face, 5, text, sizeof (text[0])), ==, 3);
+  g_assert_cmpuint (hb_face_covers_unicodes (face, 2, text + 3, sizeof (text[0])), ==, 0);
+  g_assert_cmpuint (hb_face_covers_unicodes (face, 0, text, sizeof (text[0])), ==, 0);
+
+  hb_face_destroy (face);
+
+  face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.format12.ttf");
+  g_assert_cmpuint (hb_face_covers_unicodes (face, 5, text, sizeof (text[0])), ==, 3);
+  hb_face_destroy (face);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -101,6 +119,7 @@ main (int argc, char **argv)
   hb_test_add (test_collect_unicodes);
   hb_test_add (test_collect_unicodes_format4);
   hb_test_add (test_collect_unicodes_format12);
+  hb_test_add (test_covers_unicodes);
 
   return hb_test_run();
 }
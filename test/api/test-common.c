@@ -204,6 +204,25 @@ test_types_language (void)
   g_assert (HB_LANGUAGE_INVALID != hb_language_from_string ("en", 1));
   g_assert (NULL == hb_language_to_string (HB_LANGUAGE_INVALID));
 
+  /* Enough languages to share buckets of the intern table. */
+  {
+    hb_language_t langs[1000];
+    char buf[32];
+    unsigned int i;
+    for (i = 0; i < G_N_ELEMENTS (langs); i++)
+    {
+      g_snprintf (buf, sizeof (buf), "x-test%u", i);
+      langs[i] = hb_language_from_string (buf, -1);
+      g_assert_cmpstr (hb_language_to_string (langs[i]), ==, buf);
+    }
+    for (i = 0; i < G_N_ELEMENTS (langs); i++)
+    {
+      g_snprintf (buf, sizeof (buf), "X_TEST%u", i);
+      g_assert (langs[i] == hb_language_from_string (buf, -1));
+    }
+    g_assert (en == hb_language_from_string ("en", -1));
+  }
+
   /* Not sure how to test this better.  Setting env vars
    * here doesn't sound like the right approach, and I'm
    * not sure that it even works. */
@@ -0,0 +1,184 @@
+/*
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb-test.h"
+
+/* Unit tests for hb-font-cache.h */
+
+
+static char *
+font_path (const char *file_name)
+{
+#if GLIB_CHECK_VERSION(2,37,2)
+  return g_test_build_filename (G_TEST_DIST, file_name, NULL);
+#else
+  return g_strdup (file_name);
+#endif
+}
+
+static void
+test_font_cache_empty (void)
+{
+  hb_font_cache_t *empty = hb_font_cache_get_empty ();
+  char *path = font_path ("fonts/Roboto-Regular.abc.ttf");
+  unsigned int count;
+
+  g_assert (hb_font_cache_get_face (empty, path, 0) == hb_face_get_empty ());
+  g_assert (hb_font_cache_get_font (empty, hb_face_get_empty (), 1000, 1000, NULL, 0) == hb_font_get_empty ());
+  hb_font_cache_get_stats (empty, &count, NULL, NULL, NULL, NULL);
+  g_assert_cmpuint (count, ==, 0);
+  hb_font_cache_destroy (empty);
+
+  g_free (path);
+}
+
+static void
+test_font_cache_face (void)
+{
+  hb_font_cache_t *cache = hb_font_cache_create (64 * 1024 * 1024);
+  char *path = font_path ("fonts/Roboto-Regular.abc.ttf");
+  unsigned int count, bytes, hits, misses;
+  hb_face_t *face1, *face2;
+
+  face1 = hb_font_cache_get_face (cache, path, 0);
+  face2 = hb_font_cache_get_face (cache, path, 0);
+  g_assert (face1 != hb_face_get_empty ());
+  g_assert (face1 == face2);
+  g_assert (hb_face_is_immutable (face1));
+  g_assert_cmpuint (hb_face_get_glyph_count (face1), ==, 4);
+  hb_face_destroy (face2);
+
+  /* Missing files are not cached. */
+  g_assert (hb_font_cache_get_face (cache, "nonexistent.ttf", 0) == hb_face_get_empty ());
+
+  hb_font_cache_get_stats (cache, &count, &bytes, &hits, &misses, NULL);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpuint (bytes, >, 0);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 2);
+
+  /* Faces handed out outlive the cache. */
+  hb_font_cache_destroy (cache);
+  g_assert_cmpuint (hb_face_get_glyph_count (face1), ==, 4);
+  hb_face_destroy (face1);
+
+  g_free (path);
+}
+
+static void
+test_font_cache_font (void)
+{
+  hb_font_cache_t *cache = hb_font_cache_create (64 * 1024 * 1024);
+  char *path = font_path ("fonts/Roboto-Regular.abc.ttf");
+  hb_variation_t variations[2];
+  hb_face_t *face;
+  hb_font_t *font1, *font2, *font3, *font4;
+  int x_scale, y_scale;
+
+  hb_variation_from_string ("wght=700", -1, &variations[0]);
+  hb_variation_from_string ("wdth=80", -1, &variations[1]);
+
+  face = hb_font_cache_get_face (cache, path, 0);
+  font1 = hb_font_cache_get_font (cache, face, 2048, 1024, NULL, 0);
+  font2 = hb_font_cache_get_font (cache, face, 2048, 1024, NULL, 0);
+  g_assert (font1 == font2);
+  g_assert (hb_font_is_immutable (font1));
+  g_assert (hb_font_get_face (font1) == face);
+  hb_font_get_scale (font1, &x_scale, &y_scale);
+  g_assert_cmpint (x_scale, ==, 2048);
+  g_assert_cmpint (y_scale, ==, 1024);
+  hb_font_destroy (font2);
+
+  font2 = hb_font_cache_get_font (cache, face, 1024, 1024, NULL, 0);
+  g_assert (font2 != font1);
+  font3 = hb_font_cache_get_font (cache, face, 2048, 1024, variations, 2);
+  g_assert (font3 != font1);
+  font4 = hb_font_cache_get_font (cache, face, 2048, 1024, variations, 2);
+  g_assert (font4 == font3);
+  hb_font_destroy (font4);
+  font4 = hb_font_cache_get_font (cache, face, 2048, 1024, variations + 1, 1);
+  g_assert (font4 != font3);
+  hb_font_destroy (font4);
+  hb_font_destroy (font3);
+
+  hb_font_destroy (font1);
+  hb_font_destroy (font2);
+  hb_face_destroy (face);
+  hb_font_cache_destroy (cache);
+
+  g_free (path);
+}
+
+static void
+test_font_cache_evict (void)
+{
+  hb_font_cache_t *cache = hb_font_cache_create (0);
+  char *path = font_path ("fonts/Roboto-Regular.abc.ttf");
+  unsigned int count, bytes, evictions;
+  hb_face_t *face;
+  hb_font_t *font;
+
+  g_assert_cmpuint (hb_font_cache_get_max_bytes (cache), ==, 0);
+
+  /* What was just added stays, even over the limit. */
+  face = hb_font_cache_get_face (cache, path, 0);
+  hb_font_cache_get_stats (cache, &count, NULL, NULL, NULL, &evictions);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpuint (evictions, ==, 0);
+
+  font = hb_font_cache_get_font (cache, face, 1000, 1000, NULL, 0);
+  hb_font_cache_get_stats (cache, &count, NULL, NULL, NULL, &evictions);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpuint (evictions, ==, 1);
+  hb_font_destroy (font);
+
+  hb_font_cache_set_max_bytes (cache, 0);
+  hb_font_cache_get_stats (cache, &count, &bytes, NULL, NULL, &evictions);
+  g_assert_cmpuint (count, ==, 0);
+  g_assert_cmpuint (bytes, ==, 0);
+  g_assert_cmpuint (evictions, ==, 2);
+
+  hb_font_cache_set_max_bytes (cache, 64 * 1024 * 1024);
+  hb_face_destroy (hb_font_cache_get_face (cache, path, 0));
+  hb_font_cache_clear (cache);
+  hb_font_cache_get_stats (cache, &count, &bytes, NULL, NULL, NULL);
+  g_assert_cmpuint (count, ==, 0);
+  g_assert_cmpuint (bytes, ==, 0);
+
+  hb_face_destroy (face);
+  hb_font_cache_destroy (cache);
+
+  g_free (path);
+}
+
+int
+main (int argc, char **argv)
+{
+  hb_test_init (&argc, &argv);
+
+  hb_test_add (test_font_cache_empty);
+  hb_test_add (test_font_cache_face);
+  hb_test_add (test_font_cache_font);
+  hb_test_add (test_font_cache_evict);
+
+  return hb_test_run();
+}
@@ -26,6 +26,8 @@
 
 #include "hb-test.h"
 
+#include <hb-ot.h>
+
 /* Unit tests for hb-font.h */
 
 
@@ -119,6 +121,197 @@ test_face_createfortables (void)
   g_assert (freed);
 }
 
+static void
+test_face_table_blob_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_blob_t *blob1, *blob2;
+
+  /* Repeated references share one sub-blob. */
+  blob1 = hb_face_reference_table (face, HB_TAG ('c','m','a','p'));
+  blob2 = hb_face_reference_table (face, HB_TAG ('c','m','a','p'));
+  g_assert (blob1 != hb_blob_get_empty ());
+  g_assert (blob1 == blob2);
+  g_assert (hb_blob_is_immutable (blob1));
+  hb_blob_destroy (blob1);
+  hb_blob_destroy (blob2);
+
+  /* ...and outlive the caller's references. */
+  blob1 = hb_face_reference_table (face, HB_TAG ('c','m','a','p'));
+  g_assert (blob1 == blob2);
+  hb_blob_destroy (blob1);
+
+  g_assert (hb_face_reference_table (face, HB_TAG ('a','b','c','d')) == hb_blob_get_empty ());
+
+  hb_face_destroy (face);
+}
+
+static void
+test_face_advise_access (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  const hb_tag_t tables[] = {HB_TAG ('c','m','a','p'), HB_TAG ('G','S','U','B'), HB_TAG ('a','b','c','d')};
+
+  /* Only hints; missing tables are fine. */
+  hb_face_advise_access (face, tables, G_N_ELEMENTS (tables), HB_FACE_ACCESS_WILL_NEED);
+  hb_face_advise_access (face, NULL, 0, HB_FACE_ACCESS_SEQUENTIAL);
+  hb_face_advise_access (hb_face_get_empty (), NULL, 0, HB_FACE_ACCESS_WILL_NEED);
+  g_assert_cmpint (hb_face_get_glyph_count (face), >, 0);
+
+  hb_face_destroy (face);
+}
+
+static void
+test_face_memory_usage (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_font_t *font;
+  hb_buffer_t *buffer;
+  unsigned int mapped;
+
+  /* Nothing loaded yet. */
+  g_assert_cmpuint (hb_face_get_memory_usage (face, HB_FACE_MEMORY_OBJECT, &mapped), >, 0);
+  g_assert_cmpuint (mapped, >, 0);
+  g_assert_cmpuint (hb_face_get_memory_usage (face, HB_FACE_MEMORY_TABLES, &mapped), ==, 0);
+  g_assert_cmpuint (mapped, ==, 0);
+  g_assert_cmpuint (hb_face_get_memory_usage (face, HB_FACE_MEMORY_ACCELERATORS, NULL), ==, 0);
+  g_assert_cmpuint (hb_face_get_memory_usage (face, HB_FACE_MEMORY_SHAPE_PLANS, NULL), ==, 0);
+
+  font = hb_font_create (face);
+  buffer = hb_buffer_create ();
+  hb_buffer_add_utf8 (buffer, "abc", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+
+  g_assert_cmpuint (hb_face_get_memory_usage (face, HB_FACE_MEMORY_TABLES, &mapped), >, 0);
+  g_assert_cmpuint (mapped, >, 0);
+  g_assert_cmpuint (hb_face_get_memory_usage (face, HB_FACE_MEMORY_ACCELERATORS, NULL), >, 0);
+  g_assert_cmpuint (hb_face_get_memory_usage (face, HB_FACE_MEMORY_SHAPE_PLANS, &mapped), >, 0);
+  g_assert_cmpuint (mapped, ==, 0);
+
+  g_assert_cmpuint (hb_font_get_memory_usage (hb_font_get_empty ()), ==, 0);
+  g_assert_cmpuint (hb_font_get_memory_usage (font), >, 0);
+  g_assert_cmpuint (hb_face_get_memory_usage (hb_face_get_empty (), HB_FACE_MEMORY_OBJECT, &mapped), ==, 0);
+  g_assert_cmpuint (mapped, ==, 0);
+
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+shape_abc (hb_font_t *font, hb_codepoint_t *glyphs, hb_position_t *advances)
+{
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_glyph_info_t *info;
+  hb_glyph_position_t *pos;
+  unsigned int len, i;
+
+  hb_buffer_add_utf8 (buffer, "abc", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+
+  info = hb_buffer_get_glyph_infos (buffer, &len);
+  pos = hb_buffer_get_glyph_positions (buffer, NULL);
+  g_assert_cmpuint (len, ==, 3);
+  for (i = 0; i < len; i++)
+  {
+    glyphs[i] = info[i].codepoint;
+    advances[i] = pos[i].x_advance;
+  }
+
+  hb_buffer_destroy (buffer);
+}
+
+static void
+test_face_trim (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_codepoint_t glyphs[3], trimmed_glyphs[3];
+  hb_position_t advances[3], trimmed_advances[3];
+  hb_glyph_extents_t extents, trimmed_extents;
+  unsigned int accelerators;
+  unsigned int i;
+
+  shape_abc (font, glyphs, advances);
+  g_assert (hb_font_get_glyph_extents (font, glyphs[0], &extents));
+  accelerators = hb_face_get_memory_usage (face, HB_FACE_MEMORY_ACCELERATORS, NULL);
+  g_assert_cmpuint (hb_face_get_memory_usage (face, HB_FACE_MEMORY_SHAPE_PLANS, NULL), >, 0);
+
+  hb_face_trim (face);
+  g_assert_cmpuint (hb_face_get_memory_usage (face, HB_FACE_MEMORY_ACCELERATORS, NULL), <, accelerators);
+  g_assert_cmpuint (hb_face_get_memory_usage (face, HB_FACE_MEMORY_SHAPE_PLANS, NULL), ==, 0);
+
+  /* Fonts created before keep working, rebuilding what they need. */
+  shape_abc (font, trimmed_glyphs, trimmed_advances);
+  for (i = 0; i < 3; i++)
+  {
+    g_assert_cmpuint (trimmed_glyphs[i], ==, glyphs[i]);
+    g_assert_cmpint (trimmed_advances[i], ==, advances[i]);
+  }
+  g_assert (hb_font_get_glyph_extents (font, glyphs[0], &trimmed_extents));
+  g_assert_cmpint (trimmed_extents.width, ==, extents.width);
+  g_assert_cmpint (trimmed_extents.height, ==, extents.height);
+
+  hb_face_trim (hb_face_get_empty ());
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static hb_blob_t *
+get_short_head (hb_face_t *face HB_UNUSED, hb_tag_t tag, void *user_data HB_UNUSED)
+{
+  if (tag == HB_TAG ('h','e','a','d'))
+    return hb_blob_create (test_data, 4, HB_MEMORY_MODE_READONLY, NULL, NULL);
+
+  return hb_blob_get_empty ();
+}
+
+static void
+test_face_trusted (void)
+{
+  hb_face_t *face, *trusted_face;
+  hb_font_t *font, *trusted_font;
+  hb_codepoint_t glyph, trusted_glyph;
+  hb_codepoint_t u;
+
+  face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  trusted_face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  g_assert (!hb_face_is_trusted (trusted_face));
+  hb_face_set_trusted (trusted_face, TRUE);
+  g_assert (hb_face_is_trusted (trusted_face));
+
+  g_assert_cmpint (hb_face_get_upem (trusted_face), ==, hb_face_get_upem (face));
+  g_assert_cmpint (hb_face_get_glyph_count (trusted_face), ==, hb_face_get_glyph_count (face));
+
+  font = hb_font_create (face);
+  trusted_font = hb_font_create (trusted_face);
+  for (u = 'a'; u <= 'c'; u++)
+  {
+    g_assert (hb_font_get_nominal_glyph (font, u, &glyph));
+    g_assert (hb_font_get_nominal_glyph (trusted_font, u, &trusted_glyph));
+    g_assert_cmpint (glyph, ==, trusted_glyph);
+    g_assert_cmpint (hb_font_get_glyph_h_advance (font, glyph), ==,
+		     hb_font_get_glyph_h_advance (trusted_font, glyph));
+  }
+  hb_font_destroy (font);
+  hb_font_destroy (trusted_font);
+  hb_face_destroy (face);
+
+  hb_face_make_immutable (trusted_face);
+  hb_face_set_trusted (trusted_face, FALSE);
+  g_assert (hb_face_is_trusted (trusted_face));
+  hb_face_destroy (trusted_face);
+
+  /* Tables too short for their header are still dropped. */
+  face = hb_face_create_for_tables (get_short_head, NULL, NULL);
+  hb_face_set_trusted (face, TRUE);
+  g_assert_cmpint (hb_face_get_upem (face), ==, 1000);
+  hb_face_destroy (face);
+}
+
 static void
 _test_font_nil_funcs (hb_font_t *font)
 {
@@ -601,6 +794,394 @@ test_font_properties (void)
   hb_font_destroy (subfont);
 }
 
+static void
+test_font_ot_cache_sizes (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_t *subfont;
+  hb_codepoint_t glyph_default, glyph;
+  hb_position_t advance_default, advance;
+  unsigned int i;
+
+  g_assert (hb_font_get_nominal_glyph (font, 'a', &glyph_default));
+  advance_default = hb_font_get_glyph_h_advance (font, glyph_default);
+
+  {
+    /* Sizes include zero (disabled) and odd and huge values. */
+    const unsigned int sizes[] = {0, 1, 3, 256, 4096, 1u << 30};
+    for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    {
+      g_assert (hb_ot_font_set_cache_sizes (font, sizes[i], sizes[i]));
+      /* Twice, to hit the cache. */
+      g_assert (hb_font_get_nominal_glyph (font, 'a', &glyph));
+      g_assert (hb_font_get_nominal_glyph (font, 'a', &glyph));
+      g_assert_cmpuint (glyph, ==, glyph_default);
+      g_assert (!hb_font_get_nominal_glyph (font, 'z', &glyph));
+      g_assert (!hb_font_get_nominal_glyph (font, 'z', &glyph));
+      advance = hb_font_get_glyph_h_advance (font, glyph_default);
+      advance = hb_font_get_glyph_h_advance (font, glyph_default);
+      g_assert_cmpint (advance, ==, advance_default);
+    }
+  }
+
+  /* Not using hb-ot funcs. */
+  subfont = hb_font_create_sub_font (font);
+  g_assert (!hb_ot_font_set_cache_sizes (subfont, 1024, 1024));
+  hb_font_destroy (subfont);
+
+  hb_font_make_immutable (font);
+  g_assert (!hb_ot_font_set_cache_sizes (font, 1024, 1024));
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_font_ot_var_coords_advances (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/AdobeVFPrototype.abc.otf");
+  hb_font_t *font = hb_font_create (face);
+  hb_position_t advances[3];
+  unsigned int i;
+
+  /* Advances must follow coords changes on the same font. */
+  {
+    const float wght[] = {900.f, 400.f, 900.f};
+    const hb_position_t expected[][3] = {{480, 659, 620}, {506, 578, 490}, {480, 659, 620}};
+    for (i = 0; i < G_N_ELEMENTS (wght); i++)
+    {
+      float coords[2] = {wght[i], i == 1 ? 50.f : 0.f};
+      hb_codepoint_t glyphs[3] = {1, 2, 3};
+      hb_font_set_var_coords_design (font, coords, 2);
+      hb_font_get_glyph_h_advances (font, 3, glyphs, sizeof (glyphs[0]), advances, sizeof (advances[0]));
+      g_assert_cmpint (advances[0], ==, expected[i][0]);
+      g_assert_cmpint (advances[1], ==, expected[i][1]);
+      g_assert_cmpint (advances[2], ==, expected[i][2]);
+      g_assert_cmpint (hb_font_get_glyph_h_advance (font, 2), ==, expected[i][1]);
+    }
+  }
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_font_var_coords (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/AdobeVFPrototype.abc.otf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_t *font2 = hb_font_create (face);
+  const float bold_coords[2] = {900.f, 0.f};
+  const hb_variation_t light_variations[] = {{HB_TAG ('w','g','h','t'), 400.f},
+					     {HB_TAG ('C','N','T','R'), 50.f}};
+  hb_var_coords_t *bold = hb_var_coords_create_design (face, bold_coords, 2);
+  hb_var_coords_t *light = hb_var_coords_create (face, light_variations, 2);
+  const int *normalized;
+  unsigned int length;
+  unsigned int i;
+
+  normalized = hb_var_coords_get_normalized (bold, &length);
+  g_assert_cmpuint (length, ==, 2);
+  g_assert_cmpint (normalized[0], ==, 16384);
+  g_assert_cmpint (normalized[1], ==, 0);
+
+  /* Switching back and forth follows the coords, on both fonts. */
+  for (i = 0; i < 3; i++)
+  {
+    hb_font_set_var_coords (font, bold);
+    hb_font_set_var_coords (font, bold);
+    g_assert_cmpint (hb_font_get_glyph_h_advance (font, 1), ==, 480);
+    g_assert_cmpint (hb_font_get_glyph_h_advance (font, 2), ==, 659);
+    hb_font_set_var_coords (font2, light);
+    g_assert_cmpint (hb_font_get_glyph_h_advance (font2, 2), ==, 578);
+    hb_font_set_var_coords (font, light);
+    g_assert_cmpint (hb_font_get_glyph_h_advance (font, 1), ==, 506);
+    g_assert_cmpint (hb_font_get_glyph_h_advance (font, 3), ==, 490);
+  }
+  normalized = hb_font_get_var_coords_normalized (font, &length);
+  g_assert_cmpuint (length, ==, 2);
+  g_assert_cmpint (normalized[1], ==, hb_var_coords_get_normalized (light, NULL)[1]);
+
+  /* Other ways of setting coords take over. */
+  hb_font_set_var_coords_design (font, bold_coords, 2);
+  g_assert_cmpint (hb_font_get_glyph_h_advance (font, 2), ==, 659);
+  hb_font_set_var_coords (font, hb_var_coords_get_empty ());
+  hb_font_get_var_coords_normalized (font, &length);
+  g_assert_cmpuint (length, ==, 0);
+
+  hb_var_coords_destroy (bold);
+  hb_font_set_var_coords (font, light);
+  hb_var_coords_destroy (light);
+  g_assert_cmpint (hb_font_get_glyph_h_advance (font, 1), ==, 506);
+
+  hb_font_destroy (font2);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_font_sub_font_var_coords (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/AdobeVFPrototype.abc.otf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_t *small, *large;
+  const float bold_coords[2] = {900.f, 0.f};
+  const float light_coords[2] = {400.f, 50.f};
+  unsigned int upem = hb_face_get_upem (face);
+  unsigned int length;
+
+  hb_font_set_var_coords_design (font, bold_coords, 2);
+  small = hb_font_create_sub_font (font);
+  large = hb_font_create_sub_font (font);
+  hb_font_set_scale (large, 2 * upem, 2 * upem);
+
+  hb_font_get_var_coords_normalized (small, &length);
+  g_assert_cmpuint (length, ==, 2);
+  g_assert_cmpint (hb_font_get_glyph_h_advance (small, 2), ==, 659);
+  g_assert_cmpint (hb_font_get_glyph_h_advance (large, 2), ==, 2 * 659);
+
+  /* Changing one sibling's coords leaves the others alone. */
+  hb_font_set_var_coords_design (small, light_coords, 2);
+  g_assert_cmpint (hb_font_get_var_coords_normalized (small, NULL)[1], !=, 0);
+  g_assert_cmpint (hb_font_get_var_coords_normalized (large, NULL)[1], ==, 0);
+  g_assert_cmpint (hb_font_get_glyph_h_advance (font, 2), ==, 659);
+
+  hb_font_destroy (font);
+  g_assert_cmpint (hb_font_get_glyph_h_advance (large, 2), ==, 2 * 659);
+
+  hb_font_destroy (small);
+  hb_font_destroy (large);
+  hb_face_destroy (face);
+}
+
+static void
+test_font_ot_var_font_extents (void)
+{
+  /* AdobeVFPrototype with its 'stro' MVAR record retagged 'hasc'. */
+  hb_face_t *face = hb_test_open_font_file ("fonts/AdobeVFPrototype.hasc.otf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_extents_t extents;
+  const float bold[2] = {900.f, 0.f};
+  unsigned int i;
+
+  hb_font_get_h_extents (font, &extents);
+  g_assert_cmpint (extents.ascender, ==, 918);
+  g_assert_cmpint (extents.descender, ==, -335);
+
+  /* Repeated queries hit the cache; coords and scale changes miss it. */
+  hb_font_set_var_coords_design (font, bold, 2);
+  for (i = 0; i < 2; i++)
+  {
+    hb_font_get_h_extents (font, &extents);
+    g_assert_cmpint (extents.ascender, ==, 926);
+    g_assert_cmpint (extents.descender, ==, -335);
+  }
+  hb_font_set_scale (font, 2000, 2000);
+  hb_font_get_h_extents (font, &extents);
+  g_assert_cmpint (extents.ascender, ==, 1852);
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static hb_bool_t
+glyph_extents_func1 (hb_font_t *font HB_UNUSED, void *font_data HB_UNUSED,
+		     hb_codepoint_t glyph,
+		     hb_glyph_extents_t *extents,
+		     void *user_data HB_UNUSED)
+{
+  if (glyph != 1)
+    return FALSE;
+
+  extents->x_bearing = 1;
+  extents->y_bearing = 2;
+  extents->width = 3;
+  extents->height = -4;
+  return TRUE;
+}
+
+static void
+test_font_glyph_extents_array (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/AdobeVFPrototype.abc.otf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_t *subfont;
+  hb_font_funcs_t *ffuncs;
+  hb_codepoint_t glyphs[4] = {1, 2, 3, 0};
+  hb_glyph_extents_t extents[4], single;
+  const float coords[2] = {900.f, 50.f};
+  unsigned int i;
+
+  /* Batched extents must match the single-glyph callback, before and
+   * after a coords change. */
+  g_assert_cmpuint (hb_font_get_glyph_extents_array (font, 4, glyphs, sizeof (glyphs[0]),
+						     extents, sizeof (extents[0])), ==, 4);
+  for (i = 0; i < 4; i++)
+  {
+    g_assert (hb_font_get_glyph_extents (font, glyphs[i], &single));
+    g_assert (!memcmp (&single, &extents[i], sizeof (single)));
+  }
+  hb_font_set_var_coords_design (font, coords, 2);
+  g_assert_cmpuint (hb_font_get_glyph_extents_array (font, 4, glyphs, sizeof (glyphs[0]),
+						     extents, sizeof (extents[0])), ==, 4);
+  for (i = 0; i < 4; i++)
+  {
+    g_assert (hb_font_get_glyph_extents (font, glyphs[i], &single));
+    g_assert (!memcmp (&single, &extents[i], sizeof (single)));
+  }
+
+  /* A sub-font scales the parent's batch. */
+  subfont = hb_font_create_sub_font (font);
+  hb_font_set_scale (subfont, 2 * hb_face_get_upem (face), 2 * hb_face_get_upem (face));
+  hb_font_get_glyph_extents_array (subfont, 4, glyphs, sizeof (glyphs[0]),
+				   extents, sizeof (extents[0]));
+  hb_font_get_glyph_extents (font, glyphs[2], &single);
+  g_assert_cmpint (extents[2].x_bearing, ==, 2 * single.x_bearing);
+  g_assert_cmpint (extents[2].height, ==, 2 * single.height);
+  hb_font_destroy (subfont);
+
+  /* Funcs implementing only the single form get a batched fallback;
+   * glyphs without extents come back zeroed. */
+  ffuncs = hb_font_funcs_create ();
+  hb_font_funcs_set_glyph_extents_func (ffuncs, glyph_extents_func1, NULL, NULL);
+  hb_font_set_funcs (font, ffuncs, NULL, NULL);
+  hb_font_funcs_destroy (ffuncs);
+  memset (extents, 0x55, sizeof (extents));
+  g_assert_cmpuint (hb_font_get_glyph_extents_array (font, 2, glyphs, sizeof (glyphs[0]),
+						     extents, sizeof (extents[0])), ==, 1);
+  g_assert_cmpint (extents[0].x_bearing, ==, 1);
+  g_assert_cmpint (extents[0].height, ==, -4);
+  g_assert_cmpint (extents[1].x_bearing, ==, 0);
+  g_assert_cmpint (extents[1].width, ==, 0);
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static hb_bool_t
+glyph_v_origin_func1 (hb_font_t *font HB_UNUSED, void *font_data HB_UNUSED,
+		      hb_codepoint_t glyph,
+		      hb_position_t *x, hb_position_t *y,
+		      void *user_data HB_UNUSED)
+{
+  if (glyph != 1)
+    return FALSE;
+
+  *x = 5;
+  *y = 6;
+  return TRUE;
+}
+
+static void
+check_glyph_v_origins (hb_font_t *font, const hb_codepoint_t *glyphs, unsigned int count)
+{
+  hb_glyph_position_t pos[4];
+  hb_position_t x, y;
+  unsigned int i;
+
+  /* Written into positions, to exercise the strides the shaper uses. */
+  g_assert (hb_font_get_glyph_v_origins (font, count, glyphs, sizeof (glyphs[0]),
+					 &pos[0].x_offset, sizeof (pos[0]),
+					 &pos[0].y_offset, sizeof (pos[0])));
+  for (i = 0; i < count; i++)
+  {
+    g_assert (hb_font_get_glyph_v_origin (font, glyphs[i], &x, &y));
+    g_assert_cmpint (pos[i].x_offset, ==, x);
+    g_assert_cmpint (pos[i].y_offset, ==, y);
+  }
+}
+
+static void
+test_font_glyph_v_origins (void)
+{
+  hb_face_t *face;
+  hb_font_t *font, *subfont;
+  hb_font_funcs_t *ffuncs;
+  hb_codepoint_t glyphs[4] = {1, 2, 3, 0};
+  hb_position_t x[2], y[2], single_x, single_y;
+  unsigned int j;
+
+  /* From VORG, and from the outlines for a font without one.  Twice,
+   * to get cached answers as well. */
+  face = hb_test_open_font_file ("fonts/SourceHanSans-Regular.41,3041,4C2E.otf");
+  font = hb_font_create (face);
+  for (j = 0; j < 2; j++)
+    check_glyph_v_origins (font, glyphs, 4);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+
+  face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  font = hb_font_create (face);
+  for (j = 0; j < 2; j++)
+    check_glyph_v_origins (font, glyphs, 4);
+
+  /* A sub-font scales the parent's batch. */
+  subfont = hb_font_create_sub_font (font);
+  hb_font_set_scale (subfont, 2 * hb_face_get_upem (face), 2 * hb_face_get_upem (face));
+  hb_font_get_glyph_v_origins (subfont, 2, glyphs, sizeof (glyphs[0]),
+			       x, sizeof (x[0]), y, sizeof (y[0]));
+  hb_font_get_glyph_v_origin (font, glyphs[1], &single_x, &single_y);
+  g_assert_cmpint (x[1], ==, 2 * single_x);
+  g_assert_cmpint (y[1], ==, 2 * single_y);
+  hb_font_destroy (subfont);
+
+  /* Funcs implementing only the single form get a batched fallback. */
+  ffuncs = hb_font_funcs_create ();
+  hb_font_funcs_set_glyph_v_origin_func (ffuncs, glyph_v_origin_func1, NULL, NULL);
+  hb_font_set_funcs (font, ffuncs, NULL, NULL);
+  hb_font_funcs_destroy (ffuncs);
+  g_assert (!hb_font_get_glyph_v_origins (font, 2, glyphs, sizeof (glyphs[0]),
+					  x, sizeof (x[0]), y, sizeof (y[0])));
+  g_assert_cmpint (x[0], ==, 5);
+  g_assert_cmpint (y[0], ==, 6);
+  g_assert_cmpint (x[1], ==, 0);
+  g_assert_cmpint (y[1], ==, 0);
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_font_cff_glyph_names (void)
+{
+  hb_face_t *face;
+  hb_font_t *font;
+  hb_codepoint_t glyph;
+  char buf[32];
+  unsigned int i, count;
+
+  /* A post table version 3 carries no names; they come from the CFF
+   * charset instead. */
+  face = hb_test_open_font_file ("fonts/cff1_expert.otf");
+  font = hb_font_create (face);
+  g_assert (hb_font_get_glyph_name (font, 1, buf, sizeof (buf)));
+  g_assert_cmpstr (buf, ==, "space");
+  g_assert (hb_font_get_glyph_name (font, 2, buf, sizeof (buf)));
+  g_assert_cmpstr (buf, ==, "dollaroldstyle");
+  g_assert (hb_font_get_glyph_from_name (font, "dollaroldstyle", -1, &glyph));
+  g_assert_cmpuint (glyph, ==, 2);
+  g_assert (!hb_font_get_glyph_from_name (font, "dollar", -1, &glyph));
+
+  count = hb_face_get_glyph_count (face);
+  for (i = 0; i < count; i++)
+  {
+    g_assert (hb_font_get_glyph_name (font, i, buf, sizeof (buf)));
+    g_assert (hb_font_get_glyph_from_name (font, buf, -1, &glyph));
+    g_assert_cmpuint (glyph, ==, i);
+  }
+  g_assert (!hb_font_get_glyph_name (font, count, buf, sizeof (buf)));
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+
+  /* CID-keyed fonts have no glyph names. */
+  face = hb_test_open_font_file ("fonts/SourceHanSans-Regular.41,4C2E.otf");
+  font = hb_font_create (face);
+  g_assert (!hb_font_get_glyph_name (font, 1, buf, sizeof (buf)));
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -609,6 +1190,11 @@ main (int argc, char **argv)
   hb_test_add (test_face_empty);
   hb_test_add (test_face_create);
   hb_test_add (test_face_createfortables);
+  hb_test_add (test_face_table_blob_cache);
+  hb_test_add (test_face_trusted);
+  hb_test_add (test_face_advise_access);
+  hb_test_add (test_face_memory_usage);
+  hb_test_add (test_face_trim);
 
   hb_test_add (test_fontfuncs_empty);
   hb_test_add (test_fontfuncs_nil);
@@ -617,6 +1203,14 @@ main (int argc, char **argv)
 
   hb_test_add (test_font_empty);
   hb_test_add (test_font_properties);
+  hb_test_add (test_font_ot_cache_sizes);
+  hb_test_add (test_font_ot_var_coords_advances);
+  hb_test_add (test_font_var_coords);
+  hb_test_add (test_font_sub_font_var_coords);
+  hb_test_add (test_font_ot_var_font_extents);
+  hb_test_add (test_font_glyph_extents_array);
+  hb_test_add (test_font_glyph_v_origins);
+  hb_test_add (test_font_cff_glyph_names);
 
   return hb_test_run();
 }
@@ -62,6 +62,40 @@ test_map_basic (void)
   hb_map_destroy (m);
 }
 
+static void
+test_map_many (void)
+{
+  hb_map_t *m = hb_map_create ();
+  unsigned int i;
+
+  /* Enough keys to grow the map several times, spaced so that many share
+   * low bits; then delete and add back some to reuse deleted slots. */
+  for (i = 0; i < 10000; i++)
+    hb_map_set (m, i * 64, i);
+  g_assert_cmpint (hb_map_get_population (m), ==, 10000);
+
+  for (i = 0; i < 10000; i += 2)
+    hb_map_del (m, i * 64);
+  g_assert_cmpint (hb_map_get_population (m), ==, 5000);
+  for (i = 0; i < 10000; i++)
+    g_assert (hb_map_has (m, i * 64) == (i % 2 == 1));
+
+  for (i = 0; i < 10000; i += 4)
+    hb_map_set (m, i * 64, i + 1);
+  hb_map_set (m, 64, 7);
+  g_assert_cmpint (hb_map_get_population (m), ==, 7500);
+  for (i = 0; i < 10000; i++)
+    if (i % 4 == 0)
+      g_assert_cmpint (hb_map_get (m, i * 64), ==, i + 1);
+    else if (i % 2 == 0)
+      g_assert (!hb_map_has (m, i * 64));
+    else
+      g_assert_cmpint (hb_map_get (m, i * 64), ==, i == 1 ? 7 : i);
+  g_assert (!hb_map_has (m, 1));
+
+  hb_map_destroy (m);
+}
+
 static void
 test_map_userdata (void)
 {
@@ -110,6 +144,7 @@ main (int argc, char **argv)
   hb_test_init (&argc, &argv);
 
   hb_test_add (test_map_basic);
+  hb_test_add (test_map_many);
   hb_test_add (test_map_userdata);
   hb_test_add (test_map_refcount);
 
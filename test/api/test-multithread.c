@@ -121,6 +121,148 @@ test_body (void)
   free (threads);
 }
 
+static void *
+first_use_thread_func (void *data)
+{
+  hb_font_t *fresh_font = (hb_font_t *) data;
+  hb_buffer_t *buffer = hb_buffer_create ();
+
+  pthread_mutex_lock (&mutex);
+  pthread_mutex_unlock (&mutex);
+
+  hb_buffer_add_utf8 (buffer, text, -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (fresh_font, buffer, NULL, 0);
+  validity_check (buffer);
+
+  hb_buffer_destroy (buffer);
+  return 0;
+}
+
+static void
+test_first_use (const char *path)
+{
+  int i, iter;
+  pthread_t *threads = calloc (num_threads, sizeof (pthread_t));
+
+  for (iter = 0; iter < num_iters; iter++)
+  {
+    /* A fresh face each round, so that all threads race to load the same
+     * tables and accelerators. */
+    hb_face_t *fresh_face = hb_test_open_font_file (path);
+    hb_font_t *fresh_font = hb_font_create (fresh_face);
+
+    pthread_mutex_lock (&mutex);
+    for (i = 0; i < num_threads; i++)
+      pthread_create (&threads[i], NULL, first_use_thread_func, fresh_font);
+    pthread_mutex_unlock (&mutex);
+
+    for (i = 0; i < num_threads; i++)
+      pthread_join (threads[i], NULL);
+
+    hb_font_destroy (fresh_font);
+    hb_face_destroy (fresh_face);
+  }
+
+  free (threads);
+}
+
+typedef struct {
+  hb_job_func_t job_func;
+  void *job_data;
+  unsigned int index;
+} job_t;
+
+static void *
+job_thread_func (void *data)
+{
+  job_t *job = (job_t *) data;
+  job->job_func (job->index, job->job_data);
+  return 0;
+}
+
+/* Runs each job on its own thread. */
+static void
+thread_executor (unsigned int count,
+		 hb_job_func_t job_func,
+		 void *job_data,
+		 void *user_data)
+{
+  unsigned int i;
+  pthread_t *threads = calloc (count, sizeof (pthread_t));
+  job_t *jobs = calloc (count, sizeof (job_t));
+
+  for (i = 0; i < count; i++)
+  {
+    jobs[i].job_func = job_func;
+    jobs[i].job_data = job_data;
+    jobs[i].index = i;
+    pthread_create (&threads[i], NULL, job_thread_func, &jobs[i]);
+  }
+  for (i = 0; i < count; i++)
+    pthread_join (threads[i], NULL);
+
+  free (jobs);
+  free (threads);
+}
+
+static void
+test_warm_up (const char *path)
+{
+  hb_face_t *face = hb_test_open_font_file (path);
+  hb_font_t *warm_font = hb_font_create (face);
+  hb_buffer_t *buffer = hb_buffer_create ();
+
+  hb_face_warm_up (face, NULL, 0, thread_executor, NULL);
+
+  hb_buffer_add_utf8 (buffer, text, -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (warm_font, buffer, NULL, 0);
+  validity_check (buffer);
+
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (warm_font);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_batch_parallel (const char *path)
+{
+  int i, iter;
+  unsigned int num_runs = num_threads * 8;
+  hb_shape_run_t *runs = calloc (num_runs, sizeof (hb_shape_run_t));
+
+  for (iter = 0; iter < 4; iter++)
+  {
+    /* A fresh font each round, so that its tables are first loaded while
+     * the jobs contend for them. */
+    hb_face_t *batch_face = hb_test_open_font_file (path);
+    hb_font_t *batch_font = hb_font_create (batch_face);
+
+    for (i = 0; i < (int) num_runs; i++)
+    {
+      runs[i].font = batch_font;
+      runs[i].buffer = hb_buffer_create ();
+      hb_buffer_add_utf8 (runs[i].buffer, text, -1, 0, -1);
+      hb_buffer_guess_segment_properties (runs[i].buffer);
+    }
+
+    g_assert (hb_shape_batch_parallel (runs, num_runs, NULL,
+				       iter ? thread_executor : NULL, NULL));
+
+    for (i = 0; i < (int) num_runs; i++)
+    {
+      validity_check (runs[i].buffer);
+      hb_buffer_destroy (runs[i].buffer);
+    }
+
+    hb_font_destroy (batch_font);
+    hb_face_destroy (batch_face);
+  }
+
+  free (runs);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -153,6 +295,19 @@ main (int argc, char **argv)
   hb_ft_font_set_funcs (font);
   test_body ();
 
+  /* Test hb-ft with fewer pooled faces than threads */
+  g_assert (hb_ft_font_set_face_pool_size (font, 4));
+  test_body ();
+
+  /* Test first use of a face from many threads at once */
+  test_first_use (path);
+
+  /* Test loading a face's tables concurrently */
+  test_warm_up (path);
+
+  /* Test shaping many paragraphs with one font concurrently */
+  test_shape_batch_parallel (path);
+
   hb_buffer_destroy (ref_buffer);
 
   hb_font_destroy (font);
@@ -342,6 +342,44 @@ test_hb_ot_color_glyph_get_layers (void)
   g_assert_cmpuint (layers[0].color_index, ==, 0);
 }
 
+static void
+test_hb_ot_color_glyphs_get_layers (void)
+{
+  hb_codepoint_t glyphs[] = {2, 0, 2, 1};
+  unsigned int starts[5];
+  hb_ot_color_layer_t layers[4];
+  unsigned int count = 4;
+
+  g_assert_cmpuint (hb_ot_color_glyphs_get_layers (cpal_v1, 4, glyphs, starts,
+						   &count, layers), ==, 4);
+  g_assert_cmpuint (count, ==, 4);
+  g_assert_cmpuint (starts[0], ==, 0);
+  g_assert_cmpuint (starts[1], ==, 2);
+  g_assert_cmpuint (starts[2], ==, 2);
+  g_assert_cmpuint (starts[3], ==, 4);
+  g_assert_cmpuint (starts[4], ==, 4);
+  g_assert_cmpuint (layers[0].glyph, ==, 3);
+  g_assert_cmpuint (layers[1].glyph, ==, 4);
+  g_assert_cmpuint (layers[2].glyph, ==, 3);
+  g_assert_cmpuint (layers[2].color_index, ==, 1);
+  g_assert_cmpuint (layers[3].glyph, ==, 4);
+  g_assert_cmpuint (layers[3].color_index, ==, 0);
+
+  /* Only whole glyphs are written. */
+  count = 3;
+  g_assert_cmpuint (hb_ot_color_glyphs_get_layers (cpal_v1, 4, glyphs, starts,
+						   &count, layers), ==, 4);
+  g_assert_cmpuint (count, ==, 2);
+  g_assert_cmpuint (starts[4], ==, 4);
+
+  g_assert_cmpuint (hb_ot_color_glyphs_get_layers (cpal_v1, 4, glyphs, NULL,
+						   NULL, NULL), ==, 4);
+  g_assert_cmpuint (hb_ot_color_glyphs_get_layers (empty, 4, glyphs, starts,
+						   &count, layers), ==, 0);
+  g_assert_cmpuint (count, ==, 0);
+  g_assert_cmpuint (starts[4], ==, 0);
+}
+
 static void
 test_hb_ot_color_has_data (void)
 {
@@ -399,6 +437,31 @@ test_hb_ot_color_svg (void)
   g_assert (hb_blob_get_length (blob) == 0);
 }
 
+static void
+test_hb_ot_color_svg_document (void)
+{
+  hb_blob_t *blob;
+  unsigned int length;
+  unsigned int index = 0;
+  hb_codepoint_t start = 0, end = 0;
+
+  g_assert (!hb_ot_color_glyph_get_svg_document (svg, 0, &index, &start, &end));
+  g_assert (!hb_ot_color_glyph_get_svg_document (empty, 1, &index, &start, &end));
+
+  g_assert (hb_ot_color_glyph_get_svg_document (svg, 1, &index, &start, &end));
+  g_assert_cmpuint (index, ==, 0);
+  g_assert_cmpuint (start, ==, 1);
+  g_assert_cmpuint (end, ==, 1);
+
+  blob = hb_ot_color_svg_reference_document (svg, index);
+  g_assert (hb_blob_get_data (blob, &length) != NULL);
+  g_assert_cmpuint (length, ==, 146);
+  hb_blob_destroy (blob);
+
+  blob = hb_ot_color_svg_reference_document (svg, 1);
+  g_assert (hb_blob_get_length (blob) == 0);
+}
+
 
 static void
 test_hb_ot_color_png (void)
@@ -430,6 +493,17 @@ test_hb_ot_color_png (void)
   g_assert_cmpint (extents.width, ==, 800);
   g_assert_cmpint (extents.height, ==, 800);
   hb_blob_destroy (blob);
+
+  /* Repeated lookups, also across a ppem change, return the same bitmap. */
+  blob = hb_ot_color_glyph_reference_png (sbix_font, 1);
+  g_assert (hb_blob_get_data (blob, &length) == data);
+  g_assert_cmpuint (length, ==, 224);
+  hb_blob_destroy (blob);
+  hb_font_set_ppem (sbix_font, 12, 12);
+  blob = hb_ot_color_glyph_reference_png (sbix_font, 1);
+  g_assert (hb_blob_get_data (blob, &length) == data);
+  g_assert_cmpuint (length, ==, 224);
+  hb_blob_destroy (blob);
   hb_font_destroy (sbix_font);
 
   /* cbdt */
@@ -475,9 +549,11 @@ main (int argc, char **argv)
   hb_test_add (test_hb_ot_color_palette_get_colors_v1);
   hb_test_add (test_hb_ot_color_palette_color_get_name_id);
   hb_test_add (test_hb_ot_color_glyph_get_layers);
+  hb_test_add (test_hb_ot_color_glyphs_get_layers);
   hb_test_add (test_hb_ot_color_has_data);
   hb_test_add (test_hb_ot_color_png);
   hb_test_add (test_hb_ot_color_svg);
+  hb_test_add (test_hb_ot_color_svg_document);
   status = hb_test_run();
   hb_face_destroy (cpal_v0);
   hb_face_destroy (cpal_v1);
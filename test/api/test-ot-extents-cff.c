@@ -120,6 +120,34 @@ test_extents_cff1_seac (void)
   hb_font_destroy (font);
 }
 
+static void
+test_extents_cff1_rescale (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/SourceSansPro-Regular.abc.otf");
+  g_assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  g_assert (font);
+  hb_ot_font_set_funcs (font);
+
+  hb_glyph_extents_t  extents;
+  hb_bool_t result = hb_font_get_glyph_extents (font, 1, &extents);
+  g_assert (result);
+  g_assert_cmpint (extents.width, ==, 381);
+
+  /* Same glyph again, now at twice the scale. */
+  hb_font_set_scale (font, 2000, 2000);
+  result = hb_font_get_glyph_extents (font, 1, &extents);
+  g_assert (result);
+
+  g_assert_cmpint (extents.x_bearing, ==, 104);
+  g_assert_cmpint (extents.y_bearing, ==, 996);
+  g_assert_cmpint (extents.width, ==, 762);
+  g_assert_cmpint (extents.height, ==, -1020);
+
+  hb_font_destroy (font);
+}
+
 static void
 test_extents_cff2 (void)
 {
@@ -192,6 +220,7 @@ main (int argc, char **argv)
   hb_test_add (test_extents_cff1);
   hb_test_add (test_extents_cff1_flex);
   hb_test_add (test_extents_cff1_seac);
+  hb_test_add (test_extents_cff1_rescale);
   hb_test_add (test_extents_cff2);
   hb_test_add (test_extents_cff2_vsindex);
 
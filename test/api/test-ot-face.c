@@ -118,6 +118,47 @@ test_ot_var_axis_on_zero_named_instance (void)
   hb_face_destroy (face);
 }
 
+static void
+test_ot_layout_find_feature (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/SourceHanSans-Regular.41,3041,4C2E.otf");
+  unsigned int script_count = hb_ot_layout_table_get_script_tags (face, HB_OT_TAG_GSUB, 0, NULL, NULL);
+  unsigned int script_index, pass;
+
+  g_assert_cmpuint (script_count, >, 1);
+
+  /* The second pass is answered from the face's LangSys cache. */
+  for (pass = 0; pass < 2; pass++)
+    for (script_index = 0; script_index < script_count; script_index++)
+    {
+      unsigned int feature_indexes[16];
+      unsigned int feature_count = G_N_ELEMENTS (feature_indexes);
+      unsigned int i, feature_index;
+
+      hb_ot_layout_language_get_feature_indexes (face, HB_OT_TAG_GSUB, script_index,
+						 HB_OT_LAYOUT_DEFAULT_LANGUAGE_INDEX,
+						 0, &feature_count, feature_indexes);
+      g_assert_cmpuint (feature_count, >, 0);
+      for (i = 0; i < feature_count; i++)
+      {
+	hb_tag_t tag;
+	unsigned int tag_count = 1;
+	hb_ot_layout_table_get_feature_tags (face, HB_OT_TAG_GSUB, feature_indexes[i], &tag_count, &tag);
+	g_assert (hb_ot_layout_language_find_feature (face, HB_OT_TAG_GSUB, script_index,
+						      HB_OT_LAYOUT_DEFAULT_LANGUAGE_INDEX,
+						      tag, &feature_index));
+	g_assert_cmpuint (feature_index, ==, feature_indexes[i]);
+      }
+
+      g_assert (!hb_ot_layout_language_find_feature (face, HB_OT_TAG_GSUB, script_index,
+						     HB_OT_LAYOUT_DEFAULT_LANGUAGE_INDEX,
+						     HB_TAG ('z','z','z','z'), &feature_index));
+      g_assert_cmpuint (feature_index, ==, HB_OT_LAYOUT_NO_FEATURE_INDEX);
+    }
+
+  hb_face_destroy (face);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -125,6 +166,7 @@ main (int argc, char **argv)
 
   hb_test_add (test_ot_face_empty);
   hb_test_add (test_ot_var_axis_on_zero_named_instance);
+  hb_test_add (test_ot_layout_find_feature);
 
   return hb_test_run();
 }
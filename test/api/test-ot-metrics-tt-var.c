@@ -0,0 +1,103 @@
+/*
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+#include "hb-test.h"
+#include <hb-ot.h>
+
+/* Unit tests for glyf/gvar glyph extents and advances */
+
+static void
+test_extents_tt_var (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/TestGVAROne.ttf");
+  g_assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  g_assert (font);
+  hb_ot_font_set_funcs (font);
+
+  hb_glyph_extents_t extents;
+  hb_bool_t result = hb_font_get_glyph_extents (font, 2, &extents);
+  g_assert (result);
+
+  g_assert_cmpint (extents.x_bearing, ==, 63);
+  g_assert_cmpint (extents.y_bearing, ==, 773);
+  g_assert_cmpint (extents.width, ==, 898);
+  g_assert_cmpint (extents.height, ==, -867);
+
+  float coords[1] = { 700.0f };
+  hb_font_set_var_coords_design (font, coords, 1);
+  result = hb_font_get_glyph_extents (font, 2, &extents);
+  g_assert (result);
+
+  g_assert_cmpint (extents.x_bearing, ==, 51);
+  g_assert_cmpint (extents.y_bearing, ==, 789);
+  g_assert_cmpint (extents.width, ==, 914);
+  g_assert_cmpint (extents.height, ==, -898);
+
+  coords[0] = 550.0f;
+  hb_font_set_var_coords_design (font, coords, 1);
+  result = hb_font_get_glyph_extents (font, 2, &extents);
+  g_assert (result);
+
+  g_assert_cmpint (extents.x_bearing, ==, 59);
+  g_assert_cmpint (extents.y_bearing, ==, 781);
+  g_assert_cmpint (extents.width, ==, 904);
+  g_assert_cmpint (extents.height, ==, -882);
+
+  hb_font_destroy (font);
+}
+
+static void
+test_advance_tt_var_nohvar (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/TestGVAROne.ttf");
+  g_assert (face);
+  hb_font_t *font = hb_font_create (face);
+  hb_face_destroy (face);
+  g_assert (font);
+  hb_ot_font_set_funcs (font);
+
+  /* No HVAR; advances come from the phantom points. */
+  g_assert_cmpint (hb_font_get_glyph_h_advance (font, 0), ==, 527);
+
+  float coords[1] = { 700.0f };
+  hb_font_set_var_coords_design (font, coords, 1);
+  g_assert_cmpint (hb_font_get_glyph_h_advance (font, 0), ==, 515);
+
+  coords[0] = 550.0f;
+  hb_font_set_var_coords_design (font, coords, 1);
+  g_assert_cmpint (hb_font_get_glyph_h_advance (font, 0), ==, 521);
+
+  hb_font_destroy (font);
+}
+
+int
+main (int argc, char **argv)
+{
+  hb_test_init (&argc, &argv);
+
+  hb_test_add (test_extents_tt_var);
+  hb_test_add (test_advance_tt_var_nohvar);
+
+  return hb_test_run ();
+}
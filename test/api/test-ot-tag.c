@@ -508,6 +508,11 @@ test_ot_tag_full (void)
   test_tags (HB_SCRIPT_MALAYALAM, "ml", 1, 1, 1, 1, "mlm3", "MAL");
   test_tags (HB_SCRIPT_INVALID, "xyz", HB_OT_MAX_TAGS_PER_SCRIPT, HB_OT_MAX_TAGS_PER_LANGUAGE, 0, 1, "XYZ");
   test_tags (HB_SCRIPT_INVALID, "xy", HB_OT_MAX_TAGS_PER_SCRIPT, HB_OT_MAX_TAGS_PER_LANGUAGE, 0, 0);
+
+  /* The language side is memoized; these hit it with other scripts and counts. */
+  test_tags (HB_SCRIPT_ARABIC, "ml", HB_OT_MAX_TAGS_PER_SCRIPT, HB_OT_MAX_TAGS_PER_LANGUAGE, 1, 2, "arab", "MAL", "MLR");
+  test_tags (HB_SCRIPT_LATIN, "x-hbot1234-hbsc5678", 0, 1, 0, 1, "1234");
+  test_tags (HB_SCRIPT_LATIN, "x-hbot1234-hbsc5678", 1, 0, 1, 0, "5678");
 }
 
 int
@@ -368,6 +368,238 @@ test_set_iter (void)
   hb_set_destroy (s);
 }
 
+static void
+test_set_add_sorted_array (void)
+{
+  hb_set_t *s = hb_set_create ();
+  hb_codepoint_t sorted[] = {6, 10, 11, 12, 13, 14, 15, 511, 512, 1100, 1200, 20005};
+  hb_codepoint_t unsorted[] = {20006, 7, 1100, 5};
+
+  hb_set_add_sorted_array (s, sorted, G_N_ELEMENTS (sorted));
+  g_assert_cmpint (hb_set_get_population (s), ==, G_N_ELEMENTS (sorted));
+  for (unsigned int i = 0; i < G_N_ELEMENTS (sorted); i++)
+    g_assert (hb_set_has (s, sorted[i]));
+  g_assert (!hb_set_has (s, 7));
+
+  /* Unsorted input is added all the same. */
+  hb_set_add_sorted_array (s, unsorted, G_N_ELEMENTS (unsorted));
+  g_assert_cmpint (hb_set_get_population (s), ==, G_N_ELEMENTS (sorted) + 3);
+  for (unsigned int i = 0; i < G_N_ELEMENTS (unsorted); i++)
+    g_assert (hb_set_has (s, unsorted[i]));
+
+  hb_set_add_sorted_array (s, NULL, 0);
+  g_assert_cmpint (hb_set_get_population (s), ==, G_N_ELEMENTS (sorted) + 3);
+
+  hb_set_destroy (s);
+}
+
+static void
+test_set_next_many (void)
+{
+  hb_set_t *s = hb_set_create ();
+  hb_codepoint_t out[8];
+
+  g_assert_cmpint (hb_set_next_many (s, HB_SET_VALUE_INVALID, out, 8), ==, 0);
+
+  hb_set_add (s, 6);
+  hb_set_add_range (s, 10, 15);
+  hb_set_add (s, 511);
+  hb_set_add (s, 512);
+  hb_set_add (s, 1100);
+  hb_set_add (s, 20005);
+
+  g_assert_cmpint (hb_set_next_many (s, HB_SET_VALUE_INVALID, out, 4), ==, 4);
+  g_assert_cmpint (out[0], ==, 6);
+  g_assert_cmpint (out[1], ==, 10);
+  g_assert_cmpint (out[3], ==, 12);
+
+  /* Continue from the last value written. */
+  g_assert_cmpint (hb_set_next_many (s, out[3], out, 8), ==, 7);
+  g_assert_cmpint (out[0], ==, 13);
+  g_assert_cmpint (out[2], ==, 15);
+  g_assert_cmpint (out[3], ==, 511);
+  g_assert_cmpint (out[4], ==, 512);
+  g_assert_cmpint (out[5], ==, 1100);
+  g_assert_cmpint (out[6], ==, 20005);
+
+  /* Starting from values on, between, and after pages. */
+  g_assert_cmpint (hb_set_next_many (s, 511, out, 1), ==, 1);
+  g_assert_cmpint (out[0], ==, 512);
+  g_assert_cmpint (hb_set_next_many (s, 2000, out, 8), ==, 1);
+  g_assert_cmpint (out[0], ==, 20005);
+  g_assert_cmpint (hb_set_next_many (s, 20005, out, 8), ==, 0);
+  g_assert_cmpint (hb_set_next_many (s, 5, out, 0), ==, 0);
+
+  /* Matches hb_set_next() on a larger set. */
+  hb_set_clear (s);
+  for (hb_codepoint_t g = 3; g < 70000; g += 7)
+    hb_set_add (s, g);
+  hb_codepoint_t next = HB_SET_VALUE_INVALID, last = HB_SET_VALUE_INVALID;
+  unsigned int count, total = 0;
+  while ((count = hb_set_next_many (s, last, out, G_N_ELEMENTS (out))))
+  {
+    for (unsigned int i = 0; i < count; i++)
+    {
+      g_assert (hb_set_next (s, &next));
+      g_assert_cmpint (out[i], ==, next);
+    }
+    last = out[count - 1];
+    total += count;
+  }
+  g_assert (!hb_set_next (s, &next));
+  g_assert_cmpint (total, ==, hb_set_get_population (s));
+
+  hb_set_destroy (s);
+}
+
+static void
+test_set_invert (void)
+{
+  hb_set_t *s = hb_set_create ();
+  hb_codepoint_t next, first, last;
+
+  hb_set_invert (s);
+  g_assert (!hb_set_is_empty (s));
+  g_assert (hb_set_has (s, 0));
+  g_assert (hb_set_has (s, HB_SET_VALUE_INVALID - 1));
+  g_assert (!hb_set_has (s, HB_SET_VALUE_INVALID));
+  g_assert_cmpint (hb_set_get_population (s), ==, HB_SET_VALUE_INVALID);
+  g_assert_cmpint (hb_set_get_min (s), ==, 0);
+  g_assert_cmpint (hb_set_get_max (s), ==, HB_SET_VALUE_INVALID - 1);
+
+  hb_set_del (s, 0);
+  hb_set_del_range (s, 10, 600);
+  hb_set_del (s, 1024);
+  hb_set_add (s, 300);
+  g_assert_cmpint (hb_set_get_population (s), ==, HB_SET_VALUE_INVALID - 1 - 591 + 1 - 1);
+  g_assert (!hb_set_has (s, 0));
+  g_assert (hb_set_has (s, 9));
+  g_assert (!hb_set_has (s, 10));
+  g_assert (hb_set_has (s, 300));
+  g_assert (!hb_set_has (s, 600));
+  g_assert (hb_set_has (s, 601));
+  g_assert_cmpint (hb_set_get_min (s), ==, 1);
+
+  next = HB_SET_VALUE_INVALID;
+  g_assert (hb_set_next (s, &next)); g_assert_cmpint (next, ==, 1);
+  next = 9;
+  g_assert (hb_set_next (s, &next)); g_assert_cmpint (next, ==, 300);
+  g_assert (hb_set_next (s, &next)); g_assert_cmpint (next, ==, 601);
+  next = 1023;
+  g_assert (hb_set_next (s, &next)); g_assert_cmpint (next, ==, 1025);
+  next = HB_SET_VALUE_INVALID - 1;
+  g_assert (!hb_set_next (s, &next)); g_assert_cmpint (next, ==, HB_SET_VALUE_INVALID);
+
+  next = 601;
+  g_assert (hb_set_previous (s, &next)); g_assert_cmpint (next, ==, 300);
+  g_assert (hb_set_previous (s, &next)); g_assert_cmpint (next, ==, 9);
+  next = 1;
+  g_assert (!hb_set_previous (s, &next)); g_assert_cmpint (next, ==, HB_SET_VALUE_INVALID);
+
+  first = last = HB_SET_VALUE_INVALID;
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 1); g_assert_cmpint (last, ==, 9);
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 300); g_assert_cmpint (last, ==, 300);
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 601); g_assert_cmpint (last, ==, 1023);
+  g_assert (hb_set_next_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 1025); g_assert_cmpint (last, ==, HB_SET_VALUE_INVALID - 1);
+  g_assert (!hb_set_next_range (s, &first, &last));
+
+  first = last = HB_SET_VALUE_INVALID;
+  g_assert (hb_set_previous_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 1025); g_assert_cmpint (last, ==, HB_SET_VALUE_INVALID - 1);
+  g_assert (hb_set_previous_range (s, &first, &last));
+  g_assert_cmpint (first, ==, 601); g_assert_cmpint (last, ==, 1023);
+
+  /* Inverting again gets the holes back. */
+  hb_set_invert (s);
+  g_assert_cmpint (hb_set_get_population (s), ==, 592);
+  g_assert_cmpint (hb_set_get_min (s), ==, 0);
+  g_assert_cmpint (hb_set_get_max (s), ==, 1024);
+
+  hb_set_destroy (s);
+}
+
+static void
+test_set_invert_algebra (void)
+{
+  hb_set_t *s = hb_set_create ();
+  hb_set_t *o = hb_set_create ();
+  hb_set_t *e = hb_set_create ();
+
+  /* s is everything but 10..19; o is 15..24. */
+  hb_set_invert (s);
+  hb_set_del_range (s, 10, 19);
+  hb_set_add_range (o, 15, 24);
+
+  hb_set_add_range (e, 10, 14);
+  hb_set_invert (e);
+  hb_set_union (s, o);
+  g_assert (hb_set_is_equal (s, e));
+  g_assert (hb_set_is_equal (e, s));
+
+  hb_set_clear (s);
+  hb_set_invert (s);
+  hb_set_del_range (s, 10, 19);
+  hb_set_intersect (s, o);
+  g_assert_cmpint (hb_set_get_population (s), ==, 5);
+  g_assert_cmpint (hb_set_get_min (s), ==, 20);
+  g_assert_cmpint (hb_set_get_max (s), ==, 24);
+
+  /* A plain set minus an inverted one. */
+  hb_set_clear (s);
+  hb_set_add_range (s, 0, 30);
+  hb_set_clear (e);
+  hb_set_invert (e);
+  hb_set_del_range (e, 5, 25);
+  hb_set_subtract (s, e);
+  g_assert_cmpint (hb_set_get_population (s), ==, 21);
+  g_assert_cmpint (hb_set_get_min (s), ==, 5);
+  g_assert_cmpint (hb_set_get_max (s), ==, 25);
+  g_assert (hb_set_is_subset (s, o) == FALSE);
+  hb_set_intersect (s, o);
+  g_assert (hb_set_is_subset (s, o));
+
+  /* Both inverted. */
+  hb_set_clear (s);
+  hb_set_invert (s);
+  hb_set_del_range (s, 0, 30);
+  hb_set_symmetric_difference (s, e);
+  g_assert_cmpint (hb_set_get_population (s), ==, 10);
+  g_assert (hb_set_has (s, 4));
+  g_assert (!hb_set_has (s, 5));
+  g_assert (hb_set_has (s, 26));
+  g_assert (!hb_set_has (s, 31));
+
+  hb_set_destroy (e);
+  hb_set_destroy (o);
+  hb_set_destroy (s);
+}
+
+static void
+test_set_intersect_pages (void)
+{
+  hb_set_t *s = hb_set_create ();
+  hb_set_t *o = hb_set_create ();
+
+  /* Pages of s that o does not have must go without disturbing the rest. */
+  for (hb_codepoint_t g = 0; g < 10000; g += 3)
+    hb_set_add (s, g);
+  for (hb_codepoint_t g = 5000; g < 20000; g += 5)
+    hb_set_add (o, g);
+  hb_set_intersect (s, o);
+  g_assert_cmpint (hb_set_get_population (s), ==, 333);
+  g_assert_cmpint (hb_set_get_min (s), ==, 5010);
+  g_assert_cmpint (hb_set_get_max (s), ==, 9990);
+  for (hb_codepoint_t g = 0; g < 20000; g++)
+    g_assert (hb_set_has (s, g) == (g >= 5000 && g < 10000 && !(g % 15)));
+
+  hb_set_destroy (o);
+  hb_set_destroy (s);
+}
+
 static void
 test_set_empty (void)
 {
@@ -403,6 +635,11 @@ main (int argc, char **argv)
   hb_test_add (test_set_basic);
   hb_test_add (test_set_algebra);
   hb_test_add (test_set_iter);
+  hb_test_add (test_set_add_sorted_array);
+  hb_test_add (test_set_next_many);
+  hb_test_add (test_set_invert);
+  hb_test_add (test_set_invert_algebra);
+  hb_test_add (test_set_intersect_pages);
   hb_test_add (test_set_empty);
 
   return hb_test_run();
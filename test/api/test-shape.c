@@ -25,6 +25,7 @@
  */
 
 #include "hb-test.h"
+#include <hb-ot.h>
 
 /* Unit tests for hb-shape.h */
 
@@ -193,6 +194,1060 @@ test_shape_list (void)
   g_assert (!strcmp (shapers[i - 1], "fallback"));
 }
 
+static void
+test_shape_set_shaper_list (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fi.ttf");
+  hb_segment_properties_t props = HB_SEGMENT_PROPERTIES_DEFAULT;
+  const char *fallback_first[] = {"nonexistent", "fallback", NULL};
+  const char **shapers;
+  hb_shape_plan_t *plan;
+
+  props.direction = HB_DIRECTION_LTR;
+  props.script = HB_SCRIPT_LATIN;
+
+  plan = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  g_assert_cmpstr (hb_shape_plan_get_shaper (plan), ==, "ot");
+  hb_shape_plan_destroy (plan);
+
+  g_assert (hb_shape_set_shaper_list (fallback_first));
+  shapers = hb_shape_list_shapers ();
+  g_assert_cmpstr (shapers[0], ==, "fallback");
+  plan = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  g_assert_cmpstr (hb_shape_plan_get_shaper (plan), ==, "fallback");
+  hb_shape_plan_destroy (plan);
+
+  /* Back to the default order. */
+  g_assert (hb_shape_set_shaper_list (NULL));
+  shapers = hb_shape_list_shapers ();
+  g_assert_cmpstr (shapers[0], ==, "ot");
+  plan = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  g_assert_cmpstr (hb_shape_plan_get_shaper (plan), ==, "ot");
+  hb_shape_plan_destroy (plan);
+
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_plan_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fi.ttf");
+  hb_segment_properties_t props = HB_SEGMENT_PROPERTIES_DEFAULT;
+  hb_shape_plan_t *plan1, *plan2, *plan3;
+  hb_feature_t feature;
+  unsigned int count, hits, misses, evictions;
+
+  props.direction = HB_DIRECTION_LTR;
+  props.script = HB_SCRIPT_LATIN;
+  props.language = hb_language_from_string ("en", -1);
+  hb_feature_from_string ("-liga", -1, &feature);
+
+  g_assert_cmpuint (hb_shape_plan_cache_get_capacity (face), >, 0);
+
+  plan1 = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  plan2 = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  g_assert (plan1 == plan2);
+  hb_shape_plan_destroy (plan2);
+
+  hb_shape_plan_cache_get_stats (face, &count, &hits, &misses, &evictions);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 1);
+  g_assert_cmpuint (evictions, ==, 0);
+
+  /* A one-entry cache evicts the older plan. */
+  hb_shape_plan_cache_set_capacity (face, 1);
+  g_assert_cmpuint (hb_shape_plan_cache_get_capacity (face), ==, 1);
+  plan3 = hb_shape_plan_create_cached (face, &props, &feature, 1, NULL);
+  g_assert (plan3 != plan1);
+  hb_shape_plan_cache_get_stats (face, &count, NULL, &misses, &evictions);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpuint (misses, ==, 2);
+  g_assert_cmpuint (evictions, ==, 1);
+
+  /* Evicted plans stay usable by their holders. */
+  g_assert_cmpstr (hb_shape_plan_get_shaper (plan1), ==, "ot");
+
+  plan2 = hb_shape_plan_create_cached (face, &props, NULL, 0, NULL);
+  g_assert (plan2 != plan1);
+  hb_shape_plan_destroy (plan2);
+
+  /* Zero capacity disables caching. */
+  hb_shape_plan_cache_set_capacity (face, 0);
+  hb_shape_plan_cache_get_stats (face, &count, NULL, NULL, NULL);
+  g_assert_cmpuint (count, ==, 0);
+  plan2 = hb_shape_plan_create_cached (face, &props, &feature, 1, NULL);
+  g_assert (plan2 != plan3);
+  hb_shape_plan_cache_get_stats (face, &count, NULL, NULL, NULL);
+  g_assert_cmpuint (count, ==, 0);
+
+  hb_shape_plan_destroy (plan1);
+  hb_shape_plan_destroy (plan2);
+  hb_shape_plan_destroy (plan3);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_plan_serialize (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fi.ttf");
+  hb_blob_t *font_blob = hb_face_reference_blob (face);
+  hb_face_t *fresh = hb_face_create (font_blob, 0);
+  hb_face_t *other = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_font_t *font;
+  hb_segment_properties_t props = HB_SEGMENT_PROPERTIES_DEFAULT;
+  hb_shape_plan_t *plan, *imported, *again;
+  hb_buffer_t *buffer;
+  hb_feature_t feature;
+  hb_blob_t *blob, *truncated;
+  unsigned int count, hits;
+
+  props.direction = HB_DIRECTION_LTR;
+  props.script = HB_SCRIPT_LATIN;
+  props.language = hb_language_from_string ("en", -1);
+  hb_feature_from_string ("-kern", -1, &feature);
+
+  plan = hb_shape_plan_create_cached (face, &props, &feature, 1, NULL);
+  blob = hb_shape_plan_serialize (plan);
+  g_assert_cmpuint (hb_blob_get_length (blob), >, 0);
+  g_assert_cmpuint (hb_blob_get_length (hb_shape_plan_serialize (hb_shape_plan_get_empty ())), ==, 0);
+
+  /* Blobs only fit faces with the same GSUB and GPOS, and must be whole. */
+  g_assert (hb_shape_plan_create_cached_from_blob (other, blob) == hb_shape_plan_get_empty ());
+  truncated = hb_blob_create_sub_blob (blob, 0, hb_blob_get_length (blob) - 4);
+  g_assert (hb_shape_plan_create_cached_from_blob (fresh, truncated) == hb_shape_plan_get_empty ());
+  hb_blob_destroy (truncated);
+
+  imported = hb_shape_plan_create_cached_from_blob (fresh, blob);
+  g_assert (imported != hb_shape_plan_get_empty ());
+  g_assert_cmpstr (hb_shape_plan_get_shaper (imported), ==, "ot");
+  again = hb_shape_plan_create_cached_from_blob (fresh, blob);
+  g_assert (again == imported);
+  hb_shape_plan_destroy (again);
+
+  /* Shaping with the same parameters uses the imported plan. */
+  font = hb_font_create (fresh);
+  buffer = hb_buffer_create ();
+  hb_buffer_add_utf8 (buffer, "fi", -1, 0, -1);
+  hb_buffer_set_segment_properties (buffer, &props);
+  hb_shape (font, buffer, &feature, 1);
+  g_assert_cmpuint (hb_buffer_get_length (buffer), ==, 1);
+  hb_shape_plan_cache_get_stats (fresh, &count, &hits, NULL, NULL);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpuint (hits, ==, 2);
+
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_shape_plan_destroy (imported);
+  hb_shape_plan_destroy (plan);
+  hb_blob_destroy (blob);
+  hb_face_destroy (other);
+  hb_face_destroy (fresh);
+  hb_blob_destroy (font_blob);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_batch (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fi.ttf");
+  hb_font_t *font = hb_font_create (face);
+  const char *texts[] = {"fi", "fifi", "fi"};
+  hb_buffer_t *buffers[3], *expected;
+  hb_shape_run_t runs[3];
+  hb_feature_t feature;
+  unsigned int i, j;
+
+  hb_feature_from_string ("-liga", -1, &feature);
+
+  memset (runs, 0, sizeof (runs));
+  for (i = 0; i < 3; i++)
+  {
+    buffers[i] = hb_buffer_create ();
+    hb_buffer_add_utf8 (buffers[i], texts[i], -1, 0, -1);
+    hb_buffer_guess_segment_properties (buffers[i]);
+    runs[i].font = font;
+    runs[i].buffer = buffers[i];
+  }
+  /* The middle run needs a different plan from its neighbours. */
+  runs[1].features = &feature;
+  runs[1].num_features = 1;
+
+  g_assert (hb_shape_batch (runs, 3, NULL));
+
+  for (i = 0; i < 3; i++)
+  {
+    unsigned int len, expected_len;
+    hb_glyph_info_t *infos, *expected_infos;
+    hb_glyph_position_t *positions, *expected_positions;
+
+    expected = hb_buffer_create ();
+    hb_buffer_add_utf8 (expected, texts[i], -1, 0, -1);
+    hb_buffer_guess_segment_properties (expected);
+    hb_shape (font, expected, runs[i].features, runs[i].num_features);
+
+    infos = hb_buffer_get_glyph_infos (buffers[i], &len);
+    positions = hb_buffer_get_glyph_positions (buffers[i], NULL);
+    expected_infos = hb_buffer_get_glyph_infos (expected, &expected_len);
+    expected_positions = hb_buffer_get_glyph_positions (expected, NULL);
+    g_assert_cmpint (hb_buffer_get_content_type (buffers[i]), ==, HB_BUFFER_CONTENT_TYPE_GLYPHS);
+    g_assert_cmpuint (len, ==, expected_len);
+    for (j = 0; j < len; j++)
+    {
+      g_assert_cmpuint (infos[j].codepoint, ==, expected_infos[j].codepoint);
+      g_assert_cmpuint (infos[j].cluster, ==, expected_infos[j].cluster);
+      g_assert_cmpint (positions[j].x_advance, ==, expected_positions[j].x_advance);
+    }
+
+    hb_buffer_destroy (expected);
+  }
+
+  /* Ligatures only form where they were not disabled. */
+  g_assert_cmpuint (hb_buffer_get_length (buffers[0]), ==, 1);
+  g_assert_cmpuint (hb_buffer_get_length (buffers[1]), ==, 4);
+  g_assert_cmpuint (hb_buffer_get_length (buffers[2]), ==, 1);
+
+  for (i = 0; i < 3; i++)
+    hb_buffer_destroy (buffers[i]);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fi.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_feature_t feature;
+  hb_glyph_info_t *infos;
+  hb_glyph_position_t *positions;
+  hb_codepoint_t glyph;
+  hb_position_t advance;
+  unsigned int len, count, hits, misses, evictions;
+
+  hb_feature_from_string ("-liga", -1, &feature);
+
+  /* Disabled by default. */
+  g_assert_cmpuint (hb_shape_cache_get_capacity (font), ==, 0);
+  hb_buffer_add_utf8 (buffer, "fi", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+  hb_shape_cache_get_stats (font, &count, &hits, &misses, NULL);
+  g_assert_cmpuint (count, ==, 0);
+  g_assert_cmpuint (hits, ==, 0);
+  g_assert_cmpuint (misses, ==, 0);
+  glyph = hb_buffer_get_glyph_infos (buffer, NULL)[0].codepoint;
+  advance = hb_buffer_get_glyph_positions (buffer, NULL)[0].x_advance;
+
+  hb_shape_cache_set_capacity (font, 2);
+  g_assert_cmpuint (hb_shape_cache_get_capacity (font), ==, 2);
+
+  /* The same word at another offset hits, with its own clusters. */
+  hb_buffer_clear_contents (buffer);
+  hb_buffer_set_content_type (buffer, HB_BUFFER_CONTENT_TYPE_UNICODE);
+  hb_buffer_add (buffer, 'f', 10);
+  hb_buffer_add (buffer, 'i', 11);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+  g_assert_cmpuint (hb_buffer_get_glyph_infos (buffer, NULL)[0].cluster, ==, 10);
+  hb_buffer_clear_contents (buffer);
+  hb_buffer_add_utf8 (buffer, "fi", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+  hb_shape_cache_get_stats (font, &count, &hits, &misses, NULL);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 1);
+
+  g_assert_cmpint (hb_buffer_get_content_type (buffer), ==, HB_BUFFER_CONTENT_TYPE_GLYPHS);
+  infos = hb_buffer_get_glyph_infos (buffer, &len);
+  positions = hb_buffer_get_glyph_positions (buffer, NULL);
+  g_assert_cmpuint (len, ==, 1);
+  g_assert_cmpuint (infos[0].codepoint, ==, glyph);
+  g_assert_cmpuint (infos[0].cluster, ==, 0);
+  g_assert_cmpint (positions[0].x_advance, ==, advance);
+
+  /* Different context, features or font settings are different entries. */
+  hb_buffer_clear_contents (buffer);
+  hb_buffer_add_utf8 (buffer, ".fi", -1, 1, 2);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+  hb_shape_cache_get_stats (font, NULL, &hits, &misses, NULL);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 2);
+  g_assert_cmpuint (hb_buffer_get_glyph_infos (buffer, NULL)[0].cluster, ==, 1);
+
+  hb_buffer_clear_contents (buffer);
+  hb_buffer_add_utf8 (buffer, "fi", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, &feature, 1);
+  g_assert_cmpuint (hb_buffer_get_length (buffer), ==, 2);
+  hb_shape_cache_get_stats (font, &count, &hits, &misses, &evictions);
+  g_assert_cmpuint (count, ==, 2);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 3);
+  g_assert_cmpuint (evictions, ==, 1);
+
+  hb_font_set_scale (font, 2 * hb_face_get_upem (face), 2 * hb_face_get_upem (face));
+  hb_buffer_clear_contents (buffer);
+  hb_buffer_add_utf8 (buffer, "fi", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+  hb_shape_cache_get_stats (font, NULL, &hits, &misses, NULL);
+  g_assert_cmpuint (hits, ==, 1);
+  g_assert_cmpuint (misses, ==, 4);
+  g_assert_cmpint (hb_buffer_get_glyph_positions (buffer, NULL)[0].x_advance, ==, advance * 2);
+
+  /* Zero capacity drops everything. */
+  hb_shape_cache_set_capacity (font, 0);
+  hb_shape_cache_get_stats (font, &count, NULL, NULL, NULL);
+  g_assert_cmpuint (count, ==, 0);
+
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+reshape_and_check (hb_font_t    *font,
+		   hb_direction_t direction,
+		   const char   *old_text,
+		   const char   *new_text,
+		   unsigned int  start,
+		   unsigned int  old_end,
+		   unsigned int  new_end)
+{
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_buffer_t *text = hb_buffer_create ();
+  hb_buffer_t *expected = hb_buffer_create ();
+  hb_glyph_info_t *infos, *expected_infos;
+  hb_glyph_position_t *positions, *expected_positions;
+  unsigned int len, expected_len, i;
+
+  hb_buffer_add_utf8 (buffer, old_text, -1, 0, -1);
+  hb_buffer_set_direction (buffer, direction);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+
+  hb_buffer_add_utf8 (text, new_text, -1, 0, -1);
+  hb_buffer_set_direction (text, direction);
+  hb_buffer_guess_segment_properties (text);
+  g_assert (hb_shape_reshape_range (font, buffer, text, start, old_end, new_end, NULL, 0));
+
+  hb_buffer_add_utf8 (expected, new_text, -1, 0, -1);
+  hb_buffer_set_direction (expected, direction);
+  hb_buffer_guess_segment_properties (expected);
+  hb_shape (font, expected, NULL, 0);
+
+  infos = hb_buffer_get_glyph_infos (buffer, &len);
+  positions = hb_buffer_get_glyph_positions (buffer, NULL);
+  expected_infos = hb_buffer_get_glyph_infos (expected, &expected_len);
+  expected_positions = hb_buffer_get_glyph_positions (expected, NULL);
+  g_assert_cmpuint (len, ==, expected_len);
+  for (i = 0; i < len; i++)
+  {
+    g_assert_cmpuint (infos[i].codepoint, ==, expected_infos[i].codepoint);
+    g_assert_cmpuint (infos[i].cluster, ==, expected_infos[i].cluster);
+    g_assert_cmpint (positions[i].x_advance, ==, expected_positions[i].x_advance);
+  }
+
+  hb_buffer_destroy (expected);
+  hb_buffer_destroy (text);
+  hb_buffer_destroy (buffer);
+}
+
+static void
+test_shape_reshape_range (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fi.ttf");
+  hb_font_t *font = hb_font_create (face);
+  unsigned int i;
+
+  for (i = 0; i < 2; i++)
+  {
+    hb_direction_t direction = i ? HB_DIRECTION_RTL : HB_DIRECTION_LTR;
+
+    /* Edit in the middle forms a ligature... */
+    reshape_and_check (font, direction, "fa fo fa", "fa fi fa", 4, 5, 5);
+    /* ...or breaks one. */
+    reshape_and_check (font, direction, "fa fi fa", "fa fo fa", 4, 5, 5);
+    /* Insertion and deletion shift the clusters after them. */
+    reshape_and_check (font, direction, "fa f fa", "fa fiii fa", 4, 4, 7);
+    reshape_and_check (font, direction, "fa fiii fa", "fa f fa", 4, 7, 4);
+    /* Edits at the ends. */
+    reshape_and_check (font, direction, "fa f", "fa fi", 4, 4, 5);
+    reshape_and_check (font, direction, "ifa", "fifa", 0, 0, 1);
+    reshape_and_check (font, direction, "fifa", "a", 0, 3, 0);
+    reshape_and_check (font, direction, "", "fi", 0, 0, 2);
+  }
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static unsigned int
+shape_glyph_flags (hb_font_t         *font,
+		   const char        *text,
+		   hb_buffer_flags_t  flags,
+		   unsigned int       i)
+{
+  hb_buffer_t *buffer = hb_buffer_create ();
+  unsigned int ret;
+
+  hb_buffer_set_flags (buffer, flags);
+  hb_buffer_add_utf8 (buffer, text, -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+  ret = hb_glyph_info_get_glyph_flags (&hb_buffer_get_glyph_infos (buffer, NULL)[i]);
+
+  hb_buffer_destroy (buffer);
+  return ret;
+}
+
+static void
+test_shape_unsafe_to_concat (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fi.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_buffer_flags_t produce = HB_BUFFER_FLAG_PRODUCE_UNSAFE_TO_CONCAT;
+
+  /* Only produced on request. */
+  g_assert_cmpuint (shape_glyph_flags (font, "fa", HB_BUFFER_FLAG_DEFAULT, 1), ==, 0);
+
+  /* The ligature lookup looked at "a" to no avail; changing it might
+   * have made it apply, but breaking before it is safe. */
+  g_assert_cmpuint (shape_glyph_flags (font, "fa", produce, 0), ==, 0);
+  g_assert_cmpuint (shape_glyph_flags (font, "fa", produce, 1), ==, HB_GLYPH_FLAG_UNSAFE_TO_CONCAT);
+  g_assert_cmpuint (shape_glyph_flags (font, "af", produce, 1), ==, 0);
+
+  /* Arabic letters next to a space don't join, but would join other text
+   * put in its place.  Glyphs are in visual order. */
+  g_assert_cmpuint (shape_glyph_flags (font, "\xd8\xa8 \xd8\xa8", produce, 0), ==, HB_GLYPH_FLAG_UNSAFE_TO_CONCAT);
+  g_assert_cmpuint (shape_glyph_flags (font, "\xd8\xa8 \xd8\xa8", produce, 1), ==, HB_GLYPH_FLAG_UNSAFE_TO_CONCAT);
+  g_assert_cmpuint (shape_glyph_flags (font, "\xd8\xa8 \xd8\xa8", produce, 2), ==, 0);
+
+  /* Unsafe to break implies unsafe to concat. */
+  g_assert_cmpuint (shape_glyph_flags (font, "\xd8\xa8\xd8\xa8", HB_BUFFER_FLAG_DEFAULT, 0), ==, HB_GLYPH_FLAG_UNSAFE_TO_BREAK);
+  g_assert_cmpuint (shape_glyph_flags (font, "\xd8\xa8\xd8\xa8", produce, 0), ==,
+		    HB_GLYPH_FLAG_UNSAFE_TO_BREAK | HB_GLYPH_FLAG_UNSAFE_TO_CONCAT);
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+shape_mark_offset (hb_font_t *font, const char *variations,
+		   hb_position_t *x_offset, hb_position_t *y_offset)
+{
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_variation_t variation;
+  hb_glyph_position_t *pos;
+
+  g_assert (hb_variation_from_string (variations, -1, &variation));
+  hb_font_set_variations (font, &variation, 1);
+
+  hb_buffer_add_utf8 (buffer, "\xd8\xb4\xd9\x92", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+
+  /* The mark comes first in visual order. */
+  g_assert_cmpuint (hb_buffer_get_length (buffer), ==, 2);
+  pos = hb_buffer_get_glyph_positions (buffer, NULL);
+  *x_offset = pos[0].x_offset;
+  *y_offset = pos[0].y_offset;
+
+  hb_buffer_destroy (buffer);
+}
+
+static void
+test_shape_anchor_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("../shaping/data/text-rendering-tests/fonts/TestGPOSFour.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_position_t x, y;
+
+  /* Mark anchors with variation deltas are cached on the font; changing
+   * the variations of that font must not reuse them. */
+  hb_font_set_scale (font, 1000, 1000);
+  shape_mark_offset (font, "wght=100", &x, &y);
+  g_assert_cmpint (x, ==, 663);
+  g_assert_cmpint (y, ==, 144);
+  shape_mark_offset (font, "wght=900", &x, &y);
+  g_assert_cmpint (x, ==, 784);
+  g_assert_cmpint (y, ==, 351);
+  shape_mark_offset (font, "wght=100", &x, &y);
+  g_assert_cmpint (x, ==, 663);
+  g_assert_cmpint (y, ==, 144);
+
+  /* Nor after a scale change. */
+  hb_font_set_scale (font, 2000, 2000);
+  shape_mark_offset (font, "wght=100", &x, &y);
+  g_assert_cmpint (x, ==, 2 * 663);
+  g_assert_cmpint (y, ==, 2 * 144);
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_scale_positions (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fi.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_t *big = hb_font_create (face);
+  unsigned int upem = hb_face_get_upem (face);
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_buffer_t *scaled = hb_buffer_create ();
+  hb_glyph_position_t *pos, *expected;
+  unsigned int len, i;
+
+  /* Shape once in font units, then scale a copy; an integer multiple
+   * of upem rounds the same as shaping at that scale directly. */
+  hb_font_set_scale (big, 2 * upem, 2 * upem);
+
+  hb_buffer_add_utf8 (buffer, "fifi fa", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+
+  hb_buffer_append (scaled, buffer, 0, -1);
+  hb_buffer_scale_positions (scaled, big);
+
+  hb_buffer_reset (buffer);
+  hb_buffer_add_utf8 (buffer, "fifi fa", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (big, buffer, NULL, 0);
+
+  g_assert_cmpuint (hb_buffer_get_length (scaled), ==, hb_buffer_get_length (buffer));
+  pos = hb_buffer_get_glyph_positions (scaled, &len);
+  expected = hb_buffer_get_glyph_positions (buffer, NULL);
+  for (i = 0; i < len; i++)
+  {
+    g_assert_cmpint (pos[i].x_advance, ==, expected[i].x_advance);
+    g_assert_cmpint (pos[i].x_offset, ==, expected[i].x_offset);
+    g_assert_cmpint (pos[i].y_offset, ==, expected[i].y_offset);
+  }
+  g_assert_cmpint (pos[0].x_advance, !=, 0);
+
+  hb_buffer_destroy (scaled);
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (big);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_max_ops (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fi.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_buffer_t *buffer = hb_buffer_create ();
+
+  g_assert_cmpuint (hb_buffer_get_max_ops (buffer), ==, 0);
+
+  /* A generous budget shapes as usual, forming the fi ligature. */
+  hb_buffer_set_max_ops (buffer, 1000000);
+  g_assert_cmpuint (hb_buffer_get_max_ops (buffer), ==, 1000000);
+  hb_buffer_add_utf8 (buffer, "fi", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  g_assert (hb_shape_full (font, buffer, NULL, 0, NULL));
+  g_assert_cmpuint (hb_buffer_get_length (buffer), ==, 1);
+
+  /* One that is too small stops before the ligature lookup. */
+  hb_buffer_clear_contents (buffer);
+  g_assert_cmpuint (hb_buffer_get_max_ops (buffer), ==, 1000000);
+  hb_buffer_set_max_ops (buffer, 1);
+  hb_buffer_add_utf8 (buffer, "fi", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  g_assert (!hb_shape_full (font, buffer, NULL, 0, NULL));
+  g_assert_cmpint (hb_buffer_get_content_type (buffer), ==, HB_BUFFER_CONTENT_TYPE_GLYPHS);
+  g_assert_cmpuint (hb_buffer_get_length (buffer), ==, 2);
+
+  hb_buffer_reset (buffer);
+  g_assert_cmpuint (hb_buffer_get_max_ops (buffer), ==, 0);
+
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_lazy_sanitize (void)
+{
+  /* This GPOS is big enough to have its lookups checked on first use;
+   * the trusted face loads it the eager way.  Both must shape alike. */
+  hb_face_t *lazy_face = hb_test_open_font_file ("../shaping/data/text-rendering-tests/fonts/Selawik-variable.ttf");
+  hb_blob_t *blob = hb_face_reference_blob (lazy_face);
+  hb_face_t *trusted_face = hb_face_create (blob, 0);
+  hb_font_t *lazy_font, *trusted_font;
+  hb_buffer_t *lazy_buffer = hb_buffer_create ();
+  hb_buffer_t *trusted_buffer = hb_buffer_create ();
+  const char *text = "AVATAR Type; fi Tj";
+  hb_glyph_position_t *lazy_pos, *trusted_pos;
+  unsigned int len, i;
+
+  hb_face_set_trusted (trusted_face, TRUE);
+  lazy_font = hb_font_create (lazy_face);
+  trusted_font = hb_font_create (trusted_face);
+
+  g_assert_cmpuint (hb_ot_layout_table_get_lookup_count (lazy_face, HB_OT_TAG_GPOS), ==,
+		    hb_ot_layout_table_get_lookup_count (trusted_face, HB_OT_TAG_GPOS));
+
+  hb_buffer_add_utf8 (lazy_buffer, text, -1, 0, -1);
+  hb_buffer_guess_segment_properties (lazy_buffer);
+  hb_shape (lazy_font, lazy_buffer, NULL, 0);
+  hb_buffer_add_utf8 (trusted_buffer, text, -1, 0, -1);
+  hb_buffer_guess_segment_properties (trusted_buffer);
+  hb_shape (trusted_font, trusted_buffer, NULL, 0);
+
+  g_assert_cmpuint (hb_buffer_get_length (lazy_buffer), ==, hb_buffer_get_length (trusted_buffer));
+  lazy_pos = hb_buffer_get_glyph_positions (lazy_buffer, &len);
+  trusted_pos = hb_buffer_get_glyph_positions (trusted_buffer, NULL);
+  for (i = 0; i < len; i++)
+  {
+    g_assert_cmpint (lazy_pos[i].x_advance, ==, trusted_pos[i].x_advance);
+    g_assert_cmpint (lazy_pos[i].x_offset, ==, trusted_pos[i].x_offset);
+    g_assert_cmpint (lazy_pos[i].y_offset, ==, trusted_pos[i].y_offset);
+  }
+  /* A kerned pair. */
+  g_assert_cmpint (lazy_pos[0].x_advance, !=, hb_font_get_glyph_h_advance (lazy_font, hb_buffer_get_glyph_infos (lazy_buffer, NULL)[0].codepoint));
+
+  hb_buffer_destroy (trusted_buffer);
+  hb_buffer_destroy (lazy_buffer);
+  hb_font_destroy (trusted_font);
+  hb_font_destroy (lazy_font);
+  hb_face_destroy (trusted_face);
+  hb_face_destroy (lazy_face);
+  hb_blob_destroy (blob);
+}
+
+static hb_codepoint_t
+shape_rtl_char (hb_font_t *font, hb_unicode_funcs_t *unicode, hb_codepoint_t u)
+{
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_codepoint_t glyph;
+
+  if (unicode)
+    hb_buffer_set_unicode_funcs (buffer, unicode);
+  hb_buffer_add_codepoints (buffer, &u, 1, 0, 1);
+  hb_buffer_set_direction (buffer, HB_DIRECTION_RTL);
+  hb_buffer_set_script (buffer, HB_SCRIPT_ARABIC);
+  hb_shape (font, buffer, NULL, 0);
+  g_assert_cmpuint (hb_buffer_get_length (buffer), ==, 1);
+  glyph = hb_buffer_get_glyph_infos (buffer, NULL)[0].codepoint;
+
+  hb_buffer_destroy (buffer);
+  return glyph;
+}
+
+static hb_codepoint_t
+identity_mirroring (hb_unicode_funcs_t *ufuncs HB_UNUSED,
+		    hb_codepoint_t unicode,
+		    void *user_data HB_UNUSED)
+{
+  return unicode;
+}
+
+static hb_bool_t
+no_close_paren_nominal_glyph (hb_font_t *font, void *font_data HB_UNUSED,
+			      hb_codepoint_t unicode,
+			      hb_codepoint_t *glyph,
+			      void *user_data HB_UNUSED)
+{
+  if (unicode == ')')
+    return FALSE;
+  return hb_font_get_nominal_glyph (hb_font_get_parent (font), unicode, glyph);
+}
+
+static void
+test_shape_mirroring (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/lcar.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_font_t *subfont;
+  hb_font_funcs_t *ffuncs;
+  hb_unicode_funcs_t *unicode;
+  hb_codepoint_t open_glyph, close_glyph;
+
+  g_assert (hb_font_get_nominal_glyph (font, '(', &open_glyph));
+  g_assert (hb_font_get_nominal_glyph (font, ')', &close_glyph));
+
+  /* The plan's precomputed mirrors, for the OpenType funcs and through
+   * a plain sub-font. */
+  g_assert_cmpuint (shape_rtl_char (font, NULL, '('), ==, close_glyph);
+  g_assert_cmpuint (shape_rtl_char (font, NULL, ')'), ==, open_glyph);
+  subfont = hb_font_create_sub_font (font);
+  g_assert_cmpuint (shape_rtl_char (subfont, NULL, '('), ==, close_glyph);
+
+  /* Font funcs that don't go by the face's cmap. */
+  ffuncs = hb_font_funcs_create ();
+  hb_font_funcs_set_nominal_glyph_func (ffuncs, no_close_paren_nominal_glyph, NULL, NULL);
+  hb_font_set_funcs (subfont, ffuncs, NULL, NULL);
+  hb_font_funcs_destroy (ffuncs);
+  g_assert_cmpuint (shape_rtl_char (subfont, NULL, '('), ==, open_glyph);
+  hb_font_destroy (subfont);
+
+  /* Unicode funcs with other mirroring data. */
+  unicode = hb_unicode_funcs_create (hb_unicode_funcs_get_default ());
+  hb_unicode_funcs_set_mirroring_func (unicode, identity_mirroring, NULL, NULL);
+  g_assert_cmpuint (shape_rtl_char (font, unicode, '('), ==, open_glyph);
+  hb_unicode_funcs_destroy (unicode);
+
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+typedef struct
+{
+  unsigned int count;
+  unsigned int lookups;
+  hb_buffer_trace_event_t last;
+} trace_log_t;
+
+static void
+trace_func (hb_buffer_t *buffer,
+	    hb_font_t *font,
+	    const hb_buffer_trace_event_t *event,
+	    void *user_data)
+{
+  trace_log_t *log = (trace_log_t *) user_data;
+  log->count++;
+  if (event->type == HB_BUFFER_TRACE_EVENT_TYPE_LOOKUP)
+  {
+    g_assert (event->table == HB_TAG ('G','S','U','B') ||
+	      event->table == HB_TAG ('G','P','O','S'));
+    log->lookups++;
+  }
+  g_assert_cmpuint (event->start_time, <=, event->end_time);
+  g_assert_cmpuint (event->end, ==, hb_buffer_get_length (buffer));
+  log->last = *event;
+}
+
+static hb_bool_t
+skip_all_message_func (hb_buffer_t *buffer,
+		       hb_font_t *font,
+		       const char *message,
+		       void *user_data)
+{
+  return FALSE;
+}
+
+static void
+test_shape_trace (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_buffer_t *buffer = hb_buffer_create ();
+  trace_log_t log = {0};
+
+  hb_buffer_set_trace_func (buffer, trace_func, &log, NULL);
+  hb_buffer_add_utf8 (buffer, "abc", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+  g_assert_cmpuint (log.lookups, >, 0);
+  g_assert_cmpuint (log.count, ==, log.lookups + 1);
+  /* The enclosing shape event ends last. */
+  g_assert_cmpint (log.last.type, ==, HB_BUFFER_TRACE_EVENT_TYPE_SHAPE);
+  g_assert_cmpuint (log.last.table, ==, 0);
+  g_assert_cmpuint (log.last.end, ==, 3);
+
+  /* Lookups a message func skips are not traced. */
+  memset (&log, 0, sizeof (log));
+  hb_buffer_set_message_func (buffer, skip_all_message_func, NULL, NULL);
+  hb_buffer_clear_contents (buffer);
+  hb_buffer_add_utf8 (buffer, "abc", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+  g_assert_cmpuint (log.lookups, ==, 0);
+  g_assert_cmpuint (log.count, ==, 1);
+  hb_buffer_set_message_func (buffer, NULL, NULL, NULL);
+
+  memset (&log, 0, sizeof (log));
+  hb_buffer_set_trace_func (buffer, NULL, NULL, NULL);
+  hb_buffer_clear_contents (buffer);
+  hb_buffer_add_utf8 (buffer, "abc", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+  g_assert_cmpuint (log.count, ==, 0);
+
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_lookup_stats (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_segment_properties_t props;
+  hb_shape_plan_t *plan;
+  hb_ot_lookup_stats_t stats[64], one;
+  unsigned int total, count, i, runs = 0, attempts = 0;
+
+  hb_buffer_add_utf8 (buffer, "abc", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_buffer_get_segment_properties (buffer, &props);
+  plan = hb_shape_plan_create (face, &props, NULL, 0, NULL);
+
+  count = G_N_ELEMENTS (stats);
+  g_assert_cmpuint (hb_ot_shape_plan_get_lookup_stats (plan, 0, &count, stats), ==, 0);
+  g_assert_cmpuint (count, ==, 0);
+
+  g_assert (hb_ot_shape_plan_enable_lookup_stats (plan));
+  g_assert (hb_shape_plan_execute (plan, font, buffer, NULL, 0));
+
+  count = G_N_ELEMENTS (stats);
+  total = hb_ot_shape_plan_get_lookup_stats (plan, 0, &count, stats);
+  g_assert_cmpuint (total, >, 0);
+  g_assert_cmpuint (count, ==, total);
+  for (i = 0; i < count; i++)
+  {
+    g_assert (stats[i].table_tag == HB_TAG ('G','S','U','B') ||
+	      stats[i].table_tag == HB_TAG ('G','P','O','S'));
+    g_assert_cmpuint (stats[i].applies, <=, stats[i].attempts);
+    g_assert_cmpuint (stats[i].runs, <=, 1);
+    runs += stats[i].runs;
+    attempts += stats[i].attempts;
+  }
+  g_assert_cmpuint (runs, >, 0);
+  g_assert_cmpuint (attempts, >, 0);
+
+  count = 1;
+  g_assert_cmpuint (hb_ot_shape_plan_get_lookup_stats (plan, total - 1, &count, &one), ==, total);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpuint (one.lookup_index, ==, stats[total - 1].lookup_index);
+
+  hb_ot_shape_plan_reset_lookup_stats (plan);
+  count = G_N_ELEMENTS (stats);
+  hb_ot_shape_plan_get_lookup_stats (plan, 0, &count, stats);
+  for (i = 0; i < count; i++)
+  {
+    g_assert_cmpuint (stats[i].runs, ==, 0);
+    g_assert_cmpuint (stats[i].attempts, ==, 0);
+  }
+
+  hb_shape_plan_destroy (plan);
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_ranged_features (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fi.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_buffer_t *buffer = hb_buffer_create ();
+  hb_feature_t features[4];
+  hb_glyph_info_t *infos;
+  unsigned int len;
+
+  /* Eight "fi" pairs; ligate only pairs 1, 3, 4 and 6.  Overlapping ranges
+   * apply in order, so later ones win. */
+  hb_feature_from_string ("-liga", -1, &features[0]);
+  hb_feature_from_string ("liga[2:4]", -1, &features[1]);
+  hb_feature_from_string ("liga[6:10]", -1, &features[2]);
+  hb_feature_from_string ("liga[12:14]", -1, &features[3]);
+  hb_buffer_add_utf8 (buffer, "fififififififi" "fi", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, features, 4);
+
+  infos = hb_buffer_get_glyph_infos (buffer, &len);
+  g_assert_cmpuint (len, ==, 4 * 1 + 4 * 2);
+  g_assert_cmpuint (infos[0].cluster, ==, 0);
+  g_assert_cmpuint (infos[1].cluster, ==, 1);
+  g_assert_cmpuint (infos[2].cluster, ==, 2);
+  g_assert_cmpuint (infos[3].cluster, ==, 4);
+  g_assert_cmpuint (infos[4].cluster, ==, 5);
+  g_assert_cmpuint (infos[5].cluster, ==, 6);
+  g_assert_cmpuint (infos[6].cluster, ==, 8);
+  g_assert_cmpuint (infos[7].cluster, ==, 10);
+  g_assert_cmpuint (infos[8].cluster, ==, 11);
+  g_assert_cmpuint (infos[9].cluster, ==, 12);
+  g_assert_cmpuint (infos[10].cluster, ==, 14);
+  g_assert_cmpuint (infos[11].cluster, ==, 15);
+
+  /* A later range switching liga off again overrides an earlier one. */
+  hb_feature_from_string ("liga", -1, &features[0]);
+  hb_feature_from_string ("-liga[2:10]", -1, &features[1]);
+  hb_feature_from_string ("liga[4:6]", -1, &features[2]);
+  hb_feature_from_string ("-liga[4:6]", -1, &features[3]);
+  hb_buffer_clear_contents (buffer);
+  hb_buffer_add_utf8 (buffer, "fififififi", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, features, 4);
+
+  g_assert_cmpuint (hb_buffer_get_length (buffer), ==, 1 * 1 + 4 * 2);
+
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_alloc_stats (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fi.ttf");
+  hb_font_t *font = hb_font_create (face);
+  hb_buffer_t *buffer;
+  hb_feature_t features[32];
+  char text[2 * 32 + 1];
+  unsigned int count, i, round;
+
+  hb_alloc_stats_reset ();
+  buffer = hb_buffer_create ();
+  if (!hb_alloc_stats_get (HB_ALLOC_SUBSYSTEM_BUFFER, &count))
+  {
+    /* Not built with HB_ALLOC_STATS. */
+    g_assert_cmpuint (count, ==, 0);
+    goto done;
+  }
+  g_assert_cmpuint (count, >, 0);
+
+  /* The first run builds the shape plan and loads the tables. */
+  hb_buffer_add_utf8 (buffer, "fi fi", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+  g_assert (hb_alloc_stats_get (HB_ALLOC_SUBSYSTEM_SHAPE_PLAN, &count));
+  g_assert_cmpuint (count, >, 0);
+  g_assert (hb_alloc_stats_get (HB_ALLOC_SUBSYSTEM_MAP, &count));
+  g_assert_cmpuint (count, >, 0);
+  g_assert (hb_alloc_stats_get (HB_ALLOC_SUBSYSTEM_ACCELERATOR, &count));
+  g_assert_cmpuint (count, >, 0);
+  g_assert (hb_alloc_stats_get (HB_ALLOC_SUBSYSTEM_SANITIZE, &count));
+  g_assert_cmpuint (count, >, 0);
+
+  /* Shaping the same text again must not allocate at all. */
+  hb_alloc_stats_reset ();
+  hb_buffer_clear_contents (buffer);
+  hb_buffer_add_utf8 (buffer, "fi fi", -1, 0, -1);
+  hb_buffer_guess_segment_properties (buffer);
+  hb_shape (font, buffer, NULL, 0);
+  for (i = HB_ALLOC_SUBSYSTEM_OTHER; i <= HB_ALLOC_SUBSYSTEM_SANITIZE; i++)
+  {
+    g_assert (hb_alloc_stats_get ((hb_alloc_subsystem_t) i, &count));
+    g_assert_cmpuint (count, ==, 0);
+  }
+
+  /* Likewise with many ranged features, once their scratch is sized. */
+  for (i = 0; i < G_N_ELEMENTS (features); i++)
+  {
+    features[i].tag = HB_TAG ('l','i','g','a');
+    features[i].value = i % 2;
+    features[i].start = 2 * i;
+    features[i].end = 2 * i + 2;
+    text[2 * i] = 'f';
+    text[2 * i + 1] = 'i';
+  }
+  text[2 * i] = '\0';
+  for (round = 0; round < 2; round++)
+  {
+    hb_alloc_stats_reset ();
+    hb_buffer_clear_contents (buffer);
+    hb_buffer_add_utf8 (buffer, text, -1, 0, -1);
+    hb_buffer_guess_segment_properties (buffer);
+    hb_shape (font, buffer, features, G_N_ELEMENTS (features));
+    g_assert_cmpuint (hb_buffer_get_length (buffer), ==, 16 * 1 + 16 * 2);
+  }
+  for (i = HB_ALLOC_SUBSYSTEM_OTHER; i <= HB_ALLOC_SUBSYSTEM_SANITIZE; i++)
+  {
+    g_assert (hb_alloc_stats_get ((hb_alloc_subsystem_t) i, &count));
+    g_assert_cmpuint (count, ==, 0);
+  }
+
+done:
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+}
+
+static void
+test_shape_get_glyphs (void)
+{
+  hb_blob_t *blob;
+  hb_face_t *face;
+  hb_font_funcs_t *ffuncs;
+  hb_font_t *font;
+  hb_buffer_t *buffer;
+  hb_codepoint_t glyphs[8];
+  uint32_t clusters[8];
+  hb_position_t x_advances[8], x_offsets[8], y_advances[8];
+  unsigned int count, i;
+
+  blob = hb_blob_create (test_data, sizeof (test_data), HB_MEMORY_MODE_READONLY, NULL, NULL);
+  face = hb_face_create (blob, 0);
+  hb_blob_destroy (blob);
+  font = hb_font_create (face);
+  hb_face_destroy (face);
+  hb_font_set_scale (font, 10, 10);
+
+  ffuncs = hb_font_funcs_create ();
+  hb_font_funcs_set_glyph_h_advance_func (ffuncs, glyph_h_advance_func, NULL, NULL);
+  hb_font_funcs_set_nominal_glyph_func (ffuncs, glyph_func, malloc (10), free);
+  hb_font_funcs_set_glyph_h_kerning_func (ffuncs, glyph_h_kerning_func, NULL, NULL);
+  hb_font_set_funcs (font, ffuncs, NULL, NULL);
+  hb_font_funcs_destroy (ffuncs);
+
+  buffer = hb_buffer_create ();
+  hb_buffer_set_direction (buffer, HB_DIRECTION_LTR);
+  hb_buffer_add_utf8 (buffer, TesT, 4, 0, 4);
+  hb_shape (font, buffer, NULL, 0);
+
+  g_assert_cmpuint (hb_buffer_get_glyphs (buffer, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL), ==, 4);
+
+  count = G_N_ELEMENTS (glyphs);
+  g_assert_cmpuint (hb_buffer_get_glyphs (buffer, 0, &count, glyphs, clusters,
+					  x_advances, y_advances, x_offsets, NULL), ==, 4);
+  g_assert_cmpuint (count, ==, 4);
+  {
+    const hb_codepoint_t output_glyphs[] = {1, 2, 3, 1};
+    const hb_position_t output_x_advances[] = {9, 5, 5, 10};
+    const hb_position_t output_x_offsets[] = {0, -1, 0, 0};
+    for (i = 0; i < count; i++) {
+      g_assert_cmphex (glyphs[i], ==, output_glyphs[i]);
+      g_assert_cmpuint (clusters[i], ==, i);
+      g_assert_cmpint (x_advances[i], ==, output_x_advances[i]);
+      g_assert_cmpint (x_offsets[i], ==, output_x_offsets[i]);
+      g_assert_cmpint (y_advances[i], ==, 0);
+    }
+  }
+
+  {
+    hb_glyph_compact_t compact[8];
+    count = G_N_ELEMENTS (compact);
+    g_assert_cmpuint (hb_buffer_get_compact_glyphs (buffer, 0, &count, compact), ==, 4);
+    g_assert_cmpuint (count, ==, 4);
+    for (i = 0; i < count; i++) {
+      g_assert_cmphex (compact[i].glyph, ==, glyphs[i]);
+      g_assert_cmpuint (compact[i].cluster, ==, clusters[i]);
+      g_assert_cmpint (compact[i].advance, ==, x_advances[i]);
+    }
+  }
+
+  /* A window in the middle, and one past the end. */
+  count = 2;
+  glyphs[0] = glyphs[1] = 0;
+  g_assert_cmpuint (hb_buffer_get_glyphs (buffer, 1, &count, glyphs, NULL,
+					  NULL, NULL, NULL, NULL), ==, 4);
+  g_assert_cmpuint (count, ==, 2);
+  g_assert_cmphex (glyphs[0], ==, 2);
+  g_assert_cmphex (glyphs[1], ==, 3);
+
+  count = 2;
+  g_assert_cmpuint (hb_buffer_get_glyphs (buffer, 5, &count, glyphs, NULL,
+					  NULL, NULL, NULL, NULL), ==, 4);
+  g_assert_cmpuint (count, ==, 0);
+
+  /* The arrays are the caller's; reusing the buffer leaves them alone. */
+  hb_buffer_clear_contents (buffer);
+  g_assert_cmphex (glyphs[0], ==, 2);
+
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -203,6 +1258,23 @@ main (int argc, char **argv)
   /* TODO test fallback shaper */
   /* TODO test shaper_full */
   hb_test_add (test_shape_list);
+  hb_test_add (test_shape_set_shaper_list);
+  hb_test_add (test_shape_plan_cache);
+  hb_test_add (test_shape_plan_serialize);
+  hb_test_add (test_shape_batch);
+  hb_test_add (test_shape_cache);
+  hb_test_add (test_shape_reshape_range);
+  hb_test_add (test_shape_unsafe_to_concat);
+  hb_test_add (test_shape_anchor_cache);
+  hb_test_add (test_shape_scale_positions);
+  hb_test_add (test_shape_max_ops);
+  hb_test_add (test_shape_lazy_sanitize);
+  hb_test_add (test_shape_mirroring);
+  hb_test_add (test_shape_trace);
+  hb_test_add (test_shape_lookup_stats);
+  hb_test_add (test_shape_ranged_features);
+  hb_test_add (test_shape_alloc_stats);
+  hb_test_add (test_shape_get_glyphs);
 
   return hb_test_run();
 }
@@ -336,6 +336,42 @@ test_subset_cff1_j_retaingids (void)
   hb_face_destroy (face_41_4c2e);
 }
 
+static void
+test_subset_cff1_reuse_face (void)
+{
+  hb_face_t *face_abc = hb_test_open_font_file ("fonts/SourceSansPro-Regular.abc.otf");
+  hb_face_t *face_ac = hb_test_open_font_file ("fonts/SourceSansPro-Regular.ac.otf");
+  hb_face_t *face_ac_nohints = hb_test_open_font_file ("fonts/SourceSansPro-Regular.ac.nohints.otf");
+  const hb_codepoint_t b = 'b';
+  const hb_codepoint_t ac[] = {'a', 'c'};
+
+  /* Parsed charstrings are kept on the source face between subsets;
+   * later subsets must not depend on what earlier ones parsed. */
+  hb_face_t *expected[] = {NULL, face_ac, face_ac_nohints, face_ac};
+  for (unsigned i = 0; i < G_N_ELEMENTS (expected); i++)
+  {
+    hb_set_t *codepoints = hb_set_create ();
+    if (i == 0)
+      hb_set_add (codepoints, b);
+    else
+      for (unsigned j = 0; j < G_N_ELEMENTS (ac); j++)
+        hb_set_add (codepoints, ac[j]);
+    hb_subset_input_t *input = hb_subset_test_create_input (codepoints);
+    hb_subset_input_set_drop_hints (input, expected[i] == face_ac_nohints);
+    hb_face_t *face_subset = hb_subset_test_create_subset (face_abc, input);
+    hb_set_destroy (codepoints);
+
+    if (expected[i])
+      hb_subset_test_check (expected[i], face_subset, HB_TAG ('C','F','F',' '));
+
+    hb_face_destroy (face_subset);
+  }
+
+  hb_face_destroy (face_abc);
+  hb_face_destroy (face_ac);
+  hb_face_destroy (face_ac_nohints);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -355,6 +391,7 @@ main (int argc, char **argv)
   hb_test_add (test_subset_cff1_dotsection);
   hb_test_add (test_subset_cff1_retaingids);
   hb_test_add (test_subset_cff1_j_retaingids);
+  hb_test_add (test_subset_cff1_reuse_face);
 
   return hb_test_run ();
 }
@@ -307,6 +307,48 @@ test_subset_glyf_retain_gids (void)
 
 // TODO(grieger): test for long loca generation.
 
+static void
+test_subset_glyf_woff2_transform (void)
+{
+  hb_face_t *face_abc = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+
+  hb_set_t *codepoints = hb_set_create();
+  hb_subset_input_t *input;
+  hb_face_t *face_abc_subset;
+  hb_set_add (codepoints, 'a');
+  hb_set_add (codepoints, 'c');
+  input = hb_subset_test_create_input (codepoints);
+  hb_subset_input_set_woff2_glyf_transform (input, true);
+  face_abc_subset = hb_subset_test_create_subset (face_abc, input);
+  hb_set_destroy (codepoints);
+
+  hb_blob_t *loca = hb_face_reference_table (face_abc_subset, HB_TAG ('l','o','c','a'));
+  g_assert_cmpuint (hb_blob_get_length (loca), ==, 0);
+  hb_blob_destroy (loca);
+
+  /* Header: reserved, optionFlags, numGlyphs, indexFormat, then the
+   * sizes of the seven streams that make up the rest of the table. */
+  unsigned int length;
+  hb_blob_t *glyf = hb_face_reference_table (face_abc_subset, HB_TAG ('g','l','y','f'));
+  const uint8_t *data = (const uint8_t *) hb_blob_get_data (glyf, &length);
+  g_assert_cmpuint (length, >=, 36);
+  g_assert_cmpuint ((data[4] << 8) | data[5], ==, 3);
+  g_assert_cmpuint ((data[6] << 8) | data[7], ==, 0);
+  unsigned int total = 36;
+  for (unsigned int i = 0; i < 7; i++)
+    total += (data[8 + 4 * i] << 24) | (data[9 + 4 * i] << 16) |
+	     (data[10 + 4 * i] << 8) | data[11 + 4 * i];
+  g_assert_cmpuint (total, ==, length);
+  /* nContourStream: .notdef, then the two simple glyphs. */
+  g_assert_cmpuint ((data[8] << 24) | (data[9] << 16) | (data[10] << 8) | data[11], ==, 6);
+  hb_blob_destroy (glyf);
+
+  check_maxp_num_glyphs(face_abc_subset, 3, true);
+
+  hb_face_destroy (face_abc_subset);
+  hb_face_destroy (face_abc);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -322,6 +364,7 @@ main (int argc, char **argv)
   hb_test_add (test_subset_glyf_with_gsub);
   hb_test_add (test_subset_glyf_without_gsub);
   hb_test_add (test_subset_glyf_retain_gids);
+  hb_test_add (test_subset_glyf_woff2_transform);
 
   return hb_test_run();
 }
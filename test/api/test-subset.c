@@ -27,6 +27,8 @@
 #include "hb-test.h"
 #include "hb-subset-test.h"
 
+#include <hb-ot.h>
+
 /* Unit tests for hb-subset-glyf.h */
 
 static void
@@ -95,6 +97,270 @@ test_subset_crash (void)
   hb_face_destroy (face);
 }
 
+static void
+reverse_executor (unsigned int   count,
+		  hb_job_func_t  job_func,
+		  void          *job_data,
+		  void          *user_data)
+{
+  unsigned int *calls = (unsigned int *) user_data;
+  while (count--)
+  {
+    job_func (count, job_data);
+    (*calls)++;
+  }
+}
+
+static void
+test_subset_executor (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.abc.ttf");
+  unsigned int calls = 0;
+
+  hb_subset_input_t *input = hb_subset_input_create_or_fail ();
+  hb_set_add (hb_subset_input_unicode_set (input), 'a');
+  hb_set_add (hb_subset_input_unicode_set (input), 'c');
+  hb_subset_input_set_drop_layout (input, false);
+
+  hb_face_t *expected = hb_subset (face, input);
+  hb_subset_input_set_executor (input, reverse_executor, &calls);
+  hb_face_t *subset = hb_subset (face, input);
+  g_assert (subset != hb_face_get_empty ());
+  g_assert_cmpuint (calls, >, 1);
+
+  hb_blob_t *expected_blob = hb_face_reference_blob (expected);
+  hb_blob_t *subset_blob = hb_face_reference_blob (subset);
+  unsigned int expected_length, subset_length;
+  const char *expected_data = hb_blob_get_data (expected_blob, &expected_length);
+  const char *subset_data = hb_blob_get_data (subset_blob, &subset_length);
+  g_assert_cmpmem (expected_data, expected_length, subset_data, subset_length);
+
+  hb_blob_destroy (expected_blob);
+  hb_blob_destroy (subset_blob);
+  hb_subset_input_destroy (input);
+  hb_face_destroy (subset);
+  hb_face_destroy (expected);
+  hb_face_destroy (face);
+}
+
+/* With retained glyph ids the output has enough glyphs for the CFF
+ * table to be split into several glyph jobs. */
+static void
+test_subset_executor_cff (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("../subset/data/fonts/SourceHanSans-Regular_subset.otf");
+  unsigned int i;
+
+  for (i = 0; i < 4; i++)
+  {
+    unsigned int calls = 0;
+    hb_subset_input_t *input = hb_subset_input_create_or_fail ();
+    hb_set_add (hb_subset_input_unicode_set (input), 0x3042);
+    hb_set_add (hb_subset_input_unicode_set (input), 0x8F38);
+    hb_subset_input_set_retain_gids (input, true);
+    hb_subset_input_set_desubroutinize (input, i & 1);
+    hb_subset_input_set_drop_hints (input, i & 2);
+
+    hb_face_t *expected = hb_subset (face, input);
+    hb_subset_input_set_executor (input, reverse_executor, &calls);
+    hb_face_t *subset = hb_subset (face, input);
+    g_assert (subset != hb_face_get_empty ());
+    g_assert_cmpuint (hb_face_get_glyph_count (subset), >, 256);
+    /* More jobs than there are tables. */
+    g_assert_cmpuint (calls, >, hb_face_get_table_tags (face, 0, NULL, NULL));
+
+    hb_blob_t *expected_cff = hb_face_reference_table (expected, HB_TAG ('C','F','F',' '));
+    hb_blob_t *subset_cff = hb_face_reference_table (subset, HB_TAG ('C','F','F',' '));
+    unsigned int expected_length, subset_length;
+    const char *expected_data = hb_blob_get_data (expected_cff, &expected_length);
+    const char *subset_data = hb_blob_get_data (subset_cff, &subset_length);
+    g_assert_cmpuint (expected_length, >, 0);
+    g_assert_cmpmem (expected_data, expected_length, subset_data, subset_length);
+
+    hb_blob_destroy (expected_cff);
+    hb_blob_destroy (subset_cff);
+    hb_subset_input_destroy (input);
+    hb_face_destroy (subset);
+    hb_face_destroy (expected);
+  }
+
+  hb_face_destroy (face);
+}
+
+typedef struct
+{
+  char data[65536];
+  unsigned int length;
+} write_buffer_t;
+
+static hb_bool_t
+append_func (const char *data, unsigned int length, void *user_data)
+{
+  write_buffer_t *buffer = (write_buffer_t *) user_data;
+  if (length > sizeof (buffer->data) - buffer->length)
+    return FALSE;
+  memcpy (buffer->data + buffer->length, data, length);
+  buffer->length += length;
+  return TRUE;
+}
+
+static hb_bool_t
+fail_func (const char *data HB_UNUSED, unsigned int length HB_UNUSED, void *user_data HB_UNUSED)
+{
+  return FALSE;
+}
+
+static void
+test_subset_builder_write (void)
+{
+  const char *fonts[] = {
+    "fonts/Roboto-Regular.abc.ttf",
+    "fonts/SourceSansPro-Regular.abc.otf",
+  };
+  for (unsigned int i = 0; i < G_N_ELEMENTS (fonts); i++)
+  {
+    hb_face_t *face = hb_test_open_font_file (fonts[i]);
+
+    hb_subset_input_t *input = hb_subset_input_create_or_fail ();
+    hb_set_add (hb_subset_input_unicode_set (input), 'a');
+    hb_set_add (hb_subset_input_unicode_set (input), 'c');
+    hb_face_t *subset = hb_subset (face, input);
+    g_assert (subset != hb_face_get_empty ());
+
+    /* Streamed output matches the compiled blob byte for byte. */
+    hb_blob_t *blob = hb_face_reference_blob (subset);
+    unsigned int length;
+    const char *data = hb_blob_get_data (blob, &length);
+    static write_buffer_t written;
+    written.length = 0;
+    g_assert (hb_face_builder_write (subset, append_func, &written));
+    g_assert_cmpmem (data, length, written.data, written.length);
+
+    g_assert (!hb_face_builder_write (subset, fail_func, NULL));
+    g_assert (!hb_face_builder_write (face, append_func, &written));
+
+    /* So does the scatter list, fetched in two pieces. */
+    hb_blob_t *blobs[64];
+    unsigned int total = hb_face_builder_get_blobs (subset, 0, NULL, NULL);
+    g_assert_cmpuint (total, >, 2);
+    g_assert_cmpuint (total, <=, G_N_ELEMENTS (blobs));
+    unsigned int count = 2;
+    g_assert_cmpuint (hb_face_builder_get_blobs (subset, 0, &count, blobs), ==, total);
+    g_assert_cmpuint (count, ==, 2);
+    count = G_N_ELEMENTS (blobs) - 2;
+    hb_face_builder_get_blobs (subset, 2, &count, blobs + 2);
+    g_assert_cmpuint (count, ==, total - 2);
+    written.length = 0;
+    for (unsigned int j = 0; j < total; j++)
+    {
+      unsigned int blob_length;
+      const char *blob_data = hb_blob_get_data (blobs[j], &blob_length);
+      g_assert (append_func (blob_data, blob_length, &written));
+      hb_blob_destroy (blobs[j]);
+    }
+    g_assert_cmpmem (data, length, written.data, written.length);
+
+    count = 1;
+    g_assert_cmpuint (hb_face_builder_get_blobs (face, 0, &count, blobs), ==, 0);
+    g_assert_cmpuint (count, ==, 0);
+
+    hb_blob_destroy (blob);
+    hb_subset_input_destroy (input);
+    hb_face_destroy (subset);
+    hb_face_destroy (face);
+  }
+}
+
+static void
+glyphs_of (hb_face_t *face, const char *text, hb_set_t *glyphs)
+{
+  hb_font_t *font = hb_font_create (face);
+  hb_set_clear (glyphs);
+  for (const char *p = text; *p; p++)
+  {
+    hb_codepoint_t gid;
+    if (hb_font_get_nominal_glyph (font, *p, &gid))
+      hb_set_add (glyphs, gid);
+  }
+  hb_font_destroy (font);
+}
+
+static void
+closure_of (hb_face_t *face, const char *text, hb_set_t *glyphs)
+{
+  glyphs_of (face, text, glyphs);
+  hb_ot_layout_lookups_substitute_closure (face, NULL, glyphs);
+}
+
+static void
+check_closure (hb_face_t *face, const char *text)
+{
+  hb_face_t *fresh_face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fil.ttf");
+  hb_set_t *glyphs = hb_set_create ();
+  hb_set_t *expected = hb_set_create ();
+
+  closure_of (face, text, glyphs);
+  closure_of (fresh_face, text, expected);
+  g_assert (hb_set_is_equal (glyphs, expected));
+
+  hb_set_destroy (glyphs);
+  hb_set_destroy (expected);
+  hb_face_destroy (fresh_face);
+}
+
+static void
+interleaving_executor (unsigned int   count,
+		       hb_job_func_t  job_func,
+		       void          *job_data,
+		       void          *user_data)
+{
+  unsigned int *calls = (unsigned int *) user_data;
+  for (unsigned int i = 0; i < count; i += 2)
+    job_func (i, job_data);
+  for (unsigned int i = 1; i < count; i += 2)
+    job_func (i, job_data);
+  (*calls)++;
+}
+
+static void
+test_subset_closure_parallel (void)
+{
+  /* Enough lookups for several jobs per pass. */
+  hb_face_t *face = hb_test_open_font_file ("fonts/nameID.origin.ttf");
+  hb_face_t *parallel_face = hb_test_open_font_file ("fonts/nameID.origin.ttf");
+  hb_set_t *glyphs = hb_set_create ();
+  hb_set_t *expected = hb_set_create ();
+  unsigned int calls = 0;
+
+  closure_of (face, "fi1/2", expected);
+  glyphs_of (parallel_face, "fi1/2", glyphs);
+  hb_ot_layout_lookups_substitute_closure_parallel (parallel_face, NULL, glyphs,
+						    interleaving_executor, &calls);
+  g_assert_cmpuint (calls, >, 0);
+  g_assert (hb_set_is_equal (glyphs, expected));
+
+  hb_set_destroy (expected);
+  hb_set_destroy (glyphs);
+  hb_face_destroy (parallel_face);
+  hb_face_destroy (face);
+}
+
+static void
+test_subset_closure_cache (void)
+{
+  hb_face_t *face = hb_test_open_font_file ("fonts/Roboto-Regular.gsub.fil.ttf");
+
+  /* Closures over supersets of earlier inputs start from the cached
+   * results; they must match closures computed from scratch. */
+  check_closure (face, "f");
+  check_closure (face, "fil");
+  check_closure (face, "fi");
+  check_closure (face, "i");
+  check_closure (face, "fil");
+
+  hb_face_destroy (face);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -103,6 +369,11 @@ main (int argc, char **argv)
   hb_test_add (test_subset_32_tables);
   hb_test_add (test_subset_no_inf_loop);
   hb_test_add (test_subset_crash);
+  hb_test_add (test_subset_executor);
+  hb_test_add (test_subset_executor_cff);
+  hb_test_add (test_subset_builder_write);
+  hb_test_add (test_subset_closure_cache);
+  hb_test_add (test_subset_closure_parallel);
 
   return hb_test_run();
 }
@@ -661,6 +661,67 @@ test_unicode_subclassing_deep (data_fixture_t *f, gconstpointer user_data HB_UNU
   g_assert (f->data[0].freed && f->data[1].freed);
 }
 
+static void
+all_is_hebrew_get_script_batch (hb_unicode_funcs_t   *ufuncs HB_UNUSED,
+				unsigned int          count,
+				const hb_codepoint_t *first_unicode HB_UNUSED,
+				unsigned int          unicode_stride HB_UNUSED,
+				hb_script_t          *first_script,
+				unsigned int          script_stride,
+				void                 *user_data)
+{
+  data_t *data = (data_t *) user_data;
+  unsigned int i;
+
+  g_assert (data->value == MAGIC0);
+  for (i = 0; i < count; i++)
+    *(hb_script_t *) ((char *) first_script + i * script_stride) = HB_SCRIPT_HEBREW;
+}
+
+static hb_script_t
+guess_script (hb_unicode_funcs_t *uf, const char *text)
+{
+  hb_buffer_t *b = hb_buffer_create ();
+  hb_script_t script;
+
+  hb_buffer_set_unicode_funcs (b, uf);
+  hb_buffer_add_utf8 (b, text, -1, 0, -1);
+  hb_buffer_guess_segment_properties (b);
+  script = hb_buffer_get_script (b);
+  hb_buffer_destroy (b);
+
+  return script;
+}
+
+static void
+test_unicode_subclassing_batch (data_fixture_t *f, gconstpointer user_data HB_UNUSED)
+{
+  hb_unicode_funcs_t *uf, *aa;
+  data_t data = {MAGIC1, FALSE};
+
+  uf = hb_unicode_funcs_get_default ();
+  aa = hb_unicode_funcs_create (uf);
+
+  /* The default batch callback follows the simple one. */
+  hb_unicode_funcs_set_script_func (aa, a_is_for_arabic_get_script,
+                                    &f->data[1], free_up);
+  g_assert_cmphex (guess_script (aa, "a"), ==, HB_SCRIPT_ARABIC);
+  g_assert_cmphex (guess_script (aa, "b"), ==, HB_SCRIPT_LATIN);
+
+  hb_unicode_funcs_set_script_batch_func (aa, all_is_hebrew_get_script_batch,
+                                          &f->data[0], free_up);
+  g_assert_cmphex (guess_script (aa, "a"), ==, HB_SCRIPT_HEBREW);
+  g_assert_cmphex (hb_unicode_script (aa, 'a'), ==, HB_SCRIPT_ARABIC);
+
+  /* Setting the simple callback again resets the batch one. */
+  g_assert (!f->data[0].freed && !f->data[1].freed);
+  hb_unicode_funcs_set_script_func (aa, a_is_for_arabic_get_script,
+                                    &data, NULL);
+  g_assert (f->data[0].freed && f->data[1].freed);
+  g_assert_cmphex (guess_script (aa, "a"), ==, HB_SCRIPT_ARABIC);
+
+  hb_unicode_funcs_destroy (aa);
+}
 
 static hb_script_t
 script_roundtrip_default (hb_script_t script)
@@ -787,6 +848,93 @@ test_unicode_normalization (gconstpointer user_data)
 }
 
 
+static void
+test_unicode_itemize (void)
+{
+  hb_unicode_funcs_t *uf = hb_unicode_funcs_get_default ();
+  hb_unicode_run_t runs[8];
+  unsigned int count;
+
+  /* Scripts; spaces join the text around them, closing brackets the
+   * script their opening bracket was in. */
+  count = G_N_ELEMENTS (runs);
+  g_assert_cmpuint (hb_unicode_itemize_utf8 (uf, "abc (\xCE\xB1\xCE\xB2) \xD7\xA9 x", -1, 0, &count, runs), ==, 5);
+  g_assert_cmpuint (count, ==, 5);
+  g_assert_cmpuint (runs[0].offset, ==, 0);
+  g_assert_cmpuint (runs[0].length, ==, 5);
+  g_assert_cmpuint (runs[0].script, ==, HB_SCRIPT_LATIN);
+  g_assert_cmpuint (runs[0].direction, ==, HB_DIRECTION_LTR);
+  g_assert_cmpuint (runs[1].offset, ==, 5);
+  g_assert_cmpuint (runs[1].length, ==, 4);
+  g_assert_cmpuint (runs[1].script, ==, HB_SCRIPT_GREEK);
+  g_assert_cmpuint (runs[2].offset, ==, 9);
+  g_assert_cmpuint (runs[2].length, ==, 2);
+  g_assert_cmpuint (runs[2].script, ==, HB_SCRIPT_LATIN);
+  g_assert_cmpuint (runs[3].offset, ==, 11);
+  g_assert_cmpuint (runs[3].length, ==, 3);
+  g_assert_cmpuint (runs[3].script, ==, HB_SCRIPT_HEBREW);
+  g_assert_cmpuint (runs[3].direction, ==, HB_DIRECTION_RTL);
+  g_assert_cmpuint (runs[4].offset, ==, 14);
+  g_assert_cmpuint (runs[4].script, ==, HB_SCRIPT_LATIN);
+  g_assert (!runs[0].emoji && !runs[1].emoji && !runs[2].emoji && !runs[3].emoji && !runs[4].emoji);
+
+  /* Leading common text takes the first real script. */
+  count = G_N_ELEMENTS (runs);
+  g_assert_cmpuint (hb_unicode_itemize_utf8 (uf, "1. \xD7\xA9", -1, 0, &count, runs), ==, 1);
+  g_assert_cmpuint (runs[0].script, ==, HB_SCRIPT_HEBREW);
+
+  /* Emoji: default presentation, U+FE0E / U+FE0F, ZWJ sequences, flags. */
+  count = G_N_ELEMENTS (runs);
+  g_assert_cmpuint (hb_unicode_itemize_utf8 (uf, "a\xF0\x9F\x91\xA8\xE2\x80\x8D\xF0\x9F\x91\xA9" "b"
+						 "\xE2\x8C\x9A\xEF\xB8\x8E"
+						 "\xE2\x9D\xA4\xEF\xB8\x8F"
+						 "\xF0\x9F\x87\xBA\xF0\x9F\x87\xB8", -1, 0, &count, runs), ==, 4);
+  g_assert_cmpuint (runs[0].length, ==, 1);
+  g_assert (!runs[0].emoji);
+  g_assert_cmpuint (runs[1].offset, ==, 1);
+  g_assert_cmpuint (runs[1].length, ==, 11);
+  g_assert (runs[1].emoji);
+  g_assert_cmpuint (runs[1].script, ==, HB_SCRIPT_LATIN);
+  g_assert_cmpuint (runs[2].length, ==, 7);
+  g_assert (!runs[2].emoji);
+  g_assert_cmpuint (runs[3].length, ==, 14);
+  g_assert (runs[3].emoji);
+
+  /* All-common text. */
+  count = G_N_ELEMENTS (runs);
+  g_assert_cmpuint (hb_unicode_itemize_utf8 (uf, "123", -1, 0, &count, runs), ==, 1);
+  g_assert_cmpuint (runs[0].script, ==, HB_SCRIPT_COMMON);
+  g_assert_cmpuint (runs[0].direction, ==, HB_DIRECTION_INVALID);
+
+  /* Offsets are in code units. */
+  {
+    const uint16_t utf16[] = {'a', 0x03B1, 0xD83D, 0xDE00, 0};
+    const uint32_t utf32[] = {'a', 0x03B1, 0x1F600, 0};
+
+    count = G_N_ELEMENTS (runs);
+    g_assert_cmpuint (hb_unicode_itemize_utf16 (uf, utf16, -1, 0, &count, runs), ==, 3);
+    g_assert_cmpuint (runs[2].offset, ==, 2);
+    g_assert_cmpuint (runs[2].length, ==, 2);
+    g_assert (runs[2].emoji);
+
+    count = G_N_ELEMENTS (runs);
+    g_assert_cmpuint (hb_unicode_itemize_utf32 (uf, utf32, -1, 0, &count, runs), ==, 3);
+    g_assert_cmpuint (runs[2].offset, ==, 2);
+    g_assert_cmpuint (runs[2].length, ==, 1);
+  }
+
+  /* Paging through the runs. */
+  count = 1;
+  g_assert_cmpuint (hb_unicode_itemize_utf8 (uf, "ab \xCE\xB1 c", -1, 1, &count, runs), ==, 3);
+  g_assert_cmpuint (count, ==, 1);
+  g_assert_cmpuint (runs[0].offset, ==, 3);
+  g_assert_cmpuint (runs[0].script, ==, HB_SCRIPT_GREEK);
+  count = 1;
+  g_assert_cmpuint (hb_unicode_itemize_utf8 (uf, "ab \xCE\xB1 c", -1, 3, &count, runs), ==, 3);
+  g_assert_cmpuint (count, ==, 0);
+  g_assert_cmpuint (hb_unicode_itemize_utf8 (uf, "", -1, 0, NULL, NULL), ==, 0);
+}
+
 
 int
 main (int argc, char **argv)
@@ -814,9 +962,12 @@ main (int argc, char **argv)
 
   hb_test_add (test_unicode_setters);
 
+  hb_test_add (test_unicode_itemize);
+
   hb_test_add_fixture (data_fixture, NULL, test_unicode_subclassing_nil);
   hb_test_add_fixture (data_fixture, NULL, test_unicode_subclassing_default);
   hb_test_add_fixture (data_fixture, NULL, test_unicode_subclassing_deep);
+  hb_test_add_fixture (data_fixture, NULL, test_unicode_subclassing_batch);
 
   return hb_test_run ();
 }
@@ -0,0 +1,161 @@
+/*
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+/*
+ * Times hb_map_t on the workloads of the subsetter's glyph maps: building
+ * a map from sorted old glyph ids to new ones, looking up every key,
+ * looking up keys that are not there, and deleting and adding back half
+ * of the keys.  Key counts go from a small Latin subset to a full CJK
+ * font.
+ *
+ * Usage: hb-map-benchmark [--iterations N]
+ */
+
+#include <hb.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static unsigned int seed = 1;
+
+static unsigned int
+rand_uint (void)
+{
+  seed = seed * 1103515245u + 12345u;
+  return seed >> 8;
+}
+
+struct workload_t
+{
+  hb_codepoint_t *keys;
+  hb_codepoint_t *misses;
+  unsigned int count;
+};
+
+typedef unsigned int (*op_func_t) (hb_map_t *map, const workload_t &w);
+
+static unsigned int
+op_build (hb_map_t *map, const workload_t &w)
+{
+  hb_map_clear (map);
+  for (unsigned int i = 0; i < w.count; i++)
+    hb_map_set (map, w.keys[i], i);
+  return hb_map_get_population (map);
+}
+
+static unsigned int
+op_get (hb_map_t *map, const workload_t &w)
+{
+  unsigned int sum = 0;
+  for (unsigned int i = 0; i < w.count; i++)
+    sum += hb_map_get (map, w.keys[i]);
+  return sum;
+}
+
+static unsigned int
+op_get_missing (hb_map_t *map, const workload_t &w)
+{
+  unsigned int found = 0;
+  for (unsigned int i = 0; i < w.count; i++)
+    found += hb_map_has (map, w.misses[i]);
+  return found;
+}
+
+static unsigned int
+op_churn (hb_map_t *map, const workload_t &w)
+{
+  for (unsigned int i = 0; i < w.count; i += 2)
+    hb_map_del (map, w.keys[i]);
+  for (unsigned int i = 0; i < w.count; i += 2)
+    hb_map_set (map, w.keys[i], i);
+  return hb_map_get_population (map);
+}
+
+static const struct
+{
+  const char *name;
+  op_func_t func;
+} ops[] =
+{
+  {"build",		op_build},
+  {"get",		op_get},
+  {"get-missing",	op_get_missing},
+  {"del-and-set",	op_churn},
+};
+
+int
+main (int argc, char **argv)
+{
+  unsigned int iterations = 1000;
+  if (argc > 2 && 0 == strcmp (argv[1], "--iterations"))
+    iterations = atoi (argv[2]);
+  if (!iterations)
+  {
+    fprintf (stderr, "usage: %s [--iterations N]\n", argv[0]);
+    return 1;
+  }
+
+  const unsigned int counts[] = {300, 3000, 30000};
+  for (unsigned int c = 0; c < sizeof (counts) / sizeof (counts[0]); c++)
+  {
+    /* Keys are sorted random glyph ids out of 65536, like a glyph map's;
+     * the misses are the rest. */
+    workload_t w;
+    w.count = counts[c];
+    w.keys = (hb_codepoint_t *) calloc (w.count, sizeof (hb_codepoint_t));
+    w.misses = (hb_codepoint_t *) calloc (w.count, sizeof (hb_codepoint_t));
+    unsigned int num_keys = 0, num_misses = 0;
+    for (hb_codepoint_t g = 0; g < 65536 && (num_keys < w.count || num_misses < w.count); g++)
+    {
+      if (rand_uint () % 65536 < w.count && num_keys < w.count)
+	w.keys[num_keys++] = g;
+      else if (num_misses < w.count)
+	w.misses[num_misses++] = g;
+    }
+    w.count = num_keys < num_misses ? num_keys : num_misses;
+
+    hb_map_t *map = hb_map_create ();
+    op_build (map, w);
+
+    printf ("%u of 65536 glyphs:\n", w.count);
+    for (unsigned int i = 0; i < sizeof (ops) / sizeof (ops[0]); i++)
+    {
+      unsigned long long sink = 0;
+      auto start = std::chrono::steady_clock::now ();
+      for (unsigned int j = 0; j < iterations; j++)
+	sink += ops[i].func (map, w);
+      auto end = std::chrono::steady_clock::now ();
+      double seconds = std::chrono::duration<double> (end - start).count ();
+      printf ("  %-16s %10.3f ns/key  (%llu)\n",
+	      ops[i].name, seconds * 1e9 / iterations / w.count, sink / iterations);
+    }
+
+    hb_map_destroy (map);
+    free (w.misses);
+    free (w.keys);
+  }
+
+  return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+/*
+ * Times hb_set_t algebra on glyph-set-sized inputs: union, subtract and
+ * symmetric difference of two sets, population counts, and iteration
+ * with hb_set_next() and hb_set_next_many().  Sets are dense or sparse random subsets of
+ * [0, 65536), like the glyph sets of a large font.
+ *
+ * Usage: hb-set-benchmark [--iterations N]
+ */
+
+#include <hb.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static unsigned int seed = 1;
+
+static unsigned int
+rand_uint (void)
+{
+  seed = seed * 1103515245u + 12345u;
+  return seed >> 8;
+}
+
+/* Adds each of [0, 65536) with probability 1 / one_in. */
+static hb_set_t *
+random_set (unsigned int one_in)
+{
+  hb_set_t *set = hb_set_create ();
+  for (hb_codepoint_t g = 0; g < 65536; g++)
+    if (!(rand_uint () % one_in))
+      hb_set_add (set, g);
+  return set;
+}
+
+typedef unsigned int (*op_func_t) (hb_set_t *a, hb_set_t *b, hb_set_t *out);
+
+static unsigned int
+op_union (hb_set_t *a, hb_set_t *b, hb_set_t *out)
+{
+  hb_set_set (out, a);
+  hb_set_union (out, b);
+  return 0;
+}
+
+static unsigned int
+op_subtract (hb_set_t *a, hb_set_t *b, hb_set_t *out)
+{
+  hb_set_set (out, a);
+  hb_set_subtract (out, b);
+  return 0;
+}
+
+static unsigned int
+op_symmetric_difference (hb_set_t *a, hb_set_t *b, hb_set_t *out)
+{
+  hb_set_set (out, a);
+  hb_set_symmetric_difference (out, b);
+  return 0;
+}
+
+static unsigned int
+op_population (hb_set_t *a, hb_set_t *, hb_set_t *)
+{
+  /* The population is cached; adding a present element invalidates it. */
+  hb_set_add (a, 0);
+  return hb_set_get_population (a);
+}
+
+static unsigned int
+op_next (hb_set_t *a, hb_set_t *, hb_set_t *)
+{
+  unsigned int count = 0;
+  hb_codepoint_t g = HB_SET_VALUE_INVALID;
+  while (hb_set_next (a, &g))
+    count++;
+  return count;
+}
+
+static unsigned int
+op_next_many (hb_set_t *a, hb_set_t *, hb_set_t *)
+{
+  unsigned int count = 0, n;
+  hb_codepoint_t buf[256];
+  hb_codepoint_t g = HB_SET_VALUE_INVALID;
+  while ((n = hb_set_next_many (a, g, buf, 256)))
+  {
+    count += n;
+    g = buf[n - 1];
+  }
+  return count;
+}
+
+static const struct
+{
+  const char *name;
+  op_func_t func;
+} ops[] =
+{
+  {"union",		op_union},
+  {"subtract",		op_subtract},
+  {"symmetric-diff",	op_symmetric_difference},
+  {"population",	op_population},
+  {"next",		op_next},
+  {"next-many",		op_next_many},
+};
+
+int
+main (int argc, char **argv)
+{
+  unsigned int iterations = 1000;
+  if (argc > 2 && 0 == strcmp (argv[1], "--iterations"))
+    iterations = atoi (argv[2]);
+  if (!iterations)
+  {
+    fprintf (stderr, "usage: %s [--iterations N]\n", argv[0]);
+    return 1;
+  }
+
+  const unsigned int densities[] = {2, 64};
+  for (unsigned int d = 0; d < sizeof (densities) / sizeof (densities[0]); d++)
+  {
+    hb_set_t *a = random_set (densities[d]);
+    hb_set_t *b = random_set (densities[d]);
+    hb_set_t *out = hb_set_create ();
+
+    printf ("1/%u of 65536 glyphs (%u and %u):\n", densities[d],
+	    hb_set_get_population (a), hb_set_get_population (b));
+    for (unsigned int i = 0; i < sizeof (ops) / sizeof (ops[0]); i++)
+    {
+      unsigned long long sink = 0;
+      auto start = std::chrono::steady_clock::now ();
+      for (unsigned int j = 0; j < iterations; j++)
+	sink += ops[i].func (a, b, out);
+      auto end = std::chrono::steady_clock::now ();
+      double seconds = std::chrono::duration<double> (end - start).count ();
+      printf ("  %-16s %10.3f us/op  (%llu)\n",
+	      ops[i].name, seconds * 1e6 / iterations, sink / iterations);
+    }
+
+    hb_set_destroy (out);
+    hb_set_destroy (b);
+    hb_set_destroy (a);
+  }
+
+  return 0;
+}
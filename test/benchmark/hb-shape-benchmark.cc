@@ -0,0 +1,275 @@
+/*
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+/*
+ * Shapes a fixed set of per-script corpora through hb_shape_full() and
+ * reports throughput and allocation counts, for shaping and for the
+ * first run that sets everything up.  Text is shaped one line per
+ * buffer, like hb-shape does, but without any I/O or formatting in the
+ * timed loop.
+ *
+ * Usage: hb-shape-benchmark [--iterations N] [corpus...]
+ */
+
+#include <hb.h>
+#include <hb-ot.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef SRCDIR
+#define SRCDIR "."
+#endif
+
+
+/*
+ * Allocation counting.
+ *
+ * On glibc we can interpose the allocator and forward to the libc
+ * implementation.  Elsewhere allocation counts are reported as zero.
+ */
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define HB_BENCHMARK_COUNT_ALLOCS 1
+
+static unsigned long long num_allocs;
+
+extern "C" {
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+extern void  __libc_free (void *ptr);
+
+void *malloc (size_t size) noexcept { num_allocs++; return __libc_malloc (size); }
+void *calloc (size_t nmemb, size_t size) noexcept { num_allocs++; return __libc_calloc (nmemb, size); }
+void *realloc (void *ptr, size_t size) noexcept { num_allocs++; return __libc_realloc (ptr, size); }
+void  free (void *ptr) noexcept { __libc_free (ptr); }
+}
+#else
+static unsigned long long num_allocs;
+#endif
+
+
+struct corpus_t
+{
+  const char *name;
+  const char *font_path;
+  const char *text_path;
+};
+
+/* Paths are relative to the test/ directory. */
+static const corpus_t corpora[] =
+{
+  {"latin",
+   "shaping/data/in-house/fonts/932ad5132c2761297c74e9976fe25b08e5ffa10b.ttf",
+   "benchmark/texts/latin.txt"},
+  {"arabic",
+   "shaping/data/text-rendering-tests/fonts/TestShapeAran.ttf",
+   "shaping/texts/in-house/shaper-arabic/script-arabic/language-urdu/crulp/ligatures/3grams.txt"},
+  /* Long runs of Devanagari marks, stressing cluster merging. */
+  {"marks",
+   "shaping/data/in-house/fonts/46669c8860cbfea13562a6ca0d83130ee571137b.ttf",
+   "benchmark/texts/marks.txt"},
+  {"devanagari",
+   "shaping/data/in-house/fonts/46669c8860cbfea13562a6ca0d83130ee571137b.ttf",
+   "shaping/texts/in-house/shaper-indic/script-devanagari/misc/misc.txt"},
+  {"myanmar",
+   "shaping/data/in-house/fonts/ab14b4eb9d7a67e293f51d30d719add06c9d6e06.ttf",
+   "shaping/texts/in-house/shaper-myanmar/script-myanmar/misc/utn11.txt"},
+  {"khmer",
+   "shaping/data/in-house/fonts/3998336402905b8be8301ef7f47cf7e050cbb1bd.ttf",
+   "shaping/texts/in-house/shaper-khmer/misc.txt"},
+  {"use",
+   "shaping/data/in-house/fonts/4cce528e99f600ed9c25a2b69e32eb94a03b4ae8.ttf",
+   "shaping/texts/in-house/shaper-use/script-tai-tham/torture.txt"},
+  /* There is no CJK font with a usable repertoire in shaping/data. */
+  {"cjk",
+   "subset/data/fonts/Mplus1p-Regular.ttf",
+   "benchmark/texts/cjk.txt"},
+  {"emoji",
+   "shaping/data/in-house/fonts/3cf6f8ac6d647473a43a3100e7494b202b2cfafe.ttf",
+   "benchmark/texts/emoji.txt"},
+  /* Default-ignorables through a morx font, stressing the passes that
+   * hide them and remove deleted glyphs. */
+  {"ignorables",
+   "shaping/data/text-rendering-tests/fonts/TestMORXTwo.ttf",
+   "benchmark/texts/ignorables.txt"},
+};
+
+
+struct line_t
+{
+  const char *text;
+  unsigned int length;
+};
+
+static bool
+split_lines (const char *data, unsigned int length,
+	     line_t **plines, unsigned int *pnum_lines)
+{
+  unsigned int num_lines = 0;
+  for (unsigned int i = 0; i < length; i++)
+    if (data[i] == '\n')
+      num_lines++;
+  num_lines++;
+
+  line_t *lines = (line_t *) calloc (num_lines, sizeof (line_t));
+  if (!lines)
+    return false;
+
+  unsigned int n = 0;
+  const char *start = data, *end = data + length;
+  while (start < end)
+  {
+    const char *p = (const char *) memchr (start, '\n', end - start);
+    if (!p) p = end;
+    if (p > start)
+    {
+      lines[n].text = start;
+      lines[n].length = p - start;
+      n++;
+    }
+    start = p + 1;
+  }
+
+  *plines = lines;
+  *pnum_lines = n;
+  return true;
+}
+
+/* Shapes all lines once; returns number of output glyphs. */
+static unsigned long long
+shape_lines (hb_font_t *font, hb_buffer_t *buffer,
+	     const line_t *lines, unsigned int num_lines)
+{
+  unsigned long long glyphs = 0;
+  for (unsigned int i = 0; i < num_lines; i++)
+  {
+    hb_buffer_clear_contents (buffer);
+    hb_buffer_add_utf8 (buffer, lines[i].text, lines[i].length, 0, lines[i].length);
+    hb_buffer_guess_segment_properties (buffer);
+    hb_shape_full (font, buffer, nullptr, 0, nullptr);
+    glyphs += hb_buffer_get_length (buffer);
+  }
+  return glyphs;
+}
+
+static bool
+run_corpus (const corpus_t &corpus, unsigned int iterations)
+{
+  char font_path[1024], text_path[1024];
+  snprintf (font_path, sizeof (font_path), "%s/%s", SRCDIR, corpus.font_path);
+  snprintf (text_path, sizeof (text_path), "%s/%s", SRCDIR, corpus.text_path);
+
+  hb_blob_t *font_blob = hb_blob_create_from_file (font_path);
+  hb_blob_t *text_blob = hb_blob_create_from_file (text_path);
+  if (!hb_blob_get_length (font_blob) || !hb_blob_get_length (text_blob))
+  {
+    fprintf (stderr, "%s: failed to load %s or %s\n", corpus.name, font_path, text_path);
+    hb_blob_destroy (font_blob);
+    hb_blob_destroy (text_blob);
+    return false;
+  }
+
+  unsigned int text_length;
+  const char *text = hb_blob_get_data (text_blob, &text_length);
+  line_t *lines;
+  unsigned int num_lines;
+  if (!split_lines (text, text_length, &lines, &num_lines))
+  {
+    hb_blob_destroy (font_blob);
+    hb_blob_destroy (text_blob);
+    return false;
+  }
+
+  /* Cold: face and font setup, plan creation, lazy table loading. */
+  unsigned long long cold_allocs = num_allocs;
+  hb_face_t *face = hb_face_create (font_blob, 0);
+  hb_font_t *font = hb_font_create (face);
+  hb_buffer_t *buffer = hb_buffer_create ();
+
+  /* Warm up: plan creation, lazy table loading, buffer growth. */
+  shape_lines (font, buffer, lines, num_lines);
+  cold_allocs = num_allocs - cold_allocs;
+
+  unsigned long long glyphs = 0;
+  unsigned long long allocs_before = num_allocs;
+  auto start = std::chrono::steady_clock::now ();
+  for (unsigned int i = 0; i < iterations; i++)
+    glyphs += shape_lines (font, buffer, lines, num_lines);
+  auto end = std::chrono::steady_clock::now ();
+  unsigned long long allocs = num_allocs - allocs_before;
+
+  double seconds = std::chrono::duration<double> (end - start).count ();
+  printf ("%-12s %8u lines %12llu glyphs %10.3f ms %14.0f glyphs/s %10.1f allocs/run %8llu cold allocs\n",
+	  corpus.name,
+	  num_lines,
+	  glyphs,
+	  seconds * 1000.,
+	  seconds > 0. ? glyphs / seconds : 0.,
+	  (double) allocs / iterations,
+	  cold_allocs);
+
+  hb_buffer_destroy (buffer);
+  hb_font_destroy (font);
+  hb_face_destroy (face);
+  free (lines);
+  hb_blob_destroy (font_blob);
+  hb_blob_destroy (text_blob);
+  return true;
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned int iterations = 100;
+  int first_corpus = 1;
+  if (argc > 2 && 0 == strcmp (argv[1], "--iterations"))
+  {
+    iterations = atoi (argv[2]);
+    first_corpus = 3;
+  }
+  if (!iterations)
+  {
+    fprintf (stderr, "usage: %s [--iterations N] [corpus...]\n", argv[0]);
+    return 1;
+  }
+
+#ifndef HB_BENCHMARK_COUNT_ALLOCS
+  fprintf (stderr, "Allocation counting not supported on this platform.\n");
+#endif
+
+  bool ret = true;
+  for (unsigned int i = 0; i < sizeof (corpora) / sizeof (corpora[0]); i++)
+  {
+    bool selected = first_corpus >= argc;
+    for (int j = first_corpus; j < argc; j++)
+      if (0 == strcmp (argv[j], corpora[i].name))
+	selected = true;
+    if (selected)
+      ret = run_corpus (corpora[i], iterations) && ret;
+  }
+
+  return ret ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+/*
+ *  This is part of HarfBuzz, a text shaping library.
+ *
+ * Permission is hereby granted, without written agreement and without
+ * license or royalty fees, to use, copy, modify, and distribute this
+ * software and its documentation for any purpose, provided that the
+ * above copyright notice and the following two paragraphs appear in
+ * all copies of this software.
+ *
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES
+ * ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN
+ * IF THE COPYRIGHT HOLDER HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH
+ * DAMAGE.
+ *
+ * THE COPYRIGHT HOLDER SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING,
+ * BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE COPYRIGHT HOLDER HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ */
+
+/*
+ * Runs hb_subset() on a fixed set of typical inputs and reports where the
+ * time goes: plan creation and its stages (cmap lookup, GSUB closure,
+ * composite and seac components, invalid glyph removal), and the
+ * subsetting of each table, along with the glyphs each plan stage added.
+ * Stage timing uses the trace hook on hb_subset_input_t, and the counts
+ * its stats pointer, so this needs the internal headers.
+ *
+ * With --threads, tables are subset concurrently through
+ * hb_subset_input_set_executor() on that many threads.
+ *
+ * Usage: hb-subset-benchmark [--iterations N] [--threads N] [input...]
+ */
+
+#include "hb-subset-input.hh"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef SRCDIR
+#define SRCDIR "."
+#endif
+
+
+struct input_t
+{
+  const char *name;
+  const char *font_path;
+  hb_codepoint_t first_unicode;
+  unsigned int num_unicodes;
+};
+
+/* Paths are relative to the test/ directory.  The first num_unicodes
+ * codepoints from first_unicode onward that the font maps are kept. */
+static const input_t inputs[] =
+{
+  {"latin-200",     "subset/data/fonts/Roboto-Regular.ttf",              0x0020, 200},
+  {"cjk-3000",      "subset/data/fonts/Mplus1p-Regular.ttf",             0x3000, 3000},
+  {"cff-latin-200", "subset/data/fonts/SourceSansPro-Regular.otf",       0x0020, 200},
+  {"cff-cjk-3000",  "subset/data/fonts/SourceHanSans-Regular_subset.otf", 0x3000, 3000},
+  /* The only CFF2 font in the tree is tiny; still useful for per-table overhead. */
+  {"cff2",          "api/fonts/AdobeVFPrototype.abc.otf",                0x0020, 200},
+};
+
+
+/*
+ * Stage timing.
+ */
+
+#define MAX_STAGES 64
+
+struct stage_t
+{
+  hb_tag_t tag;
+  double seconds;
+  std::chrono::steady_clock::time_point start;
+};
+
+struct timings_t
+{
+  stage_t stages[MAX_STAGES];
+  unsigned int num_stages;
+
+  stage_t *find (hb_tag_t tag)
+  {
+    for (unsigned int i = 0; i < num_stages; i++)
+      if (stages[i].tag == tag)
+	return &stages[i];
+    if (num_stages == MAX_STAGES)
+      return nullptr;
+    stage_t *stage = &stages[num_stages++];
+    stage->tag = tag;
+    stage->seconds = 0.;
+    return stage;
+  }
+};
+
+static std::mutex timings_lock;
+
+static void
+trace_func (hb_tag_t tag, bool begin, void *user_data)
+{
+  auto now = std::chrono::steady_clock::now ();
+  std::lock_guard<std::mutex> guard (timings_lock);
+  stage_t *stage = ((timings_t *) user_data)->find (tag);
+  if (!stage)
+    return;
+  if (begin)
+    stage->start = now;
+  else
+    stage->seconds += std::chrono::duration<double> (now - stage->start).count ();
+}
+
+static const char *
+stage_name (hb_tag_t tag, char buf[5])
+{
+  switch (tag)
+  {
+    case HB_SUBSET_STAGE_PLAN:		return "plan";
+    case HB_SUBSET_STAGE_CMAP:		return "  cmap";
+    case HB_SUBSET_STAGE_GSUB_CLOSURE:	return "  closure";
+    case HB_SUBSET_STAGE_COMPONENTS:	return "  components";
+    case HB_SUBSET_STAGE_REMOVE_INVALID:	return "  invalid";
+    default:
+      hb_tag_to_string (tag, buf);
+      buf[4] = '\0';
+      return buf;
+  }
+}
+
+
+static unsigned int num_threads;
+
+static void
+thread_executor (unsigned int   count,
+		 hb_job_func_t  job_func,
+		 void          *job_data,
+		 void          *user_data HB_UNUSED)
+{
+  std::atomic<unsigned int> next (0);
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < num_threads; i++)
+    threads.emplace_back ([&] () {
+      unsigned int index;
+      while ((index = next++) < count)
+	job_func (index, job_data);
+    });
+  for (auto &thread : threads)
+    thread.join ();
+}
+
+
+static bool
+run_input (const input_t &input, unsigned int iterations)
+{
+  char font_path[1024];
+  snprintf (font_path, sizeof (font_path), "%s/%s", SRCDIR, input.font_path);
+
+  hb_blob_t *blob = hb_blob_create_from_file (font_path);
+  if (!hb_blob_get_length (blob))
+  {
+    fprintf (stderr, "%s: failed to load %s\n", input.name, font_path);
+    hb_blob_destroy (blob);
+    return false;
+  }
+  hb_face_t *face = hb_face_create (blob, 0);
+  hb_blob_destroy (blob);
+
+  hb_set_t *font_unicodes = hb_set_create ();
+  hb_face_collect_unicodes (face, font_unicodes);
+  hb_set_t *unicodes = hb_set_create ();
+  hb_codepoint_t u = input.first_unicode - 1;
+  while (hb_set_get_population (unicodes) < input.num_unicodes &&
+	 hb_set_next (font_unicodes, &u))
+    hb_set_add (unicodes, u);
+  hb_set_destroy (font_unicodes);
+
+  timings_t timings;
+  timings.num_stages = 0;
+  hb_subset_plan_stats_t stats = {};
+  double total = 0.;
+  bool ret = true;
+
+  for (unsigned int i = 0; i < iterations && ret; i++)
+  {
+    hb_subset_input_t *subset_input = hb_subset_input_create_or_fail ();
+    if (!subset_input)
+    {
+      ret = false;
+      break;
+    }
+    hb_set_union (hb_subset_input_unicode_set (subset_input), unicodes);
+    hb_subset_input_set_drop_layout (subset_input, false);
+    if (num_threads)
+      hb_subset_input_set_executor (subset_input, thread_executor, nullptr);
+    subset_input->trace_func = trace_func;
+    subset_input->trace_data = &timings;
+    subset_input->stats = &stats;
+
+    auto start = std::chrono::steady_clock::now ();
+    hb_face_t *result = hb_subset (face, subset_input);
+    total += std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+    ret = result != hb_face_get_empty ();
+    hb_face_destroy (result);
+    hb_subset_input_destroy (subset_input);
+  }
+
+  if (ret)
+  {
+    printf ("%s: %u unicodes, %.3f ms/subset\n",
+	    input.name, hb_set_get_population (unicodes), total * 1000. / iterations);
+    for (unsigned int i = 0; i < timings.num_stages; i++)
+    {
+      char buf[5];
+      printf ("  %-12s %10.3f ms %6.1f%%\n",
+	      stage_name (timings.stages[i].tag, buf),
+	      timings.stages[i].seconds * 1000. / iterations,
+	      total > 0. ? timings.stages[i].seconds * 100. / total : 0.);
+    }
+    printf ("  glyphs: cmap=%u closure=%u (%u passes) components=%u invalid=%u\n",
+	    stats.cmap_glyphs,
+	    stats.gsub_closure_glyphs, stats.gsub_closure_iterations,
+	    stats.component_glyphs, stats.invalid_glyphs);
+  }
+  else
+    fprintf (stderr, "%s: subsetting failed\n", input.name);
+
+  hb_set_destroy (unicodes);
+  hb_face_destroy (face);
+  return ret;
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned int iterations = 10;
+  int first_input = 1;
+  if (argc > first_input + 1 && 0 == strcmp (argv[first_input], "--iterations"))
+  {
+    iterations = atoi (argv[first_input + 1]);
+    first_input += 2;
+  }
+  if (argc > first_input + 1 && 0 == strcmp (argv[first_input], "--threads"))
+  {
+    num_threads = atoi (argv[first_input + 1]);
+    first_input += 2;
+  }
+  if (!iterations)
+  {
+    fprintf (stderr, "usage: %s [--iterations N] [--threads N] [input...]\n", argv[0]);
+    return 1;
+  }
+
+  bool ret = true;
+  for (unsigned int i = 0; i < sizeof (inputs) / sizeof (inputs[0]); i++)
+  {
+    bool selected = first_input >= argc;
+    for (int j = first_input; j < argc; j++)
+      if (0 == strcmp (argv[j], inputs[i].name))
+	selected = true;
+    if (selected)
+      ret = run_input (inputs[i], iterations) && ret;
+  }
+
+  return ret ? 0 : 1;
+}
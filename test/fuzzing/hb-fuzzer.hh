@@ -1,4 +1,75 @@
 #include <hb.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/* Performance fuzzing.  Inputs costing more than these limits, read from
+ * the environment, are reported and abort, so that the fuzzer keeps them
+ * like crashes.  Unset or zero means no limit.
+ *
+ *   HB_FUZZER_MAX_OPS		Operation budget of each shaping, see
+ *				hb_buffer_set_max_ops().
+ *   HB_FUZZER_MAX_MEMORY	Bytes of heap held by the face and font.
+ *   HB_FUZZER_MAX_MS		Milliseconds of CPU time per input.
+ */
+struct hb_fuzzer_cost_t
+{
+  hb_fuzzer_cost_t () :
+    max_ops (get_limit ("HB_FUZZER_MAX_OPS")),
+    max_memory (get_limit ("HB_FUZZER_MAX_MEMORY")),
+    max_ms (get_limit ("HB_FUZZER_MAX_MS")),
+    start (clock ()) {}
+
+  ~hb_fuzzer_cost_t ()
+  {
+    unsigned long ms = (unsigned long) ((clock () - start) * 1000 / CLOCKS_PER_SEC);
+    if (max_ms && ms > max_ms)
+      exceeded ("CPU time (ms)", ms, max_ms);
+  }
+
+  /* Shapes buffer with the operation budget, if any. */
+  void shape (hb_font_t *font, hb_buffer_t *buffer)
+  {
+    hb_buffer_set_max_ops (buffer, (unsigned int) max_ops);
+    if (!hb_shape_full (font, buffer, nullptr, 0, nullptr) && max_ops &&
+	hb_buffer_allocation_successful (buffer))
+    {
+      fprintf (stderr, "Shaping ran out of its budget of %lu operations\n", max_ops);
+      abort ();
+    }
+  }
+
+  void check_memory (hb_face_t *face, hb_font_t *font = nullptr)
+  {
+    if (!max_memory)
+      return;
+    unsigned long heap = 0;
+    for (unsigned int i = HB_FACE_MEMORY_OBJECT; i <= HB_FACE_MEMORY_SHAPE_PLANS; i++)
+      heap += hb_face_get_memory_usage (face, (hb_face_memory_subsystem_t) i, nullptr);
+    if (font)
+      heap += hb_font_get_memory_usage (font);
+    if (heap > max_memory)
+      exceeded ("Heap memory (bytes)", heap, max_memory);
+  }
+
+  private:
+  static unsigned long get_limit (const char *name)
+  {
+    const char *s = getenv (name);
+    return s ? strtoul (s, nullptr, 10) : 0;
+  }
+
+  static void exceeded (const char *what, unsigned long value, unsigned long limit)
+  {
+    fprintf (stderr, "%s: %lu, over the limit of %lu\n", what, value, limit);
+    abort ();
+  }
+
+  unsigned long max_ops;
+  unsigned long max_memory;
+  unsigned long max_ms;
+  clock_t start;
+};
@@ -46,6 +46,8 @@ trySubset (hb_face_t *face,
 
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
 {
+  hb_fuzzer_cost_t cost;
+
   hb_blob_t *blob = hb_blob_create ((const char *)data, size,
 				    HB_MEMORY_MODE_READONLY, NULL, NULL);
   hb_face_t *face = hb_face_create (blob, 0);
@@ -78,6 +80,8 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
     trySubset (face, text_from_data, text_size, flags);
   }
 
+  cost.check_memory (face);
+
   hb_face_destroy (face);
   hb_blob_destroy (blob);
 
@@ -0,0 +1,143 @@
+#!/usr/bin/env python
+
+# Times hb-shape over the shaping test suites and perf-corpus.txt, and
+# flags tests that got slower than in a stored baseline.  Timings are
+# machine-specific; record a baseline on the same machine first.  The
+# PERF_BASELINE and PERF_RECORD environment variables stand in for the
+# options of the same name, for `make perf-check`.
+#
+#   run-perf.py --record base.json hb-shape perf-corpus.txt data/*/tests/*.tests
+#   (change things, rebuild)
+#   run-perf.py --baseline base.json hb-shape perf-corpus.txt data/*/tests/*.tests
+
+from __future__ import print_function, division, absolute_import
+
+import sys, os, subprocess, json
+
+srcdir = os.path.dirname (os.path.abspath (__file__))
+
+baseline_file = os.environ.get ('PERF_BASELINE') or None
+record_file = os.environ.get ('PERF_RECORD') or None
+threshold = 25.
+iterations = 20
+
+args = sys.argv[1:]
+while args and args[0].startswith ('--'):
+	opt = args.pop (0)
+	if '=' in opt:
+		opt, value = opt.split ('=', 1)
+	elif args:
+		value = args.pop (0)
+	else:
+		value = None
+	if value is None:
+		print ("Option %s needs a value." % opt)
+		sys.exit (1)
+	if opt == '--baseline':
+		baseline_file = value
+	elif opt == '--record':
+		record_file = value
+	elif opt == '--threshold':
+		threshold = float (value)
+	elif opt == '--iterations':
+		iterations = int (value)
+	else:
+		print ("Unknown option %s." % opt)
+		sys.exit (1)
+
+if not args or args[0].find('hb-shape') == -1 or not os.path.exists (args[0]):
+	print ("""First argument does not seem to point to usable hb-shape.""")
+	sys.exit (1)
+hb_shape, args = args[0], args[1:]
+
+def read_tests (filename):
+	"""Yields (name, font file, options, input options) for each test in a
+	*.tests file or the perf corpus."""
+	cwd = os.path.dirname (filename)
+	is_corpus = not filename.endswith ('.tests')
+	for line in open (filename):
+		line = line.strip ()
+		if not line or line.startswith ('#'):
+			continue
+
+		fields = line.split (':')
+		fontfile, options = fields[0], fields[1]
+		if fontfile.startswith ('/') or fontfile.startswith ('"/'):
+			fontfile = fontfile.split ('@')[0]
+		else:
+			fontfile = os.path.normpath (os.path.join (cwd, fontfile))
+
+		if is_corpus:
+			textfile = os.path.normpath (os.path.join (cwd, fields[2]))
+			what = os.path.relpath (textfile, srcdir)
+			inputs = ['--text-file', textfile]
+		else:
+			what = fields[2]
+			inputs = ['--unicodes', fields[2]]
+
+		name = ':'.join ([os.path.relpath (fontfile, srcdir), options, what])
+		yield name, fontfile, options, inputs
+
+def time_test (fontfile, options, inputs):
+	"""Median time of one shape, in microseconds, or None on failure."""
+	command = [hb_shape, '--shaper=ot', '--font-funcs=ot', fontfile] + inputs + \
+		  (options.split (' ') if options else []) + \
+		  ['--num-iterations=%d' % iterations, '--benchmark=json', '--output-format=']
+	process = subprocess.Popen (command,
+				    stdout=subprocess.PIPE,
+				    stderr=subprocess.PIPE)
+	out, err = process.communicate ()
+	if process.returncode:
+		return None
+	lines = err.decode ("utf-8").strip ().split ('\n')
+	try:
+		stats = json.loads (lines[-1])
+	except ValueError:
+		return None
+	return stats['median_us']
+
+baseline = {}
+if baseline_file:
+	with open (baseline_file) as f:
+		baseline = json.load (f)
+
+results = {}
+slower = 0
+skips = 0
+
+for filename in args:
+	for name, fontfile, options, inputs in read_tests (filename):
+		if not os.path.exists (fontfile):
+			skips += 1
+			continue
+
+		t = time_test (fontfile, options, inputs)
+		if t is None:
+			print ("FAILED   %s" % name)
+			skips += 1
+			continue
+		results[name] = t
+
+		if name in baseline and baseline[name] > 0:
+			change = 100. * (t - baseline[name]) / baseline[name]
+			flag = "SLOWER  " if change > threshold else "        "
+			if change > threshold:
+				slower += 1
+			print ("%s %10.3f us  %+6.1f%%  %s" % (flag, t, change, name))
+		else:
+			print ("         %10.3f us           %s" % (t, name))
+
+if record_file:
+	with open (record_file, 'w') as f:
+		json.dump (results, f, indent=0, sort_keys=True)
+		f.write ('\n')
+
+print ("%d tests timed; %d slower than baseline by more than %g%%; %d skipped." %
+       (len (results), slower, threshold, skips))
+
+if slower:
+	sys.exit (1)
+elif results:
+	sys.exit (0)
+else:
+	sys.exit (77)
@@ -35,6 +35,8 @@ struct output_buffer_t
 		    format (parser),
 		    gs (nullptr),
 		    line_no (0),
+		    trace_fp (nullptr),
+		    trace_events (0),
 		    font (nullptr),
 		    output_format (HB_BUFFER_SERIALIZE_FORMAT_INVALID),
 		    format_flags (HB_BUFFER_SERIALIZE_FLAG_DEFAULT) {}
@@ -82,6 +84,17 @@ struct output_buffer_t
 
     if (format.trace)
       hb_buffer_set_message_func (buffer, message_func, this, nullptr);
+
+    if (format.trace_file)
+    {
+      trace_fp = fopen (format.trace_file, "w");
+      if (!trace_fp)
+	fail (false, "Cannot open trace file `%s': %s",
+	      format.trace_file, strerror (errno));
+      fputs ("[", trace_fp);
+      trace_events = 0;
+      hb_buffer_set_trace_func (buffer, trace_func, this, nullptr);
+    }
   }
   void new_line () { line_no++; }
   void consume_text (hb_buffer_t  *buffer,
@@ -112,6 +125,13 @@ struct output_buffer_t
   void finish (hb_buffer_t *buffer, const font_options_t *font_opts)
   {
     hb_buffer_set_message_func (buffer, nullptr, nullptr, nullptr);
+    hb_buffer_set_trace_func (buffer, nullptr, nullptr, nullptr);
+    if (trace_fp)
+    {
+      fputs ("\n]\n", trace_fp);
+      fclose (trace_fp);
+      trace_fp = nullptr;
+    }
     hb_font_destroy (font);
     g_string_free (gs, true);
     gs = nullptr;
@@ -142,6 +162,47 @@ struct output_buffer_t
     fprintf (options.fp, "%s", gs->str);
   }
 
+  static void
+  trace_func (hb_buffer_t *buffer,
+	      hb_font_t *font,
+	      const hb_buffer_trace_event_t *event,
+	      void *user_data)
+  {
+    output_buffer_t *that = (output_buffer_t *) user_data;
+    that->trace_event (event);
+  }
+
+  /* One "complete" event per lookup; chrome://tracing and Perfetto load
+   * the resulting array as is.  Timestamps are in microseconds. */
+  void
+  trace_event (const hb_buffer_trace_event_t *event)
+  {
+    char name[32];
+    switch (event->type)
+    {
+      case HB_BUFFER_TRACE_EVENT_TYPE_SHAPE:
+	snprintf (name, sizeof (name), "shape");
+	break;
+      case HB_BUFFER_TRACE_EVENT_TYPE_LOOKUP:
+	snprintf (name, sizeof (name), "%c%c%c%c lookup %u", HB_UNTAG (event->table), event->index);
+	break;
+      case HB_BUFFER_TRACE_EVENT_TYPE_SUBTABLE:
+      default:
+	snprintf (name, sizeof (name), "%c%c%c%c subtable %u", HB_UNTAG (event->table), event->index);
+	break;
+    }
+    fprintf (trace_fp,
+	     "%s\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", "
+	     "\"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": 1, "
+	     "\"args\": {\"line\": %u, \"start\": %u, \"end\": %u}}",
+	     trace_events++ ? "," : "",
+	     name,
+	     event->type == HB_BUFFER_TRACE_EVENT_TYPE_SHAPE ? "shape" : "lookup",
+	     event->start_time / 1e3,
+	     (event->end_time - event->start_time) / 1e3,
+	     line_no, event->start, event->end);
+  }
+
 
   protected:
   output_options_t options;
@@ -149,6 +210,8 @@ struct output_buffer_t
 
   GString *gs;
   unsigned int line_no;
+  FILE *trace_fp;
+  unsigned int trace_events;
   hb_font_t *font;
   hb_buffer_serialize_format_t output_format;
   hb_buffer_serialize_flags_t format_flags;
@@ -161,11 +224,13 @@ main (int argc, char **argv)
   {
     unsigned int ret = 0;
     char buf[4092];
+    /* Lines mostly reuse a few fonts; keep them loaded. */
+    font_cache_t font_cache;
     while (fgets (buf, sizeof (buf), stdin))
     {
       size_t l = strlen (buf);
       if (l && buf[l - 1] == '\n') buf[l - 1] = '\0';
-      main_font_text_t<shape_consumer_t<output_buffer_t>, FONT_SIZE_UPEM, 0> driver;
+      main_font_text_t<shape_consumer_t<output_buffer_t>, FONT_SIZE_UPEM, 0> driver (&font_cache);
       char *args[32];
       argc = 0;
       char *p = buf, *e;
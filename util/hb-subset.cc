@@ -34,6 +34,114 @@
  * Command line interface to the harfbuzz font subsetter.
  */
 
+static hb_bool_t
+write_func (const char *data, unsigned int length, void *user_data)
+{
+  return fwrite (data, 1, length, (FILE *) user_data) == length;
+}
+
+static hb_bool_t
+write_file (const char *output_file, hb_face_t *face)
+{
+  FILE *fp_out = fopen(output_file, "wb");
+  if (fp_out == nullptr) {
+    fprintf(stderr, "Unable to open output file\n");
+    return false;
+  }
+
+  /* Streams the tables out without first building the font in memory. */
+  hb_bool_t ret = hb_face_builder_write (face, write_func, fp_out);
+
+  if (fclose (fp_out) != 0)
+    ret = false;
+
+  if (!ret) {
+    fprintf(stderr, "Unable to write output file\n");
+    return false;
+  }
+  return true;
+}
+
+static bool
+subset_and_write (hb_face_t *face, hb_subset_input_t *input, const char *output_file)
+{
+  hb_face_t *new_face = hb_subset (face, input);
+
+  bool failed = new_face == hb_face_get_empty ();
+  if (!failed)
+    write_file (output_file, new_face);
+
+  hb_face_destroy (new_face);
+  return !failed;
+}
+
+/* Subsets of a --batch --threads run, queued while the lines are read
+ * and then taken by the threads in turn. */
+struct subset_queue_t
+{
+  struct job_t
+  {
+    hb_face_t *face;
+    hb_subset_input_t *input;
+    char *output_file;
+  };
+
+  subset_queue_t () : next (0), failed (false)
+  { jobs = g_array_new (false, false, sizeof (job_t)); }
+  ~subset_queue_t ()
+  {
+    for (unsigned int i = 0; i < jobs->len; i++)
+    {
+      job_t &job = g_array_index (jobs, job_t, i);
+      hb_face_destroy (job.face);
+      hb_subset_input_destroy (job.input);
+      g_free (job.output_file);
+    }
+    g_array_free (jobs, true);
+  }
+
+  /* Takes ownership of input. */
+  void add (hb_face_t *face, hb_subset_input_t *input, const char *output_file)
+  {
+    job_t job = {hb_face_reference (face), input, g_strdup (output_file)};
+    g_array_append_val (jobs, job);
+  }
+
+  bool run (unsigned int num_threads)
+  {
+    GThread **threads = g_new (GThread *, num_threads);
+    for (unsigned int i = 0; i < num_threads; i++)
+      threads[i] = g_thread_new ("subset", worker, this);
+    for (unsigned int i = 0; i < num_threads; i++)
+      g_thread_join (threads[i]);
+    g_free (threads);
+    return !g_atomic_int_get (&failed);
+  }
+
+  static gpointer worker (gpointer data)
+  {
+    subset_queue_t *queue = (subset_queue_t *) data;
+    for (;;)
+    {
+      unsigned int i = g_atomic_int_add (&queue->next, 1);
+      if (i >= queue->jobs->len)
+	break;
+
+      job_t &job = g_array_index (queue->jobs, job_t, i);
+      if (!subset_and_write (job.face, job.input, job.output_file))
+	g_atomic_int_set (&queue->failed, true);
+    }
+    return nullptr;
+  }
+
+  GArray *jobs;
+  gint next;
+  gint failed;
+};
+
+/* Set while reading the lines of a threaded batch run. */
+static subset_queue_t *batch_queue;
+
 struct subset_consumer_t
 {
   subset_consumer_t (option_parser_t *parser)
@@ -61,32 +169,6 @@ struct subset_consumer_t
     } while ((c = g_utf8_find_next_char(c, text + text_len)) != nullptr);
   }
 
-  hb_bool_t
-  write_file (const char *output_file, hb_blob_t *blob) {
-    unsigned int data_length;
-    const char* data = hb_blob_get_data (blob, &data_length);
-
-    FILE *fp_out = fopen(output_file, "wb");
-    if (fp_out == nullptr) {
-      fprintf(stderr, "Unable to open output file\n");
-      return false;
-    }
-    int bytes_written = fwrite(data, 1, data_length, fp_out);
-
-    fclose (fp_out);
-
-    if (bytes_written == -1) {
-      fprintf(stderr, "Unable to write output file\n");
-      return false;
-    }
-    if ((unsigned int) bytes_written != data_length) {
-      fprintf(stderr, "Expected %u bytes written, got %d\n", data_length,
-              bytes_written);
-      return false;
-    }
-    return true;
-  }
-
   void finish (const font_options_t *font_opts)
   {
     hb_subset_input_set_drop_layout (input, !subset_options.keep_layout);
@@ -97,16 +179,15 @@ struct subset_consumer_t
 
     hb_face_t *face = hb_font_get_face (font);
 
-    hb_face_t *new_face = hb_subset (face, input);
-    hb_blob_t *result = hb_face_reference_blob (new_face);
-
-    failed = !hb_blob_get_length (result);
-    if (!failed)
-      write_file (options.output_file, result);
+    if (batch_queue)
+      batch_queue->add (face, input, options.output_file);
+    else
+    {
+      failed = !subset_and_write (face, input, options.output_file);
+      hb_subset_input_destroy (input);
+    }
+    input = nullptr;
 
-    hb_subset_input_destroy (input);
-    hb_blob_destroy (result);
-    hb_face_destroy (new_face);
     hb_font_destroy (font);
   }
 
@@ -123,6 +204,57 @@ struct subset_consumer_t
 int
 main (int argc, char **argv)
 {
+  /* hb-subset --batch [--threads=N]: one command line per input line,
+   * sharing the loaded faces.  With threads, all lines are read first
+   * and the subsets then run concurrently. */
+  if ((argc == 2 || argc == 3) && !strcmp (argv[1], "--batch"))
+  {
+    unsigned int num_threads = 1;
+    if (argc == 3)
+    {
+      if (strncmp (argv[2], "--threads=", 10) ||
+	  !(num_threads = strtoul (argv[2] + 10, nullptr, 10)))
+      {
+	fprintf (stderr, "Usage: %s --batch [--threads=N]\n", argv[0]);
+	return 1;
+      }
+    }
+
+    subset_queue_t queue;
+    if (num_threads > 1)
+      batch_queue = &queue;
+
+    unsigned int ret = 0;
+    char buf[4092];
+    font_cache_t font_cache;
+    while (fgets (buf, sizeof (buf), stdin))
+    {
+      size_t l = strlen (buf);
+      if (l && buf[l - 1] == '\n') buf[l - 1] = '\0';
+      main_font_text_t<subset_consumer_t, 10, 0> driver (&font_cache);
+      char *args[32];
+      argc = 0;
+      char *p = buf, *e;
+      args[argc++] = p;
+      while ((e = strchr (p, ' ')) && argc < (int) ARRAY_LENGTH (args))
+      {
+	*e++ = '\0';
+	while (*e == ' ')
+	  e++;
+	args[argc++] = p = e;
+      }
+      ret |= driver.main (argc, args);
+
+      if (ret)
+	break;
+    }
+
+    batch_queue = nullptr;
+    if (!ret && num_threads > 1 && !queue.run (num_threads))
+      ret = 1;
+    return ret;
+  }
+
   main_font_text_t<subset_consumer_t, 10, 0> driver;
   return driver.main (argc, argv);
 }
@@ -32,9 +32,55 @@
 #define DEFAULT_FONT_SIZE 256
 #define SUBPIXEL_BITS 6
 
+typedef main_font_text_t<shape_consumer_t<view_cairo_t>, DEFAULT_FONT_SIZE, SUBPIXEL_BITS> driver_t;
+
+static int
+batch_main ()
+{
+  unsigned int ret = 0;
+  char buf[4092];
+  /* Lines mostly reuse a few fonts; keep them loaded, along with the
+   * glyphs cairo rendered for them. */
+  font_cache_t font_cache;
+  while (fgets (buf, sizeof (buf), stdin))
+  {
+    size_t l = strlen (buf);
+    if (l && buf[l - 1] == '\n') buf[l - 1] = '\0';
+    driver_t driver (&font_cache);
+    char *args[32];
+    int argc = 0;
+    char *p = buf, *e;
+    args[argc++] = p;
+    while ((e = strchr (p, ' ')) && argc < (int) ARRAY_LENGTH (args))
+    {
+      *e++ = '\0';
+      while (*e == ' ')
+	e++;
+      args[argc++] = p = e;
+    }
+    ret |= driver.main (argc, args);
+
+    if (ret)
+      break;
+  }
+  return ret;
+}
+
 int
 main (int argc, char **argv)
 {
-  main_font_text_t<shape_consumer_t<view_cairo_t>, DEFAULT_FONT_SIZE, SUBPIXEL_BITS> driver;
-  return driver.main (argc, argv);
+  int ret;
+  /* hb-view --batch: one command line per input line, each with its own
+   * font, text and --output-file. */
+  if (argc == 2 && !strcmp (argv[1], "--batch"))
+    ret = batch_main ();
+  else
+  {
+    driver_t driver;
+    ret = driver.main (argc, argv);
+  }
+
+  /* Only once nothing holds on to cairo fonts anymore. */
+  cairo_debug_reset_static_data ();
+  return ret;
 }
@@ -72,10 +72,37 @@ void free_ft_library ()
 }
 #endif
 
+/* The FT_Face of a cairo font face, and the blob holding its data. */
+struct ft_face_closure_t
+{
+  FT_Face ft_face;
+  hb_blob_t *blob;
+};
+
+static void
+ft_face_closure_destroy (ft_face_closure_t *closure)
+{
+  FT_Done_Face (closure->ft_face);
+  hb_blob_destroy (closure->blob);
+  free (closure);
+}
+
+/* Batch runs keep the scaled font of each cached font on it, so that
+ * cairo's rasterized glyphs are kept across lines using the font. */
+static hb_user_data_key_t scaled_font_key;
+
 cairo_scaled_font_t *
 helper_cairo_create_scaled_font (const font_options_t *font_opts)
 {
-  hb_font_t *font = hb_font_reference (font_opts->get_font ());
+  hb_font_t *font = font_opts->get_font ();
+  if (font_opts->cache)
+  {
+    cairo_scaled_font_t *scaled_font = (cairo_scaled_font_t *)
+				       hb_font_get_user_data (font, &scaled_font_key);
+    if (scaled_font)
+      return cairo_scaled_font_reference (scaled_font);
+  }
+  font = hb_font_reference (font);
 
   cairo_font_face_t *cairo_face;
   /* We cannot use the FT_Face from hb_font_t, as doing so will confuse hb_font_t because
@@ -128,6 +155,23 @@ helper_cairo_create_scaled_font (const font_options_t *font_opts)
 #endif
 
     cairo_face = cairo_ft_font_face_create_for_ft_face (ft_face, font_opts->ft_load_flags);
+
+    /* The face is done with once cairo is; that matters for batch runs. */
+    static cairo_user_data_key_t ft_face_key;
+    ft_face_closure_t *closure = (ft_face_closure_t *) malloc (sizeof (ft_face_closure_t));
+    if (closure)
+    {
+      closure->ft_face = ft_face;
+      closure->blob = hb_blob_reference (font_opts->blob);
+      if (cairo_font_face_set_user_data (cairo_face,
+					 &ft_face_key,
+					 closure,
+					 (cairo_destroy_func_t) ft_face_closure_destroy))
+      {
+	hb_blob_destroy (closure->blob);
+	free (closure);
+      }
+    }
   }
   cairo_matrix_t ctm, font_matrix;
   cairo_font_options_t *font_options;
@@ -148,6 +192,23 @@ helper_cairo_create_scaled_font (const font_options_t *font_opts)
   cairo_font_options_destroy (font_options);
   cairo_font_face_destroy (cairo_face);
 
+  /* A cached font owns its scaled font; the other way round would make
+   * a cycle. */
+  if (font_opts->cache)
+  {
+    cairo_scaled_font_reference (scaled_font);
+    if (hb_font_set_user_data (font,
+			       &scaled_font_key,
+			       scaled_font,
+			       (hb_destroy_func_t) cairo_scaled_font_destroy,
+			       false))
+    {
+      hb_font_destroy (font);
+      return scaled_font;
+    }
+    cairo_scaled_font_destroy (scaled_font);
+  }
+
   static cairo_user_data_key_t key;
   if (cairo_scaled_font_set_user_data (scaled_font,
 				       &key,
@@ -50,11 +50,14 @@ locale_to_utf8 (char *s)
 template <typename consumer_t, int default_font_size, int subpixel_bits>
 struct main_font_text_t
 {
-  main_font_text_t ()
+  main_font_text_t (font_cache_t *font_cache = nullptr)
 		  : options ("[FONT-FILE] [TEXT]"),
 		    font_opts (&options, default_font_size, subpixel_bits),
 		    input (&options),
-		    consumer (&options) {}
+		    consumer (&options)
+  {
+    font_opts.cache = font_cache;
+  }
 
   int
   main (int argc, char **argv)
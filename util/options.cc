@@ -211,6 +211,27 @@ parse_shapers (const char *name G_GNUC_UNUSED,
   return true;
 }
 
+static gboolean
+parse_benchmark (const char *name G_GNUC_UNUSED,
+		 const char *arg,
+		 gpointer    data,
+		 GError    **error)
+{
+  shape_options_t *shape_opts = (shape_options_t *) data;
+
+  if (!arg || 0 == g_ascii_strcasecmp (arg, "text"))
+    shape_opts->benchmark = shape_options_t::BENCHMARK_TEXT;
+  else if (0 == g_ascii_strcasecmp (arg, "json"))
+    shape_opts->benchmark = shape_options_t::BENCHMARK_JSON;
+  else
+  {
+    g_set_error (error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+		 "Unknown benchmark format: %s", arg);
+    return false;
+  }
+  return true;
+}
+
 static G_GNUC_NORETURN gboolean
 list_shapers (const char *name G_GNUC_UNUSED,
 	      const char *arg G_GNUC_UNUSED,
@@ -419,6 +440,10 @@ shape_options_t::add_options (option_parser_t *parser)
     {"normalize-glyphs",0, 0, G_OPTION_ARG_NONE,	&this->normalize_glyphs,	"Rearrange glyph clusters in nominal order",	nullptr},
     {"verify",		0, 0, G_OPTION_ARG_NONE,	&this->verify,			"Perform sanity checks on shaping results",	nullptr},
     {"num-iterations", 'n', 0, G_OPTION_ARG_INT,		&this->num_iterations,		"Run shaper N times (default: 1)",	"N"},
+    {"benchmark",	0, G_OPTION_FLAG_OPTIONAL_ARG,
+			      G_OPTION_ARG_CALLBACK,	(gpointer) &parse_benchmark,	"Print shaping time statistics to stderr (default format: text)",	"text/json"},
+    {"threads",		0, 0, G_OPTION_ARG_INT,		&this->num_threads,		"Also shape all lines from N threads sharing the font, and print the throughput to stderr (default: 1)",	"N"},
+    {"profile-lookups",	0, 0, G_OPTION_ARG_NONE,	&this->profile_lookups,		"Count applications and time per GSUB/GPOS lookup, and print the costliest lookups to stderr",	nullptr},
     {nullptr}
   };
   parser->add_group (entries,
@@ -660,23 +685,52 @@ font_options_t::get_font () const
 #endif
   }
 
-  blob = hb_blob_create_from_file (font_path);
+  /* Standard input can only be read once. */
+  font_cache_t *font_cache = font_path == font_file ? cache : nullptr;
 
-  if (blob == hb_blob_get_empty ())
-    fail (false, "Couldn't read or find %s, or it was empty.", font_path);
+  hb_face_t *face = font_cache ? font_cache->get_face (font_path, face_index) : nullptr;
+  if (face)
+  {
+    hb_face_reference (face);
+    blob = hb_face_reference_blob (face);
+    hb_blob_destroy (blob);
+  }
+  else
+  {
+    blob = hb_blob_create_from_file (font_path);
 
-  /* Create the face */
-  hb_face_t *face = hb_face_create (blob, face_index);
-  hb_blob_destroy (blob);
+    if (blob == hb_blob_get_empty ())
+      fail (false, "Couldn't read or find %s, or it was empty.", font_path);
 
+    /* Create the face */
+    face = hb_face_create (blob, face_index);
+    hb_blob_destroy (blob);
 
-  font = hb_font_create (face);
+    if (font_cache)
+      font_cache->put_face (font_path, face_index, face);
+  }
 
   if (font_size_x == FONT_SIZE_UPEM)
     font_size_x = hb_face_get_upem (face);
   if (font_size_y == FONT_SIZE_UPEM)
     font_size_y = hb_face_get_upem (face);
 
+  char *font_key = nullptr;
+  if (font_cache)
+  {
+    font_key = get_font_key (face);
+    font = font_cache->get_font (font_key);
+    if (font)
+    {
+      hb_font_reference (font);
+      hb_face_destroy (face);
+      g_free (font_key);
+      return font;
+    }
+  }
+
+  font = hb_font_create (face);
+
   hb_font_set_ppem (font, x_ppem, y_ppem);
   hb_font_set_ptem (font, ptem);
 
@@ -722,9 +776,52 @@ font_options_t::get_font () const
   hb_ft_font_set_load_flags (font, ft_load_flags);
 #endif
 
+  if (font_cache)
+  {
+    font_cache->put_font (font_key, font);
+    g_free (font_key);
+  }
+
   return font;
 }
 
+char *
+font_options_t::get_font_key (hb_face_t *face) const
+{
+  GString *s = g_string_new (nullptr);
+  g_string_printf (s, "%p %d %d %g %g %g %u %s %d",
+		   (void *) face,
+		   x_ppem, y_ppem, ptem,
+		   font_size_x, font_size_y, subpixel_bits,
+		   font_funcs ? font_funcs : "",
+		   ft_load_flags);
+  for (unsigned int i = 0; i < num_variations; i++)
+  {
+    char buf[128];
+    hb_variation_to_string (&variations[i], buf, sizeof (buf));
+    g_string_append_c (s, ' ');
+    g_string_append (s, buf);
+  }
+  return g_string_free (s, FALSE);
+}
+
+hb_face_t *
+font_cache_t::get_face (const char *font_path, int face_index)
+{
+  char *key = g_strdup_printf ("%d %s", face_index, font_path);
+  hb_face_t *face = (hb_face_t *) g_hash_table_lookup (faces, key);
+  g_free (key);
+  return face;
+}
+
+void
+font_cache_t::put_face (const char *font_path, int face_index, hb_face_t *face)
+{
+  g_hash_table_replace (faces,
+			g_strdup_printf ("%d %s", face_index, font_path),
+			hb_face_reference (face));
+}
+
 
 const char *
 text_options_t::get_line (unsigned int *len)
@@ -861,6 +958,7 @@ format_options_t::add_options (option_parser_t *parser)
     {"ned",	      'v', G_OPTION_FLAG_NO_ARG,
 			      G_OPTION_ARG_CALLBACK,	(gpointer) &parse_ned,		"No Extra Data; Do not output clusters or advances",			nullptr},
     {"trace",	      'V', 0, G_OPTION_ARG_NONE,	&this->trace,			"Output interim shaping results",					nullptr},
+    {"trace-file",	0, 0, G_OPTION_ARG_STRING,	&this->trace_file,		"Write per-lookup timings to file-name, in Chrome trace event format",	"filename"},
     {nullptr}
   };
   parser->add_group (entries,
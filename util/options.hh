@@ -161,6 +161,9 @@ struct shape_options_t : option_group_t
     normalize_glyphs = false;
     verify = false;
     num_iterations = 1;
+    benchmark = BENCHMARK_NONE;
+    num_threads = 1;
+    profile_lookups = false;
 
     add_options (parser);
   }
@@ -229,7 +232,9 @@ struct shape_options_t : option_group_t
     setup_buffer (buffer);
   }
 
-  hb_bool_t shape (hb_font_t *font, hb_buffer_t *buffer, const char **error=nullptr)
+  /* With plan, shapes through it instead of the face's cached plans. */
+  hb_bool_t shape (hb_font_t *font, hb_buffer_t *buffer, const char **error=nullptr,
+		   hb_shape_plan_t *plan=nullptr)
   {
     hb_buffer_t *text_buffer = nullptr;
     if (verify)
@@ -238,7 +243,8 @@ struct shape_options_t : option_group_t
       hb_buffer_append (text_buffer, buffer, 0, -1);
     }
 
-    if (!hb_shape_full (font, buffer, features, num_features, shapers))
+    if (plan ? !hb_shape_plan_execute (plan, font, buffer, features, num_features) :
+	       !hb_shape_full (font, buffer, features, num_features, shapers))
     {
       if (error)
         *error = "all shapers failed.";
@@ -443,9 +449,46 @@ struct shape_options_t : option_group_t
   hb_bool_t normalize_glyphs;
   hb_bool_t verify;
   unsigned int num_iterations;
+  enum { BENCHMARK_NONE, BENCHMARK_TEXT, BENCHMARK_JSON } benchmark;
+  unsigned int num_threads;
+  hb_bool_t profile_lookups;
 };
 
 
+/* Faces and fonts kept across the lines of a batch run, so that each line
+ * doesn't reload its font file and lose the face's lazily-loaded tables
+ * and cached shape plans.  Faces are keyed by file and index, fonts by
+ * face and the font options that went into them. */
+struct font_cache_t
+{
+  font_cache_t ()
+  {
+    faces = g_hash_table_new_full (g_str_hash, g_str_equal,
+				   g_free, (GDestroyNotify) hb_face_destroy);
+    fonts = g_hash_table_new_full (g_str_hash, g_str_equal,
+				   g_free, (GDestroyNotify) hb_font_destroy);
+  }
+  ~font_cache_t ()
+  {
+    /* Fonts first; they hold on to their faces. */
+    g_hash_table_destroy (fonts);
+    g_hash_table_destroy (faces);
+  }
+
+  /* The get methods return borrowed pointers, or nullptr; the put methods
+   * take a reference. */
+  hb_face_t *get_face (const char *font_path, int face_index);
+  void put_face (const char *font_path, int face_index, hb_face_t *face);
+  hb_font_t *get_font (const char *key)
+  { return (hb_font_t *) g_hash_table_lookup (fonts, key); }
+  void put_font (const char *key, hb_font_t *font)
+  { g_hash_table_replace (fonts, g_strdup (key), hb_font_reference (font)); }
+
+  private:
+  GHashTable *faces;
+  GHashTable *fonts;
+};
+
 struct font_options_t : option_group_t
 {
   font_options_t (option_parser_t *parser,
@@ -467,6 +510,7 @@ struct font_options_t : option_group_t
 
     blob = nullptr;
     font = nullptr;
+    cache = nullptr;
 
     add_options (parser);
   }
@@ -496,8 +540,11 @@ struct font_options_t : option_group_t
   mutable double font_size_y;
   char *font_funcs;
   int ft_load_flags;
+  font_cache_t *cache; /* Optional; shared by batch runs. */
 
   private:
+  char *get_font_key (hb_face_t *face) const;
+
   mutable hb_font_t *font;
 };
 
@@ -622,9 +669,14 @@ struct format_options_t : option_group_t
     show_extents = false;
     show_flags = false;
     trace = false;
+    trace_file = nullptr;
 
     add_options (parser);
   }
+  virtual ~format_options_t ()
+  {
+    g_free (trace_file);
+  }
 
   void add_options (option_parser_t *parser);
 
@@ -667,6 +719,7 @@ struct format_options_t : option_group_t
   hb_bool_t show_extents;
   hb_bool_t show_flags;
   hb_bool_t trace;
+  char *trace_file;
 };
 
 struct subset_options_t : option_group_t
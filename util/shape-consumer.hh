@@ -31,6 +31,283 @@
 #include "options.hh"
 
 
+/* Shaping times for --benchmark.  The very first shape is reported on its
+ * own, since it also pays for creating the shape plan and loading the
+ * font's tables; the rest make the steady-state statistics. */
+struct shape_benchmark_t
+{
+  void init ()
+  {
+    timer = g_timer_new ();
+    times = g_array_new (false, false, sizeof (double));
+    first_time = -1;
+    total_time = 0;
+    total_glyphs = 0;
+    lines = 0;
+  }
+  void fini ()
+  {
+    g_timer_destroy (timer);
+    g_array_free (times, true);
+  }
+
+  void start () { g_timer_start (timer); }
+  void stop (unsigned int num_glyphs)
+  {
+    double t = g_timer_elapsed (timer, nullptr);
+    if (first_time < 0)
+    {
+      first_time = t;
+      return;
+    }
+    g_array_append_val (times, t);
+    total_time += t;
+    total_glyphs += num_glyphs;
+  }
+
+  void report (bool json)
+  {
+    g_array_sort (times, compare_times);
+    unsigned int n = times->len;
+    double min = n ? g_array_index (times, double, 0) : 0;
+    double median = n ? g_array_index (times, double, n / 2) : 0;
+    double p99 = n ? g_array_index (times, double, MIN (n - 1, n * 99 / 100)) : 0;
+    double glyphs_per_sec = total_time > 0 ? total_glyphs / total_time : 0;
+
+    if (json)
+      g_printerr ("{\"lines\": %u, \"shapes\": %u, \"first_us\": %.3f, "
+		  "\"min_us\": %.3f, \"median_us\": %.3f, \"p99_us\": %.3f, "
+		  "\"glyphs_per_sec\": %.0f}\n",
+		  lines, n + (first_time >= 0),
+		  MAX (first_time, 0.) * 1e6,
+		  min * 1e6, median * 1e6, p99 * 1e6,
+		  glyphs_per_sec);
+    else
+    {
+      g_printerr ("Benchmark: %u lines, %u shapes\n", lines, n + (first_time >= 0));
+      g_printerr ("  first shape:  %.3f us\n", MAX (first_time, 0.) * 1e6);
+      if (n)
+      {
+	g_printerr ("  steady state: min %.3f us, median %.3f us, p99 %.3f us\n",
+		    min * 1e6, median * 1e6, p99 * 1e6);
+	g_printerr ("  throughput:   %.0f glyphs/s\n", glyphs_per_sec);
+      }
+    }
+  }
+
+  static gint compare_times (gconstpointer pa, gconstpointer pb)
+  {
+    double a = * (const double *) pa, b = * (const double *) pb;
+    return a < b ? -1 : a > b ? 1 : 0;
+  }
+
+  GTimer *timer;
+  GArray *times;
+  double first_time;
+  double total_time;
+  double total_glyphs;
+  unsigned int lines;
+};
+
+/* For --threads: the lines are shaped again at the end, from that many
+ * threads at once against the same font, to measure how throughput scales
+ * and to catch contention in the library's shared caches. */
+struct shape_threads_t
+{
+  void init ()
+  {
+    lines = g_ptr_array_new_with_free_func (free_line);
+    glyphs = 0;
+    failed = false;
+    g_mutex_init (&mutex);
+  }
+  void fini ()
+  {
+    g_ptr_array_free (lines, true);
+    g_mutex_clear (&mutex);
+  }
+
+  void add_line (const char *text, unsigned int text_len)
+  { g_ptr_array_add (lines, g_string_new_len (text, text_len)); }
+
+  void run (unsigned int num_threads,
+	    unsigned int num_iterations_,
+	    shape_options_t *shaper_,
+	    hb_font_t *font_,
+	    const char *text_before_,
+	    const char *text_after_)
+  {
+    shaper = shaper_;
+    font = font_;
+    text_before = text_before_;
+    text_after = text_after_;
+    num_shapes = lines->len * num_iterations_;
+    next = 0;
+
+    GThread **threads = g_new (GThread *, num_threads);
+    GTimer *timer = g_timer_new ();
+    for (unsigned int i = 0; i < num_threads; i++)
+      threads[i] = g_thread_new ("shape", worker, this);
+    for (unsigned int i = 0; i < num_threads; i++)
+      g_thread_join (threads[i]);
+    double elapsed = g_timer_elapsed (timer, nullptr);
+    g_timer_destroy (timer);
+    g_free (threads);
+
+    g_printerr ("Threads: %u threads, %u shapes in %.3f ms, %.0f glyphs/s%s\n",
+		num_threads, num_shapes, elapsed * 1e3,
+		elapsed > 0 ? glyphs / elapsed : 0,
+		failed ? " (some shapes failed)" : "");
+  }
+
+  static gpointer worker (gpointer data)
+  {
+    shape_threads_t *t = (shape_threads_t *) data;
+    hb_buffer_t *buffer = hb_buffer_create ();
+    double thread_glyphs = 0;
+    bool thread_failed = false;
+
+    for (;;)
+    {
+      unsigned int i = g_atomic_int_add (&t->next, 1);
+      if (i >= t->num_shapes)
+	break;
+
+      GString *line = (GString *) g_ptr_array_index (t->lines, i % t->lines->len);
+      t->shaper->populate_buffer (buffer, line->str, line->len,
+				  t->text_before, t->text_after);
+      if (!t->shaper->shape (t->font, buffer))
+	thread_failed = true;
+      thread_glyphs += hb_buffer_get_length (buffer);
+    }
+    hb_buffer_destroy (buffer);
+
+    g_mutex_lock (&t->mutex);
+    t->glyphs += thread_glyphs;
+    t->failed = t->failed || thread_failed;
+    g_mutex_unlock (&t->mutex);
+    return nullptr;
+  }
+
+  static void free_line (gpointer line) { g_string_free ((GString *) line, true); }
+
+  GPtrArray *lines;
+  shape_options_t *shaper;
+  hb_font_t *font;
+  const char *text_before;
+  const char *text_after;
+  unsigned int num_shapes;
+  gint next;
+  GMutex mutex;
+  double glyphs;
+  bool failed;
+};
+
+/* For --profile-lookups: lines are shaped through plans of our own, one
+ * per set of segment properties, with lookup counters enabled.  The
+ * counters are summed over plans and printed costliest first. */
+struct shape_profile_t
+{
+  void init ()
+  {
+    plans = g_ptr_array_new_with_free_func (destroy_plan);
+    props = g_array_new (false, false, sizeof (hb_segment_properties_t));
+  }
+  void fini ()
+  {
+    g_ptr_array_free (plans, true);
+    g_array_free (props, true);
+  }
+
+  hb_shape_plan_t *get_plan (hb_font_t *font, hb_buffer_t *buffer,
+			     const shape_options_t *shaper)
+  {
+    hb_segment_properties_t p;
+    hb_buffer_get_segment_properties (buffer, &p);
+    for (unsigned int i = 0; i < props->len; i++)
+      if (hb_segment_properties_equal (&g_array_index (props, hb_segment_properties_t, i), &p))
+	return (hb_shape_plan_t *) g_ptr_array_index (plans, i);
+
+    unsigned int num_coords;
+    const int *coords = hb_font_get_var_coords_normalized (font, &num_coords);
+    hb_shape_plan_t *plan = hb_shape_plan_create2 (hb_font_get_face (font), &p,
+						   shaper->features, shaper->num_features,
+						   coords, num_coords,
+						   shaper->shapers);
+    hb_ot_shape_plan_enable_lookup_stats (plan);
+    g_array_append_val (props, p);
+    g_ptr_array_add (plans, plan);
+    return plan;
+  }
+
+  void report ()
+  {
+    GArray *totals = g_array_new (false, false, sizeof (hb_ot_lookup_stats_t));
+    for (unsigned int i = 0; i < plans->len; i++)
+    {
+      hb_shape_plan_t *plan = (hb_shape_plan_t *) g_ptr_array_index (plans, i);
+      hb_ot_lookup_stats_t stats[32];
+      unsigned int offset = 0, count;
+      do
+      {
+	count = G_N_ELEMENTS (stats);
+	hb_ot_shape_plan_get_lookup_stats (plan, offset, &count, stats);
+	for (unsigned int j = 0; j < count; j++)
+	  add (totals, &stats[j]);
+	offset += count;
+      } while (count == G_N_ELEMENTS (stats));
+    }
+    g_array_sort (totals, compare_time);
+
+    double total_time = 0;
+    for (unsigned int i = 0; i < totals->len; i++)
+      total_time += g_array_index (totals, hb_ot_lookup_stats_t, i).time;
+
+    g_printerr ("Lookup profile: %u lookups, %.3f us\n", totals->len, total_time / 1e3);
+    g_printerr ("  tag   lookup    runs  attempts   applies     time (us)   share\n");
+    for (unsigned int i = 0; i < totals->len; i++)
+    {
+      const hb_ot_lookup_stats_t &s = g_array_index (totals, hb_ot_lookup_stats_t, i);
+      if (!s.runs)
+	continue;
+      g_printerr ("  %c%c%c%c  %6u  %6u  %8u  %8u  %12.3f  %5.1f%%\n",
+		  HB_UNTAG (s.table_tag), s.lookup_index,
+		  s.runs, s.attempts, s.applies, s.time / 1e3,
+		  total_time > 0 ? 100. * s.time / total_time : 0.);
+    }
+    g_array_free (totals, true);
+  }
+
+  static void add (GArray *totals, const hb_ot_lookup_stats_t *stats)
+  {
+    for (unsigned int i = 0; i < totals->len; i++)
+    {
+      hb_ot_lookup_stats_t &t = g_array_index (totals, hb_ot_lookup_stats_t, i);
+      if (t.table_tag == stats->table_tag && t.lookup_index == stats->lookup_index)
+      {
+	t.runs += stats->runs;
+	t.attempts += stats->attempts;
+	t.applies += stats->applies;
+	t.time += stats->time;
+	return;
+      }
+    }
+    g_array_append_val (totals, *stats);
+  }
+
+  static gint compare_time (gconstpointer pa, gconstpointer pb)
+  {
+    const hb_ot_lookup_stats_t *a = (const hb_ot_lookup_stats_t *) pa;
+    const hb_ot_lookup_stats_t *b = (const hb_ot_lookup_stats_t *) pb;
+    return a->time > b->time ? -1 : a->time < b->time ? 1 : 0;
+  }
+
+  static void destroy_plan (gpointer plan) { hb_shape_plan_destroy ((hb_shape_plan_t *) plan); }
+
+  GPtrArray *plans;
+  GArray *props;
+};
+
 template <typename output_t>
 struct shape_consumer_t
 {
@@ -49,6 +326,14 @@ struct shape_consumer_t
     buffer = hb_buffer_reference (buffer_);
 
     output.init (buffer, font_opts);
+
+    if (shaper.benchmark)
+      benchmark.init ();
+    if (shaper.num_threads > 1)
+      threads.init ();
+    if (shaper.profile_lookups)
+      profile.init ();
+    text_before = text_after = nullptr;
   }
   void consume_line (const char   *text,
 		     unsigned int  text_len,
@@ -56,6 +341,14 @@ struct shape_consumer_t
 		     const char   *text_after)
   {
     output.new_line ();
+    if (shaper.benchmark)
+      benchmark.lines++;
+    if (shaper.num_threads > 1)
+    {
+      threads.add_line (text, text_len);
+      this->text_before = text_before;
+      this->text_after = text_after;
+    }
 
     for (unsigned int n = shaper.num_iterations; n; n--)
     {
@@ -64,7 +357,13 @@ struct shape_consumer_t
       shaper.populate_buffer (buffer, text, text_len, text_before, text_after);
       if (n == 1)
 	output.consume_text (buffer, text, text_len, shaper.utf8_clusters);
-      if (!shaper.shape (font, buffer, &error))
+      if (shaper.benchmark)
+	benchmark.start ();
+      bool ret = shaper.shape (font, buffer, &error,
+			       shaper.profile_lookups ? profile.get_plan (font, buffer, &shaper) : nullptr);
+      if (shaper.benchmark)
+	benchmark.stop (hb_buffer_get_length (buffer));
+      if (!ret)
       {
 	failed = true;
 	output.error (error);
@@ -80,6 +379,23 @@ struct shape_consumer_t
   void finish (const font_options_t *font_opts)
   {
     output.finish (buffer, font_opts);
+    if (shaper.benchmark)
+    {
+      benchmark.report (shaper.benchmark == shape_options_t::BENCHMARK_JSON);
+      benchmark.fini ();
+    }
+    if (shaper.num_threads > 1)
+    {
+      if (threads.lines->len)
+	threads.run (shaper.num_threads, shaper.num_iterations,
+		     &shaper, font, text_before, text_after);
+      threads.fini ();
+    }
+    if (shaper.profile_lookups)
+    {
+      profile.report ();
+      profile.fini ();
+    }
     hb_font_destroy (font);
     font = nullptr;
     hb_buffer_destroy (buffer);
@@ -92,6 +408,11 @@ struct shape_consumer_t
   protected:
   shape_options_t shaper;
   output_t output;
+  shape_benchmark_t benchmark;
+  shape_threads_t threads;
+  shape_profile_t profile;
+  const char *text_before;
+  const char *text_after;
 
   hb_font_t *font;
   hb_buffer_t *buffer;
@@ -39,9 +39,6 @@ struct view_cairo_t
 		 view_options (parser),
 		 direction (HB_DIRECTION_INVALID),
 		 lines (0), scale_bits (0) {}
-  ~view_cairo_t () {
-    cairo_debug_reset_static_data ();
-  }
 
   void init (hb_buffer_t *buffer, const font_options_t *font_opts)
   {